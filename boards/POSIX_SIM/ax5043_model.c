@@ -0,0 +1,696 @@
+/**
+ * @file    ax5043_model.c
+ * @brief   Register level AX5043 model for the POSIX simulator.
+ * @details Models the parts of the chip the driver depends on: the SPI
+ *          framing and status bits, the register file, the 256 byte FIFO
+ *          with commit semantics and chunk parsing, IRQ request generation,
+ *          crystal startup, VCO autoranging and PLL lock time, and modem
+ *          air time at the programmed bit rate. Analog behaviour beyond
+ *          that is not modelled. Not thread safe, the caller serializes
+ *          access and supplies the time.
+ *
+ * @addtogroup AX5043_MODEL
+ * @{
+ */
+#include <string.h>
+#include "hal.h"
+#include "ax5043.h"
+#include "ax5043_model.h"
+
+/*===========================================================================*/
+/* Model local definitions.                                                  */
+/*===========================================================================*/
+
+#define MODEL_REVISION                      0x51U
+#define MODEL_SCRATCH                       0xC5U
+#define MODEL_FREQ_RESET                    0x39034F35U
+
+/* One byte on the air in bit microseconds */
+#define MODEL_BYTE_CREDIT                   (8U * 1000000ULL)
+
+/* Data chunk header, length and flags ahead of the payload */
+#define MODEL_DATA_HDR                      3U
+
+/*===========================================================================*/
+/* Model local functions.                                                    */
+/*===========================================================================*/
+
+static uint32_t model_get(const ax5043_model_t *m, uint16_t reg, size_t len) {
+    uint32_t val = 0;
+
+    for (size_t i = 0; i < len; i++) {
+        val = (val << 8) | m->regs[reg + i];
+    }
+    return val;
+}
+
+static void model_put(ax5043_model_t *m, uint16_t reg, uint32_t val, size_t len) {
+    for (size_t i = len; i > 0; i--) {
+        m->regs[reg + i - 1] = val & 0xFFU;
+        val >>= 8;
+    }
+}
+
+static uint8_t model_pwrmode(const ax5043_model_t *m) {
+    return _FLD2VAL(AX5043_PWRMODE, m->regs[AX5043_REG_PWRMODE]);
+}
+
+static bool model_chan_b(const ax5043_model_t *m) {
+    return (m->regs[AX5043_REG_PLLLOOP] & AX5043_PLLLOOP_FREQSEL) != 0;
+}
+
+/* Deterministic VCO range a channel needs, 1..15 */
+static uint8_t model_vcor(const ax5043_model_t *m, bool chan_b) {
+    uint32_t freq = model_get(m, (chan_b ? AX5043_REG_FREQB : AX5043_REG_FREQA), 4);
+    int vcor = (int)((freq >> 20) % 15U) + 1 + m->vco_shift;
+
+    while (vcor < 1)
+        vcor += 15;
+    while (vcor > 15)
+        vcor -= 15;
+    return vcor;
+}
+
+static bool model_locked(const ax5043_model_t *m) {
+    uint16_t rng_reg = (model_chan_b(m) ? AX5043_REG_PLLRANGINGB : AX5043_REG_PLLRANGINGA);
+
+    return m->synth_on && m->xtal_ready && !m->ranging &&
+           m->now_us >= m->synth_at + m->config->lock_us &&
+           _FLD2VAL(AX5043_PLLRANGING_VCOR, m->regs[rng_reg]) == model_vcor(m, model_chan_b(m));
+}
+
+static uint16_t model_fifo_free(const ax5043_model_t *m) {
+    return AX5043_MODEL_FIFO_SIZE - m->fifo_count - m->fifo_pending;
+}
+
+static uint8_t model_fifo_peek(const ax5043_model_t *m, uint16_t off) {
+    return m->fifo[(m->fifo_head + off) % AX5043_MODEL_FIFO_SIZE];
+}
+
+static uint8_t model_fifo_pop(ax5043_model_t *m) {
+    uint8_t b;
+
+    if (m->fifo_count == 0) {
+        m->fifo_under = true;
+        return 0;
+    }
+    b = m->fifo[m->fifo_head];
+    m->fifo_head = (m->fifo_head + 1) % AX5043_MODEL_FIFO_SIZE;
+    m->fifo_count--;
+    return b;
+}
+
+/* Appends to the uncommitted end of the FIFO */
+static bool model_fifo_push(ax5043_model_t *m, uint8_t b) {
+    if (model_fifo_free(m) == 0) {
+        m->fifo_over = true;
+        return false;
+    }
+    m->fifo[(m->fifo_head + m->fifo_count + m->fifo_pending) % AX5043_MODEL_FIFO_SIZE] = b;
+    m->fifo_pending++;
+    return true;
+}
+
+static void model_fifo_commit(ax5043_model_t *m) {
+    m->fifo_count += m->fifo_pending;
+    m->fifo_pending = 0;
+}
+
+static uint16_t model_irqsources(const ax5043_model_t *m) {
+    uint16_t thresh = model_get(m, AX5043_REG_FIFOTHRESH, 2);
+    uint16_t req = 0;
+
+    if (m->fifo_count > 0)
+        req |= AX5043_IRQ_FIFONOTEMPTY;
+    if (model_fifo_free(m) > 0)
+        req |= AX5043_IRQ_FIFONOTFULL;
+    if (m->fifo_count > thresh)
+        req |= AX5043_IRQ_FIFOTHRCNT;
+    if (model_fifo_free(m) > thresh)
+        req |= AX5043_IRQ_FIFOTHRFREE;
+    if (m->fifo_over || m->fifo_under)
+        req |= AX5043_IRQ_FIFOERROR;
+    if (m->radio_events & model_get(m, AX5043_REG_RADIOEVENTMASK, 2))
+        req |= AX5043_IRQ_RADIOCTRL;
+    if (m->xtal_ready)
+        req |= AX5043_IRQ_XTALREADY;
+    if (m->range_done)
+        req |= AX5043_IRQ_PLLRNGDONE;
+    return req;
+}
+
+/* IRQREQUEST only shows sources enabled in IRQMASK */
+static uint16_t model_irqrequest(const ax5043_model_t *m) {
+    return model_irqsources(m) & model_get(m, AX5043_REG_IRQMASK, 2);
+}
+
+static uint16_t model_status(const ax5043_model_t *m) {
+    uint16_t thresh = model_get(m, AX5043_REG_FIFOTHRESH, 2);
+    uint16_t status = AX5043_STATUS_PWRGOOD;
+
+    if (model_locked(m))
+        status |= AX5043_STATUS_PLL_LOCK;
+    if (m->fifo_over)
+        status |= AX5043_STATUS_FIFO_OVER;
+    if (m->fifo_under)
+        status |= AX5043_STATUS_FIFO_UNDER;
+    if (model_fifo_free(m) > thresh)
+        status |= AX5043_STATUS_THR_FREE;
+    if (m->fifo_count > thresh)
+        status |= AX5043_STATUS_THR_COUNT;
+    if (model_fifo_free(m) == 0)
+        status |= AX5043_STATUS_FIFO_FULL;
+    if (m->fifo_count == 0)
+        status |= AX5043_STATUS_FIFO_EMPTY;
+    if (m->radio_events)
+        status |= AX5043_STATUS_RADIOEVENT_INT;
+    return status;
+}
+
+static void model_reset(ax5043_model_t *m) {
+    memset(m->regs, 0, sizeof(m->regs));
+    m->regs[AX5043_REG_REVISION] = MODEL_REVISION;
+    m->regs[AX5043_REG_SCRATCH] = MODEL_SCRATCH;
+    m->regs[AX5043_REG_PLLLOOP] = 0x0AU;
+    m->regs[AX5043_REG_PLLVCODIV] = 0x04U;
+    m->regs[AX5043_REG_PLLRANGINGA] = 0x08U;
+    m->regs[AX5043_REG_PLLRANGINGB] = 0x08U;
+    m->regs[AX5043_REG_PKTCHUNKSIZE] = AX5043_PKTCHUNKSIZE_240;
+    model_put(m, AX5043_REG_FREQA, MODEL_FREQ_RESET, 4);
+    model_put(m, AX5043_REG_FREQB, MODEL_FREQ_RESET, 4);
+    model_put(m, AX5043_REG_TXRATE, 0x00028FU, 3);
+
+    m->fifo_head = 0;
+    m->fifo_count = 0;
+    m->fifo_pending = 0;
+    m->fifo_over = false;
+    m->fifo_under = false;
+    m->xtal_on = false;
+    m->xtal_ready = false;
+    m->ranging = false;
+    m->range_done = false;
+    m->synth_on = false;
+    m->radio_events = 0;
+    m->credit = 0;
+    m->tx_left = 0;
+    m->tx_in_pkt = false;
+    m->tx_sent = false;
+    m->tx_starved = false;
+    m->rx_pos = 0;
+    m->rx_synced = false;
+}
+
+static void model_set_pwrmode(ax5043_model_t *m, uint8_t val) {
+    uint8_t prev = model_pwrmode(m);
+    uint8_t mode = _FLD2VAL(AX5043_PWRMODE, val);
+    bool xtal, synth;
+
+    if (val & AX5043_PWRMODE_RESET) {
+        model_reset(m);
+        m->regs[AX5043_REG_PWRMODE] = val;
+        return;
+    }
+    m->regs[AX5043_REG_PWRMODE] = val;
+
+    /* The crystal keeps running in POWERDOWN while XOEN is set */
+    xtal = (mode >= AX5043_PWRMODE_STANDBY ||
+            (mode == AX5043_PWRMODE_POWERDOWN && (val & AX5043_PWRMODE_XOEN)));
+    if (xtal && !m->xtal_on) {
+        m->xtal_at = m->now_us + m->config->xtal_us;
+    } else if (!xtal) {
+        m->xtal_ready = false;
+    }
+    m->xtal_on = xtal;
+
+    synth = (mode >= AX5043_PWRMODE_RX_SYNTH);
+    if (synth && !m->synth_on) {
+        m->synth_at = m->now_us;
+    }
+    m->synth_on = synth;
+
+    /* Modem state does not survive leaving TX or RX */
+    if (mode != prev) {
+        m->credit = 0;
+        m->tx_left = 0;
+        m->tx_in_pkt = false;
+        m->tx_sent = false;
+        m->tx_starved = false;
+        m->rx_pos = 0;
+        m->rx_synced = false;
+    }
+}
+
+static uint8_t model_read(ax5043_model_t *m, uint16_t addr) {
+    uint8_t val;
+
+    switch (addr) {
+    case AX5043_REG_FIFODATA:
+        return model_fifo_pop(m);
+    case AX5043_REG_FIFOSTAT:
+        val = 0;
+        if (m->fifo_count == 0)
+            val |= AX5043_FIFOSTAT_FIFOEMPTY;
+        if (model_fifo_free(m) == 0)
+            val |= AX5043_FIFOSTAT_FIFOFULL;
+        if (m->fifo_under)
+            val |= AX5043_FIFOSTAT_FIFOUNDER;
+        if (m->fifo_over)
+            val |= AX5043_FIFOSTAT_FIFOOVER;
+        return val;
+    case AX5043_REG_FIFOCOUNT:
+        return m->fifo_count >> 8;
+    case AX5043_REG_FIFOCOUNT + 1:
+        return m->fifo_count & 0xFFU;
+    case AX5043_REG_FIFOFREE:
+        return model_fifo_free(m) >> 8;
+    case AX5043_REG_FIFOFREE + 1:
+        return model_fifo_free(m) & 0xFFU;
+    case AX5043_REG_IRQREQUEST:
+        return model_irqrequest(m) >> 8;
+    case AX5043_REG_IRQREQUEST + 1:
+        return model_irqrequest(m) & 0xFFU;
+    case AX5043_REG_RADIOEVENTREQ:
+        return m->radio_events >> 8;
+    case AX5043_REG_RADIOEVENTREQ + 1:
+        /* Reading the request clears it */
+        val = m->radio_events & 0xFFU;
+        m->radio_events = 0;
+        return val;
+    case AX5043_REG_XTALSTATUS:
+        return (m->xtal_ready ? AX5043_XTALSTATUS_XTALRUN : 0);
+    case AX5043_REG_PLLRANGINGA:
+    case AX5043_REG_PLLRANGINGB:
+        val = m->regs[addr];
+        if ((addr == AX5043_REG_PLLRANGINGB) == model_chan_b(m) && model_locked(m))
+            val |= AX5043_PLLRANGING_PLLLOCK;
+        m->range_done = false;
+        return val;
+    default:
+        return m->regs[addr];
+    }
+}
+
+static void model_write(ax5043_model_t *m, uint16_t addr, uint8_t val) {
+    switch (addr) {
+    case AX5043_REG_REVISION:
+    case AX5043_REG_IRQREQUEST:
+    case AX5043_REG_IRQREQUEST + 1:
+    case AX5043_REG_XTALSTATUS:
+    case AX5043_REG_FIFOCOUNT:
+    case AX5043_REG_FIFOCOUNT + 1:
+    case AX5043_REG_FIFOFREE:
+    case AX5043_REG_FIFOFREE + 1:
+        break;
+    case AX5043_REG_PWRMODE:
+        model_set_pwrmode(m, val);
+        break;
+    case AX5043_REG_FIFODATA:
+        if (!model_fifo_push(m, val))
+            m->stats.fifo_overflows++;
+        break;
+    case AX5043_REG_FIFOSTAT:
+        switch (_FLD2VAL(AX5043_FIFOSTAT_FIFOCMD, val)) {
+        case AX5043_FIFOCMD_CLEAR_FIFOERR:
+            m->fifo_over = false;
+            m->fifo_under = false;
+            break;
+        case AX5043_FIFOCMD_CLEAR_FIFODAT:
+            m->fifo_head = 0;
+            m->fifo_count = 0;
+            m->fifo_pending = 0;
+            m->fifo_over = false;
+            m->fifo_under = false;
+            break;
+        case AX5043_FIFOCMD_COMMIT:
+            model_fifo_commit(m);
+            break;
+        case AX5043_FIFOCMD_ROLLBACK:
+            m->fifo_pending = 0;
+            break;
+        default:
+            break;
+        }
+        break;
+    case AX5043_REG_PLLRANGINGA:
+    case AX5043_REG_PLLRANGINGB:
+        m->regs[addr] = val & (AX5043_PLLRANGING_VCOR | AX5043_PLLRANGING_RNGSTART);
+        if ((val & AX5043_PLLRANGING_RNGSTART) && m->xtal_on) {
+            m->ranging = true;
+            m->range_reg = addr;
+            m->range_at = (m->xtal_ready ? m->now_us : m->xtal_at) + m->config->range_us;
+        }
+        break;
+    default:
+        m->regs[addr] = val;
+        break;
+    }
+}
+
+/*
+ * Transmit committed FIFO data at the bit rate. Chunk headers cost no air
+ * time; data bytes leave the FIFO as they are sent so free space opens up
+ * gradually, like on the chip. DONE is raised once the FIFO runs empty
+ * outside a packet, after any postamble.
+ */
+static void model_tx(ax5043_model_t *m) {
+    for (;;) {
+        if (m->tx_left == 0) {
+            uint8_t hdr, cmd, size;
+            uint16_t total;
+
+            if (m->fifo_count == 0) {
+                if (m->tx_in_pkt && !m->tx_starved) {
+                    m->stats.tx_underruns++;
+                    m->tx_starved = true;
+                } else if (!m->tx_in_pkt && m->tx_sent) {
+                    m->radio_events |= AX5043_RADIOEVENT_DONE;
+                    m->tx_sent = false;
+                }
+                m->credit = 0;
+                return;
+            }
+
+            hdr = model_fifo_peek(m, 0);
+            cmd = _FLD2VAL(AX5043_FIFOCHUNK_CMD, hdr);
+            size = _FLD2VAL(AX5043_FIFOCHUNK_SIZE, hdr);
+            if (size == AX5043_CHUNKSIZE_VAR) {
+                if (m->fifo_count < 2)
+                    return;
+                total = 2 + model_fifo_peek(m, 1);
+            } else {
+                total = 1 + size;
+            }
+            if (m->fifo_count < total)
+                return;
+            m->tx_starved = false;
+
+            if (cmd == AX5043_CHUNKCMD_DATA && size == AX5043_CHUNKSIZE_VAR && total >= MODEL_DATA_HDR) {
+                model_fifo_pop(m);
+                model_fifo_pop(m);
+                m->tx_flags = model_fifo_pop(m);
+                m->tx_left = total - MODEL_DATA_HDR;
+                m->tx_repeat = false;
+            } else if (cmd == AX5043_CHUNKCMD_REPEATDATA && total == 4) {
+                model_fifo_pop(m);
+                m->tx_flags = model_fifo_pop(m);
+                m->tx_left = model_fifo_pop(m);
+                model_fifo_pop(m);
+                m->tx_repeat = true;
+            } else {
+                while (total--)
+                    model_fifo_pop(m);
+                continue;
+            }
+            if (m->tx_flags & AX5043_CHUNK_DATATX_PKTSTART)
+                m->tx_in_pkt = true;
+            if (m->tx_left == 0)
+                continue;
+        }
+
+        /* Send what the accumulated air time allows */
+        uint64_t n = m->credit / MODEL_BYTE_CREDIT;
+        if (n == 0)
+            return;
+        if (n > m->tx_left)
+            n = m->tx_left;
+        if (!m->tx_repeat) {
+            for (uint64_t i = 0; i < n; i++)
+                model_fifo_pop(m);
+        }
+        m->credit -= n * MODEL_BYTE_CREDIT;
+        m->tx_left -= n;
+        m->tx_sent = true;
+        m->stats.tx_bytes += n;
+
+        if (m->tx_left == 0 && (m->tx_flags & AX5043_CHUNK_DATATX_PKTEND)) {
+            m->tx_in_pkt = false;
+            m->stats.tx_packets++;
+        }
+    }
+}
+
+/* Writes a complete chunk, or nothing if it does not fit */
+static bool model_rx_chunk(ax5043_model_t *m, const uint8_t *chunk, size_t len) {
+    if (model_fifo_free(m) < len) {
+        m->fifo_over = true;
+        return false;
+    }
+    for (size_t i = 0; i < len; i++)
+        model_fifo_push(m, chunk[i]);
+    model_fifo_commit(m);
+    return true;
+}
+
+static void model_rx_drop(ax5043_model_t *m) {
+    m->rx_head = (m->rx_head + 1) % AX5043_MODEL_RX_QUEUE;
+    m->rx_count--;
+    m->rx_pos = 0;
+    m->rx_synced = false;
+}
+
+/*
+ * Receive queued frames at the bit rate. After the preamble and sync word
+ * the chip stores the requested RSSI and offset chunks, then the payload
+ * in DATA chunks of PKTCHUNKSIZE as each one completes. A chunk that does
+ * not fit in the FIFO loses the rest of the frame.
+ */
+static void model_rx(ax5043_model_t *m) {
+    static const uint8_t chunk_sizes[] = {0, 1, 2, 4, 8, 16, 32, 64, 96, 128, 160, 192, 224, 240, 240, 240};
+    uint8_t chunk[MODEL_DATA_HDR + 240];
+
+    while (m->rx_count > 0) {
+        ax5043_model_frame_t *f = &m->rx_queue[m->rx_head];
+
+        if (!m->rx_synced) {
+            uint64_t gap = (uint64_t)m->config->rx_gap_bits * 1000000ULL;
+            uint8_t store = m->regs[AX5043_REG_PKTSTOREFLAGS];
+            if (m->credit < gap)
+                return;
+            m->credit -= gap;
+            m->rx_synced = true;
+
+            if (store & AX5043_PKTSTOREFLAGS_RSSI) {
+                chunk[0] = AX5043_CHUNKCMD_RSSI | _VAL2FLD(AX5043_FIFOCHUNK_SIZE, 1);
+                chunk[1] = f->rssi;
+                model_rx_chunk(m, chunk, 2);
+            }
+            if (store & AX5043_PKTSTOREFLAGS_RFOFFS) {
+                chunk[0] = AX5043_CHUNKCMD_RFFREQOFFS | _VAL2FLD(AX5043_FIFOCHUNK_SIZE, 3);
+                chunk[1] = (f->rf_offset >> 16) & 0xFFU;
+                chunk[2] = (f->rf_offset >> 8) & 0xFFU;
+                chunk[3] = f->rf_offset & 0xFFU;
+                model_rx_chunk(m, chunk, 4);
+            }
+        }
+
+        while (m->rx_pos < f->len) {
+            size_t n = chunk_sizes[_FLD2VAL(AX5043_PKTCHUNKSIZE, m->regs[AX5043_REG_PKTCHUNKSIZE])];
+            if (n == 0)
+                n = 1;
+            if (n > f->len - m->rx_pos)
+                n = f->len - m->rx_pos;
+            if (m->credit < n * MODEL_BYTE_CREDIT)
+                return;
+            m->credit -= n * MODEL_BYTE_CREDIT;
+
+            chunk[0] = AX5043_CHUNKCMD_DATA | _VAL2FLD(AX5043_FIFOCHUNK_SIZE, AX5043_CHUNKSIZE_VAR);
+            chunk[1] = n + 1;
+            chunk[2] = 0;
+            if (m->rx_pos == 0)
+                chunk[2] |= AX5043_CHUNK_DATARX_PKTSTART;
+            if (m->rx_pos + n == f->len)
+                chunk[2] |= AX5043_CHUNK_DATARX_PKTEND | f->flags;
+            memcpy(&chunk[MODEL_DATA_HDR], &f->data[m->rx_pos], n);
+            m->rx_pos += n;
+
+            if (!model_rx_chunk(m, chunk, MODEL_DATA_HDR + n)) {
+                m->stats.rx_overflows++;
+                model_rx_drop(m);
+                break;
+            }
+            if (m->rx_pos == f->len) {
+                m->stats.rx_frames++;
+                model_rx_drop(m);
+                break;
+            }
+        }
+    }
+    m->credit = 0;
+}
+
+/*===========================================================================*/
+/* Model exported functions.                                                 */
+/*===========================================================================*/
+
+/**
+ * @brief   Initializes the model in its reset state.
+ *
+ * @param[out]  m           Pointer to the @p ax5043_model_t object
+ * @param[in]   config      Timing configuration
+ */
+void ax5043ModelInit(ax5043_model_t *m, const ax5043_model_config_t *config) {
+    memset(m, 0, sizeof(*m));
+    m->config = config;
+    model_reset(m);
+}
+
+/**
+ * @brief   Bit rate programmed in TXRATE.
+ */
+uint32_t ax5043ModelBitrate(ax5043_model_t *m) {
+    return ((uint64_t)model_get(m, AX5043_REG_TXRATE, 3) * m->config->xtal_freq) >> 24;
+}
+
+/**
+ * @brief   Advances the model to a point in time.
+ * @details Completes crystal startup and ranging, then runs the modem for
+ *          the air time since the last call.
+ *
+ * @param[in]   now_us      Monotonic time in microseconds
+ */
+void ax5043ModelAdvance(ax5043_model_t *m, uint64_t now_us) {
+    uint64_t from = m->now_us;
+    uint8_t mode = model_pwrmode(m);
+
+    if (now_us <= m->now_us)
+        return;
+    m->now_us = now_us;
+
+    if (m->xtal_on && !m->xtal_ready && now_us >= m->xtal_at) {
+        m->xtal_ready = true;
+    }
+    if (m->ranging && m->xtal_ready && now_us >= m->range_at) {
+        bool chan_b = (m->range_reg == AX5043_REG_PLLRANGINGB);
+        m->regs[m->range_reg] = _VAL2FLD(AX5043_PLLRANGING_VCOR, model_vcor(m, chan_b));
+        m->ranging = false;
+        m->range_done = true;
+        m->stats.rangings++;
+    }
+
+    if ((mode == AX5043_PWRMODE_TX_FULL || mode == AX5043_PWRMODE_RX_FULL) && model_locked(m)) {
+        uint64_t lock_at = m->synth_at + m->config->lock_us;
+        uint64_t dt = now_us - (from > lock_at ? from : lock_at);
+        m->credit += dt * ax5043ModelBitrate(m);
+        if (mode == AX5043_PWRMODE_TX_FULL) {
+            if (m->tx_in_pkt || m->fifo_count)
+                m->stats.air_us += dt;
+            model_tx(m);
+        } else {
+            if (m->rx_count)
+                m->stats.air_us += dt;
+            model_rx(m);
+        }
+    }
+}
+
+/**
+ * @brief   Chip select asserted.
+ */
+void ax5043ModelSelect(ax5043_model_t *m) {
+    m->selected = true;
+    m->spi_phase = 0;
+}
+
+/**
+ * @brief   Exchanges bytes while selected.
+ * @details The first byte picks a short (7-bit) or long (12-bit) address
+ *          and the read/write direction, status bits are shifted out
+ *          during the address and the old contents during a write.
+ *          Addresses auto increment except FIFODATA.
+ *
+ * @param[in]   txbuf       Bytes from the host, NULL sends 0xFF
+ * @param[out]  rxbuf       Bytes to the host, may be NULL
+ * @param[in]   n           Number of bytes
+ */
+void ax5043ModelExchange(ax5043_model_t *m, const uint8_t *txbuf, uint8_t *rxbuf, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        uint8_t in = (txbuf != NULL ? txbuf[i] : 0xFFU);
+        uint8_t out = 0;
+
+        if (!m->selected) {
+            if (rxbuf != NULL)
+                rxbuf[i] = 0;
+            continue;
+        }
+
+        switch (m->spi_phase) {
+        case 0:
+            m->spi_write = (in & 0x80U) != 0;
+            out = model_status(m) >> 8;
+            if ((in & 0x70U) == 0x70U) {
+                m->spi_addr = (in & 0x0FU) << 8;
+                m->spi_phase = 1;
+            } else {
+                m->spi_addr = in & 0x7FU;
+                m->spi_phase = 2;
+            }
+            break;
+        case 1:
+            m->spi_addr |= in;
+            out = model_status(m) & 0xFFU;
+            m->spi_phase = 2;
+            break;
+        default:
+            if (m->spi_write) {
+                /* A write shifts out the previous register contents */
+                out = (m->spi_addr != AX5043_REG_FIFODATA ? m->regs[m->spi_addr] : 0);
+                model_write(m, m->spi_addr, in);
+            } else {
+                out = model_read(m, m->spi_addr);
+            }
+            if (m->spi_addr != AX5043_REG_FIFODATA)
+                m->spi_addr = (m->spi_addr + 1) % AX5043_MODEL_REGS;
+            break;
+        }
+        if (rxbuf != NULL)
+            rxbuf[i] = out;
+    }
+}
+
+/**
+ * @brief   Chip select released.
+ */
+void ax5043ModelUnselect(ax5043_model_t *m) {
+    m->selected = false;
+}
+
+/**
+ * @brief   Level of the IRQ pin.
+ */
+bool ax5043ModelIRQ(ax5043_model_t *m) {
+    return model_irqrequest(m) != 0;
+}
+
+/**
+ * @brief   Queues a frame on the air.
+ * @details It is received once the chip is in RX with the PLL locked.
+ *
+ * @param[in]   flags       DATA chunk error flags for the end of the frame
+ * @param[in]   rssi        RSSI chunk value
+ * @param[in]   rf_offset   RFFREQOFFS chunk value
+ *
+ * @return                  False if the queue is full or the frame too long.
+ */
+bool ax5043ModelRX(ax5043_model_t *m, const void *data, size_t len, uint8_t flags, int8_t rssi, int32_t rf_offset) {
+    ax5043_model_frame_t *f;
+
+    if (m->rx_count >= AX5043_MODEL_RX_QUEUE || len == 0 || len > AX5043_MODEL_RX_MAX)
+        return false;
+    f = &m->rx_queue[(m->rx_head + m->rx_count) % AX5043_MODEL_RX_QUEUE];
+    memcpy(f->data, data, len);
+    f->len = len;
+    f->flags = flags;
+    f->rssi = rssi;
+    f->rf_offset = rf_offset;
+    m->rx_count++;
+    return true;
+}
+
+/**
+ * @brief   Moves the VCO range every channel needs, as a temperature change would.
+ */
+void ax5043ModelShiftVCO(ax5043_model_t *m, int8_t shift) {
+    m->vco_shift = shift;
+}
+
+/** @} */
@@ -0,0 +1,156 @@
+/**
+ * @file    ax5043_model.h
+ * @brief   Register level AX5043 model for the POSIX simulator.
+ *
+ * @addtogroup AX5043_MODEL
+ * @{
+ */
+#ifndef _AX5043_MODEL_H_
+#define _AX5043_MODEL_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/*===========================================================================*/
+/* Model constants.                                                          */
+/*===========================================================================*/
+
+#define AX5043_MODEL_REGS                   0x1000U
+#define AX5043_MODEL_FIFO_SIZE              256U
+
+/*===========================================================================*/
+/* Model pre-compile time settings.                                          */
+/*===========================================================================*/
+
+/**
+ * @brief   Number of RX frames that can be queued on the air.
+ */
+#if !defined(AX5043_MODEL_RX_QUEUE) || defined(__DOXYGEN__)
+#define AX5043_MODEL_RX_QUEUE               8U
+#endif
+
+/**
+ * @brief   Largest RX frame in bytes.
+ */
+#if !defined(AX5043_MODEL_RX_MAX) || defined(__DOXYGEN__)
+#define AX5043_MODEL_RX_MAX                 1024U
+#endif
+
+/*===========================================================================*/
+/* Model data structures and types.                                          */
+/*===========================================================================*/
+
+/**
+ * @brief   Model timing configuration.
+ * @details Air time follows the bit rate programmed in TXRATE for both
+ *          directions.
+ */
+typedef struct {
+    uint32_t                    xtal_freq;      /**< Crystal frequency, Hz.     */
+    uint32_t                    xtal_us;        /**< Crystal startup time.      */
+    uint32_t                    range_us;       /**< VCO autoranging time.      */
+    uint32_t                    lock_us;        /**< PLL lock time.             */
+    uint32_t                    rx_gap_bits;    /**< Preamble and sync per frame. */
+} ax5043_model_config_t;
+
+/**
+ * @brief   Model statistics.
+ */
+typedef struct {
+    uint32_t                    rangings;       /**< Autoranging runs.          */
+    uint32_t                    tx_packets;     /**< Packets sent to PKTEND.    */
+    uint32_t                    tx_bytes;       /**< Bytes sent on the air.     */
+    uint32_t                    tx_underruns;   /**< FIFO ran dry mid packet.   */
+    uint32_t                    rx_frames;      /**< Frames put in the FIFO.    */
+    uint32_t                    rx_overflows;   /**< Frames lost to a full FIFO.*/
+    uint32_t                    fifo_overflows; /**< FIFODATA writes dropped.   */
+    uint64_t                    air_us;         /**< Time spent keyed or receiving. */
+} ax5043_model_stats_t;
+
+/**
+ * @brief   Frame waiting to be received.
+ */
+typedef struct {
+    uint8_t                     data[AX5043_MODEL_RX_MAX];
+    size_t                      len;
+    uint8_t                     flags;          /**< Error flags on the last chunk. */
+    int8_t                      rssi;
+    int32_t                     rf_offset;
+} ax5043_model_frame_t;
+
+/**
+ * @brief   AX5043 model state.
+ */
+typedef struct {
+    const ax5043_model_config_t *config;
+    uint8_t                     regs[AX5043_MODEL_REGS];
+
+    /* FIFO, committed bytes first, then bytes written but not committed */
+    uint8_t                     fifo[AX5043_MODEL_FIFO_SIZE];
+    uint16_t                    fifo_head;
+    uint16_t                    fifo_count;
+    uint16_t                    fifo_pending;
+    bool                        fifo_over;
+    bool                        fifo_under;
+
+    /* SPI transaction state */
+    bool                        selected;
+    uint8_t                     spi_phase;
+    bool                        spi_write;
+    uint16_t                    spi_addr;
+
+    /* Analog state */
+    uint64_t                    now_us;
+    uint64_t                    xtal_at;
+    bool                        xtal_on;
+    bool                        xtal_ready;
+    uint64_t                    range_at;
+    uint16_t                    range_reg;
+    bool                        ranging;
+    bool                        range_done;
+    uint64_t                    synth_at;
+    bool                        synth_on;
+    int8_t                      vco_shift;
+    uint16_t                    radio_events;
+
+    /* Modem, credit is in bit microseconds */
+    uint64_t                    credit;
+    uint16_t                    tx_left;
+    uint8_t                     tx_flags;
+    bool                        tx_repeat;
+    bool                        tx_in_pkt;
+    bool                        tx_sent;
+    bool                        tx_starved;
+    ax5043_model_frame_t        rx_queue[AX5043_MODEL_RX_QUEUE];
+    uint8_t                     rx_head;
+    uint8_t                     rx_count;
+    size_t                      rx_pos;
+    bool                        rx_synced;
+
+    ax5043_model_stats_t        stats;
+} ax5043_model_t;
+
+/*===========================================================================*/
+/* External declarations.                                                    */
+/*===========================================================================*/
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+void ax5043ModelInit(ax5043_model_t *m, const ax5043_model_config_t *config);
+void ax5043ModelAdvance(ax5043_model_t *m, uint64_t now_us);
+void ax5043ModelSelect(ax5043_model_t *m);
+void ax5043ModelExchange(ax5043_model_t *m, const uint8_t *txbuf, uint8_t *rxbuf, size_t n);
+void ax5043ModelUnselect(ax5043_model_t *m);
+bool ax5043ModelIRQ(ax5043_model_t *m);
+bool ax5043ModelRX(ax5043_model_t *m, const void *data, size_t len, uint8_t flags, int8_t rssi, int32_t rf_offset);
+void ax5043ModelShiftVCO(ax5043_model_t *m, int8_t shift);
+uint32_t ax5043ModelBitrate(ax5043_model_t *m);
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _AX5043_MODEL_H_ */
+
+/** @} */
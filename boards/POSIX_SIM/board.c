@@ -0,0 +1,185 @@
+/*
+    ChibiOS - Copyright (C) 2006..2018 Giovanni Di Sirio
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#include "hal.h"
+
+/*===========================================================================*/
+/* Driver local definitions.                                                 */
+/*===========================================================================*/
+
+/*===========================================================================*/
+/* Driver exported variables.                                                */
+/*===========================================================================*/
+
+/**
+ * @brief   AX5043 models wired to SPID1 and IOPORT1.
+ * @note    Both share the bus and MISO, each has its own chip select and IRQ.
+ */
+ax5043_model_t sim_ax5043;
+ax5043_model_t sim_ax5043b;
+
+/**
+ * @brief   MCU factory calibration, TS_CAL1 at 30 C, TS_CAL2 at 110 C and
+ *          VREFINT_CAL, all taken at 3.3 V.
+ */
+uint16_t sim_mcu_cal[3] = {
+  [SIM_MCU_TS_CAL1]         = 1770U,
+  [SIM_MCU_TS_CAL2]         = 1340U,
+  [SIM_MCU_VREFINT_CAL]     = 1525U,
+};
+
+/*===========================================================================*/
+/* Driver local variables and types.                                         */
+/*===========================================================================*/
+
+/* A model, the line its IRQ drives and its chip select */
+typedef struct {
+  ax5043_model_t            *model;
+  ioline_t                  irq;
+  ioline_t                  cs;
+} sim_radio_t;
+
+static const sim_radio_t sim_radios[] = {
+  {&sim_ax5043, LINE_AX5043_IRQ, LINE_AX5043_CS},
+  {&sim_ax5043b, LINE_AX5043B_IRQ, LINE_AX5043B_CS},
+};
+
+#define SIM_RADIOS      (sizeof(sim_radios) / sizeof(sim_radios[0]))
+
+static virtual_timer_t sim_vt;
+
+/*===========================================================================*/
+/* Driver local functions.                                                   */
+/*===========================================================================*/
+
+/*
+ * Brings a model up to the current time.
+ */
+static void sim_ax5043_sync(const sim_radio_t *radio) {
+  ax5043ModelAdvance(radio->model, simTimeUS());
+}
+
+/*
+ * Updates the IRQ line from the model, a rising edge runs the driver's
+ * line callback.
+ */
+static void sim_ax5043_irq(const sim_radio_t *radio) {
+
+  sim_ax5043_sync(radio);
+  palHostDriveLine(radio->irq, ax5043ModelIRQ(radio->model));
+}
+
+static void sim_ax5043_select(void *arg) {
+  const sim_radio_t *radio = arg;
+
+  sim_ax5043_sync(radio);
+  ax5043ModelSelect(radio->model);
+}
+
+static void sim_ax5043_exchange(void *arg, const uint8_t *txbuf,
+                                uint8_t *rxbuf, size_t n) {
+  const sim_radio_t *radio = arg;
+
+  sim_ax5043_sync(radio);
+  ax5043ModelExchange(radio->model, txbuf, rxbuf, n);
+}
+
+static void sim_ax5043_unselect(void *arg) {
+  const sim_radio_t *radio = arg;
+
+  ax5043ModelUnselect(radio->model);
+}
+
+static void sim_ax5043_complete(void *arg) {
+
+  sim_ax5043_irq(arg);
+}
+
+static const spi_host_device_t sim_ax5043_dev[] = {
+  {
+    .arg      = (void *)&sim_radios[0],
+    .select   = sim_ax5043_select,
+    .exchange = sim_ax5043_exchange,
+    .unselect = sim_ax5043_unselect,
+    .complete = sim_ax5043_complete,
+  },
+  {
+    .arg      = (void *)&sim_radios[1],
+    .select   = sim_ax5043_select,
+    .exchange = sim_ax5043_exchange,
+    .unselect = sim_ax5043_unselect,
+    .complete = sim_ax5043_complete,
+  },
+};
+
+/*
+ * Runs the models every system tick so the chips make progress and raise
+ * their IRQs while no transfer is in flight.
+ */
+static void sim_vt_cb(void *arg) {
+  (void)arg;
+
+  for (unsigned i = 0U; i < SIM_RADIOS; i++) {
+    sim_ax5043_irq(&sim_radios[i]);
+  }
+
+  chVTSetI(&sim_vt, 1, sim_vt_cb, NULL);
+}
+
+/*===========================================================================*/
+/* Driver exported functions.                                                */
+/*===========================================================================*/
+
+/**
+ * @brief   Board-specific initialization code.
+ * @note    Runs from halInit() before the kernel is initialized, the
+ *          models are started later by @p simAX5043Start.
+ */
+void boardInit(void) {
+
+  palSetLineMode(LINE_AX5043_IRQ, PAL_MODE_INPUT);
+  palSetLineMode(LINE_AX5043B_IRQ, PAL_MODE_INPUT);
+  palSetLineMode(LINE_AX5043_MISO, PAL_MODE_INPUT);
+  palSetLineMode(LINE_AX5043_CS, PAL_MODE_OUTPUT_PUSHPULL);
+  palSetLineMode(LINE_AX5043B_CS, PAL_MODE_OUTPUT_PUSHPULL);
+  palSetLine(LINE_AX5043_CS);
+  palSetLine(LINE_AX5043B_CS);
+  /* The model is always ready, MISO idles high after select.*/
+  palHostDriveLine(LINE_AX5043_MISO, true);
+}
+
+/**
+ * @brief   Resets the AX5043 models, attaches them to SPID1 and starts their clock.
+ * @note    Call after chSysInit() and before starting the driver.
+ *
+ * @param[in] config    model timing configuration
+ */
+void simAX5043Start(const ax5043_model_config_t *config) {
+
+  for (unsigned i = 0U; i < SIM_RADIOS; i++) {
+    ax5043ModelInit(sim_radios[i].model, config);
+    spiHostAttach(&SPID1, sim_radios[i].cs, &sim_ax5043_dev[i]);
+  }
+  chVTObjectInit(&sim_vt);
+  chVTSetI(&sim_vt, 1, sim_vt_cb, NULL);
+}
+
+/**
+ * @brief   Monotonic simulation time in microseconds.
+ */
+uint64_t simTimeUS(void) {
+  return chHostTimeUS();
+}
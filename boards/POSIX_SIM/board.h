@@ -0,0 +1,109 @@
+/*
+    ChibiOS - Copyright (C) 2006..2018 Giovanni Di Sirio
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#ifndef BOARD_H
+#define BOARD_H
+
+/*===========================================================================*/
+/* Driver constants.                                                         */
+/*===========================================================================*/
+
+/*
+ * Setup for host builds on the src/posix/host runtime, with two AX5043
+ * models sharing SPID1 like the UHF and L-band radios on the C3.
+ */
+
+/*
+ * Board identifier.
+ */
+#define BOARD_POSIX_SIM
+#define BOARD_NAME                  "POSIX simulator"
+
+/*
+ * Board oscillators-related settings.
+ */
+#define AX5043_SIM_XTAL             16000000U
+
+/*
+ * Factory calibration words of the MCU system memory, in the order
+ * TS_CAL1, TS_CAL2, VREFINT_CAL. Typical STM32F0 values, tests may change
+ * them before sensors_init().
+ */
+#define SIM_MCU_TS_CAL1             0
+#define SIM_MCU_TS_CAL2             1
+#define SIM_MCU_VREFINT_CAL         2
+
+/*
+ * IO pins assignments.
+ */
+#define GPIO1_AX5043_IRQ            0U
+#define GPIO1_AX5043_MISO           1U
+#define GPIO1_AX5043B_IRQ           2U
+#define GPIO1_AX5043_CS             3U
+#define GPIO1_AX5043B_CS            4U
+
+/*
+ * IO lines assignments.
+ */
+#define LINE_AX5043_IRQ             PAL_LINE(IOPORT1, GPIO1_AX5043_IRQ)
+#define LINE_AX5043_MISO            PAL_LINE(IOPORT1, GPIO1_AX5043_MISO)
+#define LINE_AX5043B_IRQ            PAL_LINE(IOPORT1, GPIO1_AX5043B_IRQ)
+#define LINE_AX5043_CS              PAL_LINE(IOPORT1, GPIO1_AX5043_CS)
+#define LINE_AX5043B_CS             PAL_LINE(IOPORT1, GPIO1_AX5043B_CS)
+
+/*===========================================================================*/
+/* External declarations.                                                    */
+/*===========================================================================*/
+
+/*
+ * CMSIS intrinsics the shared drivers rely on.
+ */
+#if !defined(_FROM_ASM_)
+#include <stdint.h>
+
+#define __REV(x)                    __builtin_bswap32(x)
+#define __REVSH(x)                  ((int16_t)__builtin_bswap16(x))
+#define __DMB()                     __atomic_thread_fence(__ATOMIC_SEQ_CST)
+#define __IO                        volatile
+#define _VAL2FLD(field, value)      (((uint32_t)(value) << field ## _Pos) & field ## _Msk)
+#define _FLD2VAL(field, value)      (((uint32_t)(value) & field ## _Msk) >> field ## _Pos)
+
+static inline uint32_t __RBIT(uint32_t value) {
+  uint32_t result = 0U;
+
+  for (int i = 0; i < 32; i++, value >>= 1) {
+    result = (result << 1) | (value & 1U);
+  }
+  return result;
+}
+
+#include "ax5043_model.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+  extern ax5043_model_t sim_ax5043;
+  extern ax5043_model_t sim_ax5043b;
+  extern uint16_t sim_mcu_cal[3];
+  void boardInit(void);
+  void simAX5043Start(const ax5043_model_config_t *config);
+  uint64_t simTimeUS(void);
+#ifdef __cplusplus
+}
+#endif
+#endif /* _FROM_ASM_ */
+
+#endif /* BOARD_H */
@@ -0,0 +1,13 @@
+# List of all the board related files.
+BOARDSRC = $(BOARDDIR)/board.c            \
+           $(BOARDDIR)/ax5043_model.c     \
+           $(BOARDDIR)/mmc5883ma_model.c  \
+           $(BOARDDIR)/ina226_model.c     \
+           $(BOARDDIR)/max7310_model.c
+
+# Required include directories
+BOARDINC = $(BOARDDIR)
+
+# Shared variables
+ALLCSRC += $(BOARDSRC)
+ALLINC  += $(BOARDINC)
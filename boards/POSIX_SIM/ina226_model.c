@@ -0,0 +1,236 @@
+/**
+ * @file    ina226_model.c
+ * @brief   Register level INA226 model for the POSIX simulator.
+ * @details Models the big endian register file behind a register pointer,
+ *          reset, continuous and triggered conversions at the configured
+ *          conversion times and averaging, the conversion ready flag and
+ *          the ALERT pin in conversion ready mode. Results are the average
+ *          of the inputs over the conversion window, so a change part way
+ *          through a conversion shows up as a mix of the old and new
+ *          values, as it does on the chip. Writing CONFIG restarts the
+ *          conversion. Not thread safe, the caller serializes access and
+ *          supplies the time.
+ *
+ * @addtogroup INA226_MODEL
+ * @{
+ */
+#include <string.h>
+#include "hal.h"
+#include "ina226.h"
+#include "ina226_model.h"
+
+/*===========================================================================*/
+/* Model local definitions.                                                  */
+/*===========================================================================*/
+
+/* Samples averaged for each CONFIG AVG setting */
+static const uint32_t model_avg[] = {1U, 4U, 16U, 64U, 128U, 256U, 512U, 1024U};
+
+/* Conversion time for each CONFIG VBUSCT and VSHCT setting */
+static const uint32_t model_ct_us[] = {140U, 204U, 332U, 588U, 1100U, 2116U, 4156U, 8244U};
+
+/* Bits of Mask/Enable the host can write, the rest are flags */
+#define MODEL_ME_WRITABLE       (INA226_ME_LEN | INA226_ME_APOL | 0xFC00U)
+
+/*===========================================================================*/
+/* Model local functions.                                                    */
+/*===========================================================================*/
+
+/* Length of one conversion, zero when powered down */
+static uint32_t model_conv_time(const ina226_model_t *m) {
+    uint16_t cfg = m->regs[INA226_AD_CONFIG];
+    uint32_t mode = _FLD2VAL(INA226_CONFIG_MODE, cfg);
+    uint32_t us = 0U;
+
+    if (mode & INA226_CONFIG_MODE_SHUNT)
+        us += model_ct_us[_FLD2VAL(INA226_CONFIG_VSHCT, cfg)];
+    if (mode & INA226_CONFIG_MODE_VBUS)
+        us += model_ct_us[_FLD2VAL(INA226_CONFIG_VBUSCT, cfg)];
+    return us * model_avg[_FLD2VAL(INA226_CONFIG_AVG, cfg)];
+}
+
+static void model_accumulate(ina226_model_t *m, uint64_t to_us) {
+    if (m->converting && to_us > m->acc_from) {
+        m->bus_acc += (int64_t)m->bus_uv * (int64_t)(to_us - m->acc_from);
+        m->current_acc += (int64_t)m->current_ua * (int64_t)(to_us - m->acc_from);
+    }
+    m->acc_from = to_us;
+}
+
+static void model_start(ina226_model_t *m) {
+    uint32_t us = model_conv_time(m);
+
+    m->converting = us != 0U;
+    m->conv_start = m->now_us;
+    m->conv_end = m->now_us + us;
+    m->acc_from = m->now_us;
+    m->bus_acc = 0;
+    m->current_acc = 0;
+}
+
+static int16_t model_clamp16(int64_t v) {
+    if (v > INT16_MAX)
+        return INT16_MAX;
+    if (v < INT16_MIN)
+        return INT16_MIN;
+    return (int16_t)v;
+}
+
+/* Latches the averages of the finished conversion into the result registers */
+static void model_latch(ina226_model_t *m) {
+    uint16_t mode = _FLD2VAL(INA226_CONFIG_MODE, m->regs[INA226_AD_CONFIG]);
+    int64_t window = (int64_t)(m->conv_end - m->conv_start);
+    int64_t current_ua = m->current_acc / window;
+    int64_t bus_uv = m->bus_acc / window;
+
+    if (mode & INA226_CONFIG_MODE_SHUNT) {
+        /* 2.5 uV per bit */
+        int64_t shunt_nv = (current_ua * (int64_t)m->shunt_uohm) / 1000;
+        m->regs[INA226_AD_SHUNT] = (uint16_t)model_clamp16(shunt_nv / 2500);
+    }
+    if (mode & INA226_CONFIG_MODE_VBUS) {
+        /* 1.25 mV per bit, never negative */
+        m->regs[INA226_AD_VBUS] = bus_uv > 0 ? (uint16_t)(bus_uv / 1250) & 0x7FFFU : 0U;
+    }
+    m->regs[INA226_AD_CURRENT] = (uint16_t)model_clamp16(
+        ((int64_t)(int16_t)m->regs[INA226_AD_SHUNT] * m->regs[INA226_AD_CAL]) / 2048);
+    m->regs[INA226_AD_POWER] = (uint16_t)(
+        ((int64_t)(int16_t)m->regs[INA226_AD_CURRENT] * m->regs[INA226_AD_VBUS]) / 20000);
+    m->regs[INA226_AD_ME] |= INA226_ME_CVRF;
+    m->stats.conversions++;
+}
+
+static void model_reset(ina226_model_t *m) {
+    memset(m->regs, 0, sizeof(m->regs));
+    m->regs[INA226_AD_CONFIG] = INA226_MODEL_CONFIG_DEFAULT;
+    model_start(m);
+}
+
+static void model_write(ina226_model_t *m, uint8_t reg, uint16_t val) {
+    switch (reg) {
+    case INA226_AD_CONFIG:
+        if (val & INA226_CONFIG_RST) {
+            model_reset(m);
+            break;
+        }
+        /* Any write aborts the conversion in progress */
+        m->regs[reg] = val;
+        m->regs[INA226_AD_ME] &= ~INA226_ME_CVRF;
+        m->stats.restarts++;
+        model_start(m);
+        break;
+    case INA226_AD_CAL:
+        m->regs[reg] = val & 0x7FFFU;
+        break;
+    case INA226_AD_ME:
+        m->regs[reg] = (m->regs[reg] & ~MODEL_ME_WRITABLE) | (val & MODEL_ME_WRITABLE);
+        break;
+    case INA226_AD_LIM:
+        m->regs[reg] = val;
+        break;
+    default:
+        /* Results and IDs are read only */
+        break;
+    }
+}
+
+static uint16_t model_read(ina226_model_t *m, uint8_t reg) {
+    uint16_t val;
+
+    switch (reg) {
+    case INA226_AD_MFG_ID:
+        return INA226_MODEL_MFG_ID;
+    case INA226_AD_DIE_ID:
+        return INA226_MODEL_DIE_ID;
+    case INA226_AD_ME:
+        /* Reading clears the flags and releases ALERT */
+        val = m->regs[reg];
+        m->regs[reg] &= ~(INA226_ME_CVRF | INA226_ME_AFF);
+        return val;
+    default:
+        return reg < INA226_MODEL_REGS ? m->regs[reg] : 0U;
+    }
+}
+
+/*===========================================================================*/
+/* Model exported functions.                                                 */
+/*===========================================================================*/
+
+/**
+ * @brief   Powers the model up with no current and no bus voltage.
+ */
+void ina226ModelInit(ina226_model_t *m, uint32_t shunt_uohm) {
+    memset(m, 0, sizeof(*m));
+    m->shunt_uohm = shunt_uohm;
+    model_reset(m);
+}
+
+/**
+ * @brief   Runs the conversions due by @p now_us.
+ */
+void ina226ModelAdvance(ina226_model_t *m, uint64_t now_us) {
+    if (now_us <= m->now_us)
+        return;
+
+    while (m->converting && now_us >= m->conv_end) {
+        model_accumulate(m, m->conv_end);
+        model_latch(m);
+        m->now_us = m->conv_end;
+        if (_FLD2VAL(INA226_CONFIG_MODE, m->regs[INA226_AD_CONFIG]) & INA226_CONFIG_MODE_CONT) {
+            model_start(m);
+        } else {
+            m->converting = false;
+        }
+    }
+    model_accumulate(m, now_us);
+    m->now_us = now_us;
+}
+
+/**
+ * @brief   Answers one I2C transfer, register pointer first.
+ *
+ * @return              0 on ACK, -1 when the transfer is not understood
+ */
+int ina226ModelTransfer(ina226_model_t *m, const uint8_t *txbuf, size_t txbytes,
+                        uint8_t *rxbuf, size_t rxbytes) {
+    if (txbytes != 0U && txbytes != 1U && txbytes != 3U)
+        return -1;
+    if (rxbytes % 2U != 0U)
+        return -1;
+    m->stats.transfers++;
+
+    if (txbytes > 0U)
+        m->ptr = txbuf[0];
+    if (txbytes == 3U)
+        model_write(m, m->ptr, (uint16_t)((txbuf[1] << 8) | txbuf[2]));
+    for (size_t i = 0; i < rxbytes; i += 2U) {
+        /* The pointer does not advance, repeated words repeat the register */
+        uint16_t val = model_read(m, m->ptr);
+        rxbuf[i] = val >> 8;
+        rxbuf[i + 1U] = val & 0xFFU;
+    }
+    return 0;
+}
+
+/**
+ * @brief   Sets the bus voltage and the current through the shunt from
+ *          @p now_us on.
+ */
+void ina226ModelSetInput(ina226_model_t *m, uint64_t now_us, int32_t bus_uv, int32_t current_ua) {
+    ina226ModelAdvance(m, now_us);
+    m->bus_uv = bus_uv;
+    m->current_ua = current_ua;
+}
+
+/**
+ * @brief   Whether ALERT is asserted, the pin is low when it is unless
+ *          APOL is set.
+ * @note    Only the conversion ready function is modelled.
+ */
+bool ina226ModelAlert(const ina226_model_t *m) {
+    uint16_t me = m->regs[INA226_AD_ME];
+
+    return (me & INA226_ME_CNVR) && (me & INA226_ME_CVRF);
+}
+
+/** @} */
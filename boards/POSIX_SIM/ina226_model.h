@@ -0,0 +1,81 @@
+/**
+ * @file    ina226_model.h
+ * @brief   Register level INA226 model for the POSIX simulator.
+ *
+ * @addtogroup INA226_MODEL
+ * @{
+ */
+#ifndef _INA226_MODEL_H_
+#define _INA226_MODEL_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/*===========================================================================*/
+/* Model constants.                                                          */
+/*===========================================================================*/
+
+#define INA226_MODEL_REGS                   8U
+#define INA226_MODEL_CONFIG_DEFAULT         0x4127U
+#define INA226_MODEL_MFG_ID                 0x5449U
+#define INA226_MODEL_DIE_ID                 0x2260U
+
+/*===========================================================================*/
+/* Model data structures and types.                                          */
+/*===========================================================================*/
+
+/**
+ * @brief   Model statistics.
+ */
+typedef struct {
+    uint32_t                    conversions;    /**< Completed conversions.     */
+    uint32_t                    restarts;       /**< Conversions restarted by a
+                                                     CONFIG write.              */
+    uint32_t                    transfers;      /**< I2C transfers answered.    */
+} ina226_model_stats_t;
+
+/**
+ * @brief   INA226 model state.
+ */
+typedef struct {
+    uint16_t                    regs[INA226_MODEL_REGS];
+    uint8_t                     ptr;            /**< Register pointer.          */
+    uint32_t                    shunt_uohm;     /**< Shunt resistor.            */
+    uint64_t                    now_us;
+
+    /* Inputs, held until the next change */
+    int32_t                     bus_uv;
+    int32_t                     current_ua;
+
+    /* Conversion in progress and the inputs integrated over it */
+    bool                        converting;
+    uint64_t                    conv_start;
+    uint64_t                    conv_end;
+    uint64_t                    acc_from;
+    int64_t                     bus_acc;
+    int64_t                     current_acc;
+
+    ina226_model_stats_t        stats;
+} ina226_model_t;
+
+/*===========================================================================*/
+/* External declarations.                                                    */
+/*===========================================================================*/
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+void ina226ModelInit(ina226_model_t *m, uint32_t shunt_uohm);
+void ina226ModelAdvance(ina226_model_t *m, uint64_t now_us);
+int ina226ModelTransfer(ina226_model_t *m, const uint8_t *txbuf, size_t txbytes,
+                        uint8_t *rxbuf, size_t rxbytes);
+void ina226ModelSetInput(ina226_model_t *m, uint64_t now_us, int32_t bus_uv, int32_t current_ua);
+bool ina226ModelAlert(const ina226_model_t *m);
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _INA226_MODEL_H_ */
+
+/** @} */
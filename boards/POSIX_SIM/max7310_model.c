@@ -0,0 +1,128 @@
+/**
+ * @file    max7310_model.c
+ * @brief   Register level MAX7310 model for the POSIX simulator.
+ * @details Models the register file behind a register pointer that does
+ *          not advance, with the power-on values, and the port pins. A pin
+ *          configured as an output drives its output register bit, an
+ *          input is released, and a low from outside always wins, so the
+ *          pins can be wired to an open drain bus. The input register reads
+ *          the pin levels through the polarity register. The bus timeout is
+ *          not modelled. Not thread safe, the caller serializes access.
+ *
+ * @addtogroup MAX7310_MODEL
+ * @{
+ */
+#include <string.h>
+#include "hal.h"
+#include "max7310.h"
+#include "max7310_model.h"
+
+/*===========================================================================*/
+/* Model local functions.                                                    */
+/*===========================================================================*/
+
+static uint8_t model_pins(const max7310_model_t *m) {
+    uint8_t driven = m->regs[MAX7310_AD_ODR] | m->regs[MAX7310_AD_MODE];
+
+    return driven & m->ext;
+}
+
+/* Reports the pins when a write changed them */
+static void model_update(max7310_model_t *m) {
+    uint8_t pins = model_pins(m);
+
+    if (pins != m->pins) {
+        m->pins = pins;
+        if (m->hook != NULL)
+            m->hook(m->hook_arg, pins);
+    }
+}
+
+static uint8_t model_read(max7310_model_t *m, uint8_t reg) {
+    m->stats.reads++;
+    if (reg == MAX7310_AD_INPUT)
+        return model_pins(m) ^ m->regs[MAX7310_AD_POL];
+    return m->regs[reg];
+}
+
+static void model_write(max7310_model_t *m, uint8_t reg, uint8_t val) {
+    m->stats.writes++;
+    switch (reg) {
+    case MAX7310_AD_INPUT:
+        /* Read only */
+        break;
+    case MAX7310_AD_TIMEOUT:
+        m->regs[reg] = val & MAX7310_TIMEOUT_MASK;
+        break;
+    default:
+        m->regs[reg] = val;
+        model_update(m);
+        break;
+    }
+}
+
+/*===========================================================================*/
+/* Model exported functions.                                                 */
+/*===========================================================================*/
+
+/**
+ * @brief   Powers the model up with every pin an input and nothing driving
+ *          them from outside.
+ */
+void max7310ModelInit(max7310_model_t *m) {
+    memset(m, 0, sizeof(*m));
+    m->regs[MAX7310_AD_POL] = MAX7310_MODEL_POL_DEFAULT;
+    m->regs[MAX7310_AD_MODE] = MAX7310_MODEL_MODE_DEFAULT;
+    m->regs[MAX7310_AD_TIMEOUT] = MAX7310_MODEL_TIMEOUT_DEFAULT;
+    m->ext = 0xFFU;
+    m->pins = model_pins(m);
+}
+
+/**
+ * @brief   Answers one I2C transfer, register pointer first.
+ *
+ * @return              0 on ACK, -1 when the transfer is not understood
+ */
+int max7310ModelTransfer(max7310_model_t *m, const uint8_t *txbuf, size_t txbytes,
+                         uint8_t *rxbuf, size_t rxbytes) {
+    if (txbytes > 2U || (txbytes == 2U && rxbytes != 0U))
+        return -1;
+    if (txbytes > 0U && txbuf[0] >= MAX7310_MODEL_REGS)
+        return -1;
+    m->stats.transfers++;
+
+    if (txbytes > 0U)
+        m->ptr = txbuf[0];
+    if (txbytes == 2U)
+        model_write(m, m->ptr, txbuf[1]);
+    for (size_t i = 0; i < rxbytes; i++) {
+        rxbuf[i] = model_read(m, m->ptr);
+    }
+    return 0;
+}
+
+/**
+ * @brief   Drives the pins from outside, a 0 bit pulls the pin low.
+ * @note    Does not run the pin observer, the caller is the outside.
+ */
+void max7310ModelSetInput(max7310_model_t *m, uint8_t ext) {
+    m->ext = ext;
+    m->pins = model_pins(m);
+}
+
+/**
+ * @brief   Observes the pin levels set by register writes.
+ */
+void max7310ModelSetPinsHook(max7310_model_t *m, max7310_model_pins_t hook, void *arg) {
+    m->hook = hook;
+    m->hook_arg = arg;
+}
+
+/**
+ * @brief   The levels on the pins.
+ */
+uint8_t max7310ModelPins(const max7310_model_t *m) {
+    return model_pins(m);
+}
+
+/** @} */
@@ -0,0 +1,76 @@
+/**
+ * @file    max7310_model.h
+ * @brief   Register level MAX7310 model for the POSIX simulator.
+ *
+ * @addtogroup MAX7310_MODEL
+ * @{
+ */
+#ifndef _MAX7310_MODEL_H_
+#define _MAX7310_MODEL_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/*===========================================================================*/
+/* Model constants.                                                          */
+/*===========================================================================*/
+
+#define MAX7310_MODEL_REGS                  5U
+#define MAX7310_MODEL_POL_DEFAULT           0xF0U
+#define MAX7310_MODEL_MODE_DEFAULT          0xFFU
+#define MAX7310_MODEL_TIMEOUT_DEFAULT       0x01U
+
+/*===========================================================================*/
+/* Model data structures and types.                                          */
+/*===========================================================================*/
+
+/**
+ * @brief   Pin observer, runs when a register write changes the pin levels.
+ */
+typedef void (*max7310_model_pins_t)(void *arg, uint8_t pins);
+
+/**
+ * @brief   Model statistics.
+ */
+typedef struct {
+    uint32_t                    reads;          /**< Register reads.            */
+    uint32_t                    writes;         /**< Register writes.           */
+    uint32_t                    transfers;      /**< I2C transfers answered.    */
+} max7310_model_stats_t;
+
+/**
+ * @brief   MAX7310 model state.
+ */
+typedef struct {
+    uint8_t                     regs[MAX7310_MODEL_REGS];
+    uint8_t                     ptr;            /**< Register pointer.          */
+    uint8_t                     ext;            /**< Levels driven from outside,
+                                                     1 where released.          */
+    uint8_t                     pins;           /**< Last levels reported.      */
+    max7310_model_pins_t        hook;
+    void                        *hook_arg;
+
+    max7310_model_stats_t       stats;
+} max7310_model_t;
+
+/*===========================================================================*/
+/* External declarations.                                                    */
+/*===========================================================================*/
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+void max7310ModelInit(max7310_model_t *m);
+int max7310ModelTransfer(max7310_model_t *m, const uint8_t *txbuf, size_t txbytes,
+                         uint8_t *rxbuf, size_t rxbytes);
+void max7310ModelSetInput(max7310_model_t *m, uint8_t ext);
+void max7310ModelSetPinsHook(max7310_model_t *m, max7310_model_pins_t hook, void *arg);
+uint8_t max7310ModelPins(const max7310_model_t *m);
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _MAX7310_MODEL_H_ */
+
+/** @} */
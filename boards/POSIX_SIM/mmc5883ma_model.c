@@ -0,0 +1,189 @@
+/**
+ * @file    mmc5883ma_model.c
+ * @brief   Register level MMC5883MA model for the POSIX simulator.
+ * @details Models the register file with auto incrementing reads, software
+ *          reset, triggered and continuous measurements at the configured
+ *          bandwidth and rate, the measurement done status bit, and the
+ *          SET/RESET bridge polarity. Each output is the null field plus
+ *          the bridge offset, plus or minus the field depending on the
+ *          polarity, so SET/RESET offset cancellation can be checked. Not
+ *          thread safe, the caller serializes access and supplies the time.
+ *
+ * @addtogroup MMC5883MA_MODEL
+ * @{
+ */
+#include <string.h>
+#include "hal.h"
+#include "mmc5883ma.h"
+#include "mmc5883ma_model.h"
+
+/*===========================================================================*/
+/* Model local definitions.                                                  */
+/*===========================================================================*/
+
+#define MODEL_NULL_FIELD                    32768
+
+/* Measurement time for each INTRNLCTRL1 bandwidth setting */
+static const uint32_t model_meas_us[] = {10000U, 5000U, 2500U, 1600U};
+
+/* Continuous mode period for each INTRNLCTRL2 CM_FREQ setting, 0 is off */
+static const uint32_t model_cm_us[] = {
+    0U, 71429U, 200000U, 454545U, 1000000U, 2000000U, 4000000U, 8000000U,
+    16000000U, 32000000U, 64000000U,
+};
+
+/*===========================================================================*/
+/* Model local functions.                                                    */
+/*===========================================================================*/
+
+static uint32_t model_meas_time(const mmc5883ma_model_t *m) {
+    return model_meas_us[_FLD2VAL(MMC5883MA_INTRNLCTRL1_BW, m->regs[MMC5883MA_AD_INTRNLCTRL1])];
+}
+
+static uint32_t model_cm_period(const mmc5883ma_model_t *m) {
+    uint8_t freq = _FLD2VAL(MMC5883MA_INTRNLCTRL2_CM_FREQ, m->regs[MMC5883MA_AD_INTRNLCTRL2]);
+
+    return freq < sizeof(model_cm_us) / sizeof(model_cm_us[0]) ? model_cm_us[freq] : 0U;
+}
+
+/* Latches a sample into the output registers */
+static void model_sample(mmc5883ma_model_t *m) {
+    for (int i = 0; i < 3; i++) {
+        int32_t out = MODEL_NULL_FIELD + m->offset[i] +
+                      (m->set_polarity ? m->field[i] : -m->field[i]);
+        if (out < 0)
+            out = 0;
+        if (out > 0xFFFF)
+            out = 0xFFFF;
+        m->regs[MMC5883MA_AD_XOUT_LOW + 2 * i] = out & 0xFFU;
+        m->regs[MMC5883MA_AD_XOUT_HIGH + 2 * i] = out >> 8;
+    }
+    m->regs[MMC5883MA_AD_STATUS] |= MMC5883MA_STATUS_MEAS_M_DONE;
+    m->stats.measurements++;
+}
+
+static void model_reset(mmc5883ma_model_t *m) {
+    memset(m->regs, 0, sizeof(m->regs));
+    m->regs[MMC5883MA_AD_PRDCT_ID_1] = MMC5883MA_PRDCT_ID_EXPECTED;
+    m->measuring = false;
+}
+
+static void model_write(mmc5883ma_model_t *m, uint8_t reg, uint8_t val) {
+    switch (reg) {
+    case MMC5883MA_AD_STATUS:
+        /* Write one to clear */
+        m->regs[reg] &= ~val;
+        break;
+    case MMC5883MA_AD_INTRNLCTRL0:
+        if (val & MMC5883MA_INTRNLCTRL0_SET_CMD) {
+            m->set_polarity = true;
+            m->stats.sets++;
+        }
+        if (val & MMC5883MA_INTRNLCTRL0_RST_CMD) {
+            m->set_polarity = false;
+            m->stats.rsts++;
+        }
+        if ((val & MMC5883MA_INTRNLCTRL0_TM_M_INIT) && !m->measuring) {
+            m->measuring = true;
+            m->meas_at = m->now_us + model_meas_time(m);
+        }
+        break;
+    case MMC5883MA_AD_INTRNLCTRL1:
+        if (val & MMC5883MA_INTRNLCTRL1_SW_RST_CMD) {
+            model_reset(m);
+            m->stats.resets++;
+        } else {
+            m->regs[reg] = val;
+        }
+        break;
+    case MMC5883MA_AD_INTRNLCTRL2:
+        m->regs[reg] = val;
+        if (model_cm_period(m) != 0U) {
+            m->cm_at = m->now_us + model_cm_period(m);
+        }
+        break;
+    default:
+        /* Outputs and product ID are read only */
+        if (reg >= MMC5883MA_AD_INTRNLCTRL0 && reg < MMC5883MA_MODEL_REGS &&
+            reg != MMC5883MA_AD_PRDCT_ID_1)
+            m->regs[reg] = val;
+        break;
+    }
+}
+
+/*===========================================================================*/
+/* Model exported functions.                                                 */
+/*===========================================================================*/
+
+/**
+ * @brief   Powers the model up with a zero field and no bridge offset.
+ */
+void mmc5883maModelInit(mmc5883ma_model_t *m) {
+    memset(m, 0, sizeof(*m));
+    model_reset(m);
+    m->set_polarity = true;
+}
+
+/**
+ * @brief   Runs the measurements due by @p now_us.
+ */
+void mmc5883maModelAdvance(mmc5883ma_model_t *m, uint64_t now_us) {
+    uint32_t period;
+
+    if (now_us <= m->now_us)
+        return;
+    m->now_us = now_us;
+
+    if (m->measuring && now_us >= m->meas_at) {
+        m->measuring = false;
+        model_sample(m);
+    }
+    period = model_cm_period(m);
+    if (period != 0U && now_us >= m->cm_at) {
+        /* Only the latest sample is kept */
+        model_sample(m);
+        m->cm_at += ((now_us - m->cm_at) / period + 1U) * period;
+    }
+}
+
+/**
+ * @brief   Answers one I2C transfer, register address first.
+ *
+ * @return              0 on ACK, -1 when the transfer is not understood
+ */
+int mmc5883maModelTransfer(mmc5883ma_model_t *m, const uint8_t *txbuf, size_t txbytes,
+                           uint8_t *rxbuf, size_t rxbytes) {
+    uint8_t reg;
+
+    if (txbytes == 0U)
+        return -1;
+    m->stats.transfers++;
+    reg = txbuf[0];
+    for (size_t i = 1; i < txbytes; i++, reg++) {
+        model_write(m, reg, txbuf[i]);
+    }
+    for (size_t i = 0; i < rxbytes; i++, reg++) {
+        rxbuf[i] = reg < MMC5883MA_MODEL_REGS ? m->regs[reg] : 0U;
+    }
+    return 0;
+}
+
+/**
+ * @brief   Sets the field at the sensor in milligauss.
+ */
+void mmc5883maModelSetField(mmc5883ma_model_t *m, int32_t x_mg, int32_t y_mg, int32_t z_mg) {
+    m->field[0] = (x_mg * MMC5883MA_COUNTS_PER_GAUSS) / 1000;
+    m->field[1] = (y_mg * MMC5883MA_COUNTS_PER_GAUSS) / 1000;
+    m->field[2] = (z_mg * MMC5883MA_COUNTS_PER_GAUSS) / 1000;
+}
+
+/**
+ * @brief   Sets the bridge offset in counts, as temperature drift would.
+ */
+void mmc5883maModelSetOffset(mmc5883ma_model_t *m, int32_t x, int32_t y, int32_t z) {
+    m->offset[0] = x;
+    m->offset[1] = y;
+    m->offset[2] = z;
+}
+
+/** @} */
@@ -0,0 +1,75 @@
+/**
+ * @file    mmc5883ma_model.h
+ * @brief   Register level MMC5883MA model for the POSIX simulator.
+ *
+ * @addtogroup MMC5883MA_MODEL
+ * @{
+ */
+#ifndef _MMC5883MA_MODEL_H_
+#define _MMC5883MA_MODEL_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/*===========================================================================*/
+/* Model constants.                                                          */
+/*===========================================================================*/
+
+#define MMC5883MA_MODEL_REGS                0x30U
+
+/*===========================================================================*/
+/* Model data structures and types.                                          */
+/*===========================================================================*/
+
+/**
+ * @brief   Model statistics.
+ */
+typedef struct {
+    uint32_t                    resets;         /**< Software resets.           */
+    uint32_t                    sets;           /**< SET pulses.                */
+    uint32_t                    rsts;           /**< RESET pulses.              */
+    uint32_t                    measurements;   /**< Completed measurements.    */
+    uint32_t                    transfers;      /**< I2C transfers answered.    */
+} mmc5883ma_model_stats_t;
+
+/**
+ * @brief   MMC5883MA model state.
+ */
+typedef struct {
+    uint8_t                     regs[MMC5883MA_MODEL_REGS];
+    uint64_t                    now_us;
+
+    /* Field at the sensor in counts, bridge offset in counts */
+    int32_t                     field[3];
+    int32_t                     offset[3];
+    bool                        set_polarity;
+
+    /* Triggered measurement in progress and the next continuous one */
+    bool                        measuring;
+    uint64_t                    meas_at;
+    uint64_t                    cm_at;
+
+    mmc5883ma_model_stats_t     stats;
+} mmc5883ma_model_t;
+
+/*===========================================================================*/
+/* External declarations.                                                    */
+/*===========================================================================*/
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+void mmc5883maModelInit(mmc5883ma_model_t *m);
+void mmc5883maModelAdvance(mmc5883ma_model_t *m, uint64_t now_us);
+int mmc5883maModelTransfer(mmc5883ma_model_t *m, const uint8_t *txbuf, size_t txbytes,
+                           uint8_t *rxbuf, size_t rxbytes);
+void mmc5883maModelSetField(mmc5883ma_model_t *m, int32_t x_mg, int32_t y_mg, int32_t z_mg);
+void mmc5883maModelSetOffset(mmc5883ma_model_t *m, int32_t x, int32_t y, int32_t z);
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _MMC5883MA_MODEL_H_ */
+
+/** @} */
@@ -202,6 +202,7 @@
 #define LINE_LED                    PAL_LINE(GPIOA, 4U)
 #define LINE_DEBUG                  PAL_LINE(GPIOA, 4U)
 #define LINE_OUTPUT_EN              PAL_LINE(GPIOA, 5U)
+#define LINE_ALERT                  PAL_LINE(GPIOA, 6U)
 #define LINE_CAN_SILENT             PAL_LINE(GPIOA, 9U)
 #define LINE_CAN_SHDN               PAL_LINE(GPIOA, 10U)
 
@@ -32,6 +32,7 @@
 
 MUTEX_DECL(emcy_mutex);
 MUTEX_DECL(od_mutex);
+volatile uint32_t od_seq;
 
 /* Interrupt callback prototypes*/
 void CO_CANrx_cb(CANDriver *canp, uint32_t flags);
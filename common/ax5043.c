@@ -174,8 +174,105 @@ eventmask_t ax5043WaitIRQ(AX5043Driver *devp, uint16_t irq, sysinterval_t timeou
     return event;
 }
 
+/**
+ * @brief   Length of a FIFO chunk header.
+ *
+ * @param[in]   header      First byte of the chunk
+ *
+ * @return                  2 for variable length chunks, 1 otherwise
+ * @notapi
+ */
+static inline size_t ax5043ChunkHdr(uint8_t header) {
+    return (_FLD2VAL(AX5043_FIFOCHUNK_SIZE, header) == AX5043_CHUNKSIZE_VAR ? 2 : 1);
+}
+
+/**
+ * @brief   Length of the FIFO chunk at the start of a buffer.
+ *
+ * @param[in]   buf         Buffer holding FIFO data
+ * @param[in]   avail       Number of bytes in @p buf
+ *
+ * @return                  Chunk length including header, 0 if incomplete
+ * @notapi
+ */
+static size_t ax5043ChunkLen(const uint8_t *buf, size_t avail) {
+    size_t length;
+
+    if (avail < 1) {
+        return 0;
+    }
+    if (ax5043ChunkHdr(buf[0]) == 2) {
+        if (avail < 2) {
+            return 0;
+        }
+        length = 2 + buf[1];
+    } else {
+        length = 1 + _FLD2VAL(AX5043_FIFOCHUNK_SIZE, buf[0]);
+    }
+    return (length <= avail ? length : 0);
+}
+
+/**
+ * @brief   Collects the DATA flags of the packet starting at a buffer.
+ * @details Used to drop bad frames before they take a frame buffer when the
+ *          whole packet arrived in one burst.
+ *
+ * @param[in]   buf         Buffer starting with the PKTSTART chunk
+ * @param[in]   avail       Number of bytes in @p buf
+ *
+ * @return                  OR of all DATA flags, PKTEND set if complete
+ * @notapi
+ */
+static uint8_t ax5043PktFlags(const uint8_t *buf, size_t avail) {
+    uint8_t flags = 0;
+    size_t off = 0;
+    size_t length;
+
+    while ((length = ax5043ChunkLen(&buf[off], avail - off)) != 0) {
+        if (_FLD2VAL(AX5043_FIFOCHUNK_CMD, buf[off]) == AX5043_CHUNKCMD_DATA) {
+            flags |= buf[off + ax5043ChunkHdr(buf[off])];
+            if (flags & AX5043_CHUNK_DATARX_PKTEND) {
+                break;
+            }
+        }
+        off += length;
+    }
+    return flags;
+}
+
+/**
+ * @brief   Accounts a frame dropped on receive error flags.
+ *
+ * @param[in]   devp        Pointer to the @p AX5043Driver object
+ * @param[in]   flags       DATA RX chunk flags
+ *
+ * @notapi
+ */
+static void ax5043RXError(AX5043Driver *devp, uint8_t flags) {
+    if (flags & AX5043_CHUNK_DATARX_CRCFAIL) {
+        devp->rx_stats.crc_fail++;
+    }
+    if (flags & AX5043_CHUNK_DATARX_ADDRFAIL) {
+        devp->rx_stats.addr_fail++;
+    }
+    if (flags & AX5043_CHUNK_DATARX_SIZEFAIL) {
+        devp->rx_stats.size_fail++;
+    }
+    if (flags & AX5043_CHUNK_DATARX_ABORT) {
+        devp->rx_stats.abort++;
+    }
+    if (devp->config->rx_err_cb != NULL) {
+        devp->config->rx_err_cb(devp->config->phy_arg, flags);
+    }
+}
+
 /**
  * @brief   RX worker thread for handling AX5043 receive data.
+ * @details Sleeps on FIFO not empty while idle. Once a packet is under way it
+ *          wakes on the FIFO threshold (or a short poll for the tail) and
+ *          reads everything pending in a single burst, so several chunks
+ *          cost one SPI transaction. Chunks split across bursts are carried
+ *          over to the next one.
  *
  * @param[in]   arg         Pointer to the @p AX5043Driver object
  *
@@ -185,102 +282,152 @@ THD_FUNCTION(rx_worker, arg) {
     AX5043Driver *devp = arg;
     objects_fifo_t *fifo = devp->config->fifo;
     fb_t *fb = NULL;
-    uint8_t buf[AX5043_FIFO_SIZE];
-    ax5043_rx_chunk_t *chunkp = (ax5043_rx_chunk_t*)buf;
-    uint8_t header;
-    size_t length, data_len;
+    uint8_t buf[AX5043_FIFO_SIZE * 2];
+    size_t avail = 0, off, length, data_len, n;
+    const ax5043_rx_chunk_t *chunkp;
+    uint8_t header, flags;
+    bool drop = false;
+    eventmask_t event;
     uint8_t *pos;
+    /* Metadata of the frame being assembled, later frames overwrite devp's */
+    int8_t rssi = 0;
+    uint32_t rf_freq_off = 0;
 
     osalDbgCheck(devp != NULL);
 
     while (!chThdShouldTerminateX()) {
 
         /* Wait for FIFO data */
-        if (ax5043WaitIRQ(devp, AX5043_IRQ_FIFONOTEMPTY, TIME_INFINITE) & AX5043_EVENT_TERMINATE) {
+        if (avail == 0 && fb == NULL && !drop) {
+            event = ax5043WaitIRQ(devp, AX5043_IRQ_FIFONOTEMPTY, TIME_INFINITE);
+        } else {
+            event = ax5043WaitIRQ(devp, AX5043_IRQ_FIFOTHRCNT, AX5043_RX_POLL_TIME);
+        }
+        if (event & AX5043_EVENT_TERMINATE) {
             continue;
         }
 
-        /* Get chunk header from FIFO */
-        ax5043Exchange(devp, AX5043_REG_FIFODATA, false, NULL, &header, 1);
-
-        /* Determine chunk length */
-        length = _FLD2VAL(AX5043_FIFOCHUNK_SIZE, header);
-        if (length == AX5043_CHUNKSIZE_VAR) {
-            ax5043Exchange(devp, AX5043_REG_FIFODATA, false, NULL, &length, 1);
+        /* Read everything pending in one burst */
+        n = ax5043ReadU16(devp, AX5043_REG_FIFOCOUNT);
+        n = (n < AX5043_FIFO_SIZE ? n : AX5043_FIFO_SIZE);
+        n = (n < sizeof(buf) - avail ? n : sizeof(buf) - avail);
+        if (n == 0) {
+            continue;
         }
+        ax5043Exchange(devp, AX5043_REG_FIFODATA, false, NULL, &buf[avail], n);
+        devp->rx_stats.fifo_reads++;
+        avail += n;
+
+        /* Process complete chunks */
+        for (off = 0; (length = ax5043ChunkLen(&buf[off], avail - off)) != 0; off += length) {
+            header = buf[off];
+            chunkp = (const ax5043_rx_chunk_t*)&buf[off + ax5043ChunkHdr(header)];
+
+            switch (_FLD2VAL(AX5043_FIFOCHUNK_CMD, header)) {
+            case AX5043_CHUNKCMD_DATA:
+                data_len = length - ax5043ChunkHdr(header) - sizeof(ax5043_chunk_data_t);
+                flags = chunkp->data.flags;
+                /* Start of new packet */
+                if (flags & AX5043_CHUNK_DATARX_PKTSTART) {
+                    if (fb != NULL) {
+                        fb_free(fb, fifo);
+                        fb = NULL;
+                    }
+                    /* Drop the whole packet up front if it is all here and bad */
+                    drop = false;
+                    uint8_t pkt_flags = ax5043PktFlags(&buf[off], avail - off);
+                    if ((pkt_flags & AX5043_CHUNK_DATARX_PKTEND) && (pkt_flags & AX5043_CHUNK_DATARX_ERR)) {
+                        ax5043RXError(devp, pkt_flags);
+                        drop = true;
+                    } else {
+                        /* Acquire frame buffer object */
+                        while (fb == NULL) {
+                            fb = fb_alloc(FB_MAX_LEN, fifo);
+                        }
+                        fb->phy_rx = devp;
+                        fb->phy_arg = (void*)devp->config->phy_arg;
+                        /* The chip stores these ahead of the packet data */
+                        rssi = devp->rssi;
+                        rf_freq_off = devp->rf_freq_off;
+                    }
+                }
 
-        /* Get chunk */
-        ax5043Exchange(devp, AX5043_REG_FIFODATA, false, NULL, buf, length);
-
-        /* Process chunk */
-        switch (_FLD2VAL(AX5043_FIFOCHUNK_CMD, header)) {
-        case AX5043_CHUNKCMD_DATA:
-            data_len = length - sizeof(ax5043_chunk_data_t);
-            /* TODO: Handle error flags */
-            /* Start of new packet */
-            if (chunkp->data.flags & AX5043_CHUNK_DATARX_PKTSTART) {
-                /* Acquire frame buffer object if needed */
-                if (fb != NULL) {
+                if (drop || fb == NULL) {
+                    /* Skip the rest of a dropped packet */
+                    if (flags & AX5043_CHUNK_DATARX_PKTEND) {
+                        drop = false;
+                    }
+                    break;
+                }
+
+                /* Error flagged in a packet spanning several bursts */
+                if (flags & AX5043_CHUNK_DATARX_ERR) {
+                    ax5043RXError(devp, flags);
                     fb_free(fb, fifo);
                     fb = NULL;
+                    drop = !(flags & AX5043_CHUNK_DATARX_PKTEND);
+                    break;
                 }
-                while (fb == NULL) {
-                    fb = fb_alloc(FB_MAX_LEN, fifo);
-                }
-                fb->phy_rx = devp;
-                fb->phy_arg = (void*)devp->config->phy_arg;
-            }
 
-            osalDbgAssert(fb != NULL, "rx_worker(), NULL frame buffer object");
-            pos = fb_put(fb, data_len);
-            if (pos != NULL) {
-                /* Copy packet data */
-                memcpy(pos, chunkp->data.data, data_len);
-            } else {
-                /* Length exceeds maximum frame buffer length, abort receive */
-                uint8_t reg = ax5043ReadU8(devp, AX5043_REG_FRAMING);
-                reg |= AX5043_FRAMING_FABORT;
-                ax5043WriteU8(devp, AX5043_REG_FRAMING, reg);
-                fb_free(fb, fifo);
-                fb = NULL;
-            }
+                pos = fb_put(fb, data_len);
+                if (pos != NULL) {
+                    /* Copy packet data */
+                    memcpy(pos, chunkp->data.data, data_len);
+                } else {
+                    /* Length exceeds maximum frame buffer length, abort receive */
+                    uint8_t reg = ax5043ReadU8(devp, AX5043_REG_FRAMING);
+                    reg |= AX5043_FRAMING_FABORT;
+                    ax5043WriteU8(devp, AX5043_REG_FRAMING, reg);
+                    devp->rx_stats.overflow++;
+                    fb_free(fb, fifo);
+                    fb = NULL;
+                    drop = !(flags & AX5043_CHUNK_DATARX_PKTEND);
+                    break;
+                }
 
-            /* End of packet */
-            if (chunkp->data.flags & AX5043_CHUNK_DATARX_PKTEND) {
-                if (fb != NULL) {
+                /* End of packet */
+                if (flags & AX5043_CHUNK_DATARX_PKTEND) {
+                    devp->rx_stats.frames++;
+                    if (devp->config->rx_frame_cb != NULL) {
+                        devp->config->rx_frame_cb(devp->config->phy_arg, rssi, rf_freq_off);
+                    }
                     pdu_send(fb, fifo);
                     fb = NULL;
                 }
+                break;
+            case AX5043_CHUNKCMD_TIMER:
+                devp->timer = __REV(chunkp->timer.timer << 8);
+                break;
+            case AX5043_CHUNKCMD_RSSI:
+                devp->rssi = chunkp->rssi.rssi;
+                break;
+            case AX5043_CHUNKCMD_FREQOFFS:
+                devp->freq_off = __REV(chunkp->freqoffs.freqoffs << 8);
+                break;
+            case AX5043_CHUNKCMD_RFFREQOFFS:
+                devp->rf_freq_off = __REV(chunkp->rffreqoffs.rffreqoffs << 8);
+                break;
+            case AX5043_CHUNKCMD_DATARATE:
+                devp->datarate = __REV(chunkp->datarate.datarate << 8);
+                break;
+            case AX5043_CHUNKCMD_ANTRSSI:
+                if (length - ax5043ChunkHdr(header) == 2) {
+                    devp->ant0rssi = chunkp->antrssi2.rssi;
+                    devp->bgndnoise = chunkp->antrssi2.bgndnoise;
+                } else if (length - ax5043ChunkHdr(header) == 3) {
+                    devp->ant0rssi = chunkp->antrssi3.ant0rssi;
+                    devp->ant1rssi = chunkp->antrssi3.ant1rssi;
+                    devp->bgndnoise = chunkp->antrssi3.bgndnoise;
+                }
+                break;
+            default:
+                break;
             }
-            break;
-        case AX5043_CHUNKCMD_TIMER:
-            devp->timer = __REV(chunkp->timer.timer << 8);
-            break;
-        case AX5043_CHUNKCMD_RSSI:
-            devp->rssi = chunkp->rssi.rssi;
-            break;
-        case AX5043_CHUNKCMD_FREQOFFS:
-            devp->freq_off = __REV(chunkp->freqoffs.freqoffs << 8);
-            break;
-        case AX5043_CHUNKCMD_RFFREQOFFS:
-            devp->rf_freq_off = __REV(chunkp->rffreqoffs.rffreqoffs << 8);
-            break;
-        case AX5043_CHUNKCMD_DATARATE:
-            devp->datarate = __REV(chunkp->datarate.datarate << 8);
-            break;
-        case AX5043_CHUNKCMD_ANTRSSI:
-            if (length == 2) {
-                devp->ant0rssi = chunkp->antrssi2.rssi;
-                devp->bgndnoise = chunkp->antrssi2.bgndnoise;
-            } else if (length == 3) {
-                devp->ant0rssi = chunkp->antrssi3.ant0rssi;
-                devp->ant1rssi = chunkp->antrssi3.ant1rssi;
-                devp->bgndnoise = chunkp->antrssi3.bgndnoise;
-            }
-            break;
-        default:
-            break;
         }
+
+        /* Carry a partial chunk over to the next burst */
+        avail -= off;
+        memmove(buf, &buf[off], avail);
     }
 
     if (fb != NULL) {
@@ -382,6 +529,97 @@ void ax5043SetRFDIV(AX5043Driver *devp, uint32_t freq) {
     ax5043WriteU8(devp, AX5043_REG_0xF34, (pllvcodiv & AX5043_PLLVCODIV_RFDIV ? AX5043_0xF34_RFDIV : AX5043_0xF34_NORFDIV));
 }
 
+/**
+ * @brief   Finds a cached VCO range for the active profile and a frequency.
+ * @details Entries ranged more than @p AX5043_VCO_TEMP_DELTA away from the
+ *          current temperature are ignored.
+ *
+ * @param[in]   freq        FREQA/FREQB register value
+ *
+ * @return                  The entry, or NULL if not cached.
+ * @notapi
+ */
+static ax5043_vco_t *ax5043VCOLookup(AX5043Driver *devp, uint32_t freq) {
+    for (uint32_t i = 0; i < AX5043_VCO_CACHE_SIZE; i++) {
+        ax5043_vco_t *entry = &devp->vco_cache[i];
+        if (entry->vcor == 0 || entry->profile != devp->profile || entry->freq != freq) {
+            continue;
+        }
+        if (devp->vco_temp != AX5043_VCO_TEMP_UNKNOWN && entry->temp != AX5043_VCO_TEMP_UNKNOWN &&
+                (devp->vco_temp - entry->temp > AX5043_VCO_TEMP_DELTA ||
+                 entry->temp - devp->vco_temp > AX5043_VCO_TEMP_DELTA)) {
+            return NULL;
+        }
+        return entry;
+    }
+    return NULL;
+}
+
+/**
+ * @brief   Records a VCO range for the active profile and a frequency.
+ * @details Replaces a stale entry for the same key, otherwise round robin.
+ *
+ * @param[in]   freq        FREQA/FREQB register value
+ * @param[in]   vcor        VCO range found by autoranging
+ *
+ * @notapi
+ */
+static void ax5043VCOStore(AX5043Driver *devp, uint32_t freq, uint8_t vcor) {
+    ax5043_vco_t *entry = NULL;
+
+    for (uint32_t i = 0; i < AX5043_VCO_CACHE_SIZE; i++) {
+        if (devp->vco_cache[i].profile == devp->profile && devp->vco_cache[i].freq == freq) {
+            entry = &devp->vco_cache[i];
+            break;
+        }
+    }
+    if (entry == NULL) {
+        entry = &devp->vco_cache[devp->vco_next];
+        devp->vco_next = (devp->vco_next + 1) % AX5043_VCO_CACHE_SIZE;
+    }
+    entry->profile = devp->profile;
+    entry->freq = freq;
+    entry->temp = devp->vco_temp;
+    entry->vcor = vcor;
+}
+
+/**
+ * @brief   Enters a synthesizer power mode and checks for PLL lock.
+ * @details If the channel was tuned from a cached VCO range and does not
+ *          lock, the entry is dropped and the channel is ranged again.
+ *
+ * @param[in]   pwrmode     AX5043_PWRMODE_TX_SYNTH or AX5043_PWRMODE_RX_SYNTH
+ * @param[in]   chan_b      Channel B if true, channel A otherwise
+ *
+ * @return                  True if the PLL locked.
+ * @notapi
+ */
+static bool ax5043SynthLock(AX5043Driver *devp, uint8_t pwrmode, bool chan_b) {
+    /* TODO: Can we base this on an interrupt instead of a delay? */
+    ax5043SetPWRMode(devp, pwrmode);
+    chThdSleepMicroseconds(1);
+    if (ax5043GetStatus(devp) & AX5043_STATUS_PLL_LOCK) {
+        return true;
+    }
+
+    uint32_t freq = ax5043ReadU32(devp, (chan_b ? AX5043_REG_FREQB : AX5043_REG_FREQA));
+    ax5043_vco_t *entry = ax5043VCOLookup(devp, freq);
+    if (entry == NULL) {
+        return false;
+    }
+    entry->vcor = 0;
+    devp->vco_relocks++;
+
+    ax5043SetPWRMode(devp, AX5043_PWRMODE_POWERDOWN);
+    ax5043SetFreq(devp, 0, (chan_b ? devp->vcorb : devp->vcora), chan_b);
+    if (devp->error != AX5043_ERR_NOERROR) {
+        return false;
+    }
+    ax5043SetPWRMode(devp, pwrmode);
+    chThdSleepMicroseconds(1);
+    return (ax5043GetStatus(devp) & AX5043_STATUS_PLL_LOCK) != 0;
+}
+
 /*===========================================================================*/
 /* Interface implementation.                                                 */
 /*===========================================================================*/
@@ -406,6 +644,14 @@ void ax5043ObjectInit(AX5043Driver *devp) {
     chEvtObjectInit(&devp->irq_event);
 
     devp->rx_worker = NULL;
+    memset(&devp->rx_stats, 0, sizeof(devp->rx_stats));
+
+    memset(devp->vco_cache, 0, sizeof(devp->vco_cache));
+    devp->vco_next = 0;
+    devp->vco_temp = AX5043_VCO_TEMP_UNKNOWN;
+    devp->vco_hits = 0;
+    devp->vco_misses = 0;
+    devp->vco_relocks = 0;
 
     devp->preamble = NULL;
     devp->postamble = NULL;
@@ -592,16 +838,14 @@ void ax5043RX(AX5043Driver *devp, bool chan_b, bool wor) {
         ax5043SetRFDIV(devp, freq);
 
         /* Activate synthesizer to lock PLL */
-        ax5043SetPWRMode(devp, AX5043_PWRMODE_RX_SYNTH);
-        chThdSleepMicroseconds(1);
-        if (!(ax5043GetStatus(devp) & AX5043_STATUS_PLL_LOCK)) {
+        if (!ax5043SynthLock(devp, AX5043_PWRMODE_RX_SYNTH, chan_b)) {
             ax5043SetPWRMode(devp, AX5043_PWRMODE_POWERDOWN);
             devp->error = AX5043_ERR_LOCKLOST;
             return;
         }
-        /* Clear FIFO and set threshold */
+        /* Clear FIFO and set threshold for batched reads */
         ax5043WriteU8(devp, AX5043_REG_FIFOSTAT, AX5043_FIFOCMD_CLEAR_FIFODAT);
-        ax5043WriteU16(devp, AX5043_REG_FIFOTHRESH, 0);
+        ax5043WriteU16(devp, AX5043_REG_FIFOTHRESH, AX5043_RX_FIFO_THRESH);
 
         /* Activate RX or WOR */
         if (wor) {
@@ -672,12 +916,10 @@ void ax5043TX(AX5043Driver *devp, const ax5043_profile_t *profile, const void *b
     ax5043SetRFDIV(devp, freq);
 
     /* Activate synthesizer to lock PLL */
-    /* TODO: Can we base this on an interrupt instead of a delay? */
-    ax5043SetPWRMode(devp, AX5043_PWRMODE_TX_SYNTH);
-    chThdSleepMicroseconds(1);
-    if (!(ax5043GetStatus(devp) & AX5043_STATUS_PLL_LOCK)) {
+    if (!ax5043SynthLock(devp, AX5043_PWRMODE_TX_SYNTH, chan_b)) {
         ax5043SetPWRMode(devp, AX5043_PWRMODE_POWERDOWN);
         devp->error = AX5043_ERR_LOCKLOST;
+        chMtxUnlock(&devp->tx_lock);
         return;
     }
     /* Clear FIFO */
@@ -830,12 +1072,10 @@ void ax5043TXRaw(AX5043Driver *devp, const ax5043_profile_t *profile, const void
     ax5043SetRFDIV(devp, freq);
 
     /* Activate synthesizer to lock PLL */
-    /* TODO: Can we base this on an interrupt instead of a delay? */
-    ax5043SetPWRMode(devp, AX5043_PWRMODE_TX_SYNTH);
-    chThdSleepMicroseconds(1);
-    if (!(ax5043GetStatus(devp) & AX5043_STATUS_PLL_LOCK)) {
+    if (!ax5043SynthLock(devp, AX5043_PWRMODE_TX_SYNTH, chan_b)) {
         ax5043SetPWRMode(devp, AX5043_PWRMODE_POWERDOWN);
         devp->error = AX5043_ERR_LOCKLOST;
+        chMtxUnlock(&devp->tx_lock);
         return;
     }
     /* Clear FIFO */
@@ -1005,12 +1245,6 @@ uint8_t ax5043SetFreq(AX5043Driver *devp, uint32_t freq, uint8_t vcor, bool chan
         vcor = 8;
     }
 
-    /* Enter Standby mode */
-    ax5043SetPWRMode(devp, AX5043_PWRMODE_STANDBY);
-
-    /* Wait for XTAL */
-    ax5043WaitIRQ(devp, AX5043_IRQ_XTALREADY, TIME_INFINITE);
-
     /* Set frequencies
      * We first find the GCD of the two frequencies in order to reduce them
      * as much as possible before doing the calculations.
@@ -1029,20 +1263,42 @@ uint8_t ax5043SetFreq(AX5043Driver *devp, uint32_t freq, uint8_t vcor, bool chan
     }
     ax5043WriteU8(devp, AX5043_REG_PLLLOOP, pllloop);
 
-    /* Set the frequency and RFDIV if needed, and initiate ranging */
+    /* Set the frequency and RFDIV if needed */
+    uint32_t freq_val;
     if (freq) {
-        ax5043WriteU32(devp, freq_reg, AX5043_FREQ_TO_REG(freq, devp->config->xtal_freq));
+        freq_val = AX5043_FREQ_TO_REG(freq, devp->config->xtal_freq);
+        ax5043WriteU32(devp, freq_reg, freq_val);
     } else {
-        freq = AX5043_REG_TO_FREQ(ax5043ReadU32(devp, freq_reg), devp->config->xtal_freq);
+        freq_val = ax5043ReadU32(devp, freq_reg);
+        freq = AX5043_REG_TO_FREQ(freq_val, devp->config->xtal_freq);
     }
     ax5043SetRFDIV(devp, freq);
-    ax5043WriteU8(devp, rng_reg, _VAL2FLD(AX5043_PLLRANGING_VCOR, vcor) | AX5043_PLLRANGING_RNGSTART);
-    ax5043WaitIRQ(devp, AX5043_IRQ_PLLRNGDONE, TIME_INFINITE);
-    vcor = ax5043ReadU8(devp, rng_reg);
-    if (vcor & AX5043_PLLRANGING_RNGERR) {
-        devp->error = AX5043_ERR_RANGING;
+
+    /* Enter Standby mode */
+    ax5043SetPWRMode(devp, AX5043_PWRMODE_STANDBY);
+
+    /* Wait for XTAL, the synthesizer cannot lock without it either */
+    ax5043WaitIRQ(devp, AX5043_IRQ_XTALREADY, TIME_INFINITE);
+
+    ax5043_vco_t *entry = ax5043VCOLookup(devp, freq_val);
+    if (entry != NULL) {
+        /* Range known for this profile and frequency, set it and skip ranging */
+        vcor = entry->vcor;
+        ax5043WriteU8(devp, rng_reg, _VAL2FLD(AX5043_PLLRANGING_VCOR, vcor));
+        devp->vco_hits++;
+    } else {
+        /* Initiate ranging */
+        ax5043WriteU8(devp, rng_reg, _VAL2FLD(AX5043_PLLRANGING_VCOR, vcor) | AX5043_PLLRANGING_RNGSTART);
+        ax5043WaitIRQ(devp, AX5043_IRQ_PLLRNGDONE, TIME_INFINITE);
+        vcor = ax5043ReadU8(devp, rng_reg);
+        devp->vco_misses++;
+        if (vcor & AX5043_PLLRANGING_RNGERR) {
+            devp->error = AX5043_ERR_RANGING;
+        } else {
+            ax5043VCOStore(devp, freq_val, _FLD2VAL(AX5043_PLLRANGING_VCOR, vcor));
+        }
+        vcor = _FLD2VAL(AX5043_PLLRANGING_VCOR, vcor);
     }
-    vcor = _FLD2VAL(AX5043_PLLRANGING_VCOR, vcor);
     if (chan_b) {
         devp->vcorb = vcor;
     } else {
@@ -1080,6 +1336,36 @@ uint32_t ax5043GetFreq(AX5043Driver *devp) {
     return AX5043_REG_TO_FREQ(ax5043ReadU32(devp, freq_reg), devp->config->xtal_freq);
 }
 
+/**
+ * @brief   Updates the temperature used to age cached VCO ranges.
+ * @details Cached ranges recorded more than @p AX5043_VCO_TEMP_DELTA degrees
+ *          away are ranged again on the next tune.
+ *
+ * @param[in]  devp         Pointer to the @p AX5043Driver object.
+ * @param[in]  temp         Temperature in degrees C, or @p AX5043_VCO_TEMP_UNKNOWN.
+ *
+ * @api
+ */
+void ax5043SetVCOTemp(AX5043Driver *devp, int16_t temp) {
+    osalDbgCheck(devp != NULL);
+
+    devp->vco_temp = temp;
+}
+
+/**
+ * @brief   Drops all cached VCO ranges.
+ *
+ * @param[in]  devp         Pointer to the @p AX5043Driver object.
+ *
+ * @api
+ */
+void ax5043ClearVCOCache(AX5043Driver *devp) {
+    osalDbgCheck(devp != NULL);
+
+    memset(devp->vco_cache, 0, sizeof(devp->vco_cache));
+    devp->vco_next = 0;
+}
+
 /**
  * @brief   Sets Preamble pointer and length for AX5043 transmission  operations.
  *
@@ -0,0 +1,186 @@
+#include <string.h>
+#include "fec.h"
+
+/* GF(2^8) field generator x^8 + x^7 + x^2 + x + 1 */
+#define RS_GFPOLY                   0x187U
+/* Generator roots are alpha^(11 * (112 + i)), i = 0..31 */
+#define RS_FCR                      112U
+#define RS_PRIM                     11U
+#define RS_A0                       FEC_RS_N
+#define RS_WORDS                    (FEC_RS_PARITY / 4U)
+
+/* CCSDS k=7 generators, newest bit in the LSB. G2 is inverted on output. */
+#define CONV_POLYA                  0x4FU
+#define CONV_POLYB                  0x6DU
+
+uint8_t fec_alpha_to[FEC_RS_N + 1];
+uint8_t fec_index_of[FEC_RS_N + 1];
+uint8_t fec_taltab[256];
+uint8_t fec_tal1tab[256];
+
+/*
+ * rs_row[f] is the generator scaled by feedback symbol f, packed four
+ * parity bytes per word MSB first. Encoding a byte is then one lookup, a
+ * one byte shift of the parity register and eight word XORs.
+ */
+static uint32_t rs_row[256][RS_WORDS];
+
+/* Output symbols for four input bits from each 6-bit encoder state */
+static uint8_t conv_table[64][16];
+
+static unsigned modnn(unsigned x)
+{
+    while (x >= FEC_RS_N) {
+        x -= FEC_RS_N;
+        x = (x >> 8) + (x & FEC_RS_N);
+    }
+    return x;
+}
+
+static uint8_t gf_mul(uint8_t a, uint8_t b)
+{
+    if (a == 0 || b == 0)
+        return 0;
+    return fec_alpha_to[modnn(fec_index_of[a] + fec_index_of[b])];
+}
+
+static void rs_init(void)
+{
+    uint8_t gen[FEC_RS_PARITY + 1] = {0};
+    unsigned sr = 1;
+
+    for (unsigned i = 0; i < FEC_RS_N; i++) {
+        fec_index_of[sr] = i;
+        fec_alpha_to[i] = sr;
+        sr <<= 1;
+        if (sr & 0x100U)
+            sr ^= RS_GFPOLY;
+    }
+    fec_index_of[0] = RS_A0;
+    fec_alpha_to[RS_A0] = 0;
+
+    /* Generator polynomial, coefficient form, gen[k] is the x^k term */
+    gen[0] = 1;
+    for (unsigned i = 0, root = RS_FCR * RS_PRIM; i < FEC_RS_PARITY; i++, root += RS_PRIM) {
+        gen[i + 1] = 1;
+        for (unsigned j = i; j > 0; j--) {
+            if (gen[j] != 0)
+                gen[j] = gen[j - 1] ^ fec_alpha_to[modnn(fec_index_of[gen[j]] + root)];
+            else
+                gen[j] = gen[j - 1];
+        }
+        gen[0] = fec_alpha_to[modnn(fec_index_of[gen[0]] + root)];
+    }
+
+    for (unsigned f = 0; f < 256; f++) {
+        for (unsigned i = 0; i < FEC_RS_PARITY; i++) {
+            uint8_t p = gf_mul(f, gen[FEC_RS_PARITY - 1 - i]);
+            if ((i & 3U) == 0)
+                rs_row[f][i / 4] = 0;
+            rs_row[f][i / 4] |= (uint32_t)p << (24 - 8 * (i & 3U));
+        }
+    }
+
+    /* Conventional <-> dual basis (CCSDS 131.0-B annex F) */
+    static const uint8_t tal[] = {0x8D, 0xEF, 0xEC, 0x86, 0xFA, 0x99, 0xAF, 0x7B};
+    for (unsigned i = 0; i < 256; i++) {
+        uint8_t t = 0;
+        for (unsigned k = 0; k < 8; k++) {
+            if (i & (1U << k))
+                t ^= tal[7 - k];
+        }
+        fec_taltab[i] = t;
+        fec_tal1tab[t] = i;
+    }
+}
+
+static void conv_init(void)
+{
+    for (unsigned s = 0; s < 64; s++) {
+        for (unsigned n = 0; n < 16; n++) {
+            unsigned sr = s;
+            uint8_t out = 0;
+            for (int b = 3; b >= 0; b--) {
+                sr = (sr << 1) | ((n >> b) & 1U);
+                out = (out << 2) | (__builtin_parity(sr & CONV_POLYA) << 1) |
+                      (__builtin_parity(sr & CONV_POLYB) ^ 1U);
+            }
+            conv_table[s][n] = out;
+        }
+    }
+}
+
+void fec_init(void)
+{
+    rs_init();
+    conv_init();
+}
+
+/*
+ * Reed-Solomon encode len bytes with interleave depth I (1..8). Byte n
+ * belongs to codeword n % I and the codewords are shortened to the padded
+ * length / I. The data is zero padded to a multiple of I and followed by the
+ * interleaved check symbols. in and out may be the same buffer. Returns the
+ * encoded length, or 0 if it does not fit.
+ */
+size_t fec_rs_encode(const uint8_t *in, size_t len, uint8_t depth, uint8_t *out, size_t out_len)
+{
+    uint32_t parity[FEC_RS_MAX_DEPTH][RS_WORDS] = {{0}};
+    size_t padded, total;
+
+    if (depth == 0 || depth > FEC_RS_MAX_DEPTH)
+        return 0;
+    padded = ((len + depth - 1) / depth) * depth;
+    total = FEC_RS_LEN(len, depth);
+    if (padded / depth > FEC_RS_K || total > out_len)
+        return 0;
+
+    if (out != in)
+        memcpy(out, in, len);
+    memset(&out[len], 0, padded - len);
+
+    for (size_t n = 0, i = 0; n < padded; n++) {
+        uint32_t *p = parity[i];
+        uint8_t f = fec_tal1tab[out[n]] ^ (p[0] >> 24);
+        const uint32_t *row = rs_row[f];
+
+        for (unsigned w = 0; w < RS_WORDS - 1; w++) {
+            p[w] = ((p[w] << 8) | (p[w + 1] >> 24)) ^ row[w];
+        }
+        p[RS_WORDS - 1] = (p[RS_WORDS - 1] << 8) ^ row[RS_WORDS - 1];
+
+        if (++i == depth)
+            i = 0;
+    }
+
+    uint8_t *pos = &out[padded];
+    for (unsigned j = 0; j < FEC_RS_PARITY; j++) {
+        for (unsigned i = 0; i < depth; i++) {
+            *pos++ = fec_taltab[(parity[i][j / 4] >> (24 - 8 * (j & 3U))) & 0xFFU];
+        }
+    }
+    return total;
+}
+
+/*
+ * Rate 1/2 k=7 convolutional encode, MSB first, G1 symbol before the
+ * inverted G2 symbol. A zero byte is appended to flush the encoder.
+ * Returns the encoded length, or 0 if it does not fit.
+ */
+size_t fec_conv_encode(const uint8_t *in, size_t len, uint8_t *out, size_t out_len)
+{
+    unsigned state = 0;
+    uint8_t b;
+
+    if (FEC_CONV_LEN(len) > out_len)
+        return 0;
+
+    for (size_t n = 0; n <= len; n++) {
+        b = (n < len ? in[n] : 0);
+        *out++ = conv_table[state][b >> 4];
+        state = ((state << 4) | (b >> 4)) & 0x3FU;
+        *out++ = conv_table[state][b & 0x0FU];
+        state = ((state << 4) | (b & 0x0FU)) & 0x3FU;
+    }
+    return FEC_CONV_LEN(len);
+}
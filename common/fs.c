@@ -223,6 +223,45 @@ int mmc_sync(const struct lfs_config *cfg)
     return LFS_ERR_OK;
 }
 
+/**
+ * @brief   Choose cache and lookahead sizes for the attached device.
+ * @details The cache is the largest multiple of the read size, up to the
+ *          configured or compile time limit, that divides the block size.
+ *          The lookahead covers the whole device if the buffer allows,
+ *          which keeps allocator rescans to a minimum.
+ *
+ * @param[in]  fsp      Pointer to the @p FSDriver object
+ * @notapi
+ */
+static void fs_geometry(FSDriver *fsp)
+{
+    struct lfs_config *cfg = &fsp->lfscfg;
+    lfs_size_t cache, lookahead;
+
+    cache = fsp->config->cache_size ? fsp->config->cache_size : FS_CACHE_SIZE;
+    if (cache > FS_CACHE_SIZE) {
+        cache = FS_CACHE_SIZE;
+    }
+    if (cache > cfg->block_size) {
+        cache = cfg->block_size;
+    }
+    cache -= cache % cfg->read_size;
+    while (cache > cfg->read_size && (cfg->block_size % cache) != 0) {
+        cache -= cfg->read_size;
+    }
+    cfg->cache_size = cache;
+
+    lookahead = fsp->config->lookahead_size;
+    if (lookahead == 0) {
+        lookahead = (cfg->block_count + 7) / 8;
+    }
+    if (lookahead > FS_LOOKAHEAD_SIZE) {
+        lookahead = FS_LOOKAHEAD_SIZE;
+    }
+    lookahead -= lookahead % 8;
+    cfg->lookahead_size = (lookahead ? lookahead : 8);
+}
+
 /**
  * @brief   Enable eMMC and connect.
  *
@@ -263,6 +302,7 @@ int mmc_enable(FSDriver *fsp)
         blkGetInfo(sdcp, &bdinfo);
         fsp->lfscfg.block_size = bdinfo.blk_size;
         fsp->lfscfg.block_count = bdinfo.blk_num;
+        fs_geometry(fsp);
 
         /* Fetch info about eMMC device */
         _mmcsd_unpack_mmc_cid((MMCSDBlockDevice*)sdcp, &fsp->mmc_cid);
@@ -336,7 +376,41 @@ static inline int fs_access_end(FSDriver *fsp)
     return LFS_ERR_OK;
 }
 
-/* TODO: Implement static buffers for files */
+/**
+ * @brief   Adjust the used block count for a file changing size.
+ * @note    Counts data blocks only, fs_reconcile() corrects for metadata
+ *          and CTZ list overhead.
+ *
+ * @param[in]  fsp      Pointer to the @p FSDriver object
+ * @param[in]  old_size File size before the operation
+ * @param[in]  new_size File size after the operation
+ * @notapi
+ */
+static void fs_usage_adjust(FSDriver *fsp, lfs_soff_t old_size, lfs_soff_t new_size)
+{
+    lfs_size_t bs = fsp->lfscfg.block_size;
+
+    if (old_size < 0 || new_size < 0 || bs == 0) {
+        return;
+    }
+
+    lfs_ssize_t delta = (lfs_ssize_t)((new_size + bs - 1) / bs) - (lfs_ssize_t)((old_size + bs - 1) / bs);
+    if (delta == 0) {
+        return;
+    }
+
+    chSysLock();
+    if (fsp->used_blocks >= 0) {
+        fsp->used_blocks += delta;
+        if (fsp->used_blocks < 0) {
+            fsp->used_blocks = 0;
+        } else if ((lfs_size_t)fsp->used_blocks > fsp->lfscfg.block_count) {
+            fsp->used_blocks = fsp->lfscfg.block_count;
+        }
+    }
+    chSysUnlock();
+}
+
 void *fs_alloc_file(FSDriver *fsp)
 {
     /* Sanity checks */
@@ -400,6 +474,7 @@ void fs_init(FSDriver *fsp)
 {
     fsp->config                 = NULL;
     fsp->err                    = LFS_ERR_OK;
+    fsp->used_blocks            = -1;
 
     /* Initialize lfscfg */
     fsp->lfscfg.context         = NULL;
@@ -424,6 +499,11 @@ void fs_init(FSDriver *fsp)
     fsp->lfscfg.attr_max        = 0;            /* Default to LFS_ATTR_MAX    */
     fsp->lfscfg.metadata_max    = 0;            /* Default to block_size      */
 
+    memset(fsp->file_cfg, 0, sizeof(fsp->file_cfg));
+    for (size_t i = 0; i < FS_MAX_HANDLERS; i++) {
+        fsp->file_cfg[i].buffer = fsp->file_buf[i];
+    }
+
     chMtxObjectInit(&fsp->mutex);
     chGuardedPoolObjectInitAligned(&fsp->file_pool, sizeof(lfs_file_t), PORT_NATURAL_ALIGN);
     chGuardedPoolLoadArray(&fsp->file_pool, fsp->file, FS_MAX_HANDLERS);
@@ -556,6 +636,9 @@ int fs_mount(FSDriver *fsp, bool format)
             }
         }
         fsp->state = FS_MOUNTED;
+        if (fsp->err == LFS_ERR_OK) {
+            fs_reconcile(fsp, true);
+        }
     }
 
     return fsp->err;
@@ -582,6 +665,7 @@ int fs_unmount(FSDriver *fsp)
     if (fsp->state == FS_MOUNTED) {
         fsp->err = lfs_unmount(&fsp->lfs);
         fsp->state = FS_ONLINE;
+        fsp->used_blocks = -1;
         if (fsp->err != LFS_ERR_OK) {
             return fsp->err;
         }
@@ -615,11 +699,20 @@ int fs_remove(FSDriver *fsp, const char *path)
         return fsp->err;
     }
 
+    struct lfs_info info;
+    if (lfs_stat(&fsp->lfs, path, &info) != LFS_ERR_OK) {
+        info.type = LFS_TYPE_DIR;
+    }
+
     fsp->err = lfs_remove(&fsp->lfs, path);
     if (fsp->err != LFS_ERR_OK) {
         return fsp->err;
     }
 
+    if (info.type == LFS_TYPE_REG) {
+        fs_usage_adjust(fsp, info.size, 0);
+    }
+
     fsp->err = fs_access_end(fsp);
     return fsp->err;
 }
@@ -823,15 +916,73 @@ lfs_size_t fs_size(FSDriver *fsp)
 
 /**
  * @brief   Return filesystem utilization as percentage.
+ * @note    Uses the incrementally maintained block count, the filesystem
+ *          is only traversed if no count is available yet.
  *
  * @param[in]  fsp      Pointer to the @p FSDriver object
  *
- * @return              Filesystem utilization percent or negative error code on failure
+ * @return              Filesystem utilization percent or 0 on failure
  * @api
  */
 uint8_t fs_usage(FSDriver *fsp)
 {
-    return fs_size(fsp) / fsp->lfscfg.block_count;
+    /* Sanity checks */
+    osalDbgCheck(fsp != NULL);
+
+    if (fsp->used_blocks < 0 && fs_reconcile(fsp, true) < 0) {
+        return 0;
+    }
+    if (fsp->lfscfg.block_count == 0) {
+        return 0;
+    }
+
+    return ((uint64_t)fsp->used_blocks * 100U) / fsp->lfscfg.block_count;
+}
+
+/**
+ * @brief   Recount used blocks by traversing the filesystem.
+ * @details Corrects drift in the incrementally maintained count. Unless
+ *          forced this does nothing if the last traversal was less than
+ *          @p FS_RECONCILE_INTERVAL ago or the filesystem is not mounted.
+ *
+ * @param[in]  fsp      Pointer to the @p FSDriver object
+ * @param[in]  force    Traverse regardless of the last traversal time
+ *
+ * @return              Used blocks or negative error code on failure
+ * @api
+ */
+int fs_reconcile(FSDriver *fsp, bool force)
+{
+    /* Sanity checks */
+    osalDbgCheck(fsp != NULL);
+
+    if (fsp->state != FS_MOUNTED) {
+        if (!force) {
+            return fsp->used_blocks;
+        }
+        /* Mounting performs the traversal */
+        fsp->err = fs_access_start(fsp);
+        if (fsp->err != LFS_ERR_OK) {
+            return fsp->err;
+        }
+        return fsp->used_blocks;
+    }
+    if (!force && fsp->used_blocks >= 0 &&
+            chVTTimeElapsedSinceX(fsp->reconciled) < FS_RECONCILE_INTERVAL) {
+        return fsp->used_blocks;
+    }
+
+    lfs_ssize_t used = fs_size(fsp);
+    if (used < 0) {
+        return used;
+    }
+
+    chSysLock();
+    fsp->used_blocks = used;
+    fsp->reconciled = chVTGetSystemTimeX();
+    chSysUnlock();
+
+    return used;
 }
 
 /**
@@ -861,7 +1012,9 @@ lfs_file_t *file_open(FSDriver *fsp, const char *path, int flags)
     file = fs_alloc_file(fsp);
 
     if (file != NULL) {
-        fsp->err = lfs_file_open(&fsp->lfs, file, path, flags);
+        /* Use the static cache buffer paired with this handle */
+        struct lfs_file_config *cfg = &fsp->file_cfg[file - fsp->file];
+        fsp->err = lfs_file_opencfg(&fsp->lfs, file, path, flags, cfg);
         if (fsp->err != LFS_ERR_OK) {
             fs_free_file(fsp, file);
             file = NULL;
@@ -969,11 +1122,15 @@ lfs_ssize_t file_write(FSDriver *fsp, lfs_file_t *file, const void *buffer, lfs_
             "file_read(), invalid state");
 
     lfs_ssize_t ret_size;
+    lfs_soff_t old_size;
     fsp->err = LFS_ERR_OK;
 
+    old_size = lfs_file_size(&fsp->lfs, file);
     ret_size = lfs_file_write(&fsp->lfs, file, buffer, size);
     if (ret_size < 0) {
         fsp->err = ret_size;
+    } else {
+        fs_usage_adjust(fsp, old_size, lfs_file_size(&fsp->lfs, file));
     }
 
     return ret_size;
@@ -1025,7 +1182,12 @@ int file_truncate(FSDriver *fsp, lfs_file_t *file, lfs_soff_t size)
     osalDbgAssert(fsp->state == FS_MOUNTED,
             "file_truncate(), invalid state");
 
+    lfs_soff_t old_size = lfs_file_size(&fsp->lfs, file);
+
     fsp->err = lfs_file_truncate(&fsp->lfs, file, size);
+    if (fsp->err == LFS_ERR_OK) {
+        fs_usage_adjust(fsp, old_size, size);
+    }
 
     return fsp->err;
 }
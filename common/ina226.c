@@ -249,6 +249,42 @@ void ina226SetAlert(INA226Driver *devp, uint16_t alert_me, uint16_t alert_lim) {
 #endif /* INA226_USE_I2C */
 }
 
+/**
+ * @brief   Restarts INA226 conversion.
+ * @details Rewriting the configuration register aborts any conversion in
+ *          progress, so the next conversion ready flag only covers samples
+ *          taken after this call.
+ *
+ * @param[in] devp       pointer to the @p INA226Driver object
+ * @return               the operation status.
+ *
+ * @api
+ */
+msg_t ina226StartConversion(INA226Driver *devp) {
+    i2cbuf_t buf;
+
+    osalDbgCheck(devp != NULL);
+    osalDbgAssert(devp->state == INA226_READY,
+            "ina226StartConversion(), invalid state");
+
+#if INA226_USE_I2C
+#if INA226_SHARED_I2C
+    i2cAcquireBus(devp->config->i2cp);
+    i2cStart(devp->config->i2cp, devp->config->i2ccfg);
+#endif /* INA226_SHARED_I2C */
+
+    buf.reg = INA226_AD_CONFIG;
+    buf.value = __REVSH(devp->config->cfg);
+    const msg_t ret = ina226I2CWriteRegister(devp->config->i2cp, devp->config->saddr, buf.buf, sizeof(buf));
+
+#if INA226_SHARED_I2C
+    i2cReleaseBus(devp->config->i2cp);
+#endif /* INA226_SHARED_I2C */
+#endif /* INA226_USE_I2C */
+
+    return(ret);
+}
+
 /**
  * @brief   Reads INA226 Register as raw value.
  *
@@ -345,7 +381,8 @@ msg_t ina226ReadCurrent(INA226Driver *devp, uint32_t *dest_current_uA) {
     const msg_t ret = ina226ReadRaw(devp, INA226_AD_CURRENT, &reg_value);
 
     if( ret == MSG_OK ) {
-    	*dest_current_uA = (reg_value * devp->config->curr_lsb * 1000) / 2048;
+    	/* The Current register counts in curr_lsb once CAL is set */
+    	*dest_current_uA = (uint32_t) reg_value * devp->config->curr_lsb;
     }
 
     return(ret);
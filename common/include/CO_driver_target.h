@@ -290,9 +290,12 @@ extern mutex_t emcy_mutex;
 #define CO_UNLOCK_EMCY(CAN_MODULE)        chMtxUnlock(&emcy_mutex)  /* Unlock critical section in CO_errorReport() or CO_errorReset() */
 
 /* (un)lock critical section when accessing Object Dictionary */
+/* od_seq is odd while a writer holds od_mutex, readers that only need a
+ * consistent copy can use it as a sequence lock instead of taking the mutex */
 extern mutex_t od_mutex;
-#define CO_LOCK_OD(CAN_MODULE)            chMtxLock(&od_mutex)      /* Lock critical section when accessing Object Dictionary */
-#define CO_UNLOCK_OD(CAN_MODULE)          chMtxUnlock(&od_mutex)    /* Unock critical section when accessing Object Dictionary */
+extern volatile uint32_t od_seq;
+#define CO_LOCK_OD(CAN_MODULE)            do {chMtxLock(&od_mutex); od_seq++; __DMB();} while (0)   /* Lock critical section when accessing Object Dictionary */
+#define CO_UNLOCK_OD(CAN_MODULE)          do {__DMB(); od_seq++; chMtxUnlock(&od_mutex);} while (0) /* Unock critical section when accessing Object Dictionary */
 
 /* Synchronization between CAN receive and message processing threads. */
 #define CO_MemoryBarrier()
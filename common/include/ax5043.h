@@ -2483,6 +2483,10 @@
 #define AX5043_CHUNK_DATARX_ABORT_Pos       (6U)
 #define AX5043_CHUNK_DATARX_ABORT_Msk       (0x1U << AX5043_CHUNK_DATARX_ABORT_Pos)
 #define AX5043_CHUNK_DATARX_ABORT           AX5043_CHUNK_DATARX_ABORT_Msk
+#define AX5043_CHUNK_DATARX_ERR             (AX5043_CHUNK_DATARX_CRCFAIL  |  \
+                                             AX5043_CHUNK_DATARX_ADDRFAIL |  \
+                                             AX5043_CHUNK_DATARX_SIZEFAIL |  \
+                                             AX5043_CHUNK_DATARX_ABORT)
 /** @} */
 
 /**
@@ -2518,6 +2522,38 @@
 #define AX5043_SHARED_SPI                   FALSE
 #endif
 
+/**
+ * @brief   RX FIFO fill level that wakes the RX worker mid packet.
+ * @details Lets several chunks be read out in one SPI burst.
+ */
+#if !defined(AX5043_RX_FIFO_THRESH) || defined(__DOXYGEN__)
+#define AX5043_RX_FIFO_THRESH               (128U)
+#endif
+
+/**
+ * @brief   RX FIFO poll interval mid packet.
+ * @details Drains the tail of a packet that stays below the threshold.
+ */
+#if !defined(AX5043_RX_POLL_TIME) || defined(__DOXYGEN__)
+#define AX5043_RX_POLL_TIME                 TIME_MS2I(5)
+#endif
+
+/**
+ * @brief   Number of cached VCO ranging results.
+ * @details Each entry holds the VCOR found for a profile and frequency so
+ *          later tunes can skip autoranging.
+ */
+#if !defined(AX5043_VCO_CACHE_SIZE) || defined(__DOXYGEN__)
+#define AX5043_VCO_CACHE_SIZE               (8U)
+#endif
+
+/**
+ * @brief   Temperature change in degrees C that invalidates a VCO result.
+ */
+#if !defined(AX5043_VCO_TEMP_DELTA) || defined(__DOXYGEN__)
+#define AX5043_VCO_TEMP_DELTA               (10)
+#endif
+
 /**
  * @brief   Maximum frequency for RFDIV = 0 (DIV 1)
  */
@@ -2567,6 +2603,10 @@
 #error "AX5043_SHARED_SPI requires SPI_USE_MUTUAL_EXCLUSION"
 #endif
 
+#if (AX5043_VCO_CACHE_SIZE < 1U)
+#error "AX5043_VCO_CACHE_SIZE must be at least 1"
+#endif
+
 #if (AX5043_FIFO_WRITE_LEN > 256U)
 #error "AX5043_FIFO_WRITE_LEN must be less than or equal to 256"
 #endif
@@ -2600,6 +2640,53 @@ typedef uint16_t ax5043_status_t;
  */
 typedef size_t (*ax5043_tx_cb_t)(void *arg);
 
+/**
+ * @brief   Receive error callback.
+ *
+ * @param   arg     The configured @p phy_arg
+ * @param   flags   DATA RX chunk flags of the dropped frame
+ */
+typedef void (*ax5043_rx_err_cb_t)(const void *arg, uint8_t flags);
+
+/**
+ * @brief   Receive frame callback.
+ * @details Called from the RX worker as each intact frame is queued, with
+ *          the values the chip stored ahead of that frame's data.
+ *
+ * @param   arg         The configured @p phy_arg
+ * @param   rssi        RSSI chunk value of the frame
+ * @param   rf_freq_off RFFREQOFFS chunk value of the frame
+ */
+typedef void (*ax5043_rx_frame_cb_t)(const void *arg, int8_t rssi, uint32_t rf_freq_off);
+
+/**
+ * @brief   Receive statistics.
+ */
+typedef struct {
+    uint32_t                    frames;         /**< Frames delivered.          */
+    uint32_t                    crc_fail;       /**< CRCFAIL frames dropped.    */
+    uint32_t                    addr_fail;      /**< ADDRFAIL frames dropped.   */
+    uint32_t                    size_fail;      /**< SIZEFAIL frames dropped.   */
+    uint32_t                    abort;          /**< ABORT frames dropped.      */
+    uint32_t                    overflow;       /**< Frames exceeding buffers.  */
+    uint32_t                    fifo_reads;     /**< FIFO burst reads.          */
+} ax5043_rx_stats_t;
+
+/**
+ * @brief   Cached VCO ranging result.
+ */
+typedef struct {
+    const void                  *profile;       /**< Profile active at ranging. */
+    uint32_t                    freq;           /**< FREQA/FREQB register value.*/
+    int16_t                     temp;           /**< Temperature at ranging.    */
+    uint8_t                     vcor;           /**< VCO range found.           */
+} ax5043_vco_t;
+
+/**
+ * @brief   Unknown temperature for the VCO cache.
+ */
+#define AX5043_VCO_TEMP_UNKNOWN             INT16_MIN
+
 /**
  * @name    AX5043 chunk structures.
  * @{
@@ -2803,6 +2890,14 @@ typedef struct{
      * @brief Optional frame buffer PHY argument
      */
     const void                  *phy_arg;
+    /**
+     * @brief Optional callback for frames dropped on error flags
+     */
+    ax5043_rx_err_cb_t          rx_err_cb;
+    /**
+     * @brief Optional callback for each frame received intact
+     */
+    ax5043_rx_frame_cb_t        rx_frame_cb;
     /**
      * @brief Profile register values table
      * @note  This is for initial configuration and performance tuning.
@@ -2859,6 +2954,14 @@ struct AX5043Driver {
     uint8_t                     vcora;
     uint8_t                     vcorb;
 
+    /* VCO ranging results by profile and frequency */
+    ax5043_vco_t                vco_cache[AX5043_VCO_CACHE_SIZE];
+    uint8_t                     vco_next;
+    int16_t                     vco_temp;
+    uint32_t                    vco_hits;
+    uint32_t                    vco_misses;
+    uint32_t                    vco_relocks;
+
     /* RX information */
     uint32_t                    timer;
     uint32_t                    datarate;
@@ -2868,6 +2971,7 @@ struct AX5043Driver {
     int8_t                      ant0rssi;
     int8_t                      ant1rssi;
     int8_t                      bgndnoise;
+    ax5043_rx_stats_t           rx_stats;
 };
 /** @} */
 
@@ -2898,6 +3002,8 @@ void ax5043SetProfile(AX5043Driver *devp, const ax5043_profile_t *profile);
 const ax5043_profile_t *ax5043GetProfile(AX5043Driver *devp);
 uint8_t ax5043SetFreq(AX5043Driver *devp, uint32_t freq, uint8_t vcor, bool chan_b);
 uint32_t ax5043GetFreq(AX5043Driver *devp);
+void ax5043SetVCOTemp(AX5043Driver *devp, int16_t temp);
+void ax5043ClearVCOCache(AX5043Driver *devp);
 void ax5043SetPreamble(AX5043Driver *devp, const void *preamble, size_t len);
 const void *ax5043GetPreamble(AX5043Driver *devp);
 void ax5043SetPostamble(AX5043Driver *devp, const void *postamble, size_t len);
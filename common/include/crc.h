@@ -8,6 +8,20 @@
 #define USE_CRC_HW                  FALSE
 #endif
 
+/* Bytes folded in per table round by crc32_sw, valid values are 1, 4 and 8.
+ * Each slice adds 1KiB of const table, so small parts keep the byte table. */
+#if !defined(CRC32_SW_SLICES)
+#if defined(STM32F0XX)
+#define CRC32_SW_SLICES             1
+#else
+#define CRC32_SW_SLICES             8
+#endif
+#endif
+
+#if (CRC32_SW_SLICES != 1) && (CRC32_SW_SLICES != 4) && (CRC32_SW_SLICES != 8)
+#error "CRC32_SW_SLICES must be 1, 4 or 8"
+#endif
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -0,0 +1,37 @@
+#ifndef _FEC_H_
+#define _FEC_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* CCSDS 131.0-B Reed-Solomon (255,223), E=16, dual basis symbols */
+#define FEC_RS_N                    255U
+#define FEC_RS_K                    223U
+#define FEC_RS_PARITY               (FEC_RS_N - FEC_RS_K)
+#define FEC_RS_MAX_DEPTH            8U
+
+/* Encoded length of len bytes at interleave depth I (data padded to a multiple of I) */
+#define FEC_RS_LEN(len, depth)      ((((len) + (depth) - 1) / (depth)) * (depth) + FEC_RS_PARITY * (depth))
+
+/* Rate 1/2 k=7 convolutional code, terminated with one zero byte */
+#define FEC_CONV_LEN(len)           (2U * ((len) + 1U))
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* GF(2^8) tables shared with decoders, valid after fec_init() */
+extern uint8_t fec_alpha_to[FEC_RS_N + 1];
+extern uint8_t fec_index_of[FEC_RS_N + 1];
+extern uint8_t fec_taltab[256];
+extern uint8_t fec_tal1tab[256];
+
+void fec_init(void);
+size_t fec_rs_encode(const uint8_t *in, size_t len, uint8_t depth, uint8_t *out, size_t out_len);
+size_t fec_conv_encode(const uint8_t *in, size_t len, uint8_t *out, size_t out_len);
+
+#ifdef __cplusplus
+}
+#endif /*__cplusplus*/
+#endif /*_FEC_H_*/
@@ -26,6 +26,7 @@
  */
 /**
  * @brief   Filesystem Cache Sizes
+ * @note    Upper bound, the size used is chosen at mount time.
  */
 #if !defined(FS_CACHE_SIZE) || defined(__DOXYGEN__)
 #define FS_CACHE_SIZE                       (512U)
@@ -33,9 +34,11 @@
 
 /**
  * @brief   Filesystem Lookahead buffer size
+ * @note    Upper bound, the size used is chosen at mount time. Each byte
+ *          tracks 8 blocks per allocator scan.
  */
 #if !defined(FS_LOOKAHEAD_SIZE) || defined(__DOXYGEN__)
-#define FS_LOOKAHEAD_SIZE                   (16U)
+#define FS_LOOKAHEAD_SIZE                   (256U)
 #endif
 
 /**
@@ -45,6 +48,17 @@
 #define FS_MAX_HANDLERS                     (4U)
 #endif
 
+#if (FS_LOOKAHEAD_SIZE % 8) != 0
+#error "FS_LOOKAHEAD_SIZE must be a multiple of 8"
+#endif
+
+/**
+ * @brief   Minimum interval between full usage traversals by fs_reconcile()
+ */
+#if !defined(FS_RECONCILE_INTERVAL) || defined(__DOXYGEN__)
+#define FS_RECONCILE_INTERVAL               TIME_S2I(600)
+#endif
+
 /** @} */
 
 /*============================================================================*/
@@ -91,6 +105,14 @@ typedef struct {
      * @brief GPIO Line for enabling eMMC
      */
     ioline_t                    mmc_pwr;
+    /**
+     * @brief Cache size, 0 to derive from the device block size
+     */
+    lfs_size_t                  cache_size;
+    /**
+     * @brief Lookahead size, 0 to derive from the device block count
+     */
+    lfs_size_t                  lookahead_size;
 } FSConfig;
 
 /**
@@ -119,13 +141,19 @@ struct FSDriver {
     /* Guarded dir pool */
     guarded_memory_pool_t       dir_pool;
     lfs_file_t                  dir[FS_MAX_HANDLERS];
-    /* TODO: Implement static file buffers */
+    /* Per handle file configuration and cache buffer */
+    struct lfs_file_config      file_cfg[FS_MAX_HANDLERS];
+    uint8_t                     file_buf[FS_MAX_HANDLERS][FS_CACHE_SIZE];
     /* Read buffer */
     uint8_t                     read_buf[FS_CACHE_SIZE];
     /* Program buffer */
     uint8_t                     prog_buf[FS_CACHE_SIZE];
     /* Lookahead buffer */
     uint8_t                     lookahead_buf[FS_LOOKAHEAD_SIZE];
+    /* Blocks in use, adjusted on write/truncate/remove between traversals */
+    lfs_ssize_t                 used_blocks;
+    /* System time of the last full traversal */
+    systime_t                   reconciled;
 };
 
 /** @} */
@@ -162,6 +190,7 @@ int fs_setattr(FSDriver *fsp, const char *path, uint8_t type, const void *buffer
 int fs_removeattr(FSDriver *fsp, const char *path, uint8_t type);
 lfs_size_t fs_size(FSDriver *fsp);
 uint8_t fs_usage(FSDriver *fsp);
+int fs_reconcile(FSDriver *fsp, bool force);
 
 /* File operations */
 lfs_file_t *file_open(FSDriver *fsp, const char *path, int flags);
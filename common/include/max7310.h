@@ -242,7 +242,11 @@ struct MAX7310VMT {
     /* Driver state.*/                                                      \
     max7310_state_t           state;                                        \
     /* Current configuration data.*/                                        \
-    const MAX7310Config       *config;
+    const MAX7310Config       *config;                                      \
+    /* Shadow of the output register.*/                                     \
+    uint8_t                   odr;                                          \
+    /* Shadow of the IO mode register.*/                                    \
+    uint8_t                   iomode;
 
 /**
  * @brief MAX710 GPIO Expander class.
@@ -259,6 +263,20 @@ struct MAX7310Driver {
 /* Driver macros.                                                            */
 /*===========================================================================*/
 
+/**
+ * @brief   Last value written to the output register.
+ *
+ * @param[in] devp       pointer to the @p MAX7310Driver object
+ */
+#define max7310GetODR(devp)                 ((devp)->odr)
+
+/**
+ * @brief   Last value written to the IO mode register.
+ *
+ * @param[in] devp       pointer to the @p MAX7310Driver object
+ */
+#define max7310GetMode(devp)                ((devp)->iomode)
+
 /*===========================================================================*/
 /* External declarations.                                                    */
 /*===========================================================================*/
@@ -1,6 +1,6 @@
 /**
  * @file    mmc5883ma.h
- * @brief   MMC5883MA Power Monitor.
+ * @brief   MMC5883MA 3-axis Magnetometer.
  *
  * @addtogroup MMC5883MA
  * @ingroup ORESAT
@@ -64,7 +64,7 @@
  * @{
  */
 #define MMC5883MA_PRDCT_ID_1_Pos               (0U)
-#define MMC5883MA_PRDCT_ID_1_Msk               (0x7U << MMC5883MA_PRDCT_ID_1_Pos)
+#define MMC5883MA_PRDCT_ID_1_Msk               (0xFFU << MMC5883MA_PRDCT_ID_1_Pos)
 #define MMC5883MA_PRDCT_ID                     MMC5883MA_PRDCT_ID_1_Msk
 #define MMC5883MA_PRDCT_ID_RST                 (0x0CU << MMC5883MA_PRDCT_ID_1_Pos)
 /** @} */
@@ -96,7 +96,7 @@
 #define MMC5883MA_X_THRSHLD_X_MAG_TH_Pos       (0U)
 #define MMC5883MA_X_THRSHLD_X_MAG_TH_Msk       (0xFFU << MMC5883MA_X_THRSHLD_X_MAG_TH_Pos)
 #define MMC5883MA_X_THRSHLD_X_MAG_TH           MMC5883MA_X_THRSHLD_X_MAG_TH_Msk
-#define MMC5883MA_X_THRSHLD_X_MAG_TH_Pos       (0x00U << MMC5883MA_X_THRSHLD_X_MAG_TH_Pos)
+#define MMC5883MA_X_THRSHLD_X_MAG_TH_RST       (0x00U << MMC5883MA_X_THRSHLD_X_MAG_TH_Pos)
 /** @} */
 
 /**
@@ -104,29 +104,26 @@
  * @{
  */
 #define MMC5883MA_INTRNLCTRL2_CM_FREQ_Pos      (0U)
-#define MMC5883MA_INTRNLCTRL2_CM_FREQ_Msk      (0xFU << MMC5883MA_INTRNL_CTRL_2_CM_FREQ_Pos)
-#define MMC5883MA_INTRNLCTRL2_CM_FREQ          MMC5883MA_INTRNL_CTRL_2_CM_FREQ_Msk
-#define MMC5883MA_INTRNLCTRL2_CM_FREQ_14Hz     (0x1U << MMC5883MA_INTRNL_CTRL_2_CM_FREQ_Pos)
-#define MMC5883MA_INTRNLCTRL2_CM_FREQ_5Hz      (0x1U << MMC5883MA_INTRNL_CTRL_2_CM_FREQ_Pos)
-#define MMC5883MA_INTRNLCTRL2_CM_FREQ_2200mHz  (0x1U << MMC5883MA_INTRNL_CTRL_2_CM_FREQ_Pos)
-#define MMC5883MA_INTRNLCTRL2_CM_FREQ_1Hz      (0x1U << MMC5883MA_INTRNL_CTRL_2_CM_FREQ_Pos)
-#define MMC5883MA_INTRNLCTRL2_CM_FREQ_1/2Hz    (0x1U << MMC5883MA_INTRNL_CTRL_2_CM_FREQ_Pos)
-#define MMC5883MA_INTRNLCTRL2_CM_FREQ_1/4Hz    (0x1U << MMC5883MA_INTRNL_CTRL_2_CM_FREQ_Pos)
-#define MMC5883MA_INTRNLCTRL2_CM_FREQ_1/8Hz    (0x1U << MMC5883MA_INTRNL_CTRL_2_CM_FREQ_Pos)
-#define MMC5883MA_INTRNLCTRL2_CM_FREQ_1/16Hz   (0x1U << MMC5883MA_INTRNL_CTRL_2_CM_FREQ_Pos)
-#define MMC5883MA_INTRNLCTRL2_CM_FREQ_1/32Hz   (0x1U << MMC5883MA_INTRNL_CTRL_2_CM_FREQ_Pos)
-#define MMC5883MA_INTRNLCTRL2_CM_FREQ_1/64Hz   (0x1U << MMC5883MA_INTRNL_CTRL_2_CM_FREQ_Pos)
-#define MMC5883MA_INTRNLCTRL2_CM_FREQ_RST      (0x1U << MMC5883MA_INTRNL_CTRL_2_CM_FREQ_Pos)
-#define MMC5883MA_INTRNLCTRL2_MDT_Pos          (5U)
-#define MMC5883MA_INTRNLCTRL2_MDT_Msk          (0x1U << MMC5883MA_INTRNLCTRL2_MDT_Pos)
-#define MMC5883MA_INTRNLCTRL2_MDT              MMC5883MA_INTRNLCTRL2_MDT_Msk
-#define MMC5883MA_INTRNLCTRL2_MDT_EN           (0x1U << MMC5883MA_INTRNLCTRL2_MDT_Pos)
-#define MMC5883MA_INTRNLCTRL2_MDT_RST          (0x0U << MMC5883MA_INTRNLCTRL2_MDT_Pos)
-#define MMC5883MA_INTRNLCTRL2_MEAS_DONE_Pos    (6U)
-#define MMC5883MA_INTRNLCTRL2_MEAS_DONE_Msk    (0x1U << MMC5883MA_INTRNLCTRL2_MEAS_DONE_Pos)
-#define MMC5883MA_INTRNLCTRL2_MEAS_DONE        MMC5883MA_INTRNLCTRL2_MEAS_DONE_Msk
-#define MMC5883MA_INTRNLCTRL2_MEAS_DONE_EN     (0x1U << MMC5883MA_INTRNLCTRL2_MEAS_DONE_Pos)
-#define MMC5883MA_INTRNLCTRL2_MEAS_DONE_RST    (0x0U << MMC5883MA_INTRNLCTRL2_MEAS_DONE_Pos)
+#define MMC5883MA_INTRNLCTRL2_CM_FREQ_Msk      (0xFU << MMC5883MA_INTRNLCTRL2_CM_FREQ_Pos)
+#define MMC5883MA_INTRNLCTRL2_CM_FREQ          MMC5883MA_INTRNLCTRL2_CM_FREQ_Msk
+#define MMC5883MA_INTRNLCTRL2_CM_FREQ_OFF      (0x0U << MMC5883MA_INTRNLCTRL2_CM_FREQ_Pos)
+#define MMC5883MA_INTRNLCTRL2_CM_FREQ_14Hz     (0x1U << MMC5883MA_INTRNLCTRL2_CM_FREQ_Pos)
+#define MMC5883MA_INTRNLCTRL2_CM_FREQ_5Hz      (0x2U << MMC5883MA_INTRNLCTRL2_CM_FREQ_Pos)
+#define MMC5883MA_INTRNLCTRL2_CM_FREQ_2200mHz  (0x3U << MMC5883MA_INTRNLCTRL2_CM_FREQ_Pos)
+#define MMC5883MA_INTRNLCTRL2_CM_FREQ_1Hz      (0x4U << MMC5883MA_INTRNLCTRL2_CM_FREQ_Pos)
+#define MMC5883MA_INTRNLCTRL2_CM_FREQ_500mHz   (0x5U << MMC5883MA_INTRNLCTRL2_CM_FREQ_Pos)
+#define MMC5883MA_INTRNLCTRL2_CM_FREQ_250mHz   (0x6U << MMC5883MA_INTRNLCTRL2_CM_FREQ_Pos)
+#define MMC5883MA_INTRNLCTRL2_CM_FREQ_125mHz   (0x7U << MMC5883MA_INTRNLCTRL2_CM_FREQ_Pos)
+#define MMC5883MA_INTRNLCTRL2_CM_FREQ_62mHz    (0x8U << MMC5883MA_INTRNLCTRL2_CM_FREQ_Pos)
+#define MMC5883MA_INTRNLCTRL2_CM_FREQ_31mHz    (0x9U << MMC5883MA_INTRNLCTRL2_CM_FREQ_Pos)
+#define MMC5883MA_INTRNLCTRL2_CM_FREQ_16mHz    (0xAU << MMC5883MA_INTRNLCTRL2_CM_FREQ_Pos)
+#define MMC5883MA_INTRNLCTRL2_CM_FREQ_RST      (0x0U << MMC5883MA_INTRNLCTRL2_CM_FREQ_Pos)
+#define MMC5883MA_INTRNLCTRL2_INT_MDT_EN_Pos   (5U)
+#define MMC5883MA_INTRNLCTRL2_INT_MDT_EN_Msk   (0x1U << MMC5883MA_INTRNLCTRL2_INT_MDT_EN_Pos)
+#define MMC5883MA_INTRNLCTRL2_INT_MDT_EN       MMC5883MA_INTRNLCTRL2_INT_MDT_EN_Msk
+#define MMC5883MA_INTRNLCTRL2_INT_MEAS_DONE_EN_Pos (6U)
+#define MMC5883MA_INTRNLCTRL2_INT_MEAS_DONE_EN_Msk (0x1U << MMC5883MA_INTRNLCTRL2_INT_MEAS_DONE_EN_Pos)
+#define MMC5883MA_INTRNLCTRL2_INT_MEAS_DONE_EN MMC5883MA_INTRNLCTRL2_INT_MEAS_DONE_EN_Msk
 /** @} */
 
 /**
@@ -135,21 +132,21 @@
  */
 #define MMC5883MA_INTRNLCTRL1_BW_Pos           (0U)
 #define MMC5883MA_INTRNLCTRL1_BW_Msk           (0x3U << MMC5883MA_INTRNLCTRL1_BW_Pos)
-#define MMC5883MA_INTRNLCTRL1_BW               MMC5883MA_INTRNLCTRL1_BW_Msk 
-#define MMC5883MA_INTRNLCTRL1_BW_ODR_100Hz     (0x0U << MMC5883MA_INTRNLCTRL1_BW_Pos)
-#define MMC5883MA_INTRNLCTRL1_BW_ODR_200Hz     (0x1U << MMC5883MA_INTRNLCTRL1_BW_Pos)
-#define MMC5883MA_INTRNLCTRL1_BW_ODR_400Hz     (0x2U << MMC5883MA_INTRNLCTRL1_BW_Pos)
-#define MMC5883MA_INTRNLCTRL1_BW_ODR_600Hz     (0x3U << MMC5883MA_INTRNLCTRL1_BW_Pos)
+#define MMC5883MA_INTRNLCTRL1_BW               MMC5883MA_INTRNLCTRL1_BW_Msk
+#define MMC5883MA_INTRNLCTRL1_BW_100Hz         (0x0U << MMC5883MA_INTRNLCTRL1_BW_Pos)
+#define MMC5883MA_INTRNLCTRL1_BW_200Hz         (0x1U << MMC5883MA_INTRNLCTRL1_BW_Pos)
+#define MMC5883MA_INTRNLCTRL1_BW_400Hz         (0x2U << MMC5883MA_INTRNLCTRL1_BW_Pos)
+#define MMC5883MA_INTRNLCTRL1_BW_600Hz         (0x3U << MMC5883MA_INTRNLCTRL1_BW_Pos)
 #define MMC5883MA_INTRNLCTRL1_INH_Pos          (2U)
-#define MMC5883MA_INTRNLCTRL1_INH_Msk          (0x7U <<  MMC5883MA_INTRNLCTRL_INH_Pos)
-#define MMC5883MA_INTRNLCTRL1_INH              MMC5883MA_INTRNLCTRZ_INH_Msk
-#define MMC5883MA_INTRNLCTRL1_INH_X            (0x1U << MMC5883MA_INTRNLCTRL_INH_Pos)
-#define MMC5883MA_INTRNLCTRL1_INH_Y            (0x2U << MMC5883MA_INTRNLCTRL_INH_Pos)
-#define MMC5883MA_INTRNLCTRL1_INH_Z            (0x4U << MMC5883MA_INTRNLCTRL_INH_Pos)
-#define MMC5883MA_INTRNLCTRL1_SW_RST_Pos       (7U)  
-#define MMC5883MA_INTRNLCTRL1_SW_RST_Msk       (0x1U << MMC5883MA_INTRNLCTRL_SW_RST_Pos) 
-#define MMC5883MA_INTRNLCTRL1_SW_RST           MMC5883MA_INTRNLCTRL_SW_RST_Msk
-#define MMC5883MA_INTRNLCTRL1_SW_RST_CMD       (0x1U << MMC5883MA_INTRNLCTRL_SW_RST_Pos)
+#define MMC5883MA_INTRNLCTRL1_INH_Msk          (0x7U << MMC5883MA_INTRNLCTRL1_INH_Pos)
+#define MMC5883MA_INTRNLCTRL1_INH              MMC5883MA_INTRNLCTRL1_INH_Msk
+#define MMC5883MA_INTRNLCTRL1_INH_X            (0x1U << MMC5883MA_INTRNLCTRL1_INH_Pos)
+#define MMC5883MA_INTRNLCTRL1_INH_Y            (0x2U << MMC5883MA_INTRNLCTRL1_INH_Pos)
+#define MMC5883MA_INTRNLCTRL1_INH_Z            (0x4U << MMC5883MA_INTRNLCTRL1_INH_Pos)
+#define MMC5883MA_INTRNLCTRL1_SW_RST_Pos       (7U)
+#define MMC5883MA_INTRNLCTRL1_SW_RST_Msk       (0x1U << MMC5883MA_INTRNLCTRL1_SW_RST_Pos)
+#define MMC5883MA_INTRNLCTRL1_SW_RST           MMC5883MA_INTRNLCTRL1_SW_RST_Msk
+#define MMC5883MA_INTRNLCTRL1_SW_RST_CMD       (0x1U << MMC5883MA_INTRNLCTRL1_SW_RST_Pos)
 /** @} */
 
 /**
@@ -215,8 +212,8 @@
  * @{
  */
 #define MMC5883MA_TEMPERATURE_OUT_Pos          (0U)
-#define MMC5883MA_TEMPERATURE_OUT_Msk          (0xFFU << MMC5883MA_TEMPERATURE_Pos)
-#define MMC5883MA_TEMPERATURE_OUT              MMC5883MA_TEMPERATURE_Msk
+#define MMC5883MA_TEMPERATURE_OUT_Msk          (0xFFU << MMC5883MA_TEMPERATURE_OUT_Pos)
+#define MMC5883MA_TEMPERATURE_OUT              MMC5883MA_TEMPERATURE_OUT_Msk
 /** @} */
 
 /**
@@ -243,7 +240,7 @@
  */
 #define MMC5883MA_YOUT_H_Pos                   (0U)              
 #define MMC5883MA_YOUT_H_Msk                   (0xFFU << MMC5883MA_YOUT_H_Pos)
-#define MMC5883MA_YOUT_H_Msk                   MMC5883MA_YOUT_H_Msk
+#define MMC5883MA_YOUT_H                       MMC5883MA_YOUT_H_Msk
 /** @} */
 
 /**
@@ -273,6 +270,17 @@
 #define MMC5883MA_XOUT_L                       MMC5883MA_XOUT_L_Msk               
 /** @} */
 
+/**
+ * @name    MMC5883MA conversion constants
+ * @{
+ */
+#define MMC5883MA_PRDCT_ID_EXPECTED            0x0CU
+#define MMC5883MA_NULL_FIELD_RAW               32768U
+#define MMC5883MA_COUNTS_PER_GAUSS             4096
+/* XOUT_LOW through STATUS, read in a single transaction */
+#define MMC5883MA_BURST_LEN                    (MMC5883MA_AD_STATUS - MMC5883MA_AD_XOUT_LOW + 1U)
+/** @} */
+
 /*===========================================================================*/
 /* Driver pre-compile time settings.                                         */
 /*===========================================================================*/
@@ -299,6 +307,20 @@
 #if !defined(MMC5883MA_SHARED_I2C) || defined(__DOXYGEN__)
 #define MMC5883MA_SHARED_I2C                   FALSE
 #endif
+
+/**
+ * @brief   MMC5883MA I2C transaction timeout.
+ */
+#if !defined(MMC5883MA_I2C_TIMEOUT) || defined(__DOXYGEN__)
+#define MMC5883MA_I2C_TIMEOUT                  TIME_MS2I(50)
+#endif
+
+/**
+ * @brief   Time to allow the SET/RESET storage capacitor to recharge.
+ */
+#if !defined(MMC5883MA_SETRESET_DELAY) || defined(__DOXYGEN__)
+#define MMC5883MA_SETRESET_DELAY               TIME_MS2I(1)
+#endif
 /** @} */
 
 /*===========================================================================*/
@@ -335,6 +357,19 @@ typedef enum {
     MMC5883MA_READY = 2,                   /**< Ready.                           */
 } mmc5883ma_state_t;
 
+/**
+ * @brief   MMC5883MA magnetic field sample.
+ * @note    Scaled values are offset corrected and in milligauss.
+ */
+typedef struct {
+    int16_t                     mag_x;
+    int16_t                     mag_y;
+    int16_t                     mag_z;
+    uint16_t                    mag_x_raw;
+    uint16_t                    mag_y_raw;
+    uint16_t                    mag_z_raw;
+} mmc5883ma_sample_t;
+
 /**
  * @brief   MMC5883MA configuration structure.
  */
@@ -353,6 +388,19 @@ typedef struct {
      */
     i2caddr_t                   saddr;
 #endif /* MMC5883MA_USE_I2C */
+    /**
+     * @brief Internal Control 1 bandwidth selection (MMC5883MA_INTRNLCTRL1_BW_*)
+     */
+    uint8_t                     bw;
+    /**
+     * @brief Continuous mode frequency (MMC5883MA_INTRNLCTRL2_CM_FREQ_*)
+     */
+    uint8_t                     cm_freq;
+    /**
+     * @brief Number of samples between SET/RESET offset updates, 0 for
+     *        only once at start.
+     */
+    uint16_t                    setreset_interval;
 } MMC5883MAConfig;
 
 /**
@@ -383,10 +431,14 @@ struct MMC5883MAVMT {
     /* Driver state.*/                                                      \
     mmc5883ma_state_t              state;                                      \
     /* Current configuration data.*/                                        \
-    const MMC5883MAConfig          *config;
+    const MMC5883MAConfig          *config;                                    \
+    /* Bridge offset from the last SET/RESET cycle.*/                       \
+    uint16_t                       offset[3];                                  \
+    /* Samples read since the last SET/RESET cycle.*/                       \
+    uint16_t                       samples;
 
 /**
- * @brief MMC5883MA Power Monitor class.
+ * @brief MMC5883MA Magnetometer class.
  */
 struct MMC5883MADriver {
     /** @brief Virtual Methods Table.*/
@@ -410,6 +462,10 @@ extern "C" {
 void mmc5883maObjectInit(MMC5883MADriver *devp);
 void mmc5883maStart(MMC5883MADriver *devp, const MMC5883MAConfig *config);
 void mmc5883maStop(MMC5883MADriver *devp);
+msg_t mmc5883maReadProductId(MMC5883MADriver *devp, uint8_t *dest);
+msg_t mmc5883maSetReset(MMC5883MADriver *devp);
+msg_t mmc5883maReadRaw(MMC5883MADriver *devp, uint8_t *dest);
+msg_t mmc5883maReadXYZ(MMC5883MADriver *devp, mmc5883ma_sample_t *dest);
 #ifdef __cplusplus
 }
 #endif
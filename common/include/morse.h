@@ -9,12 +9,49 @@
 #ifndef _MORSE_H_
 #define _MORSE_H_
 
+#include "ax5043.h"
+
+/**
+ * @brief   Longest message a keying schedule holds.
+ */
+#if !defined(MORSE_MAX_MSG) || defined(__DOXYGEN__)
+#define MORSE_MAX_MSG                       64U
+#endif
+
+/* At most 5 elements per character, each one key down and one key up run */
+#define MORSE_MAX_RUNS                      (MORSE_MAX_MSG * 10U)
+/* Runs converted to FIFO chunks per TX refill */
+#define MORSE_BLOCK_RUNS                    32U
+#define MORSE_CHUNK_LEN                     4U
+
+/* Run encoding: key state in the MSB, length in dits below it */
+#define MORSE_RUN_KEY                       0x80U
+#define MORSE_RUN_LEN                       0x7FU
+
+/**
+ * @brief   Compiled run-length keying schedule for a message.
+ */
+typedef struct {
+    char                        msg[MORSE_MAX_MSG];
+    size_t                      msg_len;
+    int                         wpm;
+    uint16_t                    dit_ms;
+    size_t                      count;
+    uint8_t                     runs[MORSE_MAX_RUNS];
+    ax5043_profile_t            profile[3];
+    /* Streaming state */
+    size_t                      pos;
+    uint8_t                     chunks[MORSE_BLOCK_RUNS * MORSE_CHUNK_LEN];
+} morse_sched_t;
+
 #ifdef __cplusplus
 extern "C" {
 #endif
-void ax5043_morse_dot_dash(AX5043Driver *devp, uint16_t dot_dash_time);
 const char *ax5043_ascii_to_morse(char letter);
-void ax5043_send_cw(AX5043Driver *devp, int wpm, char beaconMessage[], uint16_t pktlen );
+bool morse_compile(morse_sched_t *sched, int wpm, const char *msg, size_t len, uint32_t xtal_freq);
+size_t morse_fill(void *arg);
+void morse_send(AX5043Driver *devp, morse_sched_t *sched, bool chan_b);
+void ax5043_send_cw(AX5043Driver *devp, int wpm, char beaconMessage[], uint16_t pktlen);
 #ifdef __cplusplus
 }
 #endif
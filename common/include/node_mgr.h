@@ -14,6 +14,16 @@ typedef struct oresat_node {
     char            *name;
 } oresat_node_t;
 
+typedef enum {
+    NODE_OFF = 0,                   /* Not powered */
+    NODE_QUEUED,                    /* Waiting for an inrush slot */
+    NODE_INRUSH,                    /* Just powered on */
+    NODE_BOOTING,                   /* Waiting for the first heartbeat */
+    NODE_UP,                        /* Heartbeat seen */
+    NODE_BACKOFF,                   /* Powered off before a retry */
+    NODE_FAILED,                    /* Out of attempts or not connected */
+} node_phase_t;
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -22,6 +32,7 @@ extern THD_WORKING_AREA(node_mgr_wa, 0x400);
 extern THD_FUNCTION(node_mgr, arg);
 int node_enable(uint8_t id, bool enable);
 int node_status(uint8_t id, CO_NMT_internalState_t *state);
+node_phase_t node_phase(uint8_t id, uint8_t *attempts);
 
 #ifdef __cplusplus
 }
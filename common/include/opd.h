@@ -60,7 +60,11 @@ typedef struct {
 void opd_init(void);
 void opd_start(void);
 void opd_stop(void);
+size_t opd_start_expected(const i2caddr_t *addrs, size_t count);
 void opd_scan(bool restart);
+size_t opd_scan_addrs(const i2caddr_t *addrs, size_t count, bool restart);
+void opd_scan_background(void);
+bool opd_scan_busy(void);
 bool opd_probe(i2caddr_t addr, bool restart);
 int opd_enable(i2caddr_t addr, bool enable);
 int opd_disable(i2caddr_t addr);
@@ -41,17 +41,45 @@ typedef struct {
     const char              *name;
 } synth_dev_t;
 
+
 typedef struct {
     AX5043Driver            *devp;
-    const AX5043Config      *cfgp;
+    const ax5043_profile_t  *profile;
     const char              *name;
-} radio_dev_t;
+} radio_cfg_t;
+
+/**
+ * @brief   Frame buffer queue statistics.
+ * @note    Times are in realtime counter cycles.
+ */
+typedef struct {
+    uint32_t                sent;           /**< PDUs queued                       */
+    uint32_t                received;       /**< PDUs taken off the queue          */
+    uint32_t                depth_max;      /**< Deepest queue seen after a send   */
+    uint32_t                pool_empty;     /**< Allocations that found no buffer  */
+    rtcnt_t                 wait_max;       /**< Longest time a PDU sat queued     */
+    uint64_t                wait_sum;       /**< Queued time of all received PDUs  */
+} pdu_stats_t;
+
+/**
+ * @brief   Frame buffer pool and PDU queue.
+ * @note    The queue is passed to the frame buffer and PDU calls as
+ *          @p &queue->fifo, like a plain objects FIFO.
+ */
+typedef struct {
+    objects_fifo_t          fifo;
+    msg_t                   msgs[RADIO_FIFO_COUNT];
+    fb_t                    buf[RADIO_FIFO_COUNT];
+    rtcnt_t                 stamp[RADIO_FIFO_COUNT];    /**< Send time of each buffer */
+    pdu_stats_t             stats;
+} pdu_queue_t;
 
 typedef struct {
     AX5043Driver            *devp;
-    const ax5043_profile_t  *profile;
+    const AX5043Config      *cfgp;
     const char              *name;
-} radio_cfg_t;
+    pdu_queue_t             *txq;           /**< Transmit queue, NULL if receive only */
+} radio_dev_t;
 
 /*===========================================================================*/
 /* Macros.                                                                   */
@@ -68,16 +96,18 @@ extern "C" {
 extern synth_dev_t synth_devices[];
 extern radio_dev_t radio_devices[];
 extern radio_cfg_t radio_cfgs[];
-extern objects_fifo_t rx_fifo;
-extern objects_fifo_t tx_fifo;
+extern pdu_queue_t rx_queue;
 
 void radio_init(void);
 void radio_start(void);
 void radio_stop(void);
+objects_fifo_t *radio_tx_fifo(const AX5043Driver *devp);
 
 void pdu_send(fb_t *fb, void *arg);
 void pdu_send_ahead(fb_t *fb, void *arg);
 fb_t *pdu_recv(void *arg);
+void pdu_get_stats(void *arg, pdu_stats_t *stats);
+void pdu_reset_stats(void *arg);
 
 #ifdef __cplusplus
 }
@@ -12,6 +12,7 @@ extern "C" {
 #define TS_CAL1_TEMP            30
 #define TS_CAL2_TEMP            110
 #define VREFINT_CAL_VOLT        330
+#define SENSORS_OVERSAMPLE_DEF  64
 #define ADC_REG_CFG             ADC_CFGR1_CONT | ADC_CFGR1_RES_12BIT,               /* CFGR1    */  \
                                 ADC_TR(0, 0),                                       /* TR       */  \
                                 ADC_SMPR_SMP_239P5,                                 /* SMPR     */  \
@@ -24,6 +25,7 @@ extern "C" {
 #define TS_CAL1_TEMP            30
 #define TS_CAL2_TEMP            110
 #define VREFINT_CAL_VOLT        330
+#define SENSORS_OVERSAMPLE_DEF  64
 #define ADC_REG_CFG             0,                                                  /* CR1      */  \
                                 ADC_CR2_SWSTART,                                    /* CR2      */  \
                                 ADC_SMPR1_SMP_SENSOR(ADC_SAMPLE_480)                /* SMPR1    */  \
@@ -43,8 +45,12 @@ extern "C" {
 #define TS_CAL1_TEMP            30
 #define TS_CAL2_TEMP            130
 #define VREFINT_CAL_VOLT        330
+/* Hardware oversampling x256, shifted back down to 12 bits */
+#define SENSORS_OVERSAMPLE_DEF  8
 #define ADC_REG_CFG             ADC_CFGR_CONT,                                      /* CFGR     */  \
-                                0,                                                  /* CFGR2    */  \
+                                ADC_CFGR2_ROVSE | ADC_CFGR2_OVSR_2                  /* CFGR2    */  \
+                                | ADC_CFGR2_OVSR_1 | ADC_CFGR2_OVSR_0                               \
+                                | ADC_CFGR2_OVSS_3,                                                 \
                                 ADC_TR(0, 4095),                                    /* TR1      */  \
                                 0,                                                  /* TR2      */  \
                                 0,                                                  /* TR3      */  \
@@ -63,6 +69,20 @@ extern "C" {
                                     0                                                               \
                                 }
 #define ADC_ENABLE_SENSORS(adc) {adcSTM32EnableTS(adc); adcSTM32EnableVREF(adc);}
+#elif defined(SIMULATOR)
+/* The F0 sequence on the host ADC, system memory is the POSIX_SIM board's */
+#define TS_CAL1_BASE            ((uintptr_t)&sim_mcu_cal[SIM_MCU_TS_CAL1])
+#define TS_CAL2_BASE            ((uintptr_t)&sim_mcu_cal[SIM_MCU_TS_CAL2])
+#define VREFINT_CAL_BASE        ((uintptr_t)&sim_mcu_cal[SIM_MCU_VREFINT_CAL])
+#define TS_CAL1_TEMP            30
+#define TS_CAL2_TEMP            110
+#define VREFINT_CAL_VOLT        330
+#define SENSORS_OVERSAMPLE_DEF  64
+#define ADC_REG_CFG             ADC_CFGR1_CONT | ADC_CFGR1_RES_12BIT,               /* CFGR1    */  \
+                                ADC_TR(0, 0),                                       /* TR       */  \
+                                ADC_SMPR_SMP_239P5,                                 /* SMPR     */  \
+                                ADC_CHSELR_CHSEL16 | ADC_CHSELR_CHSEL17             /* CHSELR   */
+#define ADC_ENABLE_SENSORS(adc) {(void)(adc);}
 #else
 #error "No Sensors Config for this MCU"
 #endif
@@ -71,8 +91,27 @@ extern "C" {
 #define TS_CAL2_VAL             (*((uint16_t*)TS_CAL2_BASE))
 #define VREFINT_CAL_VAL         (*((uint16_t*)VREFINT_CAL_BASE))
 
+/* Sequences averaged per half buffer callback */
+#if !defined(SENSORS_OVERSAMPLE)
+#define SENSORS_OVERSAMPLE      SENSORS_OVERSAMPLE_DEF
+#endif
+
+/* Running average weight of each new result is 1/2^SENSORS_FILTER_SHIFT */
+#if !defined(SENSORS_FILTER_SHIFT)
+#define SENSORS_FILTER_SHIFT    3
+#endif
+
+typedef struct {
+    int16_t temperature;        /* 0.1 C */
+    uint16_t vdda;              /* mV */
+    uint16_t temperature_raw;
+    uint16_t vrefint_raw;
+} sensors_data_t;
+
 void sensors_init(void);
 void sensors_start(void);
+bool sensors_stop(void);
+void sensors_get(sensors_data_t *dest);
 
 #ifdef __cplusplus
 }
@@ -64,6 +64,22 @@
 #define SI41XX_REG_IF_RDIV                  0x8U
 /** @} */
 
+/**
+ * @name    SI41XX serial stream sizes
+ * @{
+ */
+/**
+ * @brief   Most words programmed in one transaction.
+ */
+#define SI41XX_MAX_WORDS                    8U
+/**
+ * @brief   GPIO set/reset steps per 22-bit word.
+ * @details SEN low, a data and a clock step per bit, then SCLK low, SEN
+ *          high and SCLK high.
+ */
+#define SI41XX_WORD_STEPS                   48U
+/** @} */
+
 /**
  * @name    SI41XX Main Configuration register fields
  * @{
@@ -219,6 +235,75 @@
 #if !defined(SI41XX_SHARED_SERIAL) || defined(__DOXYGEN__)
 #define SI41XX_SHARED_SERIAL                FALSE
 #endif
+
+/**
+ * @brief   SI41XX DMA serial switch.
+ * @details If set to @p TRUE the serial words are clocked out by a timer
+ *          paced DMA stream into the GPIO set/reset register, leaving the
+ *          CPU free while the synthesizer is programmed. All three serial
+ *          lines must be on the same GPIO port, and the driver object must
+ *          be in DMA accessible memory.
+ * @note    The default is @p FALSE. STM32 only.
+ */
+#if !defined(SI41XX_USE_DMA) || defined(__DOXYGEN__)
+#define SI41XX_USE_DMA                      FALSE
+#endif
+
+/**
+ * @brief   DMA stream used by the serial stream.
+ * @note    Must be the stream the timer update request is routed to, on a
+ *          DMA controller with access to the GPIO bus (DMA2 on STM32F4).
+ */
+#if !defined(SI41XX_DMA_STREAM) || defined(__DOXYGEN__)
+#define SI41XX_DMA_STREAM                   STM32_DMA_STREAM_ID(2, 1)
+#endif
+
+/**
+ * @brief   DMA channel of the timer update request.
+ */
+#if !defined(SI41XX_DMA_CHANNEL) || defined(__DOXYGEN__)
+#define SI41XX_DMA_CHANNEL                  7U
+#endif
+
+/**
+ * @brief   DMA stream priority (0..3).
+ */
+#if !defined(SI41XX_DMA_PRIORITY) || defined(__DOXYGEN__)
+#define SI41XX_DMA_PRIORITY                 1U
+#endif
+
+/**
+ * @brief   DMA interrupt priority.
+ */
+#if !defined(SI41XX_DMA_IRQ_PRIORITY) || defined(__DOXYGEN__)
+#define SI41XX_DMA_IRQ_PRIORITY             10U
+#endif
+
+/**
+ * @brief   Timer pacing the serial stream.
+ */
+#if !defined(SI41XX_DMA_TIM) || defined(__DOXYGEN__)
+#define SI41XX_DMA_TIM                      STM32_TIM8
+#define SI41XX_DMA_TIM_CLK                  STM32_TIMCLK2
+#define SI41XX_DMA_TIM_ENABLE()             rccEnableTIM8(true)
+#define SI41XX_DMA_TIM_DISABLE()            rccDisableTIM8()
+#endif
+
+/**
+ * @brief   Serial stream step rate in Hz.
+ * @details SCLK runs at half this rate.
+ */
+#if !defined(SI41XX_DMA_STEP_FREQ) || defined(__DOXYGEN__)
+#define SI41XX_DMA_STEP_FREQ                4000000U
+#endif
+
+/**
+ * @brief   Number of cached divider results.
+ * @details Frequencies already seen skip the divider search on retune.
+ */
+#if !defined(SI41XX_DIV_CACHE_SIZE) || defined(__DOXYGEN__)
+#define SI41XX_DIV_CACHE_SIZE               8U
+#endif
 /** @} */
 
 /*===========================================================================*/
@@ -233,6 +318,14 @@
 #error "SI41XX_SHARED_SERIAL requires SI41XX_USE_MUTUAL_EXCLUSION"
 #endif
 
+#if SI41XX_USE_DMA && !SI41XX_USE_SERIAL
+#error "SI41XX_USE_DMA requires SI41XX_USE_SERIAL"
+#endif
+
+#if SI41XX_DIV_CACHE_SIZE < 1
+#error "SI41XX_DIV_CACHE_SIZE must be at least 1"
+#endif
+
 #if (SI41XX_DEVICE != SI4112 && \
      SI41XX_DEVICE != SI4113 && \
      SI41XX_DEVICE != SI4122 && \
@@ -276,6 +369,15 @@ typedef enum {
     SI41XX_READY                /**< Ready.                             */
 } si41xx_state_t;
 
+/**
+ * @brief   Cached divider result.
+ */
+typedef struct {
+    uint32_t                    freq;
+    uint32_t                    ndiv;
+    uint32_t                    rdiv;
+} si41xx_div_t;
+
 /**
  * @brief   SI41XX configuration structure.
  */
@@ -353,6 +455,28 @@ typedef struct SI41XXDriver {
     mutex_t                     mutex;
 #endif /* SI41XX_USE_MUTUAL_EXCLUSION */
     uint8_t                     pwr;
+    /**
+     * @brief   Divider results by frequency, replaced round robin.
+     */
+    si41xx_div_t                div_cache[SI41XX_DIV_CACHE_SIZE];
+    uint8_t                     div_next;
+    uint32_t                    div_hits;
+    uint32_t                    div_misses;
+#if SI41XX_USE_DMA || defined(__DOXYGEN__)
+    /**
+     * @brief   Serial stream DMA channel.
+     */
+    const stm32_dma_stream_t    *dmastp;
+    /**
+     * @brief   Thread waiting on the serial stream.
+     */
+    thread_reference_t          thread;
+    /**
+     * @brief   GPIO set/reset register values of the last transaction.
+     */
+    uint32_t                    stream[SI41XX_MAX_WORDS * SI41XX_WORD_STEPS];
+    size_t                      stream_len;
+#endif /* SI41XX_USE_DMA */
 } SI41XXDriver;
 /** @} */
 
@@ -144,6 +144,8 @@ void max7310Start(MAX7310Driver *devp, const MAX7310Config *config) {
     i2cReleaseBus(config->i2cp);
 #endif /* MAX7310_SHARED_I2C */
 #endif /* MAX7310_USE_I2C */
+    devp->odr = config->odr;
+    devp->iomode = config->iomode;
     devp->state = MAX7310_READY;
 }
 
@@ -259,6 +261,11 @@ void max7310WriteRaw(MAX7310Driver *devp, uint8_t reg, uint8_t value) {
     buf.reg = reg;
     buf.data = value;
     max7310I2CWriteRegister(devp->config->i2cp, devp->config->saddr, buf.buf, sizeof(buf));
+    if (reg == MAX7310_AD_ODR) {
+        devp->odr = value;
+    } else if (reg == MAX7310_AD_MODE) {
+        devp->iomode = value;
+    }
 
 #if MAX7310_SHARED_I2C
     i2cReleaseBus(devp->config->i2cp);
@@ -288,10 +295,11 @@ void max7310SetPin(MAX7310Driver *devp, uint8_t pin) {
     i2cStart(devp->config->i2cp, devp->config->i2ccfg);
 #endif /* MAX7310_SHARED_I2C */
 
+    /* Output register is shadowed, no read back needed.*/
     buf.reg = MAX7310_AD_ODR;
-    max7310I2CReadRegister(devp->config->i2cp, devp->config->saddr, buf.reg, &buf.data, sizeof(buf.data));
-    buf.data |= MAX7310_PIN_MASK(pin);
+    buf.data = devp->odr | MAX7310_PIN_MASK(pin);
     max7310I2CWriteRegister(devp->config->i2cp, devp->config->saddr, buf.buf, sizeof(buf));
+    devp->odr = buf.data;
 
 #if MAX7310_SHARED_I2C
     i2cReleaseBus(devp->config->i2cp);
@@ -321,10 +329,11 @@ void max7310ClearPin(MAX7310Driver *devp, uint8_t pin) {
     i2cStart(devp->config->i2cp, devp->config->i2ccfg);
 #endif /* MAX7310_SHARED_I2C */
 
+    /* Output register is shadowed, no read back needed.*/
     buf.reg = MAX7310_AD_ODR;
-    max7310I2CReadRegister(devp->config->i2cp, devp->config->saddr, buf.reg, &buf.data, sizeof(buf.data));
-    buf.data &= ~MAX7310_PIN_MASK(pin);
+    buf.data = devp->odr & ~MAX7310_PIN_MASK(pin);
     max7310I2CWriteRegister(devp->config->i2cp, devp->config->saddr, buf.buf, sizeof(buf));
+    devp->odr = buf.data;
 
 #if MAX7310_SHARED_I2C
     i2cReleaseBus(devp->config->i2cp);
@@ -354,10 +363,11 @@ void max7310TogglePin(MAX7310Driver *devp, uint8_t pin) {
     i2cStart(devp->config->i2cp, devp->config->i2ccfg);
 #endif /* MAX7310_SHARED_I2C */
 
+    /* Output register is shadowed, no read back needed.*/
     buf.reg = MAX7310_AD_ODR;
-    max7310I2CReadRegister(devp->config->i2cp, devp->config->saddr, buf.reg, &buf.data, sizeof(buf.data));
-    buf.data ^= MAX7310_PIN_MASK(pin);
+    buf.data = devp->odr ^ MAX7310_PIN_MASK(pin);
     max7310I2CWriteRegister(devp->config->i2cp, devp->config->saddr, buf.buf, sizeof(buf));
+    devp->odr = buf.data;
 
 #if MAX7310_SHARED_I2C
     i2cReleaseBus(devp->config->i2cp);
@@ -1,12 +1,13 @@
 /**
  * @file    mmc5883ma.c
- * @brief   MMC5883MA Digital to Analog Converter.
+ * @brief   MMC5883MA 3-axis Magnetometer.
  *
  * @addtogroup MMC5883MA
  * @ingrup ORESAT
  * @{
  */
 
+#include <string.h>
 #include "hal.h"
 #include "mmc5883ma.h"
 
@@ -21,16 +22,6 @@
 /*===========================================================================*/
 /* Driver local variables and types.                                         */
 /*===========================================================================*/
-typedef union {
-    struct __attribute__((packed)) {
-        uint8_t reg;
-        union {
-            uint8_t data[2];
-            uint16_t value;
-        };
-    };
-    uint8_t buf[3];
-} i2cbuf_t;
 
 /*===========================================================================*/
 /* Driver local functions.                                                   */
@@ -52,7 +43,7 @@ typedef union {
 msg_t mmc5883maI2CReadRegister(I2CDriver *i2cp, i2caddr_t sad, uint8_t reg,
         uint8_t* rxbuf, size_t n) {
     return i2cMasterTransmitTimeout(i2cp, sad, &reg, 1, rxbuf, n,
-            TIME_INFINITE);
+            MMC5883MA_I2C_TIMEOUT);
 }
 
 /**
@@ -61,19 +52,113 @@ msg_t mmc5883maI2CReadRegister(I2CDriver *i2cp, i2caddr_t sad, uint8_t reg,
  *
  * @param[in] i2cp       pointer to the I2C interface
  * @param[in] sad        slave address without R bit
- * @param[in] txbuf      buffer containing reg in first byte and high
- *                       and low data bytes
- * @param[in] n          size of txbuf
+ * @param[in] reg        register to write
+ * @param[in] value      value to write
  * @return               the operation status.
  * @notapi
  */
-msg_t mmc5883maI2CWriteRegister(I2CDriver *i2cp, i2caddr_t sad, uint8_t *txbuf,
-        size_t n) {
-    return i2cMasterTransmitTimeout(i2cp, sad, txbuf, n, NULL, 0,
-            TIME_INFINITE);
+msg_t mmc5883maI2CWriteRegister(I2CDriver *i2cp, i2caddr_t sad, uint8_t reg,
+        uint8_t value) {
+    uint8_t txbuf[2] = {reg, value};
+    return i2cMasterTransmitTimeout(i2cp, sad, txbuf, sizeof(txbuf), NULL, 0,
+            MMC5883MA_I2C_TIMEOUT);
 }
 #endif /* MMC5883MA_USE_I2C */
 
+/**
+ * @brief   Waits for a single triggered measurement to complete.
+ * @note    Bus must already be owned by the caller.
+ *
+ * @param[in]  devp      pointer to the @p MMC5883MADriver object
+ * @param[out] rxbuf     buffer of @p MMC5883MA_BURST_LEN bytes for the result
+ * @return               the operation status.
+ * @notapi
+ */
+static msg_t mmc5883maMeasure(MMC5883MADriver *devp, uint8_t *rxbuf) {
+    const MMC5883MAConfig *config = devp->config;
+    msg_t r;
+
+    r = mmc5883maI2CWriteRegister(config->i2cp, config->saddr,
+            MMC5883MA_AD_INTRNLCTRL0, MMC5883MA_INTRNLCTRL0_TM_M_INIT);
+    if (r != MSG_OK)
+        return r;
+
+    /* Worst case measurement time is 10ms at 100Hz bandwidth */
+    for (int i = 0; i < 20; i++) {
+        chThdSleepMilliseconds(1);
+        r = mmc5883maI2CReadRegister(config->i2cp, config->saddr,
+                MMC5883MA_AD_XOUT_LOW, rxbuf, MMC5883MA_BURST_LEN);
+        if (r != MSG_OK)
+            return r;
+        if (rxbuf[MMC5883MA_AD_STATUS] & MMC5883MA_STATUS_MEAS_M_DONE) {
+            return mmc5883maI2CWriteRegister(config->i2cp, config->saddr,
+                    MMC5883MA_AD_STATUS, MMC5883MA_STATUS_MEAS_M_DONE_CLR);
+        }
+    }
+
+    return MSG_TIMEOUT;
+}
+
+/**
+ * @brief   Runs a SET/RESET cycle and leaves the sensor in continuous mode.
+ * @details The bridge offset is half the sum of a SET and a RESET sample,
+ *          since the field term changes sign between the two. The sensor is
+ *          left in SET polarity so continuous samples only need the offset
+ *          subtracted.
+ * @note    Bus must already be owned by the caller.
+ *
+ * @param[in] devp       pointer to the @p MMC5883MADriver object
+ * @param[out] sample    optional buffer of @p MMC5883MA_BURST_LEN bytes
+ *                       receiving the SET measurement, or @p NULL
+ * @return               the operation status.
+ * @notapi
+ */
+static msg_t mmc5883maSetResetI(MMC5883MADriver *devp, uint8_t *sample) {
+    const MMC5883MAConfig *config = devp->config;
+    uint8_t set[MMC5883MA_BURST_LEN], reset[MMC5883MA_BURST_LEN];
+    msg_t r;
+
+    /* Continuous mode must be off while the bridge polarity is flipped */
+    r = mmc5883maI2CWriteRegister(config->i2cp, config->saddr,
+            MMC5883MA_AD_INTRNLCTRL2, MMC5883MA_INTRNLCTRL2_CM_FREQ_OFF);
+    if (r != MSG_OK)
+        return r;
+    /* A pending continuous sample would otherwise pass for the RESET one */
+    r = mmc5883maI2CWriteRegister(config->i2cp, config->saddr,
+            MMC5883MA_AD_STATUS, MMC5883MA_STATUS_MEAS_M_DONE_CLR);
+    if (r != MSG_OK)
+        return r;
+
+    r = mmc5883maI2CWriteRegister(config->i2cp, config->saddr,
+            MMC5883MA_AD_INTRNLCTRL0, MMC5883MA_INTRNLCTRL0_RST_CMD);
+    if (r != MSG_OK)
+        return r;
+    chThdSleep(MMC5883MA_SETRESET_DELAY);
+    if ((r = mmc5883maMeasure(devp, reset)) != MSG_OK)
+        return r;
+
+    r = mmc5883maI2CWriteRegister(config->i2cp, config->saddr,
+            MMC5883MA_AD_INTRNLCTRL0, MMC5883MA_INTRNLCTRL0_SET_CMD);
+    if (r != MSG_OK)
+        return r;
+    chThdSleep(MMC5883MA_SETRESET_DELAY);
+    if ((r = mmc5883maMeasure(devp, set)) != MSG_OK)
+        return r;
+
+    for (int i = 0; i < 3; i++) {
+        uint32_t s = set[2 * i] | (set[2 * i + 1] << 8);
+        uint32_t rs = reset[2 * i] | (reset[2 * i + 1] << 8);
+        devp->offset[i] = (s + rs) / 2U;
+    }
+    devp->samples = 0;
+    if (sample != NULL) {
+        memcpy(sample, set, sizeof(set));
+    }
+
+    return mmc5883maI2CWriteRegister(config->i2cp, config->saddr,
+            MMC5883MA_AD_INTRNLCTRL2, config->cm_freq);
+}
+
 /*==========================================================================*/
 /* Interface implementation.                                                */
 /*==========================================================================*/
@@ -98,11 +183,19 @@ void mmc5883maObjectInit(MMC5883MADriver *devp) {
 
     devp->config = NULL;
 
+    for (int i = 0; i < 3; i++) {
+        devp->offset[i] = MMC5883MA_NULL_FIELD_RAW;
+    }
+    devp->samples = 0;
+
     devp->state = MMC5883MA_STOP;
 }
 
 /**
  * @brief   Configures and activates MMC5883MA Complex Driver peripheral.
+ * @details The sensor is reset, its product ID checked, an initial
+ *          SET/RESET offset measured and continuous mode enabled. The driver
+ *          only enters @p MMC5883MA_READY if all of these succeed.
  *
  * @param[in] devp      pointer to the @p MMC5883MADriver object
  * @param[in] config    pointer to the @p MMC5883MAConfig object
@@ -110,7 +203,8 @@ void mmc5883maObjectInit(MMC5883MADriver *devp) {
  * @api
  */
 void mmc5883maStart(MMC5883MADriver *devp, const MMC5883MAConfig *config) {
-    i2cbuf_t buf;
+    uint8_t id = 0;
+    msg_t r;
 
     osalDbgCheck((devp != NULL) && (config != NULL));
     osalDbgAssert((devp->state == MMC5883MA_STOP) ||
@@ -126,25 +220,38 @@ void mmc5883maStart(MMC5883MADriver *devp, const MMC5883MAConfig *config) {
 #endif /* MMC5883MA_SHARED_I2C */
 
     i2cStart(config->i2cp, config->i2ccfg);
-    buf.reg = MMC5883MA_AD_CONFIG;
-    buf.value = __REVSH(MMC5883MA_CONFIG_RST);
-    mmc5883maI2CWriteRegister(config->i2cp, config->saddr, buf.buf, sizeof(buf));
     do {
-        mmc5883maI2CReadRegister(config->i2cp, config->saddr, MMC5883MA_AD_CONFIG,
-                                                buf.data, sizeof(buf.data));
-    } while (buf.data[0] & 0x80U); /* While still resetting */
-    buf.reg = MMC5883MA_AD_CONFIG;
-    buf.value = __REVSH(config->cfg);
-    mmc5883maI2CWriteRegister(config->i2cp, config->saddr, buf.buf, sizeof(buf));
-    buf.reg = MMC5883MA_AD_CAL;
-    buf.value = __REVSH(config->cal);
-    mmc5883maI2CWriteRegister(config->i2cp, config->saddr, buf.buf, sizeof(buf));
+        r = mmc5883maI2CWriteRegister(config->i2cp, config->saddr,
+                MMC5883MA_AD_INTRNLCTRL1, MMC5883MA_INTRNLCTRL1_SW_RST_CMD);
+        if (r != MSG_OK)
+            break;
+        /* Power on time after a software reset is 5ms */
+        chThdSleepMilliseconds(5);
+
+        r = mmc5883maI2CReadRegister(config->i2cp, config->saddr,
+                MMC5883MA_AD_PRDCT_ID_1, &id, 1);
+        if (r != MSG_OK || id != MMC5883MA_PRDCT_ID_EXPECTED) {
+            r = MSG_RESET;
+            break;
+        }
+
+        r = mmc5883maI2CWriteRegister(config->i2cp, config->saddr,
+                MMC5883MA_AD_INTRNLCTRL1, config->bw);
+        if (r != MSG_OK)
+            break;
+
+        r = mmc5883maSetResetI(devp, NULL);
+    } while (0);
 
 #if MMC5883MA_SHARED_I2C
     i2cReleaseBus(config->i2cp);
 #endif /* MMC5883MA_SHARED_I2C */
+#else
+    r = MSG_OK;
 #endif /* MMC5883MA_USE_I2C */
-    devp->state = MMC5883MA_READY;
+    if (r == MSG_OK) {
+        devp->state = MMC5883MA_READY;
+    }
 }
 
 /**
@@ -155,8 +262,6 @@ void mmc5883maStart(MMC5883MADriver *devp, const MMC5883MAConfig *config) {
  * @api
  */
 void mmc5883maStop(MMC5883MADriver *devp) {
-    i2cbuf_t buf;
-
     osalDbgCheck(devp != NULL);
     osalDbgAssert((devp->state == MMC5883MA_STOP) || (devp->state == MMC5883MA_READY),
             "mmc5883maStop(), invalid state");
@@ -168,10 +273,9 @@ void mmc5883maStop(MMC5883MADriver *devp) {
         i2cStart(devp->config->i2cp, devp->config->i2ccfg);
 #endif /* MMC5883MA_SHARED_I2C */
 
-        /* Reset to input.*/
-        buf.reg = MMC5883MA_AD_CONFIG;
-        buf.value = __REVSH(MMC5883MA_CONFIG_RST);
-        mmc5883maI2CWriteRegister(devp->config->i2cp, devp->config->saddr, buf.buf, sizeof(buf));
+        /* Leave continuous mode.*/
+        mmc5883maI2CWriteRegister(devp->config->i2cp, devp->config->saddr,
+                MMC5883MA_AD_INTRNLCTRL2, MMC5883MA_INTRNLCTRL2_CM_FREQ_OFF);
 
         i2cStop(devp->config->i2cp);
 #if MMC5883MA_SHARED_I2C
@@ -183,20 +287,20 @@ void mmc5883maStop(MMC5883MADriver *devp) {
 }
 
 /**
- * @brief   Sets MMC5883MA Alert type and value
+ * @brief   Reads MMC5883MA Product ID.
  *
- * @param[in] devp       pointer to the @p MMC5883MADriver object
- * @param[in] alert_me   the value to write to Mask/Enable register (0 to disable)
- * @param[in] alert_lim  the value to write to Alert Limit register
+ * @param[in]  devp      pointer to the @p MMC5883MADriver object
+ * @param[out] dest      destination for the product ID
+ * @return               the operation status.
  *
  * @api
  */
-void mmc5883maSetAlert(MMC5883MADriver *devp, uint16_t alert_me, uint16_t alert_lim) {
-    i2cbuf_t buf;
+msg_t mmc5883maReadProductId(MMC5883MADriver *devp, uint8_t *dest) {
+    msg_t r;
 
-    osalDbgCheck(devp != NULL);
+    osalDbgCheck((devp != NULL) && (dest != NULL));
     osalDbgAssert(devp->state == MMC5883MA_READY,
-            "mmc5883maSetAlert(), invalid state");
+            "mmc5883maReadProductId(), invalid state");
 
 #if MMC5883MA_USE_I2C
 #if MMC5883MA_SHARED_I2C
@@ -204,33 +308,32 @@ void mmc5883maSetAlert(MMC5883MADriver *devp, uint16_t alert_me, uint16_t alert_
     i2cStart(devp->config->i2cp, devp->config->i2ccfg);
 #endif /* MMC5883MA_SHARED_I2C */
 
-    buf.reg = MMC5883MA_AD_LIM;
-    buf.value = __REVSH(alert_lim);
-    mmc5883maI2CWriteRegister(devp->config->i2cp, devp->config->saddr, buf.buf, sizeof(buf));
-    buf.reg = MMC5883MA_AD_ME;
-    buf.value = __REVSH(alert_me);
-    mmc5883maI2CWriteRegister(devp->config->i2cp, devp->config->saddr, buf.buf, sizeof(buf));
+    r = mmc5883maI2CReadRegister(devp->config->i2cp, devp->config->saddr,
+            MMC5883MA_AD_PRDCT_ID_1, dest, 1);
 
 #if MMC5883MA_SHARED_I2C
     i2cReleaseBus(devp->config->i2cp);
 #endif /* MMC5883MA_SHARED_I2C */
 #endif /* MMC5883MA_USE_I2C */
+    return r;
 }
 
 /**
- * @brief   Reads MMC5883MA Register as raw value.
+ * @brief   Runs a SET/RESET offset cancellation cycle.
+ * @note    Called automatically from @p mmc5883maReadXYZ() every
+ *          @p setreset_interval samples.
  *
  * @param[in] devp       pointer to the @p MMC5883MADriver object
- * @param[in] reg        the register to read from
+ * @return               the operation status.
  *
  * @api
  */
-uint16_t mmc5883maReadRaw(MMC5883MADriver *devp, uint8_t reg) {
-    i2cbuf_t buf;
+msg_t mmc5883maSetReset(MMC5883MADriver *devp) {
+    msg_t r;
 
     osalDbgCheck(devp != NULL);
     osalDbgAssert(devp->state == MMC5883MA_READY,
-            "mmc5883maReadRaw(), invalid state");
+            "mmc5883maSetReset(), invalid state");
 
 #if MMC5883MA_USE_I2C
 #if MMC5883MA_SHARED_I2C
@@ -238,92 +341,117 @@ uint16_t mmc5883maReadRaw(MMC5883MADriver *devp, uint8_t reg) {
     i2cStart(devp->config->i2cp, devp->config->i2ccfg);
 #endif /* MMC5883MA_SHARED_I2C */
 
-    buf.reg = reg;
-    mmc5883maI2CReadRegister(devp->config->i2cp, devp->config->saddr, buf.reg, buf.data, sizeof(buf.data));
+    r = mmc5883maSetResetI(devp, NULL);
 
 #if MMC5883MA_SHARED_I2C
     i2cReleaseBus(devp->config->i2cp);
 #endif /* MMC5883MA_SHARED_I2C */
 #endif /* MMC5883MA_USE_I2C */
-    return __REVSH(buf.value);
+    return r;
 }
 
 /**
- * @brief   Reads MMC5883MA Shunt voltage.
+ * @brief   Reads the output, temperature and status registers in one burst.
  *
- * @param[in] devp       Pointer to the @p MMC5883MADriver object
- * @return               Shunt voltage in 0.1uV increments
+ * @param[in]  devp      pointer to the @p MMC5883MADriver object
+ * @param[out] dest      buffer of @p MMC5883MA_BURST_LEN bytes, indexed by
+ *                       register address
+ * @return               the operation status.
  *
  * @api
  */
-int16_t mmc5883maReadShunt(MMC5883MADriver *devp) {
-    int16_t voltage;
+msg_t mmc5883maReadRaw(MMC5883MADriver *devp, uint8_t *dest) {
+    msg_t r;
 
-    osalDbgCheck(devp != NULL);
-
-    voltage = mmc5883maReadRaw(devp, MMC5883MA_AD_SHUNT) * 25;
-
-    return voltage;
-}
-
-/**
- * @brief   Reads MMC5883MA VBUS voltage.
- *
- * @param[in] devp       pointer to the @p MMC5883MADriver object
- * @return               VBUS voltage in 0.01mV increments
- *
- * @api
- */
-uint16_t mmc5883maReadVBUS(MMC5883MADriver *devp) {
-    uint16_t voltage;
+    osalDbgCheck((devp != NULL) && (dest != NULL));
+    osalDbgAssert(devp->state == MMC5883MA_READY,
+            "mmc5883maReadRaw(), invalid state");
 
-    osalDbgCheck(devp != NULL);
+#if MMC5883MA_USE_I2C
+#if MMC5883MA_SHARED_I2C
+    i2cAcquireBus(devp->config->i2cp);
+    i2cStart(devp->config->i2cp, devp->config->i2ccfg);
+#endif /* MMC5883MA_SHARED_I2C */
 
-    voltage = mmc5883maReadRaw(devp, MMC5883MA_AD_VBUS) * 125;
+    r = mmc5883maI2CReadRegister(devp->config->i2cp, devp->config->saddr,
+            MMC5883MA_AD_XOUT_LOW, dest, MMC5883MA_BURST_LEN);
 
-    return voltage;
+#if MMC5883MA_SHARED_I2C
+    i2cReleaseBus(devp->config->i2cp);
+#endif /* MMC5883MA_SHARED_I2C */
+#endif /* MMC5883MA_USE_I2C */
+    return r;
 }
 
 /**
- * @brief   Reads MMC5883MA Current.
- * @note    Requires curr_lsb to be set in config
+ * @brief   Reads the latest continuous mode sample.
+ * @details Axes and status come from a single burst read. If the status
+ *          shows no new measurement since the last call, @p dest is left
+ *          untouched and @p MSG_TIMEOUT is returned. A SET/RESET cycle is run
+ *          instead when @p setreset_interval samples have been read, and its
+ *          SET measurement is returned as the sample since continuous mode
+ *          has only just been re-enabled.
  *
- * @param[in] devp       pointer to the @p MMC5883MADriver object
- * @return               Current in increments of @p curr_lsb
+ * @param[in]  devp      pointer to the @p MMC5883MADriver object
+ * @param[out] dest      pointer to the sample to fill in
+ * @return               the operation status.
  *
  * @api
  */
-int16_t mmc5883maReadCurrent(MMC5883MADriver *devp) {
-    int16_t current;
-
-    osalDbgCheck(devp != NULL);
-    osalDbgAssert(devp->config->curr_lsb,
-            "mmc5883maReadCurrent(): invalid curr_lsb value");
+msg_t mmc5883maReadXYZ(MMC5883MADriver *devp, mmc5883ma_sample_t *dest) {
+    uint8_t buf[MMC5883MA_BURST_LEN];
+    uint16_t raw[3];
+    msg_t r;
 
-    current = mmc5883maReadRaw(devp, MMC5883MA_AD_CURRENT) * devp->config->curr_lsb;
+    osalDbgCheck((devp != NULL) && (dest != NULL));
+    osalDbgAssert(devp->state == MMC5883MA_READY,
+            "mmc5883maReadXYZ(), invalid state");
 
-    return current;
-}
+#if MMC5883MA_USE_I2C
+#if MMC5883MA_SHARED_I2C
+    i2cAcquireBus(devp->config->i2cp);
+    i2cStart(devp->config->i2cp, devp->config->i2ccfg);
+#endif /* MMC5883MA_SHARED_I2C */
 
-/**
- * @brief   Reads MMC5883MA Power.
- * @note    Requires curr_lsb to be set in config
- *
- * @param[in] devp       pointer to the @p MMC5883MADriver object
- * @return               Power in increments of @p curr_lsb * 25V
- *
- * @api
- */
-uint16_t mmc5883maReadPower(MMC5883MADriver *devp) {
-    uint16_t power;
+    do {
+        if (devp->config->setreset_interval &&
+                devp->samples >= devp->config->setreset_interval) {
+            r = mmc5883maSetResetI(devp, buf);
+            break;
+        }
+
+        r = mmc5883maI2CReadRegister(devp->config->i2cp, devp->config->saddr,
+                MMC5883MA_AD_XOUT_LOW, buf, sizeof(buf));
+        if (r != MSG_OK)
+            break;
+        if (!(buf[MMC5883MA_AD_STATUS] & MMC5883MA_STATUS_MEAS_M_DONE)) {
+            r = MSG_TIMEOUT;
+            break;
+        }
+        r = mmc5883maI2CWriteRegister(devp->config->i2cp, devp->config->saddr,
+                MMC5883MA_AD_STATUS, MMC5883MA_STATUS_MEAS_M_DONE_CLR);
+    } while (0);
 
-    osalDbgCheck(devp != NULL);
-    osalDbgAssert(devp->config->curr_lsb,
-            "mmc5883maReadCurrent(): invalid curr_lsb value");
+#if MMC5883MA_SHARED_I2C
+    i2cReleaseBus(devp->config->i2cp);
+#endif /* MMC5883MA_SHARED_I2C */
+#endif /* MMC5883MA_USE_I2C */
 
-    power = mmc5883maReadRaw(devp, MMC5883MA_AD_POWER) * devp->config->curr_lsb * 25;
+    if (r != MSG_OK)
+        return r;
 
-    return power;
+    for (int i = 0; i < 3; i++) {
+        raw[i] = buf[2 * i] | (buf[2 * i + 1] << 8);
+    }
+    dest->mag_x_raw = raw[0];
+    dest->mag_y_raw = raw[1];
+    dest->mag_z_raw = raw[2];
+    dest->mag_x = (((int32_t)raw[0] - devp->offset[0]) * 1000) / MMC5883MA_COUNTS_PER_GAUSS;
+    dest->mag_y = (((int32_t)raw[1] - devp->offset[1]) * 1000) / MMC5883MA_COUNTS_PER_GAUSS;
+    dest->mag_z = (((int32_t)raw[2] - devp->offset[2]) * 1000) / MMC5883MA_COUNTS_PER_GAUSS;
+    devp->samples++;
+
+    return MSG_OK;
 }
 
 /** @} */
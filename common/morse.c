@@ -1,5 +1,8 @@
+#include <ctype.h>
+#include <string.h>
+#include "ch.h"
+#include "hal.h"
 #include "morse.h"
-#include "ax5043.h"
 
 /**
  * @brief   Morse code for alphabets and numbers.
@@ -47,80 +50,157 @@ static const char *num[] = {
 };
 
 /**
- * @brief   Prepare for CW mode
+ * @brief   Convert an alphabet or number to morse dot and dash
  *
- * @param[in]  devp               pointer to the @p AX5043Driver object.
+ * @param[in]  letter             An alphabet or number.
  *
- * @api
+ * @return                        Length of packet received.
  */
-uint8_t ax5043_prepare_cw(AX5043Driver *devp){
-    ax5043WriteU24(devp, AX5043_REG_FSKDEV, 0x000000U);
-    ax5043WriteU24(devp, AX5043_REG_TXRATE, 0x000001U);
-
-    ax5043SetPWRMode(devp, AX5043_PWRMODE_TX_FULL);
-
-    /* This is not mentioned in datasheet or programming manual but is required.
-     * Removing this will make the transmission to transmit in low power for a few seconds
-     * before it reaches peak power */
-    /* FIFO reset */
-    ax5043WriteU8(devp, AX5043_REG_FIFOSTAT, AX5043_FIFOCMD_CLEAR_FIFODAT);
-    ax5043WriteU8(devp, AX5043_REG_FIFODATA, (AX5043_CHUNKCMD_REPEATDATA | _VAL2FLD(AX5043_FIFOCHUNK_SIZE, 3)));
-    /* Preamble flag */
-    ax5043WriteU8(devp, AX5043_REG_FIFODATA, AX5043_CHUNK_DATATX_UNENC | AX5043_CHUNK_DATATX_NOCRC);
-    ax5043WriteU8(devp, AX5043_REG_FIFODATA, 0xFF);
-    /* Preamble */
-    ax5043WriteU8(devp, AX5043_REG_FIFODATA, 0x55);
-    /* FIFO Commit */
-    ax5043WriteU8(devp, AX5043_REG_FIFOSTAT, 0x04);
-
-    ax5043SetPWRMode(devp, AX5043_PWRMODE_STANDBY);
-    devp->state = AX5043_CW;
-    return 0;
+const char *ax5043_ascii_to_morse(char letter){
+    letter = tolower(letter);
+
+    if (isalpha(letter)){
+        return alpha[letter-'a'];
+    }
+    else if (isdigit(letter)){
+        return num[letter-'0'];
+    }
+
+    return " ";
 }
 
 /**
- * @brief   Send Morse dot and dash over the air
+ * @brief   Append a key down or key up run, merging with the previous one.
  *
- * @param[in]  devp               pointer to the @p AX5043Driver object.
- * @param[in]  dot_dash_time      time in milliseconds for transmiter to be on.
+ * @return                        false if the schedule is full.
  */
-void ax5043_morse_dot_dash(AX5043Driver *devp, uint16_t dot_dash_time){
-    ax5043SetPWRMode(devp, AX5043_PWRMODE_TX_FULL);
-    ax5043WriteU8(devp, AX5043_REG_FIFODATA, (AX5043_CHUNKCMD_REPEATDATA | _VAL2FLD(AX5043_FIFOCHUNK_SIZE, 3)));
-    /* Preamble flag */
-    ax5043WriteU8(devp, AX5043_REG_FIFODATA, AX5043_CHUNK_DATATX_UNENC | AX5043_CHUNK_DATATX_NOCRC);
-    ax5043WriteU8(devp, AX5043_REG_FIFODATA, 0xFF);
-    /* Preamble */
-    ax5043WriteU8(devp, AX5043_REG_FIFODATA, 0x00);
-    /* FIFO Commit */
-    ax5043WriteU8(devp, AX5043_REG_FIFOSTAT, 0x04);
-    chThdSleepMilliseconds(dot_dash_time);
-    ax5043SetPWRMode(devp, AX5043_PWRMODE_STANDBY);
-
+static bool morse_run(morse_sched_t *sched, uint8_t key, unsigned dits) {
+    while (dits > 0) {
+        unsigned n;
+
+        if (sched->count > 0) {
+            uint8_t *last = &sched->runs[sched->count - 1];
+            unsigned room = MORSE_RUN_LEN - (*last & MORSE_RUN_LEN);
+            if ((*last & MORSE_RUN_KEY) == key && room > 0) {
+                n = (dits < room ? dits : room);
+                *last += n;
+                dits -= n;
+                continue;
+            }
+        }
+        if (sched->count == MORSE_MAX_RUNS) {
+            return false;
+        }
+        n = (dits < MORSE_RUN_LEN ? dits : MORSE_RUN_LEN);
+        sched->runs[sched->count++] = key | n;
+        dits -= n;
+    }
+    return true;
 }
 
 /**
- * @brief   Convert an alphabet or number to morse dot and dash
+ * @brief   Compile a message into a run-length keying schedule.
+ * @details Element, letter and word spacing follow the classic keyer: one
+ *          dit between elements, three after a letter and seven for a
+ *          space on top of that. Nothing is done if the message and speed
+ *          match the ones already compiled.
  *
- * @param[in]  letter             An alphabet or number.
+ * @param[out] sched              Schedule to build.
+ * @param[in]  wpm                Words per minute.
+ * @param[in]  msg                Message to be transmitted.
+ * @param[in]  len                Length of @p msg.
+ * @param[in]  xtal_freq          AX5043 crystal frequency in Hz.
  *
- * @return                        Length of packet received.
+ * @return                        true if the schedule was rebuilt.
+ * @api
  */
-const char *ax5043_ascii_to_morse(char letter){
-    letter = tolower(letter);
+bool morse_compile(morse_sched_t *sched, int wpm, const char *msg, size_t len, uint32_t xtal_freq) {
+    osalDbgCheck(sched != NULL && msg != NULL && wpm > 0 && wpm <= 1200);
 
-    if (isalpha(letter)){
-        return alpha[letter-'a'];
+    if (len > MORSE_MAX_MSG) {
+        len = MORSE_MAX_MSG;
     }
-    else if (isdigit(letter)){
-        return num[letter-'0'];
+    if (sched->count > 0 && sched->wpm == wpm && sched->msg_len == len &&
+            !memcmp(sched->msg, msg, len)) {
+        return false;
     }
 
-    return " ";
+    memcpy(sched->msg, msg, len);
+    sched->msg_len = len;
+    sched->wpm = wpm;
+    sched->dit_ms = 1200 / wpm;
+    sched->count = 0;
+
+    for (size_t i = 0; i < len; i++) {
+        const char *morse = ax5043_ascii_to_morse(msg[i]);
+        for (size_t e = 0; morse[e] != '\0'; e++) {
+            if (morse[e] == ' ') {
+                morse_run(sched, 0, 7);
+                continue;
+            }
+            morse_run(sched, MORSE_RUN_KEY, (morse[e] == '-' ? 3 : 1));
+            morse_run(sched, 0, (morse[e + 1] != '\0' ? 1 : 3));
+        }
+    }
+
+    /* One FIFO byte per dit: bitrate = 8 / dit, TXRATE = bitrate * 2^24 / f_xtal */
+    uint64_t div = (uint64_t)sched->dit_ms * xtal_freq;
+    sched->profile[0] = (ax5043_profile_t){AX5043_REG_MODULATION, AX5043_MODULATION_ASK, 1};
+    sched->profile[1] = (ax5043_profile_t){AX5043_REG_TXRATE, (((uint64_t)8000 << 24) + div / 2) / div, 3};
+    sched->profile[2] = (ax5043_profile_t){0, 0, 0};
+    return true;
+}
+
+/**
+ * @brief   Converts the next block of runs into REPEATDATA FIFO chunks.
+ * @note    Used as the @p ax5043TXRaw refill callback.
+ *
+ * @param[in]  arg                Pointer to the @p morse_sched_t object.
+ *
+ * @return                        Bytes of chunks written.
+ * @notapi
+ */
+size_t morse_fill(void *arg) {
+    morse_sched_t *sched = arg;
+    uint8_t *p = sched->chunks;
+
+    for (size_t n = 0; n < MORSE_BLOCK_RUNS && sched->pos < sched->count; n++) {
+        uint8_t run = sched->runs[sched->pos++];
+        *p++ = AX5043_CHUNKCMD_REPEATDATA | _VAL2FLD(AX5043_FIFOCHUNK_SIZE, 3);
+        *p++ = AX5043_CHUNK_REPEATDATA_UNENC | AX5043_CHUNK_REPEATDATA_NOCRC;
+        *p++ = run & MORSE_RUN_LEN;
+        *p++ = (run & MORSE_RUN_KEY ? 0xFF : 0x00);
+    }
+    return p - sched->chunks;
+}
+
+/**
+ * @brief   Transmit a compiled keying schedule.
+ * @details The carrier is ASK keyed by the FIFO data, so the whole message
+ *          streams through the FIFO in blocks instead of toggling power
+ *          modes and sleeping per element.
+ *
+ * @param[in]  devp               pointer to the @p AX5043Driver object.
+ * @param[in]  sched              Compiled schedule.
+ * @param[in]  chan_b             Use channel B if true.
+ *
+ * @api
+ */
+void morse_send(AX5043Driver *devp, morse_sched_t *sched, bool chan_b) {
+    osalDbgCheck(devp != NULL && sched != NULL);
+
+    if (sched->count == 0) {
+        return;
+    }
+    sched->pos = 0;
+    size_t len = morse_fill(sched);
+    ax5043TXRaw(devp, sched->profile, sched->chunks, len, sched->count * MORSE_CHUNK_LEN,
+            morse_fill, sched, chan_b);
 }
 
 /**
  * @brief   Convert a message to morse code and transmit it.
+ * @note    The schedule is only rebuilt when the message or speed changes.
  *
  * @param[in]  devp               pointer to the @p AX5043Driver object.
  * @param[in]  wpm                words per minute.
@@ -128,42 +208,8 @@ const char *ax5043_ascii_to_morse(char letter){
  * @param[in]  pktlen             Length of packet/beacon message.
  */
 void ax5043_send_cw(AX5043Driver *devp, int wpm, char beaconMessage[], uint16_t pktlen ){
-    int element;
-    int index = 0;
-    const char *morse;
-
-    uint16_t ditLength = 1200/wpm;
-    uint16_t letter_space = ditLength*3;
-    uint16_t word_space = ditLength*7;
-    uint16_t element_space = ditLength;
-    uint16_t dash = ditLength*3;
-
-    while (index < pktlen){
-        morse = ax5043_ascii_to_morse(beaconMessage[index]);
-
-        element = 0;
-        while (morse[element] != '\0'){
-            switch(morse[element]){
-            case '-':
-                ax5043_morse_dot_dash(devp, dash);
-                break;
-            case '.':
-                ax5043_morse_dot_dash(devp, ditLength);
-                break;
-            }
+    static morse_sched_t sched;
 
-            if (morse[element] == ' '){
-                chThdSleepMilliseconds(word_space);
-            }
-            else if (morse[element+1] != '\0'){
-                chThdSleepMilliseconds(element_space);
-            }
-            else if (morse[element+1] == '\0'){
-                chThdSleepMilliseconds(letter_space);
-            }
-            element++;
-        }
-
-        index++;
-    }
+    morse_compile(&sched, wpm, beaconMessage, pktlen, devp->config->xtal_freq);
+    morse_send(devp, &sched, false);
 }
@@ -8,18 +8,41 @@
 #define MGR_EVENT_OFFLINE           EVENT_MASK(4)
 #define MGR_EVENT_BOOT              EVENT_MASK(5)
 
+#ifndef NODE_MGR_INRUSH_MAX
+/* Number of nodes allowed to be in their power on inrush window at once */
+#define NODE_MGR_INRUSH_MAX         2
+#endif
+#ifndef NODE_MGR_INRUSH_TIME
+#define NODE_MGR_INRUSH_TIME        TIME_MS2I(250)
+#endif
+#ifndef NODE_MGR_BOOT_TIMEOUT
+/* Time from power on to first heartbeat before a node is power cycled */
+#define NODE_MGR_BOOT_TIMEOUT       TIME_S2I(90)
+#endif
+#define NODE_MGR_OFF_TIME           TIME_MS2I(500)
+#define NODE_MGR_ATTEMPTS           3
+
+#if OD_CNT_ARR_1016 > 32
+#error "node_mgr uses one event flag per heartbeat consumer"
+#endif
+
 typedef struct oresat_node_state {
     const oresat_node_t     *desc;
     CO_NMT_internalState_t  state;
+    node_phase_t            phase;
+    systime_t               since;
+    sysinterval_t           timeout;
     uint8_t                 attempts;
     bool                    enable;
+    bool                    retry;      /* Set by node_enable, taken by the manager */
 } node_state_t;
 
 /* TODO: Don't use extern, switch to some system config/object struct */
 extern CO_t *CO;
 
-node_state_t node_state[OD_CNT_HB_CONS];
+node_state_t node_state[OD_CNT_ARR_1016];
 EVENTSOURCE_DECL(mgr_change_event);
+static thread_t *mgr_tp;
 
 void node_change_cb(uint8_t nodeId, uint8_t idx, CO_NMT_internalState_t state, void *object)
 {
@@ -28,20 +51,160 @@ void node_change_cb(uint8_t nodeId, uint8_t idx, CO_NMT_internalState_t state, v
     syssts_t sts;
     sts = chSysGetStatusAndLockX();
     node->state = state;
-    chEvtBroadcastFlagsI(&mgr_change_event, idx);
+    chEvtBroadcastFlagsI(&mgr_change_event, 1U << idx);
     chSysRestoreStatusX(sts);
 }
 
+static void node_set_phase(node_state_t *node, node_phase_t phase, sysinterval_t timeout)
+{
+    node->phase = phase;
+    node->since = chVTGetSystemTime();
+    node->timeout = timeout;
+}
+
+/* Power cycle a node that failed to come up, or give up on it */
+static void node_recover(node_state_t *node)
+{
+    opd_enable(node->desc->opd_addr, false);
+    if (node->attempts < NODE_MGR_ATTEMPTS) {
+        node->attempts++;
+        node_set_phase(node, NODE_BACKOFF, NODE_MGR_OFF_TIME);
+    } else {
+        node_set_phase(node, NODE_FAILED, 0);
+    }
+}
+
+static void node_heartbeat(node_state_t *node)
+{
+    if (node->desc == NULL || node->desc->opd_addr == 0x00 || !node->enable)
+        return;
+
+    switch (node->state) {
+    case CO_NMT_UNKNOWN:
+        if (node->phase == NODE_UP)
+            node_recover(node);
+        break;
+    case CO_NMT_PRE_OPERATIONAL:
+    case CO_NMT_OPERATIONAL:
+        if (node->phase == NODE_INRUSH || node->phase == NODE_BOOTING) {
+            node_set_phase(node, NODE_UP, 0);
+            node->attempts = 0;
+        }
+        break;
+    default:
+        break;
+    }
+}
+
+/* Advance every node's state machine, returning the time until the next deadline */
+static sysinterval_t node_step(void)
+{
+    sysinterval_t next = TIME_INFINITE;
+    int inrush = 0;
+
+    for (int i = 0; i < OD_CNT_ARR_1016; i++) {
+        if (node_state[i].phase == NODE_INRUSH)
+            inrush++;
+    }
+
+    for (int i = 0; i < OD_CNT_ARR_1016; i++) {
+        node_state_t *node = &node_state[i];
+        bool expired = chVTTimeElapsedSinceX(node->since) >= node->timeout;
+
+        if (node->desc == NULL || node->desc->opd_addr == 0x00)
+            continue;
+
+        if (!node->enable) {
+            node->retry = false;
+            if (node->phase != NODE_OFF) {
+                opd_enable(node->desc->opd_addr, false);
+                node_set_phase(node, NODE_OFF, 0);
+            }
+            continue;
+        }
+        /* Re-enabling a node that gave up gives it a fresh set of attempts */
+        if (node->retry) {
+            node->retry = false;
+            if (node->phase == NODE_FAILED)
+                node_set_phase(node, NODE_OFF, 0);
+        }
+
+        switch (node->phase) {
+        case NODE_OFF:
+            node->attempts = 0;
+            node_set_phase(node, NODE_QUEUED, 0);
+            /* Fall through */
+        case NODE_QUEUED:
+            if (inrush >= NODE_MGR_INRUSH_MAX)
+                break;
+            if (opd_enable(node->desc->opd_addr, true) != 0) {
+                node_set_phase(node, NODE_FAILED, 0);
+                break;
+            }
+            inrush++;
+            node_set_phase(node, NODE_INRUSH, NODE_MGR_INRUSH_TIME);
+            break;
+        case NODE_INRUSH:
+            if (expired) {
+                inrush--;
+                node_set_phase(node, NODE_BOOTING, NODE_MGR_BOOT_TIMEOUT - NODE_MGR_INRUSH_TIME);
+            }
+            break;
+        case NODE_BOOTING:
+            if (expired)
+                node_recover(node);
+            break;
+        case NODE_BACKOFF:
+            if (expired)
+                node_set_phase(node, NODE_QUEUED, 0);
+            break;
+        case NODE_UP:
+        case NODE_FAILED:
+        default:
+            break;
+        }
+    }
+
+    for (int i = 0; i < OD_CNT_ARR_1016; i++) {
+        node_state_t *node = &node_state[i];
+        sysinterval_t elapsed = chVTTimeElapsedSinceX(node->since);
+        sysinterval_t left;
+
+        if (node->desc == NULL || !node->enable)
+            continue;
+        /* A node that left its inrush window may let a queued one start */
+        if (node->phase == NODE_QUEUED && inrush < NODE_MGR_INRUSH_MAX)
+            return TIME_IMMEDIATE;
+        if (node->phase == NODE_INRUSH || node->phase == NODE_BOOTING || node->phase == NODE_BACKOFF) {
+            left = (elapsed < node->timeout ? node->timeout - elapsed : TIME_IMMEDIATE);
+            if (next == TIME_INFINITE || left < next)
+                next = left;
+        }
+    }
+
+    return next;
+}
+
 THD_WORKING_AREA(node_mgr_wa, 0x400);
 THD_FUNCTION(node_mgr, arg)
 {
     const oresat_node_t *node = arg;
     event_listener_t mgr_change_el;
     eventmask_t event;
-    eventflags_t idx;
+    eventflags_t flags;
+    sysinterval_t timeout;
+    i2caddr_t opd_addrs[OD_CNT_ARR_1016];
+    size_t opd_cnt = 0;
 
+    mgr_tp = chThdGetSelfX();
+
+    /* Bring up known cards first, the rest of the OPD bus is scanned in the background */
+    for (int i = 0; node[i].id != 0 && opd_cnt < OD_CNT_ARR_1016; i++) {
+        if (node[i].opd_addr != 0x00)
+            opd_addrs[opd_cnt++] = node[i].opd_addr;
+    }
     opd_init();
-    opd_start();
+    opd_start_expected(opd_addrs, opd_cnt);
 
     for (int i = 0; node[i].id != 0; i++) {
         OD_IO_t hbcons_io;
@@ -50,6 +213,7 @@ THD_FUNCTION(node_mgr, arg)
         OD_getSub(OD_ENTRY_H1016_consumerHeartbeatTime, i + 1, &hbcons_io, false);
         hbcons_io.write(&hbcons_io.stream, &hbcons_entry, sizeof(hbcons_entry), &count);
         node_state[i].desc = &node[i];
+        node_state[i].phase = NODE_OFF;
         node_state[i].attempts = 0;
         if (node[i].opd_addr == 0x00 || node[i].autostart)
             node_enable(node[i].id, true);
@@ -57,43 +221,29 @@ THD_FUNCTION(node_mgr, arg)
 
     chEvtRegisterMaskWithFlags(&mgr_change_event, &mgr_change_el, MGR_EVENT_CHANGE, ALL_EVENTS);
 
+    /* Nodes power up and recover concurrently, limited only by the inrush window */
+    timeout = node_step();
     while (!chThdShouldTerminateX()) {
-        event = chEvtWaitAnyTimeout(MGR_EVENT_WAKEUP | MGR_EVENT_TERMINATE | MGR_EVENT_CHANGE, TIME_INFINITE);
+        event = chEvtWaitAnyTimeout(MGR_EVENT_WAKEUP | MGR_EVENT_TERMINATE | MGR_EVENT_CHANGE, timeout);
         if (event & MGR_EVENT_TERMINATE)
             continue;
         if (event & MGR_EVENT_CHANGE) {
-            idx = chEvtGetAndClearFlags(&mgr_change_el);
-            node_state_t *node =  &node_state[idx];
-            switch (node->state) {
-            case CO_NMT_UNKNOWN:
-                if (node->desc->opd_addr && node->enable) {
-                    if (node->attempts < 3) {
-                        node_enable(node->desc->id, false);
-                        chThdSleepMilliseconds(500);
-                        node_enable(node->desc->id, true);
-                        node->attempts++;
-                    } else {
-                        node_enable(node->desc->id, false);
-                    }
-                }
-                break;
-            case CO_NMT_INITIALIZING:
-                break;
-            case CO_NMT_PRE_OPERATIONAL:
-            case CO_NMT_OPERATIONAL:
-                node->attempts = 0;
-                break;
-            case CO_NMT_STOPPED:
-                break;
-            default:
-                break;
+            flags = chEvtGetAndClearFlags(&mgr_change_el);
+            for (int i = 0; flags != 0; i++, flags >>= 1) {
+                if (flags & 1U)
+                    node_heartbeat(&node_state[i]);
             }
         }
+        timeout = node_step();
     }
 
     chEvtUnregister(&mgr_change_event, &mgr_change_el);
+    mgr_tp = NULL;
     for (int i = 0; node[i].id != 0; i++) {
         node_enable(node[i].id, false);
+        if (node[i].opd_addr)
+            opd_enable(node[i].opd_addr, false);
+        node_state[i].phase = NODE_OFF;
         OD_IO_t hbcons_io;
         uint32_t hbcons_entry = 0;
         OD_size_t count;
@@ -115,12 +265,25 @@ int node_enable(uint8_t id, bool enable)
     } else {
         CO_HBconsumer_initCallbackNmtChanged(CO->HBcons, idx, NULL, NULL);
     }
-    if (node->desc->opd_addr) {
-        return opd_enable(node->desc->opd_addr, enable);
-    }
+    /* The phase belongs to the manager, a failed node is restarted there */
+    if (enable)
+        node->retry = true;
+    /* Powering is done by the manager so it can respect the inrush limit */
+    if (mgr_tp != NULL)
+        chEvtSignal(mgr_tp, MGR_EVENT_WAKEUP);
     return 0;
 }
 
+node_phase_t node_phase(uint8_t id, uint8_t *attempts)
+{
+    int8_t idx = CO_HBconsumer_getIdxByNodeId(CO->HBcons, id);
+    if (idx < 0)
+        return NODE_OFF;
+    if (attempts)
+        *attempts = node_state[idx].attempts;
+    return node_state[idx].phase;
+}
+
 int node_status(uint8_t id, CO_NMT_internalState_t *state)
 {
     int8_t idx = CO_HBconsumer_getIdxByNodeId(CO->HBcons, id);
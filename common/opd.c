@@ -4,6 +4,8 @@
 
 #define OPD_RESET_TIME      250
 #define OPD_I2C_TRIES       3
+/* A present MAX7310 answers a 1 byte read in well under 1 ms at 100 kHz */
+#define OPD_PROBE_TIMEOUT   TIME_MS2I(2)
 
 static struct {
     MAX7310Driver dev;
@@ -11,6 +13,13 @@ static struct {
     bool valid;
 } opd_dev[OPD_MAX_ADDR + 1];
 
+/* Held around every access to opd_dev and the devices behind it */
+static MUTEX_DECL(opd_lock);
+static thread_t *scan_tp;
+static THD_WORKING_AREA(opd_scan_wa, 0x200);
+
+static bool opd_probe_locked(i2caddr_t addr, bool restart);
+
 static const I2CConfig i2cconfig = {
     OPMODE_I2C,
     100000,
@@ -41,7 +50,7 @@ void opd_init(void)
     }
 }
 
-void opd_start(void)
+static void opd_power_on(void)
 {
 #ifdef LINE_OPD_ENABLE
     /* Enable the subsystem if the device has a control line */
@@ -51,17 +60,79 @@ void opd_start(void)
 
     /* Start the I2C driver */
     i2cStart(&I2CD1, &i2cconfig);
+}
+
+/* Address only probe, returns true if a device ACKed */
+static bool opd_ping(i2caddr_t addr)
+{
+    msg_t result;
+    uint8_t temp;
+
+    i2cAcquireBus(&I2CD1);
+    /* A timeout leaves the driver locked, only restart it when needed */
+    if (I2CD1.state != I2C_READY) {
+        i2cStart(&I2CD1, &i2cconfig);
+    }
+    result = i2cMasterReceiveTimeout(&I2CD1, addr, &temp, 1, OPD_PROBE_TIMEOUT);
+    i2cReleaseBus(&I2CD1);
+
+    return result == MSG_OK;
+}
+
+/* Background rescan of every address not already known to be present */
+static THD_FUNCTION(opd_scan_thd, arg)
+{
+    (void)arg;
+
+    for (i2caddr_t i = MAX7310_MIN_ADDR; i <= MAX7310_MAX_ADDR && !chThdShouldTerminateX(); i++) {
+        chMtxLock(&opd_lock);
+        if (opd_dev[i].valid != true) {
+            opd_probe_locked(i, false);
+        }
+        chMtxUnlock(&opd_lock);
+    }
+
+    chThdExit(MSG_OK);
+}
+
+void opd_start(void)
+{
+    opd_power_on();
     /* Probe all devices on the bus */
     opd_scan(true);
 }
 
+/* Probe expected devices first and scan the rest of the bus in the background */
+size_t opd_start_expected(const i2caddr_t *addrs, size_t count)
+{
+    size_t found;
+
+    opd_power_on();
+    found = opd_scan_addrs(addrs, count, true);
+    opd_scan_background();
+
+    return found;
+}
+
 void opd_stop(void)
 {
+    /* Stop any background scan before tearing down the bus */
+    if (scan_tp != NULL) {
+        chThdTerminate(scan_tp);
+        chThdWait(scan_tp);
+        scan_tp = NULL;
+    }
     /* Forcefully disable all devices */
+    chMtxLock(&opd_lock);
     for (i2caddr_t i = MAX7310_MIN_ADDR; i <= MAX7310_MAX_ADDR; i++) {
+        /* max7310Stop() stops the driver after each device */
+        if (I2CD1.state != I2C_READY) {
+            i2cStart(&I2CD1, &i2cconfig);
+        }
         max7310Stop(&opd_dev[i].dev);
         opd_dev[i].valid = false;
     }
+    chMtxUnlock(&opd_lock);
     /* Stop the I2C driver */
     i2cStop(&I2CD1);
 #ifdef LINE_OPD_ENABLE
@@ -77,17 +148,42 @@ void opd_scan(bool restart)
     }
 }
 
-bool opd_probe(i2caddr_t addr, bool restart)
+/* Probe only the listed addresses, returning how many responded */
+size_t opd_scan_addrs(const i2caddr_t *addrs, size_t count, bool restart)
 {
-    msg_t result;
-    uint8_t temp;
+    size_t found = 0;
+
+    for (size_t i = 0; i < count; i++) {
+        if (addrs[i] >= MAX7310_MIN_ADDR && addrs[i] <= MAX7310_MAX_ADDR && opd_probe(addrs[i], restart)) {
+            found++;
+        }
+    }
+
+    return found;
+}
+
+/* Does nothing if a background scan is already running */
+void opd_scan_background(void)
+{
+    if (scan_tp != NULL) {
+        if (!chThdTerminatedX(scan_tp)) {
+            return;
+        }
+        chThdWait(scan_tp);
+    }
+    scan_tp = chThdCreateStatic(opd_scan_wa, sizeof(opd_scan_wa), NORMALPRIO - 1, opd_scan_thd, NULL);
+}
 
+bool opd_scan_busy(void)
+{
+    return scan_tp != NULL && !chThdTerminatedX(scan_tp);
+}
+
+/* Caller holds opd_lock */
+static bool opd_probe_locked(i2caddr_t addr, bool restart)
+{
     /* Probe the device */
-    i2cAcquireBus(&I2CD1);
-    i2cStart(&I2CD1, &i2cconfig);
-    result = i2cMasterReceiveTimeout(&I2CD1, addr, &temp, 1, TIME_MS2I(10));
-    i2cReleaseBus(&I2CD1);
-    if (result == MSG_OK) {
+    if (opd_ping(addr)) {
         /* If a device responded, set as valid and (re)start if needed */
         if (opd_dev[addr].valid != true || restart) {
             max7310Stop(&opd_dev[addr].dev);
@@ -104,10 +200,23 @@ bool opd_probe(i2caddr_t addr, bool restart)
     return opd_dev[addr].valid;
 }
 
+bool opd_probe(i2caddr_t addr, bool restart)
+{
+    bool valid;
+
+    chMtxLock(&opd_lock);
+    valid = opd_probe_locked(addr, restart);
+    chMtxUnlock(&opd_lock);
+
+    return valid;
+}
+
 int opd_enable(i2caddr_t addr, bool enable)
 {
+    chMtxLock(&opd_lock);
     /* Ensure device is valid */
     if (opd_dev[addr].valid != true) {
+        chMtxUnlock(&opd_lock);
         return -1;
     }
 
@@ -116,27 +225,34 @@ int opd_enable(i2caddr_t addr, bool enable)
     } else {
         max7310ClearPin(&opd_dev[addr].dev, OPD_EN);
     }
+    chMtxUnlock(&opd_lock);
 
     return 0;
 }
 
 int opd_reset(i2caddr_t addr)
 {
+    chMtxLock(&opd_lock);
     /* Ensure device is valid */
     if (opd_dev[addr].valid != true) {
+        chMtxUnlock(&opd_lock);
         return -1;
     }
 
+    /* Held across the pulse so a rescan cannot restart the device midway */
     max7310SetPin(&opd_dev[addr].dev, OPD_CB_RESET);
     chThdSleepMilliseconds(OPD_RESET_TIME);
     max7310ClearPin(&opd_dev[addr].dev, OPD_CB_RESET);
+    chMtxUnlock(&opd_lock);
     return 0;
 }
 
 int opd_status(i2caddr_t addr, opd_status_t *status)
 {
+    chMtxLock(&opd_lock);
     /* Ensure device is valid */
     if (opd_dev[addr].valid != true) {
+        chMtxUnlock(&opd_lock);
         return -1;
     }
 
@@ -145,17 +261,24 @@ int opd_status(i2caddr_t addr, opd_status_t *status)
     status->pol = max7310ReadRaw(&opd_dev[addr].dev, MAX7310_AD_POL);
     status->mode = max7310ReadRaw(&opd_dev[addr].dev, MAX7310_AD_MODE);
     status->timeout = max7310ReadRaw(&opd_dev[addr].dev, MAX7310_AD_TIMEOUT);
+    chMtxUnlock(&opd_lock);
     return 0;
 }
 
 /**
  * I2C over OPD support functions
  */
+/*
+ * SCL and SDA are emulated open drain: the output register holds them low and
+ * the mode register switches between driving low (output) and released
+ * (input). The mode register is shadowed by the driver, so each edge is one
+ * register write and the bus is only read back when sampling.
+ */
 void opd_i2c_start(MAX7310Driver *devp)
 {
     uint8_t reg;
 
-    reg = max7310ReadRaw(devp, MAX7310_AD_MODE);
+    reg = max7310GetMode(devp);
     reg &= ~MAX7310_PIN_MASK(OPD_SDA);
     max7310WriteRaw(devp, MAX7310_AD_MODE, reg);
     reg &= ~MAX7310_PIN_MASK(OPD_SCL);
@@ -166,7 +289,7 @@ void opd_i2c_stop(MAX7310Driver *devp)
 {
     uint8_t reg;
 
-    reg = max7310ReadRaw(devp, MAX7310_AD_MODE);
+    reg = max7310GetMode(devp);
     reg &= ~(MAX7310_PIN_MASK(OPD_SCL) | MAX7310_PIN_MASK(OPD_SDA));
     max7310WriteRaw(devp, MAX7310_AD_MODE, reg);
     reg |= MAX7310_PIN_MASK(OPD_SCL);
@@ -175,11 +298,13 @@ void opd_i2c_stop(MAX7310Driver *devp)
     max7310WriteRaw(devp, MAX7310_AD_MODE, reg);
 }
 
-void opd_i2c_transmit(i2caddr_t addr, uint8_t *txbuf, size_t txsize, uint8_t *rxbuf, size_t rxsize)
+/* Caller holds opd_lock */
+static void opd_i2c_transmit_locked(i2caddr_t addr, uint8_t *txbuf, size_t txsize, uint8_t *rxbuf, size_t rxsize)
 {
     MAX7310Driver *devp;
     uint8_t tries;
     uint8_t reg;
+    uint8_t in;
 
     if (opd_dev[addr].valid != true)
         return;
@@ -188,6 +313,7 @@ void opd_i2c_transmit(i2caddr_t addr, uint8_t *txbuf, size_t txsize, uint8_t *rx
 
     /* Assert start condition on I2C */
     opd_i2c_start(devp);
+    reg = max7310GetMode(devp);
 
     /* Transmit all bytes */
     for (size_t i = 0; i < txsize; i++) {
@@ -195,7 +321,7 @@ void opd_i2c_transmit(i2caddr_t addr, uint8_t *txbuf, size_t txsize, uint8_t *rx
 
         /* Transmit 8 bits per byte */
         for (int j = 0; j < 8; j++) {
-            reg = max7310ReadRaw(devp, MAX7310_AD_MODE);
+            reg = max7310GetMode(devp);
 
             /* Set SDA based on MSB of byte */
             reg = (reg & ~MAX7310_PIN_MASK(OPD_SDA)) | ((byte & 0x80) ? MAX7310_PIN_MASK(OPD_SDA) : 0);
@@ -217,12 +343,13 @@ void opd_i2c_transmit(i2caddr_t addr, uint8_t *txbuf, size_t txsize, uint8_t *rx
         max7310WriteRaw(devp, MAX7310_AD_MODE, reg);
         reg |= MAX7310_PIN_MASK(OPD_SCL);
         max7310WriteRaw(devp, MAX7310_AD_MODE, reg);
-        while (!(max7310ReadRaw(devp, MAX7310_AD_INPUT) & MAX7310_PIN_MASK(OPD_SCL)));
-        while ((max7310ReadRaw(devp, MAX7310_AD_INPUT) & MAX7310_PIN_MASK(OPD_SDA)) && tries)
-            tries--;
+        /* The read that sees SCL released also samples the ACK */
+        while (!((in = max7310ReadRaw(devp, MAX7310_AD_INPUT)) & MAX7310_PIN_MASK(OPD_SCL)));
+        while ((in & MAX7310_PIN_MASK(OPD_SDA)) && tries--)
+            in = max7310ReadRaw(devp, MAX7310_AD_INPUT);
         reg &= ~(MAX7310_PIN_MASK(OPD_SCL) | MAX7310_PIN_MASK(OPD_SDA));
         max7310WriteRaw(devp, MAX7310_AD_MODE, reg);
-        if (tries == 0)
+        if (in & MAX7310_PIN_MASK(OPD_SDA))
             goto opd_i2c_fail;
     }
 
@@ -258,6 +385,13 @@ opd_i2c_fail:
     return;
 }
 
+void opd_i2c_transmit(i2caddr_t addr, uint8_t *txbuf, size_t txsize, uint8_t *rxbuf, size_t rxsize)
+{
+    chMtxLock(&opd_lock);
+    opd_i2c_transmit_locked(addr, txbuf, txsize, rxbuf, rxsize);
+    chMtxUnlock(&opd_lock);
+}
+
 int opd_boot(i2caddr_t addr)
 {
     MAX7310Driver *devp;
@@ -265,8 +399,11 @@ int opd_boot(i2caddr_t addr)
     uint8_t rxbuf[10];
     int retval;
 
-    if (opd_dev[addr].valid != true)
+    chMtxLock(&opd_lock);
+    if (opd_dev[addr].valid != true) {
+        chMtxUnlock(&opd_lock);
         return -1;
+    }
     devp = &opd_dev[addr].dev;
 
     max7310ClearPin(devp, OPD_EN);
@@ -277,28 +414,36 @@ int opd_boot(i2caddr_t addr)
     txbuf[0] = 0x82U;
     txbuf[1] = 0x01U;
     txbuf[2] = 0xFEU;
-    opd_i2c_transmit(addr, txbuf, 3, NULL, 0);
+    opd_i2c_transmit_locked(addr, txbuf, 3, NULL, 0);
 
     txbuf[0] = 0x83U;
-    opd_i2c_transmit(addr, txbuf, 1, rxbuf, 1);
-    if (rxbuf[0] != 0x79)
-        return rxbuf[0];
+    opd_i2c_transmit_locked(addr, txbuf, 1, rxbuf, 1);
+    if (rxbuf[0] != 0x79) {
+        retval = rxbuf[0];
+        goto out;
+    }
 
-    opd_i2c_transmit(addr, txbuf, 1, rxbuf, 1);
+    opd_i2c_transmit_locked(addr, txbuf, 1, rxbuf, 1);
     retval = rxbuf[0];
 
-    opd_i2c_transmit(addr, txbuf, 1, rxbuf, 1);
-    if (rxbuf[0] != 0x79)
-        return rxbuf[0];
+    opd_i2c_transmit_locked(addr, txbuf, 1, rxbuf, 1);
+    if (rxbuf[0] != 0x79) {
+        retval = rxbuf[0];
+        goto out;
+    }
 
     max7310ClearPin(devp, OPD_BOOT0);
 
+out:
+    chMtxUnlock(&opd_lock);
     return retval;
 }
 
 int opd_linux_recover(i2caddr_t addr, bool enable)
 {
+    chMtxLock(&opd_lock);
     if (opd_dev[addr].valid != true) {
+        chMtxUnlock(&opd_lock);
         return -1;
     }
 
@@ -307,6 +452,7 @@ int opd_linux_recover(i2caddr_t addr, bool enable)
     } else {
         max7310SetPin(&opd_dev[addr].dev, OPD_LINUX_BOOT);
     }
+    chMtxUnlock(&opd_lock);
     return 0;
 
 }
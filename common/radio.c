@@ -9,6 +9,7 @@
 #include "ch.h"
 #include "hal.h"
 #include "radio.h"
+#include "fec.h"
 
 /*===========================================================================*/
 /* Local definitions.                                                        */
@@ -18,22 +19,60 @@
 /* Exported variables.                                                       */
 /*===========================================================================*/
 
+/* Frame buffer pool for received frames, transmit pools belong to radio_devices */
+pdu_queue_t rx_queue;
+
 /*===========================================================================*/
 /* Local variables and types.                                                */
 /*===========================================================================*/
 
-/* Frame buffer allocation pool */
-objects_fifo_t rx_fifo;
-static msg_t rx_fifo_msgs[RADIO_FIFO_COUNT];
-static fb_t rx_fifo_buf[RADIO_FIFO_COUNT];
-objects_fifo_t tx_fifo;
-static msg_t tx_fifo_msgs[RADIO_FIFO_COUNT];
-static fb_t tx_fifo_buf[RADIO_FIFO_COUNT];
-
 /*===========================================================================*/
 /* Local functions.                                                          */
 /*===========================================================================*/
 
+static void pdu_queue_init(pdu_queue_t *q) {
+    chFifoObjectInit(&q->fifo, sizeof(fb_t), RADIO_FIFO_COUNT, q->buf, q->msgs);
+    memset(q->stamp, 0, sizeof(q->stamp));
+    memset(&q->stats, 0, sizeof(q->stats));
+}
+
+/* Queue bookkeeping for one of the radio pools, NULL for anything else */
+static pdu_queue_t *pdu_queue(void *arg) {
+    if (arg == &rx_queue.fifo) {
+        return &rx_queue;
+    }
+    for (int i = 0; radio_devices[i].devp != NULL; i++) {
+        pdu_queue_t *q = radio_devices[i].txq;
+        if (q != NULL && arg == &q->fifo) {
+            return q;
+        }
+    }
+    return NULL;
+}
+
+/* Send time slot of a buffer, NULL when it does not belong to the queue's pool */
+static rtcnt_t *pdu_stamp(pdu_queue_t *q, fb_t *fb) {
+    if (fb < q->buf || fb >= q->buf + RADIO_FIFO_COUNT) {
+        return NULL;
+    }
+    return &q->stamp[fb - q->buf];
+}
+
+/* Record a send, called with the kernel locked after the object is posted */
+static void pdu_stamp_sendI(fb_t *fb, void *arg) {
+    pdu_queue_t *q = pdu_queue(arg);
+    rtcnt_t *stamp;
+    if (q == NULL || (stamp = pdu_stamp(q, fb)) == NULL) {
+        return;
+    }
+    cnt_t depth = chMBGetUsedCountI(&q->fifo.mbx);
+    *stamp = chSysGetRealtimeCounterX();
+    q->stats.sent++;
+    if ((uint32_t)depth > q->stats.depth_max) {
+        q->stats.depth_max = depth;
+    }
+}
+
 /*===========================================================================*/
 /* Interface implementation.                                                 */
 /*===========================================================================*/
@@ -42,6 +81,15 @@ fb_t *__fb_alloc(size_t len, void *arg) {
     (void)len;
     osalDbgCheck(arg != NULL);
     objects_fifo_t *fifo = arg;
+    pdu_queue_t *q = pdu_queue(arg);
+    if (q != NULL) {
+        /* Count allocations that will block on an exhausted pool */
+        chSysLock();
+        if (chSemGetCounterI(&fifo->free.sem) <= 0) {
+            q->stats.pool_empty++;
+        }
+        chSysUnlock();
+    }
     fb_t *fb = chFifoTakeObjectTimeout(fifo, TIME_INFINITE);
     memset(fb, 0, sizeof(fb_t));
     return fb;
@@ -59,9 +107,16 @@ void __fb_free(fb_t *fb, void *arg) {
 
 void radio_init(void)
 {
-    /* Initialize frame buffer FIFO */
-    chFifoObjectInit(&rx_fifo, sizeof(fb_t), RADIO_FIFO_COUNT, rx_fifo_buf, rx_fifo_msgs);
-    chFifoObjectInit(&tx_fifo, sizeof(fb_t), RADIO_FIFO_COUNT, tx_fifo_buf, tx_fifo_msgs);
+    /* Initialize frame buffer FIFOs, one for receive and one per transmitter */
+    pdu_queue_init(&rx_queue);
+    for (int i = 0; radio_devices[i].devp != NULL; i++) {
+        if (radio_devices[i].txq != NULL) {
+            pdu_queue_init(radio_devices[i].txq);
+        }
+    }
+
+    /* Build FEC encoder tables */
+    fec_init();
 
     /* Initialize radio systems */
     for (int i = 0; radio_devices[i].devp != NULL; i++) {
@@ -93,18 +148,43 @@ void radio_stop(void)
     }
 }
 
+/**
+ * @brief   Transmit frame buffer pool of a radio.
+ *
+ * @param[in]  devp     radio from @p radio_devices
+ * @return              the queue to allocate and send its frames on, NULL if
+ *                      the radio has none
+ */
+objects_fifo_t *radio_tx_fifo(const AX5043Driver *devp)
+{
+    for (int i = 0; radio_devices[i].devp != NULL; i++) {
+        if (radio_devices[i].devp == devp && radio_devices[i].txq != NULL) {
+            return &radio_devices[i].txq->fifo;
+        }
+    }
+    return NULL;
+}
+
 void pdu_send(fb_t *fb, void *arg)
 {
     osalDbgCheck(fb != NULL && arg != NULL);
     objects_fifo_t *fifo = arg;
-    chFifoSendObject(fifo, fb);
+    chSysLock();
+    chFifoSendObjectI(fifo, fb);
+    pdu_stamp_sendI(fb, arg);
+    chSchRescheduleS();
+    chSysUnlock();
 }
 
 void pdu_send_ahead(fb_t *fb, void *arg)
 {
     osalDbgCheck(fb != NULL && arg != NULL);
     objects_fifo_t *fifo = arg;
-    chFifoSendObjectAhead(fifo, fb);
+    chSysLock();
+    chFifoSendObjectAheadI(fifo, fb);
+    pdu_stamp_sendI(fb, arg);
+    chSchRescheduleS();
+    chSysUnlock();
 }
 
 fb_t *pdu_recv(void *arg)
@@ -113,9 +193,56 @@ fb_t *pdu_recv(void *arg)
     fb_t *fb;
     objects_fifo_t *fifo = arg;
     if (chFifoReceiveObjectTimeout(fifo, (void**)&fb, TIME_MS2I(1000)) != MSG_OK) {
-        fb = NULL;
+        return NULL;
+    }
+
+    pdu_queue_t *q = pdu_queue(arg);
+    rtcnt_t *stamp;
+    if (q != NULL && (stamp = pdu_stamp(q, fb)) != NULL) {
+        chSysLock();
+        rtcnt_t wait = chSysGetRealtimeCounterX() - *stamp;
+        q->stats.received++;
+        q->stats.wait_sum += wait;
+        if (wait > q->stats.wait_max) {
+            q->stats.wait_max = wait;
+        }
+        chSysUnlock();
     }
     return fb;
 }
 
+/**
+ * @brief   Snapshot the queue statistics of a radio frame buffer pool.
+ *
+ * @param[in]  arg      @p rx_queue or a radio transmit queue FIFO
+ * @param[out] stats    statistics, zeroed for any other queue
+ */
+void pdu_get_stats(void *arg, pdu_stats_t *stats)
+{
+    osalDbgCheck(stats != NULL);
+    pdu_queue_t *q = pdu_queue(arg);
+    chSysLock();
+    if (q != NULL) {
+        *stats = q->stats;
+    } else {
+        memset(stats, 0, sizeof(*stats));
+    }
+    chSysUnlock();
+}
+
+/**
+ * @brief   Clear the queue statistics of a radio frame buffer pool.
+ *
+ * @param[in]  arg      @p rx_queue or a radio transmit queue FIFO
+ */
+void pdu_reset_stats(void *arg)
+{
+    pdu_queue_t *q = pdu_queue(arg);
+    if (q != NULL) {
+        chSysLock();
+        memset(&q->stats, 0, sizeof(q->stats));
+        chSysUnlock();
+    }
+}
+
 /** @} */
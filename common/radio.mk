@@ -8,6 +8,8 @@ include $(PROJ_SRC)/aprs.mk
 
 # List of all the RADIO device files.
 RADIOSRC := $(PROJ_SRC)/radio.c     \
+            $(PROJ_SRC)/fec.c       \
+            $(PROJ_SRC)/morse.c     \
 
 # Required include directories
 RADIOINC := $(PROJ_SRC)/include
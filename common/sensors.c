@@ -10,24 +10,91 @@ typedef struct {
     adcsample_t vrefint;
 } sensors_t;
 
-sensors_t sensors[2];
+/* Circular DMA buffer, each half holds SENSORS_OVERSAMPLE sequences */
+static sensors_t sensors[SENSORS_OVERSAMPLE * 2];
+/* Running averages, fixed point with SENSORS_FILTER_SHIFT fractional bits */
+static uint32_t ts_filt;
+static uint32_t vrefint_filt;
+static bool filt_valid;
+static sensors_data_t sensors_data;
+/* Processes completed half buffers, NULL while sampling is stopped */
+static thread_t *sensors_tp;
 
-static void sensors_cb(ADCDriver *adcp)
+#define SENSORS_EVENT_HALF          EVENT_MASK(0)
+#define SENSORS_EVENT_FULL          EVENT_MASK(1)
+#define SENSORS_EVENT_TERMINATE     EVENT_MASK(2)
+
+/* Averages a half buffer into the filters and publishes the result */
+static void sensors_process(const sensors_t *half)
 {
-    sensors_t *sensors = (sensors_t*)adcp->samples;
-    int16_t temperature;
-    int16_t vdda;
-    int i = adcIsBufferComplete(adcp);
+    uint32_t ts_sum = 0, vrefint_sum = 0;
+    uint32_t ts, vrefint;
+    int32_t temperature;
+    uint32_t vdda;
+
+    /* Software oversampling across the completed half buffer */
+    for (int i = 0; i < SENSORS_OVERSAMPLE; i++) {
+        ts_sum += half[i].ts;
+        vrefint_sum += half[i].vrefint;
+    }
+    ts = ts_sum / SENSORS_OVERSAMPLE;
+    vrefint = vrefint_sum / SENSORS_OVERSAMPLE;
 
-    vdda = VREFINT_CAL_VOLT * VREFINT_CAL_VAL / sensors[i].vrefint;
-    temperature = ((sensors[i].ts * VREFINT_CAL_VAL * 10 / sensors[i].vrefint) - TS_CAL1_VAL * 10);
+    /* Exponential running average, seeded with the first result */
+    if (!filt_valid) {
+        ts_filt = ts << SENSORS_FILTER_SHIFT;
+        vrefint_filt = vrefint << SENSORS_FILTER_SHIFT;
+        filt_valid = true;
+    } else {
+        ts_filt += ts - (ts_filt >> SENSORS_FILTER_SHIFT);
+        vrefint_filt += vrefint - (vrefint_filt >> SENSORS_FILTER_SHIFT);
+    }
+    ts = ts_filt >> SENSORS_FILTER_SHIFT;
+    vrefint = vrefint_filt >> SENSORS_FILTER_SHIFT;
+    if (vrefint == 0)
+        return;
+
+    vdda = VREFINT_CAL_VOLT * 10 * VREFINT_CAL_VAL / vrefint;
+    temperature = ((int32_t)(ts * VREFINT_CAL_VAL * 10 / vrefint) - TS_CAL1_VAL * 10);
     temperature = temperature * (TS_CAL2_TEMP - TS_CAL1_TEMP) / (TS_CAL2_VAL - TS_CAL1_VAL) + TS_CAL1_TEMP * 10;
 
+    chSysLock();
+    sensors_data.temperature = temperature;
+    sensors_data.vdda = vdda;
+    sensors_data.temperature_raw = ts;
+    sensors_data.vrefint_raw = vrefint;
+    chSysUnlock();
+
     /* TODO: Use proper OD interface */
-    OD_RAM.x2022_MCU_Sensors.temperatureRaw = sensors[i].ts;
-    OD_RAM.x2022_MCU_Sensors.VREFINT_Raw = sensors[i].vrefint;
-    OD_RAM.x2022_MCU_Sensors.temperature= temperature;
-    OD_RAM.x2022_MCU_Sensors.VREFINT= vdda;
+    OD_RAM.x2022_MCU_Sensors.temperatureRaw = ts;
+    OD_RAM.x2022_MCU_Sensors.VREFINT_Raw = vrefint;
+    OD_RAM.x2022_MCU_Sensors.temperature = temperature / 10;
+    OD_RAM.x2022_MCU_Sensors.VREFINT = vdda / 100;
+}
+
+/*
+ * Half and full buffer callback. The averaging and calibration math is left
+ * to the worker, the DMA keeps filling the other half meanwhile.
+ */
+static void sensors_cb(ADCDriver *adcp)
+{
+    chSysLockFromISR();
+    chEvtSignalI(sensors_tp, adcIsBufferComplete(adcp) ? SENSORS_EVENT_FULL : SENSORS_EVENT_HALF);
+    chSysUnlockFromISR();
+}
+
+static THD_FUNCTION(sensors_worker, arg)
+{
+    (void)arg;
+
+    while (!chThdShouldTerminateX()) {
+        eventmask_t events = chEvtWaitAny(ALL_EVENTS);
+
+        if (events & SENSORS_EVENT_HALF)
+            sensors_process(&sensors[0]);
+        if (events & SENSORS_EVENT_FULL)
+            sensors_process(&sensors[SENSORS_OVERSAMPLE]);
+    }
 }
 
 static void sensors_err_cb(ADCDriver *adcp, adcerror_t err)
@@ -53,10 +120,61 @@ void sensors_init(void)
     OD_RAM.x2021_MCU_Calibration.VREFINT_CAL = VREFINT_CAL_VAL;
 }
 
+/**
+ * @brief Starts background sampling on ADCD1.
+ *
+ * Without heap for the worker thread sampling stays stopped, as the DMA
+ * would otherwise run with nothing consuming it. A later call retries.
+ */
 void sensors_start(void)
 {
     adcAcquireBus(&ADCD1);
-    adcStart(&ADCD1, NULL);
-    /*adcStartConversion(&ADCD1, &adcgrpcfg, (adcsample_t*)sensors, sizeof(sensors)/sizeof(sensors_t));*/
+    if (sensors_tp == NULL) {
+        sensors_tp = chThdCreateFromHeap(NULL, THD_WORKING_AREA_SIZE(0x100), "sensors", NORMALPRIO, sensors_worker, NULL);
+        if (sensors_tp != NULL) {
+            adcStart(&ADCD1, NULL);
+            adcStartConversion(&ADCD1, &adcgrpcfg, (adcsample_t*)sensors, sizeof(sensors)/sizeof(sensors_t));
+        }
+    }
+    adcReleaseBus(&ADCD1);
+}
+
+/**
+ * @brief Stops background sampling so ADCD1 can be used for other conversions.
+ *
+ * The last filtered values remain available from sensors_get() and the OD.
+ * Call sensors_start() to resume.
+ *
+ * @return true if sampling was running, false if it was already stopped
+ */
+bool sensors_stop(void)
+{
+    thread_t *tp;
+
+    adcAcquireBus(&ADCD1);
+    tp = sensors_tp;
+    if (tp != NULL) {
+        adcStopConversion(&ADCD1);
+        sensors_tp = NULL;
+    }
     adcReleaseBus(&ADCD1);
+
+    if (tp == NULL)
+        return false;
+    chThdTerminate(tp);
+    chEvtSignal(tp, SENSORS_EVENT_TERMINATE);
+    chThdWait(tp);
+    return true;
+}
+
+/**
+ * @brief Copies out the latest filtered MCU sensor values. Never blocks.
+ *
+ * @param[out] dest     Destination for the values
+ */
+void sensors_get(sensors_data_t *dest)
+{
+    chSysLock();
+    *dest = sensors_data;
+    chSysUnlock();
 }
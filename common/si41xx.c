@@ -7,6 +7,7 @@
  * @{
  */
 
+#include <string.h>
 #include "hal.h"
 #include "si41xx.h"
 
@@ -32,6 +33,22 @@
 #define SI41XX_WORD                         SI41XX_WORD_Msk
 /** @} */
 
+/**
+ * @brief   Builds a serial word from a register address and value.
+ */
+#define SI41XX_MKWORD(addr, data)           (_VAL2FLD(SI41XX_ADDRESS, addr) | \
+                                             _VAL2FLD(SI41XX_DATA, data))
+
+#if (SI41XX_USE_DMA) || defined(__DOXYGEN__)
+/**
+ * @name    GPIO BSRR values
+ * @{
+ */
+#define SI41XX_BSRR_SET(mask)               (mask)
+#define SI41XX_BSRR_RESET(mask)             ((mask) << 16)
+/** @} */
+#endif /* SI41XX_USE_DMA */
+
 /**
  * @name    Maximum phase detector frequency
  * @{
@@ -53,35 +70,132 @@
 /*===========================================================================*/
 
 #if (SI41XX_USE_SERIAL) || defined(__DOXYGEN__)
+#if (SI41XX_USE_DMA) || defined(__DOXYGEN__)
 /**
- * @brief   Writes to an SI41xx device using its serial interface.
+ * @brief   Serial stream DMA completion.
  *
- * @param[in]   devp        Pointer to the @p SI41XXDriver object
- * @param[in]   addr        Register address
- * @param[in]   data        Data to write to register
+ * @param[in]   p           Pointer to the @p SI41XXDriver object
+ * @param[in]   flags       DMA interrupt flags
  *
  * @notapi
  */
-void si41xxWriteRegister(SI41XXDriver *devp, uint8_t addr, uint32_t data) {
-    uint32_t i = 22;
-    uint32_t word = _VAL2FLD(SI41XX_ADDRESS, addr)
-                  | _VAL2FLD(SI41XX_DATA, data);
+static void si41xx_dma_cb(void *p, uint32_t flags) {
+    SI41XXDriver *devp = p;
 
-    osalDbgCheck((devp != NULL) && (devp->config != NULL));
+    SI41XX_DMA_TIM->CR1 = 0;
+    SI41XX_DMA_TIM->DIER = 0;
+    dmaStreamDisable(devp->dmastp);
 
-    palClearLine(devp->config->sen);
+    osalSysLockFromISR();
+    osalThreadResumeI(&devp->thread, ((flags & STM32_DMA_ISR_TEIF) ? MSG_RESET : MSG_OK));
+    osalSysUnlockFromISR();
+}
 
-    while (i--) {
-        palClearLine(devp->config->sclk);
+/**
+ * @brief   Converts serial words into GPIO set/reset steps.
+ * @details The steps reproduce the bit-banged waveform: data changes with
+ *          SCLK low and is sampled on the SCLK rising edge, and SEN rising
+ *          latches the word.
+ *
+ * @param[in]   devp        Pointer to the @p SI41XXDriver object
+ * @param[in]   words       Serial words, MSB first
+ * @param[in]   n           Number of words
+ *
+ * @notapi
+ */
+static void si41xxBuildStream(SI41XXDriver *devp, const uint32_t *words, size_t n) {
+    const uint32_t sen = PAL_PORT_BIT(PAL_PAD(devp->config->sen));
+    const uint32_t sclk = PAL_PORT_BIT(PAL_PAD(devp->config->sclk));
+    const uint32_t sdata = PAL_PORT_BIT(PAL_PAD(devp->config->sdata));
+    uint32_t *p = devp->stream;
+
+    for (size_t i = 0; i < n; i++) {
+        uint32_t word = words[i];
+
+        *p++ = SI41XX_BSRR_RESET(sen);
+        for (uint32_t bit = 22; bit > 0; bit--) {
+            *p++ = SI41XX_BSRR_RESET(sclk) |
+                   (word & SI41XX_MSB ? SI41XX_BSRR_SET(sdata) : SI41XX_BSRR_RESET(sdata));
+            *p++ = SI41XX_BSRR_SET(sclk);
+            word <<= 1;
+        }
+        *p++ = SI41XX_BSRR_RESET(sclk);
+        *p++ = SI41XX_BSRR_SET(sen);
+        *p++ = SI41XX_BSRR_SET(sclk);
+    }
+    devp->stream_len = p - devp->stream;
+}
+#endif /* SI41XX_USE_DMA */
 
-        palWriteLine(devp->config->sdata, (word & SI41XX_MSB ? PAL_HIGH : PAL_LOW));
+/**
+ * @brief   Writes serial words to an SI41xx device.
+ * @details With @p SI41XX_USE_DMA the words are sent as one timer paced DMA
+ *          stream and the calling thread sleeps until it completes,
+ *          otherwise they are bit-banged.
+ *
+ * @param[in]   devp        Pointer to the @p SI41XXDriver object
+ * @param[in]   words       Serial words built with @p SI41XX_MKWORD
+ * @param[in]   n           Number of words
+ *
+ * @notapi
+ */
+void si41xxWriteWords(SI41XXDriver *devp, const uint32_t *words, size_t n) {
+    osalDbgCheck((devp != NULL) && (devp->config != NULL) && (n <= SI41XX_MAX_WORDS));
+
+#if SI41XX_USE_DMA
+    si41xxBuildStream(devp, words, n);
+
+    dmaStreamSetMemory0(devp->dmastp, devp->stream);
+    dmaStreamSetTransactionSize(devp->dmastp, devp->stream_len);
+    dmaStreamSetMode(devp->dmastp, STM32_DMA_CR_CHSEL(SI41XX_DMA_CHANNEL) |
+                                   STM32_DMA_CR_PL(SI41XX_DMA_PRIORITY) |
+                                   STM32_DMA_CR_DIR_M2P | STM32_DMA_CR_MINC |
+                                   STM32_DMA_CR_PSIZE_WORD | STM32_DMA_CR_MSIZE_WORD |
+                                   STM32_DMA_CR_TCIE | STM32_DMA_CR_TEIE);
+
+    osalSysLock();
+    dmaStreamEnable(devp->dmastp);
+    SI41XX_DMA_TIM->CNT = 0;
+    SI41XX_DMA_TIM->SR = 0;
+    SI41XX_DMA_TIM->DIER = STM32_TIM_DIER_UDE;
+    SI41XX_DMA_TIM->CR1 = STM32_TIM_CR1_CEN;
+    osalThreadSuspendS(&devp->thread);
+    osalSysUnlock();
+#else
+    for (size_t j = 0; j < n; j++) {
+        uint32_t i = 22;
+        uint32_t word = words[j];
+
+        palClearLine(devp->config->sen);
+
+        while (i--) {
+            palClearLine(devp->config->sclk);
+
+            palWriteLine(devp->config->sdata, (word & SI41XX_MSB ? PAL_HIGH : PAL_LOW));
+            palSetLine(devp->config->sclk);
+            word <<= 1;
+        }
+
+        palClearLine(devp->config->sclk);
+        palSetLine(devp->config->sen);
         palSetLine(devp->config->sclk);
-        word <<= 1;
     }
+#endif /* SI41XX_USE_DMA */
+}
+
+/**
+ * @brief   Writes to an SI41xx device using its serial interface.
+ *
+ * @param[in]   devp        Pointer to the @p SI41XXDriver object
+ * @param[in]   addr        Register address
+ * @param[in]   data        Data to write to register
+ *
+ * @notapi
+ */
+void si41xxWriteRegister(SI41XXDriver *devp, uint8_t addr, uint32_t data) {
+    uint32_t word = SI41XX_MKWORD(addr, data);
 
-    palClearLine(devp->config->sclk);
-    palSetLine(devp->config->sen);
-    palSetLine(devp->config->sclk);
+    si41xxWriteWords(devp, &word, 1);
 }
 
 #if (SI41XX_USE_MUTUAL_EXCLUSION) || defined(__DOXYGEN__)
@@ -164,6 +278,45 @@ bool si41xxCalcDiv(SI41XXDriver *devp, uint32_t freq, uint32_t *ndiv, uint32_t *
     return true;
 }
 
+/**
+ * @brief   Looks up N-Div and R-Div values, calculating them on a miss.
+ * @details Results are cached by frequency so that switching between known
+ *          frequencies skips the divider search.
+ *
+ * @param[in]   devp        Pointer to the @p SI41XXDriver object
+ * @param[in]   freq        Desired output frequency
+ * @param[out]  ndiv        N-Divider value
+ * @param[out]  rdiv        R-Divider value
+ *
+ * @return                  Successfully found values within phase detector frequency bounds
+ * @notapi
+ */
+bool si41xxGetDiv(SI41XXDriver *devp, uint32_t freq, uint32_t *ndiv, uint32_t *rdiv) {
+    si41xx_div_t *entry;
+
+    for (uint32_t i = 0; i < SI41XX_DIV_CACHE_SIZE; i++) {
+        entry = &devp->div_cache[i];
+        if (entry->freq == freq && freq != 0) {
+            *ndiv = entry->ndiv;
+            *rdiv = entry->rdiv;
+            devp->div_hits++;
+            return true;
+        }
+    }
+
+    devp->div_misses++;
+    if (!si41xxCalcDiv(devp, freq, ndiv, rdiv)) {
+        return false;
+    }
+
+    entry = &devp->div_cache[devp->div_next];
+    entry->freq = freq;
+    entry->ndiv = *ndiv;
+    entry->rdiv = *rdiv;
+    devp->div_next = (devp->div_next + 1) % SI41XX_DIV_CACHE_SIZE;
+    return true;
+}
+
 /*==========================================================================*/
 /* Interface implementation.                                                */
 /*==========================================================================*/
@@ -181,6 +334,16 @@ bool si41xxCalcDiv(SI41XXDriver *devp, uint32_t freq, uint32_t *ndiv, uint32_t *
  */
 void si41xxObjectInit(SI41XXDriver *devp) {
     devp->config = NULL;
+    memset(devp->div_cache, 0, sizeof(devp->div_cache));
+    devp->div_next = 0;
+    devp->div_hits = 0;
+    devp->div_misses = 0;
+
+#if SI41XX_USE_DMA
+    devp->dmastp = NULL;
+    devp->thread = NULL;
+    devp->stream_len = 0;
+#endif
 
 #if SI41XX_USE_MUTUAL_EXCLUSION
     osalMutexObjectInit(&devp->mutex);
@@ -205,6 +368,30 @@ void si41xxStart(SI41XXDriver *devp, SI41XXConfig *config) {
     devp->config = config;
     devp->pwr = 0;
 
+    /* Cached results depend on the reference frequency */
+    memset(devp->div_cache, 0, sizeof(devp->div_cache));
+    devp->div_next = 0;
+
+#if SI41XX_USE_DMA
+    osalDbgAssert(PAL_PORT(config->sen) == PAL_PORT(config->sclk) &&
+                  PAL_PORT(config->sen) == PAL_PORT(config->sdata),
+            "si41xxStart(), serial lines must share a port");
+
+    if (devp->dmastp == NULL) {
+        devp->dmastp = dmaStreamAlloc(SI41XX_DMA_STREAM, SI41XX_DMA_IRQ_PRIORITY,
+                                      si41xx_dma_cb, devp);
+        osalDbgAssert(devp->dmastp != NULL, "si41xxStart(), unable to allocate stream");
+    }
+    dmaStreamSetPeripheral(devp->dmastp, &PAL_PORT(config->sen)->BSRR);
+
+    SI41XX_DMA_TIM_ENABLE();
+    SI41XX_DMA_TIM->CR1 = 0;
+    SI41XX_DMA_TIM->DIER = 0;
+    SI41XX_DMA_TIM->PSC = 0;
+    SI41XX_DMA_TIM->ARR = SI41XX_DMA_TIM_CLK / SI41XX_DMA_STEP_FREQ - 1;
+    SI41XX_DMA_TIM->EGR = STM32_TIM_EGR_UG;
+#endif /* SI41XX_USE_DMA */
+
 #if SI41XX_USE_SERIAL
 #if SI41XX_SHARED_SERIAL
     si41xxAcquireBus(devp);
@@ -265,6 +452,14 @@ void si41xxStop(SI41XXDriver *devp) {
     si41xxReleaseBus(devp);
 #endif /* SI41XX_SHARED_SERIAL */
 #endif /* SI41XX_USE_SERIAL */
+
+#if SI41XX_USE_DMA
+    if (devp->dmastp != NULL) {
+        dmaStreamFree(devp->dmastp);
+        devp->dmastp = NULL;
+    }
+    SI41XX_DMA_TIM_DISABLE();
+#endif /* SI41XX_USE_DMA */
     devp->state = SI41XX_STOP;
 }
 
@@ -306,13 +501,13 @@ void si41xxWriteRaw(SI41XXDriver *devp, uint8_t reg, uint32_t value) {
  * @api
  */
 bool si41xxSetIF(SI41XXDriver *devp, uint32_t freq) {
-    uint32_t n, r;
+    uint32_t n, r, words[4];
     osalDbgCheck(devp != NULL);
     osalDbgAssert((devp->state == SI41XX_READY),
             "si41xxSetIF(), invalid state");
 
-    /* Calculate N and R values */
-    if (!si41xxCalcDiv(devp, freq << devp->config->if_div, &n, &r)) {
+    /* Look up N and R values */
+    if (!si41xxGetDiv(devp, freq << devp->config->if_div, &n, &r)) {
         return false;
     }
 
@@ -328,12 +523,12 @@ bool si41xxSetIF(SI41XXDriver *devp, uint32_t freq) {
     si41xxAcquireBus(devp);
 #endif /* SI41XX_SHARED_SERIAL */
 
-    devp->pwr &= ~SI41XX_POWERDOWN_PBIB;
-    si41xxWriteRegister(devp, SI41XX_REG_PWRDOWN, devp->pwr);
-    si41xxWriteRegister(devp, SI41XX_REG_IF_NDIV, _VAL2FLD(SI41XX_IF_NDIV, n));
-    si41xxWriteRegister(devp, SI41XX_REG_IF_RDIV, _VAL2FLD(SI41XX_IF_RDIV, r));
+    words[0] = SI41XX_MKWORD(SI41XX_REG_PWRDOWN, devp->pwr & ~SI41XX_POWERDOWN_PBIB);
+    words[1] = SI41XX_MKWORD(SI41XX_REG_IF_NDIV, _VAL2FLD(SI41XX_IF_NDIV, n));
+    words[2] = SI41XX_MKWORD(SI41XX_REG_IF_RDIV, _VAL2FLD(SI41XX_IF_RDIV, r));
     devp->pwr |= SI41XX_POWERDOWN_PBIB;
-    si41xxWriteRegister(devp, SI41XX_REG_PWRDOWN, devp->pwr);
+    words[3] = SI41XX_MKWORD(SI41XX_REG_PWRDOWN, devp->pwr);
+    si41xxWriteWords(devp, words, 4);
 
 #if SI41XX_SHARED_SERIAL
     si41xxReleaseBus(devp);
@@ -394,13 +589,13 @@ bool si41xxSetIFDiv(SI41XXDriver *devp, uint8_t div) {
  * @api
  */
 bool si41xxSetRF1(SI41XXDriver *devp, uint32_t freq) {
-    uint32_t n, r;
+    uint32_t n, r, words[4];
     osalDbgCheck(devp != NULL);
     osalDbgAssert((devp->state == SI41XX_READY),
             "si41xxSetRF1(), invalid state");
 
-    /* Calculate N and R values */
-    if (!si41xxCalcDiv(devp, freq, &n, &r)) {
+    /* Look up N and R values */
+    if (!si41xxGetDiv(devp, freq, &n, &r)) {
         return false;
     }
 
@@ -416,12 +611,12 @@ bool si41xxSetRF1(SI41XXDriver *devp, uint32_t freq) {
     si41xxAcquireBus(devp);
 #endif /* SI41XX_SHARED_SERIAL */
 
-    devp->pwr &= ~SI41XX_POWERDOWN_PBRB;
-    si41xxWriteRegister(devp, SI41XX_REG_PWRDOWN, devp->pwr);
-    si41xxWriteRegister(devp, SI41XX_REG_RF1_NDIV, _VAL2FLD(SI41XX_RF1_NDIV, n));
-    si41xxWriteRegister(devp, SI41XX_REG_RF1_RDIV, _VAL2FLD(SI41XX_RF1_RDIV, r));
+    words[0] = SI41XX_MKWORD(SI41XX_REG_PWRDOWN, devp->pwr & ~SI41XX_POWERDOWN_PBRB);
+    words[1] = SI41XX_MKWORD(SI41XX_REG_RF1_NDIV, _VAL2FLD(SI41XX_RF1_NDIV, n));
+    words[2] = SI41XX_MKWORD(SI41XX_REG_RF1_RDIV, _VAL2FLD(SI41XX_RF1_RDIV, r));
     devp->pwr |= SI41XX_POWERDOWN_PBRB;
-    si41xxWriteRegister(devp, SI41XX_REG_PWRDOWN, devp->pwr);
+    words[3] = SI41XX_MKWORD(SI41XX_REG_PWRDOWN, devp->pwr);
+    si41xxWriteWords(devp, words, 4);
 
 #if SI41XX_SHARED_SERIAL
     si41xxReleaseBus(devp);
@@ -442,13 +637,13 @@ bool si41xxSetRF1(SI41XXDriver *devp, uint32_t freq) {
  * @api
  */
 bool si41xxSetRF2(SI41XXDriver *devp, uint32_t freq) {
-    uint32_t n, r;
+    uint32_t n, r, words[4];
     osalDbgCheck(devp != NULL);
     osalDbgAssert((devp->state == SI41XX_READY),
             "si41xxSetRF2(), invalid state");
 
-    /* Calculate N and R values */
-    if (!si41xxCalcDiv(devp, freq, &n, &r)) {
+    /* Look up N and R values */
+    if (!si41xxGetDiv(devp, freq, &n, &r)) {
         return false;
     }
 
@@ -464,12 +659,12 @@ bool si41xxSetRF2(SI41XXDriver *devp, uint32_t freq) {
     si41xxAcquireBus(devp);
 #endif /* SI41XX_SHARED_SERIAL */
 
-    devp->pwr &= ~SI41XX_POWERDOWN_PBRB;
-    si41xxWriteRegister(devp, SI41XX_REG_PWRDOWN, devp->pwr);
-    si41xxWriteRegister(devp, SI41XX_REG_RF2_NDIV, _VAL2FLD(SI41XX_RF2_NDIV, n));
-    si41xxWriteRegister(devp, SI41XX_REG_RF2_RDIV, _VAL2FLD(SI41XX_RF2_RDIV, r));
+    words[0] = SI41XX_MKWORD(SI41XX_REG_PWRDOWN, devp->pwr & ~SI41XX_POWERDOWN_PBRB);
+    words[1] = SI41XX_MKWORD(SI41XX_REG_RF2_NDIV, _VAL2FLD(SI41XX_RF2_NDIV, n));
+    words[2] = SI41XX_MKWORD(SI41XX_REG_RF2_RDIV, _VAL2FLD(SI41XX_RF2_RDIV, r));
     devp->pwr |= SI41XX_POWERDOWN_PBRB;
-    si41xxWriteRegister(devp, SI41XX_REG_PWRDOWN, devp->pwr);
+    words[3] = SI41XX_MKWORD(SI41XX_REG_PWRDOWN, devp->pwr);
+    si41xxWriteWords(devp, words, 4);
 
 #if SI41XX_SHARED_SERIAL
     si41xxReleaseBus(devp);
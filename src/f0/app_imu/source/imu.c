@@ -1,11 +1,13 @@
 #include "imu.h"
 #include "bmi088.h"
+#include "mmc5883ma.h"
 #include "chprintf.h"
 #include "CANopen.h"
 #include "OD.h"
 
 #define BMI088_GYRO_SADDR     0x68U
 #define BMI088_ACC_SADDR      0x18U
+#define MMC5883MA_SADDR       0x30U
 
 #define DEBUG_SD    (BaseSequentialStream*) &SD2
 
@@ -39,7 +41,17 @@ static const BMI088Config imucfg = {
     .acc_saddr = BMI088_ACC_SADDR,
 };
 
+static const MMC5883MAConfig magcfg = {
+    .i2cp = &I2CD1,
+    .i2ccfg = &i2ccfg,
+    .saddr = MMC5883MA_SADDR,
+    .bw = MMC5883MA_INTRNLCTRL1_BW_100Hz,
+    .cm_freq = MMC5883MA_INTRNLCTRL2_CM_FREQ_14Hz,
+    .setreset_interval = 100,
+};
+
 static BMI088Driver imudev;
+static MMC5883MADriver magdev;
 
 /**
  * TODO more documentation
@@ -103,10 +115,25 @@ bool update_imu_data(void) {
 
     OD_RAM.x6002_IMU_Temperature = temp_c;
 
-    //TODO Implement magnetometer driver and populate this info
-    OD_RAM.x6003_magnetometerPZ1.magX = 0;
-    OD_RAM.x6003_magnetometerPZ1.magY = 0;
-    OD_RAM.x6003_magnetometerPZ1.magZ = 0;
+    /*
+     * Only one MMC5883MA is reachable on I2C1 since they share a fixed
+     * address, so PZ2, MZ1 and MZ2 are always published as zero.
+     * MSG_TIMEOUT means no new sample since the last loop, so the previous
+     * values are left in place.
+     */
+    if( magdev.state == MMC5883MA_READY ) {
+        mmc5883ma_sample_t mag_sample;
+        msg_t r = mmc5883maReadXYZ(&magdev, &mag_sample);
+        if( r == MSG_OK ) {
+            dbgprintf("Mag readings mG X = %d, Y = %d, Z = %d\r\n", mag_sample.mag_x, mag_sample.mag_y, mag_sample.mag_z);
+            OD_RAM.x6003_magnetometerPZ1.magX = mag_sample.mag_x;
+            OD_RAM.x6003_magnetometerPZ1.magY = mag_sample.mag_y;
+            OD_RAM.x6003_magnetometerPZ1.magZ = mag_sample.mag_z;
+        } else if( r != MSG_TIMEOUT ) {
+            ret = false;
+            dbgprintf("Failed to read magnetometer readings\r\n");
+        }
+    }
 
     OD_RAM.x6004_magnetometerPZ2.magX = 0;
     OD_RAM.x6004_magnetometerPZ2.magY = 0;
@@ -165,6 +192,14 @@ THD_FUNCTION(imu, arg)
             //CO_errorReport(CO->em, CO_EM_GENERIC_ERROR, CO_EMC_HARDWARE, IMU_OD_ERROR_INFO_CODE_GYRO_CHIP_ID_MISMATCH);
         }
     }
+
+    mmc5883maObjectInit(&magdev);
+    mmc5883maStart(&magdev, &magcfg);
+
+    chprintf(DEBUG_SD, "MMC5883MA state = %u\r\n", magdev.state);
+    if( magdev.state != MMC5883MA_READY ) {
+        chprintf(DEBUG_SD, "Failed to start magnetometer driver...\r\n");
+    }
     chprintf(DEBUG_SD, "Done initializing, starting loop...\r\n");
 
     for (uint32_t iterations = 0; !chThdShouldTerminateX(); iterations++) {
@@ -188,8 +223,9 @@ THD_FUNCTION(imu, arg)
         chThdSleepMilliseconds(1000);
     }
 
-    /* Stop the BMI088 IMU sensor */
+    /* Stop the BMI088 IMU sensor, then the magnetometer as the last I2C1 user */
     bmi088Stop(&imudev);
+    mmc5883maStop(&magdev);
 
     chThdExit(MSG_OK);
 }
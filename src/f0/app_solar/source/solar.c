@@ -1,3 +1,4 @@
+#include <string.h>
 #include "solar.h"
 #include "ina226.h"
 #include "CANopen.h"
@@ -6,7 +7,11 @@
 
 #define DEBUG_SD                (BaseSequentialStream *) &SD2
 
-#if 0
+#if !defined(SOLAR_DEBUG)
+#define SOLAR_DEBUG             FALSE
+#endif
+
+#if SOLAR_DEBUG
 #define dbgprintf(str, ...)       chprintf((BaseSequentialStream*) &SD2, str, ##__VA_ARGS__)
 #else
 #define dbgprintf(str, ...)
@@ -29,16 +34,20 @@
 #define I_ADJ_MAX               1500000
 #define I_ADJ_MIN               0
 #define HISTERESIS_MW           3
+//Below this the panel cannot source the LT1618 current limit and its voltage has collapsed
+#define PV_COLLAPSED_MV         1000
 
 
 //1000 is based on the width of the flat at the top of the curve and the minimum adjustable value of the DAC
-#define VREF_STEP_IN_MICROVOLTS_NEGATIVE             1000
-#define VREF_STEP_IN_MICROVOLTS_POSITIVE             (VREF_STEP_IN_MICROVOLTS_NEGATIVE * 4)
+#define IADJ_STEP_MIN_UV                             1000
+#define IADJ_STEP_MAX_UV                             20000
+//Step size per mA of |dP/dV|. Large far from the MPP, shrinks to IADJ_STEP_MIN_UV at it
+#define IADJ_STEP_GAIN_UV_PER_MA                     20
 #define DIAG_REPORT_EVERY_N_LOOP_ITERATIONS          1
 
 
-#if VREF_STEP_IN_MICROVOLTS_NEGATIVE < DAC_MININUM_ADJUST_UV
-#error "VREF_STEP_IN_MICROVOLTS_NEGATIVE must be greater then DAC_MININUM_ADJUSG_UV"
+#if IADJ_STEP_MIN_UV < DAC_MININUM_ADJUST_UV
+#error "IADJ_STEP_MIN_UV must be greater then DAC_MININUM_ADJUST_UV"
 #endif
 
 extern const I2CConfig i2cconfig;
@@ -54,6 +63,8 @@ extern const I2CConfig i2cconfig;
  */
 #define NUM_INA226_AVG                                 16
 #define INA226_ADC_CONVERSION_TIME_MICROSECONDS        1100
+//Shunt and bus are both converted NUM_INA226_AVG times per result
+#define INA226_CONVERSION_TIMEOUT_MS                   (((2 * NUM_INA226_AVG * INA226_ADC_CONVERSION_TIME_MICROSECONDS) / 1000) + 5)
 
 static const INA226Config ina226config = {
     &I2CD2,
@@ -82,7 +93,8 @@ uint32_t energyTrack;
 static INA226Driver ina226dev;
 
 typedef enum {
-	MPPT_ALGORITHM_PAO = 0
+	MPPT_ALGORITHM_PAO = 0,
+	MPPT_ALGORITHM_VSPAO = 1,
 } mppt_algorithm_t;
 
 
@@ -102,8 +114,6 @@ typedef struct {
 	uint32_t avg_power_perturbed_mW;
 	uint32_t avg_voltage_perturbed_mV;
 	uint32_t avg_current_perturbed_uA;
-
-	bool hit_step_size_threshold_flag;
 } mppt_pao_state;
 
 mppt_pao_state pao_state;
@@ -125,9 +135,54 @@ void dac_put_microvolts(DACDriver *dacp, dacchannel_t chan, uint32_t uv) {
     dacPutChannelX(dacp, chan, val);
 }
 
+/**
+ * @brief Blocks until the INA226 has a fresh averaged conversion.
+ *
+ * Uses the ALERT line in conversion ready mode where the board has it wired,
+ * otherwise polls the conversion ready flag. Reading the Mask/Enable register
+ * clears both the flag and the ALERT line.
+ *
+ * @return true upon success, false otherwise
+ */
+bool wait_conversion_ready(void) {
+	uint16_t mask_enable = 0;
+
+#if defined(LINE_ALERT)
+	msg_t msg = MSG_OK;
+
+	//ALERT is active low and held until Mask/Enable is read, so only wait for
+	//the edge if the conversion has not already completed
+	chSysLock();
+	if( palReadLine(LINE_ALERT) == PAL_HIGH ) {
+		msg = palWaitLineTimeoutS(LINE_ALERT, TIME_MS2I(INA226_CONVERSION_TIMEOUT_MS));
+	}
+	chSysUnlock();
+	if( msg != MSG_OK ) {
+		return(false);
+	}
+	return(ina226ReadRaw(&ina226dev, INA226_AD_ME, &mask_enable) == MSG_OK);
+#else
+	for(int elapsed_ms = 0; elapsed_ms < INA226_CONVERSION_TIMEOUT_MS; elapsed_ms++ ) {
+		chThdSleepMilliseconds(1);
+		if( ina226ReadRaw(&ina226dev, INA226_AD_ME, &mask_enable) != MSG_OK ) {
+			return(false);
+		}
+		if( mask_enable & INA226_ME_CVRF ) {
+			return(true);
+		}
+	}
+	return(false);
+#endif
+}
+
 /**
  * @brief Reads power flow characteristics from the INA226
  *
+ * Restarts the INA226 conversion so the result only covers samples taken
+ * after the last DAC change, then waits for it to complete. Power is derived
+ * from the bus voltage and current of that same conversion rather than read
+ * separately.
+ *
  * @param[in|out] *dest_avg_power_mW     Output variable into which to store average power reading
  * @param[in|out] *dest_avg_voltage_uV   Output variable into which to store average voltage reading
  * @param[in|out] *dest_avg_current      Output variable into which to store average current reading
@@ -135,18 +190,28 @@ void dac_put_microvolts(DACDriver *dacp, dacchannel_t chan, uint32_t uv) {
  * @return true upon success, false otherwise
  */
 bool read_avg_power_and_voltage(uint32_t *dest_avg_power_mW, uint32_t *dest_avg_voltage_mV, uint32_t *dest_avg_current_uA) {
-	chThdSleepMilliseconds((NUM_INA226_AVG * INA226_ADC_CONVERSION_TIME_MICROSECONDS) / 1000);//Compensate for the internal averaging done by the ina chip
-
+	uint16_t mask_enable = 0;
 	bool ret = true;
-	if( ina226ReadPower(&ina226dev, dest_avg_power_mW) != MSG_OK ) {
+
+	//Clear any stale conversion ready flag before restarting
+	if( ina226ReadRaw(&ina226dev, INA226_AD_ME, &mask_enable) != MSG_OK ) {
 		ret = false;
-	}
-	if( ina226ReadVBUS(&ina226dev, dest_avg_voltage_mV) != MSG_OK ) {
+	} else if( ina226StartConversion(&ina226dev) != MSG_OK ) {
 		ret = false;
-	}
-	if( ina226ReadCurrent(&ina226dev, dest_avg_current_uA) != MSG_OK ) {
+	} else if( ! wait_conversion_ready() ) {
 		ret = false;
+	} else {
+		if( ina226ReadVBUS(&ina226dev, dest_avg_voltage_mV) != MSG_OK ) {
+			ret = false;
+		}
+		if( ina226ReadCurrent(&ina226dev, dest_avg_current_uA) != MSG_OK ) {
+			ret = false;
+		}
+		if( ret ) {
+			*dest_avg_power_mW = (uint32_t) (((uint64_t) *dest_avg_voltage_mV * *dest_avg_current_uA) / 1000000);
+		}
 	}
+
 	if( ! ret ) {
 		//CO_errorReport(CO->em, CO_EM_GENERIC_ERROR, CO_EMC_COMMUNICATION, SOLAR_OD_ERROR_TYPE_INA226_COMM_ERROR);
 	}
@@ -164,38 +229,40 @@ uint32_t saturate_uint32_t(const int64_t v, const uint32_t min, const uint32_t m
 }
 
 /**
- * Determines step size for iAdj based on current voltage. Allows for faster convergence on MPP.
+ * Variable step size for iAdj, proportional to |dP/dV| of the last perturbation.
+ *
+ * The slope of the P-V curve is steep far from the MPP and zero at it, so the
+ * tracker takes large steps while converging and settles to the minimum step
+ * at the MPP, which keeps steady state ripple down.
  */
-uint32_t get_iadj_step_size(mppt_pao_state *pao_state) {
-	if( (! pao_state->hit_step_size_threshold_flag) && pao_state->max_voltage_initial_mV != 0 ) {
-		const uint32_t threshold_low_mV = pao_state->max_voltage_initial_mV / 20; //0.95 threshold
-		const uint32_t threshold_mV = pao_state->max_voltage_initial_mV - threshold_low_mV;
-
-		if(  pao_state->avg_voltage_initial_mV > threshold_mV ) {
-			//Linear scale of step size based on delta from maximum voltage
-		    const int32_t v = (((pao_state->avg_voltage_initial_mV - threshold_mV) * 100) / threshold_low_mV);
-			const uint32_t step_size = (((5000 - VREF_STEP_IN_MICROVOLTS_NEGATIVE) * v) / 100) + VREF_STEP_IN_MICROVOLTS_NEGATIVE;
-
-			return(step_size);//up or down is fine
-		} else {
-			pao_state->hit_step_size_threshold_flag = true;
-		}
+uint32_t get_iadj_step_size(const int32_t delta_power_mW, const int32_t delta_voltage_mV) {
+	if( delta_voltage_mV == 0 ) {
+		return(IADJ_STEP_MIN_UV);
 	}
 
-	if( pao_state->direction_up_flag ) {
-		return(VREF_STEP_IN_MICROVOLTS_POSITIVE);
+	int64_t slope_mA = (((int64_t) delta_power_mW) * 1000) / delta_voltage_mV;
+	if( slope_mA < 0 ) {
+		slope_mA = -slope_mA;
 	}
-	return(VREF_STEP_IN_MICROVOLTS_NEGATIVE);
+
+	return(saturate_uint32_t(slope_mA * IADJ_STEP_GAIN_UV_PER_MA, IADJ_STEP_MIN_UV, IADJ_STEP_MAX_UV));
 }
 
 /**
- * @param *pao_state The current state of the perturb and observe algorithm
+ * Variable step perturb and observe MPPT.
+ *
+ * Keep moving while power rises, reverse when it falls. The step size scales
+ * with the slope of the P-V curve, see get_iadj_step_size().
+ *
+ * @param *pao_state The current state of the tracker
  *
  * @return true on success, false otherwise
  */
 bool itterate_mppt_perturb_and_observe(mppt_pao_state *pao_state) {
 
-	pao_state->step_size = get_iadj_step_size(pao_state);
+	if( pao_state->step_size < IADJ_STEP_MIN_UV ) {
+		pao_state->step_size = IADJ_STEP_MIN_UV;
+	}
 
 	uint32_t iadj_uv_perturbed = pao_state->iadj_uv;
 	if( pao_state->direction_up_flag ) {
@@ -207,12 +274,14 @@ bool itterate_mppt_perturb_and_observe(mppt_pao_state *pao_state) {
 	if( pao_state->iadj_uv == iadj_uv_perturbed ) {
 		//It has saturated to an identical value, flip the search direction and process in the next iteration
 		pao_state->direction_up_flag = (! pao_state->direction_up_flag);
+		pao_state->step_size = IADJ_STEP_MIN_UV;
 	} else {
 		dac_put_microvolts(&DACD1, 0, iadj_uv_perturbed);
 
 		if( ! read_avg_power_and_voltage(&pao_state->avg_power_perturbed_mW, &pao_state->avg_voltage_perturbed_mV, &pao_state->avg_current_perturbed_uA) ) {
 			//I2C communications error, no data to make a decision on. Fail safe to moving left
 			pao_state->direction_up_flag = true;
+			pao_state->step_size = IADJ_STEP_MIN_UV;
 
 			pao_state->iadj_uv = iadj_uv_perturbed;
 			if( pao_state->iadj_uv > I_ADJ_FAILSAFE ) {
@@ -223,13 +292,27 @@ bool itterate_mppt_perturb_and_observe(mppt_pao_state *pao_state) {
 
 			return(false);
 
+		} else if( pao_state->avg_voltage_perturbed_mV < PV_COLLAPSED_MV ) {
+			//Power is flat at zero here, after an irradiance drop or in eclipse, so perturb and
+			//observe has nothing to follow. Back off to the failsafe and search down from there.
+			pao_state->direction_up_flag = false;
+			pao_state->step_size = IADJ_STEP_MIN_UV;
+			pao_state->iadj_uv = I_ADJ_FAILSAFE;
+
+			pao_state->avg_current_initial_uA = pao_state->avg_current_perturbed_uA;
+			pao_state->avg_power_initial_mW = pao_state->avg_power_perturbed_mW;
+			pao_state->avg_voltage_initial_mV = pao_state->avg_voltage_perturbed_mV;
 		} else {
-			if( pao_state->avg_power_perturbed_mW >= (pao_state->avg_power_initial_mW - HISTERESIS_MW) ) {
+			const int32_t delta_power_mW = (int32_t) pao_state->avg_power_perturbed_mW - (int32_t) pao_state->avg_power_initial_mW;
+			const int32_t delta_voltage_mV = (int32_t) pao_state->avg_voltage_perturbed_mV - (int32_t) pao_state->avg_voltage_initial_mV;
+
+			if( delta_power_mW >= -HISTERESIS_MW ) {
 				//Always move the iadj_value, even if the output power is equal. This will cause it to hunt back and forth between two points that have a detectable difference in their power output.
 			} else {
 				pao_state->direction_up_flag = (! pao_state->direction_up_flag);
 			}
 
+			pao_state->step_size = get_iadj_step_size(delta_power_mW, delta_voltage_mV);
 			pao_state->iadj_uv = iadj_uv_perturbed;
 
 			pao_state->avg_current_initial_uA = pao_state->avg_current_perturbed_uA;
@@ -265,7 +348,13 @@ THD_FUNCTION(solar, arg)
     if( ina226dev.state != INA226_READY ) {
     	chprintf(DEBUG_SD, "Failed to initialize INA226!!!\r\n");
     	chThdSleepMilliseconds(100);
+    } else {
+    	//Assert ALERT on conversion ready so sampling is driven by the INA226 rather than sleeps
+    	ina226SetAlert(&ina226dev, INA226_ME_CNVR, 0);
     }
+#if defined(LINE_ALERT)
+    palEnableLineEvent(LINE_ALERT, PAL_EVENT_MODE_FALLING_EDGE);
+#endif
 
     memset(&pao_state, 0, sizeof(pao_state));
     pao_state.iadj_uv = I_ADJ_INITIAL;
@@ -291,7 +380,9 @@ THD_FUNCTION(solar, arg)
 	dac_put_microvolts(&DACD1, 0, pao_state.iadj_uv);
 
 	chprintf(DEBUG_SD, "Done with init INA226, running main loop....\r\n");
+#if SOLAR_DEBUG
     systime_t loop_start_time_ms = TIME_I2MS(chVTGetSystemTime());
+#endif
 
 	for (uint32_t loop_iteration = 0; !chThdShouldTerminateX(); loop_iteration++) {
         if ((loop_iteration % DIAG_REPORT_EVERY_N_LOOP_ITERATIONS) == 0) {
@@ -348,8 +439,7 @@ THD_FUNCTION(solar, arg)
 
     	OD_RAM.x6002_MPPT.LT1618_IADJ = pao_state.iadj_uv / 1000;
 
-		//Only PAO implemented for the time being
-		OD_RAM.x6002_MPPT.algorithm = MPPT_ALGORITHM_PAO;
+		OD_RAM.x6002_MPPT.algorithm = MPPT_ALGORITHM_VSPAO;
 
         //Update tLast for the next loop's energy calculation
         tLast = TIME_I2MS(chVTGetSystemTime());
@@ -358,6 +448,9 @@ THD_FUNCTION(solar, arg)
 
 
     /* Stop drivers */
+#if defined(LINE_ALERT)
+    palDisableLineEvent(LINE_ALERT);
+#endif
     dacStop(&DACD1);
     ina226Stop(&ina226dev);
 
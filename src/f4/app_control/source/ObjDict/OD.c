@@ -69,13 +69,30 @@ OD_ATTR_RAM OD_RAM_t OD_RAM = {
     .x2100_errorStatusBits = {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00},
     .x6000_C3_State = {'B', 0},
     .x7000_C3_Telemetry = {
-        .highestSub_indexSupported = 0x06,
+        .highestSub_indexSupported = 0x17,
         .uptime = 0x00000000,
         .eMMC_Usage = 0x00,
         .UHF_Temperature = 0,
         .UHF_FWD_Pwr = 0x0000,
         .UHF_REV_Pwr = 0x0000,
-        .OPD_Current = 0x00
+        .OPD_Current = 0x00,
+        .FW_FlashProgress = 0x00,
+        .LBandRX_CRC_Fail = 0x00000000,
+        .LBandRX_AddrFail = 0x00000000,
+        .LBandRX_SizeFail = 0x00000000,
+        .LBandRX_Abort = 0x00000000,
+        .UHF_RX_CRC_Fail = 0x00000000,
+        .UHF_RX_AddrFail = 0x00000000,
+        .UHF_RX_SizeFail = 0x00000000,
+        .UHF_RX_Abort = 0x00000000,
+        .VC2_Accepted = 0x00000000,
+        .VC2_Rejected = 0x00000000,
+        .VC2_Retransmits = 0x00000000,
+        .VC2_Lockouts = 0x00000000,
+        .VC2_CLCW = 0x00000000,
+        .Downlink_HighRate = 0x00,
+        .Link_FER = 0x00,
+        .Link_Switches = 0x00000000
     },
     .x7001_battery = {
         .highestSub_indexSupported = 0x2C,
@@ -1874,7 +1891,7 @@ typedef struct {
     OD_obj_array_t o_6005_cryptoKeys;
     OD_obj_record_t o_6006_CCSDS[2];
     OD_obj_record_t o_6007_APRS[4];
-    OD_obj_record_t o_7000_C3_Telemetry[7];
+    OD_obj_record_t o_7000_C3_Telemetry[24];
     OD_obj_record_t o_7001_battery[45];
     OD_obj_record_t o_7002_battery[45];
     OD_obj_record_t o_7003_solarPanel[17];
@@ -8232,6 +8249,108 @@ static CO_PROGMEM ODObjs_t ODObjs = {
             .subIndex = 6,
             .attribute = ODA_SDO_R,
             .dataLength = 1
+        },
+        {
+            .dataOrig = &OD_RAM.x7000_C3_Telemetry.FW_FlashProgress,
+            .subIndex = 7,
+            .attribute = ODA_SDO_R,
+            .dataLength = 1
+        },
+        {
+            .dataOrig = &OD_RAM.x7000_C3_Telemetry.LBandRX_CRC_Fail,
+            .subIndex = 8,
+            .attribute = ODA_SDO_R | ODA_MB,
+            .dataLength = 4
+        },
+        {
+            .dataOrig = &OD_RAM.x7000_C3_Telemetry.LBandRX_AddrFail,
+            .subIndex = 9,
+            .attribute = ODA_SDO_R | ODA_MB,
+            .dataLength = 4
+        },
+        {
+            .dataOrig = &OD_RAM.x7000_C3_Telemetry.LBandRX_SizeFail,
+            .subIndex = 10,
+            .attribute = ODA_SDO_R | ODA_MB,
+            .dataLength = 4
+        },
+        {
+            .dataOrig = &OD_RAM.x7000_C3_Telemetry.LBandRX_Abort,
+            .subIndex = 11,
+            .attribute = ODA_SDO_R | ODA_MB,
+            .dataLength = 4
+        },
+        {
+            .dataOrig = &OD_RAM.x7000_C3_Telemetry.UHF_RX_CRC_Fail,
+            .subIndex = 12,
+            .attribute = ODA_SDO_R | ODA_MB,
+            .dataLength = 4
+        },
+        {
+            .dataOrig = &OD_RAM.x7000_C3_Telemetry.UHF_RX_AddrFail,
+            .subIndex = 13,
+            .attribute = ODA_SDO_R | ODA_MB,
+            .dataLength = 4
+        },
+        {
+            .dataOrig = &OD_RAM.x7000_C3_Telemetry.UHF_RX_SizeFail,
+            .subIndex = 14,
+            .attribute = ODA_SDO_R | ODA_MB,
+            .dataLength = 4
+        },
+        {
+            .dataOrig = &OD_RAM.x7000_C3_Telemetry.UHF_RX_Abort,
+            .subIndex = 15,
+            .attribute = ODA_SDO_R | ODA_MB,
+            .dataLength = 4
+        },
+        {
+            .dataOrig = &OD_RAM.x7000_C3_Telemetry.VC2_Accepted,
+            .subIndex = 16,
+            .attribute = ODA_SDO_R | ODA_MB,
+            .dataLength = 4
+        },
+        {
+            .dataOrig = &OD_RAM.x7000_C3_Telemetry.VC2_Rejected,
+            .subIndex = 17,
+            .attribute = ODA_SDO_R | ODA_MB,
+            .dataLength = 4
+        },
+        {
+            .dataOrig = &OD_RAM.x7000_C3_Telemetry.VC2_Retransmits,
+            .subIndex = 18,
+            .attribute = ODA_SDO_R | ODA_MB,
+            .dataLength = 4
+        },
+        {
+            .dataOrig = &OD_RAM.x7000_C3_Telemetry.VC2_Lockouts,
+            .subIndex = 19,
+            .attribute = ODA_SDO_R | ODA_MB,
+            .dataLength = 4
+        },
+        {
+            .dataOrig = &OD_RAM.x7000_C3_Telemetry.VC2_CLCW,
+            .subIndex = 20,
+            .attribute = ODA_SDO_R | ODA_MB,
+            .dataLength = 4
+        },
+        {
+            .dataOrig = &OD_RAM.x7000_C3_Telemetry.Downlink_HighRate,
+            .subIndex = 21,
+            .attribute = ODA_SDO_R,
+            .dataLength = 1
+        },
+        {
+            .dataOrig = &OD_RAM.x7000_C3_Telemetry.Link_FER,
+            .subIndex = 22,
+            .attribute = ODA_SDO_R,
+            .dataLength = 1
+        },
+        {
+            .dataOrig = &OD_RAM.x7000_C3_Telemetry.Link_Switches,
+            .subIndex = 23,
+            .attribute = ODA_SDO_R | ODA_MB,
+            .dataLength = 4
         }
     },
     .o_7001_battery = {
@@ -10338,7 +10457,7 @@ static OD_ATTR_OD OD_entry_t ODList[] = {
     {0x6005, 0x05, ODT_ARR, &ODObjs.o_6005_cryptoKeys, NULL},
     {0x6006, 0x02, ODT_REC, &ODObjs.o_6006_CCSDS, NULL},
     {0x6007, 0x04, ODT_REC, &ODObjs.o_6007_APRS, NULL},
-    {0x7000, 0x07, ODT_REC, &ODObjs.o_7000_C3_Telemetry, NULL},
+    {0x7000, 0x18, ODT_REC, &ODObjs.o_7000_C3_Telemetry, NULL},
     {0x7001, 0x2D, ODT_REC, &ODObjs.o_7001_battery, NULL},
     {0x7002, 0x2D, ODT_REC, &ODObjs.o_7002_battery, NULL},
     {0x7003, 0x11, ODT_REC, &ODObjs.o_7003_solarPanel, NULL},
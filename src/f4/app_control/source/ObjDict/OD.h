@@ -121,6 +121,23 @@ typedef struct {
         uint16_t UHF_FWD_Pwr;
         uint16_t UHF_REV_Pwr;
         uint8_t OPD_Current;
+        uint8_t FW_FlashProgress;
+        uint32_t LBandRX_CRC_Fail;
+        uint32_t LBandRX_AddrFail;
+        uint32_t LBandRX_SizeFail;
+        uint32_t LBandRX_Abort;
+        uint32_t UHF_RX_CRC_Fail;
+        uint32_t UHF_RX_AddrFail;
+        uint32_t UHF_RX_SizeFail;
+        uint32_t UHF_RX_Abort;
+        uint32_t VC2_Accepted;
+        uint32_t VC2_Rejected;
+        uint32_t VC2_Retransmits;
+        uint32_t VC2_Lockouts;
+        uint32_t VC2_CLCW;
+        uint8_t Downlink_HighRate;
+        uint8_t Link_FER;
+        uint32_t Link_Switches;
     } x7000_C3_Telemetry;
     struct {
         uint8_t highestSub_indexSupported;
@@ -1,10 +1,10 @@
+#include <assert.h>
 #include "beacon.h"
 #include "comms.h"
 #include "CANopen.h"
 #include "OD.h"
 #include "ax25.h"
 #include "rtc.h"
-#include "crc.h"
 #include "fs.h"
 
 /* TODO: Re-implement with OD interface */
@@ -17,6 +17,8 @@ static const ax25_link_t ax25 = {
     .sid = AX25_PID_NONE,
 };
 
+static_assert(TLM_MAX_LEN <= AX25_MAX_PAYLOAD_LEN, "beacon payload exceeds AX.25 info field");
+
 static time_t unix_time;
 static uint8_t bank_state;
 
@@ -291,50 +293,44 @@ static const tlm_item_t tlm_aprs0[] = {
     /* CFC Captures */
     { .type = TLM_PTR, .len = 4, .ptr = &OD_RAM.x7014_CFC.TEC_Captures },
 #endif /* ORESAT1 */
+    /* VC2 CLCW, so the ground sees the FARM state without any USLP downlink */
+    { .type = TLM_PTR, .len = 4, .ptr = &OD_RAM.x7000_C3_Telemetry.VC2_CLCW },
+    /* Selected engineering downlink rate, the beacon rate never changes */
+    { .type = TLM_PTR, .len = 1, .ptr = &OD_RAM.x7000_C3_Telemetry.Downlink_HighRate },
+};
+
+#define APRS0_ITEM_CNT              (sizeof(tlm_aprs0) / sizeof(tlm_item_t))
+
+static tlm_span_t aprs0_span[APRS0_ITEM_CNT];
+static tlm_prog_t aprs0_prog = {
+    .span = aprs0_span,
 };
 
-static const tlm_pkt_t aprs0 = {
-    .item_cnt = sizeof(tlm_aprs0) / sizeof(tlm_item_t),
+const tlm_pkt_t aprs0 = {
+    .item_cnt = APRS0_ITEM_CNT,
     .item = tlm_aprs0,
+    .prog = &aprs0_prog,
 };
 
 void *tlm_payload(fb_t *fb, const tlm_pkt_t *pkt)
 {
     void *tlm_start = fb->tail;
-    size_t len, total = 0;;
-    uint32_t crc;
+    size_t len = tlm_serialize(pkt, tlm_start);
 
-    for (unsigned int i = 0; i < pkt->item_cnt; i++) {
-        const tlm_item_t *item = &pkt->item[i];
-        switch (item->type) {
-        case TLM_MSG:
-            len = strlen(item->msg);
-            memcpy(fb_put(fb, len), item->msg, len);
-            break;
-        case TLM_PTR:
-            len = item->len;
-            memcpy(fb_put(fb, len), item->ptr, len);
-            break;
-        case TLM_VAL:
-            len = item->len;
-            memcpy(fb_put(fb, len), &item->val, len);
-            break;
-        default:
-            return NULL;
-        }
-        total += len;
+    if (len == 0) {
+        return NULL;
     }
-    crc = crc32(tlm_start, total, 0);
-    memcpy(fb_put(fb, sizeof(crc)), &crc, sizeof(crc));
+    fb_put(fb, len);
 
     return tlm_start;
 }
 
 void beacon_send(const radio_cfg_t *cfg)
 {
+    objects_fifo_t *fifo = radio_tx_fifo(cfg->devp);
     fb_t *fb = NULL;
     while (fb == NULL) {
-        fb = fb_alloc(AX25_MAX_FRAME_LEN, &tx_fifo);
+        fb = fb_alloc(AX25_MAX_FRAME_LEN, fifo);
     }
 
     OD_RAM.x7000_C3_Telemetry.uptime = TIME_I2S(chVTGetSystemTime());
@@ -348,7 +344,7 @@ void beacon_send(const radio_cfg_t *cfg)
 
     /* APRS Beacon */
     ax5043TX(cfg->devp, cfg->profile, fb->data, fb->len, fb->len, NULL, NULL, false);
-    fb_free(fb, &tx_fifo);
+    fb_free(fb, fifo);
     fb = NULL;
 }
 
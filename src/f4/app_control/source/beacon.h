@@ -4,27 +4,10 @@
 #include "ch.h"
 #include "hal.h"
 #include "radio.h"
+#include "ax25.h"
+#include "tlm.h"
 
-typedef enum {
-    TLM_MSG,
-    TLM_PTR,
-    TLM_VAL,
-} tlm_type_t;
-
-typedef struct tlm_item {
-    tlm_type_t          type;
-    size_t              len;
-    union {
-        char            *msg;
-        void            *ptr;
-        uint32_t        val;
-    };
-} tlm_item_t;
-
-typedef struct tlm_pkt {
-    size_t              item_cnt;
-    const tlm_item_t    *item;
-} tlm_pkt_t;
+extern const tlm_pkt_t aprs0;
 
 #ifdef __cplusplus
 extern "C" {
@@ -5,6 +5,7 @@
 #include "comms.h"
 #include "deployer.h"
 #include "fw.h"
+#include "fs.h"
 #include "worker.h"
 #include "CANopen.h"
 #include "OD.h"
@@ -274,6 +275,9 @@ THD_FUNCTION(c3, arg)
         };
 
         c3StateSave();
+
+        /* Correct drift in the filesystem usage count, rate limited */
+        fs_reconcile(&FSD1, false);
     }
 
     rtcSetCallback(&RTCD1, NULL);
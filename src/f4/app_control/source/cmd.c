@@ -1,3 +1,4 @@
+#include <string.h>
 #include "cmd.h"
 #include "c3.h"
 #include "fw.h"
@@ -6,12 +7,332 @@
 #include "rtc.h"
 #include "node_mgr.h"
 #include "CO_master.h"
+#include "crc.h"
+#include "CANopen.h"
+#include "OD.h"
 
-void cmd_process(cmd_t *cmd, fb_t *resp_fb)
+#define CMD_JOB_MAX                         4
+#define CMD_JOB_ARG_LEN                     128
+#define CMD_JOB_CRC_CHUNK                   512
+
+typedef struct {
+    uint8_t id;
+    cmd_job_state_t state;
+    uint8_t progress;
+    int32_t result;
+    uint32_t crc;
+    cmd_code_t cmd;
+    union {
+        cmd_flash_t flash;
+        uint8_t data[CMD_JOB_ARG_LEN];
+    } arg;
+} cmd_job_t;
+
+static cmd_job_t jobs[CMD_JOB_MAX];
+static uint8_t job_next_id = 1;
+static msg_t job_queue_buf[CMD_JOB_MAX];
+static MAILBOX_DECL(job_queue, job_queue_buf, CMD_JOB_MAX);
+static MUTEX_DECL(job_lock);
+static thread_t *job_runner_tp;
+static thread_t *job_tp;
+static THD_WORKING_AREA(job_runner_wa, 0x200);
+static THD_WORKING_AREA(job_wa, 0x1000);
+
+/* Checkpoint between chunks so cancel takes effect without leaving the file open */
+static int32_t job_file_crc(cmd_job_t *job, uint32_t *crc)
 {
+    uint8_t buf[CMD_JOB_CRC_CHUNK];
     lfs_file_t *file;
+    lfs_ssize_t len, n = 0;
+    lfs_size_t pos = 0;
+    uint32_t sum = 0;
+
+    file = file_open(&FSD1, (char*)job->arg.data, LFS_O_RDONLY);
+    if (file == NULL) {
+        return FSD1.err;
+    }
+    len = file_size(&FSD1, file);
+    if (len < 0) {
+        n = len;
+    }
+    while (len > 0 && (n = file_read(&FSD1, file, buf, sizeof(buf))) > 0) {
+        sum = crc32(buf, n, sum);
+        pos += n;
+        job->progress = (uint64_t)pos * 100U / len;
+        if (chThdShouldTerminateX()) {
+            n = FW_ERROR_CANCELLED;
+            break;
+        }
+    }
+    file_close(&FSD1, file);
+
+    /* A partial CRC is never reported, a cancel ends with n positive */
+    if (n != 0) {
+        return n;
+    }
+    *crc = sum;
+    return 0;
+}
+
+static THD_FUNCTION(job_thd, arg)
+{
+    cmd_job_t *job = arg;
+    int32_t result = 0;
+    uint32_t crc = 0;
+
+    switch (job->cmd) {
+    case CMD_FW_FLASH_JOB:
+        result = fw_flash(&EFLD1, job->arg.flash.filename, job->arg.flash.crc);
+        break;
+    case CMD_FW_VERIFY_JOB:
+        crc = fw_verify(&EFLD1, job->arg.data[0]);
+        result = (crc != 0 ? 0 : FLASH_ERROR_VERIFY);
+        break;
+    case CMD_FS_FORMAT_JOB:
+        result = fs_format(&FSD1);
+        break;
+    case CMD_FS_CRC_JOB:
+        result = job_file_crc(job, &crc);
+        break;
+    default:
+        break;
+    }
+
+    chMtxLock(&job_lock);
+    job->result = result;
+    job->crc = (result == 0 ? crc : 0);
+    if (job->state == JOB_RUNNING) {
+        job->state = JOB_DONE;
+        job->progress = 100;
+    }
+    chMtxUnlock(&job_lock);
+
+    chThdExit(MSG_OK);
+}
+
+/* Runs one job at a time, each in a fresh thread so it can be terminated */
+static THD_FUNCTION(job_runner, arg)
+{
+    (void)arg;
+    cmd_job_t *job;
+    thread_t *tp;
+
+    while (true) {
+        chMBFetchTimeout(&job_queue, (msg_t*)&job, TIME_INFINITE);
+        chMtxLock(&job_lock);
+        if (job->state != JOB_QUEUED) {
+            chMtxUnlock(&job_lock);
+            continue;
+        }
+        job->state = JOB_RUNNING;
+        /* Below the EDL workers so short commands preempt the job */
+        tp = job_tp = chThdCreateStatic(job_wa, sizeof(job_wa), NORMALPRIO - 1, job_thd, job);
+        chMtxUnlock(&job_lock);
+
+        chThdWait(tp);
+        chMtxLock(&job_lock);
+        job_tp = NULL;
+        /* Only now is the job off its arguments and the slot free */
+        if (job->state == JOB_CANCELLING) {
+            job->state = JOB_CANCELLED;
+        }
+        chMtxUnlock(&job_lock);
+    }
+}
+
+/**
+ * @brief   Queue a long running command to execute outside of the EDL workers.
+ *
+ * @param[in] cmd       Command to run, arguments are copied
+ *
+ * @return              Job ID, or 0 if the command was rejected or the queue is full
+ */
+uint8_t cmd_job_submit(const cmd_t *cmd)
+{
+    cmd_job_t *job;
+    uint8_t id = 0;
+    size_t len;
+
+    chMtxLock(&job_lock);
+    if (job_runner_tp == NULL) {
+        job_runner_tp = chThdCreateStatic(job_runner_wa, sizeof(job_runner_wa), NORMALPRIO, job_runner, NULL);
+    }
+
+    job = &jobs[job_next_id % CMD_JOB_MAX];
+    if (job->state == JOB_QUEUED || job->state == JOB_RUNNING ||
+            job->state == JOB_CANCELLING) {
+        goto out;
+    }
+    switch (cmd->cmd) {
+    case CMD_FW_FLASH_JOB:
+        len = strnlen(((cmd_flash_t*)cmd->arg)->filename, CMD_JOB_ARG_LEN - sizeof(cmd_flash_t));
+        if (len == CMD_JOB_ARG_LEN - sizeof(cmd_flash_t)) {
+            goto out;
+        }
+        memcpy(&job->arg, cmd->arg, sizeof(cmd_flash_t) + len + 1);
+        break;
+    case CMD_FW_VERIFY_JOB:
+        job->arg.data[0] = cmd->arg[0];
+        break;
+    case CMD_FS_FORMAT_JOB:
+        break;
+    case CMD_FS_CRC_JOB:
+        len = strnlen((char*)cmd->arg, CMD_JOB_ARG_LEN);
+        if (len == CMD_JOB_ARG_LEN) {
+            goto out;
+        }
+        memcpy(&job->arg, cmd->arg, len + 1);
+        break;
+    default:
+        goto out;
+    }
+
+    /* Cancelled jobs may still hold a queue slot until the runner skips them */
+    if (chMBPostTimeout(&job_queue, (msg_t)job, TIME_IMMEDIATE) != MSG_OK) {
+        goto out;
+    }
+    id = job->id = job_next_id;
+    job->cmd = cmd->cmd;
+    job->state = JOB_QUEUED;
+    job->progress = 0;
+    job->result = 0;
+    job->crc = 0;
+    /* Skip 0, it marks a rejected submission */
+    if (++job_next_id == 0) {
+        job_next_id = 1;
+    }
+
+out:
+    chMtxUnlock(&job_lock);
+    return id;
+}
+
+/**
+ * @brief   Query the state of a job.
+ *
+ * @param[in]  id       Job ID returned by @p cmd_job_submit()
+ * @param[out] status   Job status
+ *
+ * @return              False if the job is unknown or has been recycled
+ */
+bool cmd_job_status(uint8_t id, cmd_job_status_t *status)
+{
+    cmd_job_t *job = &jobs[id % CMD_JOB_MAX];
+    bool found;
+
+    chMtxLock(&job_lock);
+    found = (id != 0 && job->id == id);
+    status->id = id;
+    status->state = (found ? job->state : JOB_NONE);
+    status->progress = (found ? job->progress : 0);
+    status->result = (found ? job->result : 0);
+    status->crc = (found ? job->crc : 0);
+    if (found && job->state == JOB_RUNNING && job->cmd == CMD_FW_FLASH_JOB) {
+        status->progress = OD_RAM.x7000_C3_Telemetry.FW_FlashProgress;
+    }
+    chMtxUnlock(&job_lock);
+
+    return found;
+}
+
+/**
+ * @brief   Cancel a job.
+ * @note    Queued jobs are dropped. Running jobs are JOB_CANCELLING until
+ *          they stop at their next checkpoint: between flash chunks for FW
+ *          Flash and FW Verify, between reads for FS CRC. FS Format runs to
+ *          completion.
+ *
+ * @param[in] id        Job ID returned by @p cmd_job_submit()
+ *
+ * @return              Job state after the request
+ */
+cmd_job_state_t cmd_job_cancel(uint8_t id)
+{
+    cmd_job_t *job = &jobs[id % CMD_JOB_MAX];
+    cmd_job_state_t state = JOB_NONE;
+
+    chMtxLock(&job_lock);
+    if (id != 0 && job->id == id) {
+        if (job->state == JOB_RUNNING && job->cmd != CMD_FS_FORMAT_JOB) {
+            chThdTerminate(job_tp);
+            job->state = JOB_CANCELLING;
+        } else if (job->state == JOB_QUEUED) {
+            job->state = JOB_CANCELLED;
+        }
+        state = job->state;
+    }
+    chMtxUnlock(&job_lock);
+
+    return state;
+}
+
+/* Argument bytes each command reads unconditionally, 0 for the ones without */
+static const uint8_t cmd_arg_min[] = {
+    [CMD_TX_CTRL]           = 1,
+    [CMD_FW_FLASH]          = sizeof(cmd_flash_t) + 1,
+    [CMD_FW_BANK]           = 1,
+    [CMD_FW_VERIFY]         = 1,
+    [CMD_C3_SOFTRESET]      = 2 * sizeof(uint32_t),
+    [CMD_C3_HARDRESET]      = 2 * sizeof(uint32_t),
+    [CMD_C3_FACTORYRESET]   = 2 * sizeof(uint32_t),
+    [CMD_FS_REMOVE]         = 1,
+    [CMD_FS_CRC]            = 1,
+    [CMD_NODE_ENABLE]       = 2,
+    [CMD_NODE_STATUS]       = 1,
+    [CMD_OPD_SCAN]          = 1,
+    [CMD_OPD_ENABLE]        = 2,
+    [CMD_OPD_RESET]         = 1,
+    [CMD_OPD_STATUS]        = 1,
+    [CMD_RTC_SETTIME]       = sizeof(uint32_t),
+    [CMD_SDO_WRITE]         = sizeof(cmd_sdo_t),
+    [CMD_JOB_STATUS]        = 1,
+    [CMD_JOB_CANCEL]        = 1,
+    [CMD_FW_FLASH_JOB]      = sizeof(cmd_flash_t) + 1,
+    [CMD_FW_VERIFY_JOB]     = 1,
+    [CMD_FS_CRC_JOB]        = 1,
+};
+
+/* Check an uplinked command against its frame before anything reads the arguments */
+static bool cmd_valid(const cmd_t *cmd, size_t len)
+{
+    size_t arg_len;
+
+    if (len < sizeof(cmd_t) || (unsigned)cmd->cmd >= sizeof(cmd_arg_min))
+        return false;
+    arg_len = len - sizeof(cmd_t);
+    if (arg_len < cmd_arg_min[cmd->cmd])
+        return false;
+
+    switch (cmd->cmd) {
+    case CMD_FW_FLASH:
+    case CMD_FW_FLASH_JOB:
+        return memchr(((const cmd_flash_t*)cmd->arg)->filename, '\0', arg_len - sizeof(cmd_flash_t)) != NULL;
+    case CMD_FS_REMOVE:
+    case CMD_FS_CRC:
+    case CMD_FS_CRC_JOB:
+        return memchr(cmd->arg, '\0', arg_len) != NULL;
+    case CMD_SDO_WRITE:
+        return ((const cmd_sdo_t*)cmd->arg)->size <= arg_len - sizeof(cmd_sdo_t);
+    default:
+        return true;
+    }
+}
+
+/**
+ * @brief   Execute a command and build its response.
+ * @note    Commands that are truncated or unknown get a response holding
+ *          only the sequence number.
+ *
+ * @param[in] cmd       Command from the uplink frame
+ * @param[in] len       Frame length, including the command code
+ * @param[out] resp_fb  Response frame buffer
+ */
+void cmd_process(cmd_t *cmd, size_t len, fb_t *resp_fb)
+{
     cmd_flash_t *flash_arg;
+    lfs_file_t *file;
     uint32_t *key;
+    cmd_sdo_t *sdo;
     void *ret;
 
     //Add 32 bits for sequence number
@@ -19,6 +340,9 @@ void cmd_process(cmd_t *cmd, fb_t *resp_fb)
     //Put sequence number into the response buffer
     *((uint32_t*)ret) = OD_PERSIST_STATE.x6004_persistentState.EDL_SequenceCount - 1;
 
+    if (!cmd_valid(cmd, len))
+        return;
+
     switch (cmd->cmd) {
     case CMD_TX_CTRL:
         ret = fb_put(resp_fb, 1);
@@ -38,6 +362,14 @@ void cmd_process(cmd_t *cmd, fb_t *resp_fb)
         ret = fb_put(resp_fb, sizeof(uint32_t));
         *((uint32_t*)ret) = fw_verify(&EFLD1, cmd->arg[0]);
         break;
+    case CMD_FW_FLASH_JOB:
+    case CMD_FW_VERIFY_JOB:
+    case CMD_FS_FORMAT_JOB:
+    case CMD_FS_CRC_JOB:
+        /* Long running, reply with a job ID to poll with CMD_JOB_STATUS */
+        ret = fb_put(resp_fb, 1);
+        *((uint8_t*)ret) = cmd_job_submit(cmd);
+        break;
     case CMD_C3_SOFTRESET:
         key = (uint32_t*)cmd->arg;
         if (key[0] == 0x67452301U && key[1] == 0xEFCDAB89U)
@@ -120,17 +452,20 @@ void cmd_process(cmd_t *cmd, fb_t *resp_fb)
         rtcSetTimeUnix(*((uint32_t*)cmd->arg), 0);
         *((uint32_t*)ret) = rtcGetTimeUnix(NULL);
         break;
+    case CMD_JOB_STATUS:
+        ret = fb_put(resp_fb, sizeof(cmd_job_status_t));
+        cmd_job_status(cmd->arg[0], ret);
+        break;
+    case CMD_JOB_CANCEL:
+        ret = fb_put(resp_fb, 1);
+        *((uint8_t*)ret) = cmd_job_cancel(cmd->arg[0]);
+        break;
     case CMD_SDO_WRITE:
         ret = fb_put(resp_fb, 1);
-        struct __attribute__((packed)) {
-            uint8_t node_id;
-            uint16_t index;
-            uint8_t subindex;
-            size_t size;
-            uint8_t data[];
-        } *sdo_arg = (void*)cmd->arg;
-        sdo_transfer(SDO_CLI_WRITE, sdo_arg->node_id, sdo_arg->index, sdo_arg->subindex, sdo_arg->size, sdo_arg->size, sdo_arg->data);
+        sdo = (cmd_sdo_t*)cmd->arg;
+        sdo_transfer(SDO_CLI_WRITE, sdo->node_id, sdo->index, sdo->subindex, sdo->size, sdo->size, sdo->data);
         *((uint8_t*)ret) = 0;
+        break;
     default:
         break;
     }
@@ -26,13 +26,47 @@ typedef enum {
     CMD_OPD_STATUS,
     CMD_RTC_SETTIME,
     CMD_SDO_WRITE,
+    CMD_JOB_STATUS,
+    CMD_JOB_CANCEL,
+    /* Background variants of the long commands, reply with a job ID */
+    CMD_FW_FLASH_JOB,
+    CMD_FW_VERIFY_JOB,
+    CMD_FS_FORMAT_JOB,
+    CMD_FS_CRC_JOB,
 } cmd_code_t;
 
+typedef enum {
+    JOB_NONE = 0,
+    JOB_QUEUED,
+    JOB_RUNNING,
+    JOB_DONE,
+    JOB_CANCELLED,
+    /* Cancel requested, the job has not reached a checkpoint yet */
+    JOB_CANCELLING,
+} cmd_job_state_t;
+
 typedef struct {
     uint32_t crc;
     char filename[];
 } cmd_flash_t;
 
+typedef struct __attribute__((packed)) {
+    uint8_t node_id;
+    uint16_t index;
+    uint8_t subindex;
+    uint32_t size;
+    uint8_t data[];
+} cmd_sdo_t;
+
+typedef struct __attribute__((packed)) {
+    uint8_t id;
+    uint8_t state;
+    uint8_t progress;
+    int32_t result;
+    /* FS CRC and FW Verify jobs that finished with result 0, else 0 */
+    uint32_t crc;
+} cmd_job_status_t;
+
 typedef struct {
     cmd_code_t cmd;
     uint8_t arg[];
@@ -42,7 +76,10 @@ typedef struct {
 extern "C" {
 #endif
 
-void cmd_process(cmd_t *cmd, fb_t *resp_fb);
+void cmd_process(cmd_t *cmd, size_t len, fb_t *resp_fb);
+uint8_t cmd_job_submit(const cmd_t *cmd);
+bool cmd_job_status(uint8_t id, cmd_job_status_t *status);
+cmd_job_state_t cmd_job_cancel(uint8_t id);
 
 #ifdef __cplusplus
 }
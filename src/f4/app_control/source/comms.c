@@ -1,3 +1,4 @@
+#include <string.h>
 #include "ch.h"
 #include "hal.h"
 #include "comms.h"
@@ -8,6 +9,9 @@
 #include "rtc.h"
 #include "uslp.h"
 #include "hmac.h"
+#include "farm.h"
+#include "fec.h"
+#include "link.h"
 #include "CANopen.h"
 #include "OD.h"
 
@@ -21,7 +25,37 @@ static inline void vc_unlock(void *arg) {
     chMtxUnlock(mutex);
 }
 
+/* Transmit frame buffer pools, one per radio so each transmitter drains its own */
+pdu_queue_t lband_txq;
+pdu_queue_t uhf_txq;
+
+/* EDL worker stage timing, guarded by stats_lock */
+static edl_stats_t edl_stats;
+static MUTEX_DECL(stats_lock);
+
+static void edl_stage_add(edl_stage_t *stage, rtcnt_t start)
+{
+    rtcnt_t dt = chSysGetRealtimeCounterX() - start;
+
+    chMtxLock(&stats_lock);
+    stage->count++;
+    stage->sum += dt;
+    if (dt > stage->max)
+        stage->max = dt;
+    chMtxUnlock(&stats_lock);
+}
+
 #if (USLP_USE_SDLS == TRUE)
+/* SDLS verification, timed on its own so HMAC cost shows up separately */
+static int edl_hmac_recv(void *data, size_t len, void *iv, void *seq_num, void *mac, void *arg)
+{
+    rtcnt_t start = chSysGetRealtimeCounterX();
+    int ret = hmac_recv(data, len, iv, seq_num, mac, arg);
+
+    edl_stage_add(&edl_stats.auth, start);
+    return ret;
+}
+
 static const sdls_cfg_t sdls_cfg = {
     .spi            = 1,
     .iv_len         = 0,
@@ -30,7 +64,7 @@ static const sdls_cfg_t sdls_cfg = {
     .mac_len        = 32,
     .send_func      = NULL,
     .send_arg       = NULL,
-    .recv_func      = hmac_recv,
+    .recv_func      = edl_hmac_recv,
     .recv_arg       = OD_PERSIST_KEYS.x6005_cryptoKeys[0],
 };
 #endif
@@ -67,7 +101,7 @@ static const uslp_vc_t vc0 = {
     .cop            = COP_NONE,
     .mapid[0]       = &map_cmd,
     .trunc_tf_len   = USLP_MAX_LEN,
-    .ocf            = false,
+    .ocf            = true,
 #if (USLP_USE_SDLS == TRUE)
     .sdls_cfg       = &sdls_cfg,
 #endif
@@ -82,22 +116,51 @@ static const uslp_vc_t vc1 = {
     .mapid[0]       = &map_file,
     .mapid[1]       = &map_beacon,
     .trunc_tf_len   = USLP_MAX_LEN,
-    .ocf            = false,
+    .ocf            = true,
 #if (USLP_USE_SDLS == TRUE)
     .sdls_cfg       = NULL,
 #endif
 };
 
-/*
+static const uslp_map_t map_cmd_seq = {
+    .sdu            = SDU_MAP_ACCESS,
+    .upid           = UPID_MAPA_SDU,
+    .max_pkt_len    = CMD_RESP_LEN,
+    .incomplete     = false,
+    .map_recv       = comms_cmd_seq,
+};
+
+static const uslp_map_t map_file_seq = {
+    .sdu            = SDU_MAP_ACCESS,
+    .upid           = UPID_MAPA_SDU,
+    .max_pkt_len    = FILE_BUF_LEN + sizeof(file_xfr_t),
+    .incomplete     = false,
+    .map_recv       = comms_file_seq,
+};
+
+static const uslp_map_t map_cop = {
+    .sdu            = SDU_MAP_ACCESS,
+    .upid           = UPID_MAPA_SDU,
+    .max_pkt_len    = 8,
+    .incomplete     = false,
+    .map_recv       = comms_cop,
+};
+
+/* Downlink frame counters for VC2 */
+static uint32_t vc2_seq_cnt;
+static uint32_t vc2_exp_cnt;
+
+/* FARM-1 runs in comms on frames already authenticated by the USLP stack */
 static MUTEX_DECL(vc2_lock);
 static const uslp_vc_t vc2 = {
-    .seq_ctrl_len   = sizeof(OD_PERSIST_STATE.x6004_persistentState.VC2_SequenceCount),
-    .expedited_len  = sizeof(OD_PERSIST_STATE.x6004_persistentState.VC2_ExpediteCount),
-    .seq_ctrl_cnt   = &OD_PERSIST_STATE.x6004_persistentState.VC2_SequenceCount,
-    .expedited_cnt  = &OD_PERSIST_STATE.x6004_persistentState.VC2_ExpediteCount,
-    .cop            = COP_1,
-    .mapid[0]       = &map_cmd,
-    .mapid[1]       = &map_file,
+    .seq_ctrl_len   = sizeof(vc2_seq_cnt),
+    .expedited_len  = sizeof(vc2_exp_cnt),
+    .seq_ctrl_cnt   = &vc2_seq_cnt,
+    .expedited_cnt  = &vc2_exp_cnt,
+    .cop            = COP_NONE,
+    .mapid[0]       = &map_cmd_seq,
+    .mapid[1]       = &map_file_seq,
+    .mapid[2]       = &map_cop,
     .trunc_tf_len   = USLP_MAX_LEN,
     .ocf            = true,
     .lock_arg       = &vc2_lock,
@@ -107,14 +170,13 @@ static const uslp_vc_t vc2 = {
     .sdls_cfg       = &sdls_cfg,
 #endif
 };
-*/
 
 const uslp_mc_t mc = {
     .scid           = &OD_PERSIST_APP.x6006_CCSDS.spacecraftID,
     .owner          = true,
     .vcid[0]        = &vc0,
     .vcid[1]        = &vc1,
-    /*.vcid[2]        = &vc2,*/
+    .vcid[2]        = &vc2,
 };
 
 static const uslp_pc_t lband_pc = {
@@ -122,6 +184,10 @@ static const uslp_pc_t lband_pc = {
     .tf_len         = USLP_MAX_LEN,
     .fecf           = FECF_HW,
     .fecf_len       = FECF_LEN,
+    .phy_send       = pdu_send,
+    .phy_send_ahead = pdu_send_ahead,
+    .send_arg       = &lband_txq.fifo,
+    .send_ahead_arg = &lband_txq.fifo,
 };
 
 static const uslp_pc_t uhf_pc = {
@@ -131,14 +197,18 @@ static const uslp_pc_t uhf_pc = {
     .fecf_len       = FECF_LEN,
     .phy_send       = pdu_send,
     .phy_send_ahead = pdu_send_ahead,
-    .send_arg       = &tx_fifo,
-    .send_ahead_arg = &tx_fifo,
+    .send_arg       = &uhf_txq.fifo,
+    .send_ahead_arg = &uhf_txq.fifo,
 };
 
 static const uslp_link_t edl_lband_link = {
     .mc = &mc,
     .pc_rx = &lband_pc,
+#if (EDL_LBAND_DOWNLINK == TRUE)
+    .pc_tx = &lband_pc,
+#else
     .pc_tx = &uhf_pc,
+#endif
 };
 
 static const uslp_link_t edl_uhf_link = {
@@ -376,7 +446,9 @@ static const ax5043_profile_t uhf_eng[] = {
     /* Packet Controller */
     {AX5043_REG_PKTCHUNKSIZE, AX5043_PKTCHUNKSIZE_240, 1},
     {AX5043_REG_PKTMISCFLAGS, AX5043_PKTMISCFLAGS_BGNDRSSI, 1},
-    {AX5043_REG_PKTSTOREFLAGS, AX5043_PKTSTOREFLAGS_RSSI | AX5043_PKTSTOREFLAGS_CRCB, 1},
+    /* RF offset feeds the downlink rate selection */
+    {AX5043_REG_PKTSTOREFLAGS, AX5043_PKTSTOREFLAGS_RSSI | AX5043_PKTSTOREFLAGS_RFOFFS |
+                               AX5043_PKTSTOREFLAGS_CRCB, 1},
     {AX5043_REG_PKTACCEPTFLAGS, AX5043_PKTACCEPTFLAGS_LRGP, 1},
 
     /* Performance Tuning Registers */
@@ -483,6 +555,13 @@ static const ax5043_profile_t uhf_ax25[] = {
     {0, 0, 0}
 };
 
+/* Low rate downlink overlay for uhf_eng, 9.6 kbps MSK */
+static const ax5043_profile_t uhf_eng_low[] = {
+    {AX5043_REG_FSKDEV, 0x0009D5, 3},
+    {AX5043_REG_TXRATE, 0x002752, 3},
+    {0, 0, 0}
+};
+
 static const uint8_t preamble[] = {
     AX5043_CHUNKCMD_TXCTRL | _VAL2FLD(AX5043_FIFOCHUNK_SIZE, 1),
     AX5043_CHUNK_TXCTRL_SETPA | AX5043_CHUNK_TXCTRL_PASTATE,
@@ -501,6 +580,64 @@ static const uint8_t postamble[] = {
     AX5043_CHUNK_TXCTRL_SETPA
 };
 
+/* Downlink rate selection from UHF receive quality, guarded by link_lock */
+static link_t dl_link;
+static MUTEX_DECL(link_lock);
+
+static void link_update_od(void)
+{
+    OD_RAM.x7000_C3_Telemetry.Downlink_HighRate = dl_link.high;
+    OD_RAM.x7000_C3_Telemetry.Link_FER = dl_link.fer;
+    OD_RAM.x7000_C3_Telemetry.Link_Switches = dl_link.switches;
+}
+
+static void rx_err(const void *arg, uint8_t flags) {
+    uint32_t *crc, *addr, *size, *abort;
+
+    if (arg == &edl_uhf_link) {
+        chMtxLock(&link_lock);
+        link_error(&dl_link, chVTGetSystemTime());
+        link_update_od();
+        chMtxUnlock(&link_lock);
+    }
+
+    if (arg == &edl_lband_link) {
+        crc = &OD_RAM.x7000_C3_Telemetry.LBandRX_CRC_Fail;
+        addr = &OD_RAM.x7000_C3_Telemetry.LBandRX_AddrFail;
+        size = &OD_RAM.x7000_C3_Telemetry.LBandRX_SizeFail;
+        abort = &OD_RAM.x7000_C3_Telemetry.LBandRX_Abort;
+    } else if (arg == &edl_uhf_link) {
+        crc = &OD_RAM.x7000_C3_Telemetry.UHF_RX_CRC_Fail;
+        addr = &OD_RAM.x7000_C3_Telemetry.UHF_RX_AddrFail;
+        size = &OD_RAM.x7000_C3_Telemetry.UHF_RX_SizeFail;
+        abort = &OD_RAM.x7000_C3_Telemetry.UHF_RX_Abort;
+    } else {
+        return;
+    }
+
+    if (flags & AX5043_CHUNK_DATARX_CRCFAIL)
+        *crc += 1;
+    if (flags & AX5043_CHUNK_DATARX_ADDRFAIL)
+        *addr += 1;
+    if (flags & AX5043_CHUNK_DATARX_SIZEFAIL)
+        *size += 1;
+    if (flags & AX5043_CHUNK_DATARX_ABORT)
+        *abort += 1;
+}
+
+/* Called by the RX worker for each intact frame, with that frame's RSSI and offset */
+static void rx_frame(const void *arg, int8_t rssi, uint32_t rf_freq_off) {
+    if (arg != &edl_uhf_link)
+        return;
+
+    /* RFFREQOFFS is 24-bit two's complement in units of f_xtal / 2^24 */
+    int32_t foff = ((int64_t)((int32_t)(rf_freq_off << 8) >> 8) * XTAL_CLK) >> 24;
+    chMtxLock(&link_lock);
+    link_frame(&dl_link, chVTGetSystemTime(), rssi, foff);
+    link_update_od();
+    chMtxUnlock(&link_lock);
+}
+
 static const SPIConfig lband_spicfg = {
     false,
     NULL,                                   /* Operation complete callback */
@@ -531,8 +668,9 @@ static const AX5043Config lbandcfg = {
     .miso           = LINE_SPI1_MISO,
     .irq            = LINE_LBAND_IRQ,
     .xtal_freq      = XTAL_CLK,
-    .fifo           = &rx_fifo,
+    .fifo           = &rx_queue.fifo,
     .phy_arg        = &edl_lband_link,
+    .rx_err_cb      = rx_err,
     .profile        = lband_low,
 };
 
@@ -542,8 +680,10 @@ static const AX5043Config uhfcfg = {
     .miso           = LINE_SPI1_MISO,
     .irq            = LINE_UHF_IRQ,
     .xtal_freq      = XTAL_CLK,
-    .fifo           = &rx_fifo,
+    .fifo           = &rx_queue.fifo,
     .phy_arg        = &edl_uhf_link,
+    .rx_err_cb      = rx_err,
+    .rx_frame_cb    = rx_frame,
     .profile        = uhf_eng,
     .preamble       = preamble,
     .preamble_len   = sizeof(preamble),
@@ -583,6 +723,12 @@ static const radio_cfg_t uhf_eng_cfg = {
     .name = "UHF Engineering",
 };
 
+static const radio_cfg_t uhf_eng_low_cfg = {
+    .devp = &uhf,
+    .profile = uhf_eng_low,
+    .name = "UHF Engineering Low Rate",
+};
+
 static const radio_cfg_t uhf_ax25_cfg = {
     .devp = &uhf,
     .profile = uhf_ax25,
@@ -595,9 +741,9 @@ synth_dev_t synth_devices[] = {
 };
 
 radio_dev_t radio_devices[] = {
-    {&lband, &lbandcfg, "L-Band"},
-    {&uhf, &uhfcfg, "UHF"},
-    {NULL, NULL, ""},
+    {&lband, &lbandcfg, "L-Band", &lband_txq},
+    {&uhf, &uhfcfg, "UHF", &uhf_txq},
+    {NULL, NULL, "", NULL},
 };
 
 radio_cfg_t radio_cfgs[] = {
@@ -611,20 +757,169 @@ radio_cfg_t radio_cfgs[] = {
 const radio_cfg_t *tx_eng = &uhf_eng_cfg;
 const radio_cfg_t *tx_ax25 = &uhf_ax25_cfg;
 
+/* A transmit worker per radio, so one transmitter's air time never holds up the other */
+typedef struct {
+    const radio_cfg_t *cfg;                 /* Profile frames go out with */
+    pdu_queue_t *txq;
+    const char *name;
+    thread_t *tp;
+    uint8_t rs_buf[FEC_RS_MAX_DEPTH * FEC_RS_N];
+    uint8_t conv_buf[FEC_CONV_LEN(FEC_RS_MAX_DEPTH * FEC_RS_N)];
+} tx_chan_t;
+
+static tx_chan_t tx_chans[] = {
+    {.cfg = &uhf_eng_cfg, .txq = &uhf_txq, .name = "UHF TX Worker"},
+    {.cfg = &lband_high_cfg, .txq = &lband_txq, .name = "L-Band TX Worker"},
+};
+
 static thread_t *edl_tp[EDL_WORKERS] = {NULL};
-static thread_t *tx_tp = NULL;
 static thread_t *beacon_tp = NULL;
 
+/* COP-1 receiver state for VC2, guarded by farm_lock */
+static farm_t vc2_farm;
+static MUTEX_DECL(farm_lock);
+
+/*
+ * CLCW for the OCF of every downlink frame, copied from vc2_farm under
+ * farm_lock. The TX workers read it in a critical section instead of taking
+ * farm_lock, which is held while a VC2 handler waits for a TX buffer.
+ */
+static uint32_t vc2_clcw;
+
+/* Sequence fields of the VC2 frame being delivered, valid under farm_lock */
+static struct {
+    bool valid;
+    bool bypass;
+    uint8_t ns;
+    objects_fifo_t *tx_fifo;                /* Queue the response goes out on */
+} vc2_rx;
+
+typedef struct {
+    uint16_t scid;
+    uint8_t vcid;
+    bool bypass;
+    bool ocf;
+    uint8_t ns;                             /* Low octet of the VC frame count */
+} uslp_hdr_t;
+
+/* Decode the USLP primary header fields COP-1 needs (CCSDS 732.1-B 4.1.2) */
+static bool uslp_hdr_parse(const fb_t *fb, uslp_hdr_t *hdr)
+{
+    const uint8_t *h = fb->data;
+    size_t cnt_len;
+
+    /* Truncated headers carry no sequence information */
+    if (fb->len < 7 || (h[0] >> 4) != USLP_TFVN || (h[3] & 0x01U))
+        return false;
+
+    hdr->scid = ((h[0] & 0x0FU) << 12) | (h[1] << 4) | (h[2] >> 4);
+    hdr->vcid = ((h[2] & 0x07U) << 3) | (h[3] >> 5);
+    hdr->bypass = h[6] & 0x80U;
+    hdr->ocf = h[6] & 0x08U;
+    cnt_len = h[6] & 0x07U;
+    if (fb->len < 7 + cnt_len)
+        return false;
+    hdr->ns = (cnt_len ? h[6 + cnt_len] : 0);
+    return true;
+}
+
+/* Responses are allocated from, and sent on, the queue of the link's downlink */
+static objects_fifo_t *edl_tx_fifo(const fb_t *fb)
+{
+    const uslp_link_t *link = fb->phy_arg;
+    return link->pc_tx->send_arg;
+}
+
+static bool tx_ready(objects_fifo_t *fifo)
+{
+    cnt_t free;
+
+    chSysLock();
+    free = chSemGetCounterI(&fifo->free.sem);
+    chSysUnlock();
+    return free > 0;
+}
+
+static void vc2_update_od(void)
+{
+    uint32_t clcw = farm_clcw(&vc2_farm);
+
+    chSysLock();
+    vc2_clcw = clcw;
+    chSysUnlock();
+    OD_RAM.x7000_C3_Telemetry.VC2_Accepted = vc2_farm.accepted;
+    OD_RAM.x7000_C3_Telemetry.VC2_Rejected = vc2_farm.rejected;
+    OD_RAM.x7000_C3_Telemetry.VC2_Retransmits = vc2_farm.retransmits;
+    OD_RAM.x7000_C3_Telemetry.VC2_Lockouts = vc2_farm.lockouts;
+    OD_RAM.x7000_C3_Telemetry.VC2_CLCW = clcw;
+}
+
+/* Called from the VC2 MAP handlers, at most once per frame */
+static bool vc2_accept(void)
+{
+    if (!vc2_rx.valid)
+        return false;
+    vc2_rx.valid = false;
+    bool accept = farm_frame(&vc2_farm, vc2_rx.bypass, vc2_rx.ns, tx_ready(vc2_rx.tx_fifo));
+    /* Update the CLCW before the response goes out */
+    vc2_update_od();
+    return accept;
+}
+
+/* Fill in the OCF of outgoing frames on any VC with the latest CLCW and downlink rate */
+static void set_ocf(fb_t *fb, bool high_rate)
+{
+    uslp_hdr_t hdr;
+    uint32_t clcw;
+
+    if (!uslp_hdr_parse(fb, &hdr) || !hdr.ocf ||
+            hdr.scid != OD_PERSIST_APP.x6006_CCSDS.spacecraftID || fb->len < 11)
+        return;
+
+    /* FECF is appended by the radio, so the OCF is the last word of the buffer */
+    chSysLock();
+    clcw = vc2_clcw;
+    chSysUnlock();
+    if (high_rate)
+        clcw |= FARM_CLCW_STATUS_HIGH_RATE;
+    uint8_t *ocf = &fb->data[fb->len - 4];
+    ocf[0] = clcw >> 24;
+    ocf[1] = clcw >> 16;
+    ocf[2] = clcw >> 8;
+    ocf[3] = clcw;
+}
+
 THD_FUNCTION(edl_thd, arg)
 {
     (void)arg;
     fb_t *fb;
     size_t len;
+    uslp_hdr_t hdr;
+    bool seq, ok;
+    rtcnt_t start;
 
     while (!chThdShouldTerminateX()) {
-        if ((fb = pdu_recv(&rx_fifo)) == NULL)
+        if ((fb = pdu_recv(&rx_queue.fifo)) == NULL)
             continue;
-        if (uslp_recv(fb->phy_arg, fb)) {
+        start = chSysGetRealtimeCounterX();
+
+        /* VC2 frames are delivered one at a time through the FARM */
+        seq = uslp_hdr_parse(fb, &hdr) && hdr.vcid == 2;
+        if (seq) {
+            chMtxLock(&farm_lock);
+            vc2_rx.valid = true;
+            vc2_rx.bypass = hdr.bypass;
+            vc2_rx.ns = hdr.ns;
+            vc2_rx.tx_fifo = edl_tx_fifo(fb);
+        }
+        ok = uslp_recv(fb->phy_arg, fb);
+        if (seq) {
+            vc2_rx.valid = false;
+            vc2_update_od();
+            chMtxUnlock(&farm_lock);
+        }
+
+        if (ok) {
             edl_enable(true);
             len = fb->len;
             if (fb->phy_arg == &edl_lband_link) {
@@ -637,27 +932,128 @@ THD_FUNCTION(edl_thd, arg)
         } else {
             OD_PERSIST_STATE.x6004_persistentState.EDL_RejectedCount += 1;
         }
-        fb_free(fb, &rx_fifo);
+        fb_free(fb, &rx_queue.fifo);
+
+        chMtxLock(&stats_lock);
+        if (ok)
+            edl_stats.accepted++;
+        else
+            edl_stats.rejected++;
+        chMtxUnlock(&stats_lock);
+        edl_stage_add(&edl_stats.total, start);
     }
 
     chThdExit(MSG_OK);
 }
 
+/* Downlink FEC, off by default so existing ground stations keep working, guarded by fec_lock */
+static uint8_t fec_depth;
+static bool fec_conv;
+static MUTEX_DECL(fec_lock);
+
+bool comms_set_fec(uint8_t depth, bool conv)
+{
+    /* Every frame has to fit the interleaved code block */
+    if (depth > FEC_RS_MAX_DEPTH || (depth != 0 && depth * FEC_RS_K < USLP_MAX_LEN))
+        return false;
+    chMtxLock(&fec_lock);
+    fec_depth = depth;
+    fec_conv = conv;
+    chMtxUnlock(&fec_lock);
+    return true;
+}
+
+void comms_get_fec(uint8_t *depth, bool *conv)
+{
+    chMtxLock(&fec_lock);
+    *depth = fec_depth;
+    *conv = fec_conv;
+    chMtxUnlock(&fec_lock);
+}
+
+/* Adaptive downlink rate, fixed to the high rate by default like before */
+void comms_set_link(link_mode_t mode)
+{
+    chMtxLock(&link_lock);
+    link_set_mode(&dl_link, mode);
+    link_update_od();
+    chMtxUnlock(&link_lock);
+}
+
+void comms_get_link(link_t *state)
+{
+    chMtxLock(&link_lock);
+    *state = dl_link;
+    chMtxUnlock(&link_lock);
+}
+
+void comms_get_stats(edl_stats_t *stats)
+{
+    chMtxLock(&stats_lock);
+    *stats = edl_stats;
+    chMtxUnlock(&stats_lock);
+}
+
+void comms_reset_stats(void)
+{
+    chMtxLock(&stats_lock);
+    memset(&edl_stats, 0, sizeof(edl_stats));
+    chMtxUnlock(&stats_lock);
+    pdu_reset_stats(&rx_queue.fifo);
+    for (size_t i = 0; i < sizeof(tx_chans) / sizeof(tx_chans[0]); i++) {
+        pdu_reset_stats(&tx_chans[i].txq->fifo);
+    }
+}
+
 THD_FUNCTION(tx_worker, arg)
 {
-    const radio_cfg_t *cfg = arg;
+    tx_chan_t *chan = arg;
+    const radio_cfg_t *cfg = chan->cfg;
+    objects_fifo_t *fifo = &chan->txq->fifo;
+    const radio_cfg_t *tx_cfg;
     fb_t *fb;
+    const uint8_t *data;
+    size_t len;
+    uint8_t depth;
+    bool conv;
 
     while (!chThdShouldTerminateX()) {
-        if ((fb = pdu_recv(&tx_fifo)) == NULL)
+        if ((fb = pdu_recv(fifo)) == NULL)
             continue;
-        ax5043TX(cfg->devp, cfg->profile, fb->data, fb->len, fb->len, NULL, NULL, false);
-        fb_free(fb, &tx_fifo);
+
+        /* Drop to the low rate overlay when the link is marginal */
+        chMtxLock(&link_lock);
+        link_check(&dl_link, chVTGetSystemTime());
+        link_update_od();
+        tx_cfg = (dl_link.high || cfg->profile != uhf_eng ? cfg : &uhf_eng_low_cfg);
+        chMtxUnlock(&link_lock);
+
+        set_ocf(fb, tx_cfg != &uhf_eng_low_cfg);
+        data = fb->data;
+        len = fb->len;
+
+        /* One setting per frame, even if it is changed while this one is coded */
+        comms_get_fec(&depth, &conv);
+
+        /* Only USLP frames are coded, AX.25 beacons stay standard */
+        if (depth != 0 && len != 0 && (data[0] >> 4) == USLP_TFVN) {
+            len = fec_rs_encode(data, len, depth, chan->rs_buf, sizeof(chan->rs_buf));
+            data = chan->rs_buf;
+            if (conv) {
+                len = fec_conv_encode(chan->rs_buf, len, chan->conv_buf, sizeof(chan->conv_buf));
+                data = chan->conv_buf;
+            }
+            osalDbgAssert(len != 0, "tx_worker(), FEC block overflow");
+        }
+
+        ax5043SetVCOTemp(tx_cfg->devp, OD_RAM.x2022_MCU_Sensors.temperature);
+        ax5043TX(tx_cfg->devp, tx_cfg->profile, data, len, len, NULL, NULL, false);
+        fb_free(fb, fifo);
     }
 
     /* Free remaining frame buffers */
-    while ((fb = pdu_recv(&tx_fifo)) != NULL) {
-        fb_free(fb, &tx_fifo);
+    while ((fb = pdu_recv(fifo)) != NULL) {
+        fb_free(fb, fifo);
     }
 
     chThdExit(MSG_OK);
@@ -666,6 +1062,10 @@ THD_FUNCTION(tx_worker, arg)
 void comms_init(void)
 {
     radio_init();
+    farm_init(&vc2_farm, 2, FARM_WINDOW_WIDTH);
+    vc2_update_od();
+    link_init(&dl_link, LINK_FIXED_HIGH);
+    link_update_od();
 }
 
 void comms_start(void)
@@ -676,16 +1076,20 @@ void comms_start(void)
     }
     ax5043RX(&lband, false, false);
     ax5043RX(&uhf, false, false);
-    tx_tp = chThdCreateFromHeap(NULL, THD_WORKING_AREA_SIZE(0x400), "TX Worker", NORMALPRIO, tx_worker, (void*)tx_eng);
+    for (size_t i = 0; i < sizeof(tx_chans) / sizeof(tx_chans[0]); i++) {
+        tx_chans[i].tp = chThdCreateFromHeap(NULL, THD_WORKING_AREA_SIZE(0x400), tx_chans[i].name, NORMALPRIO, tx_worker, &tx_chans[i]);
+    }
 }
 
 void comms_stop(void)
 {
     /* Stop transmissions */
     beacon_enable(false);
-    chThdTerminate(tx_tp);
-    chThdWait(tx_tp);
-    tx_tp = NULL;
+    for (size_t i = 0; i < sizeof(tx_chans) / sizeof(tx_chans[0]); i++) {
+        chThdTerminate(tx_chans[i].tp);
+        chThdWait(tx_chans[i].tp);
+        tx_chans[i].tp = NULL;
+    }
 
     /* Stop receiving */
     radio_stop();
@@ -698,26 +1102,82 @@ void comms_stop(void)
     }
 }
 
-void comms_cmd(fb_t *fb, void *arg)
+static void cmd_reply(fb_t *fb, uint8_t vcid)
 {
-    (void)arg;
     osalDbgCheck(fb != NULL);
-    fb_t *resp_fb = fb_alloc(CMD_RESP_ALLOC, &tx_fifo);
+    fb_t *resp_fb = fb_alloc(CMD_RESP_ALLOC, edl_tx_fifo(fb));
     fb_reserve(resp_fb, USLP_MAX_HEADER_LEN + 6); /* TODO: Replace 6 with some calculation of SDLS overhead */
-    cmd_process((cmd_t*)fb->data, resp_fb);
-    uslp_map_send(fb->phy_arg, resp_fb, 0, 0, true);
+    rtcnt_t start = chSysGetRealtimeCounterX();
+    cmd_process((cmd_t*)fb->data, fb->len, resp_fb);
+    edl_stage_add(&edl_stats.cmd, start);
+    uslp_map_send(fb->phy_arg, resp_fb, vcid, 0, true);
 }
 
-void comms_file(fb_t *fb, void *arg)
+static void file_reply(fb_t *fb, uint8_t vcid, uint8_t mapid)
 {
-    (void)arg;
     osalDbgCheck(fb != NULL);
-    fb_t *resp_fb = fb_alloc(CMD_RESP_ALLOC, &tx_fifo);
+    fb_t *resp_fb = fb_alloc(CMD_RESP_ALLOC, edl_tx_fifo(fb));
     fb_reserve(resp_fb, USLP_MAX_HEADER_LEN + 6); /* TODO: Replace 6 with some calculation of SDLS overhead */
     int *ret = fb_put(resp_fb, sizeof(int));
     uint32_t *crc = fb_put(resp_fb, sizeof(uint32_t));
-    *ret = file_recv((file_xfr_t*)fb->data, crc);
-    uslp_map_send(fb->phy_arg, resp_fb, 1, 0, true);
+    rtcnt_t start = chSysGetRealtimeCounterX();
+    *ret = file_recv((file_xfr_t*)fb->data, fb->len, crc);
+    edl_stage_add(&edl_stats.file, start);
+    uslp_map_send(fb->phy_arg, resp_fb, vcid, mapid, true);
+}
+
+void comms_cmd(fb_t *fb, void *arg)
+{
+    (void)arg;
+    cmd_reply(fb, 0);
+}
+
+void comms_file(fb_t *fb, void *arg)
+{
+    (void)arg;
+    file_reply(fb, 1, 0);
+}
+
+void comms_cmd_seq(fb_t *fb, void *arg)
+{
+    (void)arg;
+    if (vc2_accept())
+        cmd_reply(fb, 2);
+}
+
+void comms_file_seq(fb_t *fb, void *arg)
+{
+    (void)arg;
+    if (vc2_accept())
+        file_reply(fb, 2, 1);
+}
+
+void comms_cop(fb_t *fb, void *arg)
+{
+    (void)arg;
+    osalDbgCheck(fb != NULL);
+
+    /* Directives are only valid in BC (bypass) frames */
+    if (!vc2_rx.valid || !vc2_rx.bypass) {
+        vc2_rx.valid = false;
+        vc2_farm.rejected++;
+        return;
+    }
+    vc2_rx.valid = false;
+    if (!farm_directive(&vc2_farm, fb->data, fb->len))
+        return;
+
+    /* Answer with the new CLCW so the ground sees the result */
+    uint32_t clcw = farm_clcw(&vc2_farm);
+    fb_t *resp_fb = fb_alloc(CMD_RESP_ALLOC, edl_tx_fifo(fb));
+    fb_reserve(resp_fb, USLP_MAX_HEADER_LEN + 6); /* TODO: Replace 6 with some calculation of SDLS overhead */
+    uint8_t *data = fb_put(resp_fb, sizeof(clcw));
+    data[0] = clcw >> 24;
+    data[1] = clcw >> 16;
+    data[2] = clcw >> 8;
+    data[3] = clcw;
+    vc2_update_od();
+    uslp_map_send(fb->phy_arg, resp_fb, 2, 2, true);
 }
 
 void comms_beacon(fb_t *fb, void *arg)
@@ -2,10 +2,22 @@
 #define _COMMS_H_
 
 #include "radio.h"
+#include "link.h"
 
 #define XTAL_CLK                            16000000U
 #define EDL_WORKERS                         1
 
+/*
+ * Answer L-band uplinks on the L-band transmitter instead of UHF. Off on
+ * the C3, which has no enable for the L-band PA, so every EDL response goes
+ * out on UHF. The L-band TX queue and worker run either way. Build with
+ * -DEDL_LBAND_DOWNLINK=TRUE for a board that powers the L-band PA, the host
+ * test test_comms_lband covers that build.
+ */
+#ifndef EDL_LBAND_DOWNLINK
+#define EDL_LBAND_DOWNLINK                  FALSE
+#endif
+
 #define SCID                                0x4F53U
 #define MCID                                ((USLP_TFVN << 16) | SCID)
 /* 16-bit FECF provided by AX5043 driver */
@@ -15,19 +27,46 @@
 #define CMD_RESP_ALLOC                      (CMD_RESP_LEN + USLP_MAX_HEADER_LEN)
 #define FILE_BUF_LEN                        1024
 
+/* Time spent in one EDL worker stage, in realtime counter cycles */
+typedef struct {
+    uint32_t count;
+    rtcnt_t max;
+    uint64_t sum;
+} edl_stage_t;
+
+typedef struct {
+    uint32_t accepted;                      /* Frames uslp_recv accepted */
+    uint32_t rejected;                      /* Frames dropped by USLP, SDLS or FARM checks */
+    edl_stage_t total;                      /* pdu_recv to fb_free, per frame */
+    edl_stage_t auth;                       /* HMAC verification */
+    edl_stage_t cmd;                        /* cmd_process */
+    edl_stage_t file;                       /* file_recv */
+} edl_stats_t;
+
 #ifdef __cplusplus
 extern "C" {
 #endif
 
 extern AX5043Driver lband;
 extern AX5043Driver uhf;
+extern pdu_queue_t lband_txq;
+extern pdu_queue_t uhf_txq;
 
 void comms_init(void);
 void comms_start(void);
 void comms_stop(void);
+bool comms_set_fec(uint8_t depth, bool conv);
+void comms_get_fec(uint8_t *depth, bool *conv);
+void comms_set_link(link_mode_t mode);
+void comms_get_link(link_t *state);
+void comms_get_stats(edl_stats_t *stats);
+void comms_reset_stats(void);
 
 void comms_cmd(fb_t *fb, void *arg);
 void comms_file(fb_t *fb, void *arg);
+void comms_cmd_seq(fb_t *fb, void *arg);
+void comms_file_seq(fb_t *fb, void *arg);
+void comms_cop(fb_t *fb, void *arg);
 void comms_beacon(fb_t *fb, void *arg);
 void beacon_enable(bool enable);
 
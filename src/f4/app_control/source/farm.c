@@ -0,0 +1,141 @@
+#include "farm.h"
+
+/*
+ * FARM-1 receiver side of COP-1 (CCSDS 232.1-B). Pure state machine, the
+ * caller serializes access and feeds it authenticated frames only.
+ */
+
+void farm_init(farm_t *farm, uint8_t vcid, uint8_t width)
+{
+    osalDbgCheck(farm != NULL && width >= 2 && (width & 1U) == 0);
+
+    farm->state = FARM_OPEN;
+    farm->vcid = vcid;
+    farm->vr = 0;
+    farm->pw = width / 2;
+    farm->nw = width / 2;
+    farm->retransmit = false;
+    farm->farmb_cnt = 0;
+    farm->accepted = 0;
+    farm->rejected = 0;
+    farm->retransmits = 0;
+    farm->lockouts = 0;
+}
+
+static void farm_request_retransmit(farm_t *farm)
+{
+    if (!farm->retransmit) {
+        farm->retransmit = true;
+        farm->retransmits++;
+    }
+}
+
+/*
+ * Run a data frame through FARM-1. BD frames (bypass) are always accepted,
+ * AD frames only when N(S) == V(R) and there is room to process them. Set
+ * ready false when the frame could not be handled right now (no response
+ * buffer); the FARM then enters Wait and the ground retransmits from V(R).
+ * Returns true if the frame should be delivered.
+ */
+bool farm_frame(farm_t *farm, bool bypass, uint8_t ns, bool ready)
+{
+    osalDbgCheck(farm != NULL);
+
+    if (bypass) {
+        farm->farmb_cnt = (farm->farmb_cnt + 1) & 0x3U;
+        farm->accepted++;
+        return true;
+    }
+
+    /* Buffer release ends Wait */
+    if (farm->state == FARM_WAIT && ready) {
+        farm->state = FARM_OPEN;
+    }
+
+    uint8_t ahead = ns - farm->vr;
+    uint8_t behind = farm->vr - ns;
+
+    if (farm->state == FARM_LOCKOUT) {
+        /* Discard everything until Unlock */
+    } else if (ahead == 0) {
+        if (farm->state == FARM_OPEN && ready) {
+            farm->vr++;
+            farm->retransmit = false;
+            farm->accepted++;
+            return true;
+        }
+        farm_request_retransmit(farm);
+        farm->state = FARM_WAIT;
+    } else if (ahead < farm->pw) {
+        /* Gap in the sequence, ask for go-back-N from V(R) */
+        if (farm->state == FARM_OPEN) {
+            farm_request_retransmit(farm);
+        }
+    } else if (behind <= farm->nw) {
+        /* Already accepted, duplicate from a retransmission */
+    } else {
+        farm->state = FARM_LOCKOUT;
+        farm->lockouts++;
+    }
+
+    farm->rejected++;
+    return false;
+}
+
+void farm_unlock(farm_t *farm)
+{
+    osalDbgCheck(farm != NULL);
+
+    farm->farmb_cnt = (farm->farmb_cnt + 1) & 0x3U;
+    farm->retransmit = false;
+    farm->state = FARM_OPEN;
+}
+
+void farm_set_vr(farm_t *farm, uint8_t vr)
+{
+    osalDbgCheck(farm != NULL);
+
+    farm->farmb_cnt = (farm->farmb_cnt + 1) & 0x3U;
+    if (farm->state != FARM_LOCKOUT) {
+        farm->retransmit = false;
+        farm->state = FARM_OPEN;
+        farm->vr = vr;
+    }
+}
+
+/*
+ * Handle a BC frame payload: Unlock (0x00) or Set V(R) (0x82 0x00 V*(R)).
+ * Returns false for an unrecognized directive, which is discarded.
+ */
+bool farm_directive(farm_t *farm, const uint8_t *dir, size_t len)
+{
+    osalDbgCheck(farm != NULL && dir != NULL);
+
+    if (len == 1 && dir[0] == FARM_DIR_UNLOCK) {
+        farm_unlock(farm);
+    } else if (len == 3 && dir[0] == FARM_DIR_SET_VR && dir[1] == 0x00U) {
+        farm_set_vr(farm, dir[2]);
+    } else {
+        farm->rejected++;
+        return false;
+    }
+    farm->accepted++;
+    return true;
+}
+
+uint32_t farm_clcw(const farm_t *farm)
+{
+    osalDbgCheck(farm != NULL);
+
+    uint32_t clcw = FARM_CLCW_COP1;
+    clcw |= (uint32_t)(farm->vcid & 0x3FU) << FARM_CLCW_VCID_Pos;
+    if (farm->state == FARM_LOCKOUT)
+        clcw |= FARM_CLCW_LOCKOUT;
+    if (farm->state == FARM_WAIT)
+        clcw |= FARM_CLCW_WAIT;
+    if (farm->retransmit)
+        clcw |= FARM_CLCW_RETRANSMIT;
+    clcw |= (uint32_t)farm->farmb_cnt << FARM_CLCW_FARMB_Pos;
+    clcw |= farm->vr;
+    return clcw;
+}
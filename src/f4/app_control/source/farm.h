@@ -0,0 +1,61 @@
+#ifndef _FARM_H_
+#define _FARM_H_
+
+#include "ch.h"
+#include "hal.h"
+
+/* FARM-1 sliding window width W, split evenly into the positive and negative windows */
+#define FARM_WINDOW_WIDTH                   16U
+
+/* COP control directives carried in BC frames (CCSDS 232.0-B) */
+#define FARM_DIR_UNLOCK                     0x00U
+#define FARM_DIR_SET_VR                     0x82U
+
+/* CLCW fields (CCSDS 232.0-B section 4.2) */
+#define FARM_CLCW_STATUS_Pos                26U
+#define FARM_CLCW_COP1                      (1U << 24)
+#define FARM_CLCW_VCID_Pos                  18U
+#define FARM_CLCW_LOCKOUT                   (1U << 13)
+#define FARM_CLCW_WAIT                      (1U << 12)
+#define FARM_CLCW_RETRANSMIT                (1U << 11)
+#define FARM_CLCW_FARMB_Pos                 9U
+#define FARM_CLCW_REPORT_Msk                0xFFU
+
+/* Mission specific CLCW status field: downlink is on the high rate profile */
+#define FARM_CLCW_STATUS_HIGH_RATE          (1U << FARM_CLCW_STATUS_Pos)
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+    FARM_OPEN = 1,
+    FARM_WAIT = 2,
+    FARM_LOCKOUT = 3,
+} farm_state_t;
+
+typedef struct {
+    farm_state_t state;
+    uint8_t vcid;
+    uint8_t vr;                             /* V(R), next expected N(S) */
+    uint8_t pw;                             /* Positive window */
+    uint8_t nw;                             /* Negative window */
+    bool retransmit;
+    uint8_t farmb_cnt;                      /* 2-bit FARM-B counter */
+    uint32_t accepted;
+    uint32_t rejected;
+    uint32_t retransmits;                   /* Times the retransmit flag was raised */
+    uint32_t lockouts;
+} farm_t;
+
+void farm_init(farm_t *farm, uint8_t vcid, uint8_t width);
+bool farm_frame(farm_t *farm, bool bypass, uint8_t ns, bool ready);
+bool farm_directive(farm_t *farm, const uint8_t *dir, size_t len);
+void farm_unlock(farm_t *farm);
+void farm_set_vr(farm_t *farm, uint8_t vr);
+uint32_t farm_clcw(const farm_t *farm);
+
+#ifdef __cplusplus
+}
+#endif /*__cplusplus*/
+#endif
@@ -1,12 +1,16 @@
 #include "file_xfr.h"
 #include "crc.h"
 
-int file_recv(file_xfr_t *xfr, uint32_t *crc)
+int file_recv(file_xfr_t *xfr, size_t len, uint32_t *crc)
 {
     char filename[9] = {0};
     lfs_file_t *file;
     int ret;
 
+    /* The header and all of the data have to be in the frame */
+    if (len < sizeof(file_xfr_t) || xfr->len > len - sizeof(file_xfr_t))
+        return LFS_ERR_INVAL;
+
     memcpy(filename, xfr->filename, 8);
     file = file_open(&FSD1, filename, LFS_O_WRONLY | LFS_O_CREAT);
     if (file == NULL) {
@@ -6,14 +6,73 @@
 #include "crc.h"
 #include "persist.h"
 #include "fram.h"
+#include "CANopen.h"
+#include "OD.h"
 
 #define FLASH_OPTKEY1                       0x08192A3BU
 #define FLASH_OPTKEY2                       0x4C5D6E7FU
 #define FLASH_BANK_OFFSET                   0x100000U
 #define BUF_SIZE                            256
 
+#define FW_CHUNK_SIZE                       4096U
+#define FW_CHUNK_COUNT                      2U
+
 uint8_t buf[BUF_SIZE];
 
+typedef struct {
+    ssize_t len;
+    uint8_t data[FW_CHUNK_SIZE];
+} fw_chunk_t;
+
+/* Chunks cycle between the reader (free -> full) and flash writer (full -> free) */
+static fw_chunk_t fw_chunk[FW_CHUNK_COUNT];
+static msg_t fw_free_buf[FW_CHUNK_COUNT];
+static msg_t fw_full_buf[FW_CHUNK_COUNT];
+static mailbox_t fw_free_mb;
+static mailbox_t fw_full_mb;
+static THD_WORKING_AREA(fw_reader_wa, 0x400);
+/* Held for a whole flash, the pipeline above serves one caller at a time */
+static MUTEX_DECL(fw_flash_lock);
+
+/* Reads the image from eMMC into free chunks while the caller programs flash */
+static THD_FUNCTION(fw_reader, arg)
+{
+    lfs_file_t *file = arg;
+    fw_chunk_t *chunk;
+
+    do {
+        chMBFetchTimeout(&fw_free_mb, (msg_t*)&chunk, TIME_INFINITE);
+        chunk->len = file_read(&FSD1, file, chunk->data, FW_CHUNK_SIZE);
+        chMBPostTimeout(&fw_full_mb, (msg_t)chunk, TIME_INFINITE);
+    } while (chunk->len > 0 && !chThdShouldTerminateX());
+
+    chThdExit(MSG_OK);
+}
+
+/* Erase the sector containing offset, returning the end of the sector */
+static int fw_erase_sector(EFlashDriver *eflp, flash_offset_t offset, flash_offset_t *end)
+{
+    const flash_descriptor_t *desc = flashGetDescriptor(eflp);
+    int ret;
+
+    for (flash_sector_t sector = 0; sector < desc->sectors_count; sector++) {
+        flash_offset_t start = flashGetSectorOffset((BaseFlash*)eflp, sector);
+        uint32_t size = flashGetSectorSize((BaseFlash*)eflp, sector);
+        if (offset >= start && offset < start + size) {
+            ret = flashStartEraseSector(eflp, sector);
+            if (ret != FLASH_NO_ERROR) {
+                return ret;
+            }
+            /* Sleeps while erasing, letting the reader fill the next chunk */
+            ret = flashWaitErase((BaseFlash*)eflp);
+            *end = start + size;
+            return ret;
+        }
+    }
+
+    return FLASH_ERROR_ERASE;
+}
+
 int fw_read(EFlashDriver *eflp, char *filename, flash_offset_t offset, size_t len)
 {
     lfs_file_t *file;
@@ -86,7 +145,7 @@ uint32_t fw_crc(EFlashDriver *eflp, fw_bank_t bank, size_t len)
             n = BUF_SIZE;
         }
 
-        if (flashRead(eflp, offset, n, buf) != FLASH_NO_ERROR) {
+        if (flashRead(eflp, offset, n, buf) != FLASH_NO_ERROR || chThdShouldTerminateX()) {
             break;
         }
         crc = crc32(buf, n, crc);
@@ -119,47 +178,104 @@ void fw_set_info(fw_info_t fw_info, fw_bank_t bank)
     framWrite(&FRAMD1, addr, &fw_info, sizeof(fw_info_t));
 }
 
-int fw_flash(EFlashDriver *eflp, char *filename, uint32_t expected_crc)
+static int fw_flash_stream(EFlashDriver *eflp, char *filename, uint32_t expected_crc)
 {
     lfs_file_t *file;
     fw_info_t fw_info = {0};
-    int ret;
+    fw_bank_t bank = !(SYSCFG->MEMRMP & SYSCFG_MEMRMP_UFB_MODE);
+    flash_offset_t offset = FLASH_BANK_OFFSET;
+    flash_offset_t erased = FLASH_BANK_OFFSET;
+    fw_chunk_t *chunk;
+    thread_t *tp;
+    uint32_t crc = 0;
+    int ret = FLASH_NO_ERROR;
 
-    /* Verify the file matches the expected CRC */
     file = file_open(&FSD1, filename, LFS_O_RDONLY);
     if (file == NULL) {
         return FSD1.err;
     }
-    fw_info.crc = file_crc(&FSD1, file);
     fw_info.len = file_size(&FSD1, file);
-    file_close(&FSD1, file);
     if (FSD1.err != LFS_ERR_OK) {
+        file_close(&FSD1, file);
         return FSD1.err;
     }
-    if (fw_info.crc != expected_crc) {
-        return FLASH_ERROR_VERIFY;
+
+    /* Invalidate the offline bank info before touching it */
+    fw_set_info(fw_info, bank);
+    OD_RAM.x7000_C3_Telemetry.FW_FlashProgress = 0;
+
+    chMBObjectInit(&fw_free_mb, fw_free_buf, FW_CHUNK_COUNT);
+    chMBObjectInit(&fw_full_mb, fw_full_buf, FW_CHUNK_COUNT);
+    for (size_t i = 0; i < FW_CHUNK_COUNT; i++) {
+        chMBPostTimeout(&fw_free_mb, (msg_t)&fw_chunk[i], TIME_IMMEDIATE);
     }
 
-    /* Erase the offline flash bank */
+    /* Stream the image: read ahead on eMMC, erase ahead and program flash */
     eflStart(&EFLD1, NULL);
-    ret = flashStartEraseAll(eflp);
-    if (ret != FLASH_NO_ERROR)
-        return ret;
-    /* Wait for erase operation to complete */
-    ret = flashWaitErase((BaseFlash*)eflp);
-    if (ret != FLASH_NO_ERROR)
-        return ret;
+    tp = chThdCreateStatic(fw_reader_wa, sizeof(fw_reader_wa), chThdGetPriorityX(), fw_reader, file);
+    while (true) {
+        chMBFetchTimeout(&fw_full_mb, (msg_t*)&chunk, TIME_INFINITE);
+        if (chunk->len <= 0) {
+            ret = chunk->len;
+            break;
+        }
+        if (chThdShouldTerminateX()) {
+            ret = FW_ERROR_CANCELLED;
+            break;
+        }
+
+        crc = crc32(chunk->data, chunk->len, crc);
+        while (offset + chunk->len > erased && ret == FLASH_NO_ERROR) {
+            ret = fw_erase_sector(eflp, erased, &erased);
+        }
+        if (ret == FLASH_NO_ERROR) {
+            ret = flashProgram(eflp, offset, chunk->len, chunk->data);
+        }
+        if (ret != FLASH_NO_ERROR) {
+            break;
+        }
+        offset += chunk->len;
+        chMBPostTimeout(&fw_free_mb, (msg_t)chunk, TIME_INFINITE);
+
+        OD_RAM.x7000_C3_Telemetry.FW_FlashProgress = (uint64_t)(offset - FLASH_BANK_OFFSET) * 100U / fw_info.len;
+    }
+
+    /* On error the reader may still be running, drain it until it exits */
+    chThdTerminate(tp);
+    while (!chThdTerminatedX(tp)) {
+        if (chMBFetchTimeout(&fw_full_mb, (msg_t*)&chunk, TIME_MS2I(10)) == MSG_OK) {
+            chMBPostTimeout(&fw_free_mb, (msg_t)chunk, TIME_INFINITE);
+        }
+    }
+    chThdWait(tp);
     eflStop(&EFLD1);
+    file_close(&FSD1, file);
 
-    /* Write new firmware image to offline bank */
-    ret = fw_write(eflp, filename, FLASH_BANK_OFFSET);
-    if (ret != FLASH_NO_ERROR)
+    if (ret != FLASH_NO_ERROR) {
         return ret;
+    }
+    if (offset - FLASH_BANK_OFFSET != fw_info.len || crc != expected_crc) {
+        return FLASH_ERROR_VERIFY;
+    }
 
     /* Commit new FW info to FRAM */
-    fw_set_info(fw_info, !(SYSCFG->MEMRMP & SYSCFG_MEMRMP_UFB_MODE));
+    fw_info.crc = crc;
+    fw_set_info(fw_info, bank);
+
+    return !fw_verify(eflp, bank);
+}
 
-    return !fw_verify(eflp, !(SYSCFG->MEMRMP & SYSCFG_MEMRMP_UFB_MODE));
+int fw_flash(EFlashDriver *eflp, char *filename, uint32_t expected_crc)
+{
+    int ret;
+
+    if (!chMtxTryLock(&fw_flash_lock)) {
+        return FW_ERROR_BUSY;
+    }
+    ret = fw_flash_stream(eflp, filename, expected_crc);
+    chMtxUnlock(&fw_flash_lock);
+
+    return ret;
 }
 
 int fw_set_bank(EFlashDriver *eflp, fw_bank_t bank)
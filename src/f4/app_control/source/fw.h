@@ -4,6 +4,11 @@
 #include "ch.h"
 #include "hal.h"
 
+/* Returned by fw_flash when the calling thread is terminated mid-flash */
+#define FW_ERROR_CANCELLED                  0x100
+/* Returned by fw_flash when another flash is already in progress */
+#define FW_ERROR_BUSY                       0x101
+
 #ifdef __cplusplus
 extern "C" {
 #endif
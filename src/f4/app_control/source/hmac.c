@@ -1,44 +1,128 @@
 #include <stdlib.h>
+#include <string.h>
 #include "hmac.h"
 #include "CANopen.h"
 #include "OD.h"
 
-int hmac_send(void *data, size_t len, void *iv, void *seq_num, void *mac, void *arg)
+/* Key schedule for the last key seen by hmac_send/hmac_recv */
+static hmac_key_t cached_key;
+static uint8_t cached_raw[HMAC_KEY_LEN];
+static bool cached_valid;
+static MUTEX_DECL(cache_lock);
+
+/**
+ * @brief   Precompute the ipad/opad midstates for a key.
+ * @note    Keys longer than a block are hashed first as per RFC 2104.
+ */
+void hmac_key_init(hmac_key_t *key, const uint8_t *k, size_t len)
 {
-    (void)iv;
-    cryerror_t err;
-    HMACSHA256Context ctx = {0};
+    sha256_ctx_t sha;
+    uint8_t pad[SHA256_BLOCK_LEN] = {0};
 
-    *((uint32_t*)seq_num) = __builtin_bswap32(OD_PERSIST_STATE.x6004_persistentState.EDL_SequenceCount);
+    if (len > SHA256_BLOCK_LEN) {
+        sha256_init(&sha);
+        sha256_update(&sha, k, len);
+        sha256_final(&sha, pad);
+    } else {
+        memcpy(pad, k, len);
+    }
 
-    err = cryLoadHMACTransientKey(&CRYD1, 32, arg);
-    if (err != CRY_NOERROR) {
-        return err;
+    for (size_t i = 0; i < SHA256_BLOCK_LEN; i++) {
+        pad[i] ^= 0x36;
     }
+    sha256_init(&sha);
+    sha256_update(&sha, pad, SHA256_BLOCK_LEN);
+    memcpy(key->inner, sha.state, sizeof(key->inner));
 
-    err = cryHMACSHA256Init(&CRYD1, &ctx);
-    if (err != CRY_NOERROR) {
-        return err;
+    /* 0x36 ^ 0x6A == 0x5C, turns ipad into opad */
+    for (size_t i = 0; i < SHA256_BLOCK_LEN; i++) {
+        pad[i] ^= 0x6A;
     }
+    sha256_init(&sha);
+    sha256_update(&sha, pad, SHA256_BLOCK_LEN);
+    memcpy(key->outer, sha.state, sizeof(key->outer));
+
+    memset(pad, 0, sizeof(pad));
+    memset(&sha, 0, sizeof(sha));
+}
+
+void hmac_init(hmac_ctx_t *ctx, const hmac_key_t *key)
+{
+    memcpy(ctx->sha.state, key->inner, sizeof(key->inner));
+    ctx->sha.count = SHA256_BLOCK_LEN;
+    ctx->key = key;
+}
+
+void hmac_update(hmac_ctx_t *ctx, const void *data, size_t len)
+{
+    sha256_update(&ctx->sha, data, len);
+}
+
+void hmac_final(hmac_ctx_t *ctx, uint8_t mac[HMAC_MAC_LEN])
+{
+    uint8_t inner[SHA256_DIGEST_LEN];
+
+    sha256_final(&ctx->sha, inner);
+    memcpy(ctx->sha.state, ctx->key->outer, sizeof(ctx->key->outer));
+    ctx->sha.count = SHA256_BLOCK_LEN;
+    sha256_update(&ctx->sha, inner, sizeof(inner));
+    sha256_final(&ctx->sha, mac);
+}
+
+/**
+ * @brief   Finish the MAC and compare it against the first len bytes.
+ * @note    Runs in constant time with respect to the MAC contents.
+ */
+bool hmac_verify(hmac_ctx_t *ctx, const uint8_t *mac, size_t len)
+{
+    uint8_t calc[HMAC_MAC_LEN];
+    uint8_t diff = 0;
 
-    err = cryHMACSHA256Update(&CRYD1, &ctx, len, data);
-    if (err != CRY_NOERROR) {
-        return err;
+    if (len == 0 || len > HMAC_MAC_LEN) {
+        return false;
     }
 
-    err = cryHMACSHA256Final(&CRYD1, &ctx, mac);
-    if (err != CRY_NOERROR) {
-        return err;
+    hmac_final(ctx, calc);
+    for (size_t i = 0; i < len; i++) {
+        diff |= calc[i] ^ mac[i];
     }
+    return diff == 0;
+}
+
+/* Get the key schedule for k, rebuilding the cached one only on key change */
+static void hmac_key_cached(hmac_key_t *key, const uint8_t *k)
+{
+    chMtxLock(&cache_lock);
+    if (!cached_valid || memcmp(cached_raw, k, HMAC_KEY_LEN) != 0) {
+        hmac_key_init(&cached_key, k, HMAC_KEY_LEN);
+        memcpy(cached_raw, k, HMAC_KEY_LEN);
+        cached_valid = true;
+    }
+    *key = cached_key;
+    chMtxUnlock(&cache_lock);
+}
+
+int hmac_send(void *data, size_t len, void *iv, void *seq_num, void *mac, void *arg)
+{
+    (void)iv;
+    hmac_ctx_t ctx;
+    hmac_key_t key;
+
+    *((uint32_t*)seq_num) = __builtin_bswap32(OD_PERSIST_STATE.x6004_persistentState.EDL_SequenceCount);
+
+    hmac_key_cached(&key, arg);
+    hmac_init(&ctx, &key);
+    hmac_update(&ctx, data, len);
+    hmac_final(&ctx, mac);
 
     return 0;
 }
+
 int hmac_recv(void *data, size_t len, void *iv, void *seq_num, void *mac, void *arg)
 {
     (void)iv;
-    cryerror_t err;
-    HMACSHA256Context ctx = {0};
-    uint8_t hmac[32] = {0};
+    hmac_ctx_t ctx;
+    hmac_key_t key;
     uint32_t recv_seq = __builtin_bswap32(*((uint32_t*)seq_num));
 
     /* Check sequence number first */
@@ -46,26 +130,11 @@ int hmac_recv(void *data, size_t len, void *iv, void *seq_num, void *mac, void *
         return -1;
     }
 
-    /* Calculate HMAC */
-    err = cryLoadHMACTransientKey(&CRYD1, 32, arg);
-    if (err != CRY_NOERROR) {
-        return err;
-    }
-    err = cryHMACSHA256Init(&CRYD1, &ctx);
-    if (err != CRY_NOERROR) {
-        return err;
-    }
-    err = cryHMACSHA256Update(&CRYD1, &ctx, len, data);
-    if (err != CRY_NOERROR) {
-        return err;
-    }
-    err = cryHMACSHA256Final(&CRYD1, &ctx, hmac);
-    if (err != CRY_NOERROR) {
-        return err;
-    }
-
-    /* Compare HMAC */
-    if (memcmp(hmac, mac, 32) != 0) {
+    /* Calculate and compare HMAC */
+    hmac_key_cached(&key, arg);
+    hmac_init(&ctx, &key);
+    hmac_update(&ctx, data, len);
+    if (!hmac_verify(&ctx, mac, HMAC_MAC_LEN)) {
         return -1;
     }
 
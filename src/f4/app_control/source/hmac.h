@@ -3,8 +3,36 @@
 
 #include "ch.h"
 #include "hal.h"
+#include "sha256.h"
+
+#define HMAC_KEY_LEN                32U
+#define HMAC_MAC_LEN                SHA256_DIGEST_LEN
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* HMAC-SHA256 key schedule: SHA-256 midstates after the ipad/opad blocks */
+typedef struct {
+    uint32_t inner[8];
+    uint32_t outer[8];
+} hmac_key_t;
+
+typedef struct {
+    sha256_ctx_t sha;
+    const hmac_key_t *key;
+} hmac_ctx_t;
+
+void hmac_key_init(hmac_key_t *key, const uint8_t *k, size_t len);
+void hmac_init(hmac_ctx_t *ctx, const hmac_key_t *key);
+void hmac_update(hmac_ctx_t *ctx, const void *data, size_t len);
+void hmac_final(hmac_ctx_t *ctx, uint8_t mac[HMAC_MAC_LEN]);
+bool hmac_verify(hmac_ctx_t *ctx, const uint8_t *mac, size_t len);
 
 int hmac_send(void *data, size_t len, void *iv, void *seq_num, void *mac, void *arg);
 int hmac_recv(void *data, size_t len, void *iv, void *seq_num, void *mac, void *arg);
 
+#ifdef __cplusplus
+}
+#endif /*__cplusplus*/
 #endif
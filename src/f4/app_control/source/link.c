@@ -0,0 +1,139 @@
+#include <string.h>
+#include "link.h"
+
+/*
+ * Downlink rate selection from uplink receive quality. The uplink and
+ * downlink share the antenna and path, so RSSI, frequency offset and frame
+ * error rate of received frames stand in for the downlink margin. Pure
+ * state machine, the caller serializes access and supplies the time.
+ */
+
+static void link_window_reset(link_t *link)
+{
+    link->good = 0;
+    link->bad = 0;
+    link->rssi_sum = 0;
+}
+
+void link_init(link_t *link, link_mode_t mode)
+{
+    osalDbgCheck(link != NULL);
+
+    memset(link, 0, sizeof(*link));
+    link_set_mode(link, mode);
+}
+
+void link_set_mode(link_t *link, link_mode_t mode)
+{
+    osalDbgCheck(link != NULL);
+
+    link->mode = mode;
+    link->high = (mode == LINK_FIXED_HIGH);
+    link->hold = 0;
+    link_window_reset(link);
+}
+
+/*
+ * Close a full window. Going down takes one bad window, going up takes
+ * LINK_HOLD good windows in a row. Returns true if the selection changed.
+ */
+static bool link_evaluate(link_t *link)
+{
+    uint32_t total = link->good + link->bad;
+    bool high = link->high;
+
+    link->fer = link->bad * 100U / total;
+    link->rssi = (link->good ? link->rssi_sum / (int32_t)link->good : INT16_MIN);
+    link_window_reset(link);
+
+    if (link->mode != LINK_AUTO)
+        return false;
+
+    if (link->high) {
+        if (link->fer > LINK_FER_DOWN || link->rssi < LINK_RSSI_DOWN) {
+            link->high = false;
+        }
+        link->hold = 0;
+    } else if (link->fer <= LINK_FER_UP && link->rssi >= LINK_RSSI_UP &&
+               link->foff <= LINK_FOFF_MAX && link->foff >= -LINK_FOFF_MAX) {
+        if (++link->hold >= LINK_HOLD) {
+            link->high = true;
+            link->hold = 0;
+        }
+    } else {
+        link->hold = 0;
+    }
+
+    if (link->high != high) {
+        link->switches++;
+        return true;
+    }
+    return false;
+}
+
+/* The first frame or error after a silence starts a pass */
+static void link_pass(link_t *link, systime_t now)
+{
+    if (!link->in_pass) {
+        link->in_pass = true;
+        link->passes++;
+        link->frames = 0;
+        link->errors = 0;
+        link->switches = 0;
+    }
+    link->last = now;
+}
+
+static bool link_count(link_t *link)
+{
+    if (link->good + link->bad >= LINK_WINDOW)
+        return link_evaluate(link);
+    return false;
+}
+
+/* A frame was received intact. Returns true if the selection changed. */
+bool link_frame(link_t *link, systime_t now, int8_t rssi, int32_t foff)
+{
+    osalDbgCheck(link != NULL);
+
+    link_pass(link, now);
+    link->good++;
+    link->frames++;
+    link->rssi_sum += rssi;
+    link->foff = foff;
+    return link_count(link);
+}
+
+/* A frame was dropped by the radio. Returns true if the selection changed. */
+bool link_error(link_t *link, systime_t now)
+{
+    osalDbgCheck(link != NULL);
+
+    link_pass(link, now);
+    link->bad++;
+    link->errors++;
+    return link_count(link);
+}
+
+/*
+ * End the pass after LINK_PASS_TIMEOUT without uplink frames, falling back
+ * to the low rate so the next pass starts robust. The silence is measured
+ * in ticks, so it stays right across the system time wrap. Returns true if
+ * the selection changed.
+ */
+bool link_check(link_t *link, systime_t now)
+{
+    osalDbgCheck(link != NULL);
+
+    if (!link->in_pass || chTimeDiffX(link->last, now) < TIME_MS2I(LINK_PASS_TIMEOUT))
+        return false;
+
+    link->in_pass = false;
+    link->hold = 0;
+    link_window_reset(link);
+    if (link->mode == LINK_AUTO && link->high) {
+        link->high = false;
+        return true;
+    }
+    return false;
+}
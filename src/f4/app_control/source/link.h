@@ -0,0 +1,62 @@
+#ifndef _LINK_H_
+#define _LINK_H_
+
+#include "ch.h"
+#include "hal.h"
+
+/* Frames per quality window */
+#define LINK_WINDOW                         16U
+/* Windows in a row that must qualify before moving up */
+#define LINK_HOLD                           2U
+/* RSSI thresholds in AX5043 RSSI units (dB), the gap is the hysteresis */
+#define LINK_RSSI_UP                        (-97)
+#define LINK_RSSI_DOWN                      (-100)
+/* Frame error rate thresholds in percent */
+#define LINK_FER_UP                         5U
+#define LINK_FER_DOWN                       20U
+/* Largest receiver frequency offset in Hz that still allows the high rate */
+#define LINK_FOFF_MAX                       20000
+/* Silence in ms that ends a pass */
+#define LINK_PASS_TIMEOUT                   60000U
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+    LINK_AUTO = 0,
+    LINK_FIXED_LOW = 1,
+    LINK_FIXED_HIGH = 2,
+} link_mode_t;
+
+typedef struct {
+    link_mode_t mode;
+    bool high;                              /* Selected downlink rate */
+    bool in_pass;
+    systime_t last;                         /* Time of the last uplink frame */
+    /* Current window */
+    uint32_t good;
+    uint32_t bad;
+    int32_t rssi_sum;
+    int32_t foff;                           /* Last frequency offset, Hz */
+    uint8_t hold;
+    /* Last completed window */
+    int16_t rssi;
+    uint8_t fer;
+    /* Counters for this pass */
+    uint32_t frames;
+    uint32_t errors;
+    uint32_t switches;
+    uint32_t passes;
+} link_t;
+
+void link_init(link_t *link, link_mode_t mode);
+void link_set_mode(link_t *link, link_mode_t mode);
+bool link_frame(link_t *link, systime_t now, int8_t rssi, int32_t foff);
+bool link_error(link_t *link, systime_t now);
+bool link_check(link_t *link, systime_t now);
+
+#ifdef __cplusplus
+}
+#endif /*__cplusplus*/
+#endif
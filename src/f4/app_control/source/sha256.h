@@ -0,0 +1,27 @@
+#ifndef _SHA256_H_
+#define _SHA256_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define SHA256_BLOCK_LEN            64U
+#define SHA256_DIGEST_LEN           32U
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+    uint32_t state[8];                  /* Chaining value (midstate)       */
+    uint64_t count;                     /* Total bytes hashed so far       */
+    uint8_t buf[SHA256_BLOCK_LEN];      /* Partial block awaiting data     */
+} sha256_ctx_t;
+
+void sha256_init(sha256_ctx_t *ctx);
+void sha256_update(sha256_ctx_t *ctx, const void *data, size_t len);
+void sha256_final(sha256_ctx_t *ctx, uint8_t digest[SHA256_DIGEST_LEN]);
+
+#ifdef __cplusplus
+}
+#endif /*__cplusplus*/
+#endif
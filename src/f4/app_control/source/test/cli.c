@@ -20,6 +20,9 @@
 #include "test_deploy.h"
 #include "test_crc.h"
 #include "test_hmac.h"
+#include "test_farm.h"
+#include "test_fec.h"
+#include "test_link.h"
 #include "chprintf.h"
 #include "shell.h"
 
@@ -138,11 +141,15 @@ static const ShellCommand commands[] = {
     {"rf", cmd_rf},
     {"rftest", cmd_rftest},
     {"beacon", cmd_beacon},
+    {"morse", cmd_morse},
     {"state", cmd_state},
     {"fram", cmd_fram},
     {"persist", cmd_persist},
     {"crc", cmd_crc},
     {"hmac", cmd_hmac},
+    {"farm", cmd_farm},
+    {"fec", cmd_fec},
+    {"link", cmd_link},
     {"deploy", cmd_deploy},
     {"edl", cmd_edl},
     {NULL, NULL}
@@ -97,6 +97,8 @@ static const uslp_pc_t loopback_pc = {
     .fecf_len       = FECF_LEN,
     .phy_send       = pdu_loopback,
     .phy_send_ahead = pdu_loopback,
+    .send_arg       = &uhf_txq.fifo,
+    .send_ahead_arg = &uhf_txq.fifo,
 };
 
 static const uslp_link_t edl_loopback_rx_link = {
@@ -113,13 +115,12 @@ static const uslp_link_t edl_loopback_tx_link = {
 
 static void pdu_loopback(fb_t *fb, void *arg)
 {
-    (void)arg;
     if (fb == tx_fb) {
         fb->phy_arg = (void*)&edl_loopback_rx_link;
-        pdu_send(fb, &rx_fifo);
+        pdu_send(fb, &rx_queue.fifo);
     } else {
         uslp_recv(&edl_loopback_tx_link, fb);
-        fb_free(fb, &tx_fifo);
+        fb_free(fb, arg);
     }
 }
 
@@ -132,6 +133,44 @@ static void resp_recv(fb_t *fb, void *arg)
     chEvtSignal(cli_tp, COMMS_EVENT_LOOPBACK_RX);
 }
 
+static uint32_t cycles_us(uint64_t cycles)
+{
+    return cycles / (STM32_SYSCLK / 1000000U);
+}
+
+static void print_stage(BaseSequentialStream *chp, const char *name, const edl_stage_t *stage)
+{
+    uint32_t avg = (stage->count ? cycles_us(stage->sum / stage->count) : 0);
+    chprintf(chp, "%-8s %8u %10u %10u\r\n", name, stage->count, avg, cycles_us(stage->max));
+}
+
+static void print_queue(BaseSequentialStream *chp, const char *name, void *fifo)
+{
+    pdu_stats_t stats;
+    pdu_get_stats(fifo, &stats);
+    uint32_t avg = (stats.received ? cycles_us(stats.wait_sum / stats.received) : 0);
+    chprintf(chp, "%s queue: %u sent, depth max %u, wait avg %u us max %u us, %u allocs on empty pool\r\n",
+             name, stats.sent, stats.depth_max, avg, cycles_us(stats.wait_max), stats.pool_empty);
+}
+
+static void print_stats(BaseSequentialStream *chp)
+{
+    edl_stats_t stats;
+    comms_get_stats(&stats);
+    chprintf(chp, "EDL frames: %u accepted, %u rejected\r\n", stats.accepted, stats.rejected);
+    print_queue(chp, "RX", &rx_queue.fifo);
+    for (int i = 0; radio_devices[i].devp != NULL; i++) {
+        if (radio_devices[i].txq != NULL) {
+            print_queue(chp, radio_devices[i].name, &radio_devices[i].txq->fifo);
+        }
+    }
+    chprintf(chp, "Stage       count     avg us     max us\r\n");
+    print_stage(chp, "total", &stats.total);
+    print_stage(chp, "auth", &stats.auth);
+    print_stage(chp, "cmd", &stats.cmd);
+    print_stage(chp, "file", &stats.file);
+}
+
 static void print_response(BaseSequentialStream *chp)
 {
     if (chEvtWaitAnyTimeout(COMMS_EVENT_LOOPBACK_RX, TIME_S2I(30)) != 0) {
@@ -149,7 +188,7 @@ static void print_response(BaseSequentialStream *chp)
 static void send_cmd(cmd_code_t cmd_code, void *arg, size_t arg_len)
 {
     cmd_t *cmd;
-    tx_fb = fb_alloc(CMD_RESP_ALLOC, &rx_fifo);
+    tx_fb = fb_alloc(CMD_RESP_ALLOC, &rx_queue.fifo);
     /* TODO: What's the 2 for? */
     fb_reserve(tx_fb, USLP_MAX_HEADER_LEN + 2 + 6); /* TODO: Replace 6 with some calculation of SDLS overhead */
     cmd = fb_put(tx_fb, sizeof(cmd_t) + arg_len);
@@ -159,6 +198,24 @@ static void send_cmd(cmd_code_t cmd_code, void *arg, size_t arg_len)
     uslp_map_send(&edl_loopback_tx_link, tx_fb, 0, 0, true);
 }
 
+static bool wait_response(sysinterval_t timeout)
+{
+    return chEvtWaitAnyTimeout(COMMS_EVENT_LOOPBACK_RX, timeout) != 0;
+}
+
+/* Round trip time of a short command, or 0 on timeout */
+static sysinterval_t cmd_latency(void)
+{
+    uint8_t arg = tx_enabled();
+    systime_t start = chVTGetSystemTime();
+
+    send_cmd(CMD_TX_CTRL, &arg, sizeof(arg));
+    if (!wait_response(TIME_S2I(30))) {
+        return 0;
+    }
+    return chVTTimeElapsedSinceX(start);
+}
+
 static int send_file_seg(BaseSequentialStream *chp, char *src, char *dest, lfs_soff_t off, lfs_size_t len)
 {
     file_xfr_t *xfr;
@@ -176,14 +233,14 @@ static int send_file_seg(BaseSequentialStream *chp, char *src, char *dest, lfs_s
         return ret;
     }
 
-    tx_fb = fb_alloc(FB_MAX_LEN, &rx_fifo);
+    tx_fb = fb_alloc(FB_MAX_LEN, &rx_queue.fifo);
     /* TODO: What's the 2 for? */
     fb_reserve(tx_fb, USLP_MAX_HEADER_LEN + sizeof(file_xfr_t) + 2 + 6); /* TODO: Replace 6 with some calculation of SDLS overhead */
     data = fb_put(tx_fb, len);
     ret = file_read(&FSD1, file, data, len);
     file_close(&FSD1, file);
     if (ret < 0) {
-        fb_free(tx_fb, &rx_fifo);
+        fb_free(tx_fb, &rx_queue.fifo);
         return ret;
     }
     xfr = fb_push(tx_fb, sizeof(file_xfr_t));
@@ -243,22 +300,22 @@ void cmd_edl(BaseSequentialStream *chp, int argc, char *argv[])
         uint8_t arg = strtoul(argv[1], NULL, 0);
         send_cmd(CMD_TX_CTRL, &arg, sizeof(arg));
         print_response(chp);
-    } else if (!strcmp(argv[0], "fw_flash") && argc > 2) {
+    } else if ((!strcmp(argv[0], "fw_flash") || !strcmp(argv[0], "fw_flash_job")) && argc > 2) {
         struct {
             uint32_t crc;
             char filename[strlen(argv[1]) + 1];
         } arg;
         arg.crc = strtoul(argv[2], NULL, 0);
         memcpy(arg.filename, argv[1], strlen(argv[1]) + 1);
-        send_cmd(CMD_FW_FLASH, &arg, sizeof(arg));
+        send_cmd(!strcmp(argv[0], "fw_flash") ? CMD_FW_FLASH : CMD_FW_FLASH_JOB, &arg, sizeof(arg));
         print_response(chp);
     } else if (!strcmp(argv[0], "fw_bank") && argc > 1) {
         uint8_t arg = strtoul(argv[1], NULL, 0);
         send_cmd(CMD_FW_BANK, &arg, sizeof(arg));
         print_response(chp);
-    } else if (!strcmp(argv[0], "fw_verify") && argc > 1) {
+    } else if ((!strcmp(argv[0], "fw_verify") || !strcmp(argv[0], "fw_verify_job")) && argc > 1) {
         uint8_t arg = strtoul(argv[1], NULL, 0);
-        send_cmd(CMD_FW_VERIFY, &arg, sizeof(arg));
+        send_cmd(!strcmp(argv[0], "fw_verify") ? CMD_FW_VERIFY : CMD_FW_VERIFY_JOB, &arg, sizeof(arg));
         print_response(chp);
     } else if (!strcmp(argv[0], "c3_softreset")) {
         uint32_t arg[] = {0x01234567U, 0x89ABCDEFU};
@@ -275,8 +332,8 @@ void cmd_edl(BaseSequentialStream *chp, int argc, char *argv[])
         lfs_soff_t off = strtoul(argv[3], NULL, 0);
         lfs_ssize_t len = strtoul(argv[4], NULL, 0);
         chprintf(chp, "File send result: %d\r\n", send_file_seg(chp, argv[1], argv[2], off, len));
-    } else if (!strcmp(argv[0], "fs_format")) {
-        send_cmd(CMD_FS_FORMAT, NULL, 0);
+    } else if (!strcmp(argv[0], "fs_format") || !strcmp(argv[0], "fs_format_job")) {
+        send_cmd(!strcmp(argv[0], "fs_format") ? CMD_FS_FORMAT : CMD_FS_FORMAT_JOB, NULL, 0);
         print_response(chp);
     } else if (!strcmp(argv[0], "fs_unmount")) {
         send_cmd(CMD_FS_UNMOUNT, NULL, 0);
@@ -284,8 +341,8 @@ void cmd_edl(BaseSequentialStream *chp, int argc, char *argv[])
     } else if (!strcmp(argv[0], "fs_remove") && argc > 1) {
         send_cmd(CMD_FS_REMOVE, argv[1], strlen(argv[1]) + 1);
         print_response(chp);
-    } else if (!strcmp(argv[0], "fs_crc") && argc > 1) {
-        send_cmd(CMD_FS_CRC, argv[1], strlen(argv[1]) + 1);
+    } else if ((!strcmp(argv[0], "fs_crc") || !strcmp(argv[0], "fs_crc_job")) && argc > 1) {
+        send_cmd(!strcmp(argv[0], "fs_crc") ? CMD_FS_CRC : CMD_FS_CRC_JOB, argv[1], strlen(argv[1]) + 1);
         print_response(chp);
     } else if (!strcmp(argv[0], "node_enable") && argc > 2) {
         uint8_t arg[2];
@@ -325,6 +382,48 @@ void cmd_edl(BaseSequentialStream *chp, int argc, char *argv[])
         uint32_t arg = strtoul(argv[1], NULL, 0);
         send_cmd(CMD_RTC_SETTIME, &arg, sizeof(arg));
         print_response(chp);
+    } else if (!strcmp(argv[0], "job_status") && argc > 1) {
+        uint8_t arg = strtoul(argv[1], NULL, 0);
+        send_cmd(CMD_JOB_STATUS, &arg, sizeof(arg));
+        print_response(chp);
+    } else if (!strcmp(argv[0], "job_cancel") && argc > 1) {
+        uint8_t arg = strtoul(argv[1], NULL, 0);
+        send_cmd(CMD_JOB_CANCEL, &arg, sizeof(arg));
+        print_response(chp);
+    } else if (!strcmp(argv[0], "latency") && argc > 1) {
+        sysinterval_t idle = 0, busy = 0, dt;
+        cmd_job_status_t status;
+        uint8_t id;
+        int i, n = 0;
+
+        for (i = 0; i < 8; i++) {
+            idle += cmd_latency();
+        }
+        send_cmd(CMD_FS_CRC_JOB, argv[1], strlen(argv[1]) + 1);
+        if (!wait_response(TIME_S2I(30)) || (id = resp_buf[sizeof(uint32_t)]) == 0) {
+            chprintf(chp, "Error: FS CRC job not accepted\r\n");
+            return;
+        }
+        while (cmd_job_status(id, &status) &&
+               (status.state == JOB_QUEUED || status.state == JOB_RUNNING ||
+                status.state == JOB_CANCELLING)) {
+            if ((dt = cmd_latency()) == 0) {
+                chprintf(chp, "Error: No response while job %u running\r\n", id);
+                return;
+            }
+            busy += dt;
+            n++;
+        }
+        chprintf(chp, "Idle latency: %u us\r\n", TIME_I2US(idle / 8));
+        if (n) {
+            chprintf(chp, "Busy latency: %u us over %d commands\r\n", TIME_I2US(busy / n), n);
+        }
+        chprintf(chp, "Job %u state %u result %d CRC 0x%08X\r\n", id, status.state, status.result, status.crc);
+    } else if (!strcmp(argv[0], "stats")) {
+        if (argc > 1 && !strcmp(argv[1], "reset")) {
+            comms_reset_stats();
+        }
+        print_stats(chp);
     } else if (!strcmp(argv[0], "send")) {
         uint8_t buf[] = {
             0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07,
@@ -337,10 +436,10 @@ void cmd_edl(BaseSequentialStream *chp, int argc, char *argv[])
             0x38, 0x39, 0x3A, 0x3B, 0x3C, 0x3D, 0x3E, 0x3F
         };
         edl_enable(true);
-        tx_fb = fb_alloc(sizeof(buf), &tx_fifo);
+        tx_fb = fb_alloc(sizeof(buf), &uhf_txq.fifo);
         tx_fb->data_ptr = fb_put(tx_fb, sizeof(buf));
         memcpy(tx_fb->data_ptr, buf, sizeof(buf));
-        pdu_send(tx_fb, &tx_fifo);
+        pdu_send(tx_fb, &uhf_txq.fifo);
     } else {
         goto edl_usage;
     }
@@ -391,6 +490,16 @@ edl_usage:
                    "        Post a OPD Reset command for <addr> to EDL RX queue\r\n"
                    "    opd_status <addr>:\r\n"
                    "        Post a OPD Status command for <addr> to EDL RX queue\r\n"
+                   "    fw_flash_job, fw_verify_job, fs_format_job, fs_crc_job:\r\n"
+                   "        As above, run as a background job, the response holds the job ID\r\n"
+                   "    job_status <id>:\r\n"
+                   "        Post a Job Status command for <id> to EDL RX queue\r\n"
+                   "    job_cancel <id>:\r\n"
+                   "        Post a Job Cancel command for <id> to EDL RX queue\r\n"
+                   "    latency <filename>:\r\n"
+                   "        Compare short command latency idle and during an FS CRC job on <filename>\r\n"
+                   "    stats [reset]:\r\n"
+                   "        Show EDL queue and per-stage statistics, optionally clearing them first\r\n"
                    "    send:\r\n"
                    "        Send a packet on EDL link\r\n"
                    "\r\n");
@@ -0,0 +1,40 @@
+#include <string.h>
+#include "test_farm.h"
+#include "farm.h"
+#include "CANopen.h"
+#include "OD.h"
+#include "chprintf.h"
+
+/*===========================================================================*/
+/* COP-1 FARM                                                                */
+/*===========================================================================*/
+void cmd_farm(BaseSequentialStream *chp, int argc, char *argv[])
+{
+    if (argc < 1) {
+        goto farm_usage;
+    }
+
+    if (!strcmp(argv[0], "status")) {
+        uint32_t clcw = OD_RAM.x7000_C3_Telemetry.VC2_CLCW;
+        chprintf(chp, "CLCW:        0x%08X\r\n", clcw);
+        chprintf(chp, "V(R):        %u\r\n", clcw & FARM_CLCW_REPORT_Msk);
+        chprintf(chp, "Lockout:     %u\r\n", (clcw & FARM_CLCW_LOCKOUT) != 0);
+        chprintf(chp, "Wait:        %u\r\n", (clcw & FARM_CLCW_WAIT) != 0);
+        chprintf(chp, "Retransmit:  %u\r\n", (clcw & FARM_CLCW_RETRANSMIT) != 0);
+        chprintf(chp, "FARM-B:      %u\r\n", (clcw >> FARM_CLCW_FARMB_Pos) & 0x3U);
+        chprintf(chp, "Accepted:    %u\r\n", OD_RAM.x7000_C3_Telemetry.VC2_Accepted);
+        chprintf(chp, "Rejected:    %u\r\n", OD_RAM.x7000_C3_Telemetry.VC2_Rejected);
+        chprintf(chp, "Retransmits: %u\r\n", OD_RAM.x7000_C3_Telemetry.VC2_Retransmits);
+        chprintf(chp, "Lockouts:    %u\r\n", OD_RAM.x7000_C3_Telemetry.VC2_Lockouts);
+    } else {
+        goto farm_usage;
+    }
+    return;
+
+farm_usage:
+    chprintf(chp, "\r\n"
+                  "Usage: farm <cmd>\r\n"
+                  "    status:      Show the VC2 CLCW and COP-1 counters\r\n"
+                  "\r\n");
+    return;
+}
@@ -0,0 +1,16 @@
+#ifndef _TEST_FARM_H_
+#define _TEST_FARM_H_
+
+#include "ch.h"
+#include "hal.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void cmd_farm(BaseSequentialStream *chp, int argc, char *argv[]);
+
+#ifdef __cplusplus
+}
+#endif /*__cplusplus*/
+#endif
@@ -0,0 +1,354 @@
+#include <stdlib.h>
+#include <string.h>
+#include "test_fec.h"
+#include "fec.h"
+#include "comms.h"
+#include "chprintf.h"
+
+#define FEC_TEST_LEN                223U
+#define FEC_TEST_DEPTH              4U
+#define RS_FCR                      112U
+#define RS_PRIM                     11U
+#define RS_IPRIM                    116U
+#define RS_A0                       FEC_RS_N
+
+static uint8_t fec_data[FEC_TEST_LEN * FEC_TEST_DEPTH];
+static uint8_t fec_rs[FEC_RS_N * FEC_TEST_DEPTH];
+static uint8_t fec_conv[FEC_CONV_LEN(FEC_RS_N * FEC_TEST_DEPTH)];
+static uint8_t fec_dec[FEC_RS_N * FEC_TEST_DEPTH + 1];
+static uint8_t fec_word[FEC_RS_N];
+
+/* Hard decision Viterbi survivors, one bit per state per input bit */
+#define VIT_RING                    128U
+#define VIT_DEPTH                   96U
+static uint64_t vit_dec[VIT_RING];
+
+static uint32_t fec_seed;
+
+static uint32_t fec_rand(void)
+{
+    fec_seed = fec_seed * 1103515245U + 12345U;
+    return fec_seed >> 8;
+}
+
+static unsigned modnn(unsigned x)
+{
+    while (x >= FEC_RS_N) {
+        x -= FEC_RS_N;
+        x = (x >> 8) + (x & FEC_RS_N);
+    }
+    return x;
+}
+
+/*
+ * Berlekamp-Massey, Chien search and Forney on one conventional basis
+ * codeword of len symbols (shortened by FEC_RS_N - len). Returns the number
+ * of corrected symbols or -1 if uncorrectable.
+ */
+static int rs_decode(uint8_t *data, size_t len)
+{
+    const uint8_t *alpha_to = fec_alpha_to;
+    const uint8_t *index_of = fec_index_of;
+    unsigned pad = FEC_RS_N - len;
+    uint8_t lambda[FEC_RS_PARITY + 1], s[FEC_RS_PARITY], b[FEC_RS_PARITY + 1];
+    uint8_t t[FEC_RS_PARITY + 1], omega[FEC_RS_PARITY + 1], reg[FEC_RS_PARITY + 1];
+    uint8_t root[FEC_RS_PARITY], loc[FEC_RS_PARITY];
+    int deg_lambda, el, deg_omega, count;
+    unsigned r, i, j, k, q, tmp, num1, num2, den, discr_r;
+    uint8_t syn_error = 0;
+
+    for (i = 0; i < FEC_RS_PARITY; i++)
+        s[i] = data[0];
+    for (j = 1; j < len; j++) {
+        for (i = 0; i < FEC_RS_PARITY; i++) {
+            if (s[i] == 0)
+                s[i] = data[j];
+            else
+                s[i] = data[j] ^ alpha_to[modnn(index_of[s[i]] + (RS_FCR + i) * RS_PRIM)];
+        }
+    }
+    for (i = 0; i < FEC_RS_PARITY; i++) {
+        syn_error |= s[i];
+        s[i] = index_of[s[i]];
+    }
+    if (!syn_error)
+        return 0;
+
+    memset(&lambda[1], 0, FEC_RS_PARITY);
+    lambda[0] = 1;
+    for (i = 0; i <= FEC_RS_PARITY; i++)
+        b[i] = index_of[lambda[i]];
+
+    r = 0;
+    el = 0;
+    while (++r <= FEC_RS_PARITY) {
+        discr_r = 0;
+        for (i = 0; i < r; i++) {
+            if (lambda[i] != 0 && s[r - i - 1] != RS_A0)
+                discr_r ^= alpha_to[modnn(index_of[lambda[i]] + s[r - i - 1])];
+        }
+        discr_r = index_of[discr_r];
+        if (discr_r == RS_A0) {
+            memmove(&b[1], b, FEC_RS_PARITY);
+            b[0] = RS_A0;
+        } else {
+            t[0] = lambda[0];
+            for (i = 0; i < FEC_RS_PARITY; i++) {
+                if (b[i] != RS_A0)
+                    t[i + 1] = lambda[i + 1] ^ alpha_to[modnn(discr_r + b[i])];
+                else
+                    t[i + 1] = lambda[i + 1];
+            }
+            if (2 * el <= (int)r - 1) {
+                el = r - el;
+                for (i = 0; i <= FEC_RS_PARITY; i++)
+                    b[i] = (lambda[i] == 0) ? RS_A0 : modnn(index_of[lambda[i]] - discr_r + FEC_RS_N);
+            } else {
+                memmove(&b[1], b, FEC_RS_PARITY);
+                b[0] = RS_A0;
+            }
+            memcpy(lambda, t, FEC_RS_PARITY + 1);
+        }
+    }
+
+    deg_lambda = 0;
+    for (i = 0; i <= FEC_RS_PARITY; i++) {
+        lambda[i] = index_of[lambda[i]];
+        if (lambda[i] != RS_A0)
+            deg_lambda = i;
+    }
+
+    memcpy(&reg[1], &lambda[1], FEC_RS_PARITY);
+    count = 0;
+    for (i = 1, k = RS_IPRIM - 1; i <= FEC_RS_N; i++, k = modnn(k + RS_IPRIM)) {
+        q = 1;
+        for (j = deg_lambda; j > 0; j--) {
+            if (reg[j] != RS_A0) {
+                reg[j] = modnn(reg[j] + j);
+                q ^= alpha_to[reg[j]];
+            }
+        }
+        if (q != 0)
+            continue;
+        root[count] = i;
+        loc[count] = k;
+        if (++count == deg_lambda)
+            break;
+    }
+    if (deg_lambda != count)
+        return -1;
+
+    deg_omega = deg_lambda - 1;
+    for (i = 0; (int)i <= deg_omega; i++) {
+        tmp = 0;
+        for (j = 0; j <= i; j++) {
+            if (s[i - j] != RS_A0 && lambda[j] != RS_A0)
+                tmp ^= alpha_to[modnn(s[i - j] + lambda[j])];
+        }
+        omega[i] = index_of[tmp];
+    }
+
+    for (int n = count - 1; n >= 0; n--) {
+        num1 = 0;
+        for (int m = deg_omega; m >= 0; m--) {
+            if (omega[m] != RS_A0)
+                num1 ^= alpha_to[modnn(omega[m] + m * root[n])];
+        }
+        num2 = alpha_to[modnn(root[n] * (RS_FCR - 1) + FEC_RS_N)];
+        den = 0;
+        int m = (deg_lambda < (int)FEC_RS_PARITY - 1 ? deg_lambda : (int)FEC_RS_PARITY - 1) & ~1;
+        for (; m >= 0; m -= 2) {
+            if (lambda[m + 1] != RS_A0)
+                den ^= alpha_to[modnn(lambda[m + 1] + m * root[n])];
+        }
+        if (den == 0)
+            return -1;
+        if (num1 != 0 && loc[n] >= pad)
+            data[loc[n] - pad] ^= alpha_to[modnn(index_of[num1] + index_of[num2] + FEC_RS_N - index_of[den])];
+    }
+    return count;
+}
+
+/* Deinterleave, decode and reinterleave an RS block in place */
+static int rs_decode_block(uint8_t *block, size_t len, uint8_t depth)
+{
+    size_t n = len / depth;
+    int total = 0;
+
+    for (uint8_t i = 0; i < depth; i++) {
+        for (size_t j = 0; j < n; j++)
+            fec_word[j] = fec_tal1tab[block[j * depth + i]];
+        int ret = rs_decode(fec_word, n);
+        if (ret < 0)
+            return -1;
+        total += ret;
+        for (size_t j = 0; j < n; j++)
+            block[j * depth + i] = fec_taltab[fec_word[j]];
+    }
+    return total;
+}
+
+static unsigned vit_prev(unsigned s, size_t n)
+{
+    return (s >> 1) | (((vit_dec[n % VIT_RING] >> s) & 1U) << 5);
+}
+
+/*
+ * Hard decision Viterbi for the terminated rate 1/2 k=7 code. Bits are
+ * released VIT_DEPTH steps behind the best path so only a small ring of
+ * decisions is kept.
+ */
+static void conv_decode(const uint8_t *in, size_t len, uint8_t *out)
+{
+    uint16_t metric[64], next[64];
+    size_t bits = len * 4;
+    unsigned s;
+
+    for (s = 0; s < 64; s++)
+        metric[s] = (s == 0 ? 0 : 0x3FFF);
+    memset(out, 0, len / 2);
+
+    for (size_t n = 0; n < bits; n++) {
+        unsigned sym = (in[n / 4] >> (6 - 2 * (n % 4))) & 0x3U;
+        unsigned best_s = 0;
+        uint64_t dec = 0;
+        for (s = 0; s < 64; s++) {
+            /* s is the new state, its LSB the input bit. Predecessors differ in the oldest bit */
+            unsigned best = 0xFFFF, choice = 0;
+            for (unsigned old = 0; old < 2; old++) {
+                unsigned prev = (s >> 1) | (old << 5);
+                unsigned sr = (prev << 1) | (s & 1U);
+                unsigned exp = (__builtin_parity(sr & 0x4FU) << 1) | (__builtin_parity(sr & 0x6DU) ^ 1U);
+                unsigned m = metric[prev] + __builtin_popcount(exp ^ sym);
+                if (m < best) {
+                    best = m;
+                    choice = old;
+                }
+            }
+            next[s] = best;
+            dec |= (uint64_t)choice << s;
+            if (best < next[best_s])
+                best_s = s;
+        }
+        memcpy(metric, next, sizeof(metric));
+        vit_dec[n % VIT_RING] = dec;
+
+        if (n >= VIT_DEPTH) {
+            s = best_s;
+            for (size_t m = n; m > n - VIT_DEPTH; m--)
+                s = vit_prev(s, m);
+            if (s & 1U)
+                out[(n - VIT_DEPTH) / 8] |= 0x80U >> ((n - VIT_DEPTH) % 8);
+        }
+    }
+
+    /* Terminated in state 0 */
+    s = 0;
+    for (size_t n = bits; n-- > 0 && n + VIT_DEPTH >= bits;) {
+        if (s & 1U)
+            out[n / 8] |= 0x80U >> (n % 8);
+        s = vit_prev(s, n);
+    }
+}
+
+/* Flip each bit with probability ber_ppm / 1e6, returns bits flipped */
+static unsigned fec_noise(uint8_t *buf, size_t len, uint32_t ber_ppm)
+{
+    unsigned flips = 0;
+    for (size_t n = 0; n < len * 8; n++) {
+        if ((fec_rand() % 1000000U) < ber_ppm) {
+            buf[n / 8] ^= 0x80U >> (n % 8);
+            flips++;
+        }
+    }
+    return flips;
+}
+
+static uint32_t fec_bench(bool conv)
+{
+    uint32_t bytes = 0;
+    systime_t start = chVTGetSystemTime();
+    systime_t end = chTimeAddX(start, TIME_S2I(1));
+    while (chVTIsSystemTimeWithin(start, end)) {
+        size_t len = fec_rs_encode(fec_data, sizeof(fec_data), FEC_TEST_DEPTH, fec_rs, sizeof(fec_rs));
+        if (conv)
+            fec_conv_encode(fec_rs, len, fec_conv, sizeof(fec_conv));
+        bytes += sizeof(fec_data);
+    }
+    return bytes;
+}
+
+/*===========================================================================*/
+/* Forward Error Correction                                                  */
+/*===========================================================================*/
+void cmd_fec(BaseSequentialStream *chp, int argc, char *argv[])
+{
+    if (argc < 1) {
+        goto fec_usage;
+    }
+
+    if (!strcmp(argv[0], "mode")) {
+        uint8_t depth;
+        bool conv;
+        if (argc > 1 && !comms_set_fec(strtoul(argv[1], NULL, 0), (argc > 2 && !strcmp(argv[2], "conv")))) {
+            chprintf(chp, "Error: Invalid interleave depth\r\n");
+            goto fec_usage;
+        }
+        comms_get_fec(&depth, &conv);
+        chprintf(chp, "Downlink FEC: %s", (depth ? "RS(255,223)" : "off"));
+        if (depth)
+            chprintf(chp, " I=%u%s", depth, (conv ? " + conv k=7 r=1/2" : ""));
+        chprintf(chp, "\r\n");
+    } else if (!strcmp(argv[0], "bench")) {
+        for (size_t i = 0; i < sizeof(fec_data); i++)
+            fec_data[i] = i;
+        chprintf(chp, "RS(255,223) I=%u:      %u B/s\r\n", FEC_TEST_DEPTH, fec_bench(false));
+        chprintf(chp, "RS + conv k=7 r=1/2:  %u B/s\r\n", fec_bench(true));
+    } else if (!strcmp(argv[0], "ber") && argc > 1) {
+        uint32_t ber = strtoul(argv[1], NULL, 0);
+        unsigned frames = (argc > 2 ? strtoul(argv[2], NULL, 0) : 100);
+        bool conv = (argc > 3 && !strcmp(argv[3], "conv"));
+        unsigned ok = 0, raw_ok = 0, flips = 0, fixed = 0;
+
+        fec_seed = 1;
+        for (unsigned f = 0; f < frames; f++) {
+            for (size_t i = 0; i < sizeof(fec_data); i++)
+                fec_data[i] = fec_rand();
+            size_t len = fec_rs_encode(fec_data, sizeof(fec_data), FEC_TEST_DEPTH, fec_rs, sizeof(fec_rs));
+            if (conv) {
+                size_t clen = fec_conv_encode(fec_rs, len, fec_conv, sizeof(fec_conv));
+                flips += fec_noise(fec_conv, clen, ber);
+                conv_decode(fec_conv, clen, fec_dec);
+            } else {
+                memcpy(fec_dec, fec_rs, len);
+                flips += fec_noise(fec_dec, len, ber);
+            }
+            raw_ok += (memcmp(fec_dec, fec_data, sizeof(fec_data)) == 0);
+            int ret = rs_decode_block(fec_dec, len, FEC_TEST_DEPTH);
+            if (ret >= 0 && memcmp(fec_dec, fec_data, sizeof(fec_data)) == 0) {
+                ok++;
+                fixed += ret;
+            }
+        }
+        chprintf(chp, "Frames:     %u at %u ppm BER%s\r\n", frames, ber, (conv ? " with conv" : ""));
+        chprintf(chp, "Bit flips:  %u\r\n", flips);
+        chprintf(chp, "Before RS:  %u\r\n", raw_ok);
+        chprintf(chp, "Decoded OK: %u (%u RS symbols corrected)\r\n", ok, fixed);
+    } else {
+        goto fec_usage;
+    }
+    return;
+
+fec_usage:
+    chprintf(chp, "\r\n"
+                  "Usage: fec <cmd>\r\n"
+                  "    mode [depth] [conv]:\r\n"
+                  "                 Show or set downlink FEC. Depth 0 disables it, 'conv'\r\n"
+                  "                 adds the convolutional code\r\n"
+                  "    bench:       Measure encode throughput\r\n"
+                  "    ber <ppm> [frames] [conv]:\r\n"
+                  "                 Encode random frames, flip bits at <ppm> BER, decode and\r\n"
+                  "                 count frames recovered. 'conv' adds the convolutional code\r\n"
+                  "\r\n");
+    return;
+}
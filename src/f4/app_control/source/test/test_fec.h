@@ -0,0 +1,16 @@
+#ifndef _TEST_FEC_H_
+#define _TEST_FEC_H_
+
+#include "ch.h"
+#include "hal.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void cmd_fec(BaseSequentialStream *chp, int argc, char *argv[]);
+
+#ifdef __cplusplus
+}
+#endif /*__cplusplus*/
+#endif
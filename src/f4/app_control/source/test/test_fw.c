@@ -95,15 +95,17 @@ void cmd_fw(BaseSequentialStream *chp, int argc, char *argv[])
         chprintf(chp, "Done!\r\n");
     } else if (!strcmp(argv[0], "flash") && argc > 2) {
         uint32_t crc = strtoul(argv[2], NULL, 0);
+        systime_t start;
         int err;
 
         chprintf(chp, "Erasing offline bank and writing %s... ", argv[1]);
+        start = chVTGetSystemTime();
         err = fw_flash(&EFLD1, argv[1], crc);
         if (err != 0) {
             chprintf(chp, "Error: Return code %d\r\n", err);
             return;
         }
-        chprintf(chp, "Done!\r\n");
+        chprintf(chp, "Done in %u ms!\r\n", TIME_I2MS(chVTTimeElapsedSinceX(start)));
     } else if (!strcmp(argv[0], "crc") && argc > 2) {
         fw_bank_t bank;
         size_t len = strtoul(argv[2], NULL, 0);
@@ -3,8 +3,11 @@
 #include <limits.h>
 
 #include "test_hmac.h"
+#include "hmac.h"
 #include "chprintf.h"
 
+#define HMAC_BENCH_FRAME_LEN        256U
+
 struct TestCase {
     const uint8_t *key;
     const size_t keylen;
@@ -65,13 +68,78 @@ void testHMACSHA256(BaseSequentialStream *chp, CRYDriver *cryp, const struct Tes
     } else {
         chprintf(chp, "good\r\n");
     }
+
+    hmac_key_t key;
+    hmac_ctx_t sw_ctx;
+    chprintf(chp, "hmac_verify() (cached key) ... ");
+    hmac_key_init(&key, tc->key, tc->keylen);
+    hmac_init(&sw_ctx, &key);
+    /* Feed in two pieces to exercise the streaming interface */
+    hmac_update(&sw_ctx, tc->data, tc->datalen / 2);
+    hmac_update(&sw_ctx, &tc->data[tc->datalen / 2], tc->datalen - tc->datalen / 2);
+    if (!hmac_verify(&sw_ctx, tc->hmac, tc->hmaclen)) {
+        chprintf(chp, "failed\r\n");
+    } else {
+        chprintf(chp, "good\r\n");
+    }
+}
+
+static void benchHMACSHA256(BaseSequentialStream *chp, CRYDriver *cryp)
+{
+    static uint8_t frame[HMAC_BENCH_FRAME_LEN];
+    static const uint8_t bench_key[HMAC_KEY_LEN] = {0};
+    uint8_t mac[HMAC_MAC_LEN];
+    uint32_t frames = 0;
+    systime_t start, end;
+
+    /* Transient key per frame, as hmac_recv() used to do */
+    start = chVTGetSystemTime();
+    end = chTimeAddX(start, TIME_S2I(1));
+    while (chVTIsSystemTimeWithin(start, end)) {
+        HMACSHA256Context ctx = {0};
+        if (cryLoadHMACTransientKey(cryp, sizeof(bench_key), bench_key) != CRY_NOERROR ||
+            cryHMACSHA256Init(cryp, &ctx) != CRY_NOERROR ||
+            cryHMACSHA256Update(cryp, &ctx, sizeof(frame), frame) != CRY_NOERROR ||
+            cryHMACSHA256Final(cryp, &ctx, mac) != CRY_NOERROR) {
+            chprintf(chp, "CRY HMAC failed\r\n");
+            return;
+        }
+        frames++;
+    }
+    chprintf(chp, "CRY transient key: %u frames/S\r\n", frames);
+
+    /* Midstates computed once, per frame cost is the message blocks only */
+    hmac_key_t key;
+    hmac_ctx_t ctx;
+    hmac_key_init(&key, bench_key, sizeof(bench_key));
+    frames = 0;
+    start = chVTGetSystemTime();
+    end = chTimeAddX(start, TIME_S2I(1));
+    while (chVTIsSystemTimeWithin(start, end)) {
+        hmac_init(&ctx, &key);
+        hmac_update(&ctx, frame, sizeof(frame));
+        hmac_verify(&ctx, mac, sizeof(mac));
+        frames++;
+    }
+    chprintf(chp, "Cached key:        %u frames/S (%u byte frames)\r\n", frames, sizeof(frame));
 }
 
 
 void cmd_hmac(BaseSequentialStream *chp, int argc, char *argv[])
 {
-    (void) argc;
-    (void) argv;
+    if (argc > 0) {
+        if (!strcmp(argv[0], "bench")) {
+            benchHMACSHA256(chp, &CRYD1);
+        } else {
+            chprintf(chp,  "Usage: hmac [command]\r\n"
+                           "    (none):\r\n"
+                           "        Run RFC 4231 test vectors\r\n"
+                           "    bench:\r\n"
+                           "        Measure frames verified per second\r\n"
+                           "\r\n");
+        }
+        return;
+    }
 
     /* Taken from RFC 4231: Test Vectors for HMAC-SHA-256 */
     // 4.2. Test Case 1
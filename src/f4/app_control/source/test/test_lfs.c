@@ -173,6 +173,61 @@ void cmd_lfs(BaseSequentialStream *chp, int argc, char *argv[])
             chprintf(chp, "Error in file_close: %d\r\n", ret);
             return;
         }
+    } else if (!strcmp(argv[0], "info")) {
+        chprintf(chp, "Block size:     %u\r\n"
+                      "Block count:    %u\r\n"
+                      "Cache size:     %u\r\n"
+                      "Lookahead size: %u (%u blocks per scan)\r\n",
+                      FSD1.lfscfg.block_size, FSD1.lfscfg.block_count,
+                      FSD1.lfscfg.cache_size, FSD1.lfscfg.lookahead_size,
+                      FSD1.lfscfg.lookahead_size * 8);
+    } else if (!strcmp(argv[0], "bench") && argc > 1) {
+        const int count = 64;
+        systime_t start, t_open, t_write, t_close;
+
+        memset(buf, 0xA5, BUF_SIZE);
+        start = chVTGetSystemTime();
+        file = file_open(&FSD1, argv[1], LFS_O_WRONLY | LFS_O_CREAT | LFS_O_TRUNC);
+        if (file == NULL) {
+            chprintf(chp, "Error in file_open: %d\r\n", FSD1.err);
+            return;
+        }
+        t_open = chVTTimeElapsedSinceX(start);
+        start = chVTGetSystemTime();
+        for (int i = 0; i < count; i++) {
+            ret = file_write(&FSD1, file, buf, BUF_SIZE);
+            if (ret < 0) {
+                chprintf(chp, "Error in file_write: %d\r\n", ret);
+                break;
+            }
+        }
+        t_write = chVTTimeElapsedSinceX(start);
+        start = chVTGetSystemTime();
+        ret = file_close(&FSD1, file);
+        if (ret < 0) {
+            chprintf(chp, "Error in file_close: %d\r\n", ret);
+            return;
+        }
+        t_close = chVTTimeElapsedSinceX(start);
+        chprintf(chp, "open %u ticks, write %u bytes %u ticks, close %u ticks\r\n",
+                t_open, count * BUF_SIZE, t_write, t_close);
+    } else if (!strcmp(argv[0], "usage")) {
+        systime_t start;
+        uint8_t pct;
+        lfs_ssize_t counted = FSD1.used_blocks;
+
+        start = chVTGetSystemTime();
+        pct = fs_usage(&FSD1);
+        chprintf(chp, "Incremental: %d blocks (%u%%) in %u ticks\r\n",
+                FSD1.used_blocks, pct, chVTTimeElapsedSinceX(start));
+        start = chVTGetSystemTime();
+        ret = fs_reconcile(&FSD1, true);
+        if (ret < 0) {
+            chprintf(chp, "Error in fs_reconcile: %d\r\n", ret);
+            return;
+        }
+        chprintf(chp, "Traversal:   %d blocks (%u%%) in %u ticks, drift %d\r\n",
+                ret, fs_usage(&FSD1), chVTTimeElapsedSinceX(start), counted - ret);
     } else if (!strcmp(argv[0], "mount")) {
         chprintf(chp, "Attempting to mount LFS...\r\n");
         ret = fs_mount(&FSD1, false);
@@ -211,6 +266,9 @@ lfs_usage:
                    "    crc:        Print CRC32 of file\r\n"
                    "    cat:        Dump 255 bytes of file as string\r\n"
                    "    hexdump:    Dump 255 bytes of file as hex\r\n"
+                   "    usage:      Compare usage count against a full traversal\r\n"
+                   "    info:       Show block device and cache geometry\r\n"
+                   "    bench:      Time open/write/close of a 16KiB file at path\r\n"
                    "\r\n"
                    "    mount:      Mount LFS\r\n"
                    "    unmount:    Unmount LFS\r\n"
@@ -0,0 +1,54 @@
+#include <string.h>
+#include "test_link.h"
+#include "link.h"
+#include "comms.h"
+#include "chprintf.h"
+
+/*===========================================================================*/
+/* Downlink Rate Selection                                                   */
+/*===========================================================================*/
+void cmd_link(BaseSequentialStream *chp, int argc, char *argv[])
+{
+    static const char *const modes[] = {"auto", "low", "high"};
+
+    if (argc < 1) {
+        goto link_usage;
+    }
+
+    if (!strcmp(argv[0], "status")) {
+        link_t link;
+        comms_get_link(&link);
+        chprintf(chp, "Mode:        %s\r\n", modes[link.mode]);
+        chprintf(chp, "Rate:        %s\r\n", (link.high ? "high" : "low"));
+        chprintf(chp, "In pass:     %u\r\n", link.in_pass);
+        chprintf(chp, "RSSI:        %d\r\n", link.rssi);
+        chprintf(chp, "FER:         %u%%\r\n", link.fer);
+        chprintf(chp, "Freq offset: %d Hz\r\n", link.foff);
+        chprintf(chp, "Frames:      %u\r\n", link.frames);
+        chprintf(chp, "Errors:      %u\r\n", link.errors);
+        chprintf(chp, "Switches:    %u\r\n", link.switches);
+        chprintf(chp, "Passes:      %u\r\n", link.passes);
+    } else if (!strcmp(argv[0], "mode") && argc > 1) {
+        link_mode_t mode;
+        for (mode = LINK_AUTO; mode <= LINK_FIXED_HIGH; mode++) {
+            if (!strcmp(argv[1], modes[mode]))
+                break;
+        }
+        if (mode > LINK_FIXED_HIGH) {
+            goto link_usage;
+        }
+        comms_set_link(mode);
+    } else {
+        goto link_usage;
+    }
+    return;
+
+link_usage:
+    chprintf(chp, "\r\n"
+                  "Usage: link <cmd>\r\n"
+                  "    status:      Show downlink rate selection state\r\n"
+                  "    mode <auto|low|high>:\r\n"
+                  "                 Select the downlink rate from uplink quality or fix it\r\n"
+                  "\r\n");
+    return;
+}
@@ -38,7 +38,12 @@ void cmd_node(BaseSequentialStream *chp, int argc, char *argv[])
             chprintf(chp, "NOT CONNECTED\r\n");
         }
     } else if (!strcmp(argv[0], "status")) {
+        static const char *phase_str[] = {
+            "OFF", "QUEUED", "INRUSH", "BOOTING", "UP", "BACKOFF", "FAILED"
+        };
         CO_NMT_internalState_t state;
+        node_phase_t phase;
+        uint8_t attempts = 0;
         chprintf(chp, "Status of node 0x%02X: ", node_id);
         switch (node_status(node_id, &state)) {
         case -1:
@@ -55,6 +60,9 @@ void cmd_node(BaseSequentialStream *chp, int argc, char *argv[])
             chprintf(chp, "Invalid return code!\r\n");
             break;
         }
+        phase = node_phase(node_id, &attempts);
+        chprintf(chp, "Power: %s (%u attempts)\r\n",
+                (phase < sizeof(phase_str) / sizeof(phase_str[0]) ? phase_str[phase] : "?"), attempts);
     } else {
         goto node_usage;
     }
@@ -98,6 +106,23 @@ void cmd_opd(BaseSequentialStream *chp, int argc, char *argv[])
     } else if (!strcmp(argv[0], "rescan")) {
         chprintf(chp, "Re-scanning OPD devices\r\n");
         opd_scan(false);
+    } else if (!strcmp(argv[0], "scantime")) {
+        i2caddr_t addrs[OPD_MAX_ADDR - OPD_MIN_ADDR + 1];
+        size_t count = 0, found;
+        systime_t start;
+
+        start = chVTGetSystemTime();
+        opd_scan(false);
+        chprintf(chp, "Full scan:     %u us\r\n", TIME_I2US(chVTTimeElapsedSinceX(start)));
+        for (i2caddr_t i = OPD_MIN_ADDR; i <= OPD_MAX_ADDR; i++) {
+            if (!opd_status(i, &status)) {
+                addrs[count++] = i;
+            }
+        }
+        start = chVTGetSystemTime();
+        found = opd_scan_addrs(addrs, count, false);
+        chprintf(chp, "Expected scan: %u us (%u of %u found)\r\n",
+                TIME_I2US(chVTTimeElapsedSinceX(start)), found, count);
     } else if (!strcmp(argv[0], "summary")) {
         chprintf(chp, "Board summary:\r\n");
         for (i2caddr_t i = OPD_MIN_ADDR; i <= OPD_MAX_ADDR; i++) {
@@ -187,6 +212,7 @@ opd_usage:
                   "    sysdisable:      Disable OPD subsystem (Power Off)\r\n"
                   "    sysrestart:      Cycle power on OPD subsystem\r\n"
                   "    rescan:          Rescans devices on OPD\r\n"
+                  "    scantime:        Time a full scan against probing only found devices\r\n"
                   "    enable:          Enable an OPD attached card\r\n"
                   "    disable:         Disable an OPD attached card\r\n"
                   "    reset:           Reset the circuit breaker of a card\r\n"
@@ -3,6 +3,9 @@
 #include "test_radio.h"
 #include "radio.h"
 #include "beacon.h"
+#include "morse.h"
+#include "comms.h"
+#include "sensors.h"
 #include "chprintf.h"
 
 #define PA_SAMPLES 8
@@ -15,6 +18,8 @@ typedef struct {
 
 static pa_samples_t pa_samples[PA_SAMPLES * 2];
 static pa_samples_t pa_avg = {0};
+/* Set while "rf start" has background sensor sampling stopped */
+static bool rf_stopped_sensors = false;
 
 static void  adccallback(ADCDriver *adcp) {
     uint32_t start, end;
@@ -168,6 +173,82 @@ void cmd_radio(BaseSequentialStream *chp, int argc, char *argv[])
         }
     } else if (!strcmp(argv[0], "rssi")) {
         chprintf(chp, "AGCCOUNTER: %u\r\nRSSI: %d\r\nBGNDRSSI: %d\r\n", ax5043ReadU8(devp, AX5043_REG_AGCCOUNTER), (int8_t)ax5043ReadU8(devp, AX5043_REG_RSSI), (int8_t)ax5043ReadU8(devp, AX5043_REG_BGNDRSSI));
+    } else if (!strcmp(argv[0], "stats")) {
+        const ax5043_rx_stats_t *stats = &devp->rx_stats;
+        chprintf(chp, "Frames:      %u\r\n"
+                      "CRC fail:    %u\r\n"
+                      "Addr fail:   %u\r\n"
+                      "Size fail:   %u\r\n"
+                      "Abort:       %u\r\n"
+                      "Overflow:    %u\r\n"
+                      "FIFO reads:  %u\r\n",
+                      stats->frames, stats->crc_fail, stats->addr_fail, stats->size_fail,
+                      stats->abort, stats->overflow, stats->fifo_reads);
+    } else if (!strcmp(argv[0], "vco")) {
+        if (argc > 1 && !strcmp(argv[1], "clear")) {
+            ax5043ClearVCOCache(devp);
+        } else if (argc > 1 && !strcmp(argv[1], "check")) {
+            const ax5043_profile_t *profile = ax5043GetProfile(devp);
+            uint32_t hits = devp->vco_hits, misses = devp->vco_misses;
+            uint8_t vcora, vcorb;
+            bool ok;
+
+            /* Cold tune ranges both channels and records them */
+            ax5043ClearVCOCache(devp);
+            ax5043SetProfile(devp, profile);
+            vcora = devp->vcora;
+            vcorb = devp->vcorb;
+            ok = (devp->vco_misses == misses + 2 && devp->vco_hits == hits);
+            chprintf(chp, "Cold tune ranges:      %s\r\n", (ok ? "PASS" : "FAIL"));
+
+            /* Warm tune writes the recorded ranges */
+            ax5043WriteU8(devp, AX5043_REG_PLLRANGINGA, 0);
+            ax5043WriteU8(devp, AX5043_REG_PLLRANGINGB, 0);
+            ax5043SetProfile(devp, profile);
+            ok = (devp->vco_misses == misses + 2 && devp->vco_hits == hits + 2 &&
+                  _FLD2VAL(AX5043_PLLRANGING_VCOR, ax5043ReadU8(devp, AX5043_REG_PLLRANGINGA)) == vcora &&
+                  _FLD2VAL(AX5043_PLLRANGING_VCOR, ax5043ReadU8(devp, AX5043_REG_PLLRANGINGB)) == vcorb);
+            chprintf(chp, "Warm tune uses cache:  %s\r\n", (ok ? "PASS" : "FAIL"));
+
+            /* A large temperature change forces ranging again */
+            int16_t temp = devp->vco_temp;
+            ax5043SetVCOTemp(devp, 0);
+            ax5043ClearVCOCache(devp);
+            ax5043SetProfile(devp, profile);
+            ax5043SetVCOTemp(devp, AX5043_VCO_TEMP_DELTA + 1);
+            ax5043SetProfile(devp, profile);
+            ok = (devp->vco_misses == misses + 6);
+            chprintf(chp, "Temperature re-ranges: %s\r\n", (ok ? "PASS" : "FAIL"));
+            ax5043SetVCOTemp(devp, temp);
+        } else if (argc > 1 && !strcmp(argv[1], "bench")) {
+            const ax5043_profile_t *profile = ax5043GetProfile(devp);
+            const unsigned iters = 20;
+            systime_t start;
+
+            start = chVTGetSystemTime();
+            for (unsigned i = 0; i < iters; i++) {
+                ax5043ClearVCOCache(devp);
+                ax5043SetProfile(devp, profile);
+            }
+            chprintf(chp, "Ranged retune: %u us\r\n", TIME_I2US(chVTTimeElapsedSinceX(start)) / iters);
+
+            start = chVTGetSystemTime();
+            for (unsigned i = 0; i < iters; i++) {
+                ax5043SetProfile(devp, profile);
+            }
+            chprintf(chp, "Cached retune: %u us\r\n", TIME_I2US(chVTTimeElapsedSinceX(start)) / iters);
+        }
+        chprintf(chp, "Hits:        %u\r\n"
+                      "Misses:      %u\r\n"
+                      "Relocks:     %u\r\n"
+                      "Temperature: %d\r\n",
+                      devp->vco_hits, devp->vco_misses, devp->vco_relocks, devp->vco_temp);
+        for (uint32_t i = 0; i < AX5043_VCO_CACHE_SIZE; i++) {
+            const ax5043_vco_t *entry = &devp->vco_cache[i];
+            if (entry->vcor != 0) {
+                chprintf(chp, "%u: FREQ 0x%08X VCOR %u at %d C\r\n", i, entry->freq, entry->vcor, entry->temp);
+            }
+        }
     } else if (!strcmp(argv[0], "read") && argc > 2) {
         uint16_t reg = strtoul(argv[1], NULL, 0);
 
@@ -228,6 +309,10 @@ radio_usage:
                   "                 or set the profile to [num] if provided\r\n"
                   "\r\n"
                   "    rssi:        Get the current RSSI value\r\n"
+                  "    stats:       Print RX frame and error counters\r\n"
+                  "    vco [clear|check|bench]:\r\n"
+                  "                 Print the VCO range cache, clear it, check that\r\n"
+                  "                 retunes use it, or time ranged and cached retunes\r\n"
                   "\r\n"
                   "    read<reg> <type>:\r\n"
                   "                 Read <reg> where <type> is u8|u16|u24|u32\r\n"
@@ -242,6 +327,47 @@ radio_usage:
 /*===========================================================================*/
 /* OreSat Synthesizer Control                                                */
 /*===========================================================================*/
+#if SI41XX_USE_DMA
+/*
+ * Bit-level model of the SI41xx serial port driven by the recorded GPIO
+ * set/reset stream. Bits shift in on SCLK rising edges while SEN is low and
+ * SEN rising latches the word. Returns the number of words latched, or -1
+ * on a malformed word or data changing on a clock edge.
+ */
+static int synth_decode(const SI41XXDriver *devp, uint32_t *words, size_t max)
+{
+    const uint32_t sen = PAL_PORT_BIT(PAL_PAD(devp->config->sen));
+    const uint32_t sclk = PAL_PORT_BIT(PAL_PAD(devp->config->sclk));
+    const uint32_t sdata = PAL_PORT_BIT(PAL_PAD(devp->config->sdata));
+    uint32_t pins = sen | sclk, shift = 0;
+    unsigned bits = 0;
+    size_t n = 0;
+
+    for (size_t i = 0; i < devp->stream_len; i++) {
+        uint32_t bsrr = devp->stream[i];
+        uint32_t next = (pins & ~(bsrr >> 16)) | (bsrr & 0xFFFFU);
+
+        if (!(pins & sclk) && (next & sclk) && !(next & sen)) {
+            if ((pins ^ next) & sdata) {
+                return -1;
+            }
+            shift = (shift << 1) | ((next & sdata) != 0);
+            bits++;
+        }
+        if (!(pins & sen) && (next & sen)) {
+            if (bits != 22 || n == max) {
+                return -1;
+            }
+            words[n++] = shift & 0x3FFFFFU;
+            shift = 0;
+            bits = 0;
+        }
+        pins = next;
+    }
+    return n;
+}
+#endif
+
 void cmd_synth(BaseSequentialStream *chp, int argc, char *argv[])
 {
     static SI41XXDriver *devp = NULL;
@@ -299,6 +425,55 @@ void cmd_synth(BaseSequentialStream *chp, int argc, char *argv[])
         chprintf(chp, "IFDIV=%u\r\n", cfgp->if_div);
     } else if (!strcmp(argv[0], "status")) {
         chprintf(chp, "PLL: %s\r\n", (palReadLine(LINE_LO_PLL) ? "NOT LOCKED" : "LOCKED"));
+        chprintf(chp, "Divider cache: %u hits, %u misses\r\n", devp->div_hits, devp->div_misses);
+#if SI41XX_USE_DMA
+    } else if (!strcmp(argv[0], "check") && argc > 1) {
+        uint32_t freq = strtoul(argv[1], NULL, 0);
+        uint32_t words[SI41XX_MAX_WORDS], expect[4];
+        uint32_t hits = devp->div_hits;
+        int n;
+
+        if (!si41xxSetIF(devp, freq)) {
+            chprintf(chp, "Failed to set frequency\r\n");
+            goto synth_usage;
+        }
+        expect[0] = SI41XX_REG_PWRDOWN | ((devp->pwr & ~SI41XX_POWERDOWN_PBIB) << 4);
+        expect[1] = SI41XX_REG_IF_NDIV | (cfgp->if_n << 4);
+        expect[2] = SI41XX_REG_IF_RDIV | (cfgp->if_r << 4);
+        expect[3] = SI41XX_REG_PWRDOWN | (devp->pwr << 4);
+
+        n = synth_decode(devp, words, SI41XX_MAX_WORDS);
+        for (int i = 0; i < n; i++) {
+            chprintf(chp, "Word %d: reg %u data 0x%05X\r\n", i, words[i] & 0xFU, words[i] >> 4);
+        }
+        chprintf(chp, "Stream:  %s\r\n",
+                (n == 4 && !memcmp(words, expect, sizeof(expect)) ? "PASS" : "FAIL"));
+
+        si41xxSetIF(devp, freq);
+        chprintf(chp, "Cache:   %s\r\n", (devp->div_hits == hits + 1 ? "PASS" : "FAIL"));
+    } else if (!strcmp(argv[0], "bench") && argc > 2) {
+        uint32_t freq[2] = {strtoul(argv[1], NULL, 0), strtoul(argv[2], NULL, 0)};
+        const unsigned iters = 100;
+        systime_t start;
+
+        start = chVTGetSystemTime();
+        for (unsigned i = 0; i < iters; i++) {
+            memset(devp->div_cache, 0, sizeof(devp->div_cache));
+            if (!si41xxSetIF(devp, freq[i & 1])) {
+                chprintf(chp, "Failed to set frequency\r\n");
+                goto synth_usage;
+            }
+        }
+        chprintf(chp, "Uncached retune: %u us\r\n", TIME_I2US(chVTTimeElapsedSinceX(start)) / iters);
+
+        start = chVTGetSystemTime();
+        for (unsigned i = 0; i < iters; i++) {
+            si41xxSetIF(devp, freq[i & 1]);
+        }
+        chprintf(chp, "Cached retune:   %u us\r\n", TIME_I2US(chVTTimeElapsedSinceX(start)) / iters);
+        chprintf(chp, "Stream:          %u steps, %u us\r\n", devp->stream_len,
+                devp->stream_len * 1000000U / SI41XX_DMA_STEP_FREQ);
+#endif
     } else {
         goto synth_usage;
     }
@@ -317,7 +492,14 @@ synth_usage:
                   "\r\n"
                   "    freq <freq>: Sets frequency of IF output to <freq>\r\n"
                   "    ifdiv <div>: Sets IF output divider to <div> (1,2,4,8)\r\n"
-                  "    status:      Print PLL lock status\r\n"
+                  "    status:      Print PLL lock status and divider cache counters\r\n"
+#if SI41XX_USE_DMA
+                  "    check <freq>:\r\n"
+                  "                 Set the IF to <freq> and verify the serial stream words\r\n"
+                  "    bench <freq1> <freq2>:\r\n"
+                  "                 Time retunes between two frequencies with and without\r\n"
+                  "                 the divider cache\r\n"
+#endif
                   "\r\n");
     return;
 }
@@ -348,9 +530,16 @@ void cmd_rf(BaseSequentialStream *chp, int argc, char *argv[])
         chThdSleepMicroseconds(10);
         palClearLine(LINE_TOT_RESET);
     } else if (!strcmp(argv[0], "start")) {
+        if (!rf_stopped_sensors)
+            rf_stopped_sensors = sensors_stop();
         adcStartConversion(&ADCD1, &pa_pwr_cfg, (adcsample_t*)pa_samples, PA_SAMPLES * 2);
     } else if (!strcmp(argv[0], "stop")) {
         adcStopConversion(&ADCD1);
+        /* Only resume sampling that "rf start" interrupted */
+        if (rf_stopped_sensors) {
+            sensors_start();
+            rf_stopped_sensors = false;
+        }
     } else if (!strcmp(argv[0], "status")) {
         chprintf(chp, "PA State: %s\r\nLNA State: %s\r\nTOT State: %s\r\n"
                       "PA THERM AVG: %u\r\nPA FWD AVG: %u\r\nPA REV AVG: %u\r\n\r\n",
@@ -414,9 +603,12 @@ void cmd_rftest(BaseSequentialStream *chp, int argc, char *argv[])
         uint32_t cnt = strtoul(argv[2], NULL, 0);
         if (cnt == 0)  cnt = 1;
         ax5043WriteU16(tx_eng->devp, AX5043_REG_TXPWRCOEFFB, txpwr);
+        bool stopped_sensors = sensors_stop();
         adcStartConversion(&ADCD1, &pa_pwr_cfg, (adcsample_t*)pa_samples, PA_SAMPLES * 2);
         ax5043TXRaw(tx_eng->devp, NULL, &cw, sizeof(cw), sizeof(cw) * cnt, tx_cb, NULL, false);
         adcStopConversion(&ADCD1);
+        if (stopped_sensors)
+            sensors_start();
     } else {
         ax5043WriteU8(tx_eng->devp, AX5043_REG_PWRAMP, 0);
         palClearLine(LINE_PA_ENABLE);
@@ -437,10 +629,198 @@ rftest_usage:
     return;
 }
 
+/*===========================================================================*/
+/* OreSat Morse Beacon                                                       */
+/*===========================================================================*/
+#define MORSE_REF_MAX               (MORSE_MAX_RUNS * 2)
+
+typedef struct {
+    bool key;
+    uint32_t ms;
+} morse_ref_t;
+
+static morse_ref_t morse_ref[MORSE_REF_MAX];
+static size_t morse_ref_len;
+static morse_sched_t morse_test;
+
+static void morse_ref_add(bool key, uint32_t ms)
+{
+    if (morse_ref_len > 0 && morse_ref[morse_ref_len - 1].key == key) {
+        morse_ref[morse_ref_len - 1].ms += ms;
+    } else if (morse_ref_len < MORSE_REF_MAX) {
+        morse_ref[morse_ref_len++] = (morse_ref_t){key, ms};
+    }
+}
+
+/* Keying timeline of the original per-element encoder, key and sleep calls recorded */
+static void morse_reference(int wpm, const char *msg, size_t len)
+{
+    uint16_t ditLength = 1200/wpm;
+    morse_ref_len = 0;
+
+    for (size_t index = 0; index < len; index++) {
+        const char *morse = ax5043_ascii_to_morse(msg[index]);
+        for (int element = 0; morse[element] != '\0'; element++) {
+            switch (morse[element]) {
+            case '-':
+                morse_ref_add(true, ditLength * 3);
+                break;
+            case '.':
+                morse_ref_add(true, ditLength);
+                break;
+            }
+            if (morse[element] == ' ') {
+                morse_ref_add(false, ditLength * 7);
+            } else if (morse[element + 1] != '\0') {
+                morse_ref_add(false, ditLength);
+            } else {
+                morse_ref_add(false, ditLength * 3);
+            }
+        }
+    }
+}
+
+static bool morse_matches(const morse_sched_t *sched)
+{
+    size_t r = 0;
+
+    for (size_t i = 0; i < morse_ref_len; i++) {
+        bool key = morse_ref[i].key;
+        uint32_t ms = 0;
+        /* Runs longer than MORSE_RUN_LEN dits are split */
+        while (r < sched->count && ((sched->runs[r] & MORSE_RUN_KEY) != 0) == key) {
+            ms += (sched->runs[r++] & MORSE_RUN_LEN) * sched->dit_ms;
+        }
+        if (ms != morse_ref[i].ms) {
+            return false;
+        }
+    }
+    return r == sched->count;
+}
+
+static void morse_join(int argc, char *argv[], char *msg, size_t *len)
+{
+    *len = 0;
+    for (int i = 0; i < argc; i++) {
+        size_t n = strlen(argv[i]);
+        if (i > 0 && *len < MORSE_MAX_MSG) {
+            msg[(*len)++] = ' ';
+        }
+        if (n > MORSE_MAX_MSG - *len) {
+            n = MORSE_MAX_MSG - *len;
+        }
+        memcpy(&msg[*len], argv[i], n);
+        *len += n;
+    }
+}
+
+void cmd_morse(BaseSequentialStream *chp, int argc, char *argv[])
+{
+    char msg[MORSE_MAX_MSG];
+    size_t len;
+
+    if (argc < 3) {
+        goto morse_usage;
+    }
+
+    int wpm = strtol(argv[1], NULL, 0);
+    if (wpm <= 0 || wpm > 60) {
+        goto morse_usage;
+    }
+    morse_join(argc - 2, &argv[2], msg, &len);
+
+    if (!strcmp(argv[0], "check")) {
+        morse_test.count = 0;
+        morse_compile(&morse_test, wpm, msg, len, XTAL_CLK);
+        morse_reference(wpm, msg, len);
+        chprintf(chp, "%s: %u runs, reference %u key changes, TXRATE 0x%06X\r\n",
+                (morse_matches(&morse_test) ? "OK" : "MISMATCH"),
+                morse_test.count, morse_ref_len, morse_test.profile[1].val);
+    } else if (!strcmp(argv[0], "bench")) {
+        const unsigned iters = 1000;
+        size_t bytes = 0, fills = 0;
+        systime_t start;
+
+        start = chVTGetSystemTime();
+        for (unsigned i = 0; i < iters; i++) {
+            morse_test.count = 0;
+            morse_compile(&morse_test, wpm, msg, len, XTAL_CLK);
+        }
+        chprintf(chp, "Build:     %u us per message\r\n",
+                TIME_I2US(chVTTimeElapsedSinceX(start)) / iters);
+
+        start = chVTGetSystemTime();
+        for (unsigned i = 0; i < iters; i++) {
+            morse_compile(&morse_test, wpm, msg, len, XTAL_CLK);
+        }
+        chprintf(chp, "Unchanged: %u us per call\r\n",
+                TIME_I2US(chVTTimeElapsedSinceX(start)) / iters);
+
+        start = chVTGetSystemTime();
+        for (unsigned i = 0; i < iters; i++) {
+            size_t n;
+            morse_test.pos = 0;
+            while ((n = morse_fill(&morse_test)) != 0) {
+                bytes += n;
+                fills++;
+            }
+        }
+        chprintf(chp, "Stream:    %u us per message, %u FIFO bytes in %u blocks\r\n",
+                TIME_I2US(chVTTimeElapsedSinceX(start)) / iters, bytes / iters, fills / iters);
+
+        /* Per element the old encoder did 6 SPI writes plus two power mode changes */
+        morse_reference(wpm, msg, len);
+        chprintf(chp, "Old SPI:   %u transactions, new %u\r\n",
+                (morse_ref_len / 2) * 8, fills / iters * 2);
+    } else if (!strcmp(argv[0], "send")) {
+        ax5043_send_cw(tx_eng->devp, wpm, msg, len);
+    } else {
+        goto morse_usage;
+    }
+    return;
+
+morse_usage:
+    chprintf(chp, "\r\n"
+                  "Usage: morse <cmd> <wpm> <message>\r\n"
+                  "    check:       Compare the keying schedule with the per-element encoder\r\n"
+                  "    bench:       Report schedule build and FIFO stream cost\r\n"
+                  "    send:        Transmit <message> as CW\r\n"
+                  "\r\n");
+    return;
+}
+
 void cmd_beacon(BaseSequentialStream *chp, int argc, char *argv[])
 {
     int count = 1;
-    if (argc > 0) {
+    if (argc > 0 && !strcmp(argv[0], "check")) {
+        static uint8_t ref[TLM_MAX_LEN], out[TLM_MAX_LEN];
+        size_t ref_len = tlm_serialize_ref(&aprs0, ref);
+        size_t out_len = tlm_serialize(&aprs0, out);
+        if (ref_len == 0 || ref_len != out_len || memcmp(ref, out, ref_len)) {
+            chprintf(chp, "MISMATCH: ref %u bytes, compiled %u bytes\r\n", ref_len, out_len);
+        } else {
+            chprintf(chp, "OK: %u bytes identical\r\n", out_len);
+        }
+        return;
+    } else if (argc > 0 && !strcmp(argv[0], "bench")) {
+        static uint8_t buf[TLM_MAX_LEN];
+        const int iterations = 1000;
+        rtcnt_t start, ref_cycles, out_cycles;
+
+        start = chSysGetRealtimeCounterX();
+        for (int i = 0; i < iterations; i++) {
+            tlm_serialize_ref(&aprs0, buf);
+        }
+        ref_cycles = chSysGetRealtimeCounterX() - start;
+        start = chSysGetRealtimeCounterX();
+        for (int i = 0; i < iterations; i++) {
+            tlm_serialize(&aprs0, buf);
+        }
+        out_cycles = chSysGetRealtimeCounterX() - start;
+        chprintf(chp, "Reference: %u cycles/beacon\r\n", ref_cycles / iterations);
+        chprintf(chp, "Compiled:  %u cycles/beacon\r\n", out_cycles / iterations);
+        return;
+    } else if (argc > 0) {
         count = strtoul(argv[0], NULL, 0);
         if (count < 1 || count > 10)
             goto beacon_usage;
@@ -456,6 +836,10 @@ void cmd_beacon(BaseSequentialStream *chp, int argc, char *argv[])
 beacon_usage:
     chprintf(chp, "\r\n"
                   "Usage: beacon [count]\r\n"
+                  "       beacon check\r\n"
+                  "           Compare compiled beacon serializer against reference\r\n"
+                  "       beacon bench\r\n"
+                  "           Report serializer cycles per beacon\r\n"
                   "\r\n");
     return;
 }
@@ -0,0 +1,150 @@
+#include <string.h>
+#include "tlm.h"
+#include "CANopen.h"
+#include "crc.h"
+
+static MUTEX_DECL(tlm_compile_lock);
+
+/* Flatten the item table: constants go into the template once, pointer
+ * items become copy spans, merged when their sources are contiguous. */
+static int tlm_compile(const tlm_pkt_t *pkt)
+{
+    tlm_prog_t *prog = pkt->prog;
+    tlm_span_t *span = NULL;
+    size_t len, total = 0;
+    int ret = 0;
+
+    chMtxLock(&tlm_compile_lock);
+    if (prog->ready) {
+        goto out;
+    }
+
+    prog->span_cnt = 0;
+    for (unsigned int i = 0; i < pkt->item_cnt; i++) {
+        const tlm_item_t *item = &pkt->item[i];
+        len = (item->type == TLM_MSG ? strlen(item->msg) : item->len);
+        if (total + len + sizeof(uint32_t) > TLM_MAX_LEN) {
+            ret = -1;
+            goto out;
+        }
+        switch (item->type) {
+        case TLM_MSG:
+            memcpy(&prog->tmpl[total], item->msg, len);
+            span = NULL;
+            break;
+        case TLM_PTR:
+            if (span != NULL && span->src + span->len == item->ptr) {
+                span->len += len;
+            } else {
+                span = &prog->span[prog->span_cnt++];
+                span->src = item->ptr;
+                span->offset = total;
+                span->len = len;
+            }
+            break;
+        case TLM_VAL:
+            memcpy(&prog->tmpl[total], &item->val, len);
+            span = NULL;
+            break;
+        default:
+            ret = -1;
+            goto out;
+        }
+        total += len;
+    }
+    prog->len = total;
+    prog->ready = true;
+
+out:
+    chMtxUnlock(&tlm_compile_lock);
+    return ret;
+}
+
+/* Copy attempts before falling back to holding od_mutex for the copy */
+#define TLM_SNAPSHOT_RETRIES        4
+
+static void tlm_copy(const tlm_prog_t *prog, uint8_t *buf)
+{
+    memcpy(buf, prog->tmpl, prog->len);
+    for (size_t i = 0; i < prog->span_cnt; i++) {
+        const tlm_span_t *span = &prog->span[i];
+        memcpy(&buf[span->offset], span->src, span->len);
+    }
+}
+
+/**
+ * @brief   Serialize a telemetry packet, CRC32 appended.
+ * @note    The live fields are copied under the OD sequence lock so that a
+ *          beacon never mixes values from before and after an OD write.
+ *
+ * @return  Bytes written to buf, or 0 if the item table is invalid.
+ */
+size_t tlm_serialize(const tlm_pkt_t *pkt, uint8_t *buf)
+{
+    const tlm_prog_t *prog = pkt->prog;
+    uint32_t crc, seq;
+
+    if (!prog->ready && tlm_compile(pkt) != 0) {
+        return 0;
+    }
+
+    for (int i = 0; ; i++) {
+        seq = od_seq;
+        if ((seq & 1U) == 0) {
+            __DMB();
+            tlm_copy(prog, buf);
+            __DMB();
+            if (od_seq == seq) {
+                break;
+            }
+        }
+        if (i >= TLM_SNAPSHOT_RETRIES) {
+            /* Writers keep racing us, wait them out */
+            chMtxLock(&od_mutex);
+            tlm_copy(prog, buf);
+            chMtxUnlock(&od_mutex);
+            break;
+        }
+        chThdYield();
+    }
+
+    crc = crc32(buf, prog->len, 0);
+    memcpy(&buf[prog->len], &crc, sizeof(crc));
+
+    return prog->len + sizeof(crc);
+}
+
+/**
+ * @brief   Reference serializer, walks the item table directly.
+ * @note    Kept to cross check tlm_serialize() output.
+ */
+size_t tlm_serialize_ref(const tlm_pkt_t *pkt, uint8_t *buf)
+{
+    size_t len, total = 0;
+    uint32_t crc;
+
+    for (unsigned int i = 0; i < pkt->item_cnt; i++) {
+        const tlm_item_t *item = &pkt->item[i];
+        switch (item->type) {
+        case TLM_MSG:
+            len = strlen(item->msg);
+            memcpy(&buf[total], item->msg, len);
+            break;
+        case TLM_PTR:
+            len = item->len;
+            memcpy(&buf[total], item->ptr, len);
+            break;
+        case TLM_VAL:
+            len = item->len;
+            memcpy(&buf[total], &item->val, len);
+            break;
+        default:
+            return 0;
+        }
+        total += len;
+    }
+    crc = crc32(buf, total, 0);
+    memcpy(&buf[total], &crc, sizeof(crc));
+
+    return total + sizeof(crc);
+}
@@ -0,0 +1,58 @@
+#ifndef _TLM_H_
+#define _TLM_H_
+
+#include "ch.h"
+#include "hal.h"
+
+typedef enum {
+    TLM_MSG,
+    TLM_PTR,
+    TLM_VAL,
+} tlm_type_t;
+
+typedef struct tlm_item {
+    tlm_type_t          type;
+    size_t              len;
+    union {
+        char            *msg;
+        void            *ptr;
+        uint32_t        val;
+    };
+} tlm_item_t;
+
+/* Largest payload, the AX.25 information field */
+#define TLM_MAX_LEN                 256U
+
+/* Run of live bytes copied into the template at serialization time */
+typedef struct tlm_span {
+    const uint8_t       *src;
+    uint16_t            offset;
+    uint16_t            len;
+} tlm_span_t;
+
+/* Item table flattened into a template and a list of merged copy spans */
+typedef struct tlm_prog {
+    bool                ready;
+    size_t              len;            /* Payload length, excluding CRC */
+    size_t              span_cnt;
+    tlm_span_t          *span;          /* Room for at least item_cnt spans */
+    uint8_t             tmpl[TLM_MAX_LEN];
+} tlm_prog_t;
+
+typedef struct tlm_pkt {
+    size_t              item_cnt;
+    const tlm_item_t    *item;
+    tlm_prog_t          *prog;
+} tlm_pkt_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+size_t tlm_serialize(const tlm_pkt_t *pkt, uint8_t *buf);
+size_t tlm_serialize_ref(const tlm_pkt_t *pkt, uint8_t *buf);
+
+#ifdef __cplusplus
+}
+#endif /*__cplusplus*/
+#endif
@@ -0,0 +1,435 @@
+/*
+    ChibiOS - Copyright (C) 2006..2018 Giovanni Di Sirio
+
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+/*
+ * Runs the AX5043 driver against the register level model on the POSIX
+ * simulator and reports the SPI traffic and time each operation costs.
+ * A second radio on the same bus compares one transmit queue shared by both
+ * radios against a queue and worker per radio.
+ */
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+/* ChibiOS header files */
+#include "ch.h"
+#include "hal.h"
+
+/* Project header files */
+#include "ax5043.h"
+#include "radio.h"
+
+#define SIM_FB_COUNT                        8U
+#define SIM_TX_REPEAT                       4U
+#define SIM_RX_FRAMES                       32U
+#define SIM_RX_LEN                          200U
+#define SIM_QUEUE_FRAMES                    8U
+
+/* Frame buffer pool the RX worker fills, radio.c is not linked here */
+objects_fifo_t rx_fifo;
+static msg_t rx_fifo_msgs[SIM_FB_COUNT];
+static fb_t rx_fifo_buf[SIM_FB_COUNT];
+
+static const ax5043_model_config_t model_cfg = {
+    .xtal_freq      = AX5043_SIM_XTAL,
+    .xtal_us        = 1000,
+    .range_us       = 1000,
+    .lock_us        = 50,
+    .rx_gap_bits    = 64,
+};
+
+/* f_pclk/8, 10.5 MHz like the C3 */
+static const SPIConfig spicfg = {
+    false,
+    NULL,
+    LINE_AX5043_CS,
+    SPI_CR1_BR_1,
+    0
+};
+
+static const SPIConfig spicfg_b = {
+    false,
+    NULL,
+    LINE_AX5043B_CS,
+    SPI_CR1_BR_1,
+    0
+};
+
+/* Only the registers the model acts on, plus the packet store setup */
+static const ax5043_profile_t sim_96k[] = {
+    {AX5043_REG_FREQA, 0x1B480001, 4},
+    {AX5043_REG_TXRATE, 0x018937, 3},
+    {AX5043_REG_PKTCHUNKSIZE, AX5043_PKTCHUNKSIZE_240, 1},
+    {AX5043_REG_PKTSTOREFLAGS, AX5043_PKTSTOREFLAGS_RSSI, 1},
+    {0, 0, 0}
+};
+
+static const ax5043_profile_t sim_9k6[] = {
+    {AX5043_REG_FREQA, 0x1B480001, 4},
+    {AX5043_REG_TXRATE, 0x002752, 3},
+    {AX5043_REG_PKTCHUNKSIZE, AX5043_PKTCHUNKSIZE_240, 1},
+    {AX5043_REG_PKTSTOREFLAGS, AX5043_PKTSTOREFLAGS_RSSI, 1},
+    {0, 0, 0}
+};
+
+static const uint8_t preamble[] = {
+    AX5043_CHUNKCMD_TXCTRL | _VAL2FLD(AX5043_FIFOCHUNK_SIZE, 1),
+    AX5043_CHUNK_TXCTRL_SETPA | AX5043_CHUNK_TXCTRL_PASTATE,
+    AX5043_CHUNKCMD_REPEATDATA | _VAL2FLD(AX5043_FIFOCHUNK_SIZE, 3),
+    AX5043_CHUNK_REPEATDATA_RAW | AX5043_CHUNK_REPEATDATA_NOCRC,
+    50,
+    0x7E
+};
+
+static const uint8_t postamble[] = {
+    AX5043_CHUNKCMD_REPEATDATA | _VAL2FLD(AX5043_FIFOCHUNK_SIZE, 3),
+    AX5043_CHUNK_REPEATDATA_RAW | AX5043_CHUNK_REPEATDATA_NOCRC,
+    5,
+    0x7E,
+    AX5043_CHUNKCMD_TXCTRL | _VAL2FLD(AX5043_FIFOCHUNK_SIZE, 1),
+    AX5043_CHUNK_TXCTRL_SETPA
+};
+
+static const AX5043Config axcfg = {
+    .spip           = &SPID1,
+    .spicfg         = &spicfg,
+    .miso           = LINE_AX5043_MISO,
+    .irq            = LINE_AX5043_IRQ,
+    .xtal_freq      = AX5043_SIM_XTAL,
+    .fifo           = &rx_fifo,
+    .phy_arg        = NULL,
+    .rx_err_cb      = NULL,
+    .profile        = sim_96k,
+    .preamble       = preamble,
+    .preamble_len   = sizeof(preamble),
+    .postamble      = postamble,
+    .postamble_len  = sizeof(postamble),
+};
+
+static const AX5043Config axcfg_b = {
+    .spip           = &SPID1,
+    .spicfg         = &spicfg_b,
+    .miso           = LINE_AX5043_MISO,
+    .irq            = LINE_AX5043B_IRQ,
+    .xtal_freq      = AX5043_SIM_XTAL,
+    .fifo           = &rx_fifo,
+    .phy_arg        = NULL,
+    .rx_err_cb      = NULL,
+    .profile        = sim_96k,
+};
+
+static AX5043Driver axd;
+static AX5043Driver axd_b;
+static uint8_t tx_buf[1024];
+
+/* Frames for one radio, produced by their own thread like beacons and EDL responses */
+typedef struct {
+    const char              *name;
+    AX5043Driver            *devp;
+    const ax5043_profile_t  *profile;
+    size_t                  len;
+    objects_fifo_t          *fifo;
+    uint32_t                frames;     /* Transmitted */
+    uint64_t                done_us;    /* Simulation time the last one finished */
+} sim_stream_t;
+
+/* Transmit pools, either one shared by both radios or one per radio */
+static objects_fifo_t txq[2];
+static msg_t txq_msgs[2][SIM_FB_COUNT];
+static fb_t txq_buf[2][SIM_FB_COUNT];
+
+typedef struct {
+    uint32_t        xfers;
+    uint32_t        bytes;
+    uint64_t        sim_us;
+    uint64_t        wall_ns;
+    uint64_t        air_us;
+} bench_t;
+
+/* Frame buffer and PDU glue for the RX worker */
+fb_t *__fb_alloc(size_t len, void *arg)
+{
+    (void)len;
+    objects_fifo_t *fifo = arg;
+    fb_t *fb = chFifoTakeObjectTimeout(fifo, TIME_INFINITE);
+    memset(fb, 0, sizeof(fb_t));
+    return fb;
+}
+
+void __fb_free(fb_t *fb, void *arg)
+{
+    chFifoReturnObject((objects_fifo_t*)arg, fb);
+}
+
+void pdu_send(fb_t *fb, void *arg)
+{
+    chFifoSendObject((objects_fifo_t*)arg, fb);
+}
+
+static uint64_t wall_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000U + ts.tv_nsec;
+}
+
+static void bench_snap(bench_t *b)
+{
+    chSysLock();
+    b->xfers = SPID1.xfers;
+    b->bytes = SPID1.bytes;
+    b->sim_us = simTimeUS();
+    b->air_us = sim_ax5043.stats.air_us + sim_ax5043b.stats.air_us;
+    chSysUnlock();
+    b->wall_ns = wall_ns();
+}
+
+static void bench_report(const char *name, const bench_t *start, unsigned count)
+{
+    bench_t end;
+
+    bench_snap(&end);
+    printf("%-24s %8.1f xfers %9.1f bytes %9.2f ms sim %9.2f ms air %9.2f ms wall\n", name,
+           (double)(end.xfers - start->xfers) / count,
+           (double)(end.bytes - start->bytes) / count,
+           (double)(end.sim_us - start->sim_us) / count / 1000.0,
+           (double)(end.air_us - start->air_us) / count / 1000.0,
+           (double)(end.wall_ns - start->wall_ns) / count / 1000000.0);
+}
+
+static void bench_profile(void)
+{
+    bench_t b;
+
+    bench_snap(&b);
+    ax5043SetProfile(&axd, sim_9k6);
+    bench_report("set_profile cold", &b, 1);
+
+    bench_snap(&b);
+    for (unsigned i = 0; i < SIM_TX_REPEAT; i++) {
+        ax5043SetProfile(&axd, (i & 1U) ? sim_9k6 : sim_96k);
+    }
+    bench_report("set_profile warm", &b, SIM_TX_REPEAT);
+    printf("  vco cache %lu hits %lu misses, %lu rangings\n", (unsigned long)axd.vco_hits,
+           (unsigned long)axd.vco_misses, (unsigned long)sim_ax5043.stats.rangings);
+}
+
+static void bench_tx(const char *rate, const ax5043_profile_t *profile)
+{
+    static const size_t lens[] = {64, 256, 1024};
+    char name[32];
+    bench_t b;
+
+    for (size_t i = 0; i < sizeof(lens) / sizeof(lens[0]); i++) {
+        uint32_t underruns = sim_ax5043.stats.tx_underruns;
+
+        snprintf(name, sizeof(name), "tx %s %4u B", rate, (unsigned)lens[i]);
+        bench_snap(&b);
+        for (unsigned n = 0; n < SIM_TX_REPEAT; n++) {
+            ax5043TX(&axd, profile, tx_buf, lens[i], lens[i], NULL, NULL, false);
+        }
+        bench_report(name, &b, SIM_TX_REPEAT);
+        if (axd.error != AX5043_ERR_NOERROR || sim_ax5043.stats.tx_underruns != underruns) {
+            printf("  error %d, %lu underruns\n", axd.error,
+                   (unsigned long)(sim_ax5043.stats.tx_underruns - underruns));
+        }
+    }
+}
+
+static void bench_relock(void)
+{
+    uint32_t relocks = axd.vco_relocks;
+    bench_t b;
+
+    /* A temperature swing moves the range the cached entry points at */
+    chSysLock();
+    ax5043ModelShiftVCO(&sim_ax5043, 3);
+    chSysUnlock();
+
+    bench_snap(&b);
+    ax5043TX(&axd, NULL, tx_buf, 64, 64, NULL, NULL, false);
+    bench_report("tx after vco shift", &b, 1);
+    printf("  %lu relocks, error %d\n", (unsigned long)(axd.vco_relocks - relocks), axd.error);
+}
+
+static void bench_rx(void)
+{
+    uint32_t frames = 0, fifo_reads = axd.rx_stats.fifo_reads;
+    uint8_t frame[SIM_RX_LEN];
+    bench_t b;
+    fb_t *fb;
+
+    for (size_t i = 0; i < sizeof(frame); i++) {
+        frame[i] = i;
+    }
+
+    ax5043SetProfile(&axd, sim_96k);
+    ax5043RX(&axd, false, false);
+    bench_snap(&b);
+    for (unsigned i = 0; i < SIM_RX_FRAMES; i++) {
+        /* Keep a few frames queued on the air */
+        while (true) {
+            bool queued;
+            chSysLock();
+            queued = ax5043ModelRX(&sim_ax5043, frame, sizeof(frame), 0, -80, 0);
+            chSysUnlock();
+            if (queued) {
+                break;
+            }
+            while (chFifoReceiveObjectTimeout(&rx_fifo, (void**)&fb, TIME_MS2I(1)) == MSG_OK) {
+                frames++;
+                fb_free(fb, &rx_fifo);
+            }
+        }
+    }
+    while (chFifoReceiveObjectTimeout(&rx_fifo, (void**)&fb, TIME_MS2I(100)) == MSG_OK) {
+        frames++;
+        fb_free(fb, &rx_fifo);
+    }
+    bench_report("rx 96k  200 B", &b, (frames ? frames : 1));
+    printf("  %lu/%u frames, %lu fifo reads, %lu chip overflows\n", (unsigned long)frames, SIM_RX_FRAMES,
+           (unsigned long)(axd.rx_stats.fifo_reads - fifo_reads),
+           (unsigned long)sim_ax5043.stats.rx_overflows);
+    ax5043Idle(&axd);
+}
+
+static THD_FUNCTION(stream_producer, arg)
+{
+    sim_stream_t *s = arg;
+
+    for (unsigned i = 0; i < SIM_QUEUE_FRAMES; i++) {
+        fb_t *fb = fb_alloc(s->len, s->fifo);
+        fb->phy_arg = s;
+        memcpy(fb_put(fb, s->len), tx_buf, s->len);
+        pdu_send(fb, s->fifo);
+    }
+    chThdExit(MSG_OK);
+}
+
+/* Sends each frame on the radio of its stream, like the TX worker in comms.c */
+static THD_FUNCTION(tx_worker, arg)
+{
+    objects_fifo_t *fifo = arg;
+    sim_stream_t *s;
+    fb_t *fb;
+
+    while (!chThdShouldTerminateX()) {
+        if (chFifoReceiveObjectTimeout(fifo, (void**)&fb, TIME_MS2I(1)) != MSG_OK) {
+            continue;
+        }
+        s = fb->phy_arg;
+        ax5043TX(s->devp, s->profile, fb->data, fb->len, fb->len, NULL, NULL, false);
+        chSysLock();
+        s->frames++;
+        s->done_us = simTimeUS();
+        chSysUnlock();
+        fb_free(fb, fifo);
+    }
+    chThdExit(MSG_OK);
+}
+
+/* UHF beacons and L-band EDL downlinks, through one queue or a queue per radio */
+static void bench_queues(const char *name, unsigned queues)
+{
+    sim_stream_t streams[] = {
+        {"uhf beacon", &axd, sim_9k6, 256, &txq[0], 0, 0},
+        {"lband edl", &axd_b, sim_96k, 1024, &txq[queues - 1], 0, 0},
+    };
+    const unsigned count = sizeof(streams) / sizeof(streams[0]);
+    thread_t *workers[2], *producers[2];
+    uint64_t end_us = 0, bits = 0;
+    bench_t b;
+
+    for (unsigned i = 0; i < queues; i++) {
+        chFifoObjectInit(&txq[i], sizeof(fb_t), SIM_FB_COUNT, txq_buf[i], txq_msgs[i]);
+        workers[i] = chThdCreateFromHeap(NULL, THD_WORKING_AREA_SIZE(0x800), "tx", NORMALPRIO, tx_worker, &txq[i]);
+    }
+
+    bench_snap(&b);
+    for (unsigned i = 0; i < count; i++) {
+        producers[i] = chThdCreateFromHeap(NULL, THD_WORKING_AREA_SIZE(0x800), streams[i].name, NORMALPRIO,
+                                           stream_producer, &streams[i]);
+    }
+    for (unsigned i = 0; i < count; i++) {
+        chThdWait(producers[i]);
+    }
+    /* Producers finish once their last frame is queued, the air takes longer */
+    while (streams[0].frames + streams[1].frames < count * SIM_QUEUE_FRAMES) {
+        chThdSleepMilliseconds(1);
+    }
+    bench_report(name, &b, 1);
+
+    for (unsigned i = 0; i < count; i++) {
+        const sim_stream_t *s = &streams[i];
+        printf("  %-10s %2lu x %4u B, last done at %8.2f ms\n", s->name, (unsigned long)s->frames,
+               (unsigned)s->len, (double)(s->done_us - b.sim_us) / 1000.0);
+        bits += (uint64_t)s->frames * s->len * 8U;
+        if (s->done_us > end_us) {
+            end_us = s->done_us;
+        }
+    }
+    printf("  %.1f kbit/s combined\n", (double)bits * 1000.0 / (double)(end_us - b.sim_us));
+
+    for (unsigned i = 0; i < queues; i++) {
+        chThdTerminate(workers[i]);
+        chThdWait(workers[i]);
+    }
+}
+
+int main(void)
+{
+    bench_t b;
+
+    halInit();
+    chSysInit();
+
+    chFifoObjectInit(&rx_fifo, sizeof(fb_t), SIM_FB_COUNT, rx_fifo_buf, rx_fifo_msgs);
+    for (size_t i = 0; i < sizeof(tx_buf); i++) {
+        tx_buf[i] = i * 7U;
+    }
+
+    simAX5043Start(&model_cfg);
+    ax5043ObjectInit(&axd);
+    ax5043ObjectInit(&axd_b);
+
+    bench_snap(&b);
+    ax5043Start(&axd, &axcfg);
+    bench_report("start", &b, 1);
+    if (axd.error != AX5043_ERR_NOERROR) {
+        printf("ax5043Start failed: %d\n", axd.error);
+        return 1;
+    }
+
+    bench_profile();
+    bench_tx("9k6", sim_9k6);
+    bench_tx("96k", sim_96k);
+    bench_relock();
+    bench_rx();
+
+    ax5043Start(&axd_b, &axcfg_b);
+    if (axd_b.error != AX5043_ERR_NOERROR) {
+        printf("ax5043Start failed on the second radio: %d\n", axd_b.error);
+        return 1;
+    }
+    bench_queues("tx 1 queue  2 radios", 1);
+    bench_queues("tx 2 queues 2 radios", 2);
+
+    printf("model: %lu packets %lu bytes sent, %lu frames received, %lu fifo overflows\n",
+           (unsigned long)sim_ax5043.stats.tx_packets, (unsigned long)sim_ax5043.stats.tx_bytes,
+           (unsigned long)sim_ax5043.stats.rx_frames, (unsigned long)sim_ax5043.stats.fifo_overflows);
+    return 0;
+}
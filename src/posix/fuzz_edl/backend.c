@@ -0,0 +1,265 @@
+/*
+ * Stub back ends for the EDL parsers: object dictionary, file system, flash,
+ * OPD, node manager, CANopen SDO client and the C3 state machine. They keep
+ * just enough state to answer like the real ones and are reset before every
+ * input, so each input runs from the same starting point.
+ */
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+#include "ch.h"
+#include "hal.h"
+#include "c3.h"
+#include "crc.h"
+#include "fw.h"
+#include "fs.h"
+#include "opd.h"
+#include "rtc.h"
+#include "node_mgr.h"
+#include "CO_master.h"
+#include "OD.h"
+#include "fuzz.h"
+
+#define BACKEND_FILES                       4
+
+OD_RAM_t OD_RAM;
+OD_PERSIST_APP_t OD_PERSIST_APP;
+OD_PERSIST_STATE_t OD_PERSIST_STATE;
+OD_PERSIST_KEYS_t OD_PERSIST_KEYS;
+
+FSDriver FSD1;
+
+static lfs_file_t files[BACKEND_FILES];
+static bool file_used[BACKEND_FILES];
+static bool tx_state;
+static time_t rtc_time;
+static uint32_t sink;
+
+void backend_reset(void)
+{
+    memset(&OD_RAM, 0, sizeof(OD_RAM));
+    memset(&OD_PERSIST_STATE, 0, sizeof(OD_PERSIST_STATE));
+    OD_PERSIST_APP.x6006_CCSDS.spacecraftID = 0x4F53U;
+    memset(files, 0, sizeof(files));
+    memset(file_used, 0, sizeof(file_used));
+    FSD1.err = 0;
+    EFLD1.bank = 0;
+    tx_state = false;
+    rtc_time = 0;
+}
+
+/* C3 */
+void soft_reset(void) {}
+void hard_reset(void) {}
+void factory_reset(void) {}
+void tx_enable(bool state) { tx_state = state; }
+void edl_enable(bool state) { (void)state; }
+bool tx_enabled(void) { return tx_state; }
+
+/* Flash */
+int fw_flash(EFlashDriver *eflp, char *filename, uint32_t crc)
+{
+    (void)eflp;
+    (void)crc;
+    return (strlen(filename) != 0 ? 0 : -1);
+}
+
+uint32_t fw_verify(EFlashDriver *eflp, fw_bank_t bank)
+{
+    (void)eflp;
+    return (bank <= BANK_1 ? 0 : 1);
+}
+
+int fw_set_bank(EFlashDriver *eflp, fw_bank_t bank)
+{
+    if (bank > BANK_1)
+        return -1;
+    eflp->bank = bank;
+    return 0;
+}
+
+/* OPD, addresses outside the 7-bit range fail like a NAK */
+void opd_start(void) {}
+void opd_stop(void) {}
+void opd_scan(bool restart) { (void)restart; }
+int opd_enable(i2caddr_t addr, bool enable) { (void)enable; return (addr < 0x80 ? 0 : -1); }
+int opd_reset(i2caddr_t addr) { return (addr < 0x80 ? 0 : -1); }
+
+int opd_status(i2caddr_t addr, opd_status_t *status)
+{
+    memset(status, 0, sizeof(*status));
+    return (addr < 0x80 ? 0 : -1);
+}
+
+/* CANopen */
+int node_enable(uint8_t id, bool enable) { (void)enable; return (id < 0x80 ? 0 : -1); }
+
+int node_status(uint8_t id, CO_NMT_internalState_t *state)
+{
+    *state = (id < 0x80 ? CO_NMT_OPERATIONAL : CO_NMT_UNKNOWN);
+    return 0;
+}
+
+void sdo_transfer(sdocli_op_t op, uint8_t node_id, uint16_t index, uint8_t subindex, size_t total_size, size_t buf_size, void *buf)
+{
+    (void)op;
+    (void)node_id;
+    (void)index;
+    (void)subindex;
+    (void)total_size;
+    /* Read all of it, as the segmented transfer would */
+    sink = crc32(buf, buf_size, sink);
+}
+
+/* RTC */
+time_t rtcGetTimeUnix(uint32_t *msec)
+{
+    if (msec != NULL)
+        *msec = 0;
+    return rtc_time;
+}
+
+void rtcSetTimeUnix(time_t unix_time, uint32_t msec)
+{
+    (void)msec;
+    rtc_time = unix_time;
+}
+
+/* File system */
+int fs_format(FSDriver *fsp)
+{
+    memset(file_used, 0, sizeof(file_used));
+    return fsp->err = 0;
+}
+
+int fs_unmount(FSDriver *fsp)
+{
+    return fsp->err = 0;
+}
+
+int fs_remove(FSDriver *fsp, const char *path)
+{
+    for (int i = 0; i < BACKEND_FILES; i++) {
+        if (file_used[i] && !strcmp(files[i].name, path)) {
+            file_used[i] = false;
+            return fsp->err = 0;
+        }
+    }
+    return fsp->err = LFS_ERR_NOENT;
+}
+
+lfs_file_t *file_open(FSDriver *fsp, const char *path, int flags)
+{
+    int free_slot = -1;
+    size_t len = strlen(path);
+
+    if (len == 0 || len > LFS_NAME_MAX) {
+        fsp->err = LFS_ERR_INVAL;
+        return NULL;
+    }
+    for (int i = 0; i < BACKEND_FILES; i++) {
+        if (file_used[i] && !strcmp(files[i].name, path)) {
+            files[i].pos = 0;
+            files[i].flags = flags;
+            return &files[i];
+        }
+        if (!file_used[i] && free_slot < 0)
+            free_slot = i;
+    }
+    if (!(flags & LFS_O_CREAT)) {
+        fsp->err = LFS_ERR_NOENT;
+        return NULL;
+    }
+    if (free_slot < 0) {
+        fsp->err = LFS_ERR_NOSPC;
+        return NULL;
+    }
+    file_used[free_slot] = true;
+    memset(&files[free_slot], 0, sizeof(lfs_file_t));
+    memcpy(files[free_slot].name, path, len + 1);
+    files[free_slot].flags = flags;
+    return &files[free_slot];
+}
+
+int file_close(FSDriver *fsp, lfs_file_t *file)
+{
+    (void)file;
+    return fsp->err = 0;
+}
+
+lfs_ssize_t file_read(FSDriver *fsp, lfs_file_t *file, void *buffer, lfs_size_t size)
+{
+    lfs_size_t n = (file->pos < file->size ? file->size - file->pos : 0);
+
+    if (n > size)
+        n = size;
+    memset(buffer, 0, n);
+    file->pos += n;
+    fsp->err = 0;
+    return n;
+}
+
+lfs_ssize_t file_write(FSDriver *fsp, lfs_file_t *file, const void *buffer, lfs_size_t size)
+{
+    if ((file->flags & LFS_O_WRONLY) == 0)
+        return fsp->err = LFS_ERR_BADF;
+    if (size > LFS_FILE_MAX - file->pos)
+        return fsp->err = LFS_ERR_FBIG;
+    file->sum = crc32(buffer, size, file->sum);
+    file->pos += size;
+    if (file->pos > file->size)
+        file->size = file->pos;
+    fsp->err = 0;
+    return size;
+}
+
+lfs_soff_t file_seek(FSDriver *fsp, lfs_file_t *file, lfs_soff_t off, int whence)
+{
+    int64_t pos = off;
+
+    if (whence == LFS_SEEK_CUR)
+        pos += file->pos;
+    else if (whence == LFS_SEEK_END)
+        pos += file->size;
+    if (pos < 0 || pos > LFS_FILE_MAX)
+        return fsp->err = LFS_ERR_INVAL;
+    file->pos = pos;
+    fsp->err = 0;
+    return pos;
+}
+
+lfs_soff_t file_size(FSDriver *fsp, lfs_file_t *file)
+{
+    fsp->err = 0;
+    return file->size;
+}
+
+uint32_t file_crc(FSDriver *fsp, lfs_file_t *file)
+{
+    uint8_t buf[512];
+    lfs_ssize_t n;
+    uint32_t crc = 0;
+
+    while ((n = file_read(fsp, file, buf, sizeof(buf))) > 0)
+        crc = crc32(buf, n, crc);
+    return crc;
+}
+
+/* Table driven CRC-32 as crc32_sw computes it, the real file needs the STM32 CRC unit */
+uint32_t crc32(const uint8_t block[], size_t len, uint32_t crc)
+{
+    static uint32_t table[256];
+
+    if (table[1] == 0) {
+        for (uint32_t i = 0; i < 256; i++) {
+            uint32_t c = i;
+            for (int k = 0; k < 8; k++)
+                c = (c & 1U ? 0xEDB88320U ^ (c >> 1) : c >> 1);
+            table[i] = c;
+        }
+    }
+    crc = ~crc;
+    for (size_t i = 0; i < len; i++)
+        crc = table[(crc ^ block[i]) & 0xFFU] ^ (crc >> 8);
+    return ~crc;
+}
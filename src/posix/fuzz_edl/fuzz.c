@@ -0,0 +1,160 @@
+/*
+ * Per-input cost accounting shared by the harnesses, and a main() for
+ * replaying a corpus when the harness is not linked against libFuzzer.
+ *
+ * Every input is timed around the parser call only. The slowest input seen
+ * is reported as soon as it shows up and saved to slow-<name> on exit, next
+ * to a log2 histogram of the cost, so a regression in a slow path is visible
+ * even when nothing crashes.
+ */
+#include <dirent.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+#include "fuzz.h"
+
+#define FUZZ_BUCKETS                        32
+/* Inputs before slow input reports start, the first ones warm the caches */
+#define FUZZ_WARMUP                         1000U
+#define FUZZ_MAX_LEN                        4096U
+
+static const char *fuzz_name = "fuzz";
+static uint64_t start_ns;
+static uint64_t runs;
+static uint64_t total_ns;
+static uint64_t total_bytes;
+static uint64_t max_ns;
+static uint64_t hist[FUZZ_BUCKETS];
+static uint8_t slow_buf[FUZZ_MAX_LEN];
+static size_t slow_len;
+
+static uint64_t now_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000U + ts.tv_nsec;
+}
+
+static void fuzz_report(void)
+{
+    char path[64];
+    FILE *f;
+
+    if (runs == 0)
+        return;
+
+    fprintf(stderr, "%s: %llu inputs, %.0f ns/input, %.2f ns/byte, slowest %llu ns (%zu bytes)\n",
+            fuzz_name, (unsigned long long)runs, (double)total_ns / runs,
+            (total_bytes ? (double)total_ns / total_bytes : 0.0),
+            (unsigned long long)max_ns, slow_len);
+    for (int i = 0; i < FUZZ_BUCKETS; i++) {
+        if (hist[i] != 0) {
+            fprintf(stderr, "  < %10llu ns %10llu\n", 2ULL << i, (unsigned long long)hist[i]);
+        }
+    }
+
+    snprintf(path, sizeof(path), "slow-%s", fuzz_name);
+    if ((f = fopen(path, "wb")) != NULL) {
+        fwrite(slow_buf, 1, slow_len, f);
+        fclose(f);
+    }
+}
+
+void fuzz_init(const char *name)
+{
+    fuzz_name = name;
+    atexit(fuzz_report);
+}
+
+void fuzz_begin(void)
+{
+    start_ns = now_ns();
+}
+
+void fuzz_end(const uint8_t *data, size_t size)
+{
+    uint64_t ns = now_ns() - start_ns;
+    int bucket = 0;
+
+    runs++;
+    total_ns += ns;
+    total_bytes += size;
+    while (bucket < FUZZ_BUCKETS - 1 && (ns >> (bucket + 1)) != 0)
+        bucket++;
+    hist[bucket]++;
+
+    if (ns > max_ns) {
+        max_ns = ns;
+        slow_len = (size < sizeof(slow_buf) ? size : sizeof(slow_buf));
+        memcpy(slow_buf, data, slow_len);
+        if (runs > FUZZ_WARMUP) {
+            fprintf(stderr, "%s: new slowest input, %llu ns for %zu bytes\n",
+                    fuzz_name, (unsigned long long)ns, size);
+        }
+    }
+}
+
+#if defined(FUZZ_STANDALONE)
+static uint8_t input[FUZZ_MAX_LEN];
+
+static void run_file(const char *path)
+{
+    FILE *f = fopen(path, "rb");
+    size_t len;
+
+    if (f == NULL) {
+        perror(path);
+        return;
+    }
+    len = fread(input, 1, sizeof(input), f);
+    fclose(f);
+    LLVMFuzzerTestOneInput(input, len);
+}
+
+static void run_path(const char *path)
+{
+    char child[1024];
+    struct stat st;
+    struct dirent *ent;
+    DIR *dir;
+
+    if (stat(path, &st) != 0) {
+        perror(path);
+        return;
+    }
+    if (!S_ISDIR(st.st_mode)) {
+        run_file(path);
+        return;
+    }
+    if ((dir = opendir(path)) == NULL)
+        return;
+    while ((ent = readdir(dir)) != NULL) {
+        if (ent->d_name[0] == '.')
+            continue;
+        snprintf(child, sizeof(child), "%s/%s", path, ent->d_name);
+        run_path(child);
+    }
+    closedir(dir);
+}
+
+/* Usage: <harness> [-n passes] <file or corpus dir>... */
+int main(int argc, char *argv[])
+{
+    int passes = 1, first = 1;
+
+    LLVMFuzzerInitialize(&argc, &argv);
+    if (argc > 2 && !strcmp(argv[1], "-n")) {
+        passes = atoi(argv[2]);
+        first = 3;
+    }
+    for (int n = 0; n < passes; n++) {
+        for (int i = first; i < argc; i++) {
+            run_path(argv[i]);
+        }
+    }
+    return 0;
+}
+#endif
@@ -0,0 +1,28 @@
+#ifndef _FUZZ_H_
+#define _FUZZ_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include "frame_buf.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* libFuzzer entry points, each harness defines both */
+int LLVMFuzzerInitialize(int *argc, char ***argv);
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size);
+
+void fuzz_init(const char *name);
+void fuzz_begin(void);
+void fuzz_end(const uint8_t *data, size_t size);
+
+/* Stub back ends, see backend.c */
+void backend_reset(void);
+/* A frame buffer from the pool in kernel.c */
+fb_t *backend_fb(void);
+
+#ifdef __cplusplus
+}
+#endif /*__cplusplus*/
+#endif
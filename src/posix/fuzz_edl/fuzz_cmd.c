@@ -0,0 +1,34 @@
+/*
+ * cmd_process() on raw command bytes, as the VC0/VC2 command MAPs hand
+ * them over after the USLP and SDLS layers.
+ */
+#include <stdlib.h>
+#include <string.h>
+#include "cmd.h"
+#include "fuzz.h"
+
+int LLVMFuzzerInitialize(int *argc, char ***argv)
+{
+    (void)argc;
+    (void)argv;
+    fuzz_init("cmd");
+    return 0;
+}
+
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
+{
+    /* Exactly sized copy, so reads past the frame are caught */
+    cmd_t *cmd = malloc(size ? size : 1);
+    fb_t *resp_fb = backend_fb();
+
+    memcpy(cmd, data, size);
+    backend_reset();
+
+    fuzz_begin();
+    cmd_process(cmd, size, resp_fb);
+    fuzz_end(data, size);
+
+    fb_free(resp_fb, NULL);
+    free(cmd);
+    return 0;
+}
@@ -0,0 +1,32 @@
+/*
+ * file_recv() on raw file transfer segments, as the VC1/VC2 file MAPs hand
+ * them over.
+ */
+#include <stdlib.h>
+#include <string.h>
+#include "file_xfr.h"
+#include "fuzz.h"
+
+int LLVMFuzzerInitialize(int *argc, char ***argv)
+{
+    (void)argc;
+    (void)argv;
+    fuzz_init("file");
+    return 0;
+}
+
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
+{
+    file_xfr_t *xfr = malloc(size ? size : 1);
+    uint32_t crc = 0;
+
+    memcpy(xfr, data, size);
+    backend_reset();
+
+    fuzz_begin();
+    file_recv(xfr, size, &crc);
+    fuzz_end(data, size);
+
+    free(xfr);
+    return 0;
+}
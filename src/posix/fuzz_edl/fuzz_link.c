@@ -0,0 +1,192 @@
+/*
+ * USLP configuration shared by the frame harness and the seed generator.
+ * VC0 carries SDLS authenticated commands, VC1 unauthenticated file
+ * segments and VC2 sequence controlled commands and file segments, with
+ * COP directives on MAP 2, like the flight configuration in comms.c. The receive side checks MACs with
+ * hmac_recv, the transmit side signs with hmac_send for the seeds.
+ */
+#include "hmac.h"
+#include "file_xfr.h"
+#include "fuzz_link.h"
+#include "OD.h"
+
+static inline void vc_lock(void *arg) {
+    mutex_t *mutex = arg;
+    chMtxLock(mutex);
+}
+
+static inline void vc_unlock(void *arg) {
+    mutex_t *mutex = arg;
+    chMtxUnlock(mutex);
+}
+
+#if (USLP_USE_SDLS == TRUE)
+static const sdls_cfg_t sdls_rx_cfg = {
+    .spi            = 1,
+    .iv_len         = 0,
+    .seq_num_len    = sizeof(OD_PERSIST_STATE.x6004_persistentState.EDL_SequenceCount),
+    .pad_len        = 0,
+    .mac_len        = 32,
+    .send_func      = NULL,
+    .send_arg       = NULL,
+    .recv_func      = hmac_recv,
+    .recv_arg       = OD_PERSIST_KEYS.x6005_cryptoKeys[0],
+};
+
+static const sdls_cfg_t sdls_tx_cfg = {
+    .spi            = 1,
+    .iv_len         = 0,
+    .seq_num_len    = sizeof(OD_PERSIST_STATE.x6004_persistentState.EDL_SequenceCount),
+    .pad_len        = 0,
+    .mac_len        = 32,
+    .send_func      = hmac_send,
+    .send_arg       = OD_PERSIST_KEYS.x6005_cryptoKeys[0],
+    .recv_func      = NULL,
+    .recv_arg       = NULL,
+};
+#endif
+
+static const uslp_map_t map_cmd = {
+    .sdu            = SDU_MAP_ACCESS,
+    .upid           = UPID_MAPA_SDU,
+    .max_pkt_len    = CMD_RESP_LEN,
+    .incomplete     = false,
+    .map_recv       = fuzz_map_cmd,
+};
+
+static const uslp_map_t map_file = {
+    .sdu            = SDU_MAP_ACCESS,
+    .upid           = UPID_MAPA_SDU,
+    .max_pkt_len    = FILE_BUF_LEN + sizeof(file_xfr_t),
+    .incomplete     = false,
+    .map_recv       = fuzz_map_file,
+};
+
+static const uslp_map_t map_cop = {
+    .sdu            = SDU_MAP_ACCESS,
+    .upid           = UPID_MAPA_SDU,
+    .max_pkt_len    = 8,
+    .incomplete     = false,
+    .map_recv       = fuzz_map_cop,
+};
+
+uint32_t fuzz_vc2_seq_cnt;
+static uint32_t vc2_exp_cnt;
+static MUTEX_DECL(vc2_lock);
+
+static const uslp_vc_t vc0_rx = {
+    .seq_ctrl_len   = 0,
+    .expedited_len  = 0,
+    .seq_ctrl_cnt   = NULL,
+    .expedited_cnt  = NULL,
+    .cop            = COP_NONE,
+    .mapid[0]       = &map_cmd,
+    .trunc_tf_len   = USLP_MAX_LEN,
+    .ocf            = true,
+#if (USLP_USE_SDLS == TRUE)
+    .sdls_cfg       = &sdls_rx_cfg,
+#endif
+};
+
+static const uslp_vc_t vc0_tx = {
+    .seq_ctrl_len   = 0,
+    .expedited_len  = 0,
+    .seq_ctrl_cnt   = NULL,
+    .expedited_cnt  = NULL,
+    .cop            = COP_NONE,
+    .mapid[0]       = &map_cmd,
+    .trunc_tf_len   = USLP_MAX_LEN,
+    .ocf            = true,
+#if (USLP_USE_SDLS == TRUE)
+    .sdls_cfg       = &sdls_tx_cfg,
+#endif
+};
+
+static const uslp_vc_t vc1 = {
+    .seq_ctrl_len   = 0,
+    .expedited_len  = 0,
+    .seq_ctrl_cnt   = NULL,
+    .expedited_cnt  = NULL,
+    .cop            = COP_NONE,
+    .mapid[0]       = &map_file,
+    .trunc_tf_len   = USLP_MAX_LEN,
+    .ocf            = true,
+#if (USLP_USE_SDLS == TRUE)
+    .sdls_cfg       = NULL,
+#endif
+};
+
+static const uslp_vc_t vc2_rx = {
+    .seq_ctrl_len   = sizeof(fuzz_vc2_seq_cnt),
+    .expedited_len  = sizeof(vc2_exp_cnt),
+    .seq_ctrl_cnt   = &fuzz_vc2_seq_cnt,
+    .expedited_cnt  = &vc2_exp_cnt,
+    .cop            = COP_NONE,
+    .mapid[0]       = &map_cmd,
+    .mapid[1]       = &map_file,
+    .mapid[2]       = &map_cop,
+    .trunc_tf_len   = USLP_MAX_LEN,
+    .ocf            = true,
+    .lock_arg       = &vc2_lock,
+    .lock           = vc_lock,
+    .unlock         = vc_unlock,
+#if (USLP_USE_SDLS == TRUE)
+    .sdls_cfg       = &sdls_rx_cfg,
+#endif
+};
+
+static const uslp_vc_t vc2_tx = {
+    .seq_ctrl_len   = sizeof(fuzz_vc2_seq_cnt),
+    .expedited_len  = sizeof(vc2_exp_cnt),
+    .seq_ctrl_cnt   = &fuzz_vc2_seq_cnt,
+    .expedited_cnt  = &vc2_exp_cnt,
+    .cop            = COP_NONE,
+    .mapid[0]       = &map_cmd,
+    .mapid[1]       = &map_file,
+    .mapid[2]       = &map_cop,
+    .trunc_tf_len   = USLP_MAX_LEN,
+    .ocf            = true,
+    .lock_arg       = &vc2_lock,
+    .lock           = vc_lock,
+    .unlock         = vc_unlock,
+#if (USLP_USE_SDLS == TRUE)
+    .sdls_cfg       = &sdls_tx_cfg,
+#endif
+};
+
+static const uslp_mc_t rx_mc = {
+    .scid           = &OD_PERSIST_APP.x6006_CCSDS.spacecraftID,
+    .owner          = true,
+    .vcid[0]        = &vc0_rx,
+    .vcid[1]        = &vc1,
+    .vcid[2]        = &vc2_rx,
+};
+
+static const uslp_mc_t tx_mc = {
+    .scid           = &OD_PERSIST_APP.x6006_CCSDS.spacecraftID,
+    .owner          = false,
+    .vcid[0]        = &vc0_tx,
+    .vcid[1]        = &vc1,
+    .vcid[2]        = &vc2_tx,
+};
+
+static const uslp_pc_t fuzz_pc = {
+    .name           = "Fuzz",
+    .tf_len         = USLP_MAX_LEN,
+    .fecf           = FECF_HW,
+    .fecf_len       = FECF_LEN,
+    .phy_send       = fuzz_phy_send,
+    .phy_send_ahead = fuzz_phy_send,
+};
+
+const uslp_link_t fuzz_rx_link = {
+    .mc = &rx_mc,
+    .pc_rx = &fuzz_pc,
+    .pc_tx = &fuzz_pc,
+};
+
+const uslp_link_t fuzz_tx_link = {
+    .mc = &tx_mc,
+    .pc_rx = &fuzz_pc,
+    .pc_tx = &fuzz_pc,
+};
@@ -0,0 +1,47 @@
+#ifndef _FUZZ_LINK_H_
+#define _FUZZ_LINK_H_
+
+#include "uslp.h"
+
+/* 16-bit FECF checked and stripped by the AX5043, as in comms.h */
+#define FECF_LEN                            2
+#define USLP_MAX_LEN                        (FB_MAX_LEN + FECF_LEN)
+#define CMD_RESP_LEN                        64
+#define FILE_BUF_LEN                        1024
+
+/*
+ * Capture files hold a replay_hdr_t followed by one replay_rec_t and len
+ * frame bytes per received frame, as the radio hands them to the EDL
+ * worker (FECF stripped). Fields are little endian.
+ */
+#define REPLAY_MAGIC                        0x434C4445U /* "EDLC" */
+
+typedef struct __attribute__((packed)) {
+    uint32_t magic;
+    uint32_t seq;                           /* EDL_SequenceCount when the capture started */
+} replay_hdr_t;
+
+typedef struct __attribute__((packed)) {
+    uint32_t t_us;                          /* Arrival time since the start of the capture */
+    uint16_t len;
+} replay_rec_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* The flight VC and MAP layout from comms.c, around the given handlers */
+extern const uslp_link_t fuzz_rx_link;
+extern const uslp_link_t fuzz_tx_link;
+/* VC2 frame count of both, the next N(S) the ground sends */
+extern uint32_t fuzz_vc2_seq_cnt;
+
+void fuzz_map_cmd(fb_t *fb, void *arg);
+void fuzz_map_file(fb_t *fb, void *arg);
+void fuzz_map_cop(fb_t *fb, void *arg);
+void fuzz_phy_send(fb_t *fb, void *arg);
+
+#ifdef __cplusplus
+}
+#endif /*__cplusplus*/
+#endif
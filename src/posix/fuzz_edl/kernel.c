@@ -0,0 +1,97 @@
+/*
+ * Single threaded kernel and frame buffer pool for the fuzz harnesses, as
+ * declared in stubs/kernel. Nothing blocks and no thread ever runs.
+ * replay links the host runtime and radio.c instead.
+ */
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+#include "ch.h"
+#include "hal.h"
+#include "fuzz.h"
+
+#define KERNEL_FB_COUNT                     4
+
+EFlashDriver EFLD1;
+
+static thread_t dummy_thread = {"stub", false};
+static fb_t fb_pool[KERNEL_FB_COUNT];
+static bool fb_used[KERNEL_FB_COUNT];
+
+/* Frame buffers come from a small fixed pool, leaks trip the assert */
+fb_t *__fb_alloc(size_t len, void *arg)
+{
+    (void)len;
+    (void)arg;
+    for (int i = 0; i < KERNEL_FB_COUNT; i++) {
+        if (!fb_used[i]) {
+            fb_used[i] = true;
+            memset(&fb_pool[i], 0, sizeof(fb_t));
+            return &fb_pool[i];
+        }
+    }
+    assert(!"frame buffer pool exhausted");
+    return NULL;
+}
+
+void __fb_free(fb_t *fb, void *arg)
+{
+    (void)arg;
+    assert(fb >= fb_pool && fb < fb_pool + KERNEL_FB_COUNT && fb_used[fb - fb_pool]);
+    fb_used[fb - fb_pool] = false;
+}
+
+fb_t *backend_fb(void)
+{
+    return fb_alloc(FB_MAX_LEN, NULL);
+}
+
+/* Kernel */
+void chMtxObjectInit(mutex_t *mp) { mp->locked = 0; }
+void chMtxLock(mutex_t *mp) { assert(!mp->locked); mp->locked = 1; }
+void chMtxUnlock(mutex_t *mp) { assert(mp->locked); mp->locked = 0; }
+
+/* No job runner, so the job queue is always full and submissions stop at validation */
+msg_t chMBPostTimeout(mailbox_t *mbp, msg_t msg, sysinterval_t timeout)
+{
+    (void)mbp;
+    (void)msg;
+    (void)timeout;
+    return MSG_TIMEOUT;
+}
+
+msg_t chMBFetchTimeout(mailbox_t *mbp, msg_t *msgp, sysinterval_t timeout)
+{
+    (void)mbp;
+    (void)msgp;
+    (void)timeout;
+    return MSG_TIMEOUT;
+}
+
+thread_t *chThdCreateStatic(void *wsp, size_t size, tprio_t prio, tfunc_t pf, void *arg)
+{
+    (void)wsp;
+    (void)size;
+    (void)prio;
+    (void)pf;
+    (void)arg;
+    return &dummy_thread;
+}
+
+thread_t *chThdCreateFromHeap(void *heapp, size_t size, const char *name, tprio_t prio, tfunc_t pf, void *arg)
+{
+    (void)heapp;
+    (void)name;
+    return chThdCreateStatic(NULL, size, prio, pf, arg);
+}
+
+thread_t *chThdGetSelfX(void) { return &dummy_thread; }
+void chThdTerminate(thread_t *tp) { (void)tp; }
+bool chThdShouldTerminateX(void) { return false; }
+msg_t chThdWait(thread_t *tp) { (void)tp; return MSG_OK; }
+void chThdExit(msg_t msg) { (void)msg; abort(); }
+void chThdSleepMilliseconds(uint32_t ms) { (void)ms; }
+systime_t chVTGetSystemTime(void) { return 0; }
+rtcnt_t chSysGetRealtimeCounterX(void) { return 0; }
+void chSysLock(void) {}
+void chSysUnlock(void) {}
@@ -0,0 +1,323 @@
+/*
+ * Replays a recorded uplink capture through the flight EDL path on the host
+ * runtime: comms.c and radio.c as built for the C3, with the EDL worker,
+ * the VC2 FARM, the TX workers and the frame buffer queues, and uslp_recv()
+ * with the SDLS/HMAC check, cmd_process() and file_recv() behind them. Only
+ * the radio driver and the object dictionary are stood in for, and the
+ * commands reach the stub back ends in backend.c, so nothing in a capture
+ * can reach a spacecraft.
+ *
+ * Frames are posted with pdu_send(&rx_queue.fifo) at their recorded arrival
+ * times on the virtual clock, from a buffer taken off the receive pool as
+ * the AX5043 RX worker does, on the UHF link. Responses leave through
+ * ax5043TX(), which takes the air time of the profile's data rate, so a
+ * slow downlink backs up into the EDL worker as it would on the C3. The
+ * code itself takes no virtual time: the stage times are time spent
+ * blocked, and the host CPU time is reported on its own.
+ *
+ * Every run starts from the same state in a fresh process. The frame
+ * counts, FARM counters, response digest, queue statistics and stage times
+ * are therefore the same on every run and every host, only the host CPU
+ * time is not.
+ *
+ * Usage: replay [-n runs] <capture>
+ */
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include "ch.h"
+#include "hal.h"
+#include "comms.h"
+#include "beacon.h"
+#include "crc.h"
+#include "fuzz_link.h"
+#include "fuzz.h"
+#include "OD.h"
+
+typedef struct {
+    uint32_t t_us;
+    uint16_t len;
+    const uint8_t *data;
+} replay_frame_t;
+
+/* What a run sends back to the parent */
+typedef struct {
+    char report[2048];                      /* Identical on every run */
+    uint64_t cpu_ns;                        /* Host CPU time, first frame to drained */
+} replay_result_t;
+
+static replay_result_t result;
+
+/* Transmissions through the stand-in radio */
+static struct {
+    uint32_t frames;
+    uint32_t bytes;
+    uint32_t digest;                        /* CRC32 over every frame sent */
+} tx;
+
+/*===========================================================================*/
+/* Radio stand-in.                                                           */
+/*===========================================================================*/
+
+/* The AX5043 driver calls of comms.c and radio.c, nothing is received here */
+void ax5043ObjectInit(AX5043Driver *devp) { memset(devp, 0, sizeof(*devp)); }
+void ax5043Start(AX5043Driver *devp, const AX5043Config *config) { devp->config = config; }
+void ax5043Stop(AX5043Driver *devp) { (void)devp; }
+void ax5043RX(AX5043Driver *devp, bool chan_b, bool wor) { (void)devp; (void)chan_b; (void)wor; }
+void ax5043SetVCOTemp(AX5043Driver *devp, int16_t temp) { (void)devp; (void)temp; }
+void si41xxObjectInit(SI41XXDriver *devp) { (void)devp; }
+void si41xxStart(SI41XXDriver *devp, SI41XXConfig *config) { (void)devp; (void)config; }
+void si41xxStop(SI41XXDriver *devp) { (void)devp; }
+
+/* Air time in us at the TXRATE of the profile, none if it sets no rate */
+static uint32_t air_time_us(const ax5043_profile_t *profile, size_t len)
+{
+    for (; profile->len != 0; profile++) {
+        if (profile->reg == AX5043_REG_TXRATE && profile->val != 0)
+            return (uint64_t)len * 8U * 1000000U * (1U << 24) / ((uint64_t)profile->val * XTAL_CLK);
+    }
+    return 0;
+}
+
+void ax5043TX(AX5043Driver *devp, const ax5043_profile_t *profile, const void *buf, size_t len,
+              size_t total_len, ax5043_tx_cb_t tx_cb, void *tx_cb_arg, bool chan_b)
+{
+    (void)devp;
+    (void)total_len;
+    (void)tx_cb;
+    (void)tx_cb_arg;
+    (void)chan_b;
+
+    tx.frames++;
+    tx.bytes += len;
+    tx.digest = crc32(buf, len, tx.digest);
+    chThdSleepMicroseconds(air_time_us(profile, len));
+}
+
+/* Beacons need the telemetry and go nowhere */
+void beacon_send(const radio_cfg_t *cfg) { (void)cfg; }
+
+THD_FUNCTION(beacon, arg)
+{
+    (void)arg;
+    chThdExit(MSG_OK);
+}
+
+/*===========================================================================*/
+/* Replay.                                                                   */
+/*===========================================================================*/
+
+/* Read the whole capture up front, so file access stays out of the run */
+static replay_frame_t *load(const char *path, uint32_t *seq, size_t *count)
+{
+    replay_hdr_t hdr;
+    replay_rec_t rec;
+    replay_frame_t *frames = NULL;
+    size_t n = 0, size = 0;
+    uint8_t *data;
+    FILE *f;
+
+    if ((f = fopen(path, "rb")) == NULL) {
+        perror(path);
+        return NULL;
+    }
+    if (fread(&hdr, sizeof(hdr), 1, f) != 1 || hdr.magic != REPLAY_MAGIC) {
+        fprintf(stderr, "%s: not a capture\n", path);
+        fclose(f);
+        return NULL;
+    }
+    while (fread(&rec, sizeof(rec), 1, f) == 1) {
+        if (rec.len > FB_MAX_LEN || (data = malloc(rec.len ? rec.len : 1)) == NULL ||
+                fread(data, 1, rec.len, f) != rec.len) {
+            fprintf(stderr, "%s: frame %zu truncated or longer than %u bytes\n", path, n, FB_MAX_LEN);
+            fclose(f);
+            return NULL;
+        }
+        if (n == size) {
+            size = (size ? size * 2 : 64);
+            frames = realloc(frames, size * sizeof(*frames));
+        }
+        frames[n++] = (replay_frame_t){
+            .t_us = rec.t_us,
+            .len = rec.len,
+            .data = data,
+        };
+    }
+    fclose(f);
+    *seq = hdr.seq;
+    *count = n;
+    return frames;
+}
+
+static uint64_t cpu_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000U + ts.tv_nsec;
+}
+
+static uint32_t rt_us(uint64_t cycles)
+{
+    return cycles / (CH_HOST_RT_FREQUENCY / 1000000U);
+}
+
+static bool pool_full(objects_fifo_t *fifo)
+{
+    cnt_t free;
+
+    chSysLock();
+    free = chSemGetCounterI(&fifo->free.sem);
+    chSysUnlock();
+    return free == (cnt_t)RADIO_FIFO_COUNT;
+}
+
+/* Append to the report of this run */
+static void report(const char *fmt, ...)
+{
+    size_t len = strlen(result.report);
+    va_list ap;
+
+    va_start(ap, fmt);
+    vsnprintf(&result.report[len], sizeof(result.report) - len, fmt, ap);
+    va_end(ap);
+}
+
+static void report_queue(const char *name, void *fifo)
+{
+    pdu_stats_t stats;
+
+    pdu_get_stats(fifo, &stats);
+    report("%-8s %8u %8u %9u %10u %11u %11u\n", name, stats.sent, stats.received,
+           stats.depth_max, stats.pool_empty,
+           (stats.received ? rt_us(stats.wait_sum / stats.received) : 0), rt_us(stats.wait_max));
+}
+
+static void report_stage(const char *name, const edl_stage_t *stage)
+{
+    report("%-8s %8u %10u %10u\n", name, stage->count,
+           (stage->count ? rt_us(stage->sum / stage->count) : 0), rt_us(stage->max));
+}
+
+/* One run from a fresh runtime, in the child process */
+static void run(const replay_frame_t *frames, size_t count, uint32_t seq)
+{
+    const AX5043Config *cfg = NULL;
+    edl_stats_t edl;
+    systime_t start;
+    uint64_t cpu_start;
+
+    memset(&result, 0, sizeof(result));
+    halInit();
+    chSysInit();
+    backend_reset();
+    OD_PERSIST_STATE.x6004_persistentState.EDL_SequenceCount = seq;
+    comms_init();
+    comms_start();
+    for (int i = 0; radio_devices[i].devp != NULL; i++) {
+        if (radio_devices[i].devp == &uhf)
+            cfg = radio_devices[i].cfgp;
+    }
+
+    start = chVTGetSystemTime();
+    cpu_start = cpu_ns();
+    for (size_t i = 0; i < count; i++) {
+        sysinterval_t at = TIME_US2I(frames[i].t_us);
+        fb_t *fb;
+
+        if (chVTTimeElapsedSinceX(start) < at)
+            chThdSleep(at - chVTTimeElapsedSinceX(start));
+        /* Blocks on an empty pool, as the RX worker does */
+        fb = fb_alloc(FB_MAX_LEN, &rx_queue.fifo);
+        fb->phy_arg = (void*)cfg->phy_arg;
+        memcpy(fb_put(fb, frames[i].len), frames[i].data, frames[i].len);
+        pdu_send(fb, &rx_queue.fifo);
+    }
+
+    /* Every buffer back in its pool, so every response is on the air */
+    while (!pool_full(&rx_queue.fifo) || !pool_full(&uhf_txq.fifo) || !pool_full(&lband_txq.fifo)) {
+        chThdSleepMilliseconds(1);
+    }
+    result.cpu_ns = cpu_ns() - cpu_start;
+
+    comms_get_stats(&edl);
+    report("Replayed %zu frames over %u ms, drained after %u ms\n", count,
+           (count ? frames[count - 1].t_us / 1000U : 0),
+           (unsigned)TIME_I2MS(chVTTimeElapsedSinceX(start)));
+    report("EDL frames: %u accepted, %u rejected\n", edl.accepted, edl.rejected);
+    report("VC2 FARM: %u accepted, %u rejected, %u retransmits, %u lockouts, CLCW 0x%08X\n",
+           OD_RAM.x7000_C3_Telemetry.VC2_Accepted, OD_RAM.x7000_C3_Telemetry.VC2_Rejected,
+           OD_RAM.x7000_C3_Telemetry.VC2_Retransmits, OD_RAM.x7000_C3_Telemetry.VC2_Lockouts,
+           OD_RAM.x7000_C3_Telemetry.VC2_CLCW);
+    report("Downlink: %u frames, %u bytes, digest 0x%08X\n", tx.frames, tx.bytes, tx.digest);
+    report("Queue        sent     recv depth max pool empty wait avg us wait max us\n");
+    report_queue("rx", &rx_queue.fifo);
+    report_queue("uhf tx", &uhf_txq.fifo);
+    report_queue("lband tx", &lband_txq.fifo);
+    report("Stage       count     avg us     max us\n");
+    report_stage("total", &edl.total);
+    report_stage("auth", &edl.auth);
+    report_stage("cmd", &edl.cmd);
+    report_stage("file", &edl.file);
+}
+
+int main(int argc, char *argv[])
+{
+    replay_frame_t *frames;
+    replay_result_t first;
+    uint64_t cpu_min = UINT64_MAX;
+    size_t count;
+    uint32_t seq;
+    int runs = 1, arg = 1;
+
+    if (argc > 3 && !strcmp(argv[1], "-n")) {
+        runs = atoi(argv[2]);
+        arg = 3;
+    }
+    if (arg != argc - 1 || runs < 1) {
+        fprintf(stderr, "Usage: %s [-n runs] <capture>\n", argv[0]);
+        return 1;
+    }
+    if ((frames = load(argv[arg], &seq, &count)) == NULL)
+        return 1;
+
+    for (int i = 0; i < runs; i++) {
+        int fds[2], status;
+        pid_t pid;
+
+        if (pipe(fds) != 0 || (pid = fork()) < 0) {
+            perror("replay");
+            return 1;
+        }
+        if (pid == 0) {
+            close(fds[0]);
+            run(frames, count, seq);
+            _exit(write(fds[1], &result, sizeof(result)) == sizeof(result) ? 0 : 1);
+        }
+        close(fds[1]);
+        if (read(fds[0], &result, sizeof(result)) != sizeof(result) ||
+                waitpid(pid, &status, 0) != pid || !WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+            fprintf(stderr, "Run %d did not finish\n", i + 1);
+            return 1;
+        }
+        close(fds[0]);
+
+        if (i == 0) {
+            first = result;
+        } else if (strcmp(first.report, result.report) != 0) {
+            fprintf(stderr, "Run %d differs from the first, the replay is not deterministic\n", i + 1);
+            return 1;
+        }
+        if (result.cpu_ns < cpu_min)
+            cpu_min = result.cpu_ns;
+    }
+
+    printf("%s", first.report);
+    printf("Host CPU: %llu ns per frame, fastest of %d runs\n",
+           (unsigned long long)(count ? cpu_min / count : 0), runs);
+    return 0;
+}
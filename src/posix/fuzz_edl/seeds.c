@@ -0,0 +1,207 @@
+/*
+ * Writes the starting corpus for the harnesses. The commands and file
+ * segments are the ones the "edl" shell command in test_comms.c builds; the
+ * USLP seeds are the same payloads framed and signed by the OpenCCSDS stack
+ * with the stub key, so they pass the receive side checks unmodified.
+ *
+ * The USLP seeds are also written in order to seeds.edlc, a capture for the
+ * replay program. Signed frames take successive sequence numbers as they do
+ * from the ground, and the capture ends with a retransmitted old frame that
+ * the anti-replay check has to reject.
+ *
+ * Usage: seeds <corpus dir>, the cmd, file and uslp directories must exist.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "cmd.h"
+#include "farm.h"
+#include "file_xfr.h"
+#include "fuzz_link.h"
+#include "fuzz.h"
+#include "OD.h"
+
+/* Spacing of the frames in the capture */
+#define CAPTURE_INTERVAL_US                 100000U
+
+static const char *corpus;
+static const char *seed_name;
+static int seed_count;
+static FILE *capture;
+static uint32_t capture_us;
+static uint8_t first_frame[FB_MAX_LEN];
+static uint16_t first_len;
+
+static void seed_write(const char *dir, const char *name, const void *data, size_t len)
+{
+    char path[256];
+    FILE *f;
+
+    snprintf(path, sizeof(path), "%s/%s/%s", corpus, dir, name);
+    if ((f = fopen(path, "wb")) == NULL) {
+        perror(path);
+        exit(1);
+    }
+    fwrite(data, 1, len, f);
+    fclose(f);
+    seed_count++;
+}
+
+void fuzz_map_cmd(fb_t *fb, void *arg)
+{
+    (void)fb;
+    (void)arg;
+}
+
+void fuzz_map_file(fb_t *fb, void *arg)
+{
+    (void)fb;
+    (void)arg;
+}
+
+void fuzz_map_cop(fb_t *fb, void *arg)
+{
+    (void)fb;
+    (void)arg;
+}
+
+static void capture_write(const void *data, uint16_t len)
+{
+    replay_rec_t rec = {
+        .t_us = capture_us,
+        .len = len,
+    };
+
+    fwrite(&rec, sizeof(rec), 1, capture);
+    fwrite(data, 1, len, capture);
+    capture_us += CAPTURE_INTERVAL_US;
+}
+
+/* Frames leave the stack here, one per seed */
+void fuzz_phy_send(fb_t *fb, void *arg)
+{
+    (void)arg;
+    seed_write("uslp", seed_name, fb->data, fb->len);
+    if (first_len == 0) {
+        memcpy(first_frame, fb->data, fb->len);
+        first_len = fb->len;
+    }
+    capture_write(fb->data, fb->len);
+    fb_free(fb, NULL);
+}
+
+static void seed_frame(const char *name, uint8_t vcid, uint8_t mapid, bool expedited,
+                       size_t reserve, const void *sdu, size_t len)
+{
+    fb_t *fb = backend_fb();
+    char frame_name[64];
+
+    /* Same headroom as send_cmd() and send_file_seg() leave */
+    fb_reserve(fb, USLP_MAX_HEADER_LEN + reserve + 2 + 6);
+    memcpy(fb_put(fb, len), sdu, len);
+    snprintf(frame_name, sizeof(frame_name), "vc%u-%s", vcid, name);
+    seed_name = frame_name;
+    uslp_map_send(&fuzz_tx_link, fb, vcid, mapid, expedited);
+    /* Harnesses start from zero, which accepts any sequence number */
+    OD_PERSIST_STATE.x6004_persistentState.EDL_SequenceCount++;
+}
+
+static void seed_cmd(const char *name, cmd_code_t code, const void *arg, size_t arg_len)
+{
+    uint8_t buf[sizeof(cmd_t) + 64];
+    cmd_t *cmd = (cmd_t*)buf;
+
+    cmd->cmd = code;
+    memcpy(cmd->arg, arg, arg_len);
+    seed_write("cmd", name, buf, sizeof(cmd_t) + arg_len);
+    seed_frame(name, 0, 0, true, 0, buf, sizeof(cmd_t) + arg_len);
+    seed_frame(name, 2, 0, false, 0, buf, sizeof(cmd_t) + arg_len);
+}
+
+static void seed_file(const char *name, const char *dest, uint32_t off, uint32_t len)
+{
+    static uint8_t buf[sizeof(file_xfr_t) + FILE_BUF_LEN];
+    file_xfr_t *xfr = (file_xfr_t*)buf;
+
+    memset(buf, 0, sizeof(buf));
+    memcpy(xfr->filename, dest, strlen(dest));
+    xfr->off = off;
+    xfr->len = len;
+    for (uint32_t i = 0; i < len; i++)
+        xfr->data[i] = i;
+    seed_write("file", name, buf, sizeof(file_xfr_t) + len);
+    seed_frame(name, 1, 0, true, sizeof(file_xfr_t), buf, sizeof(file_xfr_t) + len);
+    seed_frame(name, 2, 1, false, sizeof(file_xfr_t), buf, sizeof(file_xfr_t) + len);
+}
+
+int main(int argc, char *argv[])
+{
+    const uint32_t reset_key[] = {0x01234567U, 0x89ABCDEFU};
+    const uint8_t one = 1, pair[] = {0x1C, 1};
+    const uint32_t now = 1600000000U;
+    const uint8_t unlock = FARM_DIR_UNLOCK;
+    char path[256];
+    replay_hdr_t hdr = {
+        .magic = REPLAY_MAGIC,
+        .seq = 0,
+    };
+    struct {
+        uint32_t crc;
+        char filename[9];
+    } flash = {0x12345678U, "fw.bin"};
+    uint8_t sdo_buf[sizeof(cmd_sdo_t) + 4] = {0};
+    cmd_sdo_t *sdo = (cmd_sdo_t*)sdo_buf;
+
+    if (argc < 2) {
+        fprintf(stderr, "Usage: %s <corpus dir>\n", argv[0]);
+        return 1;
+    }
+    corpus = argv[1];
+    backend_reset();
+    snprintf(path, sizeof(path), "%s/seeds.edlc", corpus);
+    if ((capture = fopen(path, "wb")) == NULL) {
+        perror(path);
+        return 1;
+    }
+    fwrite(&hdr, sizeof(hdr), 1, capture);
+
+    sdo->node_id = 0x10;
+    sdo->index = 0x6000;
+    sdo->subindex = 1;
+    sdo->size = 4;
+    memcpy(sdo->data, "\x01\x02\x03\x04", 4);
+
+    seed_cmd("tx_enable", CMD_TX_CTRL, &one, sizeof(one));
+    seed_cmd("fw_flash", CMD_FW_FLASH, &flash, sizeof(flash));
+    seed_cmd("fw_bank", CMD_FW_BANK, &one, sizeof(one));
+    seed_cmd("fw_verify", CMD_FW_VERIFY, &one, sizeof(one));
+    seed_cmd("c3_softreset", CMD_C3_SOFTRESET, reset_key, sizeof(reset_key));
+    seed_cmd("fs_format", CMD_FS_FORMAT, NULL, 0);
+    seed_cmd("fs_unmount", CMD_FS_UNMOUNT, NULL, 0);
+    seed_cmd("fs_remove", CMD_FS_REMOVE, "test", 5);
+    seed_cmd("fs_crc", CMD_FS_CRC, "test", 5);
+    seed_cmd("node_enable", CMD_NODE_ENABLE, pair, sizeof(pair));
+    seed_cmd("node_status", CMD_NODE_STATUS, pair, 1);
+    seed_cmd("opd_sysenable", CMD_OPD_SYSENABLE, NULL, 0);
+    seed_cmd("opd_scan", CMD_OPD_SCAN, &one, sizeof(one));
+    seed_cmd("opd_enable", CMD_OPD_ENABLE, pair, sizeof(pair));
+    seed_cmd("opd_status", CMD_OPD_STATUS, pair, 1);
+    seed_cmd("rtc_settime", CMD_RTC_SETTIME, &now, sizeof(now));
+    seed_cmd("sdo_write", CMD_SDO_WRITE, sdo_buf, sizeof(sdo_buf));
+    seed_cmd("job_status", CMD_JOB_STATUS, &one, sizeof(one));
+    seed_cmd("job_cancel", CMD_JOB_CANCEL, &one, sizeof(one));
+    seed_cmd("fw_flash_job", CMD_FW_FLASH_JOB, &flash, sizeof(flash));
+    seed_cmd("fw_verify_job", CMD_FW_VERIFY_JOB, &one, sizeof(one));
+    seed_cmd("fs_format_job", CMD_FS_FORMAT_JOB, NULL, 0);
+    seed_cmd("fs_crc_job", CMD_FS_CRC_JOB, "test", 5);
+
+    seed_file("fs_upload_seg", "test", 0, 64);
+    seed_file("fs_upload", "test", 1024, FILE_BUF_LEN);
+    seed_frame("cop_unlock", 2, 2, true, 0, &unlock, sizeof(unlock));
+
+    capture_write(first_frame, first_len);
+    fclose(capture);
+
+    printf("Wrote %d seeds to %s\n", seed_count, corpus);
+    return 0;
+}
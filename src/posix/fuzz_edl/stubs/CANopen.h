@@ -0,0 +1,14 @@
+#ifndef _CANOPEN_H_
+#define _CANOPEN_H_
+
+#include <stdint.h>
+
+typedef enum {
+    CO_NMT_UNKNOWN = -1,
+    CO_NMT_INITIALIZING = 0,
+    CO_NMT_PRE_OPERATIONAL = 127,
+    CO_NMT_OPERATIONAL = 5,
+    CO_NMT_STOPPED = 4
+} CO_NMT_internalState_t;
+
+#endif /* _CANOPEN_H_ */
@@ -0,0 +1,14 @@
+#ifndef _CO_MASTER_H_
+#define _CO_MASTER_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+typedef enum {
+    SDO_CLI_WRITE,
+    SDO_CLI_READ
+} sdocli_op_t;
+
+void sdo_transfer(sdocli_op_t op, uint8_t node_id, uint16_t index, uint8_t subindex, size_t total_size, size_t buf_size, void *buf);
+
+#endif /* _CO_MASTER_H_ */
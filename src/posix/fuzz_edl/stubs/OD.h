@@ -0,0 +1,62 @@
+/*
+ * The object dictionary entries the EDL receive path reads and writes,
+ * with the same names and types as the generated ObjDict/OD.h. The radio
+ * and link counters are only used by comms.c in replay.
+ */
+#ifndef _OD_H_
+#define _OD_H_
+
+#include <stdint.h>
+
+typedef struct {
+    struct {
+        int8_t temperature;
+    } x2022_MCU_Sensors;
+    struct {
+        uint8_t FW_FlashProgress;
+        uint32_t LBandRX_CRC_Fail;
+        uint32_t LBandRX_AddrFail;
+        uint32_t LBandRX_SizeFail;
+        uint32_t LBandRX_Abort;
+        uint32_t UHF_RX_CRC_Fail;
+        uint32_t UHF_RX_AddrFail;
+        uint32_t UHF_RX_SizeFail;
+        uint32_t UHF_RX_Abort;
+        uint32_t VC2_Accepted;
+        uint32_t VC2_Rejected;
+        uint32_t VC2_Retransmits;
+        uint32_t VC2_Lockouts;
+        uint32_t VC2_CLCW;
+        uint8_t Downlink_HighRate;
+        uint8_t Link_FER;
+        uint32_t Link_Switches;
+    } x7000_C3_Telemetry;
+} OD_RAM_t;
+
+typedef struct {
+    struct {
+        uint16_t spacecraftID;
+    } x6006_CCSDS;
+} OD_PERSIST_APP_t;
+
+typedef struct {
+    struct {
+        uint32_t LBandRX_Bytes;
+        uint32_t LBandRX_Packets;
+        uint32_t UHF_RX_Bytes;
+        uint32_t UHF_RX_Packets;
+        uint32_t EDL_SequenceCount;
+        uint32_t EDL_RejectedCount;
+    } x6004_persistentState;
+} OD_PERSIST_STATE_t;
+
+typedef struct {
+    uint8_t x6005_cryptoKeys[4][32];
+} OD_PERSIST_KEYS_t;
+
+extern OD_RAM_t OD_RAM;
+extern OD_PERSIST_APP_t OD_PERSIST_APP;
+extern OD_PERSIST_STATE_t OD_PERSIST_STATE;
+extern OD_PERSIST_KEYS_t OD_PERSIST_KEYS;
+
+#endif /* _OD_H_ */
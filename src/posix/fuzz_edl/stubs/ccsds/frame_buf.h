@@ -0,0 +1,60 @@
+/*
+ * Stand-in for the OpenCCSDS frame buffer, only on the include path when
+ * the submodule is not checked out. cmd_process() appends its response with
+ * fb_put() and that is all fuzz_cmd and fuzz_file need; the frame harness,
+ * seeds and replay build against the real one. app_radio_sim and the AX5043
+ * driver also fill in phy_rx.
+ */
+#ifndef _FRAME_BUF_H_
+#define _FRAME_BUF_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* Room for a 1024 byte file segment and its frame headers */
+#define FB_MAX_LEN                          1280U
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+    uint8_t *data;
+    size_t len;
+    size_t head;
+    void *phy_rx;
+    void *phy_arg;
+    uint8_t buf[FB_MAX_LEN];
+} fb_t;
+
+/* Provided by backend.c, as by radio.c on the target */
+fb_t *__fb_alloc(size_t len, void *arg);
+void __fb_free(fb_t *fb, void *arg);
+
+#define fb_alloc(len, arg)                  __fb_alloc((len), (arg))
+#define fb_free(fb, arg)                    __fb_free((fb), (arg))
+
+static inline void fb_reserve(fb_t *fb, size_t len)
+{
+    fb->head += len;
+}
+
+/* Append len bytes to the end of the data, NULL when they do not fit */
+static inline void *fb_put(fb_t *fb, size_t len)
+{
+    void *pos;
+
+    if (fb->data == NULL)
+        fb->data = &fb->buf[fb->head];
+    if (fb->head + fb->len + len > FB_MAX_LEN)
+        return NULL;
+    pos = &fb->data[fb->len];
+    fb->len += len;
+    return pos;
+}
+
+#ifdef __cplusplus
+}
+#endif /*__cplusplus*/
+#endif
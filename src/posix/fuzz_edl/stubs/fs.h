@@ -0,0 +1,78 @@
+/*
+ * In-memory stand-in for the littlefs wrapper. Files keep their size but
+ * not their contents, written data is only folded into a checksum so
+ * every byte is still read.
+ */
+#ifndef _FS_H_
+#define _FS_H_
+
+#include <stdint.h>
+#include <string.h>
+
+typedef int32_t lfs_ssize_t;
+typedef int32_t lfs_soff_t;
+typedef uint32_t lfs_size_t;
+typedef uint32_t lfs_off_t;
+
+enum lfs_error {
+    LFS_ERR_OK          = 0,
+    LFS_ERR_IO          = -5,
+    LFS_ERR_CORRUPT     = -84,
+    LFS_ERR_NOENT       = -2,
+    LFS_ERR_EXIST       = -17,
+    LFS_ERR_NOTDIR      = -20,
+    LFS_ERR_ISDIR       = -21,
+    LFS_ERR_NOTEMPTY    = -39,
+    LFS_ERR_BADF        = -9,
+    LFS_ERR_FBIG        = -27,
+    LFS_ERR_INVAL       = -22,
+    LFS_ERR_NOSPC       = -28,
+    LFS_ERR_NOMEM       = -12,
+    LFS_ERR_NAMETOOLONG = -36,
+};
+
+enum lfs_open_flags {
+    LFS_O_RDONLY = 1,
+    LFS_O_WRONLY = 2,
+    LFS_O_RDWR   = 3,
+    LFS_O_CREAT  = 0x0100,
+    LFS_O_EXCL   = 0x0200,
+    LFS_O_TRUNC  = 0x0400,
+    LFS_O_APPEND = 0x0800,
+};
+
+enum lfs_whence_flags {
+    LFS_SEEK_SET = 0,
+    LFS_SEEK_CUR = 1,
+    LFS_SEEK_END = 2,
+};
+
+#define LFS_NAME_MAX                        255
+#define LFS_FILE_MAX                        2147483647
+
+typedef struct {
+    char name[LFS_NAME_MAX + 1];
+    lfs_off_t pos;
+    lfs_size_t size;
+    int flags;
+    uint32_t sum;
+} lfs_file_t;
+
+typedef struct {
+    int err;
+} FSDriver;
+
+extern FSDriver FSD1;
+
+int fs_format(FSDriver *fsp);
+int fs_unmount(FSDriver *fsp);
+int fs_remove(FSDriver *fsp, const char *path);
+lfs_file_t *file_open(FSDriver *fsp, const char *path, int flags);
+int file_close(FSDriver *fsp, lfs_file_t *file);
+lfs_ssize_t file_read(FSDriver *fsp, lfs_file_t *file, void *buffer, lfs_size_t size);
+lfs_ssize_t file_write(FSDriver *fsp, lfs_file_t *file, const void *buffer, lfs_size_t size);
+lfs_soff_t file_seek(FSDriver *fsp, lfs_file_t *file, lfs_soff_t off, int whence);
+lfs_soff_t file_size(FSDriver *fsp, lfs_file_t *file);
+uint32_t file_crc(FSDriver *fsp, lfs_file_t *file);
+
+#endif /* _FS_H_ */
@@ -0,0 +1,110 @@
+/*
+ * Single threaded stand-ins for the ChibiOS/RT calls the EDL parsers make.
+ * Nothing blocks and no thread ever runs, so an input is processed start to
+ * finish inside the fuzz callback.
+ */
+#ifndef _CH_H_
+#define _CH_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <assert.h>
+
+#if !defined(FALSE)
+#define FALSE                               0
+#endif
+#if !defined(TRUE)
+#define TRUE                                1
+#endif
+
+/* Wide enough for the pointers cmd.c posts as messages */
+typedef intptr_t msg_t;
+typedef int32_t cnt_t;
+typedef uint32_t systime_t;
+typedef uint32_t sysinterval_t;
+typedef uint32_t rtcnt_t;
+typedef uint32_t tprio_t;
+
+#define MSG_OK                              (msg_t)0
+#define MSG_TIMEOUT                         (msg_t)-1
+#define MSG_RESET                           (msg_t)-2
+
+#define TIME_IMMEDIATE                      ((sysinterval_t)0)
+#define TIME_INFINITE                       ((sysinterval_t)-1)
+#define TIME_MS2I(ms)                       ((sysinterval_t)(ms))
+#define TIME_S2I(s)                         ((sysinterval_t)(s) * 1000U)
+#define TIME_I2MS(i)                        (i)
+
+#define NORMALPRIO                          128U
+
+typedef struct {
+    int locked;
+} mutex_t;
+
+#define MUTEX_DECL(name)                    mutex_t name = {0}
+
+typedef struct {
+    msg_t *buf;
+    size_t n;
+} mailbox_t;
+
+#define MAILBOX_DECL(name, buffer, size)    mailbox_t name = {(msg_t*)(buffer), (size)}
+
+typedef struct {
+    const char *name;
+    bool terminate;
+} thread_t;
+
+typedef void (*tfunc_t)(void *p);
+
+typedef uint32_t eventmask_t;
+typedef uint32_t eventflags_t;
+
+typedef struct {
+    void *next;
+} event_source_t;
+
+typedef struct {
+    void *next;
+    eventmask_t events;
+} event_listener_t;
+
+#define EVENT_MASK(eid)                     ((eventmask_t)1 << (eventmask_t)(eid))
+
+#define THD_FUNCTION(tname, arg)            void tname(void *arg)
+#define THD_WORKING_AREA(s, n)              uint8_t s[n]
+#define THD_WORKING_AREA_SIZE(n)            (n)
+
+#define osalDbgCheck(c)                     assert(c)
+#define osalDbgAssert(c, remark)            assert((c) && (remark))
+#define chDbgCheck(c)                       assert(c)
+#define chDbgAssert(c, remark)              assert((c) && (remark))
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void chMtxObjectInit(mutex_t *mp);
+void chMtxLock(mutex_t *mp);
+void chMtxUnlock(mutex_t *mp);
+msg_t chMBPostTimeout(mailbox_t *mbp, msg_t msg, sysinterval_t timeout);
+msg_t chMBFetchTimeout(mailbox_t *mbp, msg_t *msgp, sysinterval_t timeout);
+thread_t *chThdCreateStatic(void *wsp, size_t size, tprio_t prio, tfunc_t pf, void *arg);
+thread_t *chThdCreateFromHeap(void *heapp, size_t size, const char *name, tprio_t prio, tfunc_t pf, void *arg);
+thread_t *chThdGetSelfX(void);
+void chThdTerminate(thread_t *tp);
+bool chThdShouldTerminateX(void);
+msg_t chThdWait(thread_t *tp);
+void chThdExit(msg_t msg);
+void chThdSleepMilliseconds(uint32_t ms);
+systime_t chVTGetSystemTime(void);
+rtcnt_t chSysGetRealtimeCounterX(void);
+void chSysLock(void);
+void chSysUnlock(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _CH_H_ */
@@ -0,0 +1,30 @@
+/*
+ * Board and HAL pieces the EDL parsers touch. GPIO writes go nowhere.
+ */
+#ifndef _HAL_H_
+#define _HAL_H_
+
+#include "ch.h"
+
+typedef uint32_t ioline_t;
+typedef uint32_t flash_offset_t;
+
+/* Only which bank is selected, nothing is programmed */
+typedef struct {
+    int bank;
+} EFlashDriver;
+
+extern EFlashDriver EFLD1;
+
+/* The flash_error_t codes the commands report */
+#define FLASH_NO_ERROR                      0
+#define FLASH_ERROR_VERIFY                  5
+
+#define LINE_I2C_PWROFF                     0U
+
+#define palSetLine(line)                    ((void)(line))
+#define palClearLine(line)                  ((void)(line))
+
+#define __REV(x)                            __builtin_bswap32(x)
+
+#endif /* _HAL_H_ */
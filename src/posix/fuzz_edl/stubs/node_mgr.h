@@ -0,0 +1,10 @@
+#ifndef _NODE_MGR_H_
+#define _NODE_MGR_H_
+
+#include <stdbool.h>
+#include "CANopen.h"
+
+int node_enable(uint8_t id, bool enable);
+int node_status(uint8_t id, CO_NMT_internalState_t *state);
+
+#endif /* _NODE_MGR_H_ */
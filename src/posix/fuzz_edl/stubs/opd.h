@@ -0,0 +1,24 @@
+#ifndef _OPD_H_
+#define _OPD_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+typedef uint16_t i2caddr_t;
+
+typedef struct {
+    uint8_t input;
+    uint8_t odr;
+    uint8_t pol;
+    uint8_t mode;
+    uint8_t timeout;
+} opd_status_t;
+
+void opd_start(void);
+void opd_stop(void);
+void opd_scan(bool restart);
+int opd_enable(i2caddr_t addr, bool enable);
+int opd_reset(i2caddr_t addr);
+int opd_status(i2caddr_t addr, opd_status_t *status);
+
+#endif /* _OPD_H_ */
@@ -0,0 +1,10 @@
+#ifndef _RTC_H_
+#define _RTC_H_
+
+#include <stdint.h>
+#include <time.h>
+
+time_t rtcGetTimeUnix(uint32_t *msec);
+void rtcSetTimeUnix(time_t unix_time, uint32_t msec);
+
+#endif /* _RTC_H_ */
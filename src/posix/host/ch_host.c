@@ -0,0 +1,1193 @@
+/**
+ * @file    ch_host.c
+ * @brief   ChibiOS/RT subset for host builds.
+ * @details Every thread is a ucontext coroutine with its own host stack.
+ *          Switching happens only inside kernel calls, so the kernel lock
+ *          is a no-op. When no thread is ready the scheduler moves virtual
+ *          time to the first armed timer and runs its callback as an ISR
+ *          would, then looks again. With nothing ready and no timer armed
+ *          the system is deadlocked, the run stops with a thread dump.
+ *
+ * @addtogroup HOST_CH
+ * @{
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ucontext.h>
+#include "ch.h"
+
+/*===========================================================================*/
+/* Kernel local definitions.                                                 */
+/*===========================================================================*/
+
+#define US_PER_TICK                         (1000000U / CH_CFG_ST_FREQUENCY)
+
+/*===========================================================================*/
+/* Kernel local variables and types.                                         */
+/*===========================================================================*/
+
+/* Absolute tick count, systime_t is its low word and wraps like the target */
+static uint64_t ch_now;
+
+static thread_t ch_main;
+static ucontext_t ch_main_ctx;
+static thread_t *ch_current = &ch_main;
+static threads_queue_t ch_rlist;
+static virtual_timer_t *ch_vtlist;
+
+/* Nesting of ISR context, where threads may only be readied */
+static unsigned ch_isr;
+
+/* Heap allocations fail while set, as with the heap exhausted */
+static bool ch_heap_full;
+
+/* Every thread ever created, for the deadlock dump */
+#define CH_REGISTRY_MAX                     64U
+static thread_t *ch_registry[CH_REGISTRY_MAX];
+static unsigned ch_registry_n;
+
+/*===========================================================================*/
+/* Kernel local functions.                                                   */
+/*===========================================================================*/
+
+static const char *state_name(tstate_t state) {
+    static const char *const names[] = {
+        "READY", "CURRENT", "WTSTART", "SUSPENDED", "QUEUED", "WTSEM",
+        "WTMTX", "WTCOND", "SLEEPING", "WTEXIT", "WTOREVT", "WTANDEVT",
+        "SNDMSGQ", "SNDMSG", "WTMSG", "FINAL",
+    };
+
+    return state < sizeof(names) / sizeof(names[0]) ? names[state] : "?";
+}
+
+/* Priority order, FIFO among equals */
+static void queue_insert(threads_queue_t *tqp, thread_t *tp) {
+    thread_t **pp = &tqp->head;
+
+    while (*pp != NULL && (*pp)->prio >= tp->prio) {
+        pp = &(*pp)->queue_next;
+    }
+    tp->queue_next = *pp;
+    *pp = tp;
+    tp->queue = tqp;
+}
+
+/* Ahead of the threads of the same priority */
+static void queue_insert_ahead(threads_queue_t *tqp, thread_t *tp) {
+    thread_t **pp = &tqp->head;
+
+    while (*pp != NULL && (*pp)->prio > tp->prio) {
+        pp = &(*pp)->queue_next;
+    }
+    tp->queue_next = *pp;
+    *pp = tp;
+    tp->queue = tqp;
+}
+
+static void queue_remove(thread_t *tp) {
+    threads_queue_t *tqp = tp->queue;
+
+    if (tqp != NULL) {
+        for (thread_t **pp = &tqp->head; *pp != NULL; pp = &(*pp)->queue_next) {
+            if (*pp == tp) {
+                *pp = tp->queue_next;
+                break;
+            }
+        }
+        tp->queue = NULL;
+        tp->queue_next = NULL;
+    }
+}
+
+static thread_t *queue_fetch(threads_queue_t *tqp) {
+    thread_t *tp = tqp->head;
+
+    if (tp != NULL) {
+        tqp->head = tp->queue_next;
+        tp->queue = NULL;
+        tp->queue_next = NULL;
+    }
+    return tp;
+}
+
+static void vt_insert(virtual_timer_t *vtp) {
+    virtual_timer_t **pp = &ch_vtlist;
+
+    while (*pp != NULL && (*pp)->deadline <= vtp->deadline) {
+        pp = &(*pp)->next;
+    }
+    vtp->next = *pp;
+    *pp = vtp;
+    vtp->armed = true;
+}
+
+static void vt_remove(virtual_timer_t *vtp) {
+    for (virtual_timer_t **pp = &ch_vtlist; *pp != NULL; pp = &(*pp)->next) {
+        if (*pp == vtp) {
+            *pp = vtp->next;
+            break;
+        }
+    }
+    vtp->next = NULL;
+    vtp->armed = false;
+}
+
+/* Fires the first timer, moving time up to it. False when none is armed */
+static bool vt_fire_next(void) {
+    virtual_timer_t *vtp = ch_vtlist;
+
+    if (vtp == NULL) {
+        return false;
+    }
+    if (vtp->deadline > ch_now) {
+        ch_now = vtp->deadline;
+    }
+    vt_remove(vtp);
+    ch_isr++;
+    vtp->func(vtp->par);
+    ch_isr--;
+    return true;
+}
+
+static void wakeup_timeout(void *p) {
+    thread_t *tp = p;
+
+    /* Anything still waiting gives up its place and sees the timeout */
+    queue_remove(tp);
+    tp->rdymsg = MSG_TIMEOUT;
+    chSchReadyI(tp);
+}
+
+static void thread_switch(thread_t *otp, thread_t *ntp) {
+    ch_current = ntp;
+    ntp->state = CH_STATE_CURRENT;
+    if (ntp != otp) {
+        swapcontext(otp->ctx, ntp->ctx);
+    }
+}
+
+/* Next thread to run, advancing time until one is ready */
+static thread_t *next_ready(void) {
+    while (ch_rlist.head == NULL) {
+        if (!vt_fire_next()) {
+            fprintf(stderr, "ch_host: deadlock at %lu ticks\n", (unsigned long)ch_now);
+            chHostDumpThreads();
+            abort();
+        }
+    }
+    /* As the tick interrupt would, run every other timer that is due too */
+    while (ch_vtlist != NULL && ch_vtlist->deadline <= ch_now) {
+        vt_fire_next();
+    }
+    return queue_fetch(&ch_rlist);
+}
+
+static void thread_entry(void) {
+    thread_t *tp = ch_current;
+
+    tp->func(tp->arg);
+    chThdExit(MSG_OK);
+}
+
+static thread_t *thread_create(const char *name, tprio_t prio, tfunc_t pf, void *arg, bool heap) {
+    thread_t *tp = calloc(1, sizeof(thread_t));
+    ucontext_t *ctx = calloc(1, sizeof(ucontext_t));
+
+    chDbgAssert(tp != NULL && ctx != NULL, "out of memory");
+    tp->name = name;
+    tp->prio = prio;
+    tp->state = CH_STATE_WTSTART;
+    tp->refs = 1;
+    tp->heap = heap;
+    tp->func = pf;
+    tp->arg = arg;
+    tp->ctx = ctx;
+    tp->stack = malloc(CH_HOST_STACK_SIZE);
+    chDbgAssert(tp->stack != NULL, "out of memory");
+    getcontext(ctx);
+    ctx->uc_stack.ss_sp = tp->stack;
+    ctx->uc_stack.ss_size = CH_HOST_STACK_SIZE;
+    ctx->uc_link = NULL;
+    makecontext(ctx, thread_entry, 0);
+    if (ch_registry_n < CH_REGISTRY_MAX) {
+        ch_registry[ch_registry_n++] = tp;
+    }
+
+    /* Same as chThdCreateI followed by chSchWakeupS */
+    chSchWakeupS(tp, MSG_OK);
+    return tp;
+}
+
+/*===========================================================================*/
+/* System.                                                                   */
+/*===========================================================================*/
+
+/**
+ * @brief   Turns main() into the first thread at NORMALPRIO.
+ */
+void chSysInit(void) {
+    ch_main.name = "main";
+    ch_main.prio = NORMALPRIO;
+    ch_main.state = CH_STATE_CURRENT;
+    ch_main.refs = 1;
+    ch_main.ctx = &ch_main_ctx;
+    ch_current = &ch_main;
+    ch_rlist.head = NULL;
+    ch_vtlist = NULL;
+    ch_registry_n = 0;
+    ch_registry[ch_registry_n++] = &ch_main;
+}
+
+/**
+ * @brief   Stops the run on a failed assertion or a kernel misuse.
+ */
+void chSysHalt(const char *reason) {
+    fprintf(stderr, "ch_host: halt in thread %s at %lu ticks: %s\n",
+            ch_current->name ? ch_current->name : "?", (unsigned long)ch_now, reason);
+    abort();
+}
+
+/**
+ * @brief   Realtime counter at @p CH_HOST_RT_FREQUENCY.
+ * @note    Follows virtual time, so it measures simulated waits and not
+ *          host CPU time.
+ */
+rtcnt_t chSysGetRealtimeCounterX(void) {
+    return (rtcnt_t)(chHostTimeUS() * (CH_HOST_RT_FREQUENCY / 1000000U));
+}
+
+void chSysPolledDelayX(rtcnt_t cycles) {
+    (void)cycles;
+}
+
+/*===========================================================================*/
+/* Host control.                                                             */
+/*===========================================================================*/
+
+/**
+ * @brief   Sets the system time, for runs that start close to a wrap.
+ * @note    Call before anything is armed.
+ */
+void chHostSetSystemTime(systime_t time) {
+    ch_now = (ch_now & ~(uint64_t)UINT32_MAX) | time;
+}
+
+/**
+ * @brief   Exhausts the heap or gives it back: while @p full is set
+ *          @p chHeapAlloc() and @p chThdCreateFromHeap() return NULL.
+ */
+void chHostSetHeapFull(bool full) {
+    ch_heap_full = full;
+}
+
+/**
+ * @brief   Simulated time since start in microseconds, never wraps.
+ */
+uint64_t chHostTimeUS(void) {
+    return ch_now * US_PER_TICK;
+}
+
+/**
+ * @brief   Enters ISR context from a thread, for models that raise
+ *          interrupts synchronously.
+ */
+void chHostISREnter(void) {
+    ch_isr++;
+}
+
+/**
+ * @brief   Leaves ISR context, switching to a higher priority thread the
+ *          ISR readied.
+ */
+void chHostISRExit(void) {
+    chDbgAssert(ch_isr > 0U, "not in ISR");
+    if (--ch_isr == 0U) {
+        chSchRescheduleS();
+    }
+}
+
+/**
+ * @brief   Prints every thread with its state and priority.
+ */
+void chHostDumpThreads(void) {
+    for (unsigned i = 0; i < ch_registry_n; i++) {
+        thread_t *tp = ch_registry[i];
+        fprintf(stderr, "  %-16s prio %3u %s\n", tp->name ? tp->name : "?",
+                (unsigned)tp->prio, state_name(tp->state));
+    }
+}
+
+/*===========================================================================*/
+/* Virtual timers.                                                           */
+/*===========================================================================*/
+
+systime_t chVTGetSystemTimeX(void) {
+    return (systime_t)ch_now;
+}
+
+void chVTSetI(virtual_timer_t *vtp, sysinterval_t delay, vtfunc_t vtfunc, void *par) {
+    chDbgCheck(vtp != NULL && vtfunc != NULL && delay != TIME_IMMEDIATE);
+
+    if (vtp->armed) {
+        vt_remove(vtp);
+    }
+    vtp->deadline = ch_now + delay;
+    vtp->func = vtfunc;
+    vtp->par = par;
+    vt_insert(vtp);
+}
+
+void chVTResetI(virtual_timer_t *vtp) {
+    if (vtp->armed) {
+        vt_remove(vtp);
+    }
+}
+
+void chVTDoResetI(virtual_timer_t *vtp) {
+    chVTResetI(vtp);
+}
+
+/*===========================================================================*/
+/* Scheduler.                                                                */
+/*===========================================================================*/
+
+thread_t *chSchReadyI(thread_t *tp) {
+    chDbgAssert(tp->state != CH_STATE_READY && tp->state != CH_STATE_FINAL,
+                "invalid state");
+    if (tp->timeout.armed) {
+        vt_remove(&tp->timeout);
+    }
+    tp->state = CH_STATE_READY;
+    queue_insert(&ch_rlist, tp);
+    return tp;
+}
+
+void chSchGoSleepS(tstate_t newstate) {
+    thread_t *otp = ch_current;
+
+    otp->state = newstate;
+    thread_switch(otp, next_ready());
+}
+
+msg_t chSchGoSleepTimeoutS(tstate_t newstate, sysinterval_t timeout) {
+    thread_t *tp = ch_current;
+
+    if (timeout == TIME_IMMEDIATE) {
+        queue_remove(tp);
+        return MSG_TIMEOUT;
+    }
+    if (timeout != TIME_INFINITE) {
+        tp->timeout.deadline = ch_now + timeout;
+        tp->timeout.func = wakeup_timeout;
+        tp->timeout.par = tp;
+        vt_insert(&tp->timeout);
+    }
+    chSchGoSleepS(newstate);
+    return tp->rdymsg;
+}
+
+void chSchWakeupS(thread_t *ntp, msg_t msg) {
+    thread_t *otp = ch_current;
+
+    ntp->rdymsg = msg;
+    if (ch_isr || ntp->prio <= otp->prio) {
+        chSchReadyI(ntp);
+    } else {
+        if (ntp->timeout.armed) {
+            vt_remove(&ntp->timeout);
+        }
+        otp->state = CH_STATE_READY;
+        queue_insert_ahead(&ch_rlist, otp);
+        thread_switch(otp, ntp);
+    }
+}
+
+void chSchRescheduleS(void) {
+    thread_t *otp = ch_current;
+
+    if (!ch_isr && ch_rlist.head != NULL && ch_rlist.head->prio > otp->prio) {
+        otp->state = CH_STATE_READY;
+        queue_insert_ahead(&ch_rlist, otp);
+        thread_switch(otp, queue_fetch(&ch_rlist));
+    }
+}
+
+/*===========================================================================*/
+/* Threads.                                                                  */
+/*===========================================================================*/
+
+thread_t *chThdCreateStatic(void *wsp, size_t size, tprio_t prio, tfunc_t pf, void *arg) {
+    (void)wsp;
+    (void)size;
+    return thread_create(NULL, prio, pf, arg, false);
+}
+
+thread_t *chThdCreateFromHeap(memory_heap_t *heapp, size_t size, const char *name,
+                              tprio_t prio, tfunc_t pf, void *arg) {
+    (void)heapp;
+    (void)size;
+    if (ch_heap_full) {
+        return NULL;
+    }
+    return thread_create(name, prio, pf, arg, true);
+}
+
+thread_t *chThdCreate(const thread_descriptor_t *tdp) {
+    return thread_create(tdp->name, tdp->prio, tdp->funcp, tdp->arg, false);
+}
+
+thread_t *chThdGetSelfX(void) {
+    return ch_current;
+}
+
+tprio_t chThdSetPriority(tprio_t newprio) {
+    tprio_t oldprio = ch_current->prio;
+
+    ch_current->prio = newprio;
+    chSchRescheduleS();
+    return oldprio;
+}
+
+void chThdTerminate(thread_t *tp) {
+    tp->terminate = true;
+}
+
+bool chThdShouldTerminateX(void) {
+    return ch_current->terminate;
+}
+
+msg_t chThdWait(thread_t *tp) {
+    msg_t msg;
+
+    chDbgAssert(tp != ch_current, "waiting self");
+    if (tp->state != CH_STATE_FINAL) {
+        queue_insert(&tp->waiting, ch_current);
+        chSchGoSleepS(CH_STATE_WTEXIT);
+    }
+    msg = tp->exitcode;
+    chThdRelease(tp);
+    return msg;
+}
+
+void chThdRelease(thread_t *tp) {
+    chDbgAssert(tp->refs > 0, "not referenced");
+    if (--tp->refs == 0 && tp->state == CH_STATE_FINAL) {
+        /* The thread is not running, its stack can go */
+        free(tp->stack);
+        tp->stack = NULL;
+    }
+}
+
+void chThdExit(msg_t msg) {
+    chThdExitS(msg);
+}
+
+void chThdExitS(msg_t msg) {
+    thread_t *tp = ch_current;
+    thread_t *wtp;
+
+    chDbgAssert(tp->mtxlist == NULL, "exiting with mutexes held");
+    tp->exitcode = msg;
+    while ((wtp = queue_fetch(&tp->waiting)) != NULL) {
+        wtp->rdymsg = MSG_OK;
+        chSchReadyI(wtp);
+    }
+    chSchGoSleepS(CH_STATE_FINAL);
+    chSysHalt("exited thread resumed");
+}
+
+void chThdSleep(sysinterval_t time) {
+    chThdSleepS(time);
+}
+
+void chThdSleepS(sysinterval_t time) {
+    chDbgCheck(time != TIME_IMMEDIATE);
+    (void)chSchGoSleepTimeoutS(CH_STATE_SLEEPING, time);
+}
+
+void chThdSleepUntil(systime_t time) {
+    sysinterval_t interval = chTimeDiffX(chVTGetSystemTimeX(), time);
+
+    if (interval > (sysinterval_t)0) {
+        chThdSleepS(interval);
+    }
+}
+
+systime_t chThdSleepUntilWindowed(systime_t prev, systime_t next) {
+    systime_t time = chVTGetSystemTimeX();
+
+    if (chTimeIsInRangeX(time, prev, next)) {
+        chThdSleepS(chTimeDiffX(time, next));
+    }
+    return next;
+}
+
+void chThdYield(void) {
+    thread_t *otp = ch_current;
+
+    if (ch_rlist.head != NULL && ch_rlist.head->prio >= otp->prio) {
+        otp->state = CH_STATE_READY;
+        queue_insert(&ch_rlist, otp);
+        thread_switch(otp, queue_fetch(&ch_rlist));
+    }
+}
+
+msg_t chThdSuspendS(thread_reference_t *trp) {
+    return chThdSuspendTimeoutS(trp, TIME_INFINITE);
+}
+
+msg_t chThdSuspendTimeoutS(thread_reference_t *trp, sysinterval_t timeout) {
+    msg_t msg;
+
+    chDbgAssert(*trp == NULL, "not NULL");
+    if (timeout == TIME_IMMEDIATE) {
+        return MSG_TIMEOUT;
+    }
+    *trp = ch_current;
+    msg = chSchGoSleepTimeoutS(CH_STATE_SUSPENDED, timeout);
+    *trp = NULL;
+    return msg;
+}
+
+void chThdResumeI(thread_reference_t *trp, msg_t msg) {
+    if (*trp != NULL) {
+        thread_t *tp = *trp;
+        *trp = NULL;
+        tp->rdymsg = msg;
+        chSchReadyI(tp);
+    }
+}
+
+void chThdResumeS(thread_reference_t *trp, msg_t msg) {
+    if (*trp != NULL) {
+        thread_t *tp = *trp;
+        *trp = NULL;
+        chSchWakeupS(tp, msg);
+    }
+}
+
+void chThdResume(thread_reference_t *trp, msg_t msg) {
+    chThdResumeS(trp, msg);
+}
+
+msg_t chThdEnqueueTimeoutS(threads_queue_t *tqp, sysinterval_t timeout) {
+    if (timeout == TIME_IMMEDIATE) {
+        return MSG_TIMEOUT;
+    }
+    queue_insert(tqp, ch_current);
+    return chSchGoSleepTimeoutS(CH_STATE_QUEUED, timeout);
+}
+
+void chThdDequeueNextI(threads_queue_t *tqp, msg_t msg) {
+    thread_t *tp = queue_fetch(tqp);
+
+    if (tp != NULL) {
+        tp->rdymsg = msg;
+        chSchReadyI(tp);
+    }
+}
+
+void chThdDequeueAllI(threads_queue_t *tqp, msg_t msg) {
+    while (tqp->head != NULL) {
+        chThdDequeueNextI(tqp, msg);
+    }
+}
+
+/*===========================================================================*/
+/* Mutexes.                                                                  */
+/*===========================================================================*/
+
+void chMtxLock(mutex_t *mp) {
+    thread_t *ctp = ch_current;
+
+    chDbgAssert(!ch_isr, "lock from ISR");
+    chDbgAssert(mp->owner != ctp, "recursive lock");
+    if (mp->owner != NULL) {
+        queue_insert(&mp->queue, ctp);
+        chSchGoSleepS(CH_STATE_WTMTX);
+        chDbgAssert(mp->owner == ctp, "not owner");
+    } else {
+        mp->owner = ctp;
+    }
+    mp->next = ctp->mtxlist;
+    ctp->mtxlist = mp;
+}
+
+bool chMtxTryLock(mutex_t *mp) {
+    return chMtxTryLockS(mp);
+}
+
+bool chMtxTryLockS(mutex_t *mp) {
+    if (mp->owner != NULL) {
+        return false;
+    }
+    mp->owner = ch_current;
+    mp->next = ch_current->mtxlist;
+    ch_current->mtxlist = mp;
+    return true;
+}
+
+void chMtxUnlock(mutex_t *mp) {
+    thread_t *tp;
+
+    chDbgAssert(mp->owner == ch_current, "not owner");
+    chDbgAssert(ch_current->mtxlist == mp, "not next in list");
+    ch_current->mtxlist = mp->next;
+    tp = queue_fetch(&mp->queue);
+    mp->owner = tp;
+    if (tp != NULL) {
+        chSchWakeupS(tp, MSG_OK);
+    }
+}
+
+void chMtxUnlockAll(void) {
+    while (ch_current->mtxlist != NULL) {
+        chMtxUnlock(ch_current->mtxlist);
+    }
+}
+
+/*===========================================================================*/
+/* Semaphores.                                                               */
+/*===========================================================================*/
+
+msg_t chSemWaitTimeout(semaphore_t *sp, sysinterval_t timeout) {
+    return chSemWaitTimeoutS(sp, timeout);
+}
+
+msg_t chSemWaitTimeoutS(semaphore_t *sp, sysinterval_t timeout) {
+    msg_t msg;
+
+    if (--sp->cnt >= (cnt_t)0) {
+        return MSG_OK;
+    }
+    if (timeout == TIME_IMMEDIATE) {
+        sp->cnt++;
+        return MSG_TIMEOUT;
+    }
+    queue_insert(&sp->queue, ch_current);
+    msg = chSchGoSleepTimeoutS(CH_STATE_WTSEM, timeout);
+    if (msg == MSG_TIMEOUT) {
+        sp->cnt++;
+    }
+    return msg;
+}
+
+void chSemSignal(semaphore_t *sp) {
+    if (++sp->cnt <= (cnt_t)0) {
+        chSchWakeupS(queue_fetch(&sp->queue), MSG_OK);
+    }
+}
+
+void chSemSignalI(semaphore_t *sp) {
+    if (++sp->cnt <= (cnt_t)0) {
+        thread_t *tp = queue_fetch(&sp->queue);
+        tp->rdymsg = MSG_OK;
+        chSchReadyI(tp);
+    }
+}
+
+void chSemReset(semaphore_t *sp, cnt_t n) {
+    chSemResetI(sp, n);
+    chSchRescheduleS();
+}
+
+void chSemResetI(semaphore_t *sp, cnt_t n) {
+    sp->cnt = n;
+    while (sp->queue.head != NULL) {
+        chThdDequeueNextI(&sp->queue, MSG_RESET);
+    }
+}
+
+msg_t chBSemWaitTimeout(binary_semaphore_t *bsp, sysinterval_t timeout) {
+    return chSemWaitTimeoutS(&bsp->sem, timeout);
+}
+
+void chBSemSignal(binary_semaphore_t *bsp) {
+    if (bsp->sem.cnt < (cnt_t)1) {
+        chSemSignal(&bsp->sem);
+    }
+}
+
+void chBSemSignalI(binary_semaphore_t *bsp) {
+    if (bsp->sem.cnt < (cnt_t)1) {
+        chSemSignalI(&bsp->sem);
+    }
+}
+
+void chBSemReset(binary_semaphore_t *bsp, bool taken) {
+    chSemReset(&bsp->sem, taken ? (cnt_t)0 : (cnt_t)1);
+}
+
+void chBSemResetI(binary_semaphore_t *bsp, bool taken) {
+    chSemResetI(&bsp->sem, taken ? (cnt_t)0 : (cnt_t)1);
+}
+
+/*===========================================================================*/
+/* Events.                                                                   */
+/*===========================================================================*/
+
+void chEvtRegisterMaskWithFlags(event_source_t *esp, event_listener_t *elp,
+                                eventmask_t events, eventflags_t wflags) {
+    elp->next = esp->next;
+    esp->next = elp;
+    elp->listener = ch_current;
+    elp->events = events;
+    elp->flags = (eventflags_t)0;
+    elp->wflags = wflags;
+}
+
+void chEvtUnregister(event_source_t *esp, event_listener_t *elp) {
+    for (event_listener_t **pp = &esp->next; *pp != NULL; pp = &(*pp)->next) {
+        if (*pp == elp) {
+            *pp = elp->next;
+            break;
+        }
+    }
+}
+
+eventmask_t chEvtGetAndClearEventsI(eventmask_t events) {
+    eventmask_t m = ch_current->epending & events;
+
+    ch_current->epending &= ~events;
+    return m;
+}
+
+eventmask_t chEvtAddEvents(eventmask_t events) {
+    return ch_current->epending |= events;
+}
+
+eventflags_t chEvtGetAndClearFlags(event_listener_t *elp) {
+    return chEvtGetAndClearFlagsI(elp);
+}
+
+eventflags_t chEvtGetAndClearFlagsI(event_listener_t *elp) {
+    eventflags_t flags = elp->flags;
+
+    elp->flags = (eventflags_t)0;
+    return flags;
+}
+
+void chEvtSignalI(thread_t *tp, eventmask_t events) {
+    tp->epending |= events;
+    if ((tp->state == CH_STATE_WTOREVT && (tp->epending & tp->ewmask) != 0U) ||
+        (tp->state == CH_STATE_WTANDEVT && (tp->epending & tp->ewmask) == tp->ewmask)) {
+        tp->rdymsg = MSG_OK;
+        chSchReadyI(tp);
+    }
+}
+
+void chEvtSignal(thread_t *tp, eventmask_t events) {
+    chEvtSignalI(tp, events);
+    chSchRescheduleS();
+}
+
+void chEvtBroadcastFlagsI(event_source_t *esp, eventflags_t flags) {
+    for (event_listener_t *elp = esp->next; elp != NULL; elp = elp->next) {
+        elp->flags |= flags;
+        if (flags == (eventflags_t)0 || (flags & elp->wflags) != (eventflags_t)0) {
+            chEvtSignalI(elp->listener, elp->events);
+        }
+    }
+}
+
+void chEvtBroadcastFlags(event_source_t *esp, eventflags_t flags) {
+    chEvtBroadcastFlagsI(esp, flags);
+    chSchRescheduleS();
+}
+
+void chEvtDispatch(const evhandler_t *handlers, eventmask_t events) {
+    eventid_t eid = 0;
+
+    while (events != 0U) {
+        if ((events & EVENT_MASK(eid)) != 0U) {
+            events &= ~EVENT_MASK(eid);
+            handlers[eid](eid);
+        }
+        eid++;
+    }
+}
+
+static eventmask_t evt_wait(eventmask_t events, sysinterval_t timeout, bool all) {
+    thread_t *ctp = ch_current;
+    eventmask_t m;
+
+    m = ctp->epending & events;
+    if (all ? m != events : m == 0U) {
+        if (timeout == TIME_IMMEDIATE) {
+            return (eventmask_t)0;
+        }
+        ctp->ewmask = events;
+        if (chSchGoSleepTimeoutS(all ? CH_STATE_WTANDEVT : CH_STATE_WTOREVT, timeout) < MSG_OK) {
+            return (eventmask_t)0;
+        }
+        m = ctp->epending & events;
+    }
+    return m;
+}
+
+eventmask_t chEvtWaitOne(eventmask_t events) {
+    return chEvtWaitOneTimeout(events, TIME_INFINITE);
+}
+
+eventmask_t chEvtWaitAny(eventmask_t events) {
+    return chEvtWaitAnyTimeout(events, TIME_INFINITE);
+}
+
+eventmask_t chEvtWaitAll(eventmask_t events) {
+    return chEvtWaitAllTimeout(events, TIME_INFINITE);
+}
+
+eventmask_t chEvtWaitOneTimeout(eventmask_t events, sysinterval_t timeout) {
+    eventmask_t m = evt_wait(events, timeout, false);
+
+    m ^= m & (m - 1U);
+    ch_current->epending &= ~m;
+    return m;
+}
+
+eventmask_t chEvtWaitAnyTimeout(eventmask_t events, sysinterval_t timeout) {
+    eventmask_t m = evt_wait(events, timeout, false);
+
+    ch_current->epending &= ~m;
+    return m;
+}
+
+eventmask_t chEvtWaitAllTimeout(eventmask_t events, sysinterval_t timeout) {
+    eventmask_t m = evt_wait(events, timeout, true);
+
+    ch_current->epending &= ~m;
+    return m;
+}
+
+/*===========================================================================*/
+/* Mailboxes.                                                                */
+/*===========================================================================*/
+
+void chMBObjectInit(mailbox_t *mbp, msg_t *buf, size_t n) {
+    mbp->buffer = buf;
+    mbp->rdptr = buf;
+    mbp->wrptr = buf;
+    mbp->top = &buf[n];
+    mbp->cnt = 0;
+    mbp->reset = false;
+    mbp->qw.head = NULL;
+    mbp->qr.head = NULL;
+}
+
+void chMBReset(mailbox_t *mbp) {
+    chMBResetI(mbp);
+    chSchRescheduleS();
+}
+
+void chMBResetI(mailbox_t *mbp) {
+    mbp->wrptr = mbp->buffer;
+    mbp->rdptr = mbp->buffer;
+    mbp->cnt = 0;
+    mbp->reset = true;
+    chThdDequeueAllI(&mbp->qw, MSG_RESET);
+    chThdDequeueAllI(&mbp->qr, MSG_RESET);
+}
+
+static msg_t mb_wait_free(mailbox_t *mbp, sysinterval_t timeout) {
+    msg_t rdymsg;
+
+    do {
+        if (mbp->reset) {
+            return MSG_RESET;
+        }
+        if (chMBGetFreeCountI(mbp) > 0U) {
+            return MSG_OK;
+        }
+        rdymsg = chThdEnqueueTimeoutS(&mbp->qw, timeout);
+    } while (rdymsg == MSG_OK);
+    return rdymsg;
+}
+
+msg_t chMBPostTimeout(mailbox_t *mbp, msg_t msg, sysinterval_t timeout) {
+    msg_t rdymsg = mb_wait_free(mbp, timeout);
+
+    if (rdymsg == MSG_OK) {
+        *mbp->wrptr++ = msg;
+        if (mbp->wrptr >= mbp->top) {
+            mbp->wrptr = mbp->buffer;
+        }
+        mbp->cnt++;
+        chThdDequeueNextI(&mbp->qr, MSG_OK);
+        chSchRescheduleS();
+    }
+    return rdymsg;
+}
+
+msg_t chMBPostI(mailbox_t *mbp, msg_t msg) {
+    if (mbp->reset) {
+        return MSG_RESET;
+    }
+    if (chMBGetFreeCountI(mbp) == 0U) {
+        return MSG_TIMEOUT;
+    }
+    *mbp->wrptr++ = msg;
+    if (mbp->wrptr >= mbp->top) {
+        mbp->wrptr = mbp->buffer;
+    }
+    mbp->cnt++;
+    chThdDequeueNextI(&mbp->qr, MSG_OK);
+    return MSG_OK;
+}
+
+msg_t chMBPostAheadTimeout(mailbox_t *mbp, msg_t msg, sysinterval_t timeout) {
+    msg_t rdymsg = mb_wait_free(mbp, timeout);
+
+    if (rdymsg == MSG_OK) {
+        if (--mbp->rdptr < mbp->buffer) {
+            mbp->rdptr = mbp->top - 1;
+        }
+        *mbp->rdptr = msg;
+        mbp->cnt++;
+        chThdDequeueNextI(&mbp->qr, MSG_OK);
+        chSchRescheduleS();
+    }
+    return rdymsg;
+}
+
+msg_t chMBPostAheadI(mailbox_t *mbp, msg_t msg) {
+    if (mbp->reset) {
+        return MSG_RESET;
+    }
+    if (chMBGetFreeCountI(mbp) == 0U) {
+        return MSG_TIMEOUT;
+    }
+    if (--mbp->rdptr < mbp->buffer) {
+        mbp->rdptr = mbp->top - 1;
+    }
+    *mbp->rdptr = msg;
+    mbp->cnt++;
+    chThdDequeueNextI(&mbp->qr, MSG_OK);
+    return MSG_OK;
+}
+
+msg_t chMBFetchTimeout(mailbox_t *mbp, msg_t *msgp, sysinterval_t timeout) {
+    msg_t rdymsg;
+
+    do {
+        if (mbp->reset) {
+            return MSG_RESET;
+        }
+        if (mbp->cnt > 0U) {
+            *msgp = *mbp->rdptr++;
+            if (mbp->rdptr >= mbp->top) {
+                mbp->rdptr = mbp->buffer;
+            }
+            mbp->cnt--;
+            chThdDequeueNextI(&mbp->qw, MSG_OK);
+            chSchRescheduleS();
+            return MSG_OK;
+        }
+        rdymsg = chThdEnqueueTimeoutS(&mbp->qr, timeout);
+    } while (rdymsg == MSG_OK);
+    return rdymsg;
+}
+
+msg_t chMBFetchI(mailbox_t *mbp, msg_t *msgp) {
+    if (mbp->reset) {
+        return MSG_RESET;
+    }
+    if (mbp->cnt == 0U) {
+        return MSG_TIMEOUT;
+    }
+    *msgp = *mbp->rdptr++;
+    if (mbp->rdptr >= mbp->top) {
+        mbp->rdptr = mbp->buffer;
+    }
+    mbp->cnt--;
+    chThdDequeueNextI(&mbp->qw, MSG_OK);
+    return MSG_OK;
+}
+
+/*===========================================================================*/
+/* Memory.                                                                   */
+/*===========================================================================*/
+
+void *chCoreAlloc(size_t size) {
+    return calloc(1, size);
+}
+
+void *chCoreAllocAligned(size_t size, unsigned align) {
+    void *p = NULL;
+
+    if (posix_memalign(&p, align < sizeof(void *) ? sizeof(void *) : align, size) != 0) {
+        return NULL;
+    }
+    return memset(p, 0, size);
+}
+
+void *chHeapAlloc(memory_heap_t *heapp, size_t size) {
+    (void)heapp;
+    if (ch_heap_full) {
+        return NULL;
+    }
+    return malloc(size);
+}
+
+void *chHeapAllocAligned(memory_heap_t *heapp, size_t size, unsigned align) {
+    (void)heapp;
+    if (ch_heap_full) {
+        return NULL;
+    }
+    return chCoreAllocAligned(size, align);
+}
+
+void chHeapFree(void *p) {
+    free(p);
+}
+
+void chPoolObjectInit(memory_pool_t *mp, size_t size, memgetfunc_t provider) {
+    chPoolObjectInitAligned(mp, size, sizeof(void *), provider);
+}
+
+void chPoolObjectInitAligned(memory_pool_t *mp, size_t size, unsigned align,
+                             memgetfunc_t provider) {
+    chDbgCheck(size >= sizeof(void *));
+    mp->next = NULL;
+    mp->object_size = size;
+    mp->align = align;
+    mp->provider = provider;
+}
+
+void chPoolLoadArray(memory_pool_t *mp, void *p, size_t n) {
+    while (n != 0U) {
+        chPoolFreeI(mp, p);
+        p = (uint8_t *)p + mp->object_size;
+        n--;
+    }
+}
+
+void *chPoolAlloc(memory_pool_t *mp) {
+    return chPoolAllocI(mp);
+}
+
+void *chPoolAllocI(memory_pool_t *mp) {
+    void *objp = mp->next;
+
+    if (objp != NULL) {
+        mp->next = mp->next->next;
+    } else if (mp->provider != NULL) {
+        objp = mp->provider(mp->object_size, mp->align);
+    }
+    return objp;
+}
+
+void chPoolFree(memory_pool_t *mp, void *objp) {
+    chPoolFreeI(mp, objp);
+}
+
+void chPoolFreeI(memory_pool_t *mp, void *objp) {
+    struct pool_header *php = objp;
+
+    php->next = mp->next;
+    mp->next = php;
+}
+
+void chGuardedPoolObjectInit(guarded_memory_pool_t *gmp, size_t size) {
+    chGuardedPoolObjectInitAligned(gmp, size, sizeof(void *));
+}
+
+void chGuardedPoolObjectInitAligned(guarded_memory_pool_t *gmp, size_t size, unsigned align) {
+    chPoolObjectInitAligned(&gmp->pool, size, align, NULL);
+    chSemObjectInit(&gmp->sem, (cnt_t)0);
+}
+
+void chGuardedPoolLoadArray(guarded_memory_pool_t *gmp, void *p, size_t n) {
+    while (n != 0U) {
+        chGuardedPoolFreeI(gmp, p);
+        p = (uint8_t *)p + gmp->pool.object_size;
+        n--;
+    }
+}
+
+void *chGuardedPoolAllocTimeout(guarded_memory_pool_t *gmp, sysinterval_t timeout) {
+    return chGuardedPoolAllocTimeoutS(gmp, timeout);
+}
+
+void *chGuardedPoolAllocTimeoutS(guarded_memory_pool_t *gmp, sysinterval_t timeout) {
+    if (chSemWaitTimeoutS(&gmp->sem, timeout) != MSG_OK) {
+        return NULL;
+    }
+    return chPoolAllocI(&gmp->pool);
+}
+
+void chGuardedPoolFree(guarded_memory_pool_t *gmp, void *objp) {
+    chGuardedPoolFreeI(gmp, objp);
+    chSchRescheduleS();
+}
+
+void chGuardedPoolFreeI(guarded_memory_pool_t *gmp, void *objp) {
+    chPoolFreeI(&gmp->pool, objp);
+    chSemSignalI(&gmp->sem);
+}
+
+/*===========================================================================*/
+/* Objects FIFOs.                                                            */
+/*===========================================================================*/
+
+void chFifoObjectInit(objects_fifo_t *ofp, size_t objsize, size_t objn,
+                      void *objbuf, msg_t *msgbuf) {
+    chFifoObjectInitAligned(ofp, objsize, objn, sizeof(void *), objbuf, msgbuf);
+}
+
+void chFifoObjectInitAligned(objects_fifo_t *ofp, size_t objsize, size_t objn,
+                             unsigned objalign, void *objbuf, msg_t *msgbuf) {
+    chGuardedPoolObjectInitAligned(&ofp->free, objsize, objalign);
+    chGuardedPoolLoadArray(&ofp->free, objbuf, objn);
+    chMBObjectInit(&ofp->mbx, msgbuf, objn);
+}
+
+void *chFifoTakeObjectI(objects_fifo_t *ofp) {
+    return chGuardedPoolAllocI(&ofp->free);
+}
+
+void *chFifoTakeObjectTimeout(objects_fifo_t *ofp, sysinterval_t timeout) {
+    return chGuardedPoolAllocTimeout(&ofp->free, timeout);
+}
+
+void chFifoReturnObjectI(objects_fifo_t *ofp, void *objp) {
+    chGuardedPoolFreeI(&ofp->free, objp);
+}
+
+void chFifoReturnObject(objects_fifo_t *ofp, void *objp) {
+    chGuardedPoolFree(&ofp->free, objp);
+}
+
+void chFifoSendObjectI(objects_fifo_t *ofp, void *objp) {
+    msg_t msg = chMBPostI(&ofp->mbx, (msg_t)objp);
+
+    chDbgAssert(msg == MSG_OK, "post failed");
+}
+
+void chFifoSendObject(objects_fifo_t *ofp, void *objp) {
+    msg_t msg = chMBPostTimeout(&ofp->mbx, (msg_t)objp, TIME_IMMEDIATE);
+
+    chDbgAssert(msg == MSG_OK, "post failed");
+}
+
+void chFifoSendObjectAheadI(objects_fifo_t *ofp, void *objp) {
+    msg_t msg = chMBPostAheadI(&ofp->mbx, (msg_t)objp);
+
+    chDbgAssert(msg == MSG_OK, "post failed");
+}
+
+void chFifoSendObjectAhead(objects_fifo_t *ofp, void *objp) {
+    msg_t msg = chMBPostAheadTimeout(&ofp->mbx, (msg_t)objp, TIME_IMMEDIATE);
+
+    chDbgAssert(msg == MSG_OK, "post failed");
+}
+
+msg_t chFifoReceiveObjectI(objects_fifo_t *ofp, void **objpp) {
+    return chMBFetchI(&ofp->mbx, (msg_t *)objpp);
+}
+
+msg_t chFifoReceiveObjectTimeout(objects_fifo_t *ofp, void **objpp, sysinterval_t timeout) {
+    return chMBFetchTimeout(&ofp->mbx, (msg_t *)objpp, timeout);
+}
+
+/** @} */
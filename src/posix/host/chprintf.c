@@ -0,0 +1,44 @@
+/**
+ * @file    chprintf.c
+ * @brief   ChibiOS chprintf() for host builds.
+ *
+ * @addtogroup HOST_HAL
+ * @{
+ */
+#include <stdio.h>
+#include "hal.h"
+#include "chprintf.h"
+
+int chvprintf(BaseSequentialStream *chp, const char *fmt, va_list ap) {
+    SerialDriver *sdp = (SerialDriver *)chp;
+    char buf[256];
+    int n;
+
+    n = vsnprintf(buf, sizeof(buf), fmt, ap);
+    if (sdp != NULL && sdp->out != NULL && n > 0) {
+        fputs(buf, sdp->out);
+    }
+    return n;
+}
+
+int chprintf(BaseSequentialStream *chp, const char *fmt, ...) {
+    va_list ap;
+    int n;
+
+    va_start(ap, fmt);
+    n = chvprintf(chp, fmt, ap);
+    va_end(ap);
+    return n;
+}
+
+int chsnprintf(char *str, size_t size, const char *fmt, ...) {
+    va_list ap;
+    int n;
+
+    va_start(ap, fmt);
+    n = vsnprintf(str, size, fmt, ap);
+    va_end(ap);
+    return n;
+}
+
+/** @} */
@@ -0,0 +1,769 @@
+/**
+ * @file    hal_host.c
+ * @brief   ChibiOS/HAL subset for host builds.
+ *
+ * @addtogroup HOST_HAL
+ * @{
+ */
+#include <string.h>
+#include "hal.h"
+
+/*===========================================================================*/
+/* Driver local definitions.                                                 */
+/*===========================================================================*/
+
+#define NS_PER_TICK                         (1000000000ULL / CH_CFG_ST_FREQUENCY)
+
+/* Start, address and stop around the data bytes of a transaction */
+#define I2C_OVERHEAD_BITS                   (2U * 9U + 2U)
+
+/*===========================================================================*/
+/* Driver exported variables.                                                */
+/*===========================================================================*/
+
+SPIDriver SPID1;
+SPIDriver SPID2;
+SPIDriver SPID3;
+I2CDriver I2CD1;
+I2CDriver I2CD2;
+SDCDriver SDCD1;
+DACDriver DACD1;
+ADCDriver ADCD1;
+CRC_TypeDef CRC_HOST;
+EFlashDriver EFLD1;
+SerialDriver SD1;
+SerialDriver SD2;
+
+/*===========================================================================*/
+/* Driver local variables and types.                                         */
+/*===========================================================================*/
+
+typedef struct {
+    bool                        level;
+    iomode_t                    mode;
+    uint32_t                    event;
+    palcallback_t               cb;
+    void                        *arg;
+    threads_queue_t             waiting;
+    palhostout_t                hook;
+    void                        *hook_arg;
+} pal_line_t;
+
+static pal_line_t pal_lines[HAL_HOST_PORTS][PAL_IOPORTS_WIDTH];
+
+/*===========================================================================*/
+/* Driver local functions.                                                   */
+/*===========================================================================*/
+
+static pal_line_t *pal_line(ioline_t line) {
+    osalDbgCheck(PAL_PORT(line) > 0U && PAL_PORT(line) < HAL_HOST_PORTS);
+    return &pal_lines[PAL_PORT(line)][PAL_PAD(line)];
+}
+
+/* Level change from either side, raising the event on a matching edge */
+static void pal_set(ioline_t line, bool level) {
+    pal_line_t *lp = pal_line(line);
+    bool rising = !lp->level && level;
+    bool falling = lp->level && !level;
+
+    lp->level = level;
+    if ((rising && (lp->event & PAL_EVENT_MODE_RISING_EDGE) != 0U) ||
+        (falling && (lp->event & PAL_EVENT_MODE_FALLING_EDGE) != 0U)) {
+        chHostISREnter();
+        if (lp->cb != NULL) {
+            lp->cb(lp->arg);
+        }
+        chThdDequeueAllI(&lp->waiting, MSG_OK);
+        chHostISRExit();
+    }
+}
+
+static void pal_write(ioline_t line, bool level) {
+    pal_line_t *lp = pal_line(line);
+
+    pal_set(line, level);
+    if (lp->hook != NULL) {
+        lp->hook(lp->hook_arg, line, level);
+    }
+}
+
+/* Sleeps the bus time owed once it adds up to a tick */
+static void bus_time(uint64_t *debt_ns, uint64_t ns) {
+    sysinterval_t ticks;
+
+    *debt_ns += ns;
+    ticks = (sysinterval_t)(*debt_ns / NS_PER_TICK);
+    if (ticks > (sysinterval_t)0) {
+        *debt_ns -= (uint64_t)ticks * NS_PER_TICK;
+        chThdSleep(ticks);
+    }
+}
+
+static void spi_transfer(SPIDriver *spip, size_t n, const uint8_t *txbuf, uint8_t *rxbuf) {
+    const spi_host_device_t *dev = spip->selected;
+
+    osalDbgAssert(spip->state == SPI_READY, "not ready");
+    if (dev != NULL && dev->exchange != NULL) {
+        dev->exchange(dev->arg, txbuf, rxbuf, n);
+    } else if (rxbuf != NULL) {
+        /* Nothing selected, MISO floats high */
+        memset(rxbuf, 0xFF, n);
+    }
+    spip->bytes += n;
+    bus_time(&spip->debt_ns, ((uint64_t)n * 8U * 1000000000ULL) / spiHostClock(spip->config));
+    if (dev != NULL && dev->complete != NULL) {
+        chHostISREnter();
+        dev->complete(dev->arg);
+        chHostISRExit();
+    }
+}
+
+static const i2c_host_device_t *i2c_device(I2CDriver *i2cp, i2caddr_t addr) {
+    for (unsigned i = 0; i < HAL_HOST_I2C_DEVICES; i++) {
+        if (i2cp->devices[i].dev != NULL && i2cp->devices[i].addr == addr) {
+            return i2cp->devices[i].dev;
+        }
+    }
+    return NULL;
+}
+
+/* Data time of @p n blocks on the configured bus width */
+static uint64_t sdc_time(SDCDriver *sdcp, uint32_t n) {
+    uint32_t lines = sdcp->config->bus_width == SDC_MODE_8BIT ? 8U :
+                     sdcp->config->bus_width == SDC_MODE_4BIT ? 4U : 1U;
+
+    return ((uint64_t)n * MMCSD_BLOCK_SIZE * 8U * 1000000000ULL) / (lines * HAL_HOST_SDC_HZ);
+}
+
+/*===========================================================================*/
+/* Driver exported functions.                                                */
+/*===========================================================================*/
+
+/**
+ * @brief   HAL initialization, ends with @p boardInit() like the real one.
+ */
+void halInit(void) {
+    memset(pal_lines, 0, sizeof(pal_lines));
+    spiObjectInit(&SPID1);
+    spiObjectInit(&SPID2);
+    spiObjectInit(&SPID3);
+    i2cObjectInit(&I2CD1);
+    i2cObjectInit(&I2CD2);
+    sdcObjectInit(&SDCD1);
+    dacObjectInit(&DACD1);
+    adcObjectInit(&ADCD1);
+    SD1.out = NULL;
+    SD2.out = NULL;
+    boardInit();
+}
+
+/*===========================================================================*/
+/* PAL.                                                                      */
+/*===========================================================================*/
+
+uint8_t palReadLine(ioline_t line) {
+    return pal_line(line)->level ? PAL_HIGH : PAL_LOW;
+}
+
+void palWriteLine(ioline_t line, uint8_t bit) {
+    pal_write(line, bit != PAL_LOW);
+}
+
+void palSetLine(ioline_t line) {
+    pal_write(line, true);
+}
+
+void palClearLine(ioline_t line) {
+    pal_write(line, false);
+}
+
+void palToggleLine(ioline_t line) {
+    pal_write(line, !pal_line(line)->level);
+}
+
+void palSetLineMode(ioline_t line, iomode_t mode) {
+    pal_line_t *lp = pal_line(line);
+
+    lp->mode = mode;
+    /* Pulls settle the input when nothing drives it */
+    if (mode == PAL_MODE_INPUT_PULLUP) {
+        pal_set(line, true);
+    } else if (mode == PAL_MODE_INPUT_PULLDOWN) {
+        pal_set(line, false);
+    }
+}
+
+void palEnableLineEvent(ioline_t line, uint32_t mode) {
+    pal_line(line)->event = mode & PAL_EVENT_MODE_EDGES_MASK;
+}
+
+void palDisableLineEvent(ioline_t line) {
+    pal_line_t *lp = pal_line(line);
+
+    lp->event = PAL_EVENT_MODE_DISABLED;
+    lp->cb = NULL;
+    lp->arg = NULL;
+    chThdDequeueAllI(&lp->waiting, MSG_RESET);
+}
+
+bool palIsLineEventEnabledX(ioline_t line) {
+    return pal_line(line)->event != PAL_EVENT_MODE_DISABLED;
+}
+
+void palSetLineCallback(ioline_t line, palcallback_t cb, void *arg) {
+    pal_line_t *lp = pal_line(line);
+
+    lp->cb = cb;
+    lp->arg = arg;
+}
+
+msg_t palWaitLineTimeout(ioline_t line, sysinterval_t timeout) {
+    return palWaitLineTimeoutS(line, timeout);
+}
+
+msg_t palWaitLineTimeoutS(ioline_t line, sysinterval_t timeout) {
+    return chThdEnqueueTimeoutS(&pal_line(line)->waiting, timeout);
+}
+
+/**
+ * @brief   Mode the firmware last set on a line.
+ */
+iomode_t palHostGetLineMode(ioline_t line) {
+    return pal_line(line)->mode;
+}
+
+/**
+ * @brief   Drives an input line from a model, edges raise the line event.
+ * @note    Callable from a thread or a timer callback.
+ */
+void palHostDriveLine(ioline_t line, bool level) {
+    pal_set(line, level);
+}
+
+/**
+ * @brief   Observes the writes the firmware makes to a line.
+ */
+void palHostSetOutputHook(ioline_t line, palhostout_t hook, void *arg) {
+    pal_line_t *lp = pal_line(line);
+
+    lp->hook = hook;
+    lp->hook_arg = arg;
+}
+
+/*===========================================================================*/
+/* SPI.                                                                      */
+/*===========================================================================*/
+
+void spiObjectInit(SPIDriver *spip) {
+    memset(spip, 0, sizeof(*spip));
+    spip->state = SPI_STOP;
+    chMtxObjectInit(&spip->mutex);
+}
+
+/**
+ * @brief   Connects a device model to the bus behind a chip select line.
+ *
+ * @param[in] spip      pointer to the @p SPIDriver object
+ * @param[in] ssline    chip select the device answers to
+ * @param[in] dev       device hooks, NULL disconnects
+ */
+void spiHostAttach(SPIDriver *spip, ioline_t ssline, const spi_host_device_t *dev) {
+    for (unsigned i = 0; i < HAL_HOST_SPI_DEVICES; i++) {
+        if (spip->devices[i].dev == NULL || spip->devices[i].line == ssline) {
+            spip->devices[i].line = ssline;
+            spip->devices[i].dev = dev;
+            return;
+        }
+    }
+    osalDbgAssert(false, "too many devices");
+}
+
+/**
+ * @brief   Bus clock a configuration runs at, from the SPI_CR1 divider.
+ */
+uint32_t spiHostClock(const SPIConfig *config) {
+    return HAL_HOST_SPI_PCLK >> (((config->cr1 & SPI_CR1_BR_Msk) >> SPI_CR1_BR_Pos) + 1U);
+}
+
+msg_t spiStart(SPIDriver *spip, const SPIConfig *config) {
+    osalDbgCheck(spip != NULL && config != NULL);
+    osalDbgAssert(spip->state == SPI_STOP || spip->state == SPI_READY, "invalid state");
+    spip->config = config;
+    spip->state = SPI_READY;
+    palSetLine(config->ssline);
+    return MSG_OK;
+}
+
+void spiStop(SPIDriver *spip) {
+    osalDbgAssert(spip->state == SPI_STOP || spip->state == SPI_READY, "invalid state");
+    spip->config = NULL;
+    spip->selected = NULL;
+    spip->state = SPI_STOP;
+}
+
+void spiAcquireBus(SPIDriver *spip) {
+    chMtxLock(&spip->mutex);
+}
+
+void spiReleaseBus(SPIDriver *spip) {
+    chMtxUnlock(&spip->mutex);
+}
+
+void spiSelect(SPIDriver *spip) {
+    osalDbgAssert(spip->state == SPI_READY, "not ready");
+    osalDbgAssert(spip->selected == NULL, "already selected");
+    palClearLine(spip->config->ssline);
+    spip->xfers++;
+    for (unsigned i = 0; i < HAL_HOST_SPI_DEVICES; i++) {
+        if (spip->devices[i].dev != NULL && spip->devices[i].line == spip->config->ssline) {
+            spip->selected = spip->devices[i].dev;
+            if (spip->selected->select != NULL) {
+                spip->selected->select(spip->selected->arg);
+            }
+            break;
+        }
+    }
+}
+
+void spiUnselect(SPIDriver *spip) {
+    osalDbgAssert(spip->state == SPI_READY, "not ready");
+    if (spip->selected != NULL && spip->selected->unselect != NULL) {
+        spip->selected->unselect(spip->selected->arg);
+    }
+    spip->selected = NULL;
+    palSetLine(spip->config->ssline);
+}
+
+void spiIgnore(SPIDriver *spip, size_t n) {
+    spi_transfer(spip, n, NULL, NULL);
+}
+
+void spiExchange(SPIDriver *spip, size_t n, const void *txbuf, void *rxbuf) {
+    spi_transfer(spip, n, txbuf, rxbuf);
+}
+
+void spiSend(SPIDriver *spip, size_t n, const void *txbuf) {
+    spi_transfer(spip, n, txbuf, NULL);
+}
+
+void spiReceive(SPIDriver *spip, size_t n, void *rxbuf) {
+    spi_transfer(spip, n, NULL, rxbuf);
+}
+
+uint16_t spiPolledExchange(SPIDriver *spip, uint16_t frame) {
+    uint8_t tx = (uint8_t)frame;
+    uint8_t rx = 0xFFU;
+
+    osalDbgAssert(spip->state == SPI_READY, "not ready");
+    if (spip->selected != NULL && spip->selected->exchange != NULL) {
+        spip->selected->exchange(spip->selected->arg, &tx, &rx, 1U);
+    }
+    spip->bytes++;
+    return rx;
+}
+
+/*===========================================================================*/
+/* I2C.                                                                      */
+/*===========================================================================*/
+
+void i2cObjectInit(I2CDriver *i2cp) {
+    memset(i2cp, 0, sizeof(*i2cp));
+    i2cp->state = I2C_STOP;
+    chMtxObjectInit(&i2cp->mutex);
+}
+
+/**
+ * @brief   Connects a device model to the bus at a 7-bit address.
+ *
+ * @param[in] i2cp      pointer to the @p I2CDriver object
+ * @param[in] addr      address the device answers to
+ * @param[in] dev       device hooks, NULL disconnects
+ */
+void i2cHostAttach(I2CDriver *i2cp, i2caddr_t addr, const i2c_host_device_t *dev) {
+    for (unsigned i = 0; i < HAL_HOST_I2C_DEVICES; i++) {
+        if (i2cp->devices[i].dev == NULL || i2cp->devices[i].addr == addr) {
+            i2cp->devices[i].addr = addr;
+            i2cp->devices[i].dev = dev;
+            return;
+        }
+    }
+    osalDbgAssert(false, "too many devices");
+}
+
+/**
+ * @brief   Observes the transactions the firmware starts.
+ */
+void i2cHostSetTransferHook(I2CDriver *i2cp, i2chostxfer_t hook, void *arg) {
+    i2cp->hook = hook;
+    i2cp->hook_arg = arg;
+}
+
+msg_t i2cStart(I2CDriver *i2cp, const I2CConfig *config) {
+    osalDbgCheck(i2cp != NULL && config != NULL);
+    osalDbgAssert(i2cp->state == I2C_STOP || i2cp->state == I2C_READY ||
+                  i2cp->state == I2C_LOCKED, "invalid state");
+    i2cp->config = config;
+    i2cp->errors = I2C_NO_ERROR;
+    i2cp->state = I2C_READY;
+    return MSG_OK;
+}
+
+void i2cStop(I2CDriver *i2cp) {
+    osalDbgAssert(i2cp->state == I2C_STOP || i2cp->state == I2C_READY ||
+                  i2cp->state == I2C_LOCKED, "invalid state");
+    i2cp->config = NULL;
+    i2cp->state = I2C_STOP;
+}
+
+void i2cAcquireBus(I2CDriver *i2cp) {
+    chMtxLock(&i2cp->mutex);
+}
+
+void i2cReleaseBus(I2CDriver *i2cp) {
+    chMtxUnlock(&i2cp->mutex);
+}
+
+i2cflags_t i2cGetErrors(I2CDriver *i2cp) {
+    return i2cp->errors;
+}
+
+msg_t i2cMasterTransmitTimeout(I2CDriver *i2cp, i2caddr_t addr,
+                               const uint8_t *txbuf, size_t txbytes,
+                               uint8_t *rxbuf, size_t rxbytes,
+                               sysinterval_t timeout) {
+    const i2c_host_device_t *dev;
+    msg_t msg = MSG_RESET;
+    size_t bits;
+
+    (void)timeout;
+    osalDbgCheck(i2cp != NULL && (txbytes > 0U || rxbytes > 0U));
+    osalDbgAssert(i2cp->state == I2C_READY, "not ready");
+
+    i2cp->errors = I2C_NO_ERROR;
+    dev = i2c_device(i2cp, addr);
+    if (dev != NULL) {
+        msg = dev->transfer(dev->arg, txbuf, txbytes, rxbuf, rxbytes);
+    }
+    if (msg != MSG_OK) {
+        i2cp->errors = I2C_ACK_FAILURE;
+    }
+    if (i2cp->hook != NULL) {
+        i2cp->hook(i2cp->hook_arg, addr, txbuf, txbytes, rxbytes, msg);
+    }
+
+    i2cp->xfers++;
+    i2cp->bytes += txbytes + rxbytes;
+    bits = (txbytes + rxbytes) * 9U + I2C_OVERHEAD_BITS;
+    if (txbytes > 0U && rxbytes > 0U) {
+        bits += I2C_OVERHEAD_BITS / 2U;
+    }
+    bus_time(&i2cp->debt_ns, ((uint64_t)bits * 1000000000ULL) / HAL_HOST_I2C_HZ);
+    return msg;
+}
+
+msg_t i2cMasterReceiveTimeout(I2CDriver *i2cp, i2caddr_t addr,
+                              uint8_t *rxbuf, size_t rxbytes,
+                              sysinterval_t timeout) {
+    return i2cMasterTransmitTimeout(i2cp, addr, NULL, 0U, rxbuf, rxbytes, timeout);
+}
+
+/*===========================================================================*/
+/* SDC.                                                                      */
+/*===========================================================================*/
+
+void sdcObjectInit(SDCDriver *sdcp) {
+    memset(sdcp, 0, sizeof(*sdcp));
+    sdcp->state = BLK_STOP;
+}
+
+/**
+ * @brief   Inserts a card model, it is seen on the next connect.
+ *
+ * @param[in] sdcp      pointer to the @p SDCDriver object
+ * @param[in] dev       card hooks, NULL removes the card
+ */
+void sdcHostInsert(SDCDriver *sdcp, const sdc_host_device_t *dev) {
+    sdcp->dev = dev;
+}
+
+msg_t sdcStart(SDCDriver *sdcp, const SDCConfig *config) {
+    osalDbgCheck(sdcp != NULL && config != NULL);
+    osalDbgAssert(sdcp->state == BLK_STOP || sdcp->state == BLK_ACTIVE,
+                  "invalid state");
+    sdcp->config = config;
+    sdcp->state = BLK_ACTIVE;
+    return MSG_OK;
+}
+
+void sdcStop(SDCDriver *sdcp) {
+    osalDbgAssert(sdcp->state == BLK_STOP || sdcp->state == BLK_ACTIVE,
+                  "invalid state");
+    sdcp->config = NULL;
+    sdcp->state = BLK_STOP;
+}
+
+bool sdcConnect(SDCDriver *sdcp) {
+    osalDbgAssert(sdcp->state == BLK_ACTIVE || sdcp->state == BLK_READY,
+                  "invalid state");
+    if (sdcp->dev == NULL) {
+        sdcp->errors |= SDC_COMMAND_TIMEOUT;
+        return HAL_FAILED;
+    }
+    sdcp->state = BLK_READY;
+    return HAL_SUCCESS;
+}
+
+bool sdcDisconnect(SDCDriver *sdcp) {
+    osalDbgAssert(sdcp->state == BLK_ACTIVE || sdcp->state == BLK_READY,
+                  "invalid state");
+    sdcp->state = BLK_ACTIVE;
+    return HAL_SUCCESS;
+}
+
+sdcflags_t sdcGetAndClearErrors(SDCDriver *sdcp) {
+    sdcflags_t flags = sdcp->errors;
+
+    sdcp->errors = SDC_NO_ERROR;
+    return flags;
+}
+
+bool blkRead(SDCDriver *sdcp, uint32_t startblk, uint8_t *buf, uint32_t n) {
+    bool err;
+
+    osalDbgCheck(buf != NULL && n > 0U);
+    osalDbgAssert(sdcp->state == BLK_READY, "not ready");
+    if (startblk + n > sdcp->dev->blocks) {
+        sdcp->errors |= SDC_UNHANDLED_ERROR;
+        return HAL_FAILED;
+    }
+    err = sdcp->dev->read(sdcp->dev->arg, startblk, buf, n);
+    if (err) {
+        sdcp->errors |= SDC_DATA_CRC_ERROR;
+    }
+    sdcp->reads += n;
+    bus_time(&sdcp->debt_ns, sdc_time(sdcp, n));
+    return err;
+}
+
+bool blkWrite(SDCDriver *sdcp, uint32_t startblk, const uint8_t *buf, uint32_t n) {
+    bool err;
+
+    osalDbgCheck(buf != NULL && n > 0U);
+    osalDbgAssert(sdcp->state == BLK_READY, "not ready");
+    if (startblk + n > sdcp->dev->blocks) {
+        sdcp->errors |= SDC_UNHANDLED_ERROR;
+        return HAL_FAILED;
+    }
+    err = sdcp->dev->write(sdcp->dev->arg, startblk, buf, n);
+    if (err) {
+        sdcp->errors |= SDC_DATA_CRC_ERROR;
+    }
+    sdcp->writes += n;
+    bus_time(&sdcp->debt_ns, sdc_time(sdcp, n));
+    return err;
+}
+
+bool blkSync(SDCDriver *sdcp) {
+    osalDbgAssert(sdcp->state == BLK_READY, "not ready");
+    return HAL_SUCCESS;
+}
+
+bool blkGetInfo(SDCDriver *sdcp, BlockDeviceInfo *bdip) {
+    if (sdcp->state != BLK_READY) {
+        return HAL_FAILED;
+    }
+    bdip->blk_size = MMCSD_BLOCK_SIZE;
+    bdip->blk_num = sdcp->dev->blocks;
+    return HAL_SUCCESS;
+}
+
+/**
+ * @brief   The card models have no CID, the fields read as zero.
+ */
+void _mmcsd_unpack_mmc_cid(const MMCSDBlockDevice *sdcp, unpacked_mmc_cid_t *cidmmc) {
+    (void)sdcp;
+    memset(cidmmc, 0, sizeof(*cidmmc));
+}
+
+/**
+ * @brief   The card models have no CSD, the fields read as zero.
+ */
+void _mmcsd_unpack_csd_mmc(const MMCSDBlockDevice *sdcp, unpacked_mmc_csd_t *csdmmc) {
+    (void)sdcp;
+    memset(csdmmc, 0, sizeof(*csdmmc));
+}
+
+/*===========================================================================*/
+/* DAC.                                                                      */
+/*===========================================================================*/
+
+void dacObjectInit(DACDriver *dacp) {
+    memset(dacp, 0, sizeof(*dacp));
+    dacp->state = DAC_STOP;
+}
+
+/**
+ * @brief   Observes the conversions the firmware starts.
+ */
+void dacHostSetOutputHook(DACDriver *dacp, dachostout_t hook, void *arg) {
+    dacp->hook = hook;
+    dacp->hook_arg = arg;
+}
+
+msg_t dacStart(DACDriver *dacp, const DACConfig *config) {
+    osalDbgCheck(dacp != NULL && config != NULL);
+    osalDbgAssert(dacp->state == DAC_STOP || dacp->state == DAC_READY,
+                  "invalid state");
+    dacp->config = config;
+    dacp->state = DAC_READY;
+    for (dacchannel_t i = 0U; i < HAL_HOST_DAC_CHANNELS; i++) {
+        dacPutChannelX(dacp, i, config->init);
+    }
+    return MSG_OK;
+}
+
+void dacStop(DACDriver *dacp) {
+    osalDbgAssert(dacp->state == DAC_STOP || dacp->state == DAC_READY,
+                  "invalid state");
+    dacp->config = NULL;
+    dacp->state = DAC_STOP;
+}
+
+void dacPutChannelX(DACDriver *dacp, dacchannel_t channel, dacsample_t sample) {
+    osalDbgCheck(channel < HAL_HOST_DAC_CHANNELS);
+    osalDbgAssert(dacp->state == DAC_READY, "not ready");
+    dacp->output[channel] = sample;
+    if (dacp->hook != NULL) {
+        dacp->hook(dacp->hook_arg, channel, sample);
+    }
+}
+
+/*===========================================================================*/
+/* ADC.                                                                      */
+/*===========================================================================*/
+
+void adcObjectInit(ADCDriver *adcp) {
+    memset(adcp, 0, sizeof(*adcp));
+    adcp->state = ADC_STOP;
+    chMtxObjectInit(&adcp->mutex);
+}
+
+/**
+ * @brief   Sets the model the channels sample, without one they read zero.
+ */
+void adcHostSetInputHook(ADCDriver *adcp, adchostin_t hook, void *arg) {
+    adcp->hook = hook;
+    adcp->hook_arg = arg;
+}
+
+/**
+ * @brief   Converts @p n sequences into the buffer where the DMA is.
+ * @details The half and full buffer callbacks run as the DMA interrupts
+ *          would when the position crosses them. A linear conversion stops
+ *          at the end of the buffer, a circular one wraps.
+ */
+void adcHostConvert(ADCDriver *adcp, size_t n) {
+    while (n-- > 0U && adcp->state == ADC_ACTIVE) {
+        const ADCConversionGroup *grpp = adcp->grpp;
+        adcsample_t *sp = &adcp->samples[adcp->pos * grpp->num_channels];
+        for (unsigned ch = 0U; ch < HAL_HOST_ADC_CHANNELS; ch++) {
+            if ((grpp->chselr & ADC_CHSELR_CHSEL(ch)) != 0U) {
+                *sp++ = adcp->hook != NULL ? adcp->hook(adcp->hook_arg, ch) : 0U;
+            }
+        }
+        adcp->sequences++;
+        adcp->pos++;
+
+        chHostISREnter();
+        if (adcp->pos == adcp->depth / 2U && adcp->depth > 1U) {
+            if (grpp->end_cb != NULL) {
+                grpp->end_cb(adcp);
+            }
+        } else if (adcp->pos == adcp->depth) {
+            adcp->pos = 0U;
+            if (grpp->circular) {
+                if (grpp->end_cb != NULL) {
+                    adcp->state = ADC_COMPLETE;
+                    grpp->end_cb(adcp);
+                    if (adcp->state == ADC_COMPLETE) {
+                        adcp->state = ADC_ACTIVE;
+                    }
+                }
+            } else {
+                adcp->state = ADC_COMPLETE;
+                if (grpp->end_cb != NULL) {
+                    grpp->end_cb(adcp);
+                }
+                if (adcp->state == ADC_COMPLETE) {
+                    adcp->state = ADC_READY;
+                    adcp->grpp = NULL;
+                }
+            }
+        }
+        chHostISRExit();
+    }
+}
+
+/**
+ * @note    @p config may be NULL, the STM32 ADCv1 driver has no settings.
+ */
+msg_t adcStart(ADCDriver *adcp, const ADCConfig *config) {
+    osalDbgCheck(adcp != NULL);
+    osalDbgAssert(adcp->state == ADC_STOP || adcp->state == ADC_READY,
+                  "invalid state");
+    adcp->config = config;
+    adcp->state = ADC_READY;
+    return MSG_OK;
+}
+
+void adcStop(ADCDriver *adcp) {
+    osalDbgAssert(adcp->state == ADC_STOP || adcp->state == ADC_READY,
+                  "invalid state");
+    adcp->config = NULL;
+    adcp->state = ADC_STOP;
+}
+
+void adcAcquireBus(ADCDriver *adcp) {
+    chMtxLock(&adcp->mutex);
+}
+
+void adcReleaseBus(ADCDriver *adcp) {
+    chMtxUnlock(&adcp->mutex);
+}
+
+void adcStartConversion(ADCDriver *adcp, const ADCConversionGroup *grpp,
+                        adcsample_t *samples, size_t depth) {
+    osalDbgCheck(adcp != NULL && grpp != NULL && samples != NULL && depth > 0U &&
+                 (depth == 1U || (depth & 1U) == 0U));
+    osalDbgAssert(adcp->state == ADC_READY || adcp->state == ADC_ERROR,
+                  "not ready");
+    osalDbgAssert((unsigned)__builtin_popcount(grpp->chselr) == grpp->num_channels,
+                  "channels mismatch");
+    adcp->grpp = grpp;
+    adcp->samples = samples;
+    adcp->depth = depth;
+    adcp->pos = 0U;
+    adcp->state = ADC_ACTIVE;
+}
+
+void adcStopConversion(ADCDriver *adcp) {
+    osalDbgAssert(adcp->state == ADC_READY || adcp->state == ADC_ACTIVE,
+                  "invalid state");
+    if (adcp->state != ADC_READY) {
+        adcp->grpp = NULL;
+        adcp->state = ADC_READY;
+    }
+}
+
+/*===========================================================================*/
+/* Serial.                                                                   */
+/*===========================================================================*/
+
+/**
+ * @brief   Sends what the firmware prints on @p sdp to @p out, NULL drops it.
+ */
+void sdHostSetOutput(SerialDriver *sdp, FILE *out) {
+    sdp->out = out;
+}
+
+/** @} */
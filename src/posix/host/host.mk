@@ -0,0 +1,8 @@
+# Host runtime, the ChibiOS/RT and HAL subset host builds link against.
+# Set HOST_ROOT to this directory before including.
+HOST_SRC := $(HOST_ROOT)/ch_host.c \
+            $(HOST_ROOT)/hal_host.c \
+            $(HOST_ROOT)/chprintf.c
+
+# Required include directories
+HOST_INC := $(HOST_ROOT)/include
@@ -0,0 +1,572 @@
+/**
+ * @file    ch.h
+ * @brief   ChibiOS/RT subset for host builds.
+ * @details Threads are cooperative coroutines on one host thread and time
+ *          is virtual: it only advances when every thread is blocked, to
+ *          the next timer deadline. A run is therefore deterministic and
+ *          takes as much host time as the code under test needs, not as
+ *          much as it sleeps. Scheduling follows RT: the highest priority
+ *          ready thread runs, equal priorities round robin on yield, and
+ *          waking a higher priority thread preempts the caller. Threads are
+ *          never preempted in the middle of a computation, which matches
+ *          RT everywhere except where the firmware relies on an interrupt
+ *          landing between two instructions.
+ *
+ * @addtogroup HOST_CH
+ * @{
+ */
+#ifndef _CH_H_
+#define _CH_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/*===========================================================================*/
+/* Kernel constants.                                                         */
+/*===========================================================================*/
+
+#define _CHIBIOS_RT_
+#define CH_KERNEL_STABLE                    1
+#define CH_KERNEL_VERSION                   "6.1.host"
+
+#if !defined(FALSE)
+#define FALSE                               0
+#endif
+#if !defined(TRUE)
+#define TRUE                                1
+#endif
+
+#define MSG_OK                              (msg_t)0
+#define MSG_TIMEOUT                         (msg_t)-1
+#define MSG_RESET                           (msg_t)-2
+
+#define NOPRIO                              (tprio_t)0
+#define IDLEPRIO                            (tprio_t)1
+#define LOWPRIO                             (tprio_t)2
+#define NORMALPRIO                          (tprio_t)128
+#define HIGHPRIO                            (tprio_t)255
+
+#define CH_STATE_READY                      (tstate_t)0
+#define CH_STATE_CURRENT                    (tstate_t)1
+#define CH_STATE_WTSTART                    (tstate_t)2
+#define CH_STATE_SUSPENDED                  (tstate_t)3
+#define CH_STATE_QUEUED                     (tstate_t)4
+#define CH_STATE_WTSEM                      (tstate_t)5
+#define CH_STATE_WTMTX                      (tstate_t)6
+#define CH_STATE_WTCOND                     (tstate_t)7
+#define CH_STATE_SLEEPING                   (tstate_t)8
+#define CH_STATE_WTEXIT                     (tstate_t)9
+#define CH_STATE_WTOREVT                    (tstate_t)10
+#define CH_STATE_WTANDEVT                   (tstate_t)11
+#define CH_STATE_SNDMSGQ                    (tstate_t)12
+#define CH_STATE_SNDMSG                     (tstate_t)13
+#define CH_STATE_WTMSG                      (tstate_t)14
+#define CH_STATE_FINAL                      (tstate_t)15
+
+/* Alignment of the pool and heap objects, as the port sets it */
+#define PORT_NATURAL_ALIGN                  sizeof(void *)
+
+#define ALL_EVENTS                          ((eventmask_t)-1)
+#define EVENT_MASK(eid)                     ((eventmask_t)1 << (eventmask_t)(eid))
+
+/*===========================================================================*/
+/* Kernel settings.                                                          */
+/*===========================================================================*/
+
+/**
+ * @brief   System tick frequency, same as the firmware configurations.
+ */
+#if !defined(CH_CFG_ST_FREQUENCY) || defined(__DOXYGEN__)
+#define CH_CFG_ST_FREQUENCY                 10000
+#endif
+
+/**
+ * @brief   Realtime counter frequency, one count per simulated microsecond.
+ */
+#if !defined(CH_HOST_RT_FREQUENCY) || defined(__DOXYGEN__)
+#define CH_HOST_RT_FREQUENCY                1000000U
+#endif
+
+/**
+ * @brief   Host stack given to every thread, whatever its working area.
+ * @note    Host frames are larger than Cortex-M ones, the firmware sizes
+ *          do not apply.
+ */
+#if !defined(CH_HOST_STACK_SIZE) || defined(__DOXYGEN__)
+#define CH_HOST_STACK_SIZE                  (256U * 1024U)
+#endif
+
+#define CH_CFG_ST_RESOLUTION                32
+#define CH_CFG_INTERVALS_SIZE               32
+#define CH_CFG_TIME_TYPES_SIZE              32
+#define CH_CFG_USE_REGISTRY                 TRUE
+#define CH_CFG_USE_WAITEXIT                 TRUE
+#define CH_CFG_USE_SEMAPHORES               TRUE
+#define CH_CFG_USE_MUTEXES                  TRUE
+#define CH_CFG_USE_EVENTS                   TRUE
+#define CH_CFG_USE_EVENTS_TIMEOUT           TRUE
+#define CH_CFG_USE_MAILBOXES                TRUE
+#define CH_CFG_USE_MEMPOOLS                 TRUE
+#define CH_CFG_USE_HEAP                     TRUE
+#define CH_CFG_USE_OBJ_FIFOS                TRUE
+#define CH_DBG_ENABLE_ASSERTS               TRUE
+#define CH_DBG_ENABLE_CHECKS                TRUE
+
+/*===========================================================================*/
+/* Kernel data structures and types.                                         */
+/*===========================================================================*/
+
+/* Wide enough for the pointers the firmware posts as messages */
+typedef intptr_t msg_t;
+typedef int32_t cnt_t;
+typedef uint32_t ucnt_t;
+typedef uint32_t tprio_t;
+typedef uint8_t tstate_t;
+typedef uint8_t trefs_t;
+typedef uint32_t eventmask_t;
+typedef uint32_t eventflags_t;
+typedef int32_t eventid_t;
+typedef uint32_t rtcnt_t;
+typedef uint32_t systime_t;
+typedef uint32_t sysinterval_t;
+typedef uint64_t time_conv_t;
+typedef uint32_t syssts_t;
+typedef void (*tfunc_t)(void *p);
+typedef void (*vtfunc_t)(void *p);
+
+typedef struct ch_thread thread_t;
+typedef thread_t *thread_reference_t;
+
+/**
+ * @brief   Priority ordered queue of waiting threads.
+ */
+typedef struct {
+    thread_t                    *head;
+} threads_queue_t;
+
+/**
+ * @brief   Virtual timer.
+ */
+typedef struct ch_virtual_timer {
+    struct ch_virtual_timer     *next;
+    uint64_t                    deadline;
+    vtfunc_t                    func;
+    void                        *par;
+    bool                        armed;
+} virtual_timer_t;
+
+struct ch_thread {
+    const char                  *name;
+    tprio_t                     prio;
+    tstate_t                    state;
+    trefs_t                     refs;
+    bool                        terminate;
+    bool                        heap;
+    thread_t                    *queue_next;
+    threads_queue_t             *queue;
+    msg_t                       rdymsg;
+    msg_t                       exitcode;
+    threads_queue_t             waiting;
+    eventmask_t                 epending;
+    eventmask_t                 ewmask;
+    virtual_timer_t             timeout;
+    struct ch_mutex             *mtxlist;
+    tfunc_t                     func;
+    void                        *arg;
+    void                        *stack;
+    void                        *ctx;
+};
+
+typedef struct ch_mutex {
+    threads_queue_t             queue;
+    thread_t                    *owner;
+    struct ch_mutex             *next;
+} mutex_t;
+
+typedef struct {
+    threads_queue_t             queue;
+    cnt_t                       cnt;
+} semaphore_t;
+
+typedef struct {
+    semaphore_t                 sem;
+} binary_semaphore_t;
+
+typedef struct event_listener {
+    struct event_listener       *next;
+    thread_t                    *listener;
+    eventmask_t                 events;
+    eventflags_t                flags;
+    eventflags_t                wflags;
+} event_listener_t;
+
+typedef struct {
+    event_listener_t            *next;
+} event_source_t;
+
+typedef void (*evhandler_t)(eventid_t id);
+
+typedef struct {
+    msg_t                       *buffer;
+    msg_t                       *top;
+    msg_t                       *wrptr;
+    msg_t                       *rdptr;
+    size_t                      cnt;
+    bool                        reset;
+    threads_queue_t             qw;
+    threads_queue_t             qr;
+} mailbox_t;
+
+typedef void *(*memgetfunc_t)(size_t size, unsigned align);
+
+struct pool_header {
+    struct pool_header          *next;
+};
+
+typedef struct {
+    struct pool_header          *next;
+    size_t                      object_size;
+    unsigned                    align;
+    memgetfunc_t                provider;
+} memory_pool_t;
+
+typedef struct {
+    semaphore_t                 sem;
+    memory_pool_t               pool;
+} guarded_memory_pool_t;
+
+typedef struct {
+    guarded_memory_pool_t       free;
+    mailbox_t                   mbx;
+} objects_fifo_t;
+
+typedef struct memory_heap memory_heap_t;
+
+typedef struct {
+    const char                  *name;
+    void                        *wbase;
+    void                        *wend;
+    tprio_t                     prio;
+    tfunc_t                     funcp;
+    void                        *arg;
+} thread_descriptor_t;
+
+/*===========================================================================*/
+/* Kernel macros.                                                            */
+/*===========================================================================*/
+
+#define TIME_IMMEDIATE                      ((sysinterval_t)0)
+#define TIME_INFINITE                       ((sysinterval_t)-1)
+#define TIME_MAX_INTERVAL                   ((sysinterval_t)-2)
+#define TIME_MAX_SYSTIME                    ((systime_t)-1)
+
+#define TIME_S2I(secs)                                                      \
+    ((sysinterval_t)((time_conv_t)(secs) * (time_conv_t)CH_CFG_ST_FREQUENCY))
+#define TIME_MS2I(msecs)                                                    \
+    ((sysinterval_t)((((time_conv_t)(msecs) *                               \
+                       (time_conv_t)CH_CFG_ST_FREQUENCY) +                  \
+                      (time_conv_t)999) / (time_conv_t)1000))
+#define TIME_US2I(usecs)                                                    \
+    ((sysinterval_t)((((time_conv_t)(usecs) *                               \
+                       (time_conv_t)CH_CFG_ST_FREQUENCY) +                  \
+                      (time_conv_t)999999) / (time_conv_t)1000000))
+#define TIME_I2S(interval)                                                  \
+    (time_secs_t)((((time_conv_t)(interval) +                               \
+                    (time_conv_t)CH_CFG_ST_FREQUENCY) - (time_conv_t)1) /   \
+                  (time_conv_t)CH_CFG_ST_FREQUENCY)
+#define TIME_I2MS(interval)                                                 \
+    (time_msecs_t)((((time_conv_t)(interval) * (time_conv_t)1000) +         \
+                    (time_conv_t)CH_CFG_ST_FREQUENCY - (time_conv_t)1) /    \
+                   (time_conv_t)CH_CFG_ST_FREQUENCY)
+#define TIME_I2US(interval)                                                 \
+    (time_usecs_t)((((time_conv_t)(interval) * (time_conv_t)1000000) +      \
+                    (time_conv_t)CH_CFG_ST_FREQUENCY - (time_conv_t)1) /    \
+                   (time_conv_t)CH_CFG_ST_FREQUENCY)
+
+typedef uint32_t time_secs_t;
+typedef uint32_t time_msecs_t;
+typedef uint32_t time_usecs_t;
+
+#define RTC2S(freq, n)                      ((((n) - 1UL) / (freq)) + 1UL)
+#define RTC2MS(freq, n)                     ((((n) - 1UL) / ((freq) / 1000UL)) + 1UL)
+#define RTC2US(freq, n)                     ((((n) - 1UL) / ((freq) / 1000000UL)) + 1UL)
+#define S2RTC(freq, sec)                    ((freq) * (sec))
+#define MS2RTC(freq, msec)                  (rtcnt_t)((((freq) + 999UL) / 1000UL) * (msec))
+#define US2RTC(freq, usec)                  (rtcnt_t)((((freq) + 999999UL) / 1000000UL) * (usec))
+
+#define THD_WORKING_AREA_SIZE(n)            ((size_t)(n))
+#define THD_WORKING_AREA(s, n)              uint8_t s[THD_WORKING_AREA_SIZE(n)]
+#define THD_WORKING_AREA_BASE(s)            ((void *)(s))
+#define THD_WORKING_AREA_END(s)             ((void *)((uint8_t *)(s) + sizeof(s)))
+#define THD_FUNCTION(tname, arg)            void tname(void *arg)
+#define CH_IRQ_HANDLER(id)                  void id(void)
+#define CH_IRQ_PROLOGUE()
+#define CH_IRQ_EPILOGUE()
+
+#define MUTEX_DECL(name)                    mutex_t name = {{NULL}, NULL, NULL}
+#define SEMAPHORE_DECL(name, n)             semaphore_t name = {{NULL}, (n)}
+#define BSEMAPHORE_DECL(name, taken)        binary_semaphore_t name = {{{NULL}, ((taken) ? 0 : 1)}}
+#define EVENTSOURCE_DECL(name)              event_source_t name = {NULL}
+#define MAILBOX_DECL(name, buffer, size)                                    \
+    mailbox_t name = {(msg_t *)(buffer), (msg_t *)(buffer) + (size),        \
+                      (msg_t *)(buffer), (msg_t *)(buffer), 0, false,       \
+                      {NULL}, {NULL}}
+
+#define chDbgCheck(c)                       chDbgAssert((c), "check failed")
+#define chDbgAssert(c, remark)                                              \
+    do {                                                                    \
+        if (!(c)) {                                                         \
+            chSysHalt(remark);                                              \
+        }                                                                   \
+    } while (false)
+#define chDbgCheckClassI()
+#define chDbgCheckClassS()
+
+#define chSysLock()
+#define chSysUnlock()
+#define chSysLockFromISR()
+#define chSysUnlockFromISR()
+#define chSysGetStatusAndLockX()            ((syssts_t)0)
+#define chSysRestoreStatusX(sts)            ((void)(sts))
+#define chSysDisable()
+#define chSysEnable()
+#define chSysSuspend()
+
+#define chThdSleepSeconds(sec)              chThdSleep(TIME_S2I(sec))
+#define chThdSleepMilliseconds(msec)        chThdSleep(TIME_MS2I(msec))
+#define chThdSleepMicroseconds(usec)        chThdSleep(TIME_US2I(usec))
+
+#define chEvtGetAndClearEvents(events)      chEvtGetAndClearEventsI(events)
+#define chEvtRegisterMask(esp, elp, events)                                 \
+    chEvtRegisterMaskWithFlags(esp, elp, events, (eventflags_t)-1)
+#define chEvtRegister(esp, elp, event)                                      \
+    chEvtRegisterMask(esp, elp, EVENT_MASK(event))
+#define chEvtObjectInit(esp)                ((esp)->next = NULL)
+#define chEvtIsListeningI(esp)              ((esp)->next != NULL)
+#define chEvtBroadcast(esp)                 chEvtBroadcastFlags(esp, (eventflags_t)0)
+#define chEvtBroadcastI(esp)                chEvtBroadcastFlagsI(esp, (eventflags_t)0)
+
+#define chVTGetSystemTime()                 chVTGetSystemTimeX()
+#define chVTTimeElapsedSinceX(start)        chTimeDiffX((start), chVTGetSystemTimeX())
+#define chVTIsSystemTimeWithin(start, end)  chTimeIsInRangeX(chVTGetSystemTimeX(), start, end)
+#define chVTIsArmed(vtp)                    ((vtp)->armed)
+#define chVTIsArmedI(vtp)                   ((vtp)->armed)
+#define chVTSet(vtp, delay, vtfunc, par)    chVTSetI(vtp, delay, vtfunc, par)
+#define chVTReset(vtp)                      chVTResetI(vtp)
+#define chVTObjectInit(vtp)                 ((vtp)->armed = false)
+
+#define chSemGetCounterI(sp)                ((sp)->cnt)
+#define chSemFastSignalI(sp)                ((void)((sp)->cnt++))
+#define chSemWaitS(sp)                      chSemWaitTimeoutS(sp, TIME_INFINITE)
+#define chSemWait(sp)                       chSemWaitTimeout(sp, TIME_INFINITE)
+#define chBSemGetStateI(bsp)                ((bsp)->sem.cnt > 0 ? false : true)
+#define chBSemWait(bsp)                     chBSemWaitTimeout(bsp, TIME_INFINITE)
+#define chMtxQueueNotEmptyS(mp)             ((mp)->queue.head != NULL)
+#define chMtxGetOwnerI(mp)                  ((mp)->owner)
+#define chMtxLockS(mp)                      chMtxLock(mp)
+#define chMtxUnlockS(mp)                    chMtxUnlock(mp)
+#define chMBGetSizeI(mbp)                   ((size_t)((mbp)->top - (mbp)->buffer))
+#define chMBGetUsedCountI(mbp)              ((mbp)->cnt)
+#define chMBGetFreeCountI(mbp)              (chMBGetSizeI(mbp) - (mbp)->cnt)
+#define chMBPost(mbp, msg)                  chMBPostTimeout(mbp, msg, TIME_INFINITE)
+#define chMBFetch(mbp, msgp)                chMBFetchTimeout(mbp, msgp, TIME_INFINITE)
+#define chFifoTakeObject(ofp)               chFifoTakeObjectTimeout(ofp, TIME_INFINITE)
+#define chGuardedPoolAllocI(gmp)            chGuardedPoolAllocTimeout(gmp, TIME_IMMEDIATE)
+#define chGuardedPoolGetCounterI(gmp)       chSemGetCounterI(&(gmp)->sem)
+#define chThdGetPriorityX()                 (chThdGetSelfX()->prio)
+#define chThdTerminatedX(tp)                ((tp)->state == CH_STATE_FINAL)
+#define chThdQueueIsEmptyI(tqp)             ((tqp)->head == NULL)
+#define chThdQueueObjectInit(tqp)           ((tqp)->head = NULL)
+#define chRegSetThreadName(p)               (chThdGetSelfX()->name = (p))
+#define chRegGetThreadNameX(tp)             ((tp)->name)
+#define chSchIsPreemptionRequired()         false
+
+/*===========================================================================*/
+/* Inline functions.                                                         */
+/*===========================================================================*/
+
+static inline sysinterval_t chTimeDiffX(systime_t start, systime_t end) {
+    return (sysinterval_t)((systime_t)(end - start));
+}
+
+static inline systime_t chTimeAddX(systime_t systime, sysinterval_t interval) {
+    return systime + (systime_t)interval;
+}
+
+static inline bool chTimeIsInRangeX(systime_t time, systime_t start, systime_t end) {
+    return (bool)((systime_t)((systime_t)time - (systime_t)start) <
+                  (systime_t)((systime_t)end - (systime_t)start));
+}
+
+static inline void chMtxObjectInit(mutex_t *mp) {
+    mp->queue.head = NULL;
+    mp->owner = NULL;
+    mp->next = NULL;
+}
+
+static inline void chSemObjectInit(semaphore_t *sp, cnt_t n) {
+    sp->queue.head = NULL;
+    sp->cnt = n;
+}
+
+static inline void chBSemObjectInit(binary_semaphore_t *bsp, bool taken) {
+    chSemObjectInit(&bsp->sem, taken ? (cnt_t)0 : (cnt_t)1);
+}
+
+/*===========================================================================*/
+/* External declarations.                                                    */
+/*===========================================================================*/
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+/* System */
+void chSysInit(void);
+void chSysHalt(const char *reason);
+rtcnt_t chSysGetRealtimeCounterX(void);
+void chSysPolledDelayX(rtcnt_t cycles);
+
+/* Host control */
+void chHostSetSystemTime(systime_t time);
+void chHostSetHeapFull(bool full);
+uint64_t chHostTimeUS(void);
+void chHostISREnter(void);
+void chHostISRExit(void);
+void chHostDumpThreads(void);
+
+/* Virtual timers */
+systime_t chVTGetSystemTimeX(void);
+void chVTSetI(virtual_timer_t *vtp, sysinterval_t delay, vtfunc_t vtfunc, void *par);
+void chVTResetI(virtual_timer_t *vtp);
+void chVTDoResetI(virtual_timer_t *vtp);
+
+/* Scheduler */
+thread_t *chSchReadyI(thread_t *tp);
+void chSchGoSleepS(tstate_t newstate);
+msg_t chSchGoSleepTimeoutS(tstate_t newstate, sysinterval_t timeout);
+void chSchWakeupS(thread_t *ntp, msg_t msg);
+void chSchRescheduleS(void);
+
+/* Threads */
+thread_t *chThdCreateStatic(void *wsp, size_t size, tprio_t prio, tfunc_t pf, void *arg);
+thread_t *chThdCreateFromHeap(memory_heap_t *heapp, size_t size, const char *name,
+                              tprio_t prio, tfunc_t pf, void *arg);
+thread_t *chThdCreate(const thread_descriptor_t *tdp);
+thread_t *chThdGetSelfX(void);
+tprio_t chThdSetPriority(tprio_t newprio);
+void chThdTerminate(thread_t *tp);
+bool chThdShouldTerminateX(void);
+msg_t chThdWait(thread_t *tp);
+void chThdRelease(thread_t *tp);
+void chThdExit(msg_t msg);
+void chThdExitS(msg_t msg);
+void chThdSleep(sysinterval_t time);
+void chThdSleepS(sysinterval_t time);
+void chThdSleepUntil(systime_t time);
+systime_t chThdSleepUntilWindowed(systime_t prev, systime_t next);
+void chThdYield(void);
+msg_t chThdSuspendS(thread_reference_t *trp);
+msg_t chThdSuspendTimeoutS(thread_reference_t *trp, sysinterval_t timeout);
+void chThdResumeI(thread_reference_t *trp, msg_t msg);
+void chThdResumeS(thread_reference_t *trp, msg_t msg);
+void chThdResume(thread_reference_t *trp, msg_t msg);
+msg_t chThdEnqueueTimeoutS(threads_queue_t *tqp, sysinterval_t timeout);
+void chThdDequeueNextI(threads_queue_t *tqp, msg_t msg);
+void chThdDequeueAllI(threads_queue_t *tqp, msg_t msg);
+
+/* Mutexes */
+void chMtxLock(mutex_t *mp);
+bool chMtxTryLock(mutex_t *mp);
+bool chMtxTryLockS(mutex_t *mp);
+void chMtxUnlock(mutex_t *mp);
+void chMtxUnlockAll(void);
+
+/* Semaphores */
+msg_t chSemWaitTimeout(semaphore_t *sp, sysinterval_t timeout);
+msg_t chSemWaitTimeoutS(semaphore_t *sp, sysinterval_t timeout);
+void chSemSignal(semaphore_t *sp);
+void chSemSignalI(semaphore_t *sp);
+void chSemReset(semaphore_t *sp, cnt_t n);
+void chSemResetI(semaphore_t *sp, cnt_t n);
+msg_t chBSemWaitTimeout(binary_semaphore_t *bsp, sysinterval_t timeout);
+void chBSemSignal(binary_semaphore_t *bsp);
+void chBSemSignalI(binary_semaphore_t *bsp);
+void chBSemReset(binary_semaphore_t *bsp, bool taken);
+void chBSemResetI(binary_semaphore_t *bsp, bool taken);
+
+/* Events */
+void chEvtRegisterMaskWithFlags(event_source_t *esp, event_listener_t *elp,
+                                eventmask_t events, eventflags_t wflags);
+void chEvtUnregister(event_source_t *esp, event_listener_t *elp);
+eventmask_t chEvtGetAndClearEventsI(eventmask_t events);
+eventmask_t chEvtAddEvents(eventmask_t events);
+eventflags_t chEvtGetAndClearFlags(event_listener_t *elp);
+eventflags_t chEvtGetAndClearFlagsI(event_listener_t *elp);
+void chEvtSignal(thread_t *tp, eventmask_t events);
+void chEvtSignalI(thread_t *tp, eventmask_t events);
+void chEvtBroadcastFlags(event_source_t *esp, eventflags_t flags);
+void chEvtBroadcastFlagsI(event_source_t *esp, eventflags_t flags);
+void chEvtDispatch(const evhandler_t *handlers, eventmask_t events);
+eventmask_t chEvtWaitOne(eventmask_t events);
+eventmask_t chEvtWaitAny(eventmask_t events);
+eventmask_t chEvtWaitAll(eventmask_t events);
+eventmask_t chEvtWaitOneTimeout(eventmask_t events, sysinterval_t timeout);
+eventmask_t chEvtWaitAnyTimeout(eventmask_t events, sysinterval_t timeout);
+eventmask_t chEvtWaitAllTimeout(eventmask_t events, sysinterval_t timeout);
+
+/* Mailboxes */
+void chMBObjectInit(mailbox_t *mbp, msg_t *buf, size_t n);
+void chMBReset(mailbox_t *mbp);
+void chMBResetI(mailbox_t *mbp);
+msg_t chMBPostTimeout(mailbox_t *mbp, msg_t msg, sysinterval_t timeout);
+msg_t chMBPostI(mailbox_t *mbp, msg_t msg);
+msg_t chMBPostAheadTimeout(mailbox_t *mbp, msg_t msg, sysinterval_t timeout);
+msg_t chMBPostAheadI(mailbox_t *mbp, msg_t msg);
+msg_t chMBFetchTimeout(mailbox_t *mbp, msg_t *msgp, sysinterval_t timeout);
+msg_t chMBFetchI(mailbox_t *mbp, msg_t *msgp);
+
+/* Memory */
+void *chCoreAlloc(size_t size);
+void *chCoreAllocAligned(size_t size, unsigned align);
+void *chHeapAlloc(memory_heap_t *heapp, size_t size);
+void *chHeapAllocAligned(memory_heap_t *heapp, size_t size, unsigned align);
+void chHeapFree(void *p);
+void chPoolObjectInit(memory_pool_t *mp, size_t size, memgetfunc_t provider);
+void chPoolObjectInitAligned(memory_pool_t *mp, size_t size, unsigned align,
+                             memgetfunc_t provider);
+void chPoolLoadArray(memory_pool_t *mp, void *p, size_t n);
+void *chPoolAlloc(memory_pool_t *mp);
+void *chPoolAllocI(memory_pool_t *mp);
+void chPoolFree(memory_pool_t *mp, void *objp);
+void chPoolFreeI(memory_pool_t *mp, void *objp);
+void chGuardedPoolObjectInit(guarded_memory_pool_t *gmp, size_t size);
+void chGuardedPoolObjectInitAligned(guarded_memory_pool_t *gmp, size_t size, unsigned align);
+void chGuardedPoolLoadArray(guarded_memory_pool_t *gmp, void *p, size_t n);
+void *chGuardedPoolAllocTimeout(guarded_memory_pool_t *gmp, sysinterval_t timeout);
+void *chGuardedPoolAllocTimeoutS(guarded_memory_pool_t *gmp, sysinterval_t timeout);
+void chGuardedPoolFree(guarded_memory_pool_t *gmp, void *objp);
+void chGuardedPoolFreeI(guarded_memory_pool_t *gmp, void *objp);
+
+/* Objects FIFOs */
+void chFifoObjectInit(objects_fifo_t *ofp, size_t objsize, size_t objn,
+                      void *objbuf, msg_t *msgbuf);
+void chFifoObjectInitAligned(objects_fifo_t *ofp, size_t objsize, size_t objn,
+                             unsigned objalign, void *objbuf, msg_t *msgbuf);
+void *chFifoTakeObjectI(objects_fifo_t *ofp);
+void *chFifoTakeObjectTimeout(objects_fifo_t *ofp, sysinterval_t timeout);
+void chFifoReturnObjectI(objects_fifo_t *ofp, void *objp);
+void chFifoReturnObject(objects_fifo_t *ofp, void *objp);
+void chFifoSendObjectI(objects_fifo_t *ofp, void *objp);
+void chFifoSendObject(objects_fifo_t *ofp, void *objp);
+void chFifoSendObjectAheadI(objects_fifo_t *ofp, void *objp);
+void chFifoSendObjectAhead(objects_fifo_t *ofp, void *objp);
+msg_t chFifoReceiveObjectI(objects_fifo_t *ofp, void **objpp);
+msg_t chFifoReceiveObjectTimeout(objects_fifo_t *ofp, void **objpp, sysinterval_t timeout);
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _CH_H_ */
+
+/** @} */
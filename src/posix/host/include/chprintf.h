@@ -0,0 +1,31 @@
+/**
+ * @file    chprintf.h
+ * @brief   ChibiOS chprintf() for host builds.
+ * @details Streams are the host serial drivers, what is printed goes to the
+ *          file set with @p sdHostSetOutput() and is dropped otherwise.
+ *
+ * @addtogroup HOST_HAL
+ * @{
+ */
+#ifndef _CHPRINTF_H_
+#define _CHPRINTF_H_
+
+#include <stdarg.h>
+#include <stddef.h>
+#include "hal.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+int chvprintf(BaseSequentialStream *chp, const char *fmt, va_list ap);
+int chprintf(BaseSequentialStream *chp, const char *fmt, ...)
+    __attribute__((format(printf, 2, 3)));
+int chsnprintf(char *str, size_t size, const char *fmt, ...)
+    __attribute__((format(printf, 3, 4)));
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _CHPRINTF_H_ */
+
+/** @} */
@@ -0,0 +1,739 @@
+/**
+ * @file    hal.h
+ * @brief   ChibiOS/HAL subset for host builds.
+ * @details PAL, SPI, I2C, SDC, DAC and ADC with the API and state checks of the
+ *          real HAL, and a serial driver that only feeds @p chprintf().
+ *          Peripherals are models attached by the test or the board: an
+ *          SPI device answers to its chip select line, an I2C device to its
+ *          address, a card to the SDC driver it is inserted in. Transfers advance virtual time by their bus time. Input
+ *          lines are driven with @p palHostDriveLine(), edges on them run
+ *          the line callback and wake @p palWaitLineTimeout() as the EXTI
+ *          interrupt would.
+ *
+ * @addtogroup HOST_HAL
+ * @{
+ */
+#ifndef _HAL_H_
+#define _HAL_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include "ch.h"
+
+/*===========================================================================*/
+/* Driver constants.                                                         */
+/*===========================================================================*/
+
+#define _CHIBIOS_HAL_
+#define CH_HAL_STABLE                       1
+#define HAL_USE_PAL                         TRUE
+#define HAL_USE_SPI                         TRUE
+#define HAL_USE_I2C                         TRUE
+#define HAL_USE_DAC                         TRUE
+#define HAL_USE_ADC                         TRUE
+#define HAL_USE_SDC                         TRUE
+#define HAL_USE_SERIAL                      TRUE
+#define PAL_USE_CALLBACKS                   TRUE
+#define PAL_USE_WAIT                        TRUE
+#define SPI_USE_WAIT                        TRUE
+#define SPI_USE_MUTUAL_EXCLUSION            TRUE
+#define I2C_USE_MUTUAL_EXCLUSION            TRUE
+#define ADC_USE_MUTUAL_EXCLUSION            TRUE
+#define HAL_SUCCESS                         false
+#define HAL_FAILED                          true
+
+/* PAL */
+#define PAL_IOPORTS_WIDTH                   32U
+#define PAL_WHOLE_PORT                      ((ioportmask_t)0xFFFFFFFFU)
+#define PAL_LOW                             0U
+#define PAL_HIGH                            1U
+#define PAL_NOLINE                          0U
+
+#define PAL_MODE_RESET                      0U
+#define PAL_MODE_UNCONNECTED                1U
+#define PAL_MODE_INPUT                      2U
+#define PAL_MODE_INPUT_PULLUP               3U
+#define PAL_MODE_INPUT_PULLDOWN             4U
+#define PAL_MODE_INPUT_ANALOG               5U
+#define PAL_MODE_OUTPUT_PUSHPULL            6U
+#define PAL_MODE_OUTPUT_OPENDRAIN           7U
+#define PAL_MODE_ALTERNATE(n)               (16U + (n))
+
+#define PAL_EVENT_MODE_EDGES_MASK           3U
+#define PAL_EVENT_MODE_DISABLED             0U
+#define PAL_EVENT_MODE_RISING_EDGE          1U
+#define PAL_EVENT_MODE_FALLING_EDGE         2U
+#define PAL_EVENT_MODE_BOTH_EDGES           3U
+
+/* Ports, numbered from one so that no line is PAL_NOLINE */
+#define IOPORT1                             1U
+#define IOPORT2                             2U
+#define IOPORT3                             3U
+#define IOPORT4                             4U
+#define IOPORT5                             5U
+#define IOPORT6                             6U
+#define IOPORT7                             7U
+#define IOPORT8                             8U
+#define GPIOA                               IOPORT1
+#define GPIOB                               IOPORT2
+#define GPIOC                               IOPORT3
+#define GPIOD                               IOPORT4
+#define GPIOE                               IOPORT5
+#define GPIOF                               IOPORT6
+#define GPIOG                               IOPORT7
+#define GPIOH                               IOPORT8
+#define HAL_HOST_PORTS                      9U
+
+/* SPI, the STM32 SPI_CR1 bits the configurations use */
+#define SPI_CR1_CPHA                        0x0001U
+#define SPI_CR1_CPOL                        0x0002U
+#define SPI_CR1_MSTR                        0x0004U
+#define SPI_CR1_BR_Pos                      3U
+#define SPI_CR1_BR_Msk                      0x0038U
+#define SPI_CR1_BR_0                        0x0008U
+#define SPI_CR1_BR_1                        0x0010U
+#define SPI_CR1_BR_2                        0x0020U
+#define SPI_CR1_SPE                         0x0040U
+#define SPI_CR1_LSBFIRST                    0x0080U
+#define SPI_CR1_SSI                         0x0100U
+#define SPI_CR1_SSM                         0x0200U
+#define SPI_CR1_DFF                         0x0800U
+#define SPI_CR2_SSOE                        0x0004U
+#define SPI_CR2_DS_Pos                      8U
+#define SPI_CR2_DS_0                        0x0100U
+#define SPI_CR2_DS_1                        0x0200U
+#define SPI_CR2_DS_2                        0x0400U
+#define SPI_CR2_DS_3                        0x0800U
+
+/* I2C */
+#define I2C_NO_ERROR                        0x00U
+#define I2C_BUS_ERROR                       0x01U
+#define I2C_ARBITRATION_LOST                0x02U
+#define I2C_ACK_FAILURE                     0x04U
+#define I2C_OVERRUN                         0x08U
+#define I2C_PEC_ERROR                       0x10U
+#define I2C_TIMEOUT                         0x20U
+#define I2C_SMB_ALERT                       0x40U
+
+/* I2Cv1 configuration values, so F4 configurations build */
+#define OPMODE_I2C                          1U
+#define STD_DUTY_CYCLE                      1U
+
+#define STM32_TIMINGR_PRESC(n)              ((uint32_t)(n) << 28)
+#define STM32_TIMINGR_SCLDEL(n)             ((uint32_t)(n) << 20)
+#define STM32_TIMINGR_SDADEL(n)             ((uint32_t)(n) << 16)
+#define STM32_TIMINGR_SCLH(n)               ((uint32_t)(n) << 8)
+#define STM32_TIMINGR_SCLL(n)               ((uint32_t)(n) << 0)
+
+/* SDC */
+#define MMCSD_BLOCK_SIZE                    512U
+#define SDC_NO_ERROR                        0U
+#define SDC_CMD_CRC_ERROR                   1U
+#define SDC_DATA_CRC_ERROR                  2U
+#define SDC_DATA_TIMEOUT                    4U
+#define SDC_COMMAND_TIMEOUT                 8U
+#define SDC_TX_UNDERRUN                     16U
+#define SDC_RX_OVERRUN                      32U
+#define SDC_STARTBIT_ERROR                  64U
+#define SDC_OVERFLOW_ERROR                  128U
+#define SDC_UNHANDLED_ERROR                 0xFFFFFFFFU
+
+/* DAC, the STM32 data holding register modes */
+#define DAC_DHRM_12BIT_RIGHT                0U
+#define DAC_DHRM_12BIT_LEFT                 1U
+#define DAC_DHRM_8BIT_RIGHT                 2U
+#define HAL_HOST_DAC_CHANNELS               2U
+
+/* ADC, the STM32F0 ADCv1 register bits the conversion groups use */
+#define ADC_CFGR1_CONT                      0x00002000U
+#define ADC_CFGR1_RES_12BIT                 0x00000000U
+#define ADC_TR(low, high)                   (((uint32_t)(high) << 16U) | (uint32_t)(low))
+#define ADC_SMPR_SMP_239P5                  0x00000007U
+#define ADC_CHSELR_CHSEL(n)                 (1U << (n))
+#define ADC_CHSELR_CHSEL16                  ADC_CHSELR_CHSEL(16U)
+#define ADC_CHSELR_CHSEL17                  ADC_CHSELR_CHSEL(17U)
+#define HAL_HOST_ADC_CHANNELS               19U
+
+/* CRC, there is no unit: crc32_hw() builds against plain registers and
+   crc32() takes the software path */
+#define STM32_HAS_CRC                       FALSE
+#define STM32_CRC_PROGRAMMABLE              TRUE
+#define CRC_CR_RESET                        0x00000001U
+#define CRC_CR_POLYSIZE_Pos                 3U
+#define CRC_CR_POLYSIZE_Msk                 0x00000018U
+#define CRC_CR_REV_IN_Pos                   5U
+#define CRC_CR_REV_IN_Msk                   0x00000060U
+#define CRC_CR_REV_OUT                      0x00000080U
+#define CRC                                 (&CRC_HOST)
+
+/* EFL, the flash_error_t codes, there is no flash to program */
+#define FLASH_NO_ERROR                      0
+#define FLASH_BUSY_ERASING                  1
+#define FLASH_ERROR_READ                    2
+#define FLASH_ERROR_PROGRAM                 3
+#define FLASH_ERROR_ERASE                   4
+#define FLASH_ERROR_VERIFY                  5
+#define FLASH_ERROR_HW_FAILURE              6
+#define FLASH_ERROR_UNIMPLEMENTED           7
+
+/*===========================================================================*/
+/* Driver pre-compile time settings.                                         */
+/*===========================================================================*/
+
+/**
+ * @brief   Peripheral clock the SPI baud rate divider applies to.
+ */
+#if !defined(HAL_HOST_SPI_PCLK) || defined(__DOXYGEN__)
+#define HAL_HOST_SPI_PCLK                   84000000U
+#endif
+
+/**
+ * @brief   Devices that can be attached to one SPI bus.
+ */
+#if !defined(HAL_HOST_SPI_DEVICES) || defined(__DOXYGEN__)
+#define HAL_HOST_SPI_DEVICES                4U
+#endif
+
+/**
+ * @brief   Devices that can be attached to one I2C bus.
+ */
+#if !defined(HAL_HOST_I2C_DEVICES) || defined(__DOXYGEN__)
+#define HAL_HOST_I2C_DEVICES                8U
+#endif
+
+/**
+ * @brief   I2C bus clock used for the bus time.
+ */
+#if !defined(HAL_HOST_I2C_HZ) || defined(__DOXYGEN__)
+#define HAL_HOST_I2C_HZ                     100000U
+#endif
+
+/**
+ * @brief   SDC bus clock used for the bus time, per data line.
+ */
+#if !defined(HAL_HOST_SDC_HZ) || defined(__DOXYGEN__)
+#define HAL_HOST_SDC_HZ                     24000000U
+#endif
+
+/*===========================================================================*/
+/* Driver data structures and types.                                         */
+/*===========================================================================*/
+
+/* PAL */
+typedef uint32_t ioportid_t;
+typedef uint32_t iopadid_t;
+typedef uint32_t ioportmask_t;
+typedef uint32_t iomode_t;
+typedef uint32_t ioline_t;
+typedef void (*palcallback_t)(void *arg);
+
+/**
+ * @brief   Output observer, runs on every write to a line.
+ */
+typedef void (*palhostout_t)(void *arg, ioline_t line, bool level);
+
+/* SPI */
+typedef enum {
+    SPI_UNINIT = 0,
+    SPI_STOP = 1,
+    SPI_READY = 2,
+    SPI_ACTIVE = 3,
+    SPI_COMPLETE = 4
+} spistate_t;
+
+typedef struct hal_spi_driver SPIDriver;
+typedef void (*spicallback_t)(SPIDriver *spip);
+
+/**
+ * @brief   SPI configuration, same layout as the STM32 driver in line mode.
+ */
+typedef struct {
+    bool                        circular;
+    spicallback_t               end_cb;
+    ioline_t                    ssline;
+    uint16_t                    cr1;
+    uint16_t                    cr2;
+} SPIConfig;
+
+/**
+ * @brief   SPI device model hooks.
+ * @note    @p exchange gets NULL for @p txbuf when the master only
+ *          receives, the device sees all ones, and NULL for @p rxbuf when
+ *          it only sends. @p complete runs as an interrupt after every
+ *          transfer, for devices with an IRQ line to update.
+ */
+typedef struct {
+    void                        *arg;
+    void                        (*select)(void *arg);
+    void                        (*exchange)(void *arg, const uint8_t *txbuf,
+                                            uint8_t *rxbuf, size_t n);
+    void                        (*unselect)(void *arg);
+    void                        (*complete)(void *arg);
+} spi_host_device_t;
+
+struct hal_spi_driver {
+    spistate_t                  state;
+    const SPIConfig             *config;
+    mutex_t                     mutex;
+    struct {
+        ioline_t                line;
+        const spi_host_device_t *dev;
+    } devices[HAL_HOST_SPI_DEVICES];
+    const spi_host_device_t     *selected;
+    uint64_t                    debt_ns;        /**< Bus time not slept yet.     */
+    uint32_t                    xfers;          /**< Transactions, on select.    */
+    uint32_t                    bytes;          /**< Bytes moved on the bus.     */
+};
+
+/* I2C */
+typedef enum {
+    I2C_UNINIT = 0,
+    I2C_STOP = 1,
+    I2C_READY = 2,
+    I2C_ACTIVE_TX = 3,
+    I2C_ACTIVE_RX = 4,
+    I2C_LOCKED = 5
+} i2cstate_t;
+
+typedef uint16_t i2caddr_t;
+typedef uint32_t i2cflags_t;
+
+/**
+ * @brief   I2C configuration, same layout as the STM32 I2Cv2 driver.
+ */
+typedef struct {
+    uint32_t                    timingr;
+    uint32_t                    cr1;
+    uint32_t                    cr2;
+} I2CConfig;
+
+/**
+ * @brief   I2C device model hooks.
+ * @details One call per transaction: the write phase, then a repeated
+ *          start and the read phase when @p rxbytes is not zero. Returns
+ *          MSG_OK, or MSG_RESET for a NACK.
+ */
+typedef struct {
+    void                        *arg;
+    msg_t                       (*transfer)(void *arg, const uint8_t *txbuf, size_t txbytes,
+                                            uint8_t *rxbuf, size_t rxbytes);
+} i2c_host_device_t;
+
+/**
+ * @brief   Transaction observer, runs after every transfer on the bus
+ *          whether a device answered or not.
+ */
+typedef void (*i2chostxfer_t)(void *arg, i2caddr_t addr, const uint8_t *txbuf,
+                              size_t txbytes, size_t rxbytes, msg_t msg);
+
+typedef struct hal_i2c_driver {
+    i2cstate_t                  state;
+    const I2CConfig             *config;
+    i2cflags_t                  errors;
+    mutex_t                     mutex;
+    struct {
+        i2caddr_t               addr;
+        const i2c_host_device_t *dev;
+    } devices[HAL_HOST_I2C_DEVICES];
+    i2chostxfer_t               hook;
+    void                        *hook_arg;
+    uint64_t                    debt_ns;        /**< Bus time not slept yet.     */
+    uint32_t                    xfers;          /**< Transactions.               */
+    uint32_t                    bytes;          /**< Data bytes moved.           */
+} I2CDriver;
+
+/* SDC */
+typedef enum {
+    BLK_UNINIT = 0,
+    BLK_STOP = 1,
+    BLK_ACTIVE = 2,
+    BLK_CONNECTING = 3,
+    BLK_DISCONNECTING = 4,
+    BLK_READY = 5,
+    BLK_READING = 6,
+    BLK_WRITING = 7,
+    BLK_SYNCING = 8
+} blkstate_t;
+
+typedef enum {
+    SDC_MODE_1BIT = 0,
+    SDC_MODE_4BIT = 1,
+    SDC_MODE_8BIT = 2
+} sdcbusmode_t;
+
+typedef uint32_t sdcflags_t;
+
+typedef struct {
+    uint32_t                    blk_size;
+    uint32_t                    blk_num;
+} BlockDeviceInfo;
+
+/**
+ * @brief   SDC configuration, same layout as the STM32 SDCv1 driver.
+ */
+typedef struct {
+    sdcbusmode_t                bus_width;
+    uint32_t                    slowdown;
+} SDCConfig;
+
+/**
+ * @brief   Card model hooks.
+ * @details Whole blocks of @p MMCSD_BLOCK_SIZE bytes, @p read and
+ *          @p write return @p HAL_SUCCESS or @p HAL_FAILED for a card
+ *          error.
+ */
+typedef struct {
+    void                        *arg;
+    uint32_t                    blocks;
+    bool                        (*read)(void *arg, uint32_t startblk,
+                                        uint8_t *buf, uint32_t n);
+    bool                        (*write)(void *arg, uint32_t startblk,
+                                         const uint8_t *buf, uint32_t n);
+} sdc_host_device_t;
+
+typedef struct hal_sdc_driver {
+    blkstate_t                  state;
+    const SDCConfig             *config;
+    sdcflags_t                  errors;
+    const sdc_host_device_t     *dev;
+    uint64_t                    debt_ns;        /**< Bus time not slept yet.     */
+    uint32_t                    reads;          /**< Blocks read.                */
+    uint32_t                    writes;         /**< Blocks written.             */
+} SDCDriver;
+
+/* The MMC/SD block device the SDC driver derives from */
+typedef SDCDriver MMCSDBlockDevice;
+
+/**
+ * @brief   Card identification, the MMC fields.
+ */
+typedef struct {
+    uint8_t                     crc;
+    uint8_t                     mdt_y;
+    uint8_t                     mdt_m;
+    uint32_t                    psn;
+    uint8_t                     prv_m;
+    uint8_t                     prv_n;
+    char                        pnm[6];
+    uint8_t                     cbx;
+    uint8_t                     mid;
+} unpacked_mmc_cid_t;
+
+/**
+ * @brief   Card specific data, the MMC fields the firmware reports.
+ */
+typedef struct {
+    uint8_t                     crc;
+    uint8_t                     csd_structure;
+    uint8_t                     spec_vers;
+    uint16_t                    ccc;
+    uint8_t                     read_bl_len;
+    uint8_t                     write_bl_len;
+    uint16_t                    c_size;
+    uint8_t                     c_size_mult;
+    uint8_t                     tran_speed;
+} unpacked_mmc_csd_t;
+
+/* DAC */
+typedef enum {
+    DAC_UNINIT = 0,
+    DAC_STOP = 1,
+    DAC_READY = 2
+} dacstate_t;
+
+typedef uint16_t dacsample_t;
+typedef uint32_t dacchannel_t;
+
+/**
+ * @brief   DAC configuration, same layout as the STM32 DACv1 driver.
+ */
+typedef struct {
+    dacsample_t                 init;
+    uint32_t                    datamode;
+    uint32_t                    cr;
+} DACConfig;
+
+/**
+ * @brief   Output observer, runs on every conversion the firmware starts.
+ */
+typedef void (*dachostout_t)(void *arg, dacchannel_t channel, dacsample_t sample);
+
+typedef struct hal_dac_driver {
+    dacstate_t                  state;
+    const DACConfig             *config;
+    dacsample_t                 output[HAL_HOST_DAC_CHANNELS];
+    dachostout_t                hook;
+    void                        *hook_arg;
+} DACDriver;
+
+/* ADC */
+typedef enum {
+    ADC_UNINIT = 0,
+    ADC_STOP = 1,
+    ADC_READY = 2,
+    ADC_ACTIVE = 3,
+    ADC_COMPLETE = 4,
+    ADC_ERROR = 5
+} adcstate_t;
+
+typedef enum {
+    ADC_ERR_DMAFAILURE = 0,
+    ADC_ERR_OVERFLOW = 1,
+    ADC_ERR_AWD = 2
+} adcerror_t;
+
+typedef uint16_t adcsample_t;
+typedef uint16_t adc_channels_num_t;
+
+typedef struct hal_adc_driver ADCDriver;
+typedef void (*adccallback_t)(ADCDriver *adcp);
+typedef void (*adcerrorcallback_t)(ADCDriver *adcp, adcerror_t err);
+
+/**
+ * @brief   ADC configuration, same layout as the STM32 ADCv1 driver.
+ */
+typedef struct {
+    uint32_t                    dummy;
+} ADCConfig;
+
+/**
+ * @brief   Conversion group, same layout as the STM32 ADCv1 driver.
+ * @note    A sequence converts the @p chselr channels in ascending order.
+ */
+typedef struct {
+    bool                        circular;
+    adc_channels_num_t          num_channels;
+    adccallback_t               end_cb;
+    adcerrorcallback_t          error_cb;
+    uint32_t                    cfgr1;
+    uint32_t                    tr;
+    uint32_t                    smpr;
+    uint32_t                    chselr;
+} ADCConversionGroup;
+
+/**
+ * @brief   Input model, the sample a channel converts to.
+ */
+typedef adcsample_t (*adchostin_t)(void *arg, unsigned channel);
+
+struct hal_adc_driver {
+    adcstate_t                  state;
+    const ADCConfig             *config;
+    const ADCConversionGroup    *grpp;
+    adcsample_t                 *samples;
+    size_t                      depth;
+    mutex_t                     mutex;
+    adchostin_t                 hook;
+    void                        *hook_arg;
+    size_t                      pos;            /**< Next sequence the DMA fills. */
+    uint32_t                    sequences;      /**< Sequences converted.        */
+};
+
+/* CRC */
+typedef struct {
+    volatile uint32_t           DR;
+    volatile uint32_t           IDR;
+    volatile uint32_t           CR;
+    uint32_t                    RESERVED;
+    volatile uint32_t           INIT;
+    volatile uint32_t           POL;
+} CRC_TypeDef;
+
+/* EFL, the driver type for code that names it */
+typedef uint32_t flash_offset_t;
+
+typedef struct {
+    int                         bank;           /**< Bank a test selected.       */
+} EFlashDriver;
+
+/* Serial, output only */
+typedef struct {
+    FILE                        *out;
+} SerialDriver;
+
+/* Stream the firmware casts its serial drivers to, as in hal_streams.h */
+typedef struct BaseSequentialStream BaseSequentialStream;
+
+/*===========================================================================*/
+/* Driver macros.                                                            */
+/*===========================================================================*/
+
+/* OSAL */
+#define osalDbgCheck(c)                     chDbgCheck(c)
+#define osalDbgAssert(c, remark)            chDbgAssert(c, remark)
+#define osalDbgCheckClassI()
+#define osalDbgCheckClassS()
+#define osalSysHalt(reason)                 chSysHalt(reason)
+#define osalSysLock()
+#define osalSysUnlock()
+#define osalSysLockFromISR()
+#define osalSysUnlockFromISR()
+#define osalSysGetStatusAndLockX()          ((syssts_t)0)
+#define osalSysRestoreStatusX(sts)          ((void)(sts))
+#define osalOsRescheduleS()                 chSchRescheduleS()
+#define osalOsGetSystemTimeX()              chVTGetSystemTimeX()
+#define osalThreadSleep(time)               chThdSleep(time)
+#define osalThreadSleepS(time)              chThdSleepS(time)
+#define osalThreadSleepMilliseconds(msec)   chThdSleepMilliseconds(msec)
+#define osalThreadSleepMicroseconds(usec)   chThdSleepMicroseconds(usec)
+#define osalThreadSuspendS(trp)             chThdSuspendS(trp)
+#define osalThreadSuspendTimeoutS(trp, t)   chThdSuspendTimeoutS(trp, t)
+#define osalThreadResumeI(trp, msg)         chThdResumeI(trp, msg)
+#define osalThreadResumeS(trp, msg)         chThdResumeS(trp, msg)
+#define osalThreadQueueObjectInit(tqp)      chThdQueueObjectInit(tqp)
+#define osalThreadEnqueueTimeoutS(tqp, t)   chThdEnqueueTimeoutS(tqp, t)
+#define osalThreadDequeueNextI(tqp, msg)    chThdDequeueNextI(tqp, msg)
+#define osalThreadDequeueAllI(tqp, msg)     chThdDequeueAllI(tqp, msg)
+#define osalMutexObjectInit(mp)             chMtxObjectInit(mp)
+#define osalMutexLock(mp)                   chMtxLock(mp)
+#define osalMutexUnlock(mp)                 chMtxUnlock(mp)
+#define OSAL_MS2I(msecs)                    TIME_MS2I(msecs)
+#define OSAL_US2I(usecs)                    TIME_US2I(usecs)
+#define OSAL_IRQ_PROLOGUE()
+#define OSAL_IRQ_EPILOGUE()
+
+/* Base object, the device drivers derive from it */
+#define _base_object_methods                size_t instance_offset;
+#define _base_object_data
+
+/* PAL */
+#define PAL_PORT_BIT(n)                     ((ioportmask_t)(1U << (n)))
+#define PAL_LINE(port, pad)                 ((ioline_t)(((uint32_t)(port) << 5U) | (uint32_t)(pad)))
+#define PAL_PORT(line)                      ((ioportid_t)((uint32_t)(line) >> 5U))
+#define PAL_PAD(line)                       ((iopadid_t)((uint32_t)(line) & 0x1FU))
+#define palReadPad(port, pad)               palReadLine(PAL_LINE(port, pad))
+#define palWritePad(port, pad, bit)         palWriteLine(PAL_LINE(port, pad), bit)
+#define palSetPad(port, pad)                palSetLine(PAL_LINE(port, pad))
+#define palClearPad(port, pad)              palClearLine(PAL_LINE(port, pad))
+#define palTogglePad(port, pad)             palToggleLine(PAL_LINE(port, pad))
+#define palSetPadMode(port, pad, mode)      palSetLineMode(PAL_LINE(port, pad), mode)
+#define palEnableLineEventI(line, mode)     palEnableLineEvent(line, mode)
+#define palDisableLineEventI(line)          palDisableLineEvent(line)
+#define palSetLineCallbackI(line, cb, arg)  palSetLineCallback(line, cb, arg)
+
+/* SPI */
+#define spiIsBufferComplete(spip)           false
+
+/* ADC */
+#define adcIsBufferComplete(adcp)           ((bool)((adcp)->state == ADC_COMPLETE))
+
+/*===========================================================================*/
+/* External declarations.                                                    */
+/*===========================================================================*/
+
+extern SPIDriver SPID1;
+extern SPIDriver SPID2;
+extern SPIDriver SPID3;
+extern I2CDriver I2CD1;
+extern I2CDriver I2CD2;
+extern SDCDriver SDCD1;
+extern DACDriver DACD1;
+extern ADCDriver ADCD1;
+extern CRC_TypeDef CRC_HOST;
+extern EFlashDriver EFLD1;
+extern SerialDriver SD1;
+extern SerialDriver SD2;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+void halInit(void);
+void boardInit(void);
+
+/* PAL */
+uint8_t palReadLine(ioline_t line);
+void palWriteLine(ioline_t line, uint8_t bit);
+void palSetLine(ioline_t line);
+void palClearLine(ioline_t line);
+void palToggleLine(ioline_t line);
+void palSetLineMode(ioline_t line, iomode_t mode);
+void palEnableLineEvent(ioline_t line, uint32_t mode);
+void palDisableLineEvent(ioline_t line);
+bool palIsLineEventEnabledX(ioline_t line);
+void palSetLineCallback(ioline_t line, palcallback_t cb, void *arg);
+msg_t palWaitLineTimeout(ioline_t line, sysinterval_t timeout);
+msg_t palWaitLineTimeoutS(ioline_t line, sysinterval_t timeout);
+iomode_t palHostGetLineMode(ioline_t line);
+void palHostDriveLine(ioline_t line, bool level);
+void palHostSetOutputHook(ioline_t line, palhostout_t hook, void *arg);
+
+/* SPI */
+void spiObjectInit(SPIDriver *spip);
+void spiHostAttach(SPIDriver *spip, ioline_t ssline, const spi_host_device_t *dev);
+uint32_t spiHostClock(const SPIConfig *config);
+msg_t spiStart(SPIDriver *spip, const SPIConfig *config);
+void spiStop(SPIDriver *spip);
+void spiAcquireBus(SPIDriver *spip);
+void spiReleaseBus(SPIDriver *spip);
+void spiSelect(SPIDriver *spip);
+void spiUnselect(SPIDriver *spip);
+void spiIgnore(SPIDriver *spip, size_t n);
+void spiExchange(SPIDriver *spip, size_t n, const void *txbuf, void *rxbuf);
+void spiSend(SPIDriver *spip, size_t n, const void *txbuf);
+void spiReceive(SPIDriver *spip, size_t n, void *rxbuf);
+uint16_t spiPolledExchange(SPIDriver *spip, uint16_t frame);
+
+/* I2C */
+void i2cObjectInit(I2CDriver *i2cp);
+void i2cHostAttach(I2CDriver *i2cp, i2caddr_t addr, const i2c_host_device_t *dev);
+void i2cHostSetTransferHook(I2CDriver *i2cp, i2chostxfer_t hook, void *arg);
+msg_t i2cStart(I2CDriver *i2cp, const I2CConfig *config);
+void i2cStop(I2CDriver *i2cp);
+void i2cAcquireBus(I2CDriver *i2cp);
+void i2cReleaseBus(I2CDriver *i2cp);
+i2cflags_t i2cGetErrors(I2CDriver *i2cp);
+msg_t i2cMasterTransmitTimeout(I2CDriver *i2cp, i2caddr_t addr,
+                               const uint8_t *txbuf, size_t txbytes,
+                               uint8_t *rxbuf, size_t rxbytes,
+                               sysinterval_t timeout);
+msg_t i2cMasterReceiveTimeout(I2CDriver *i2cp, i2caddr_t addr,
+                              uint8_t *rxbuf, size_t rxbytes,
+                              sysinterval_t timeout);
+
+/* SDC */
+void sdcObjectInit(SDCDriver *sdcp);
+void sdcHostInsert(SDCDriver *sdcp, const sdc_host_device_t *dev);
+msg_t sdcStart(SDCDriver *sdcp, const SDCConfig *config);
+void sdcStop(SDCDriver *sdcp);
+bool sdcConnect(SDCDriver *sdcp);
+bool sdcDisconnect(SDCDriver *sdcp);
+sdcflags_t sdcGetAndClearErrors(SDCDriver *sdcp);
+bool blkRead(SDCDriver *sdcp, uint32_t startblk, uint8_t *buf, uint32_t n);
+bool blkWrite(SDCDriver *sdcp, uint32_t startblk, const uint8_t *buf, uint32_t n);
+bool blkSync(SDCDriver *sdcp);
+bool blkGetInfo(SDCDriver *sdcp, BlockDeviceInfo *bdip);
+void _mmcsd_unpack_mmc_cid(const MMCSDBlockDevice *sdcp, unpacked_mmc_cid_t *cidmmc);
+void _mmcsd_unpack_csd_mmc(const MMCSDBlockDevice *sdcp, unpacked_mmc_csd_t *csdmmc);
+
+/* DAC */
+void dacObjectInit(DACDriver *dacp);
+void dacHostSetOutputHook(DACDriver *dacp, dachostout_t hook, void *arg);
+msg_t dacStart(DACDriver *dacp, const DACConfig *config);
+void dacStop(DACDriver *dacp);
+void dacPutChannelX(DACDriver *dacp, dacchannel_t channel, dacsample_t sample);
+
+/* ADC */
+void adcObjectInit(ADCDriver *adcp);
+void adcHostSetInputHook(ADCDriver *adcp, adchostin_t hook, void *arg);
+void adcHostConvert(ADCDriver *adcp, size_t n);
+msg_t adcStart(ADCDriver *adcp, const ADCConfig *config);
+void adcStop(ADCDriver *adcp);
+void adcAcquireBus(ADCDriver *adcp);
+void adcReleaseBus(ADCDriver *adcp);
+void adcStartConversion(ADCDriver *adcp, const ADCConversionGroup *grpp,
+                        adcsample_t *samples, size_t depth);
+void adcStopConversion(ADCDriver *adcp);
+
+/* Serial */
+void sdHostSetOutput(SerialDriver *sdp, FILE *out);
+#ifdef __cplusplus
+}
+#endif
+
+#include "board.h"
+
+#endif /* _HAL_H_ */
+
+/** @} */
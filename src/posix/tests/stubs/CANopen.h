@@ -0,0 +1,86 @@
+/*
+ * Stand-in for CANopenNode in the host tests: app code only uses the
+ * generated OD.h, which needs the OD_t and bool_t types, the NMT state and
+ * SDO abort code types, and the OD lock
+ * from common/include/CO_driver_target.h. Tests that take the lock define
+ * od_mutex and od_seq. node_mgr also uses OD_getSub() and the heartbeat
+ * consumer, declared here and implemented by the tests that link it.
+ */
+#ifndef _CANOPEN_STUB_H_
+#define _CANOPEN_STUB_H_
+
+#include <stdint.h>
+#include "ch.h"
+
+/* As in common/include/CO_driver_target.h */
+typedef uint_fast8_t            bool_t;
+
+/* As in CANopenNode 301/CO_ODinterface.h, without the attribute details */
+typedef uint32_t                OD_size_t;
+
+typedef enum {
+    ODR_OK = 0,
+    ODR_SUB_NOT_EXIST = 14
+} ODR_t;
+
+typedef struct {
+    uint16_t                    index;
+    uint8_t                     subEntriesCount;
+    uint8_t                     odObjectType;
+    void                        *odObject;
+} OD_entry_t;
+
+typedef struct {
+    OD_size_t                   size;
+    OD_entry_t                  *list;
+} OD_t;
+
+typedef struct {
+    void                        *dataOrig;
+    void                        *object;
+    OD_size_t                   dataLength;
+    OD_size_t                   dataOffset;
+    uint8_t                     subIndex;
+} OD_stream_t;
+
+typedef struct {
+    OD_stream_t                 stream;
+    ODR_t                       (*read)(OD_stream_t *stream, void *buf,
+                                        OD_size_t count, OD_size_t *countRead);
+    ODR_t                       (*write)(OD_stream_t *stream, const void *buf,
+                                         OD_size_t count, OD_size_t *countWritten);
+} OD_IO_t;
+
+ODR_t OD_getSub(const OD_entry_t *entry, uint8_t subIndex, OD_IO_t *io, bool_t odOrig);
+
+/* As in CANopenNode 301/CO_NMT_Heartbeat.h */
+typedef enum {
+    CO_NMT_UNKNOWN = -1,
+    CO_NMT_INITIALIZING = 0,
+    CO_NMT_PRE_OPERATIONAL = 127,
+    CO_NMT_OPERATIONAL = 5,
+    CO_NMT_STOPPED = 4
+} CO_NMT_internalState_t;
+
+/* As in CANopenNode 301/CO_SDOserver.h, the codes are not used */
+typedef uint32_t CO_SDO_abortCode_t;
+
+/* As in CANopenNode 301/CO_HBconsumer.h and CANopen.h, opaque here */
+typedef struct CO_HBconsumer_t CO_HBconsumer_t;
+
+typedef struct {
+    CO_HBconsumer_t             *HBcons;
+} CO_t;
+
+int8_t CO_HBconsumer_getIdxByNodeId(CO_HBconsumer_t *HBcons, uint8_t nodeId);
+void CO_HBconsumer_initCallbackNmtChanged(CO_HBconsumer_t *HBcons, uint8_t idx, void *object,
+                                          void (*pFunctSignal)(uint8_t nodeId, uint8_t idx,
+                                                               CO_NMT_internalState_t NMTstate,
+                                                               void *object));
+
+extern mutex_t od_mutex;
+extern volatile uint32_t od_seq;
+#define CO_LOCK_OD(CAN_MODULE)            do {chMtxLock(&od_mutex); od_seq++; __DMB();} while (0)
+#define CO_UNLOCK_OD(CAN_MODULE)          do {__DMB(); od_seq++; chMtxUnlock(&od_mutex);} while (0)
+
+#endif /* _CANOPEN_STUB_H_ */
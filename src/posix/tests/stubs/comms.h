@@ -0,0 +1,15 @@
+/*
+ * Stand-in for the app_control comms.h in the host tests, which pulls in
+ * the radio and USLP stack: only the downlink FEC settings the fec shell
+ * command uses.
+ */
+#ifndef _COMMS_STUB_H_
+#define _COMMS_STUB_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+bool comms_set_fec(uint8_t depth, bool conv);
+void comms_get_fec(uint8_t *depth, bool *conv);
+
+#endif /* _COMMS_STUB_H_ */
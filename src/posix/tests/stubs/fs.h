@@ -0,0 +1,59 @@
+/*
+ * Stand-in for common/include/fs.h in the host tests that do not run
+ * littlefs: the types and calls app code uses, with the same names. Tests
+ * that include it implement the calls, typically over files held in
+ * memory, and define FSD1.
+ */
+#ifndef _FS_STUB_H_
+#define _FS_STUB_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "ch.h"
+
+typedef int32_t lfs_ssize_t;
+typedef int32_t lfs_soff_t;
+typedef uint32_t lfs_size_t;
+typedef uint32_t lfs_off_t;
+
+enum lfs_error {
+    LFS_ERR_OK          = 0,
+    LFS_ERR_IO          = -5,
+    LFS_ERR_CORRUPT     = -84,
+    LFS_ERR_NOENT       = -2,
+    LFS_ERR_BADF        = -9,
+    LFS_ERR_INVAL       = -22,
+    LFS_ERR_NOSPC       = -28,
+};
+
+enum lfs_open_flags {
+    LFS_O_RDONLY = 1,
+    LFS_O_WRONLY = 2,
+    LFS_O_RDWR   = 3,
+    LFS_O_CREAT  = 0x0100,
+};
+
+typedef struct {
+    const char                  *name;
+    const uint8_t               *data;
+    lfs_size_t                  size;
+    lfs_off_t                   pos;
+    bool                        open;
+} lfs_file_t;
+
+typedef struct {
+    int                         err;
+} FSDriver;
+
+extern FSDriver FSD1;
+
+int fs_format(FSDriver *fsp);
+int fs_unmount(FSDriver *fsp);
+int fs_remove(FSDriver *fsp, const char *path);
+lfs_file_t *file_open(FSDriver *fsp, const char *path, int flags);
+int file_close(FSDriver *fsp, lfs_file_t *file);
+lfs_ssize_t file_read(FSDriver *fsp, lfs_file_t *file, void *buffer, lfs_size_t size);
+lfs_soff_t file_size(FSDriver *fsp, lfs_file_t *file);
+uint32_t file_crc(FSDriver *fsp, lfs_file_t *file);
+
+#endif /* _FS_STUB_H_ */
@@ -0,0 +1,15 @@
+/*
+ * Stand-in for common/include/rtc.h in the host tests, which needs the
+ * RTC driver: only the Unix time calls. Tests that include it implement
+ * them.
+ */
+#ifndef _RTC_STUB_H_
+#define _RTC_STUB_H_
+
+#include <stdint.h>
+#include <time.h>
+
+time_t rtcGetTimeUnix(uint32_t *msec);
+void rtcSetTimeUnix(time_t unix_time, uint32_t msec);
+
+#endif /* _RTC_STUB_H_ */
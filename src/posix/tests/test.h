@@ -0,0 +1,37 @@
+/*
+ * Minimal checks for the host tests. A failed check prints where and stops
+ * the test binary with a non-zero status, so make check stops there too.
+ */
+#ifndef _TEST_H_
+#define _TEST_H_
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#define TEST_CHECK(c)                                                       \
+    do {                                                                    \
+        if (!(c)) {                                                         \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #c); \
+            exit(1);                                                        \
+        }                                                                   \
+    } while (0)
+
+#define TEST_EQUAL(a, b)                                                    \
+    do {                                                                    \
+        long long _a = (long long)(a), _b = (long long)(b);                 \
+        if (_a != _b) {                                                     \
+            fprintf(stderr, "%s:%d: %s == %s failed: %lld != %lld\n",       \
+                    __FILE__, __LINE__, #a, #b, _a, _b);                    \
+            exit(1);                                                        \
+        }                                                                   \
+    } while (0)
+
+#define TEST_RUN(fn)                                                        \
+    do {                                                                    \
+        printf("%-40s ", #fn);                                              \
+        fflush(stdout);                                                     \
+        fn();                                                               \
+        printf("ok\n");                                                     \
+    } while (0)
+
+#endif /* _TEST_H_ */
@@ -0,0 +1,316 @@
+/*
+ * Runs the AX5043 driver against the register level model: the VCO range
+ * cache and PLL lock on retune, and the RX worker's batched FIFO reads and
+ * accounting of frames dropped on error flags.
+ */
+#include <string.h>
+#include "ch.h"
+#include "hal.h"
+#include "ax5043.h"
+#include "radio.h"
+#include "test.h"
+
+#define FB_COUNT                            4U
+
+objects_fifo_t rx_fifo;
+static msg_t rx_fifo_msgs[FB_COUNT];
+static fb_t rx_fifo_buf[FB_COUNT];
+
+static const ax5043_model_config_t model_cfg = {
+    .xtal_freq      = AX5043_SIM_XTAL,
+    .xtal_us        = 1000,
+    .range_us       = 1000,
+    .lock_us        = 50,
+    .rx_gap_bits    = 64,
+};
+
+static const SPIConfig spicfg = {
+    false,
+    NULL,
+    LINE_AX5043_CS,
+    SPI_CR1_BR_1,
+    0
+};
+
+static const ax5043_profile_t profile_a[] = {
+    {AX5043_REG_FREQA, 0x1B480001, 4},
+    {AX5043_REG_TXRATE, 0x018937, 3},
+    {AX5043_REG_PKTCHUNKSIZE, AX5043_PKTCHUNKSIZE_64, 1},
+    {AX5043_REG_PKTSTOREFLAGS, AX5043_PKTSTOREFLAGS_RSSI | AX5043_PKTSTOREFLAGS_RFOFFS, 1},
+    {0, 0, 0}
+};
+
+static const ax5043_profile_t profile_b[] = {
+    {AX5043_REG_FREQA, 0x1B580001, 4},
+    {AX5043_REG_TXRATE, 0x018937, 3},
+    {0, 0, 0}
+};
+
+static uint32_t rx_err_calls;
+static uint8_t rx_err_flags;
+
+static void rx_err_cb(const void *arg, uint8_t flags)
+{
+    (void)arg;
+    rx_err_calls++;
+    rx_err_flags |= flags;
+}
+
+/* RSSI and RF offset handed over with each intact frame */
+static struct {
+    int8_t                      rssi;
+    uint32_t                    rf_freq_off;
+} rx_meta[8];
+static uint32_t rx_meta_calls;
+
+static void rx_frame_cb(const void *arg, int8_t rssi, uint32_t rf_freq_off)
+{
+    (void)arg;
+    if (rx_meta_calls < 8) {
+        rx_meta[rx_meta_calls].rssi = rssi;
+        rx_meta[rx_meta_calls].rf_freq_off = rf_freq_off;
+    }
+    rx_meta_calls++;
+}
+
+static const AX5043Config axcfg = {
+    .spip           = &SPID1,
+    .spicfg         = &spicfg,
+    .miso           = LINE_AX5043_MISO,
+    .irq            = LINE_AX5043_IRQ,
+    .xtal_freq      = AX5043_SIM_XTAL,
+    .fifo           = &rx_fifo,
+    .rx_err_cb      = rx_err_cb,
+    .rx_frame_cb    = rx_frame_cb,
+    .profile        = profile_a,
+};
+
+static AX5043Driver axd;
+static uint8_t tx_buf[64];
+
+fb_t *__fb_alloc(size_t len, void *arg)
+{
+    (void)len;
+    fb_t *fb = chFifoTakeObjectTimeout(arg, TIME_INFINITE);
+    memset(fb, 0, sizeof(fb_t));
+    return fb;
+}
+
+void __fb_free(fb_t *fb, void *arg)
+{
+    chFifoReturnObject(arg, fb);
+}
+
+void pdu_send(fb_t *fb, void *arg)
+{
+    chFifoSendObject(arg, fb);
+}
+
+/*
+ * Switching back to a profile uses the cached ranges of both channels and
+ * locks first time.
+ */
+static void test_vco_cache_hit(void)
+{
+    uint32_t rangings, hits, relocks;
+
+    ax5043SetProfile(&axd, profile_b);
+    ax5043SetProfile(&axd, profile_a);
+    rangings = sim_ax5043.stats.rangings;
+    hits = axd.vco_hits;
+    relocks = axd.vco_relocks;
+
+    ax5043SetProfile(&axd, profile_b);
+    ax5043TX(&axd, NULL, tx_buf, sizeof(tx_buf), sizeof(tx_buf), NULL, NULL, false);
+    TEST_EQUAL(axd.error, AX5043_ERR_NOERROR);
+    TEST_EQUAL(axd.vco_hits, hits + 2);
+    TEST_EQUAL(axd.vco_relocks, relocks);
+    TEST_EQUAL(sim_ax5043.stats.rangings, rangings);
+}
+
+/* A hit with the crystal stopped waits for it instead of failing to lock */
+static void test_vco_cache_hit_xtal_off(void)
+{
+    uint32_t rangings, hits, relocks;
+    uint64_t start, tune_us;
+
+    rangings = sim_ax5043.stats.rangings;
+    hits = axd.vco_hits;
+    relocks = axd.vco_relocks;
+
+    ax5043WriteU8(&axd, AX5043_REG_PWRMODE, AX5043_PWRMODE_POWERDOWN);
+    start = simTimeUS();
+    ax5043SetProfile(&axd, profile_a);
+    tune_us = simTimeUS() - start;
+    ax5043TX(&axd, NULL, tx_buf, sizeof(tx_buf), sizeof(tx_buf), NULL, NULL, false);
+    TEST_EQUAL(axd.error, AX5043_ERR_NOERROR);
+    TEST_EQUAL(axd.vco_hits, hits + 2);
+    TEST_EQUAL(axd.vco_relocks, relocks);
+    TEST_EQUAL(sim_ax5043.stats.rangings, rangings);
+    TEST_CHECK(tune_us >= model_cfg.xtal_us);
+}
+
+/* A stale cached range is dropped and the channel ranged once more */
+static void test_vco_cache_relock(void)
+{
+    uint32_t rangings = sim_ax5043.stats.rangings;
+    uint32_t relocks = axd.vco_relocks;
+
+    ax5043ModelShiftVCO(&sim_ax5043, 3);
+    ax5043TX(&axd, NULL, tx_buf, sizeof(tx_buf), sizeof(tx_buf), NULL, NULL, false);
+    TEST_EQUAL(axd.error, AX5043_ERR_NOERROR);
+    TEST_EQUAL(axd.vco_relocks, relocks + 1);
+    TEST_EQUAL(sim_ax5043.stats.rangings, rangings + 1);
+    ax5043ModelShiftVCO(&sim_ax5043, 0);
+}
+
+static void rx_frame(uint8_t seed, size_t len, uint8_t flags)
+{
+    uint8_t frame[AX5043_MODEL_RX_MAX];
+
+    for (size_t i = 0; i < len; i++) {
+        frame[i] = seed + i;
+    }
+    TEST_CHECK(ax5043ModelRX(&sim_ax5043, frame, len, flags, -80, 0));
+}
+
+/* Waits for the next delivered frame and checks it against rx_frame() */
+static void rx_expect(uint8_t seed, size_t len)
+{
+    fb_t *fb = NULL;
+
+    TEST_EQUAL(chFifoReceiveObjectTimeout(&rx_fifo, (void **)&fb, TIME_S2I(2)), MSG_OK);
+    TEST_EQUAL(fb->len, len);
+    for (size_t i = 0; i < len; i++) {
+        TEST_EQUAL(fb->data[i], (uint8_t)(seed + i));
+    }
+    TEST_CHECK(fb->phy_rx == &axd);
+    chFifoReturnObject(&rx_fifo, fb);
+}
+
+/* Every frame buffer is back in the pool */
+static void rx_check_pool(void)
+{
+    fb_t *fb[FB_COUNT];
+
+    for (size_t i = 0; i < FB_COUNT; i++) {
+        fb[i] = chFifoTakeObjectTimeout(&rx_fifo, TIME_IMMEDIATE);
+        TEST_CHECK(fb[i] != NULL);
+    }
+    for (size_t i = 0; i < FB_COUNT; i++) {
+        chFifoReturnObject(&rx_fifo, fb[i]);
+    }
+}
+
+/*
+ * Frames arrive whole, including ones longer than the FIFO, and each burst
+ * read drains several chunks.
+ */
+static void test_rx_batched(void)
+{
+    static const size_t lens[] = {40, 200, 600};
+    ax5043_rx_stats_t start = axd.rx_stats;
+    uint32_t model_frames = sim_ax5043.stats.rx_frames;
+
+    ax5043RX(&axd, false, false);
+    TEST_EQUAL(axd.error, AX5043_ERR_NOERROR);
+    for (size_t i = 0; i < 3; i++) {
+        rx_frame(i, lens[i], 0);
+    }
+    for (size_t i = 0; i < 3; i++) {
+        rx_expect(i, lens[i]);
+    }
+    TEST_EQUAL(sim_ax5043.stats.rx_frames, model_frames + 3);
+    TEST_EQUAL(sim_ax5043.stats.rx_overflows, 0);
+    TEST_EQUAL(axd.rx_stats.frames, start.frames + 3);
+    /* 15 DATA chunks of up to 64 bytes and 6 RSSI and offset chunks, read in fewer bursts */
+    TEST_CHECK(axd.rx_stats.fifo_reads - start.fifo_reads < 21);
+    TEST_EQUAL(rx_err_calls, 0);
+    rx_check_pool();
+}
+
+/*
+ * Frames flagged bad are dropped and counted by cause, whole or after
+ * part of them was buffered, and the good frames around them still arrive.
+ */
+static void test_rx_drops(void)
+{
+    ax5043_rx_stats_t start = axd.rx_stats;
+
+    rx_err_calls = 0;
+    rx_err_flags = 0;
+    rx_frame(1, 30, 0);
+    rx_frame(2, 30, AX5043_CHUNK_DATARX_CRCFAIL);
+    rx_frame(3, 100, 0);
+    /* Longer than the FIFO, so the flag comes in a later burst */
+    rx_frame(4, 700, AX5043_CHUNK_DATARX_ADDRFAIL);
+    rx_frame(5, 60, AX5043_CHUNK_DATARX_ABORT);
+    rx_frame(6, 50, 0);
+
+    rx_expect(1, 30);
+    rx_expect(3, 100);
+    rx_expect(6, 50);
+    TEST_EQUAL(axd.rx_stats.frames, start.frames + 3);
+    TEST_EQUAL(axd.rx_stats.crc_fail, start.crc_fail + 1);
+    TEST_EQUAL(axd.rx_stats.addr_fail, start.addr_fail + 1);
+    TEST_EQUAL(axd.rx_stats.abort, start.abort + 1);
+    TEST_EQUAL(axd.rx_stats.size_fail, start.size_fail);
+    TEST_EQUAL(axd.rx_stats.overflow, start.overflow);
+    TEST_EQUAL(rx_err_calls, 3);
+    TEST_EQUAL(rx_err_flags & AX5043_CHUNK_DATARX_ERR,
+               AX5043_CHUNK_DATARX_CRCFAIL | AX5043_CHUNK_DATARX_ADDRFAIL | AX5043_CHUNK_DATARX_ABORT);
+    /* Nothing else was delivered and no buffer leaked on a drop */
+    TEST_CHECK(chFifoReceiveObjectTimeout(&rx_fifo, NULL, TIME_MS2I(100)) != MSG_OK);
+    rx_check_pool();
+}
+
+/*
+ * Each frame's RSSI and RF offset reach the frame callback, even when later
+ * frames arrive before the first one is taken off the queue.
+ */
+static void test_rx_meta(void)
+{
+    static const int8_t rssi[] = {-70, -95, -110};
+    static const int32_t rf_offset[] = {1200, -3400, 0x7FFFFF};
+
+    rx_meta_calls = 0;
+    for (size_t i = 0; i < 3; i++) {
+        uint8_t frame[40];
+
+        for (size_t j = 0; j < sizeof(frame); j++) {
+            frame[j] = i + j;
+        }
+        TEST_CHECK(ax5043ModelRX(&sim_ax5043, frame, sizeof(frame), 0, rssi[i], rf_offset[i]));
+    }
+    /* All three are queued before any is looked at */
+    while (rx_meta_calls < 3) {
+        chThdSleep(TIME_MS2I(1));
+    }
+    TEST_EQUAL(axd.rssi, rssi[2]);
+    for (size_t i = 0; i < 3; i++) {
+        TEST_EQUAL(rx_meta[i].rssi, rssi[i]);
+        TEST_EQUAL(rx_meta[i].rf_freq_off, (uint32_t)rf_offset[i] & 0xFFFFFFU);
+        rx_expect(i, 40);
+    }
+    rx_check_pool();
+}
+
+int main(void)
+{
+    halInit();
+    chSysInit();
+
+    chFifoObjectInit(&rx_fifo, sizeof(fb_t), FB_COUNT, rx_fifo_buf, rx_fifo_msgs);
+    simAX5043Start(&model_cfg);
+    ax5043ObjectInit(&axd);
+    ax5043Start(&axd, &axcfg);
+    TEST_EQUAL(axd.error, AX5043_ERR_NOERROR);
+
+    TEST_RUN(test_vco_cache_hit);
+    TEST_RUN(test_vco_cache_hit_xtal_off);
+    TEST_RUN(test_vco_cache_relock);
+    TEST_RUN(test_rx_batched);
+    TEST_RUN(test_rx_drops);
+    TEST_RUN(test_rx_meta);
+    return 0;
+}
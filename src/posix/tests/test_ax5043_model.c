@@ -0,0 +1,394 @@
+/*
+ * Register level checks of the AX5043 model the radio tests run the driver
+ * against: SPI framing, FIFO commit and rollback, crystal, ranging and PLL
+ * timing, TX air time and RX chunk layout. The model is driven directly
+ * here, with the test supplying the time.
+ */
+#include <string.h>
+#include "hal.h"
+#include "ax5043.h"
+#include "ax5043_model.h"
+#include "test.h"
+
+static const ax5043_model_config_t cfg = {
+    .xtal_freq      = 16000000,
+    .xtal_us        = 500,
+    .range_us       = 200,
+    .lock_us        = 30,
+    .rx_gap_bits    = 64,
+};
+
+static ax5043_model_t m;
+static uint64_t now;
+
+/* One SPI transaction, returns the status bits shifted out with the address */
+static uint16_t xfer(uint16_t reg, bool write, const uint8_t *tx, uint8_t *rx, size_t n)
+{
+    uint8_t txb[300] = {0}, rxb[300];
+    uint16_t addr = (reg & 0xFFFU) | 0x7000U | (write ? 0x8000U : 0U);
+
+    txb[0] = addr >> 8;
+    txb[1] = addr & 0xFFU;
+    if (tx != NULL) {
+        memcpy(&txb[2], tx, n);
+    }
+    ax5043ModelAdvance(&m, now);
+    ax5043ModelSelect(&m);
+    ax5043ModelExchange(&m, txb, rxb, n + 2);
+    ax5043ModelUnselect(&m);
+    if (rx != NULL) {
+        memcpy(rx, &rxb[2], n);
+    }
+    return (rxb[0] << 8) | rxb[1];
+}
+
+static void put8(uint16_t reg, uint8_t val)
+{
+    xfer(reg, true, &val, NULL, 1);
+}
+
+static uint8_t get8(uint16_t reg)
+{
+    uint8_t val;
+
+    xfer(reg, false, NULL, &val, 1);
+    return val;
+}
+
+static void put16(uint16_t reg, uint16_t val)
+{
+    uint8_t buf[2] = {val >> 8, val & 0xFFU};
+
+    xfer(reg, true, buf, NULL, 2);
+}
+
+static uint16_t get16(uint16_t reg)
+{
+    uint8_t buf[2];
+
+    xfer(reg, false, NULL, buf, 2);
+    return (buf[0] << 8) | buf[1];
+}
+
+static void put_n(uint16_t reg, uint32_t val, size_t n)
+{
+    uint8_t buf[4];
+
+    for (size_t i = 0; i < n; i++) {
+        buf[i] = val >> (8 * (n - 1 - i));
+    }
+    xfer(reg, true, buf, NULL, n);
+}
+
+static uint16_t status(void)
+{
+    return xfer(AX5043_REG_SCRATCH, false, NULL, NULL, 0);
+}
+
+static void advance(uint64_t us)
+{
+    now += us;
+    ax5043ModelAdvance(&m, now);
+}
+
+/* Reset, crystal running, 9600 bit/s on channel A */
+static void setup(void)
+{
+    now = 0;
+    ax5043ModelInit(&m, &cfg);
+    put8(AX5043_REG_PWRMODE, AX5043_PWRMODE_RESET);
+    put8(AX5043_REG_PWRMODE, AX5043_PWRMODE_REFEN | AX5043_PWRMODE_XOEN);
+    put_n(AX5043_REG_FREQA, 0x1B480001, 4);
+    put_n(AX5043_REG_TXRATE, 0x002753, 3);
+    advance(cfg.xtal_us);
+}
+
+static void range(void)
+{
+    put8(AX5043_REG_PLLRANGINGA, AX5043_PLLRANGING_RNGSTART | 8);
+    advance(cfg.range_us);
+}
+
+static void test_spi_framing(void)
+{
+    uint8_t val = 0x55;
+
+    setup();
+    TEST_EQUAL(get8(AX5043_REG_REVISION), 0x51);
+    TEST_EQUAL(get8(AX5043_REG_SCRATCH), 0xC5);
+
+    /* A write shifts out the old contents */
+    xfer(AX5043_REG_SCRATCH, true, &val, &val, 1);
+    TEST_EQUAL(val, 0xC5);
+    TEST_EQUAL(get8(AX5043_REG_SCRATCH), 0x55);
+
+    /* Read only registers ignore writes */
+    put8(AX5043_REG_REVISION, 0);
+    TEST_EQUAL(get8(AX5043_REG_REVISION), 0x51);
+
+    TEST_CHECK(status() & AX5043_STATUS_PWRGOOD);
+    TEST_CHECK(status() & AX5043_STATUS_FIFO_EMPTY);
+    TEST_EQUAL(ax5043ModelBitrate(&m), 9600);
+}
+
+static void test_fifo_commit(void)
+{
+    static const uint8_t data[] = {1, 2, 3, 4};
+
+    setup();
+    xfer(AX5043_REG_FIFODATA, true, data, NULL, sizeof(data));
+    TEST_EQUAL(get16(AX5043_REG_FIFOCOUNT), 0);
+    TEST_EQUAL(get16(AX5043_REG_FIFOFREE), AX5043_MODEL_FIFO_SIZE - sizeof(data));
+
+    put8(AX5043_REG_FIFOSTAT, AX5043_FIFOCMD_ROLLBACK);
+    TEST_EQUAL(get16(AX5043_REG_FIFOFREE), AX5043_MODEL_FIFO_SIZE);
+
+    xfer(AX5043_REG_FIFODATA, true, data, NULL, sizeof(data));
+    put8(AX5043_REG_FIFOSTAT, AX5043_FIFOCMD_COMMIT);
+    TEST_EQUAL(get16(AX5043_REG_FIFOCOUNT), sizeof(data));
+    TEST_CHECK(!(status() & AX5043_STATUS_FIFO_EMPTY));
+
+    /* FIFODATA does not auto increment */
+    uint8_t out[4];
+    xfer(AX5043_REG_FIFODATA, false, NULL, out, sizeof(out));
+    TEST_CHECK(memcmp(out, data, sizeof(data)) == 0);
+
+    /* Reading past the end is an underrun */
+    get8(AX5043_REG_FIFODATA);
+    TEST_CHECK(get8(AX5043_REG_FIFOSTAT) & AX5043_FIFOSTAT_FIFOUNDER);
+    put8(AX5043_REG_FIFOSTAT, AX5043_FIFOCMD_CLEAR_FIFOERR);
+    TEST_CHECK(!(get8(AX5043_REG_FIFOSTAT) & AX5043_FIFOSTAT_FIFOUNDER));
+
+    /* Writes beyond the free space are dropped and counted */
+    for (unsigned i = 0; i < AX5043_MODEL_FIFO_SIZE + 3; i++) {
+        put8(AX5043_REG_FIFODATA, i);
+    }
+    TEST_EQUAL(m.stats.fifo_overflows, 3);
+    TEST_CHECK(status() & AX5043_STATUS_FIFO_OVER);
+}
+
+static void test_xtal_and_ranging(void)
+{
+    now = 0;
+    ax5043ModelInit(&m, &cfg);
+    put16(AX5043_REG_IRQMASK, AX5043_IRQ_XTALREADY | AX5043_IRQ_PLLRNGDONE);
+    put8(AX5043_REG_PWRMODE, AX5043_PWRMODE_XOEN | AX5043_PWRMODE_STANDBY);
+    advance(cfg.xtal_us - 1);
+    TEST_EQUAL(get8(AX5043_REG_XTALSTATUS), 0);
+    TEST_CHECK(!ax5043ModelIRQ(&m));
+    advance(1);
+    TEST_EQUAL(get8(AX5043_REG_XTALSTATUS), AX5043_XTALSTATUS_XTALRUN);
+    TEST_CHECK(ax5043ModelIRQ(&m));
+    put16(AX5043_REG_IRQMASK, AX5043_IRQ_PLLRNGDONE);
+    TEST_CHECK(!ax5043ModelIRQ(&m));
+
+    /* Ranging takes range_us, then raises PLLRNGDONE until the result is read */
+    put_n(AX5043_REG_FREQA, 0x1B480001, 4);
+    put8(AX5043_REG_PLLRANGINGA, AX5043_PLLRANGING_RNGSTART | 8);
+    advance(cfg.range_us - 1);
+    TEST_CHECK(!ax5043ModelIRQ(&m));
+    advance(1);
+    TEST_CHECK(ax5043ModelIRQ(&m));
+    TEST_EQUAL(m.stats.rangings, 1);
+    uint8_t rng = get8(AX5043_REG_PLLRANGINGA);
+    TEST_CHECK(!(rng & AX5043_PLLRANGING_RNGSTART));
+    TEST_EQUAL(_FLD2VAL(AX5043_PLLRANGING_VCOR, rng), ((0x1B480001U >> 20) % 15U) + 1U);
+    TEST_CHECK(!ax5043ModelIRQ(&m));
+
+    /* The crystal stops in POWERDOWN without XOEN, ranging then waits for it */
+    put8(AX5043_REG_PWRMODE, AX5043_PWRMODE_POWERDOWN);
+    put8(AX5043_REG_PWRMODE, AX5043_PWRMODE_XOEN | AX5043_PWRMODE_STANDBY);
+    put8(AX5043_REG_PLLRANGINGA, AX5043_PLLRANGING_RNGSTART | 8);
+    advance(cfg.range_us);
+    TEST_EQUAL(m.stats.rangings, 1);
+    advance(cfg.xtal_us);
+    TEST_EQUAL(m.stats.rangings, 2);
+}
+
+static void test_pll_lock(void)
+{
+    setup();
+    range();
+
+    put8(AX5043_REG_PWRMODE, AX5043_PWRMODE_XOEN | AX5043_PWRMODE_TX_SYNTH);
+    advance(cfg.lock_us - 1);
+    TEST_CHECK(!(status() & AX5043_STATUS_PLL_LOCK));
+    advance(1);
+    TEST_CHECK(status() & AX5043_STATUS_PLL_LOCK);
+    TEST_CHECK(get8(AX5043_REG_PLLRANGINGA) & AX5043_PLLRANGING_PLLLOCK);
+
+    /* A stale range from before a temperature swing does not lock */
+    ax5043ModelShiftVCO(&m, 3);
+    TEST_CHECK(!(status() & AX5043_STATUS_PLL_LOCK));
+    range();
+    TEST_CHECK(status() & AX5043_STATUS_PLL_LOCK);
+}
+
+/* 300 bytes in chunks of 125 at 9600 bit/s, refilled on FIFOTHRFREE */
+static void test_tx_air_time(void)
+{
+    uint8_t data[300];
+    size_t sent = 0;
+    uint64_t start;
+
+    setup();
+    range();
+    memset(data, 0x5A, sizeof(data));
+    put8(AX5043_REG_PWRMODE, AX5043_PWRMODE_XOEN | AX5043_PWRMODE_TX_FULL);
+    put16(AX5043_REG_FIFOTHRESH, 128);
+    put16(AX5043_REG_IRQMASK, AX5043_IRQ_FIFOTHRFREE);
+    advance(cfg.lock_us);
+    start = now;
+
+    while (sent < sizeof(data)) {
+        size_t n = sizeof(data) - sent;
+        uint8_t hdr[3];
+
+        while (!ax5043ModelIRQ(&m)) {
+            advance(100);
+        }
+        if (n > 125) {
+            n = 125;
+        }
+        hdr[0] = AX5043_CHUNKCMD_DATA | _VAL2FLD(AX5043_FIFOCHUNK_SIZE, AX5043_CHUNKSIZE_VAR);
+        hdr[1] = n + 1;
+        hdr[2] = (sent == 0 ? AX5043_CHUNK_DATATX_PKTSTART : 0) |
+                 (sent + n == sizeof(data) ? AX5043_CHUNK_DATATX_PKTEND : 0);
+        xfer(AX5043_REG_FIFODATA, true, hdr, NULL, sizeof(hdr));
+        xfer(AX5043_REG_FIFODATA, true, &data[sent], NULL, n);
+        put8(AX5043_REG_FIFOSTAT, AX5043_FIFOCMD_COMMIT);
+        sent += n;
+    }
+
+    put16(AX5043_REG_RADIOEVENTMASK, AX5043_RADIOEVENT_DONE);
+    put16(AX5043_REG_IRQMASK, AX5043_IRQ_RADIOCTRL);
+    while (!ax5043ModelIRQ(&m)) {
+        advance(100);
+    }
+    TEST_EQUAL(m.stats.tx_packets, 1);
+    TEST_EQUAL(m.stats.tx_bytes, sizeof(data));
+    TEST_EQUAL(m.stats.tx_underruns, 0);
+
+    /* 250 ms on the air, DONE within a step of the last bit */
+    TEST_CHECK(now - start >= 250000 && now - start <= 250000 + 200);
+    TEST_CHECK(m.stats.air_us >= 250000 && m.stats.air_us <= 250000 + 200);
+
+    /* Reading the request clears it */
+    TEST_CHECK(get16(AX5043_REG_RADIOEVENTREQ) & AX5043_RADIOEVENT_DONE);
+    TEST_CHECK(!ax5043ModelIRQ(&m));
+}
+
+/* Starving the FIFO inside a packet counts one underrun */
+static void test_tx_underrun(void)
+{
+    uint8_t chunk[3 + 10] = {
+        AX5043_CHUNKCMD_DATA | _VAL2FLD(AX5043_FIFOCHUNK_SIZE, AX5043_CHUNKSIZE_VAR),
+        11, AX5043_CHUNK_DATATX_PKTSTART,
+    };
+
+    setup();
+    range();
+    put8(AX5043_REG_PWRMODE, AX5043_PWRMODE_XOEN | AX5043_PWRMODE_TX_FULL);
+    advance(cfg.lock_us);
+    xfer(AX5043_REG_FIFODATA, true, chunk, NULL, sizeof(chunk));
+    put8(AX5043_REG_FIFOSTAT, AX5043_FIFOCMD_COMMIT);
+    advance(20000);
+    TEST_EQUAL(m.stats.tx_bytes, 10);
+    TEST_EQUAL(m.stats.tx_underruns, 1);
+    TEST_EQUAL(m.stats.tx_packets, 0);
+}
+
+/* Parses the RX FIFO into chunks, checking the layout as it goes */
+static void test_rx_chunks(void)
+{
+    uint8_t frame[200], buf[1024];
+    size_t got = 0, data = 0, frames = 0;
+
+    setup();
+    range();
+    for (size_t i = 0; i < sizeof(frame); i++) {
+        frame[i] = i;
+    }
+    put8(AX5043_REG_PKTSTOREFLAGS, AX5043_PKTSTOREFLAGS_RSSI | AX5043_PKTSTOREFLAGS_RFOFFS);
+    put8(AX5043_REG_PKTCHUNKSIZE, AX5043_PKTCHUNKSIZE_64);
+    put8(AX5043_REG_PWRMODE, AX5043_PWRMODE_XOEN | AX5043_PWRMODE_RX_FULL);
+    TEST_CHECK(ax5043ModelRX(&m, frame, sizeof(frame), 0, -80, 0x123));
+    TEST_CHECK(ax5043ModelRX(&m, frame, 10, AX5043_CHUNK_DATARX_CRCFAIL, -90, -5));
+
+    /* Both frames, preamble and sync each, at 9600 bit/s */
+    for (int i = 0; i < 400; i++) {
+        uint16_t count;
+
+        advance(1000);
+        count = get16(AX5043_REG_FIFOCOUNT);
+        if (count > 0) {
+            TEST_CHECK(got + count <= sizeof(buf));
+            xfer(AX5043_REG_FIFODATA, false, NULL, &buf[got], count);
+            got += count;
+        }
+    }
+    TEST_EQUAL(m.stats.rx_frames, 2);
+    TEST_EQUAL(m.stats.rx_overflows, 0);
+
+    for (size_t off = 0; off < got;) {
+        uint8_t hdr = buf[off];
+
+        if (hdr == (AX5043_CHUNKCMD_RSSI | _VAL2FLD(AX5043_FIFOCHUNK_SIZE, 1))) {
+            TEST_EQUAL((int8_t)buf[off + 1], frames == 0 ? -80 : -90);
+            off += 2;
+        } else if (hdr == (AX5043_CHUNKCMD_RFFREQOFFS | _VAL2FLD(AX5043_FIFOCHUNK_SIZE, 3))) {
+            int32_t offs = (int32_t)((uint32_t)buf[off + 1] << 24 | (uint32_t)buf[off + 2] << 16 | (uint32_t)buf[off + 3] << 8) >> 8;
+            TEST_EQUAL(offs, frames == 0 ? 0x123 : -5);
+            off += 4;
+        } else {
+            size_t len = buf[off + 1] - 1;
+            uint8_t flags = buf[off + 2];
+
+            TEST_EQUAL(hdr, AX5043_CHUNKCMD_DATA | _VAL2FLD(AX5043_FIFOCHUNK_SIZE, AX5043_CHUNKSIZE_VAR));
+            TEST_CHECK(len <= 64);
+            TEST_EQUAL(!!(flags & AX5043_CHUNK_DATARX_PKTSTART), data == 0);
+            TEST_CHECK(memcmp(&buf[off + 3], &frame[data], len) == 0);
+            data += len;
+            if (flags & AX5043_CHUNK_DATARX_PKTEND) {
+                TEST_EQUAL(data, frames == 0 ? sizeof(frame) : 10);
+                TEST_EQUAL(!!(flags & AX5043_CHUNK_DATARX_CRCFAIL), frames == 1);
+                frames++;
+                data = 0;
+            }
+            off += 3 + len;
+        }
+    }
+    TEST_EQUAL(frames, 2);
+}
+
+/* A frame that does not fit is lost as a whole, later ones still arrive */
+static void test_rx_overflow(void)
+{
+    uint8_t frame[400] = {0};
+
+    setup();
+    range();
+    put8(AX5043_REG_PWRMODE, AX5043_PWRMODE_XOEN | AX5043_PWRMODE_RX_FULL);
+    TEST_CHECK(ax5043ModelRX(&m, frame, sizeof(frame), 0, -80, 0));
+    advance(500000);
+    TEST_EQUAL(m.stats.rx_overflows, 1);
+    TEST_EQUAL(m.stats.rx_frames, 0);
+
+    put8(AX5043_REG_FIFOSTAT, AX5043_FIFOCMD_CLEAR_FIFODAT);
+    TEST_CHECK(ax5043ModelRX(&m, frame, 100, 0, -80, 0));
+    advance(200000);
+    TEST_EQUAL(m.stats.rx_frames, 1);
+}
+
+int main(void)
+{
+    TEST_RUN(test_spi_framing);
+    TEST_RUN(test_fifo_commit);
+    TEST_RUN(test_xtal_and_ranging);
+    TEST_RUN(test_pll_lock);
+    TEST_RUN(test_tx_air_time);
+    TEST_RUN(test_tx_underrun);
+    TEST_RUN(test_rx_chunks);
+    TEST_RUN(test_rx_overflow);
+    return 0;
+}
@@ -0,0 +1,438 @@
+/*
+ * Runs EDL commands through cmd_process() in an EDL worker thread on the
+ * host runtime, with an in-memory file system whose reads take the card's
+ * time. Checks that a TX Ctrl round trip is as short while an FS CRC job
+ * runs as with nothing running, where the inline FS CRC holds it for the
+ * whole file, that the job's CRC and progress are right, and that cancel
+ * goes JOB_CANCELLING to JOB_CANCELLED at the next read and closes the
+ * file. Also cancels a queued job and checks FS Format runs to the end.
+ */
+#include <string.h>
+#include "cmd.h"
+#include "c3.h"
+#include "fw.h"
+#include "fs.h"
+#include "opd.h"
+#include "rtc.h"
+#include "node_mgr.h"
+#include "CO_master.h"
+#include "crc.h"
+#include "CANopen.h"
+#include "OD.h"
+#include "test.h"
+
+#define FILE_SIZE                           (256U * 1024U)
+/* Card and littlefs time per read call, as measured on the C3 */
+#define READ_TIME_US                        1000U
+#define FORMAT_TIME_MS                      2000U
+#define UPLINK_PERIOD_MS                    20U
+#define EDL_QUEUE_LEN                       4U
+
+OD_RAM_t OD_RAM;
+OD_PERSIST_STATE_t OD_PERSIST_STATE;
+OD_t *OD;
+FSDriver FSD1;
+
+static uint8_t file_data[FILE_SIZE];
+static lfs_file_t files[] = {
+    {.name = "big.bin", .data = file_data, .size = FILE_SIZE},
+    {.name = "small.bin", .data = file_data, .size = 1000U},
+};
+static bool tx_state;
+static unsigned formats;
+
+/*===========================================================================*/
+/* Back ends cmd.c calls.                                                    */
+/*===========================================================================*/
+
+int fs_format(FSDriver *fsp)
+{
+    (void)fsp;
+    chThdSleepMilliseconds(FORMAT_TIME_MS);
+    formats++;
+    return LFS_ERR_OK;
+}
+
+int fs_unmount(FSDriver *fsp)
+{
+    (void)fsp;
+    return LFS_ERR_OK;
+}
+
+int fs_remove(FSDriver *fsp, const char *path)
+{
+    (void)fsp;
+    (void)path;
+    return LFS_ERR_NOENT;
+}
+
+lfs_file_t *file_open(FSDriver *fsp, const char *path, int flags)
+{
+    TEST_EQUAL(flags, LFS_O_RDONLY);
+    for (size_t i = 0; i < sizeof(files) / sizeof(files[0]); i++) {
+        if (strcmp(files[i].name, path) == 0) {
+            TEST_CHECK(!files[i].open);
+            files[i].open = true;
+            files[i].pos = 0;
+            fsp->err = LFS_ERR_OK;
+            return &files[i];
+        }
+    }
+    fsp->err = LFS_ERR_NOENT;
+    return NULL;
+}
+
+int file_close(FSDriver *fsp, lfs_file_t *file)
+{
+    (void)fsp;
+    TEST_CHECK(file->open);
+    file->open = false;
+    return LFS_ERR_OK;
+}
+
+lfs_ssize_t file_read(FSDriver *fsp, lfs_file_t *file, void *buffer, lfs_size_t size)
+{
+    (void)fsp;
+    TEST_CHECK(file->open);
+    if (size > file->size - file->pos) {
+        size = file->size - file->pos;
+    }
+    chThdSleepMicroseconds(READ_TIME_US);
+    memcpy(buffer, &file->data[file->pos], size);
+    file->pos += size;
+    return size;
+}
+
+lfs_soff_t file_size(FSDriver *fsp, lfs_file_t *file)
+{
+    (void)fsp;
+    return file->size;
+}
+
+/* As in fs.c */
+uint32_t file_crc(FSDriver *fsp, lfs_file_t *file)
+{
+    uint8_t buf[512];
+    lfs_ssize_t n;
+    uint32_t crc = 0;
+
+    while ((n = file_read(fsp, file, buf, sizeof(buf))) > 0) {
+        crc = crc32(buf, n, crc);
+    }
+    return crc;
+}
+
+void tx_enable(bool state) { tx_state = state; }
+bool tx_enabled(void) { return tx_state; }
+void soft_reset(void) { TEST_CHECK(false); }
+void hard_reset(void) { TEST_CHECK(false); }
+void factory_reset(void) { TEST_CHECK(false); }
+
+int fw_flash(EFlashDriver *eflp, char *filename, uint32_t expected_crc)
+{
+    (void)eflp;
+    (void)filename;
+    (void)expected_crc;
+    return FLASH_ERROR_PROGRAM;
+}
+
+uint32_t fw_verify(EFlashDriver *eflp, fw_bank_t bank)
+{
+    (void)eflp;
+    (void)bank;
+    return 0;
+}
+
+int fw_set_bank(EFlashDriver *eflp, fw_bank_t bank)
+{
+    eflp->bank = bank;
+    return 0;
+}
+
+void opd_start(void) {}
+void opd_stop(void) {}
+void opd_scan(bool restart) { (void)restart; }
+int opd_enable(i2caddr_t addr, bool enable) { (void)addr; (void)enable; return 0; }
+int opd_reset(i2caddr_t addr) { (void)addr; return 0; }
+int opd_status(i2caddr_t addr, opd_status_t *status) { (void)addr; memset(status, 0, sizeof(*status)); return 0; }
+int node_enable(uint8_t id, bool enable) { (void)id; (void)enable; return 0; }
+int node_status(uint8_t id, CO_NMT_internalState_t *state) { (void)id; *state = CO_NMT_OPERATIONAL; return 0; }
+void sdo_transfer(sdocli_op_t op, uint8_t node_id, uint16_t index, uint8_t subindex,
+                  size_t total_size, size_t buf_size, void *buf)
+{
+    (void)op; (void)node_id; (void)index; (void)subindex; (void)total_size; (void)buf_size; (void)buf;
+}
+time_t rtcGetTimeUnix(uint32_t *msec) { (void)msec; return 0; }
+void rtcSetTimeUnix(time_t unix_time, uint32_t msec) { (void)unix_time; (void)msec; }
+
+/*===========================================================================*/
+/* EDL worker.                                                               */
+/*===========================================================================*/
+
+/* An uplinked command and its response, timed from arrival to reply */
+typedef struct {
+    union {
+        cmd_t                   cmd;
+        uint8_t                 buf[64];
+    } frame;
+    size_t                      len;
+    fb_t                        resp;
+    uint64_t                    arrived_us;
+    uint64_t                    replied_us;
+    binary_semaphore_t          done;
+} edl_req_t;
+
+static msg_t edl_queue_buf[EDL_QUEUE_LEN];
+static MAILBOX_DECL(edl_queue, edl_queue_buf, EDL_QUEUE_LEN);
+
+/* At the EDL worker priority of comms.c, one command at a time */
+static THD_FUNCTION(edl_worker, arg)
+{
+    (void)arg;
+    edl_req_t *req;
+
+    while (true) {
+        chMBFetchTimeout(&edl_queue, (msg_t*)&req, TIME_INFINITE);
+        cmd_process(&req->frame.cmd, req->len, &req->resp);
+        req->replied_us = chHostTimeUS();
+        chBSemSignal(&req->done);
+    }
+}
+
+static void edl_post(edl_req_t *req, cmd_code_t code, const void *arg, size_t arg_len)
+{
+    memset(req, 0, sizeof(*req));
+    req->frame.cmd.cmd = code;
+    memcpy(req->frame.cmd.arg, arg, arg_len);
+    req->len = sizeof(cmd_t) + arg_len;
+    chBSemObjectInit(&req->done, true);
+    OD_PERSIST_STATE.x6004_persistentState.EDL_SequenceCount++;
+    req->arrived_us = chHostTimeUS();
+    TEST_EQUAL(chMBPostTimeout(&edl_queue, (msg_t)req, TIME_IMMEDIATE), MSG_OK);
+}
+
+/* Waits for the reply and returns its payload, after the sequence number */
+static const uint8_t *edl_wait(edl_req_t *req, size_t payload_len)
+{
+    chBSemWait(&req->done);
+    TEST_EQUAL(req->resp.len, sizeof(uint32_t) + payload_len);
+    TEST_EQUAL(*(uint32_t*)req->resp.data, OD_PERSIST_STATE.x6004_persistentState.EDL_SequenceCount - 1);
+    return &req->resp.data[sizeof(uint32_t)];
+}
+
+static uint64_t tx_ctrl_rtt(uint8_t enable)
+{
+    edl_req_t req;
+
+    edl_post(&req, CMD_TX_CTRL, &enable, 1);
+    TEST_EQUAL(*edl_wait(&req, 1), enable);
+    return req.replied_us - req.arrived_us;
+}
+
+static uint8_t job_submit(cmd_code_t code, const char *filename)
+{
+    edl_req_t req;
+    size_t len = filename != NULL ? strlen(filename) + 1 : 0;
+
+    edl_post(&req, code, filename, len);
+    return *edl_wait(&req, 1);
+}
+
+static void job_status(uint8_t id, cmd_job_status_t *status)
+{
+    edl_req_t req;
+
+    edl_post(&req, CMD_JOB_STATUS, &id, 1);
+    memcpy(status, edl_wait(&req, sizeof(*status)), sizeof(*status));
+    TEST_EQUAL(status->id, id);
+}
+
+static cmd_job_state_t job_cancel(uint8_t id)
+{
+    edl_req_t req;
+
+    edl_post(&req, CMD_JOB_CANCEL, &id, 1);
+    return *edl_wait(&req, 1);
+}
+
+/*===========================================================================*/
+/* Tests.                                                                    */
+/*===========================================================================*/
+
+static uint64_t rtt_idle_us;
+static uint64_t rtt_inline_us;
+static uint32_t inline_crc;
+
+static void test_tx_ctrl_idle(void)
+{
+    rtt_idle_us = tx_ctrl_rtt(1);
+    TEST_CHECK(tx_state);
+    TEST_CHECK(tx_ctrl_rtt(0) == rtt_idle_us);
+    TEST_CHECK(!tx_state);
+    TEST_CHECK(rtt_idle_us < READ_TIME_US);
+}
+
+/* The inline command holds the worker, TX Ctrl waits for the whole file */
+static void test_tx_ctrl_behind_inline_crc(void)
+{
+    edl_req_t crc_req, tx_req;
+    uint8_t enable = 1;
+
+    edl_post(&crc_req, CMD_FS_CRC, "big.bin", sizeof("big.bin"));
+    edl_post(&tx_req, CMD_TX_CTRL, &enable, 1);
+    memcpy(&inline_crc, edl_wait(&crc_req, sizeof(uint32_t)), sizeof(uint32_t));
+    TEST_EQUAL(*edl_wait(&tx_req, 1), 1);
+    TEST_EQUAL(inline_crc, crc32(file_data, FILE_SIZE, 0));
+    rtt_inline_us = tx_req.replied_us - tx_req.arrived_us;
+    TEST_CHECK(rtt_inline_us >= (FILE_SIZE / 512U) * READ_TIME_US);
+    TEST_CHECK(!files[0].open);
+}
+
+/* As a job, TX Ctrl is answered as fast as with nothing running */
+static void test_tx_ctrl_during_job(void)
+{
+    cmd_job_status_t status;
+    uint64_t rtt_max = 0, start = chHostTimeUS();
+    uint8_t last_progress = 0;
+    unsigned samples = 0;
+    uint8_t id;
+
+    id = job_submit(CMD_FS_CRC_JOB, "big.bin");
+    TEST_CHECK(id != 0);
+    do {
+        chThdSleepMilliseconds(UPLINK_PERIOD_MS);
+        uint64_t rtt = tx_ctrl_rtt(samples & 1U);
+        if (rtt > rtt_max)
+            rtt_max = rtt;
+        job_status(id, &status);
+        TEST_CHECK(status.progress >= last_progress);
+        last_progress = status.progress;
+        samples++;
+    } while (status.state == JOB_QUEUED || status.state == JOB_RUNNING);
+
+    TEST_EQUAL(status.state, JOB_DONE);
+    TEST_EQUAL(status.progress, 100);
+    TEST_EQUAL(status.result, 0);
+    TEST_EQUAL(status.crc, inline_crc);
+    TEST_CHECK(!files[0].open);
+    TEST_CHECK(samples > 10);
+    TEST_CHECK(rtt_max == rtt_idle_us);
+    printf("\n    TX Ctrl round trip: idle %llu us, during FS CRC job max %llu us over %u, "
+           "behind inline FS CRC %llu ms (job %llu ms)\n",
+           (unsigned long long)rtt_idle_us, (unsigned long long)rtt_max, samples,
+           (unsigned long long)rtt_inline_us / 1000U, (unsigned long long)(chHostTimeUS() - start) / 1000U);
+    printf("%-40s ", "");
+}
+
+/* Cancel holds JOB_CANCELLING until the job reaches its next read */
+static void test_cancel_running(void)
+{
+    cmd_job_status_t status;
+    uint64_t cancelled_us;
+    uint8_t id;
+
+    id = job_submit(CMD_FS_CRC_JOB, "big.bin");
+    TEST_CHECK(id != 0);
+    chThdSleepMilliseconds(50);
+    job_status(id, &status);
+    TEST_EQUAL(status.state, JOB_RUNNING);
+    TEST_CHECK(status.progress > 0 && status.progress < 100);
+    TEST_CHECK(files[0].open);
+
+    TEST_EQUAL(job_cancel(id), JOB_CANCELLING);
+    cancelled_us = chHostTimeUS();
+    job_status(id, &status);
+    TEST_EQUAL(status.state, JOB_CANCELLING);
+
+    do {
+        chThdSleepMicroseconds(READ_TIME_US / 10U);
+        job_status(id, &status);
+    } while (status.state == JOB_CANCELLING);
+    TEST_EQUAL(status.state, JOB_CANCELLED);
+    TEST_EQUAL(status.result, FW_ERROR_CANCELLED);
+    TEST_EQUAL(status.crc, 0);
+    TEST_CHECK(status.progress < 100);
+    TEST_CHECK(chHostTimeUS() - cancelled_us <= 2U * READ_TIME_US);
+    TEST_CHECK(!files[0].open);
+
+    /* Cancelling again or a finished job changes nothing */
+    TEST_EQUAL(job_cancel(id), JOB_CANCELLED);
+    TEST_EQUAL(job_cancel(0), JOB_NONE);
+}
+
+/* A queued job is dropped at once and never opens its file */
+static void test_cancel_queued(void)
+{
+    cmd_job_status_t status;
+    uint8_t first, second;
+
+    first = job_submit(CMD_FS_CRC_JOB, "big.bin");
+    second = job_submit(CMD_FS_CRC_JOB, "small.bin");
+    TEST_CHECK(first != 0 && second != 0 && first != second);
+    job_status(second, &status);
+    TEST_EQUAL(status.state, JOB_QUEUED);
+    TEST_EQUAL(job_cancel(second), JOB_CANCELLED);
+
+    do {
+        chThdSleepMilliseconds(UPLINK_PERIOD_MS);
+        TEST_CHECK(!files[1].open);
+        job_status(first, &status);
+    } while (status.state == JOB_RUNNING);
+    TEST_EQUAL(status.state, JOB_DONE);
+    TEST_EQUAL(status.crc, inline_crc);
+    chThdSleepMilliseconds(UPLINK_PERIOD_MS);
+    job_status(second, &status);
+    TEST_EQUAL(status.state, JOB_CANCELLED);
+    TEST_CHECK(!files[1].open);
+}
+
+/* FS Format is not cancellable once started */
+static void test_format_runs_out(void)
+{
+    cmd_job_status_t status;
+    unsigned before = formats;
+    uint8_t id;
+
+    id = job_submit(CMD_FS_FORMAT_JOB, NULL);
+    TEST_CHECK(id != 0);
+    chThdSleepMilliseconds(UPLINK_PERIOD_MS);
+    TEST_EQUAL(job_cancel(id), JOB_RUNNING);
+    chThdSleepMilliseconds(FORMAT_TIME_MS);
+    job_status(id, &status);
+    TEST_EQUAL(status.state, JOB_DONE);
+    TEST_EQUAL(formats, before + 1);
+}
+
+/* A missing file fails the job with the file system error */
+static void test_missing_file(void)
+{
+    cmd_job_status_t status;
+    uint8_t id;
+
+    id = job_submit(CMD_FS_CRC_JOB, "none.bin");
+    TEST_CHECK(id != 0);
+    chThdSleepMilliseconds(UPLINK_PERIOD_MS);
+    job_status(id, &status);
+    TEST_EQUAL(status.state, JOB_DONE);
+    TEST_EQUAL(status.result, LFS_ERR_NOENT);
+    TEST_EQUAL(status.crc, 0);
+}
+
+int main(void)
+{
+    halInit();
+    chSysInit();
+    for (size_t i = 0; i < FILE_SIZE; i++) {
+        file_data[i] = (uint8_t)(i * 131U + (i >> 9));
+    }
+    chThdCreateFromHeap(NULL, THD_WORKING_AREA_SIZE(0x1000), "EDL Worker", NORMALPRIO, edl_worker, NULL);
+
+    TEST_RUN(test_tx_ctrl_idle);
+    TEST_RUN(test_tx_ctrl_behind_inline_crc);
+    TEST_RUN(test_tx_ctrl_during_job);
+    TEST_RUN(test_cancel_running);
+    TEST_RUN(test_cancel_queued);
+    TEST_RUN(test_format_runs_out);
+    TEST_RUN(test_missing_file);
+    return 0;
+}
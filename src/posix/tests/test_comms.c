@@ -0,0 +1,320 @@
+/*
+ * Runs VC2 commands through app_control comms.c on the host runtime, framed
+ * and signed by the ground side of the fuzz_edl link, and checks the COP-1
+ * state comms.c publishes in the object dictionary: the accepted, rejected,
+ * retransmit and lockout counters and the CLCW after in sequence frames, a
+ * lost frame, a full downlink queue and a frame outside the window, and the
+ * Unlock and Set V(R) directives. Also checks which transmitter answers an
+ * L-band uplink, built once with EDL_LBAND_DOWNLINK and once without. Only
+ * the radio driver and the object dictionary are stood in for, as in the
+ * fuzz_edl replay.
+ */
+#include <string.h>
+#include "ch.h"
+#include "hal.h"
+#include "comms.h"
+#include "beacon.h"
+#include "cmd.h"
+#include "farm.h"
+#include "fuzz_link.h"
+#include "fuzz.h"
+#include "OD.h"
+#include "test.h"
+
+#define CLCW_FLAGS                          (FARM_CLCW_LOCKOUT | FARM_CLCW_WAIT | FARM_CLCW_RETRANSMIT)
+
+/* The counters comms.c should have published */
+static struct {
+    uint32_t accepted;
+    uint32_t rejected;
+    uint32_t retransmits;
+    uint32_t lockouts;
+} expect;
+
+/* Downlink frames, the radio sends nothing while tx_gate is taken */
+static BSEMAPHORE_DECL(tx_gate, false);
+static bool tx_held;
+static unsigned tx_frames;
+static unsigned tx_lband;
+static bool uplink_lost;
+/* The radio the uplink arrives on */
+static const AX5043Config *uplink_cfg;
+
+/*===========================================================================*/
+/* Radio stand-in.                                                           */
+/*===========================================================================*/
+
+void ax5043ObjectInit(AX5043Driver *devp) { memset(devp, 0, sizeof(*devp)); }
+void ax5043Start(AX5043Driver *devp, const AX5043Config *config) { devp->config = config; }
+void ax5043Stop(AX5043Driver *devp) { (void)devp; }
+void ax5043RX(AX5043Driver *devp, bool chan_b, bool wor) { (void)devp; (void)chan_b; (void)wor; }
+void ax5043SetVCOTemp(AX5043Driver *devp, int16_t temp) { (void)devp; (void)temp; }
+void si41xxObjectInit(SI41XXDriver *devp) { (void)devp; }
+void si41xxStart(SI41XXDriver *devp, SI41XXConfig *config) { (void)devp; (void)config; }
+void si41xxStop(SI41XXDriver *devp) { (void)devp; }
+
+void ax5043TX(AX5043Driver *devp, const ax5043_profile_t *profile, const void *buf, size_t len,
+              size_t total_len, ax5043_tx_cb_t tx_cb, void *tx_cb_arg, bool chan_b)
+{
+    (void)profile;
+    (void)buf;
+    (void)len;
+    (void)total_len;
+    (void)tx_cb;
+    (void)tx_cb_arg;
+    (void)chan_b;
+
+    chBSemWait(&tx_gate);
+    tx_frames++;
+    if (devp == &lband)
+        tx_lband++;
+    chBSemSignal(&tx_gate);
+}
+
+void beacon_send(const radio_cfg_t *cfg) { (void)cfg; }
+
+THD_FUNCTION(beacon, arg)
+{
+    (void)arg;
+    chThdExit(MSG_OK);
+}
+
+/*===========================================================================*/
+/* Ground side.                                                              */
+/*===========================================================================*/
+
+/* The receive MAPs of the fuzz link, comms.c has its own */
+void fuzz_map_cmd(fb_t *fb, void *arg) { (void)fb; (void)arg; }
+void fuzz_map_file(fb_t *fb, void *arg) { (void)fb; (void)arg; }
+void fuzz_map_cop(fb_t *fb, void *arg) { (void)fb; (void)arg; }
+
+/* A framed uplink goes to the EDL worker as the RX worker hands it over */
+void fuzz_phy_send(fb_t *fb, void *arg)
+{
+    (void)arg;
+
+    if (uplink_lost) {
+        fb_free(fb, &rx_queue.fifo);
+        return;
+    }
+    fb->phy_arg = (void*)uplink_cfg->phy_arg;
+    pdu_send(fb, &rx_queue.fifo);
+}
+
+static bool pool_full(objects_fifo_t *fifo)
+{
+    cnt_t free;
+
+    chSysLock();
+    free = chSemGetCounterI(&fifo->free.sem);
+    chSysUnlock();
+    return free == (cnt_t)RADIO_FIFO_COUNT;
+}
+
+/* Until the EDL worker is done, and the radios too unless they are held */
+static void settle(void)
+{
+    while (!pool_full(&rx_queue.fifo) ||
+            (!tx_held && (!pool_full(&uhf_txq.fifo) || !pool_full(&lband_txq.fifo)))) {
+        chThdSleepMilliseconds(1);
+    }
+}
+
+/* Frame <sdu> on VC2 with N(S) <ns>, or as a BD frame if <bypass> */
+static void uplink(uint8_t ns, bool bypass, uint8_t mapid, const void *sdu, size_t len, bool lost)
+{
+    fb_t *fb = fb_alloc(FB_MAX_LEN, &rx_queue.fifo);
+
+    fb_reserve(fb, USLP_MAX_HEADER_LEN + 2 + 6);
+    memcpy(fb_put(fb, len), sdu, len);
+    if (!bypass)
+        fuzz_vc2_seq_cnt = ns;
+    uplink_lost = lost;
+    uslp_map_send(&fuzz_tx_link, fb, 2, mapid, bypass);
+    settle();
+}
+
+/* A command on MAP 0 that always answers */
+static void uplink_cmd(uint8_t ns, bool lost)
+{
+    uint8_t buf[sizeof(cmd_t) + 1];
+    cmd_t *cmd = (cmd_t*)buf;
+
+    cmd->cmd = CMD_JOB_STATUS;
+    cmd->arg[0] = 1;
+    uplink(ns, false, 0, buf, sizeof(buf), lost);
+}
+
+static void uplink_dir(const uint8_t *dir, size_t len, bool bypass)
+{
+    uplink(0, bypass, 2, dir, len, false);
+}
+
+static void check_od(uint8_t vr, uint32_t flags)
+{
+    uint32_t clcw = OD_RAM.x7000_C3_Telemetry.VC2_CLCW;
+
+    TEST_EQUAL(OD_RAM.x7000_C3_Telemetry.VC2_Accepted, expect.accepted);
+    TEST_EQUAL(OD_RAM.x7000_C3_Telemetry.VC2_Rejected, expect.rejected);
+    TEST_EQUAL(OD_RAM.x7000_C3_Telemetry.VC2_Retransmits, expect.retransmits);
+    TEST_EQUAL(OD_RAM.x7000_C3_Telemetry.VC2_Lockouts, expect.lockouts);
+    TEST_CHECK(clcw & FARM_CLCW_COP1);
+    TEST_EQUAL((clcw >> FARM_CLCW_VCID_Pos) & 0x3FU, 2);
+    TEST_EQUAL(clcw & CLCW_FLAGS, flags);
+    TEST_EQUAL(clcw & FARM_CLCW_REPORT_Msk, vr);
+}
+
+/*===========================================================================*/
+/* Tests.                                                                    */
+/*===========================================================================*/
+
+/* Each command in sequence is answered, a repeat is not */
+static void test_sequence(void)
+{
+    unsigned frames = tx_frames;
+
+    for (uint8_t ns = 0; ns < 3; ns++) {
+        uplink_cmd(ns, false);
+    }
+    expect.accepted += 3;
+    check_od(3, 0);
+    TEST_EQUAL(tx_frames, frames + 3);
+
+    uplink_cmd(2, false);
+    expect.rejected++;
+    check_od(3, 0);
+    TEST_EQUAL(tx_frames, frames + 3);
+}
+
+/* A lost frame raises the retransmit flag until the ground goes back to V(R) */
+static void test_retransmit(void)
+{
+    unsigned frames = tx_frames;
+
+    uplink_cmd(3, true);
+    uplink_cmd(4, false);
+    uplink_cmd(5, false);
+    expect.rejected += 2;
+    expect.retransmits++;
+    check_od(3, FARM_CLCW_RETRANSMIT);
+    TEST_EQUAL(tx_frames, frames);
+
+    for (uint8_t ns = 3; ns < 6; ns++) {
+        uplink_cmd(ns, false);
+    }
+    expect.accepted += 3;
+    check_od(6, 0);
+    TEST_EQUAL(tx_frames, frames + 3);
+}
+
+/* With every downlink buffer taken the FARM waits, and takes the frame again after */
+static void test_wait(void)
+{
+    unsigned frames = tx_frames;
+    uint8_t ns = 6;
+
+    chBSemWait(&tx_gate);
+    tx_held = true;
+    for (unsigned i = 0; i < RADIO_FIFO_COUNT; i++) {
+        uplink_cmd(ns++, false);
+    }
+    expect.accepted += RADIO_FIFO_COUNT;
+    check_od(ns, 0);
+
+    uplink_cmd(ns, false);
+    expect.rejected++;
+    expect.retransmits++;
+    check_od(ns, FARM_CLCW_WAIT | FARM_CLCW_RETRANSMIT);
+
+    tx_held = false;
+    chBSemSignal(&tx_gate);
+    settle();
+    TEST_EQUAL(tx_frames, frames + RADIO_FIFO_COUNT);
+    uplink_cmd(ns, false);
+    expect.accepted++;
+    check_od(ns + 1, 0);
+    TEST_EQUAL(tx_frames, frames + RADIO_FIFO_COUNT + 1);
+}
+
+/* Outside the window locks out until an Unlock in a BC frame, then Set V(R) */
+static void test_lockout(void)
+{
+    const uint8_t unlock[] = {FARM_DIR_UNLOCK};
+    const uint8_t setvr[] = {FARM_DIR_SET_VR, 0x00, 100};
+    uint8_t vr = OD_RAM.x7000_C3_Telemetry.VC2_CLCW & FARM_CLCW_REPORT_Msk;
+    unsigned frames = tx_frames;
+
+    uplink_cmd(vr + 100, false);
+    expect.rejected++;
+    expect.lockouts++;
+    check_od(vr, FARM_CLCW_LOCKOUT);
+
+    uplink_cmd(vr, false);
+    expect.rejected++;
+    check_od(vr, FARM_CLCW_LOCKOUT);
+
+    /* Directives in an AD frame are not taken */
+    uplink_dir(unlock, sizeof(unlock), false);
+    expect.rejected++;
+    check_od(vr, FARM_CLCW_LOCKOUT);
+    TEST_EQUAL(tx_frames, frames);
+
+    /* Each directive taken is answered with the CLCW */
+    uplink_dir(unlock, sizeof(unlock), true);
+    expect.accepted++;
+    check_od(vr, 0);
+    uplink_dir(setvr, sizeof(setvr), true);
+    expect.accepted++;
+    check_od(100, 0);
+    TEST_EQUAL(tx_frames, frames + 2);
+
+    uplink_cmd(100, false);
+    expect.accepted++;
+    check_od(101, 0);
+    TEST_EQUAL(tx_frames, frames + 3);
+}
+
+/* L-band uplinks are answered on L-band only with EDL_LBAND_DOWNLINK */
+static void test_lband(void)
+{
+    uint8_t vr = OD_RAM.x7000_C3_Telemetry.VC2_CLCW & FARM_CLCW_REPORT_Msk;
+    uint32_t packets = OD_PERSIST_STATE.x6004_persistentState.LBandRX_Packets;
+    unsigned frames = tx_frames, lband_frames = tx_lband;
+    const AX5043Config *uhf_cfg = uplink_cfg;
+
+    for (int i = 0; radio_devices[i].devp != NULL; i++) {
+        if (radio_devices[i].devp == &lband)
+            uplink_cfg = radio_devices[i].cfgp;
+    }
+    uplink_cmd(vr, false);
+    uplink_cfg = uhf_cfg;
+    expect.accepted++;
+    check_od(vr + 1, 0);
+    TEST_EQUAL(OD_PERSIST_STATE.x6004_persistentState.LBandRX_Packets, packets + 1);
+    TEST_EQUAL(tx_frames, frames + 1);
+#if (EDL_LBAND_DOWNLINK == TRUE)
+    TEST_EQUAL(tx_lband, lband_frames + 1);
+#else
+    TEST_EQUAL(tx_lband, lband_frames);
+#endif
+}
+
+int main(void)
+{
+    halInit();
+    chSysInit();
+    backend_reset();
+    comms_init();
+    comms_start();
+    for (int i = 0; radio_devices[i].devp != NULL; i++) {
+        if (radio_devices[i].devp == &uhf)
+            uplink_cfg = radio_devices[i].cfgp;
+    }
+
+    TEST_RUN(test_sequence);
+    TEST_RUN(test_retransmit);
+    TEST_RUN(test_wait);
+    TEST_RUN(test_lockout);
+    TEST_RUN(test_lband);
+    return 0;
+}
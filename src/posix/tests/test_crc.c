@@ -0,0 +1,161 @@
+/*
+ * Checks the software CRCs in common/crc.c against bitwise references:
+ * the check values, random lengths and buffer offsets with random running
+ * values, and calls chained at random splits. Also measures crc32_sw
+ * throughput, aligned and not. The Makefile builds this once per
+ * CRC32_SW_SLICES width so the two can be compared.
+ */
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "ch.h"
+#include "hal.h"
+#include "crc.h"
+#include "test.h"
+
+#define RANDOM_BUF_SIZE                     2048U
+#define RANDOM_RUNS                         5000U
+#define BENCH_BUF_SIZE                      1024U
+#define BENCH_BYTES                         (64U * 1024U * 1024U)
+
+static uint8_t buf[RANDOM_BUF_SIZE + 8];
+
+static uint32_t crc32_ref(const uint8_t block[], size_t len, uint32_t crc)
+{
+    for (size_t i = 0; i < len; i++) {
+        crc ^= block[i];
+        for (int j = 0; j < 8; j++) {
+            crc = (crc & 1U) ? (crc >> 1) ^ 0xEDB88320U : crc >> 1;
+        }
+    }
+    return crc;
+}
+
+static uint16_t crc16_ref(const uint8_t block[], size_t len, uint16_t crc)
+{
+    for (size_t i = 0; i < len; i++) {
+        crc ^= (uint16_t)(block[i] << 8);
+        for (int j = 0; j < 8; j++) {
+            crc = (crc & 0x8000U) ? (uint16_t)((crc << 1) ^ 0x1021U) : (uint16_t)(crc << 1);
+        }
+    }
+    return crc;
+}
+
+static uint32_t rand32(void)
+{
+    return ((uint32_t)rand() << 16) ^ (uint32_t)rand();
+}
+
+static double now_s(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/* The catalogue check values of CRC-32 and CRC-16/CCITT-FALSE */
+static void test_check_values(void)
+{
+    static const uint8_t check[] = "123456789";
+
+    TEST_EQUAL(crc32(check, 9, 0), 0xCBF43926U);
+    TEST_EQUAL(~crc32_sw(check, 9, 0xFFFFFFFFU), 0xCBF43926U);
+    TEST_EQUAL(crc16_ccitt_sw(check, 9, 0xFFFFU), 0x29B1U);
+    TEST_EQUAL(crc16_ccitt_new(check, 9, 0xFFFFU), 0x29B1U);
+    TEST_EQUAL(crc16_ccitt_sw(check, 9, 0x0000U), 0x31C3U);
+    TEST_EQUAL(crc32_sw(check, 0, 0x12345678U), 0x12345678U);
+}
+
+/* Every length across the slice boundaries, at every alignment */
+static void test_short(void)
+{
+    for (size_t offset = 0; offset < 8; offset++) {
+        for (size_t len = 0; len <= 64; len++) {
+            uint32_t crc = rand32();
+
+            TEST_EQUAL(crc32_sw(&buf[offset], len, crc), crc32_ref(&buf[offset], len, crc));
+        }
+    }
+}
+
+static void test_random(void)
+{
+    for (unsigned n = 0; n < RANDOM_RUNS; n++) {
+        size_t offset = rand() % 8;
+        size_t len = rand() % (RANDOM_BUF_SIZE + 1);
+        uint32_t crc = rand32();
+        uint16_t crc16 = (uint16_t)rand();
+
+        TEST_EQUAL(crc32_sw(&buf[offset], len, crc), crc32_ref(&buf[offset], len, crc));
+        TEST_EQUAL(crc16_ccitt_sw(&buf[offset], len, crc16), crc16_ref(&buf[offset], len, crc16));
+    }
+}
+
+/* Up to four calls at random splits give the CRC of the whole */
+static void test_chained(void)
+{
+    for (unsigned n = 0; n < RANDOM_RUNS; n++) {
+        size_t offset = rand() % 8;
+        size_t len = rand() % (RANDOM_BUF_SIZE + 1);
+        unsigned parts = 1 + rand() % 4;
+        uint32_t whole = crc32(&buf[offset], len, 0);
+        uint32_t crc = 0;
+        uint16_t whole16 = crc16_ccitt_sw(&buf[offset], len, 0xFFFFU);
+        uint16_t crc16 = 0xFFFFU;
+        size_t done = 0;
+
+        for (unsigned p = 0; p < parts; p++) {
+            size_t chunk = p + 1 == parts ? len - done : rand() % (len - done + 1);
+
+            crc = crc32(&buf[offset + done], chunk, crc);
+            crc16 = crc16_ccitt_new(&buf[offset + done], chunk, crc16);
+            done += chunk;
+        }
+        TEST_EQUAL(crc, whole);
+        TEST_EQUAL(crc16, whole16);
+    }
+}
+
+static double bench(uint32_t (*fn)(const uint8_t[], size_t, uint32_t), size_t offset, uint32_t bytes)
+{
+    volatile uint32_t sink;
+    uint32_t crc = 0xFFFFFFFFU;
+    double start = now_s();
+
+    for (uint32_t done = 0; done < bytes; done += BENCH_BUF_SIZE) {
+        crc = fn(&buf[offset], BENCH_BUF_SIZE, crc);
+    }
+    sink = crc;
+    (void)sink;
+    return bytes / (now_s() - start) / 1e6;
+}
+
+static void test_bench(void)
+{
+    double aligned = bench(crc32_sw, 0, BENCH_BYTES);
+    double unaligned = bench(crc32_sw, 1, BENCH_BYTES);
+    double ref = bench(crc32_ref, 0, BENCH_BYTES / 16U);
+
+    printf("\n    crc32_sw slice-by-%d: %.0f MB/s aligned, %.0f MB/s at +1, bitwise %.0f MB/s\n",
+           CRC32_SW_SLICES, aligned, unaligned, ref);
+    printf("%-40s ", "");
+}
+
+int main(void)
+{
+    halInit();
+    chSysInit();
+    srand(29);
+    for (size_t i = 0; i < sizeof(buf); i++) {
+        buf[i] = (uint8_t)rand();
+    }
+
+    TEST_RUN(test_check_values);
+    TEST_RUN(test_short);
+    TEST_RUN(test_random);
+    TEST_RUN(test_chained);
+    TEST_RUN(test_bench);
+    return 0;
+}
@@ -0,0 +1,280 @@
+/*
+ * Checks the COP-1 FARM in app_control farm.c: acceptance in sequence, the
+ * retransmit flag on a gap, Wait while no response buffer is free, lockout
+ * on a frame outside the window and the Unlock and Set V(R) directives,
+ * with the CLCW flags and the counters comms.c publishes at every step.
+ * Simulates go-back-N over the FARM on a lossy link and reports the frame
+ * slots it takes against one command per round trip.
+ */
+#include <string.h>
+#include "ch.h"
+#include "hal.h"
+#include "farm.h"
+#include "test.h"
+
+#define SIM_COUNT                   200U
+#define SIM_WINDOW                  (FARM_WINDOW_WIDTH / 2)
+/* Round trip in frame slots */
+#define SIM_RTT                     8U
+#define SIM_RTT_MAX                 64U
+
+static const uint8_t unlock[] = {FARM_DIR_UNLOCK};
+
+static uint32_t sim_seed;
+
+/* Small LCG so runs are repeatable for a given seed */
+static bool sim_lost(unsigned loss)
+{
+    sim_seed = sim_seed * 1103515245U + 12345U;
+    return ((sim_seed >> 16) % 100U) < loss;
+}
+
+/* The counters and CLCW flags after a step */
+static void check_farm(const farm_t *farm, uint32_t accepted, uint32_t rejected,
+                       uint32_t retransmits, uint32_t lockouts, uint32_t flags)
+{
+    uint32_t clcw = farm_clcw(farm);
+
+    TEST_EQUAL(farm->accepted, accepted);
+    TEST_EQUAL(farm->rejected, rejected);
+    TEST_EQUAL(farm->retransmits, retransmits);
+    TEST_EQUAL(farm->lockouts, lockouts);
+    TEST_EQUAL(clcw & (FARM_CLCW_LOCKOUT | FARM_CLCW_WAIT | FARM_CLCW_RETRANSMIT), flags);
+    TEST_EQUAL(clcw & FARM_CLCW_REPORT_Msk, farm->vr);
+}
+
+/* In sequence frames are accepted, duplicates from a retransmission discarded */
+static void test_sequence(void)
+{
+    farm_t farm;
+    uint32_t clcw;
+
+    farm_init(&farm, 2, FARM_WINDOW_WIDTH);
+    clcw = farm_clcw(&farm);
+    TEST_CHECK(clcw & FARM_CLCW_COP1);
+    TEST_EQUAL((clcw >> FARM_CLCW_VCID_Pos) & 0x3FU, 2);
+    check_farm(&farm, 0, 0, 0, 0, 0);
+
+    TEST_CHECK(farm_frame(&farm, false, 0, true));
+    TEST_CHECK(farm_frame(&farm, false, 1, true));
+    TEST_EQUAL(farm.vr, 2);
+    check_farm(&farm, 2, 0, 0, 0, 0);
+
+    TEST_CHECK(!farm_frame(&farm, false, 0, true));
+    TEST_EQUAL(farm.state, FARM_OPEN);
+    check_farm(&farm, 2, 1, 0, 0, 0);
+
+    /* V(R) wraps at 256 */
+    farm_set_vr(&farm, 255);
+    TEST_CHECK(farm_frame(&farm, false, 255, true));
+    TEST_CHECK(farm_frame(&farm, false, 0, true));
+    TEST_EQUAL(farm.vr, 1);
+    check_farm(&farm, 4, 1, 0, 0, 0);
+}
+
+/* A gap raises the retransmit flag once, the resend from V(R) clears it */
+static void test_retransmit(void)
+{
+    farm_t farm;
+
+    farm_init(&farm, 2, FARM_WINDOW_WIDTH);
+    TEST_CHECK(farm_frame(&farm, false, 0, true));
+    TEST_CHECK(!farm_frame(&farm, false, 2, true));
+    TEST_CHECK(farm.retransmit);
+    check_farm(&farm, 1, 1, 1, 0, FARM_CLCW_RETRANSMIT);
+
+    /* The rest of the window in flight counts one request */
+    TEST_CHECK(!farm_frame(&farm, false, 3, true));
+    check_farm(&farm, 1, 2, 1, 0, FARM_CLCW_RETRANSMIT);
+
+    TEST_CHECK(farm_frame(&farm, false, 1, true));
+    check_farm(&farm, 2, 2, 1, 0, 0);
+    TEST_CHECK(farm_frame(&farm, false, 2, true));
+    check_farm(&farm, 3, 2, 1, 0, 0);
+}
+
+/* No buffer for the response enters Wait until one is free again */
+static void test_wait(void)
+{
+    farm_t farm;
+
+    farm_init(&farm, 2, FARM_WINDOW_WIDTH);
+    TEST_CHECK(farm_frame(&farm, false, 0, true));
+    TEST_CHECK(!farm_frame(&farm, false, 1, false));
+    TEST_EQUAL(farm.state, FARM_WAIT);
+    check_farm(&farm, 1, 1, 1, 0, FARM_CLCW_WAIT | FARM_CLCW_RETRANSMIT);
+
+    /* Frames behind it are not accepted in Wait, and raise nothing more */
+    TEST_CHECK(!farm_frame(&farm, false, 2, false));
+    check_farm(&farm, 1, 2, 1, 0, FARM_CLCW_WAIT | FARM_CLCW_RETRANSMIT);
+
+    /* A free buffer leaves Wait, and so does Set V(R) */
+    TEST_CHECK(farm_frame(&farm, false, 1, true));
+    TEST_EQUAL(farm.state, FARM_OPEN);
+    check_farm(&farm, 2, 2, 1, 0, 0);
+    TEST_CHECK(!farm_frame(&farm, false, 2, false));
+    farm_set_vr(&farm, 2);
+    check_farm(&farm, 2, 3, 2, 0, 0);
+
+    /* BD frames pass in Wait and count FARM-B */
+    TEST_CHECK(!farm_frame(&farm, false, 2, false));
+    TEST_CHECK(farm_frame(&farm, true, 77, false));
+    TEST_EQUAL(farm.state, FARM_WAIT);
+    TEST_EQUAL((farm_clcw(&farm) >> FARM_CLCW_FARMB_Pos) & 0x3U, 2);
+    check_farm(&farm, 3, 4, 3, 0, FARM_CLCW_WAIT | FARM_CLCW_RETRANSMIT);
+}
+
+/* Outside both windows locks out until Unlock, Set V(R) is ignored there */
+static void test_lockout(void)
+{
+    const uint8_t setvr[] = {FARM_DIR_SET_VR, 0x00, 200};
+    const uint8_t bad[] = {FARM_DIR_SET_VR, 0x01, 200};
+    farm_t farm;
+
+    farm_init(&farm, 2, FARM_WINDOW_WIDTH);
+    TEST_CHECK(farm_frame(&farm, false, 0, true));
+
+    /* Just inside the windows is a gap or a duplicate */
+    TEST_CHECK(!farm_frame(&farm, false, 1 + FARM_WINDOW_WIDTH / 2 - 1, true));
+    TEST_CHECK(!farm_frame(&farm, false, (uint8_t)(1U - FARM_WINDOW_WIDTH / 2), true));
+    check_farm(&farm, 1, 2, 1, 0, FARM_CLCW_RETRANSMIT);
+
+    TEST_CHECK(!farm_frame(&farm, false, 100, true));
+    TEST_EQUAL(farm.state, FARM_LOCKOUT);
+    check_farm(&farm, 1, 3, 1, 1, FARM_CLCW_LOCKOUT | FARM_CLCW_RETRANSMIT);
+
+    /* Even V(R) is discarded, a second lockout is not counted */
+    TEST_CHECK(!farm_frame(&farm, false, 1, true));
+    TEST_CHECK(!farm_frame(&farm, false, 100, true));
+    check_farm(&farm, 1, 5, 1, 1, FARM_CLCW_LOCKOUT | FARM_CLCW_RETRANSMIT);
+
+    TEST_CHECK(farm_directive(&farm, setvr, sizeof(setvr)));
+    TEST_EQUAL(farm.vr, 1);
+    check_farm(&farm, 2, 5, 1, 1, FARM_CLCW_LOCKOUT | FARM_CLCW_RETRANSMIT);
+
+    TEST_CHECK(!farm_directive(&farm, bad, sizeof(bad)));
+    TEST_CHECK(!farm_directive(&farm, unlock, 2));
+    check_farm(&farm, 2, 7, 1, 1, FARM_CLCW_LOCKOUT | FARM_CLCW_RETRANSMIT);
+
+    TEST_CHECK(farm_directive(&farm, unlock, sizeof(unlock)));
+    TEST_EQUAL(farm.state, FARM_OPEN);
+    check_farm(&farm, 3, 7, 1, 1, 0);
+
+    TEST_CHECK(farm_directive(&farm, setvr, sizeof(setvr)));
+    TEST_EQUAL(farm.vr, 200);
+    TEST_CHECK(farm_frame(&farm, false, 200, true));
+    check_farm(&farm, 5, 7, 1, 1, 0);
+    TEST_EQUAL((farm_clcw(&farm) >> FARM_CLCW_FARMB_Pos) & 0x3U, 3);
+}
+
+/*
+ * Go-back-N over the FARM: the ground keeps up to <window> frames in flight,
+ * every slot returns a CLCW <rtt> slots later, and the ground rewinds to
+ * the reported V(R) on a retransmit flag or after a timeout. Frames and
+ * CLCWs are each lost with <loss> percent probability. Returns slots used.
+ */
+static uint32_t sim_go_back_n(farm_t *farm, unsigned count, unsigned loss, unsigned window, unsigned rtt)
+{
+    uint32_t clcw[SIM_RTT_MAX];
+    bool clcw_ok[SIM_RTT_MAX] = {false};
+    unsigned base = 0, next = 0, last_progress = 0, last_rewind = 0;
+    uint32_t slot;
+
+    farm_init(farm, 2, FARM_WINDOW_WIDTH);
+
+    for (slot = 0; farm->accepted < count; slot++) {
+        /* Ground send */
+        if (next < count && next < base + window) {
+            if (!sim_lost(loss)) {
+                farm_frame(farm, false, next & 0xFFU, true);
+            }
+            next++;
+        }
+
+        /* Downlink CLCW for this slot, seen by the ground rtt slots later */
+        unsigned idx = slot % rtt;
+        if (slot >= rtt && clcw_ok[idx]) {
+            uint8_t nr = clcw[idx] & FARM_CLCW_REPORT_Msk;
+            uint8_t acked = nr - (base & 0xFFU);
+            if (acked <= next - base) {
+                if (acked) {
+                    base += acked;
+                    last_progress = slot;
+                }
+                if ((clcw[idx] & FARM_CLCW_RETRANSMIT) && next > base && slot - last_rewind > rtt) {
+                    next = base;
+                    last_rewind = slot;
+                }
+            }
+        }
+        clcw[idx] = farm_clcw(farm);
+        clcw_ok[idx] = !sim_lost(loss);
+
+        /* Timer expiry */
+        if (next > base && slot - last_progress > 2 * rtt && slot - last_rewind > 2 * rtt) {
+            next = base;
+            last_rewind = slot;
+        }
+    }
+    return slot;
+}
+
+/* One command, then wait a round trip for its response and resend on timeout */
+static uint32_t sim_stop_and_wait(unsigned count, unsigned loss, unsigned rtt)
+{
+    uint32_t slots = 0;
+
+    for (unsigned i = 0; i < count; ) {
+        bool up = !sim_lost(loss);
+        bool down = !sim_lost(loss);
+        slots += 1 + rtt;
+        if (up && down) {
+            i++;
+        }
+    }
+    return slots;
+}
+
+/* Every command is delivered once and in order, in fewer slots than stop-and-wait */
+static void test_sim(void)
+{
+    static const unsigned losses[] = {0, 1, 5, 10, 20};
+    farm_t farm;
+
+    printf("\n    loss  go-back-N  cmds/100  stop-and-wait  cmds/100  retransmits  rejected\n");
+    for (size_t i = 0; i < sizeof(losses) / sizeof(losses[0]); i++) {
+        uint32_t gbn, sw;
+
+        sim_seed = 1;
+        gbn = sim_go_back_n(&farm, SIM_COUNT, losses[i], SIM_WINDOW, SIM_RTT);
+        sim_seed = 1;
+        sw = sim_stop_and_wait(SIM_COUNT, losses[i], SIM_RTT);
+
+        TEST_EQUAL(farm.accepted, SIM_COUNT);
+        TEST_EQUAL(farm.vr, SIM_COUNT & 0xFFU);
+        TEST_EQUAL(farm.lockouts, 0);
+        TEST_CHECK(gbn < sw);
+        if (losses[i] == 0) {
+            TEST_EQUAL(farm.rejected, 0);
+            TEST_EQUAL(farm.retransmits, 0);
+        } else {
+            TEST_CHECK(farm.retransmits > 0);
+        }
+        printf("    %3u%%  %9u  %8u  %13u  %8u  %11u  %8u\n", losses[i], gbn, SIM_COUNT * 100U / gbn,
+               sw, SIM_COUNT * 100U / sw, farm.retransmits, farm.rejected);
+    }
+    printf("%-40s ", "");
+}
+
+int main(void)
+{
+    halInit();
+    chSysInit();
+
+    TEST_RUN(test_sequence);
+    TEST_RUN(test_retransmit);
+    TEST_RUN(test_wait);
+    TEST_RUN(test_lockout);
+    TEST_RUN(test_sim);
+    return 0;
+}
@@ -0,0 +1,212 @@
+/*
+ * Round-trips the downlink FEC encoders in common/fec.c through the RS
+ * and Viterbi decoders of the fec shell command: clean frames at every
+ * interleave depth, the RS correction limit, sparse bit errors through
+ * the convolutional code and random frames at a fixed BER. Also measures
+ * encode throughput. The shell command is included for its decoders.
+ */
+#include <time.h>
+#include "test/test_fec.c"
+#include "test.h"
+
+#define RANDOM_FRAMES                       100U
+#define BENCH_FRAMES                        2000U
+
+static uint8_t out_depth;
+static bool out_conv;
+
+bool comms_set_fec(uint8_t depth, bool conv)
+{
+    out_depth = depth;
+    out_conv = conv;
+    return true;
+}
+
+void comms_get_fec(uint8_t *depth, bool *conv)
+{
+    *depth = out_depth;
+    *conv = out_conv;
+}
+
+static void fill_random(uint8_t *buf, size_t len)
+{
+    for (size_t i = 0; i < len; i++) {
+        buf[i] = fec_rand();
+    }
+}
+
+/* Systematic, the right length and decoded without corrections */
+static void test_rs_clean(void)
+{
+    static const size_t lens[] = {1, 100, 223, 500, 892};
+
+    fec_seed = 1;
+    for (uint8_t depth = 1; depth <= FEC_TEST_DEPTH; depth++) {
+        for (size_t i = 0; i < sizeof(lens) / sizeof(lens[0]); i++) {
+            size_t len = lens[i];
+
+            if (len > FEC_RS_K * depth) {
+                continue;
+            }
+            fill_random(fec_data, len);
+            size_t rs_len = fec_rs_encode(fec_data, len, depth, fec_rs, sizeof(fec_rs));
+            TEST_EQUAL(rs_len, FEC_RS_LEN(len, depth));
+            TEST_CHECK(memcmp(fec_rs, fec_data, len) == 0);
+
+            memcpy(fec_dec, fec_rs, rs_len);
+            TEST_EQUAL(rs_decode_block(fec_dec, rs_len, depth), 0);
+            TEST_CHECK(memcmp(fec_dec, fec_rs, rs_len) == 0);
+        }
+    }
+    /* Too long for the code block, or for the output buffer */
+    TEST_EQUAL(fec_rs_encode(fec_data, FEC_RS_K + 1, 1, fec_rs, sizeof(fec_rs)), 0);
+    TEST_EQUAL(fec_rs_encode(fec_data, FEC_RS_K, 1, fec_rs, FEC_RS_N - 1), 0);
+}
+
+/* Corrupts count distinct symbols of codeword i of an interleaved block */
+static void corrupt_symbols(uint8_t *block, size_t len, uint8_t depth, uint8_t i, unsigned count)
+{
+    size_t n = len / depth;
+    bool hit[FEC_RS_N] = {false};
+
+    while (count > 0) {
+        size_t j = fec_rand() % n;
+        uint8_t err = fec_rand();
+
+        if (hit[j] || err == 0) {
+            continue;
+        }
+        hit[j] = true;
+        block[j * depth + i] ^= err;
+        count--;
+    }
+}
+
+/* Up to 16 symbol errors in every codeword are corrected, 17 are not */
+static void test_rs_limit(void)
+{
+    fec_seed = 2;
+    for (uint8_t depth = 1; depth <= FEC_TEST_DEPTH; depth++) {
+        size_t len = FEC_RS_K * depth;
+        size_t rs_len;
+
+        fill_random(fec_data, len);
+        rs_len = fec_rs_encode(fec_data, len, depth, fec_rs, sizeof(fec_rs));
+
+        memcpy(fec_dec, fec_rs, rs_len);
+        for (uint8_t i = 0; i < depth; i++) {
+            corrupt_symbols(fec_dec, rs_len, depth, i, FEC_RS_PARITY / 2);
+        }
+        TEST_EQUAL(rs_decode_block(fec_dec, rs_len, depth), FEC_RS_PARITY / 2 * depth);
+        TEST_CHECK(memcmp(fec_dec, fec_data, len) == 0);
+
+        memcpy(fec_dec, fec_rs, rs_len);
+        corrupt_symbols(fec_dec, rs_len, depth, depth - 1, FEC_RS_PARITY / 2 + 1);
+        TEST_CHECK(rs_decode_block(fec_dec, rs_len, depth) < 0 ||
+                   memcmp(fec_dec, fec_data, len) != 0);
+    }
+}
+
+/* Clean and sparsely corrupted coded frames decode back to the input */
+static void test_conv(void)
+{
+    size_t len = FEC_RS_N * FEC_TEST_DEPTH;
+
+    fec_seed = 3;
+    fill_random(fec_rs, len);
+    size_t conv_len = fec_conv_encode(fec_rs, len, fec_conv, sizeof(fec_conv));
+    TEST_EQUAL(conv_len, FEC_CONV_LEN(len));
+    conv_decode(fec_conv, conv_len, fec_dec);
+    TEST_CHECK(memcmp(fec_dec, fec_rs, len) == 0);
+    /* Terminated with a zero byte */
+    TEST_EQUAL(fec_dec[len], 0);
+
+    /* One flipped bit in every 64 is well inside the free distance of 10 */
+    for (size_t n = 17; n < conv_len * 8; n += 64) {
+        fec_conv[n / 8] ^= 0x80U >> (n % 8);
+    }
+    conv_decode(fec_conv, conv_len, fec_dec);
+    TEST_CHECK(memcmp(fec_dec, fec_rs, len) == 0);
+
+    /* Too long for the output buffer */
+    TEST_EQUAL(fec_conv_encode(fec_rs, len, fec_conv, FEC_CONV_LEN(len) - 1), 0);
+}
+
+/* Random frames at a channel BER, returns the frames recovered */
+static unsigned ber_frames(uint32_t ber_ppm, bool conv)
+{
+    unsigned ok = 0;
+
+    fec_seed = 4;
+    for (unsigned f = 0; f < RANDOM_FRAMES; f++) {
+        fill_random(fec_data, sizeof(fec_data));
+        size_t len = fec_rs_encode(fec_data, sizeof(fec_data), FEC_TEST_DEPTH, fec_rs, sizeof(fec_rs));
+        if (conv) {
+            size_t clen = fec_conv_encode(fec_rs, len, fec_conv, sizeof(fec_conv));
+            fec_noise(fec_conv, clen, ber_ppm);
+            conv_decode(fec_conv, clen, fec_dec);
+        } else {
+            memcpy(fec_dec, fec_rs, len);
+            fec_noise(fec_dec, len, ber_ppm);
+        }
+        if (rs_decode_block(fec_dec, len, FEC_TEST_DEPTH) >= 0 &&
+                memcmp(fec_dec, fec_data, sizeof(fec_data)) == 0) {
+            ok++;
+        }
+    }
+    return ok;
+}
+
+static void test_ber(void)
+{
+    TEST_EQUAL(ber_frames(2000, false), RANDOM_FRAMES);
+    TEST_EQUAL(ber_frames(20000, true), RANDOM_FRAMES);
+    /* Well past what RS alone can take */
+    TEST_CHECK(ber_frames(20000, false) < RANDOM_FRAMES / 10);
+}
+
+static double now_s(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void test_bench(void)
+{
+    double start, rs_s, conv_s;
+    size_t len = 0;
+
+    fill_random(fec_data, sizeof(fec_data));
+    start = now_s();
+    for (unsigned i = 0; i < BENCH_FRAMES; i++) {
+        len = fec_rs_encode(fec_data, sizeof(fec_data), FEC_TEST_DEPTH, fec_rs, sizeof(fec_rs));
+    }
+    rs_s = now_s() - start;
+    start = now_s();
+    for (unsigned i = 0; i < BENCH_FRAMES; i++) {
+        fec_conv_encode(fec_rs, len, fec_conv, sizeof(fec_conv));
+    }
+    conv_s = now_s() - start;
+
+    TEST_EQUAL(len, FEC_RS_N * FEC_TEST_DEPTH);
+    printf("\n    RS(255,223) I=%u %.0f MB/s, conv k=7 r=1/2 %.0f MB/s of input\n",
+           FEC_TEST_DEPTH, BENCH_FRAMES * sizeof(fec_data) / rs_s / 1e6,
+           BENCH_FRAMES * len / conv_s / 1e6);
+    printf("%-40s ", "");
+}
+
+int main(void)
+{
+    halInit();
+    chSysInit();
+    fec_init();
+
+    TEST_RUN(test_rs_clean);
+    TEST_RUN(test_rs_limit);
+    TEST_RUN(test_conv);
+    TEST_RUN(test_ber);
+    TEST_RUN(test_bench);
+    return 0;
+}
@@ -0,0 +1,365 @@
+/*
+ * Runs the littlefs driver in common/fs.c on a RAM card behind the host SDC
+ * driver. Checks that the block count kept as files are written, truncated
+ * and removed stays close to a full traversal, that fs_usage() reads nothing
+ * from the card, and reports how the traversal it replaced grows with the
+ * number of files. Then checks the cache and lookahead sizes chosen at
+ * mount, that every handle opens and keeps its own cache with no heap, and
+ * reports the card I/O of open/write/close on a large card for several
+ * geometries.
+ */
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "ch.h"
+#include "hal.h"
+#include "fs.h"
+#include "test.h"
+
+#define CARD_MAX_BLOCKS                     (1U << 18)
+#define SMALL_CARD                          2048U
+#define LARGE_CARD                          CARD_MAX_BLOCKS
+#define BENCH_FILES                         32U
+#define BENCH_FILE_SIZE                     (16U * 1024U)
+#define FILE_SIZE                           2048U
+#define LINE_MMC_PWR                        PAL_LINE(GPIOC, 8U)
+
+/* Data blocks only are counted between traversals, CTZ pointers and
+ * inline files account for the rest */
+#define MAX_DRIFT                           8
+
+/* Sparse RAM card, blocks never written read as erased */
+static uint8_t *card[CARD_MAX_BLOCKS];
+
+static bool card_read(void *arg, uint32_t startblk, uint8_t *buf, uint32_t n)
+{
+    (void)arg;
+    for (uint32_t i = 0; i < n; i++, buf += MMCSD_BLOCK_SIZE) {
+        if (card[startblk + i] != NULL) {
+            memcpy(buf, card[startblk + i], MMCSD_BLOCK_SIZE);
+        } else {
+            memset(buf, 0xFF, MMCSD_BLOCK_SIZE);
+        }
+    }
+    return HAL_SUCCESS;
+}
+
+static bool card_write(void *arg, uint32_t startblk, const uint8_t *buf, uint32_t n)
+{
+    (void)arg;
+    for (uint32_t i = 0; i < n; i++, buf += MMCSD_BLOCK_SIZE) {
+        if (card[startblk + i] == NULL) {
+            card[startblk + i] = malloc(MMCSD_BLOCK_SIZE);
+        }
+        memcpy(card[startblk + i], buf, MMCSD_BLOCK_SIZE);
+    }
+    return HAL_SUCCESS;
+}
+
+static sdc_host_device_t card_dev = {
+    .read = card_read,
+    .write = card_write,
+};
+
+static const SDCConfig sdccfg = {
+    .bus_width = SDC_MODE_4BIT,
+};
+
+static FSConfig fscfg = {
+    .sdcp = &SDCD1,
+    .sdccfg = &sdccfg,
+    .mmc_pwr = LINE_MMC_PWR,
+};
+
+static FSDriver fs;
+
+/* crc.c needs the STM32 CRC unit, file_crc() is not exercised */
+uint32_t crc32(const uint8_t block[], size_t len, uint32_t crc)
+{
+    (void)block;
+    (void)len;
+    return crc;
+}
+
+/* Blank card of @p blocks, formatted and mounted with the current fscfg */
+static void card_mount(uint32_t blocks)
+{
+    if (fs.state == FS_MOUNTED) {
+        TEST_EQUAL(fs_unmount(&fs), LFS_ERR_OK);
+    }
+    for (uint32_t i = 0; i < CARD_MAX_BLOCKS; i++) {
+        free(card[i]);
+        card[i] = NULL;
+    }
+    card_dev.blocks = blocks;
+    sdcHostInsert(&SDCD1, &card_dev);
+    fs_start(&fs, &fscfg);
+    TEST_EQUAL(fs_mount(&fs, true), LFS_ERR_OK);
+}
+
+static int drift(void)
+{
+    return abs((int)fs.used_blocks - (int)fs_size(&fs));
+}
+
+static void write_file(const char *path, size_t size)
+{
+    static uint8_t buf[1024];
+    lfs_file_t *file = file_open(&fs, path, LFS_O_WRONLY | LFS_O_CREAT | LFS_O_TRUNC);
+
+    TEST_CHECK(file != NULL);
+    memset(buf, path[0], sizeof(buf));
+    for (size_t off = 0; off < size; off += sizeof(buf)) {
+        size_t n = size - off < sizeof(buf) ? size - off : sizeof(buf);
+        TEST_EQUAL(file_write(&fs, file, buf, n), (lfs_ssize_t)n);
+    }
+    TEST_EQUAL(file_close(&fs, file), LFS_ERR_OK);
+}
+
+static void test_usage(void)
+{
+    lfs_file_t *file;
+    uint32_t reads;
+
+    card_mount(SMALL_CARD);
+    /* Mounting counts the blocks in use */
+    TEST_EQUAL(fs.used_blocks, fs_size(&fs));
+
+    write_file("log", 64U * 1024U);
+    TEST_CHECK(fs.used_blocks >= (lfs_ssize_t)(64U * 1024U / MMCSD_BLOCK_SIZE));
+    TEST_CHECK(drift() <= MAX_DRIFT);
+
+    file = file_open(&fs, "log", LFS_O_RDWR);
+    TEST_CHECK(file != NULL);
+    TEST_EQUAL(file_truncate(&fs, file, 1000), LFS_ERR_OK);
+    TEST_EQUAL(file_close(&fs, file), LFS_ERR_OK);
+    TEST_CHECK(fs.used_blocks < 8);
+    TEST_CHECK(drift() <= MAX_DRIFT);
+
+    write_file("img", 32U * 1024U);
+    TEST_EQUAL(fs_remove(&fs, "log"), LFS_ERR_OK);
+    TEST_CHECK(drift() <= MAX_DRIFT);
+
+    /* Forced, the traversal replaces the count */
+    TEST_EQUAL(fs_reconcile(&fs, true), fs_size(&fs));
+    TEST_EQUAL(fs.used_blocks, fs_size(&fs));
+
+    /* The beacon reads nothing from the card */
+    reads = SDCD1.reads;
+    TEST_EQUAL(fs_usage(&fs), (uint8_t)(fs.used_blocks * 100 / SMALL_CARD));
+    TEST_EQUAL(SDCD1.reads, reads);
+}
+
+static void test_reconcile_interval(void)
+{
+    uint32_t reads;
+    int used;
+
+    card_mount(SMALL_CARD);
+    write_file("log", 20U * 1024U);
+    used = fs.used_blocks;
+
+    /* Too soon after the mount, the count stands */
+    reads = SDCD1.reads;
+    TEST_EQUAL(fs_reconcile(&fs, false), used);
+    TEST_EQUAL(SDCD1.reads, reads);
+
+    chThdSleep(FS_RECONCILE_INTERVAL + 1);
+    TEST_EQUAL(fs_reconcile(&fs, false), fs_size(&fs));
+    TEST_CHECK(SDCD1.reads > reads);
+
+    /* Unmounted there is nothing to count */
+    TEST_EQUAL(fs_unmount(&fs), LFS_ERR_OK);
+    TEST_EQUAL(fs_reconcile(&fs, false), -1);
+    TEST_EQUAL(fs_mount(&fs, false), LFS_ERR_OK);
+    TEST_EQUAL(fs.used_blocks, fs_size(&fs));
+}
+
+static double now_s(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void test_bench(void)
+{
+    static const unsigned counts[] = {8, 64, 256};
+    uint32_t last_reads = 0;
+    unsigned files = 0;
+
+    card_mount(SMALL_CARD);
+    printf("\n");
+    for (size_t c = 0; c < sizeof(counts) / sizeof(counts[0]); c++) {
+        uint32_t reads, size_reads, usage_reads;
+        double start, size_us, usage_us;
+        char path[16];
+
+        while (files < counts[c]) {
+            snprintf(path, sizeof(path), "f%u", files++);
+            write_file(path, FILE_SIZE);
+        }
+
+        reads = SDCD1.reads;
+        start = now_s();
+        TEST_CHECK(fs_size(&fs) > 0);
+        size_us = (now_s() - start) * 1e6;
+        size_reads = SDCD1.reads - reads;
+
+        reads = SDCD1.reads;
+        start = now_s();
+        TEST_CHECK(fs_usage(&fs) > 0);
+        usage_us = (now_s() - start) * 1e6;
+        usage_reads = SDCD1.reads - reads;
+
+        /* Constant for the beacon, the traversal grows with the files */
+        TEST_EQUAL(usage_reads, 0);
+        TEST_CHECK(size_reads > last_reads);
+        last_reads = size_reads;
+        printf("    %3u files: traversal %5u block reads %8.1f us, "
+               "fs_usage %u block reads %5.2f us\n",
+               files, size_reads, size_us, usage_reads, usage_us);
+    }
+    printf("%-40s ", "");
+}
+
+static void test_geometry(void)
+{
+    static const struct {
+        uint32_t                blocks;
+        lfs_size_t              cache_size;
+        lfs_size_t              lookahead_size;
+        lfs_size_t              cache;
+        lfs_size_t              lookahead;
+    } cases[] = {
+        /* A block of cache, a lookahead over the whole card */
+        {SMALL_CARD, 0, 0, 512, SMALL_CARD / 8},
+        /* Capped at the buffers in the driver */
+        {LARGE_CARD, 1024, 0, FS_CACHE_SIZE, FS_LOOKAHEAD_SIZE},
+        /* Down to a read size multiple dividing the block */
+        {SMALL_CARD, 200, 0, 128, SMALL_CARD / 8},
+        {SMALL_CARD, 0, 20, 512, 16},
+        /* Never below 8 bytes */
+        {100, 0, 0, 512, 8},
+    };
+
+    for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+        fscfg.cache_size = cases[i].cache_size;
+        fscfg.lookahead_size = cases[i].lookahead_size;
+        card_mount(cases[i].blocks);
+        TEST_EQUAL(fs.lfscfg.block_count, cases[i].blocks);
+        TEST_EQUAL(fs.lfscfg.cache_size, cases[i].cache);
+        TEST_EQUAL(fs.lfscfg.lookahead_size, cases[i].lookahead);
+    }
+    fscfg.cache_size = 0;
+    fscfg.lookahead_size = 0;
+}
+
+/* lfs_malloc() fails under LFS_NO_MALLOC, so any heap use fails the open */
+static void test_handles(void)
+{
+    lfs_file_t *file[FS_MAX_HANDLERS];
+    uint8_t buf[300], check[300];
+    char path[16];
+
+    card_mount(SMALL_CARD);
+    for (unsigned i = 0; i < FS_MAX_HANDLERS; i++) {
+        snprintf(path, sizeof(path), "h%u", i);
+        file[i] = file_open(&fs, path, LFS_O_RDWR | LFS_O_CREAT);
+        TEST_CHECK(file[i] != NULL);
+    }
+    TEST_CHECK(file_open(&fs, "extra", LFS_O_RDWR | LFS_O_CREAT) == NULL);
+    TEST_EQUAL(fs.err, LFS_ERR_NOMEM);
+
+    /* Interleaved writes through the per handle caches */
+    for (unsigned n = 0; n < 8; n++) {
+        for (unsigned i = 0; i < FS_MAX_HANDLERS; i++) {
+            memset(buf, 'a' + i, sizeof(buf));
+            TEST_EQUAL(file_write(&fs, file[i], buf, sizeof(buf)), (lfs_ssize_t)sizeof(buf));
+        }
+    }
+    for (unsigned i = 0; i < FS_MAX_HANDLERS; i++) {
+        TEST_EQUAL(file_rewind(&fs, file[i]), LFS_ERR_OK);
+        memset(buf, 'a' + i, sizeof(buf));
+        for (unsigned n = 0; n < 8; n++) {
+            TEST_EQUAL(file_read(&fs, file[i], check, sizeof(check)), (lfs_ssize_t)sizeof(check));
+            TEST_CHECK(memcmp(buf, check, sizeof(buf)) == 0);
+        }
+        TEST_EQUAL(file_close(&fs, file[i]), LFS_ERR_OK);
+    }
+
+    /* Closed handles go back to the pool */
+    file[0] = file_open(&fs, "extra", LFS_O_RDWR | LFS_O_CREAT);
+    TEST_CHECK(file[0] != NULL);
+    TEST_EQUAL(file_close(&fs, file[0]), LFS_ERR_OK);
+}
+
+/* Card I/O per file and time for the files written on a large card */
+static void bench_geometry(lfs_size_t cache_size, lfs_size_t lookahead_size,
+                           uint32_t *reads)
+{
+    uint32_t writes;
+    double start, us;
+
+    fscfg.cache_size = cache_size;
+    fscfg.lookahead_size = lookahead_size;
+    card_mount(LARGE_CARD);
+
+    *reads = SDCD1.reads;
+    writes = SDCD1.writes;
+    start = now_s();
+    for (unsigned i = 0; i < BENCH_FILES; i++) {
+        char path[16];
+
+        snprintf(path, sizeof(path), "b%u", i);
+        write_file(path, BENCH_FILE_SIZE);
+    }
+    us = (now_s() - start) * 1e6 / BENCH_FILES;
+    *reads = SDCD1.reads - *reads;
+    writes = SDCD1.writes - writes;
+
+    printf("    cache %3u lookahead %3u: %6.1f block reads %6.1f block writes "
+           "%8.1f us per file\n", (unsigned)fs.lfscfg.cache_size,
+           (unsigned)fs.lfscfg.lookahead_size, (double)*reads / BENCH_FILES,
+           (double)writes / BENCH_FILES, us);
+}
+
+static void test_bench_geometry(void)
+{
+    static const lfs_size_t caches[] = {128, 512};
+    static const lfs_size_t lookaheads[] = {16, 64, 256};
+
+    printf("\n    %u files of %u bytes on a %u block card\n",
+           BENCH_FILES, BENCH_FILE_SIZE, LARGE_CARD);
+    for (size_t c = 0; c < sizeof(caches) / sizeof(caches[0]); c++) {
+        uint32_t reads, first = 0;
+
+        for (size_t l = 0; l < sizeof(lookaheads) / sizeof(lookaheads[0]); l++) {
+            bench_geometry(caches[c], lookaheads[l], &reads);
+            if (l == 0) {
+                first = reads;
+            }
+        }
+        /* A wider window rescans the tree for free blocks less often */
+        TEST_CHECK(reads <= first);
+    }
+    fscfg.cache_size = 0;
+    fscfg.lookahead_size = 0;
+    printf("%-40s ", "");
+}
+
+int main(void)
+{
+    halInit();
+    chSysInit();
+    fs_init(&fs);
+
+    TEST_RUN(test_usage);
+    TEST_RUN(test_reconcile_interval);
+    TEST_RUN(test_bench);
+    TEST_RUN(test_geometry);
+    TEST_RUN(test_handles);
+    TEST_RUN(test_bench_geometry);
+    return 0;
+}
@@ -0,0 +1,256 @@
+/*
+ * Checks the software HMAC-SHA256 used for SDLS frame authentication in
+ * app_control against the RFC 4231 vectors, runs hmac_send()/hmac_recv()
+ * through a round trip with the anti-replay check, and measures frames
+ * verified per second with the cached key midstates against a key
+ * schedule rebuilt for every frame, as the transient key path did.
+ */
+#include <string.h>
+#include <time.h>
+#include "hmac.h"
+#include "CANopen.h"
+#include "OD.h"
+#include "test.h"
+
+#define BENCH_FRAMES                        20000U
+#define BENCH_ROUNDS                        3U
+
+OD_PERSIST_STATE_t OD_PERSIST_STATE;
+
+typedef struct {
+    const char                  *name;
+    const uint8_t               *key;
+    size_t                      keylen;
+    const uint8_t               *data;
+    size_t                      datalen;
+    const uint8_t               *mac;
+    size_t                      maclen;
+} rfc4231_t;
+
+/* RFC 4231 section 4, test cases 1 to 7 */
+static const uint8_t tc1_key[20] = {
+    0x0b, 0x0b, 0x0b, 0x0b, 0x0b, 0x0b, 0x0b, 0x0b, 0x0b, 0x0b,
+    0x0b, 0x0b, 0x0b, 0x0b, 0x0b, 0x0b, 0x0b, 0x0b, 0x0b, 0x0b };
+static const uint8_t tc1_mac[] = {
+    0xb0, 0x34, 0x4c, 0x61, 0xd8, 0xdb, 0x38, 0x53, 0x5c, 0xa8, 0xaf, 0xce,
+    0xaf, 0x0b, 0xf1, 0x2b, 0x88, 0x1d, 0xc2, 0x00, 0xc9, 0x83, 0x3d, 0xa7,
+    0x26, 0xe9, 0x37, 0x6c, 0x2e, 0x32, 0xcf, 0xf7 };
+static const uint8_t tc2_mac[] = {
+    0x5b, 0xdc, 0xc1, 0x46, 0xbf, 0x60, 0x75, 0x4e, 0x6a, 0x04, 0x24, 0x26,
+    0x08, 0x95, 0x75, 0xc7, 0x5a, 0x00, 0x3f, 0x08, 0x9d, 0x27, 0x39, 0x83,
+    0x9d, 0xec, 0x58, 0xb9, 0x64, 0xec, 0x38, 0x43 };
+static uint8_t tc3_key[20];
+static uint8_t tc3_data[50];
+static const uint8_t tc3_mac[] = {
+    0x77, 0x3e, 0xa9, 0x1e, 0x36, 0x80, 0x0e, 0x46, 0x85, 0x4d, 0xb8, 0xeb,
+    0xd0, 0x91, 0x81, 0xa7, 0x29, 0x59, 0x09, 0x8b, 0x3e, 0xf8, 0xc1, 0x22,
+    0xd9, 0x63, 0x55, 0x14, 0xce, 0xd5, 0x65, 0xfe };
+static uint8_t tc4_key[25];
+static uint8_t tc4_data[50];
+static const uint8_t tc4_mac[] = {
+    0x82, 0x55, 0x8a, 0x38, 0x9a, 0x44, 0x3c, 0x0e, 0xa4, 0xcc, 0x81, 0x98,
+    0x99, 0xf2, 0x08, 0x3a, 0x85, 0xf0, 0xfa, 0xa3, 0xe5, 0x78, 0xf8, 0x07,
+    0x7a, 0x2e, 0x3f, 0xf4, 0x67, 0x29, 0x66, 0x5b };
+static uint8_t tc5_key[20];
+static const uint8_t tc5_mac[] = {
+    0xa3, 0xb6, 0x16, 0x74, 0x73, 0x10, 0x0e, 0xe0, 0x6e, 0x0c, 0x79, 0x6c,
+    0x29, 0x55, 0x55, 0x2b };
+static uint8_t tc6_key[131];
+static const uint8_t tc6_mac[] = {
+    0x60, 0xe4, 0x31, 0x59, 0x1e, 0xe0, 0xb6, 0x7f, 0x0d, 0x8a, 0x26, 0xaa,
+    0xcb, 0xf5, 0xb7, 0x7f, 0x8e, 0x0b, 0xc6, 0x21, 0x37, 0x28, 0xc5, 0x14,
+    0x05, 0x46, 0x04, 0x0f, 0x0e, 0xe3, 0x7f, 0x54 };
+static const uint8_t tc7_mac[] = {
+    0x9b, 0x09, 0xff, 0xa7, 0x1b, 0x94, 0x2f, 0xcb, 0x27, 0x63, 0x5f, 0xbc,
+    0xd5, 0xb0, 0xe9, 0x44, 0xbf, 0xdc, 0x63, 0x64, 0x4f, 0x07, 0x13, 0x93,
+    0x8a, 0x7f, 0x51, 0x53, 0x5c, 0x3a, 0x35, 0xe2 };
+
+#define STR(s)                              (const uint8_t *)(s), sizeof(s) - 1U
+#define ARR(a)                              (a), sizeof(a)
+
+static const rfc4231_t vectors[] = {
+    {"TC1", ARR(tc1_key), STR("Hi There"), ARR(tc1_mac)},
+    {"TC2", STR("Jefe"), STR("what do ya want for nothing?"), ARR(tc2_mac)},
+    {"TC3", ARR(tc3_key), ARR(tc3_data), ARR(tc3_mac)},
+    {"TC4", ARR(tc4_key), ARR(tc4_data), ARR(tc4_mac)},
+    {"TC5", ARR(tc5_key), STR("Test With Truncation"), ARR(tc5_mac)},
+    {"TC6", ARR(tc6_key), STR("Test Using Larger Than Block-Size Key - Hash Key First"), ARR(tc6_mac)},
+    {"TC7", ARR(tc6_key), STR("This is a test using a larger than block-size key and a larger "
+                              "than block-size data. The key needs to be hashed before being "
+                              "used by the HMAC algorithm."), ARR(tc7_mac)},
+};
+
+static void vectors_init(void)
+{
+    memset(tc3_key, 0xaa, sizeof(tc3_key));
+    memset(tc3_data, 0xdd, sizeof(tc3_data));
+    for (size_t i = 0; i < sizeof(tc4_key); i++) {
+        tc4_key[i] = i + 1;
+    }
+    memset(tc4_data, 0xcd, sizeof(tc4_data));
+    memset(tc5_key, 0x0c, sizeof(tc5_key));
+    memset(tc6_key, 0xaa, sizeof(tc6_key));
+}
+
+static void test_rfc4231(void)
+{
+    for (size_t i = 0; i < sizeof(vectors) / sizeof(vectors[0]); i++) {
+        const rfc4231_t *tc = &vectors[i];
+        uint8_t mac[HMAC_MAC_LEN];
+        hmac_key_t key;
+        hmac_ctx_t ctx;
+
+        hmac_key_init(&key, tc->key, tc->keylen);
+        hmac_init(&ctx, &key);
+        hmac_update(&ctx, tc->data, tc->datalen);
+        hmac_final(&ctx, mac);
+        if (memcmp(mac, tc->mac, tc->maclen) != 0) {
+            fprintf(stderr, "%s: MAC mismatch\n", tc->name);
+        }
+        TEST_CHECK(memcmp(mac, tc->mac, tc->maclen) == 0);
+
+        /* Every split of the message through the streaming interface */
+        for (size_t split = 0; split <= tc->datalen; split++) {
+            hmac_init(&ctx, &key);
+            hmac_update(&ctx, tc->data, split);
+            hmac_update(&ctx, &tc->data[split], tc->datalen - split);
+            TEST_CHECK(hmac_verify(&ctx, tc->mac, tc->maclen));
+        }
+
+        /* A single flipped bit anywhere in the MAC fails */
+        for (size_t bit = 0; bit < tc->maclen * 8U; bit++) {
+            uint8_t bad[HMAC_MAC_LEN];
+
+            memcpy(bad, tc->mac, tc->maclen);
+            bad[bit / 8U] ^= 1U << (bit % 8U);
+            hmac_init(&ctx, &key);
+            hmac_update(&ctx, tc->data, tc->datalen);
+            TEST_CHECK(!hmac_verify(&ctx, bad, tc->maclen));
+        }
+    }
+}
+
+static void test_verify_length(void)
+{
+    uint8_t mac[HMAC_MAC_LEN];
+    hmac_key_t key;
+    hmac_ctx_t ctx;
+
+    hmac_key_init(&key, tc1_key, sizeof(tc1_key));
+    hmac_init(&ctx, &key);
+    hmac_update(&ctx, "Hi There", 8);
+    hmac_final(&ctx, mac);
+
+    hmac_init(&ctx, &key);
+    TEST_CHECK(!hmac_verify(&ctx, mac, 0));
+    hmac_init(&ctx, &key);
+    TEST_CHECK(!hmac_verify(&ctx, mac, HMAC_MAC_LEN + 1U));
+}
+
+static void test_send_recv(void)
+{
+    uint8_t key_a[HMAC_KEY_LEN], key_b[HMAC_KEY_LEN];
+    uint8_t frame[200], mac[HMAC_MAC_LEN];
+    uint32_t seq;
+
+    memset(key_a, 0x5a, sizeof(key_a));
+    memset(key_b, 0xa5, sizeof(key_b));
+    for (size_t i = 0; i < sizeof(frame); i++) {
+        frame[i] = i * 7;
+    }
+
+    /* The sending side stamps the current count */
+    OD_PERSIST_STATE.x6004_persistentState.EDL_SequenceCount = 41;
+    TEST_EQUAL(hmac_send(frame, sizeof(frame), NULL, &seq, mac, key_a), 0);
+    TEST_EQUAL(__builtin_bswap32(seq), 41);
+
+    /* Accepted once, then the count moves past it */
+    TEST_EQUAL(hmac_recv(frame, sizeof(frame), NULL, &seq, mac, key_a), 0);
+    TEST_EQUAL(OD_PERSIST_STATE.x6004_persistentState.EDL_SequenceCount, 42);
+    TEST_EQUAL(hmac_recv(frame, sizeof(frame), NULL, &seq, mac, key_a), -1);
+    TEST_EQUAL(OD_PERSIST_STATE.x6004_persistentState.EDL_SequenceCount, 42);
+
+    /* A changed key in the OD replaces the cached midstates */
+    OD_PERSIST_STATE.x6004_persistentState.EDL_SequenceCount = 41;
+    TEST_EQUAL(hmac_recv(frame, sizeof(frame), NULL, &seq, mac, key_b), -1);
+    TEST_EQUAL(hmac_send(frame, sizeof(frame), NULL, &seq, mac, key_b), 0);
+    TEST_EQUAL(hmac_recv(frame, sizeof(frame), NULL, &seq, mac, key_b), 0);
+
+    /* A tampered frame does not advance the count */
+    OD_PERSIST_STATE.x6004_persistentState.EDL_SequenceCount = 50;
+    TEST_EQUAL(hmac_send(frame, sizeof(frame), NULL, &seq, mac, key_a), 0);
+    frame[100] ^= 0x01;
+    TEST_EQUAL(hmac_recv(frame, sizeof(frame), NULL, &seq, mac, key_a), -1);
+    TEST_EQUAL(OD_PERSIST_STATE.x6004_persistentState.EDL_SequenceCount, 50);
+    frame[100] ^= 0x01;
+    TEST_EQUAL(hmac_recv(frame, sizeof(frame), NULL, &seq, mac, key_a), 0);
+}
+
+static double now_s(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/* Best of a few rounds, frames verified per second */
+static double bench(size_t len, bool cached)
+{
+    static uint8_t frame[1024];
+    uint8_t raw[HMAC_KEY_LEN] = {0};
+    uint8_t mac[HMAC_MAC_LEN] = {0};
+    volatile unsigned ok = 0;
+    hmac_key_t key;
+    hmac_ctx_t ctx;
+    double best = 0.0;
+
+    hmac_key_init(&key, raw, sizeof(raw));
+    for (unsigned r = 0; r < BENCH_ROUNDS; r++) {
+        double start = now_s();
+
+        for (unsigned i = 0; i < BENCH_FRAMES; i++) {
+            if (!cached) {
+                hmac_key_init(&key, raw, sizeof(raw));
+            }
+            hmac_init(&ctx, &key);
+            hmac_update(&ctx, frame, len);
+            ok += hmac_verify(&ctx, mac, sizeof(mac));
+        }
+
+        double rate = BENCH_FRAMES / (now_s() - start);
+        if (rate > best) {
+            best = rate;
+        }
+    }
+    return best;
+}
+
+/* Reported only, host timings are too noisy to fail a build on */
+static void test_bench(void)
+{
+    static const size_t lens[] = {32, 256, 1024};
+
+    printf("\n");
+    printf("    %6s %16s %16s %8s\n", "bytes", "per frame key/s", "cached key/s", "speedup");
+    for (size_t i = 0; i < sizeof(lens) / sizeof(lens[0]); i++) {
+        double slow = bench(lens[i], false);
+        double fast = bench(lens[i], true);
+
+        printf("    %6zu %16.0f %16.0f %7.2fx\n", lens[i], slow, fast, fast / slow);
+    }
+    printf("%-40s ", "");
+}
+
+int main(void)
+{
+    halInit();
+    chSysInit();
+    vectors_init();
+
+    TEST_RUN(test_rfc4231);
+    TEST_RUN(test_verify_length);
+    TEST_RUN(test_send_recv);
+    TEST_RUN(test_bench);
+    return 0;
+}
@@ -0,0 +1,282 @@
+/*
+ * Checks of the host runtime itself: priorities, virtual time, the blocking
+ * primitives with their timeouts, line events and bus timing. Every other
+ * host test relies on these.
+ */
+#include <string.h>
+#include "ch.h"
+#include "hal.h"
+#include "test.h"
+
+static THD_WORKING_AREA(wa_a, 1024);
+static THD_WORKING_AREA(wa_b, 1024);
+
+static char order[16];
+static unsigned order_n;
+
+static void mark(char c)
+{
+    order[order_n++] = c;
+    order[order_n] = '\0';
+}
+
+static void reset_marks(void)
+{
+    order_n = 0;
+    order[0] = '\0';
+}
+
+static THD_FUNCTION(mark_thd, arg)
+{
+    mark(*(const char *)arg);
+}
+
+/* A higher priority thread runs at creation, a lower one at the next block */
+static void test_priorities(void)
+{
+    thread_t *hi, *lo;
+
+    reset_marks();
+    hi = chThdCreateStatic(wa_a, sizeof(wa_a), NORMALPRIO + 1, mark_thd, "h");
+    mark('m');
+    lo = chThdCreateStatic(wa_b, sizeof(wa_b), NORMALPRIO - 1, mark_thd, "l");
+    mark('m');
+    chThdWait(hi);
+    chThdWait(lo);
+    TEST_CHECK(strcmp(order, "hmml") == 0);
+}
+
+static THD_FUNCTION(sleeper_thd, arg)
+{
+    chThdSleepMilliseconds((uintptr_t)arg);
+    mark('a' + (uintptr_t)arg / 10);
+}
+
+/* Sleeps end in deadline order and time only moves when everyone waits */
+static void test_sleep(void)
+{
+    systime_t start = chVTGetSystemTime();
+    thread_t *a, *b;
+
+    reset_marks();
+    a = chThdCreateStatic(wa_a, sizeof(wa_a), NORMALPRIO, sleeper_thd, (void *)20);
+    b = chThdCreateStatic(wa_b, sizeof(wa_b), NORMALPRIO, sleeper_thd, (void *)10);
+    TEST_EQUAL(chVTGetSystemTime(), start);
+    chThdWait(a);
+    chThdWait(b);
+    TEST_CHECK(strcmp(order, "bc") == 0);
+    TEST_EQUAL(chTimeDiffX(start, chVTGetSystemTime()), TIME_MS2I(20));
+}
+
+static mutex_t mtx;
+static unsigned shared;
+
+static THD_FUNCTION(locker_thd, arg)
+{
+    (void)arg;
+    for (int i = 0; i < 100; i++) {
+        chMtxLock(&mtx);
+        unsigned v = shared;
+        chThdSleep(1);
+        shared = v + 1;
+        chMtxUnlock(&mtx);
+    }
+}
+
+/* Holding a mutex across a sleep keeps the other thread out */
+static void test_mutex(void)
+{
+    thread_t *a, *b;
+
+    chMtxObjectInit(&mtx);
+    shared = 0;
+    a = chThdCreateStatic(wa_a, sizeof(wa_a), NORMALPRIO, locker_thd, NULL);
+    b = chThdCreateStatic(wa_b, sizeof(wa_b), NORMALPRIO, locker_thd, NULL);
+    chThdWait(a);
+    chThdWait(b);
+    TEST_EQUAL(shared, 200);
+}
+
+static semaphore_t sem;
+
+static void sem_cb(void *arg)
+{
+    (void)arg;
+    chSemSignalI(&sem);
+}
+
+/* A timer callback signals as an ISR, waits time out on the tick */
+static void test_semaphore_timeout(void)
+{
+    virtual_timer_t vt;
+    systime_t start;
+
+    chSemObjectInit(&sem, 0);
+    chVTObjectInit(&vt);
+    start = chVTGetSystemTime();
+    TEST_EQUAL(chSemWaitTimeout(&sem, TIME_MS2I(5)), MSG_TIMEOUT);
+    TEST_EQUAL(chTimeDiffX(start, chVTGetSystemTime()), TIME_MS2I(5));
+    TEST_EQUAL(chSemWaitTimeout(&sem, TIME_IMMEDIATE), MSG_TIMEOUT);
+
+    chVTSet(&vt, TIME_MS2I(3), sem_cb, NULL);
+    start = chVTGetSystemTime();
+    TEST_EQUAL(chSemWaitTimeout(&sem, TIME_MS2I(5)), MSG_OK);
+    TEST_EQUAL(chTimeDiffX(start, chVTGetSystemTime()), TIME_MS2I(3));
+}
+
+static mailbox_t mb;
+static msg_t mb_buf[2];
+
+static THD_FUNCTION(producer_thd, arg)
+{
+    (void)arg;
+    for (msg_t i = 1; i <= 5; i++) {
+        TEST_EQUAL(chMBPostTimeout(&mb, i, TIME_INFINITE), MSG_OK);
+    }
+}
+
+/* A full mailbox blocks the producer until the consumer catches up */
+static void test_mailbox(void)
+{
+    thread_t *tp;
+    msg_t msg;
+
+    chMBObjectInit(&mb, mb_buf, 2);
+    tp = chThdCreateStatic(wa_a, sizeof(wa_a), NORMALPRIO + 1, producer_thd, NULL);
+    TEST_EQUAL(chMBGetUsedCountI(&mb), 2);
+    for (msg_t i = 1; i <= 5; i++) {
+        TEST_EQUAL(chMBFetchTimeout(&mb, &msg, TIME_MS2I(1)), MSG_OK);
+        TEST_EQUAL(msg, i);
+    }
+    TEST_EQUAL(chMBFetchTimeout(&mb, &msg, TIME_MS2I(1)), MSG_TIMEOUT);
+    chThdWait(tp);
+}
+
+static event_source_t es;
+
+static THD_FUNCTION(broadcast_thd, arg)
+{
+    (void)arg;
+    chThdSleepMilliseconds(1);
+    chEvtBroadcastFlags(&es, 0x5);
+}
+
+static void test_events(void)
+{
+    event_listener_t el;
+    thread_t *tp;
+
+    chEvtObjectInit(&es);
+    chEvtRegisterMaskWithFlags(&es, &el, EVENT_MASK(2), 0x4);
+    tp = chThdCreateStatic(wa_a, sizeof(wa_a), NORMALPRIO, broadcast_thd, NULL);
+    TEST_EQUAL(chEvtWaitAnyTimeout(EVENT_MASK(2), TIME_MS2I(10)), EVENT_MASK(2));
+    TEST_EQUAL(chEvtGetAndClearFlags(&el), 0x5);
+    TEST_EQUAL(chEvtWaitAnyTimeout(EVENT_MASK(2), TIME_MS2I(1)), 0);
+    chEvtUnregister(&es, &el);
+    chThdWait(tp);
+}
+
+#define LINE_TEST                           PAL_LINE(GPIOB, 3U)
+
+static unsigned line_cbs;
+
+static void line_cb(void *arg)
+{
+    (void)arg;
+    line_cbs++;
+}
+
+static void drive_cb(void *arg)
+{
+    palHostDriveLine(LINE_TEST, (uintptr_t)arg);
+}
+
+/* Only the enabled edge wakes a waiter, disabling the event releases it */
+static void test_line_event(void)
+{
+    virtual_timer_t vt;
+
+    chVTObjectInit(&vt);
+    palSetLineMode(LINE_TEST, PAL_MODE_INPUT_PULLDOWN);
+    TEST_EQUAL(palReadLine(LINE_TEST), PAL_LOW);
+    palEnableLineEvent(LINE_TEST, PAL_EVENT_MODE_RISING_EDGE);
+    palSetLineCallback(LINE_TEST, line_cb, NULL);
+
+    chVTSet(&vt, TIME_MS2I(2), drive_cb, (void *)1);
+    TEST_EQUAL(palWaitLineTimeout(LINE_TEST, TIME_MS2I(5)), MSG_OK);
+    TEST_EQUAL(line_cbs, 1);
+    chVTSet(&vt, TIME_MS2I(2), drive_cb, (void *)0);
+    TEST_EQUAL(palWaitLineTimeout(LINE_TEST, TIME_MS2I(5)), MSG_TIMEOUT);
+    TEST_EQUAL(line_cbs, 1);
+    palDisableLineEvent(LINE_TEST);
+}
+
+/* 1050 bytes at 10.5 MHz take 800 us */
+static void test_spi_timing(void)
+{
+    static const SPIConfig cfg = {false, NULL, PAL_LINE(GPIOA, 7U), SPI_CR1_BR_1, 0};
+    static uint8_t buf[1050];
+    uint64_t start;
+
+    TEST_EQUAL(spiHostClock(&cfg), 10500000);
+    spiStart(&SPID2, &cfg);
+    spiAcquireBus(&SPID2);
+    start = chHostTimeUS();
+    spiSelect(&SPID2);
+    spiExchange(&SPID2, sizeof(buf), buf, buf);
+    spiUnselect(&SPID2);
+    spiReleaseBus(&SPID2);
+    TEST_EQUAL(chHostTimeUS() - start, 800);
+    TEST_EQUAL(buf[0], 0xFF);
+    TEST_EQUAL(SPID2.xfers, 1);
+    TEST_EQUAL(SPID2.bytes, sizeof(buf));
+    spiStop(&SPID2);
+}
+
+static uint8_t i2c_reg[4];
+
+static msg_t i2c_transfer(void *arg, const uint8_t *txbuf, size_t txbytes,
+                          uint8_t *rxbuf, size_t rxbytes)
+{
+    (void)arg;
+    if (txbytes > 1U) {
+        memcpy(&i2c_reg[txbuf[0]], &txbuf[1], txbytes - 1U);
+    } else if (rxbytes > 0U) {
+        memcpy(rxbuf, &i2c_reg[txbuf[0]], rxbytes);
+    }
+    return MSG_OK;
+}
+
+static void test_i2c(void)
+{
+    static const i2c_host_device_t dev = {NULL, i2c_transfer};
+    static const I2CConfig cfg = {0, 0, 0};
+    uint8_t tx[3] = {1, 0xAB, 0xCD}, rx[2];
+
+    i2cHostAttach(&I2CD2, 0x30, &dev);
+    i2cStart(&I2CD2, &cfg);
+    TEST_EQUAL(i2cMasterTransmitTimeout(&I2CD2, 0x30, tx, 3, NULL, 0, TIME_INFINITE), MSG_OK);
+    TEST_EQUAL(i2cMasterTransmitTimeout(&I2CD2, 0x30, tx, 1, rx, 2, TIME_INFINITE), MSG_OK);
+    TEST_EQUAL(rx[0], 0xAB);
+    TEST_EQUAL(rx[1], 0xCD);
+    TEST_EQUAL(i2cMasterTransmitTimeout(&I2CD2, 0x31, tx, 1, rx, 1, TIME_INFINITE), MSG_RESET);
+    TEST_EQUAL(i2cGetErrors(&I2CD2), I2C_ACK_FAILURE);
+    i2cStop(&I2CD2);
+}
+
+int main(void)
+{
+    halInit();
+    chSysInit();
+
+    TEST_RUN(test_priorities);
+    TEST_RUN(test_sleep);
+    TEST_RUN(test_mutex);
+    TEST_RUN(test_semaphore_timeout);
+    TEST_RUN(test_mailbox);
+    TEST_RUN(test_events);
+    TEST_RUN(test_line_event);
+    TEST_RUN(test_spi_timing);
+    TEST_RUN(test_i2c);
+    return 0;
+}
@@ -0,0 +1,284 @@
+/*
+ * Checks the downlink rate selection in app_control link.c: fixed modes,
+ * the RSSI, frame error and Doppler thresholds with their hysteresis, the
+ * pass timeout, and all of it across the system time wrap. Simulates
+ * overhead passes with a varying C/N0 and reports the bytes delivered per
+ * pass with the rate selected from uplink quality against either fixed rate.
+ */
+#include <string.h>
+#include "ch.h"
+#include "hal.h"
+#include "link.h"
+#include "test.h"
+
+#define SIM_PASS_S                  600U
+/* Uplink frames per second */
+#define SIM_UPLINK                  4U
+#define SIM_HIGH_BPS                96000U
+#define SIM_LOW_BPS                 9600U
+/* 10*log10 of the bit rates, in 0.1 dB */
+#define SIM_HIGH_DBHZ               498
+#define SIM_LOW_DBHZ                398
+/* Received power = C/N0 - 160 dB, in AX5043 RSSI units */
+#define SIM_RSSI_OFS                160
+/* Peak Doppler at UHF, Hz */
+#define SIM_DOPPLER                 10000
+
+/*
+ * Frame error rate in permille of 2048 bit frames with noncoherent FSK,
+ * by Eb/N0 from 9 to 15 dB.
+ */
+static const uint16_t fer_table[] = {1000, 999, 849, 310, 46, 4, 0};
+
+static uint32_t sim_seed;
+
+/* Small LCG so runs are repeatable for a given seed */
+static bool sim_lost(unsigned permille)
+{
+    sim_seed = sim_seed * 1103515245U + 12345U;
+    return ((sim_seed >> 16) % 1000U) < permille;
+}
+
+/* Linear interpolation of fer_table, ebn0 in 0.1 dB */
+static unsigned sim_fer(int ebn0)
+{
+    if (ebn0 < 90)
+        return 1000;
+    if (ebn0 >= 150)
+        return 0;
+    unsigned i = (ebn0 - 90) / 10;
+    unsigned f = (ebn0 - 90) % 10;
+    return (fer_table[i] * (10 - f) + fer_table[i + 1] * f) / 10;
+}
+
+/*
+ * One overhead pass starting at <start>: C/N0 in 0.1 dB-Hz rises from 20 dB
+ * below <peak> at the horizon to <peak> at culmination along a parabola,
+ * and the Doppler shift sweeps linearly through zero. The uplink at the
+ * high rate feeds the selector, the downlink delivers one second of data
+ * at the selected rate. Returns bytes delivered.
+ */
+static uint32_t sim_pass(link_t *link, link_mode_t mode, int peak, systime_t start)
+{
+    uint32_t bytes = 0;
+
+    sim_seed = 1;
+    link_init(link, mode);
+
+    for (uint32_t t = 0; t < SIM_PASS_S; t++) {
+        int x = (int)(t * 200U / SIM_PASS_S) - 100;
+        int cn0 = peak - 200 * x * x / 10000;
+        int32_t foff = SIM_DOPPLER * -x / 100;
+        unsigned up_fer = sim_fer(cn0 - SIM_HIGH_DBHZ);
+
+        for (uint32_t n = 0; n < SIM_UPLINK; n++) {
+            systime_t now = chTimeAddX(start, TIME_MS2I(t * 1000U + n * (1000U / SIM_UPLINK)));
+            if (sim_lost(up_fer)) {
+                link_error(link, now);
+            } else {
+                link_frame(link, now, (cn0 / 10) - SIM_RSSI_OFS, foff);
+            }
+        }
+
+        if (link->high) {
+            bytes += SIM_HIGH_BPS / 8U * (1000U - sim_fer(cn0 - SIM_HIGH_DBHZ)) / 1000U;
+        } else {
+            bytes += SIM_LOW_BPS / 8U * (1000U - sim_fer(cn0 - SIM_LOW_DBHZ)) / 1000U;
+        }
+    }
+    return bytes;
+}
+
+/* Feed one full window of frames 100 ms apart, <bad> of them dropped */
+static bool link_window(link_t *link, systime_t *now, unsigned bad, int8_t rssi, int32_t foff)
+{
+    bool changed = false;
+
+    for (unsigned i = 0; i < LINK_WINDOW; i++) {
+        *now = chTimeAddX(*now, TIME_MS2I(100));
+        if (i < bad) {
+            changed |= link_error(link, *now);
+        } else {
+            changed |= link_frame(link, *now, rssi, foff);
+        }
+    }
+    return changed;
+}
+
+static void test_fixed(void)
+{
+    link_t link;
+    systime_t now = 0;
+
+    link_init(&link, LINK_FIXED_HIGH);
+    TEST_CHECK(!link_window(&link, &now, LINK_WINDOW, 0, 0));
+    TEST_CHECK(link.high);
+    TEST_EQUAL(link.fer, 100);
+    TEST_CHECK(!link_check(&link, chTimeAddX(now, TIME_MS2I(LINK_PASS_TIMEOUT))));
+    TEST_CHECK(link.high);
+
+    link_init(&link, LINK_FIXED_LOW);
+    TEST_CHECK(!link_window(&link, &now, 0, 0, 0));
+    TEST_CHECK(!link_window(&link, &now, 0, 0, 0));
+    TEST_CHECK(!link.high);
+    TEST_EQUAL(link.switches, 0);
+}
+
+/* The thresholds, the hold before moving up and the RSSI gap between up and down */
+static void test_hysteresis(void)
+{
+    link_t link;
+    systime_t now = 0;
+
+    link_init(&link, LINK_AUTO);
+    TEST_CHECK(!link.high);
+
+    /* One good window holds, the second moves up */
+    TEST_CHECK(!link_window(&link, &now, 0, LINK_RSSI_UP, 0));
+    TEST_CHECK(!link.high);
+    TEST_EQUAL(link.hold, 1);
+    TEST_CHECK(link_window(&link, &now, 0, LINK_RSSI_UP, 0));
+    TEST_CHECK(link.high);
+    TEST_EQUAL(link.switches, 1);
+
+    /* Inside the gap stays high, below it moves down at once */
+    TEST_CHECK(!link_window(&link, &now, 0, LINK_RSSI_DOWN, 0));
+    TEST_CHECK(link.high);
+    TEST_EQUAL(link.rssi, LINK_RSSI_DOWN);
+    TEST_CHECK(link_window(&link, &now, 0, LINK_RSSI_DOWN - 1, 0));
+    TEST_CHECK(!link.high);
+    TEST_EQUAL(link.switches, 2);
+
+    /* Inside the gap does not move up either */
+    TEST_CHECK(!link_window(&link, &now, 0, LINK_RSSI_UP - 1, 0));
+    TEST_CHECK(!link_window(&link, &now, 0, LINK_RSSI_UP - 1, 0));
+    TEST_CHECK(!link.high);
+    TEST_EQUAL(link.hold, 0);
+
+    /* A bad window in between resets the hold */
+    TEST_CHECK(!link_window(&link, &now, 0, LINK_RSSI_UP, 0));
+    TEST_CHECK(!link_window(&link, &now, LINK_WINDOW / 2, LINK_RSSI_UP, 0));
+    TEST_EQUAL(link.hold, 0);
+    TEST_CHECK(!link_window(&link, &now, 0, LINK_RSSI_UP, 0));
+    TEST_CHECK(!link.high);
+
+    /* Doppler beyond the limit either way blocks the high rate */
+    TEST_CHECK(!link_window(&link, &now, 0, LINK_RSSI_UP, LINK_FOFF_MAX + 1));
+    TEST_CHECK(!link_window(&link, &now, 0, LINK_RSSI_UP, -LINK_FOFF_MAX - 1));
+    TEST_CHECK(!link.high);
+    TEST_CHECK(!link_window(&link, &now, 0, LINK_RSSI_UP, LINK_FOFF_MAX));
+    TEST_CHECK(link_window(&link, &now, 0, LINK_RSSI_UP, -LINK_FOFF_MAX));
+    TEST_CHECK(link.high);
+
+    /* Frame errors: at the up limit still good, past the down limit moves down */
+    TEST_CHECK(!link_window(&link, &now, LINK_WINDOW * LINK_FER_DOWN / 100, LINK_RSSI_UP, 0));
+    TEST_CHECK(link.high);
+    TEST_CHECK(link_window(&link, &now, LINK_WINDOW / 4, LINK_RSSI_UP, 0));
+    TEST_CHECK(!link.high);
+    TEST_EQUAL(link.fer, 25);
+    TEST_EQUAL(link.errors, LINK_WINDOW / 2 + LINK_WINDOW * LINK_FER_DOWN / 100 + LINK_WINDOW / 4);
+    TEST_EQUAL(link.frames + link.errors, 15 * LINK_WINDOW);
+    TEST_EQUAL(link.passes, 1);
+
+    /* A window of nothing but errors has no RSSI */
+    TEST_CHECK(!link_window(&link, &now, LINK_WINDOW, 0, 0));
+    TEST_EQUAL(link.rssi, INT16_MIN);
+    TEST_EQUAL(link.fer, 100);
+}
+
+/* A pass that spans the system time wrap times out like any other */
+static void test_wrap(void)
+{
+    link_t link;
+    systime_t now = TIME_MAX_SYSTIME - TIME_MS2I(10000);
+
+    link_init(&link, LINK_AUTO);
+    link_window(&link, &now, 0, LINK_RSSI_UP, 0);
+    link_window(&link, &now, 0, LINK_RSSI_UP, 0);
+    TEST_CHECK(link.high);
+    TEST_CHECK(link.in_pass);
+
+    /* The last frame before the wrap, the timeout lands after it */
+    TEST_CHECK(now < TIME_MAX_SYSTIME);
+    TEST_CHECK(chTimeAddX(now, TIME_MS2I(LINK_PASS_TIMEOUT)) < now);
+    TEST_CHECK(!link_check(&link, chTimeAddX(now, TIME_MS2I(LINK_PASS_TIMEOUT) - 1)));
+    TEST_CHECK(link.high);
+    TEST_CHECK(link_check(&link, chTimeAddX(now, TIME_MS2I(LINK_PASS_TIMEOUT))));
+    TEST_CHECK(!link.high);
+    TEST_CHECK(!link.in_pass);
+    TEST_CHECK(!link_check(&link, chTimeAddX(now, TIME_MS2I(2 * LINK_PASS_TIMEOUT))));
+
+    /* Frames across the wrap keep the pass going, the next frame starts a new one */
+    link_window(&link, &now, 0, LINK_RSSI_UP, 0);
+    TEST_EQUAL(link.passes, 2);
+    TEST_EQUAL(link.frames, LINK_WINDOW);
+    now = TIME_MAX_SYSTIME - TIME_MS2I(500);
+    for (unsigned i = 0; i < 3; i++) {
+        link_window(&link, &now, 0, LINK_RSSI_UP, 0);
+        TEST_CHECK(!link_check(&link, chTimeAddX(now, TIME_MS2I(1000))));
+    }
+    TEST_CHECK(now < TIME_MS2I(10000));
+    TEST_EQUAL(link.passes, 2);
+    TEST_CHECK(link.high);
+
+    /* A whole simulated pass delivers the same across the wrap */
+    for (link_mode_t mode = LINK_AUTO; mode <= LINK_FIXED_HIGH; mode++) {
+        link_t wrapped;
+        uint32_t bytes = sim_pass(&link, mode, 680, 0);
+
+        TEST_EQUAL(sim_pass(&wrapped, mode, 680, TIME_MAX_SYSTIME - TIME_S2I(SIM_PASS_S / 2)), bytes);
+        TEST_EQUAL(wrapped.switches, link.switches);
+        TEST_EQUAL(wrapped.frames, link.frames);
+    }
+}
+
+/*
+ * Passes from a low to a high peak C/N0. The selector never delivers less
+ * than the low rate. Once the high rate closes for a good part of the pass
+ * it goes up once and down once, and gives up only the margin at either
+ * end against fixed high rate, which in turn delivers nothing on a weak
+ * pass. Near the threshold the 5% frame error limit keeps it low while
+ * the high rate would still deliver more through the losses.
+ */
+static void test_sim(void)
+{
+    static const int peaks[] = {560, 620, 680, 740, 800};
+
+    printf("\n    peak dB-Hz      auto kB       low kB      high kB  switches\n");
+    for (size_t i = 0; i < sizeof(peaks) / sizeof(peaks[0]); i++) {
+        link_t link;
+        uint32_t bytes[3];
+        uint32_t switches = 0;
+
+        for (link_mode_t mode = LINK_AUTO; mode <= LINK_FIXED_HIGH; mode++) {
+            bytes[mode] = sim_pass(&link, mode, peaks[i], 0);
+            if (mode == LINK_AUTO)
+                switches = link.switches;
+            else
+                TEST_EQUAL(link.switches, 0);
+        }
+        printf("    %10d %12u %12u %12u %9u\n", peaks[i] / 10, bytes[LINK_AUTO] / 1024U,
+               bytes[LINK_FIXED_LOW] / 1024U, bytes[LINK_FIXED_HIGH] / 1024U, switches);
+
+        TEST_CHECK(bytes[LINK_AUTO] >= bytes[LINK_FIXED_LOW]);
+        if (bytes[LINK_FIXED_HIGH] < bytes[LINK_FIXED_LOW])
+            TEST_EQUAL(bytes[LINK_AUTO], bytes[LINK_FIXED_LOW]);
+        if (peaks[i] >= 680) {
+            TEST_EQUAL(switches, 2);
+            TEST_CHECK(bytes[LINK_AUTO] * 100U >= bytes[LINK_FIXED_HIGH] * 95U);
+        }
+    }
+    printf("%-40s ", "");
+}
+
+int main(void)
+{
+    halInit();
+    chSysInit();
+
+    TEST_RUN(test_fixed);
+    TEST_RUN(test_hysteresis);
+    TEST_RUN(test_wrap);
+    TEST_RUN(test_sim);
+    return 0;
+}
@@ -0,0 +1,195 @@
+/*
+ * Runs the MMC5883MA driver against the register level model, on I2CD1
+ * shared with the BMI088 like app_imu: start up, offset cancellation,
+ * continuous sampling, and stopping both devices in the app's order.
+ */
+#include <string.h>
+#include "ch.h"
+#include "hal.h"
+#include "bmi088.h"
+#include "mmc5883ma.h"
+#include "mmc5883ma_model.h"
+#include "test.h"
+
+#define BMI088_GYRO_SADDR                   0x68U
+#define BMI088_ACC_SADDR                    0x18U
+#define MMC5883MA_SADDR                     0x30U
+
+static const I2CConfig i2ccfg = {0, 0, 0};
+
+static const BMI088Config imucfg = {
+    .i2cp = &I2CD1,
+    .i2ccfg = &i2ccfg,
+    .gyro_saddr = BMI088_GYRO_SADDR,
+    .acc_saddr = BMI088_ACC_SADDR,
+};
+
+static const MMC5883MAConfig magcfg = {
+    .i2cp = &I2CD1,
+    .i2ccfg = &i2ccfg,
+    .saddr = MMC5883MA_SADDR,
+    .bw = MMC5883MA_INTRNLCTRL1_BW_100Hz,
+    .cm_freq = MMC5883MA_INTRNLCTRL2_CM_FREQ_14Hz,
+    .setreset_interval = 4,
+};
+
+static BMI088Driver imudev;
+static MMC5883MADriver magdev;
+static mmc5883ma_model_t mag;
+
+/* Only what the BMI088 driver reads back: chip IDs, everything else zero */
+typedef struct {
+    uint8_t regs[0x80];
+} bmi088_fake_t;
+
+static bmi088_fake_t acc, gyro;
+
+static msg_t mag_transfer(void *arg, const uint8_t *txbuf, size_t txbytes,
+                          uint8_t *rxbuf, size_t rxbytes)
+{
+    mmc5883maModelAdvance(arg, chHostTimeUS());
+    return mmc5883maModelTransfer(arg, txbuf, txbytes, rxbuf, rxbytes) == 0 ? MSG_OK : MSG_RESET;
+}
+
+static msg_t bmi088_transfer(void *arg, const uint8_t *txbuf, size_t txbytes,
+                             uint8_t *rxbuf, size_t rxbytes)
+{
+    bmi088_fake_t *dev = arg;
+    uint8_t reg = txbuf[0] & 0x7FU;
+
+    for (size_t i = 1; i < txbytes; i++) {
+        if (reg != 0U) {
+            dev->regs[(reg + i - 1U) & 0x7FU] = txbuf[i];
+        }
+    }
+    for (size_t i = 0; i < rxbytes; i++) {
+        rxbuf[i] = dev->regs[(reg + i) & 0x7FU];
+    }
+    return MSG_OK;
+}
+
+static const i2c_host_device_t mag_dev = {&mag, mag_transfer};
+static const i2c_host_device_t acc_dev = {&acc, bmi088_transfer};
+static const i2c_host_device_t gyro_dev = {&gyro, bmi088_transfer};
+
+static void check_sample(const mmc5883ma_sample_t *s, int x, int y, int z)
+{
+    TEST_CHECK(s->mag_x >= x - 1 && s->mag_x <= x + 1);
+    TEST_CHECK(s->mag_y >= y - 1 && s->mag_y <= y + 1);
+    TEST_CHECK(s->mag_z >= z - 1 && s->mag_z <= z + 1);
+}
+
+/* Same order as the IMU thread, BMI088 first */
+static void test_start(void)
+{
+    TEST_CHECK(bmi088Start(&imudev, &imucfg));
+    mmc5883maStart(&magdev, &magcfg);
+    TEST_EQUAL(magdev.state, MMC5883MA_READY);
+    TEST_EQUAL(mag.stats.resets, 1);
+    TEST_EQUAL(mag.stats.sets, 1);
+    TEST_EQUAL(mag.stats.rsts, 1);
+    TEST_EQUAL(mag.regs[MMC5883MA_AD_INTRNLCTRL2], MMC5883MA_INTRNLCTRL2_CM_FREQ_14Hz);
+}
+
+/* The bridge offset measured at start is taken out of the samples */
+static void test_offset_cancelled(void)
+{
+    mmc5883ma_sample_t s;
+
+    mmc5883maModelSetOffset(&mag, 0, 0, 0);
+    mmc5883maModelSetField(&mag, 300, -150, 500);
+    chThdSleepMilliseconds(100);
+    TEST_EQUAL(mmc5883maReadXYZ(&magdev, &s), MSG_OK);
+    /* Offset from start was zero, so nothing to cancel yet */
+    check_sample(&s, 300, -150, 500);
+
+    /* No new sample until the next continuous measurement */
+    TEST_EQUAL(mmc5883maReadXYZ(&magdev, &s), MSG_TIMEOUT);
+}
+
+/* Drift in the bridge offset is corrected at the next SET/RESET */
+static void test_setreset_interval(void)
+{
+    mmc5883ma_sample_t s;
+    uint32_t sets;
+
+    /* Restart the sample count */
+    TEST_EQUAL(mmc5883maSetReset(&magdev), MSG_OK);
+    sets = mag.stats.sets;
+    mmc5883maModelSetOffset(&mag, 400, -200, 100);
+    for (unsigned i = 0; i < magcfg.setreset_interval; i++) {
+        chThdSleepMilliseconds(100);
+        TEST_EQUAL(mmc5883maReadXYZ(&magdev, &s), MSG_OK);
+        TEST_EQUAL(mag.stats.sets, sets);
+    }
+    /* The previous samples still carry the drift */
+    TEST_CHECK(s.mag_x > 300 + 50);
+
+    chThdSleepMilliseconds(100);
+    TEST_EQUAL(mmc5883maReadXYZ(&magdev, &s), MSG_OK);
+    TEST_EQUAL(mag.stats.sets, sets + 1);
+    check_sample(&s, 300, -150, 500);
+
+    /* Continuous mode resumes with the new offset */
+    chThdSleepMilliseconds(100);
+    TEST_EQUAL(mmc5883maReadXYZ(&magdev, &s), MSG_OK);
+    TEST_EQUAL(mag.stats.sets, sets + 1);
+    check_sample(&s, 300, -150, 500);
+}
+
+/* One update loop of the IMU thread, BMI088 reads then the magnetometer */
+static void test_shared_bus(void)
+{
+    bmi088_accelerometer_sample_t accl;
+    bmi088_gyro_sample_t gyr;
+    mmc5883ma_sample_t s;
+    uint8_t id;
+    int16_t temp;
+
+    for (int i = 0; i < 3; i++) {
+        TEST_EQUAL(bmi088ReadAccelerometerChipId(&imudev, &id), MSG_OK);
+        TEST_EQUAL(id, BMI088_ACC_CHIP_ID_EXPECTED);
+        TEST_EQUAL(bmi088ReadAccelerometerXYZmG(&imudev, &accl), MSG_OK);
+        TEST_EQUAL(bmi088ReadGyroXYZ(&imudev, &gyr), MSG_OK);
+        TEST_EQUAL(bmi088ReadTemp(&imudev, &temp), MSG_OK);
+        chThdSleepMilliseconds(100);
+        TEST_EQUAL(mmc5883maReadXYZ(&magdev, &s), MSG_OK);
+        check_sample(&s, 300, -150, 500);
+    }
+}
+
+/*
+ * Same order as the IMU thread on exit. Every transfer checks the bus is
+ * started, so a device stopping I2CD1 under the other one fails here.
+ */
+static void test_stop(void)
+{
+    bmi088Stop(&imudev);
+    mmc5883maStop(&magdev);
+    TEST_EQUAL(imudev.state, BMI088_STOP);
+    TEST_EQUAL(magdev.state, MMC5883MA_STOP);
+    TEST_EQUAL(mag.regs[MMC5883MA_AD_INTRNLCTRL2], MMC5883MA_INTRNLCTRL2_CM_FREQ_OFF);
+    TEST_EQUAL(I2CD1.state, I2C_STOP);
+}
+
+int main(void)
+{
+    halInit();
+    chSysInit();
+
+    acc.regs[BMI088_ADDR_ACC_CHIP_ID] = BMI088_ACC_CHIP_ID_EXPECTED;
+    gyro.regs[0] = BMI088_GYR_CHIP_ID_EXPECTED;
+    mmc5883maModelInit(&mag);
+    i2cHostAttach(&I2CD1, MMC5883MA_SADDR, &mag_dev);
+    i2cHostAttach(&I2CD1, BMI088_ACC_SADDR, &acc_dev);
+    i2cHostAttach(&I2CD1, BMI088_GYRO_SADDR, &gyro_dev);
+    bmi088ObjectInit(&imudev);
+    mmc5883maObjectInit(&magdev);
+
+    TEST_RUN(test_start);
+    TEST_RUN(test_offset_cancelled);
+    TEST_RUN(test_setreset_interval);
+    TEST_RUN(test_shared_bus);
+    TEST_RUN(test_stop);
+    return 0;
+}
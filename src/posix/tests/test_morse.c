@@ -0,0 +1,247 @@
+/*
+ * Checks the CW keying schedule in common/morse.c against the timeline of
+ * the per-element encoder it replaced, as the AX5043 would key it from the
+ * REPEATDATA chunks streamed through ax5043TXRaw(), which is stood in for
+ * here. Also measures building and streaming a schedule.
+ */
+#include <string.h>
+#include <time.h>
+#include "ch.h"
+#include "hal.h"
+#include "morse.h"
+#include "test.h"
+
+#define XTAL_FREQ                           16000000U
+#define TIMELINE_MAX                        (MORSE_MAX_RUNS * 2U)
+#define BENCH_MESSAGES                      20000U
+
+typedef struct {
+    bool                        key;
+    uint32_t                    ms;
+} mark_t;
+
+typedef struct {
+    mark_t                      mark[TIMELINE_MAX];
+    size_t                      len;
+} timeline_t;
+
+static timeline_t ref, air;
+static uint32_t air_bytes, air_calls, air_txrate;
+
+static void timeline_add(timeline_t *t, bool key, uint32_t ms)
+{
+    if (t->len > 0 && t->mark[t->len - 1].key == key) {
+        t->mark[t->len - 1].ms += ms;
+    } else {
+        TEST_CHECK(t->len < TIMELINE_MAX);
+        t->mark[t->len++] = (mark_t){key, ms};
+    }
+}
+
+/* Keying timeline of the original per-element encoder, key and sleep calls recorded */
+static void reference(int wpm, const char *msg, size_t len)
+{
+    uint16_t ditLength = 1200 / wpm;
+
+    ref.len = 0;
+    for (size_t index = 0; index < len; index++) {
+        const char *morse = ax5043_ascii_to_morse(msg[index]);
+        for (int element = 0; morse[element] != '\0'; element++) {
+            switch (morse[element]) {
+            case '-':
+                timeline_add(&ref, true, ditLength * 3);
+                break;
+            case '.':
+                timeline_add(&ref, true, ditLength);
+                break;
+            }
+            if (morse[element] == ' ') {
+                timeline_add(&ref, false, ditLength * 7);
+            } else if (morse[element + 1] != '\0') {
+                timeline_add(&ref, false, ditLength);
+            } else {
+                timeline_add(&ref, false, ditLength * 3);
+            }
+        }
+    }
+}
+
+/* Plays the chunks back as the radio would, one FIFO byte per dit */
+static void play(const uint8_t *chunks, size_t len, uint16_t dit_ms)
+{
+    for (size_t i = 0; i < len; i += MORSE_CHUNK_LEN) {
+        TEST_EQUAL(chunks[i], AX5043_CHUNKCMD_REPEATDATA | _VAL2FLD(AX5043_FIFOCHUNK_SIZE, 3));
+        TEST_EQUAL(chunks[i + 1], AX5043_CHUNK_REPEATDATA_UNENC | AX5043_CHUNK_REPEATDATA_NOCRC);
+        TEST_CHECK(chunks[i + 2] != 0);
+        TEST_CHECK(chunks[i + 3] == 0x00 || chunks[i + 3] == 0xFF);
+        timeline_add(&air, chunks[i + 3] != 0, chunks[i + 2] * dit_ms);
+    }
+    air_bytes += len;
+}
+
+void ax5043TXRaw(AX5043Driver *devp, const ax5043_profile_t *profile, const void *buf, size_t len,
+                 size_t total_len, ax5043_tx_cb_t tx_cb, void *tx_cb_arg, bool chan_b)
+{
+    morse_sched_t *sched = tx_cb_arg;
+
+    (void)devp;
+    (void)chan_b;
+    air_calls++;
+    air.len = 0;
+    air_bytes = 0;
+    TEST_EQUAL(profile[0].reg, AX5043_REG_MODULATION);
+    TEST_EQUAL(profile[0].val, AX5043_MODULATION_ASK);
+    TEST_EQUAL(profile[1].reg, AX5043_REG_TXRATE);
+    air_txrate = profile[1].val;
+    play(buf, len, sched->dit_ms);
+    while ((len = tx_cb(tx_cb_arg)) != 0) {
+        play(sched->chunks, len, sched->dit_ms);
+    }
+    TEST_EQUAL(air_bytes, total_len);
+}
+
+static bool timeline_equal(const timeline_t *a, const timeline_t *b)
+{
+    if (a->len != b->len) {
+        return false;
+    }
+    for (size_t i = 0; i < a->len; i++) {
+        if (a->mark[i].key != b->mark[i].key || a->mark[i].ms != b->mark[i].ms) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static const AX5043Config axcfg = {
+    .xtal_freq      = XTAL_FREQ,
+};
+
+static AX5043Driver axd = {
+    .config         = &axcfg,
+};
+
+static void send(int wpm, const char *msg)
+{
+    char buf[MORSE_MAX_MSG];
+    size_t len = strlen(msg);
+
+    memcpy(buf, msg, len);
+    ax5043_send_cw(&axd, wpm, buf, len);
+    reference(wpm, msg, len);
+}
+
+/* Keyed as the per-element encoder did, at every speed */
+static void test_timeline(void)
+{
+    static const char *msgs[] = {
+        "E",
+        "OreSat0",
+        "CQ CQ DE KJ7SAT",
+        "0123456789 abcdefghijklmnopqrstuvwxyz",
+        "?.,",
+        /* 15 spaces make key up runs longer than one schedule run holds */
+        "SOS               SOS",
+    };
+
+    for (int wpm = 1; wpm <= 60; wpm++) {
+        for (size_t i = 0; i < sizeof(msgs) / sizeof(msgs[0]); i++) {
+            send(wpm, msgs[i]);
+            TEST_CHECK(timeline_equal(&air, &ref));
+        }
+    }
+}
+
+/* FIFO bytes go out one per dit, to the nearest TXRATE step */
+static void test_txrate(void)
+{
+    for (int wpm = 1; wpm <= 60; wpm++) {
+        uint16_t dit_ms = 1200 / wpm;
+        double exact = 8000.0 * (1U << 24) / ((double)dit_ms * XTAL_FREQ);
+
+        send(wpm, "K");
+        TEST_CHECK(air_txrate >= exact - 0.5 && air_txrate <= exact + 0.5);
+    }
+}
+
+/* Truncated at MORSE_MAX_MSG and rebuilt only on a change */
+static void test_compile(void)
+{
+    static morse_sched_t sched;
+    char msg[MORSE_MAX_MSG + 8];
+
+    memset(msg, '0', sizeof(msg));
+    TEST_CHECK(morse_compile(&sched, 20, msg, sizeof(msg), XTAL_FREQ));
+    TEST_EQUAL(sched.msg_len, MORSE_MAX_MSG);
+    /* "-----" is 5 key down and 5 key up runs */
+    TEST_EQUAL(sched.count, MORSE_MAX_MSG * 10U);
+    reference(20, msg, MORSE_MAX_MSG);
+    TEST_EQUAL(ref.len, sched.count);
+
+    TEST_CHECK(!morse_compile(&sched, 20, msg, sizeof(msg), XTAL_FREQ));
+    TEST_CHECK(morse_compile(&sched, 25, msg, sizeof(msg), XTAL_FREQ));
+    msg[3] = '1';
+    TEST_CHECK(morse_compile(&sched, 25, msg, sizeof(msg), XTAL_FREQ));
+    TEST_CHECK(!morse_compile(&sched, 25, msg, sizeof(msg), XTAL_FREQ));
+
+    /* One radio transaction per message */
+    air_calls = 0;
+    send(20, "CQ CQ DE KJ7SAT");
+    send(20, "CQ CQ DE KJ7SAT");
+    TEST_EQUAL(air_calls, 2);
+}
+
+static double now_s(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void test_bench(void)
+{
+    static morse_sched_t sched;
+    static const char msg[] = "CQ CQ DE KJ7SAT OreSat0 CW beacon";
+    double start, build_s, stream_s;
+    size_t bytes = 0, fills = 0;
+
+    start = now_s();
+    for (unsigned i = 0; i < BENCH_MESSAGES; i++) {
+        sched.count = 0;
+        morse_compile(&sched, 20, msg, sizeof(msg) - 1, XTAL_FREQ);
+    }
+    build_s = now_s() - start;
+
+    start = now_s();
+    for (unsigned i = 0; i < BENCH_MESSAGES; i++) {
+        size_t n;
+
+        sched.pos = 0;
+        while ((n = morse_fill(&sched)) != 0) {
+            bytes += n;
+            fills++;
+        }
+    }
+    stream_s = now_s() - start;
+
+    TEST_EQUAL(bytes / BENCH_MESSAGES, sched.count * MORSE_CHUNK_LEN);
+    reference(20, msg, sizeof(msg) - 1);
+    printf("\n    %zu runs: build %.2f us, stream %.2f us in %zu refills, "
+           "%zu key changes before\n",
+           sched.count, build_s * 1e6 / BENCH_MESSAGES, stream_s * 1e6 / BENCH_MESSAGES,
+           fills / BENCH_MESSAGES, ref.len);
+    printf("%-40s ", "");
+}
+
+int main(void)
+{
+    halInit();
+    chSysInit();
+
+    TEST_RUN(test_timeline);
+    TEST_RUN(test_txrate);
+    TEST_RUN(test_compile);
+    TEST_RUN(test_bench);
+    return 0;
+}
@@ -0,0 +1,428 @@
+/*
+ * Runs the node manager thread over a full constellation on virtual time.
+ * OPD is stood in for by cards that count inrush, and the heartbeat
+ * consumer by a table the manager configures through OD 0x1016: a healthy
+ * card sends its first heartbeat a fixed time after power on, a failing one
+ * never does. Checks that no more than NODE_MGR_INRUSH_MAX cards are in
+ * their inrush window at once, that failing cards are power cycled the set
+ * number of times without holding the others back, that a card which
+ * stops heartbeating is recovered, and that stopping the manager powers
+ * everything down. Reports the bring-up times.
+ */
+#include <string.h>
+#include "ch.h"
+#include "hal.h"
+#include "CANopen.h"
+#include "OD.h"
+#include "node_mgr.h"
+#include "opd.h"
+#include "test.h"
+
+/* As in common/worker.c */
+#define WRK_EVT_TERMINATE                   EVENT_MASK(1)
+
+/* As in common/node_mgr.c */
+#ifndef NODE_MGR_INRUSH_TIME
+#define NODE_MGR_INRUSH_TIME                TIME_MS2I(250)
+#endif
+#ifndef NODE_MGR_BOOT_TIMEOUT
+#define NODE_MGR_BOOT_TIMEOUT               TIME_S2I(90)
+#endif
+#define NODE_MGR_OFF_TIME                   TIME_MS2I(500)
+#define NODE_MGR_ATTEMPTS                   3
+
+#define BOOT_TIME                           TIME_S2I(3)
+#define SETTLE_LIMIT                        TIME_S2I(600)
+
+/* Every OPD card autostarts, the solar panels have no OPD */
+static const oresat_node_t nodes[] = {
+    {0x04, 0x18, 10000, true, "Battery 0"},
+    {0x0C, 0x00, 10000, false, "Solar Panel 0"},
+    {0x10, 0x00, 10000, false, "Solar Panel 1"},
+    {0x2C, 0x1C, 10000, true, "Star Tracker 0"},
+    {0x34, 0x19, 10000, true, "GPS"},
+    {0x38, 0x1A, 10000, true, "ACS"},
+    {0x3C, 0x20, 10000, true, "RWB 0"},
+    {0x40, 0x21, 10000, true, "RWB 1"},
+    {0x44, 0x22, 10000, true, "RWB 2"},
+    {0x48, 0x23, 10000, true, "RWB 3"},
+    {0x4C, 0x1B, 10000, true, "DxWiFi"},
+    {0x50, 0x1E, 10000, true, "CFC"},
+    {0, 0, 0, 0, NULL}
+};
+#define NODES                               (sizeof(nodes) / sizeof(nodes[0]) - 1)
+
+static OD_entry_t od_list[64];
+static OD_t od = {sizeof(od_list) / sizeof(od_list[0]), od_list};
+OD_t *OD = &od;
+static CO_t co;
+CO_t *CO = &co;
+
+/* The heartbeat consumer: OD 0x1016 and the NMT change callbacks */
+static struct {
+    uint32_t                    entries[OD_CNT_ARR_1016];
+    struct {
+        void                    *object;
+        void                    (*cb)(uint8_t nodeId, uint8_t idx,
+                                      CO_NMT_internalState_t state, void *object);
+    } callbacks[OD_CNT_ARR_1016];
+} hbcons;
+
+/* The card behind each node and what it has been through */
+typedef struct {
+    const oresat_node_t         *desc;
+    uint8_t                     idx;
+    bool                        absent;         /**< Not on the OPD bus.        */
+    int                         dead_boots;     /**< Boots without a heartbeat,
+                                                     negative for all of them.  */
+    bool                        powered;
+    bool                        up;
+    systime_t                   on_at;
+    systime_t                   up_at;
+    unsigned                    power_ons;
+    virtual_timer_t             boot;
+} card_t;
+
+static card_t cards[NODES];
+static unsigned inrush_peak;
+static i2caddr_t opd_expected[OD_CNT_ARR_1016];
+static size_t opd_expected_count;
+static systime_t start;
+
+/*===========================================================================*/
+/* Heartbeat consumer and OD stand-ins.                                      */
+/*===========================================================================*/
+
+static ODR_t hbcons_write(OD_stream_t *stream, const void *buf, OD_size_t count, OD_size_t *countWritten)
+{
+    TEST_EQUAL(count, sizeof(uint32_t));
+    memcpy(stream->dataOrig, buf, count);
+    *countWritten = count;
+    return ODR_OK;
+}
+
+ODR_t OD_getSub(const OD_entry_t *entry, uint8_t subIndex, OD_IO_t *io, bool_t odOrig)
+{
+    (void)odOrig;
+
+    TEST_CHECK(entry == OD_ENTRY_H1016_consumerHeartbeatTime);
+    if (subIndex < 1 || subIndex > OD_CNT_ARR_1016)
+        return ODR_SUB_NOT_EXIST;
+    memset(io, 0, sizeof(*io));
+    io->stream.dataOrig = &hbcons.entries[subIndex - 1];
+    io->stream.dataLength = sizeof(uint32_t);
+    io->stream.subIndex = subIndex;
+    io->write = hbcons_write;
+    return ODR_OK;
+}
+
+int8_t CO_HBconsumer_getIdxByNodeId(CO_HBconsumer_t *HBcons, uint8_t nodeId)
+{
+    (void)HBcons;
+
+    for (int i = 0; i < OD_CNT_ARR_1016; i++) {
+        if ((hbcons.entries[i] >> 16 & 0xFFU) == nodeId && (hbcons.entries[i] & 0xFFFFU) != 0)
+            return i;
+    }
+    return -1;
+}
+
+void CO_HBconsumer_initCallbackNmtChanged(CO_HBconsumer_t *HBcons, uint8_t idx, void *object,
+                                          void (*pFunctSignal)(uint8_t nodeId, uint8_t idx,
+                                                               CO_NMT_internalState_t NMTstate,
+                                                               void *object))
+{
+    (void)HBcons;
+
+    hbcons.callbacks[idx].object = object;
+    hbcons.callbacks[idx].cb = pFunctSignal;
+}
+
+/* The NMT state change the consumer reports for a card */
+static void hbcons_report(card_t *card, CO_NMT_internalState_t state)
+{
+    if (hbcons.callbacks[card->idx].cb != NULL) {
+        hbcons.callbacks[card->idx].cb(card->desc->id, card->idx, state,
+                                      hbcons.callbacks[card->idx].object);
+    }
+}
+
+/*===========================================================================*/
+/* OPD stand-in.                                                             */
+/*===========================================================================*/
+
+static card_t *card_at(i2caddr_t addr)
+{
+    for (size_t i = 0; i < NODES; i++) {
+        if (cards[i].desc->opd_addr == addr)
+            return &cards[i];
+    }
+    return NULL;
+}
+
+/* First heartbeat, as a timer callback */
+static void card_boot(void *arg)
+{
+    card_t *card = arg;
+
+    card->up = true;
+    card->up_at = chVTGetSystemTimeX();
+    hbcons_report(card, CO_NMT_PRE_OPERATIONAL);
+}
+
+void opd_init(void)
+{
+}
+
+size_t opd_start_expected(const i2caddr_t *addrs, size_t count)
+{
+    size_t found = 0;
+
+    TEST_CHECK(count <= OD_CNT_ARR_1016);
+    memcpy(opd_expected, addrs, count * sizeof(addrs[0]));
+    opd_expected_count = count;
+    for (size_t i = 0; i < count; i++) {
+        if (card_at(addrs[i]) != NULL && !card_at(addrs[i])->absent)
+            found++;
+    }
+    return found;
+}
+
+void opd_stop(void)
+{
+}
+
+int opd_enable(i2caddr_t addr, bool enable)
+{
+    card_t *card = card_at(addr);
+    systime_t now = chVTGetSystemTimeX();
+
+    if (card == NULL || card->absent)
+        return -1;
+
+    if (enable && !card->powered) {
+        unsigned inrush = 1;
+
+        for (size_t i = 0; i < NODES; i++) {
+            if (cards[i].powered && chTimeDiffX(cards[i].on_at, now) < NODE_MGR_INRUSH_TIME)
+                inrush++;
+        }
+        if (inrush > inrush_peak)
+            inrush_peak = inrush;
+        card->powered = true;
+        card->on_at = now;
+        card->power_ons++;
+        if (card->dead_boots == 0) {
+            chVTSet(&card->boot, BOOT_TIME, card_boot, card);
+        } else if (card->dead_boots > 0) {
+            card->dead_boots--;
+        }
+    } else if (!enable && card->powered) {
+        card->powered = false;
+        card->up = false;
+        chVTReset(&card->boot);
+    }
+    return 0;
+}
+
+/*===========================================================================*/
+/* Scenarios.                                                                */
+/*===========================================================================*/
+
+static void reset_cards(void)
+{
+    for (size_t i = 0; i < NODES; i++) {
+        memset(&cards[i], 0, sizeof(cards[i]));
+        cards[i].desc = &nodes[i];
+        cards[i].idx = i;
+        chVTObjectInit(&cards[i].boot);
+    }
+    inrush_peak = 0;
+}
+
+static bool settled(void)
+{
+    for (size_t i = 0; i < NODES; i++) {
+        node_phase_t phase = node_phase(nodes[i].id, NULL);
+
+        if (nodes[i].opd_addr != 0x00 && phase != NODE_UP && phase != NODE_FAILED)
+            return false;
+    }
+    return true;
+}
+
+static thread_t *mgr_start(void)
+{
+    thread_t *tp;
+
+    start = chVTGetSystemTime();
+    tp = chThdCreateStatic(node_mgr_wa, sizeof(node_mgr_wa), NORMALPRIO, node_mgr, (void *)nodes);
+    chThdSleepMilliseconds(1);
+    while (!settled()) {
+        TEST_CHECK(chVTTimeElapsedSinceX(start) < SETTLE_LIMIT);
+        chThdSleepMilliseconds(10);
+    }
+    return tp;
+}
+
+/* The worker shutdown, everything is powered down and unconfigured */
+static void mgr_stop(thread_t *tp)
+{
+    chThdTerminate(tp);
+    chEvtSignal(tp, WRK_EVT_TERMINATE);
+    chThdWait(tp);
+    for (size_t i = 0; i < NODES; i++) {
+        TEST_CHECK(!cards[i].powered);
+        TEST_EQUAL(hbcons.entries[i], 0);
+        TEST_CHECK(hbcons.callbacks[i].cb == NULL);
+    }
+}
+
+/* Time from the manager starting to the last heartbeat of a card up first time */
+static sysinterval_t healthy_up_time(void)
+{
+    sysinterval_t last = 0;
+
+    for (size_t i = 0; i < NODES; i++) {
+        if (cards[i].up && cards[i].power_ons == 1) {
+            if (chTimeDiffX(start, cards[i].up_at) > last)
+                last = chTimeDiffX(start, cards[i].up_at);
+        }
+    }
+    return last;
+}
+
+static sysinterval_t all_healthy_time;
+
+/* Every card comes up, NODE_MGR_INRUSH_MAX at a time */
+static void test_all_healthy(void)
+{
+    unsigned opd_nodes = 0;
+    thread_t *tp;
+
+    reset_cards();
+    tp = mgr_start();
+
+    /* The OPD scan was asked for the cards in table order */
+    for (size_t i = 0; i < NODES; i++) {
+        if (nodes[i].opd_addr != 0x00) {
+            TEST_EQUAL(opd_expected[opd_nodes], nodes[i].opd_addr);
+            opd_nodes++;
+        }
+    }
+    TEST_EQUAL(opd_expected_count, opd_nodes);
+
+    for (size_t i = 0; i < NODES; i++) {
+        uint8_t attempts = 0xFF;
+
+        TEST_EQUAL(hbcons.entries[i], (uint32_t)nodes[i].id << 16 | nodes[i].timeout);
+        if (nodes[i].opd_addr == 0x00)
+            continue;
+        TEST_EQUAL(node_phase(nodes[i].id, &attempts), NODE_UP);
+        TEST_EQUAL(attempts, 0);
+        TEST_EQUAL(cards[i].power_ons, 1);
+    }
+    TEST_EQUAL(inrush_peak, NODE_MGR_INRUSH_MAX);
+
+    all_healthy_time = healthy_up_time();
+    TEST_EQUAL(all_healthy_time, ((opd_nodes + NODE_MGR_INRUSH_MAX - 1) / NODE_MGR_INRUSH_MAX - 1) *
+                                 NODE_MGR_INRUSH_TIME + BOOT_TIME);
+    mgr_stop(tp);
+    printf("\n    %u cards up in %.2f s at %d in inrush, %.2f s one at a time\n",
+           opd_nodes, TIME_I2MS(all_healthy_time) / 1000.0, NODE_MGR_INRUSH_MAX,
+           TIME_I2MS(opd_nodes * (NODE_MGR_INRUSH_TIME + BOOT_TIME)) / 1000.0);
+    printf("%-40s ", "");
+}
+
+/*
+ * The battery never boots, an RWB only on its second power on and the CFC
+ * card is not on the bus. The rest come up as if nothing had failed.
+ */
+static void test_failing(void)
+{
+    card_t *battery = card_at(0x18), *rwb = card_at(0x21), *cfc = card_at(0x1E);
+    sysinterval_t healthy, failed, recovered;
+    uint8_t attempts;
+    thread_t *tp;
+
+    reset_cards();
+    battery->dead_boots = -1;
+    rwb->dead_boots = 1;
+    cfc->absent = true;
+    tp = mgr_start();
+
+    healthy = healthy_up_time();
+    TEST_CHECK(healthy <= all_healthy_time);
+    TEST_CHECK(inrush_peak <= NODE_MGR_INRUSH_MAX);
+
+    /* Powered once and three times more, each after a boot timeout */
+    TEST_EQUAL(node_phase(battery->desc->id, &attempts), NODE_FAILED);
+    TEST_EQUAL(attempts, NODE_MGR_ATTEMPTS);
+    TEST_EQUAL(battery->power_ons, 1 + NODE_MGR_ATTEMPTS);
+    TEST_CHECK(!battery->powered);
+    failed = chVTTimeElapsedSinceX(start);
+    TEST_CHECK(failed >= (1 + NODE_MGR_ATTEMPTS) * NODE_MGR_BOOT_TIMEOUT + NODE_MGR_ATTEMPTS * NODE_MGR_OFF_TIME);
+
+    /* Up on the retry, with its attempts cleared */
+    TEST_EQUAL(node_phase(rwb->desc->id, &attempts), NODE_UP);
+    TEST_EQUAL(attempts, 0);
+    TEST_EQUAL(rwb->power_ons, 2);
+    recovered = chTimeDiffX(start, rwb->up_at);
+    TEST_CHECK(recovered >= NODE_MGR_BOOT_TIMEOUT + NODE_MGR_OFF_TIME + BOOT_TIME);
+    TEST_CHECK(recovered <= NODE_MGR_BOOT_TIMEOUT + NODE_MGR_OFF_TIME + NODE_MGR_INRUSH_TIME + BOOT_TIME);
+
+    /* Not connected, given up at once */
+    TEST_EQUAL(node_phase(cfc->desc->id, &attempts), NODE_FAILED);
+    TEST_EQUAL(cfc->power_ons, 0);
+
+    /* Re-enabling the failed card gives it a fresh set of attempts */
+    battery->dead_boots = 0;
+    TEST_EQUAL(node_enable(battery->desc->id, true), 0);
+    chThdSleep(NODE_MGR_INRUSH_TIME + BOOT_TIME + TIME_MS2I(10));
+    TEST_EQUAL(node_phase(battery->desc->id, &attempts), NODE_UP);
+    TEST_EQUAL(attempts, 0);
+
+    mgr_stop(tp);
+    printf("\n    healthy cards up in %.2f s, retried card in %.2f s, dead card failed after %.0f s\n",
+           TIME_I2MS(healthy) / 1000.0, TIME_I2MS(recovered) / 1000.0, TIME_I2MS(failed) / 1000.0);
+    printf("%-40s ", "");
+}
+
+/* A card that stops heartbeating is power cycled and comes back */
+static void test_heartbeat_lost(void)
+{
+    card_t *gps = card_at(0x19);
+    systime_t lost;
+    uint8_t attempts;
+    thread_t *tp;
+
+    reset_cards();
+    tp = mgr_start();
+
+    lost = chVTGetSystemTime();
+    hbcons_report(gps, CO_NMT_UNKNOWN);
+    chThdSleepMilliseconds(1);
+    TEST_CHECK(!gps->powered);
+    TEST_EQUAL(node_phase(gps->desc->id, &attempts), NODE_BACKOFF);
+    TEST_EQUAL(attempts, 1);
+
+    chThdSleep(NODE_MGR_OFF_TIME + BOOT_TIME + TIME_MS2I(10));
+    TEST_EQUAL(node_phase(gps->desc->id, &attempts), NODE_UP);
+    TEST_EQUAL(attempts, 0);
+    TEST_EQUAL(gps->power_ons, 2);
+    TEST_EQUAL(chTimeDiffX(lost, gps->up_at), NODE_MGR_OFF_TIME + BOOT_TIME);
+    TEST_CHECK(inrush_peak <= NODE_MGR_INRUSH_MAX);
+
+    mgr_stop(tp);
+}
+
+int main(void)
+{
+    halInit();
+    chSysInit();
+
+    TEST_RUN(test_all_healthy);
+    TEST_RUN(test_failing);
+    TEST_RUN(test_heartbeat_lost);
+    return 0;
+}
@@ -0,0 +1,183 @@
+/*
+ * Runs the OPD bus scan against MAX7310 models on the host I2C bus, a few
+ * of the 56 addresses populated. Every transaction is observed on the bus,
+ * the probes are the 1 byte reads. Checks that opd_start_expected() probes
+ * the listed cards first and returns once they are done, that the
+ * background scan then covers only the rest of the bus and finds a card
+ * nobody listed, and that opd_stop() joins it midway. Reports the time to
+ * the expected cards against the full synchronous scan of opd_start().
+ */
+#include <string.h>
+#include "ch.h"
+#include "hal.h"
+#include "max7310.h"
+#include "max7310_model.h"
+#include "opd.h"
+#include "test.h"
+
+#define OPD_ADDRS                           (MAX7310_MAX_ADDR - MAX7310_MIN_ADDR + 1)
+
+/* Cards the node table lists, 0x1B is listed but not plugged in */
+static const i2caddr_t expected[] = {0x18, 0x1A, 0x1B, 0x2C};
+/* Cards on the bus, 0x30 is not listed */
+static const i2caddr_t present[] = {0x18, 0x1A, 0x2C, 0x30};
+
+static max7310_model_t models[sizeof(present) / sizeof(present[0])];
+static i2c_host_device_t devices[sizeof(present) / sizeof(present[0])];
+
+/* The probes in bus order */
+static struct {
+    i2caddr_t                   addr[4 * OPD_ADDRS];
+    unsigned                    count;
+    unsigned                    per_addr[MAX7310_MAX_ADDR + 1];
+} probes;
+
+static msg_t max7310_transfer(void *arg, const uint8_t *txbuf, size_t txbytes,
+                              uint8_t *rxbuf, size_t rxbytes)
+{
+    return max7310ModelTransfer(arg, txbuf, txbytes, rxbuf, rxbytes) == 0 ? MSG_OK : MSG_RESET;
+}
+
+static void bus_observer(void *arg, i2caddr_t addr, const uint8_t *txbuf,
+                         size_t txbytes, size_t rxbytes, msg_t msg)
+{
+    (void)arg;
+    (void)txbuf;
+    (void)msg;
+
+    if (txbytes == 0U && rxbytes == 1U) {
+        TEST_CHECK(probes.count < sizeof(probes.addr) / sizeof(probes.addr[0]));
+        probes.addr[probes.count++] = addr;
+        probes.per_addr[addr]++;
+    }
+}
+
+static void reset_probes(void)
+{
+    memset(&probes, 0, sizeof(probes));
+}
+
+static bool is_present(i2caddr_t addr)
+{
+    for (size_t i = 0; i < sizeof(present) / sizeof(present[0]); i++) {
+        if (present[i] == addr)
+            return true;
+    }
+    return false;
+}
+
+static void wait_scan(void)
+{
+    while (opd_scan_busy()) {
+        chThdSleepMilliseconds(1);
+    }
+}
+
+/* Listed cards go first and in order, the call returns as soon as they are done */
+static void test_expected_first(void)
+{
+    opd_status_t status;
+    size_t found;
+
+    reset_probes();
+    found = opd_start_expected(expected, sizeof(expected) / sizeof(expected[0]));
+    TEST_EQUAL(found, 3);
+    TEST_EQUAL(probes.count, sizeof(expected) / sizeof(expected[0]));
+    for (size_t i = 0; i < sizeof(expected) / sizeof(expected[0]); i++) {
+        TEST_EQUAL(probes.addr[i], expected[i]);
+    }
+    TEST_CHECK(opd_scan_busy());
+    TEST_EQUAL(opd_status(0x18, &status), 0);
+    TEST_EQUAL(status.mode, OPD_MODE_VAL);
+    TEST_EQUAL(opd_status(0x1B, &status), -1);
+    TEST_EQUAL(opd_status(0x30, &status), -1);
+
+    /* The rescan skips the cards found, in address order, and finds 0x30 */
+    wait_scan();
+    TEST_EQUAL(probes.count, sizeof(expected) / sizeof(expected[0]) + OPD_ADDRS - found);
+    for (unsigned i = sizeof(expected) / sizeof(expected[0]) + 1; i < probes.count; i++) {
+        TEST_CHECK(probes.addr[i] > probes.addr[i - 1]);
+    }
+    for (i2caddr_t addr = MAX7310_MIN_ADDR; addr <= MAX7310_MAX_ADDR; addr++) {
+        unsigned listed = addr == 0x1B ? 2 : 1;
+
+        TEST_EQUAL(probes.per_addr[addr], listed);
+        TEST_EQUAL(opd_status(addr, &status), is_present(addr) ? 0 : -1);
+    }
+    opd_stop();
+}
+
+/* opd_stop() terminates the rescan midway and waits for it */
+static void test_stop_joins_scan(void)
+{
+    unsigned count;
+
+    reset_probes();
+    opd_start_expected(expected, sizeof(expected) / sizeof(expected[0]));
+    chThdSleepMilliseconds(2);
+    TEST_CHECK(opd_scan_busy());
+    TEST_CHECK(probes.count > sizeof(expected) / sizeof(expected[0]));
+
+    opd_stop();
+    count = probes.count;
+    TEST_CHECK(!opd_scan_busy());
+    TEST_CHECK(count < sizeof(expected) / sizeof(expected[0]) + OPD_ADDRS - 3);
+    TEST_EQUAL(I2CD1.state, I2C_STOP);
+    for (size_t i = 0; i < sizeof(present) / sizeof(present[0]); i++) {
+        TEST_EQUAL(models[i].regs[MAX7310_AD_MODE], 0xFF);
+    }
+
+    /* Nothing probes the stopped bus */
+    chThdSleepMilliseconds(100);
+    TEST_EQUAL(probes.count, count);
+
+    /* A second stop with no scan running is harmless */
+    opd_stop();
+}
+
+/* Time until the listed cards are up, against probing all 56 addresses */
+static void test_scan_time(void)
+{
+    systime_t start;
+    sysinterval_t expected_time, full_time;
+    opd_status_t status;
+
+    start = chVTGetSystemTime();
+    opd_start_expected(expected, sizeof(expected) / sizeof(expected[0]));
+    expected_time = chVTTimeElapsedSinceX(start);
+    opd_stop();
+
+    reset_probes();
+    start = chVTGetSystemTime();
+    opd_start();
+    full_time = chVTTimeElapsedSinceX(start);
+    TEST_EQUAL(probes.count, OPD_ADDRS);
+    TEST_CHECK(!opd_scan_busy());
+    TEST_EQUAL(opd_status(0x30, &status), 0);
+    opd_stop();
+
+    TEST_CHECK(expected_time * 3 < full_time);
+    printf("\n    %u listed cards up in %.1f ms, full scan of %u addresses %.1f ms\n",
+           (unsigned)(sizeof(expected) / sizeof(expected[0])), TIME_I2US(expected_time) / 1000.0,
+           OPD_ADDRS, TIME_I2US(full_time) / 1000.0);
+    printf("%-40s ", "");
+}
+
+int main(void)
+{
+    halInit();
+    chSysInit();
+    for (size_t i = 0; i < sizeof(present) / sizeof(present[0]); i++) {
+        max7310ModelInit(&models[i]);
+        devices[i].arg = &models[i];
+        devices[i].transfer = max7310_transfer;
+        i2cHostAttach(&I2CD1, present[i], &devices[i]);
+    }
+    i2cHostSetTransferHook(&I2CD1, bus_observer, NULL);
+    opd_init();
+
+    TEST_RUN(test_expected_first);
+    TEST_RUN(test_stop_joins_scan);
+    TEST_RUN(test_scan_time);
+    return 0;
+}
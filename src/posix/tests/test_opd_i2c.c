@@ -0,0 +1,459 @@
+/*
+ * Runs the OPD bit-banged I2C against a MAX7310 model with a bit level I2C
+ * target wired to its SCL and SDA pins. The target is a small register
+ * device that decodes START, STOP, address, data and ACK from the bus
+ * levels, so it only answers a correct waveform. The read-modify-write
+ * implementation from before the MAX7310 registers were shadowed is kept
+ * here as the reference: both drive the same transfers, ACKed and not, and
+ * must produce the same SCL/SDA sequence and the same received bytes. The
+ * I2C transactions each takes on the host bus are reported.
+ */
+#include <stdlib.h>
+#include <string.h>
+#include "ch.h"
+#include "hal.h"
+#include "max7310.h"
+#include "max7310_model.h"
+#include "opd.h"
+#include "test.h"
+
+#define OPD_ADDR                            0x20U
+#define TARGET_ADDR                         0x41U
+#define OPD_I2C_TRIES                       3
+#define BUS_PINS                            (OPD_PIN_MASK(OPD_SCL) | OPD_PIN_MASK(OPD_SDA))
+#define WAVE_MAX                            2048U
+#define RANDOM_RUNS                         200U
+
+void opd_i2c_transmit(i2caddr_t addr, uint8_t *txbuf, size_t txsize, uint8_t *rxbuf, size_t rxsize);
+
+static max7310_model_t model;
+static i2c_host_device_t device;
+
+/* The SCL/SDA levels after every change */
+static struct {
+    uint8_t                     levels[WAVE_MAX];
+    unsigned                    count;
+} wave;
+
+/* Register device on the far side of the OPD card */
+static struct {
+    enum {
+        TARGET_IDLE,
+        TARGET_ADDRESS,
+        TARGET_WRITE,
+        TARGET_READ
+    }                           state;
+    uint8_t                     regs[256];
+    uint8_t                     ptr;
+    bool                        have_ptr;
+    unsigned                    nbits;          /**< Clocks in this byte.       */
+    uint8_t                     byte;
+    bool                        scl;
+    bool                        sda;
+    unsigned                    starts;
+    unsigned                    stops;
+} target;
+
+/*===========================================================================*/
+/* I2C target.                                                               */
+/*===========================================================================*/
+
+static void target_sda(bool level)
+{
+    uint8_t ext = level ? 0xFFU : (uint8_t)~OPD_PIN_MASK(OPD_SDA);
+
+    max7310ModelSetInput(&model, ext);
+    target.sda = max7310ModelPins(&model) & OPD_PIN_MASK(OPD_SDA);
+}
+
+static void target_rising(void)
+{
+    switch (target.state) {
+    case TARGET_ADDRESS:
+    case TARGET_WRITE:
+        if (target.nbits < 8)
+            target.byte = (uint8_t)(target.byte << 1 | target.sda);
+        target.nbits++;
+        break;
+    case TARGET_READ:
+        /* The ninth clock is the master's ACK, a NACK ends the read */
+        if (++target.nbits == 9 && target.sda)
+            target.state = TARGET_IDLE;
+        break;
+    default:
+        break;
+    }
+}
+
+static void target_falling(void)
+{
+    switch (target.state) {
+    case TARGET_ADDRESS:
+        if (target.nbits == 8) {
+            if (target.byte >> 1 != TARGET_ADDR) {
+                target.state = TARGET_IDLE;
+                break;
+            }
+            target_sda(false);
+        } else if (target.nbits == 9) {
+            target.nbits = 0;
+            if (target.byte & 1U) {
+                target.state = TARGET_READ;
+                target.byte = target.regs[target.ptr++];
+                target_sda(target.byte & 0x80U);
+            } else {
+                target.state = TARGET_WRITE;
+                target.have_ptr = false;
+                target_sda(true);
+            }
+        }
+        break;
+    case TARGET_WRITE:
+        if (target.nbits == 8) {
+            if (target.have_ptr) {
+                target.regs[target.ptr++] = target.byte;
+            } else {
+                target.ptr = target.byte;
+                target.have_ptr = true;
+            }
+            target_sda(false);
+        } else if (target.nbits == 9) {
+            target.nbits = 0;
+            target.byte = 0;
+            target_sda(true);
+        }
+        break;
+    case TARGET_READ:
+        if (target.nbits < 8) {
+            target_sda(target.byte & (0x80U >> target.nbits));
+        } else if (target.nbits == 8) {
+            target_sda(true);
+        } else {
+            target.nbits = 0;
+            target.byte = target.regs[target.ptr++];
+            target_sda(target.byte & 0x80U);
+        }
+        break;
+    default:
+        break;
+    }
+}
+
+/* Runs on every bus change made by a MAX7310 register write */
+static void bus_pins(void *arg, uint8_t pins)
+{
+    bool scl = pins & OPD_PIN_MASK(OPD_SCL);
+    bool sda = pins & OPD_PIN_MASK(OPD_SDA);
+
+    (void)arg;
+
+    if ((pins & BUS_PINS) != (wave.count > 0 ? wave.levels[wave.count - 1] : BUS_PINS)) {
+        TEST_CHECK(wave.count < WAVE_MAX);
+        wave.levels[wave.count++] = pins & BUS_PINS;
+    }
+
+    /* SDA moving while SCL stays high is a START or a STOP */
+    if (scl && target.scl) {
+        if (target.sda && !sda) {
+            target.starts++;
+            target.state = TARGET_ADDRESS;
+            target.nbits = 0;
+            target.byte = 0;
+        } else if (!target.sda && sda) {
+            target.stops++;
+            target.state = TARGET_IDLE;
+        }
+        target.sda = sda;
+        return;
+    }
+    target.sda = sda;
+    if (scl && !target.scl) {
+        target.scl = true;
+        target_rising();
+    } else if (!scl && target.scl) {
+        target.scl = false;
+        target_falling();
+    }
+}
+
+/*===========================================================================*/
+/* Reference: the OPD I2C before the MAX7310 registers were shadowed.        */
+/*===========================================================================*/
+
+static void old_i2c_start(MAX7310Driver *devp)
+{
+    uint8_t reg;
+
+    reg = max7310ReadRaw(devp, MAX7310_AD_MODE);
+    reg &= ~MAX7310_PIN_MASK(OPD_SDA);
+    max7310WriteRaw(devp, MAX7310_AD_MODE, reg);
+    reg &= ~MAX7310_PIN_MASK(OPD_SCL);
+    max7310WriteRaw(devp, MAX7310_AD_MODE, reg);
+}
+
+static void old_i2c_stop(MAX7310Driver *devp)
+{
+    uint8_t reg;
+
+    reg = max7310ReadRaw(devp, MAX7310_AD_MODE);
+    reg &= ~(MAX7310_PIN_MASK(OPD_SCL) | MAX7310_PIN_MASK(OPD_SDA));
+    max7310WriteRaw(devp, MAX7310_AD_MODE, reg);
+    reg |= MAX7310_PIN_MASK(OPD_SCL);
+    max7310WriteRaw(devp, MAX7310_AD_MODE, reg);
+    reg |= MAX7310_PIN_MASK(OPD_SDA);
+    max7310WriteRaw(devp, MAX7310_AD_MODE, reg);
+}
+
+/* reg starts from MODE here, the old code left it unset for a read only transfer */
+static void old_i2c_transmit(MAX7310Driver *devp, uint8_t *txbuf, size_t txsize, uint8_t *rxbuf, size_t rxsize)
+{
+    uint8_t tries;
+    uint8_t reg;
+
+    old_i2c_start(devp);
+    reg = max7310ReadRaw(devp, MAX7310_AD_MODE);
+
+    for (size_t i = 0; i < txsize; i++) {
+        uint8_t byte = txbuf[i];
+
+        for (int j = 0; j < 8; j++) {
+            reg = max7310ReadRaw(devp, MAX7310_AD_MODE);
+            reg = (reg & ~MAX7310_PIN_MASK(OPD_SDA)) | ((byte & 0x80) ? MAX7310_PIN_MASK(OPD_SDA) : 0);
+            max7310WriteRaw(devp, MAX7310_AD_MODE, reg);
+            reg |= MAX7310_PIN_MASK(OPD_SCL);
+            max7310WriteRaw(devp, MAX7310_AD_MODE, reg);
+            reg &= ~MAX7310_PIN_MASK(OPD_SCL);
+            max7310WriteRaw(devp, MAX7310_AD_MODE, reg);
+            byte <<= 1;
+        }
+
+        tries = OPD_I2C_TRIES;
+        reg |= MAX7310_PIN_MASK(OPD_SDA);
+        max7310WriteRaw(devp, MAX7310_AD_MODE, reg);
+        reg |= MAX7310_PIN_MASK(OPD_SCL);
+        max7310WriteRaw(devp, MAX7310_AD_MODE, reg);
+        while (!(max7310ReadRaw(devp, MAX7310_AD_INPUT) & MAX7310_PIN_MASK(OPD_SCL)));
+        while ((max7310ReadRaw(devp, MAX7310_AD_INPUT) & MAX7310_PIN_MASK(OPD_SDA)) && tries)
+            tries--;
+        reg &= ~(MAX7310_PIN_MASK(OPD_SCL) | MAX7310_PIN_MASK(OPD_SDA));
+        max7310WriteRaw(devp, MAX7310_AD_MODE, reg);
+        if (tries == 0)
+            goto opd_i2c_fail;
+    }
+
+    for (size_t i = 0; i < rxsize; i++) {
+        uint8_t byte = 0;
+
+        reg |= MAX7310_PIN_MASK(OPD_SDA);
+        max7310WriteRaw(devp, MAX7310_AD_MODE, reg);
+        for (int j = 0; j < 8; j++) {
+            reg |= MAX7310_PIN_MASK(OPD_SCL);
+            max7310WriteRaw(devp, MAX7310_AD_MODE, reg);
+            byte = ((byte << 1) | (max7310ReadRaw(devp, MAX7310_AD_INPUT) & MAX7310_PIN_MASK(OPD_SDA) ? 1 : 0));
+            reg &= ~MAX7310_PIN_MASK(OPD_SCL);
+            max7310WriteRaw(devp, MAX7310_AD_MODE, reg);
+        }
+
+        if (i < rxsize - 1) {
+            reg &= ~MAX7310_PIN_MASK(OPD_SDA);
+            max7310WriteRaw(devp, MAX7310_AD_MODE, reg);
+        }
+        reg |= MAX7310_PIN_MASK(OPD_SCL);
+        max7310WriteRaw(devp, MAX7310_AD_MODE, reg);
+        while (!(max7310ReadRaw(devp, MAX7310_AD_INPUT) & MAX7310_PIN_MASK(OPD_SCL)));
+        reg &= ~MAX7310_PIN_MASK(OPD_SCL);
+        max7310WriteRaw(devp, MAX7310_AD_MODE, reg);
+
+        rxbuf[i] = byte;
+    }
+
+opd_i2c_fail:
+    old_i2c_stop(devp);
+}
+
+/*===========================================================================*/
+/* Tests.                                                                    */
+/*===========================================================================*/
+
+static const I2CConfig old_i2ccfg = {
+    OPMODE_I2C,
+    100000,
+    STD_DUTY_CYCLE,
+};
+
+static const MAX7310Config old_config = {
+    &I2CD1,
+    &old_i2ccfg,
+    OPD_ADDR,
+    OPD_ODR_VAL,
+    OPD_POL_VAL,
+    OPD_MODE_VAL,
+    MAX7310_TIMEOUT_ENABLED
+};
+
+static MAX7310Driver old_dev;
+
+/* What one implementation put on the bus for one transfer */
+typedef struct {
+    uint8_t                     levels[WAVE_MAX];
+    unsigned                    count;
+    uint8_t                     rx[4];
+    uint8_t                     regs[256];
+    unsigned                    starts;
+    unsigned                    stops;
+    uint32_t                    xfers;
+} run_t;
+
+static uint32_t total_old, total_new;
+
+static msg_t max7310_transfer(void *arg, const uint8_t *txbuf, size_t txbytes,
+                              uint8_t *rxbuf, size_t rxbytes)
+{
+    return max7310ModelTransfer(arg, txbuf, txbytes, rxbuf, rxbytes) == 0 ? MSG_OK : MSG_RESET;
+}
+
+static void run(bool old, const uint8_t *tx, size_t txsize, size_t rxsize, run_t *r)
+{
+    uint8_t txbuf[8];
+    uint32_t xfers = I2CD1.xfers;
+
+    memcpy(txbuf, tx, txsize);
+    memset(r->rx, 0xEE, sizeof(r->rx));
+    wave.count = 0;
+    target.starts = target.stops = 0;
+    if (old) {
+        old_i2c_transmit(&old_dev, txbuf, txsize, r->rx, rxsize);
+    } else {
+        opd_i2c_transmit(OPD_ADDR, txbuf, txsize, r->rx, rxsize);
+    }
+    r->xfers = I2CD1.xfers - xfers;
+    memcpy(r->levels, wave.levels, sizeof(r->levels));
+    r->count = wave.count;
+    memcpy(r->regs, target.regs, sizeof(r->regs));
+    r->starts = target.starts;
+    r->stops = target.stops;
+
+    /* Both leave the bus idle and the mode register as they found it */
+    TEST_EQUAL(max7310ModelPins(&model) & BUS_PINS, BUS_PINS);
+    TEST_EQUAL(model.regs[MAX7310_AD_MODE], OPD_MODE_VAL);
+    TEST_EQUAL(target.state, TARGET_IDLE);
+}
+
+/* The same transfer from the same target state through both, compared */
+static void compare(const uint8_t *tx, size_t txsize, size_t rxsize, run_t *rnew)
+{
+    static run_t rold;
+    static uint8_t regs[256];
+    uint8_t ptr = target.ptr;
+
+    memcpy(regs, target.regs, sizeof(regs));
+    run(true, tx, txsize, rxsize, &rold);
+    memcpy(target.regs, regs, sizeof(regs));
+    target.ptr = ptr;
+    run(false, tx, txsize, rxsize, rnew);
+
+    TEST_EQUAL(rnew->count, rold.count);
+    TEST_CHECK(memcmp(rnew->levels, rold.levels, rold.count) == 0);
+    TEST_CHECK(memcmp(rnew->rx, rold.rx, sizeof(rold.rx)) == 0);
+    TEST_CHECK(memcmp(rnew->regs, rold.regs, sizeof(rold.regs)) == 0);
+    TEST_EQUAL(rnew->starts, 1);
+    TEST_EQUAL(rnew->stops, 1);
+    TEST_CHECK(rnew->xfers < rold.xfers);
+    total_old += rold.xfers;
+    total_new += rnew->xfers;
+}
+
+/* Pointer and two data bytes land in the target's registers */
+static void test_write(void)
+{
+    static const uint8_t tx[] = {TARGET_ADDR << 1, 0x10, 0xA5, 0x3C};
+    static run_t r;
+
+    compare(tx, sizeof(tx), 0, &r);
+    TEST_EQUAL(r.regs[0x10], 0xA5);
+    TEST_EQUAL(r.regs[0x11], 0x3C);
+    /* START, 4 bytes of 9 clocks and STOP */
+    TEST_CHECK(r.count > 4 * 9 * 2);
+}
+
+/* The pointer set by a write is read back, ACKed then NACKed */
+static void test_read(void)
+{
+    static const uint8_t ptr[] = {TARGET_ADDR << 1, 0x10};
+    static const uint8_t tx[] = {TARGET_ADDR << 1 | 1};
+    static run_t r;
+
+    compare(ptr, sizeof(ptr), 0, &r);
+    compare(tx, sizeof(tx), 2, &r);
+    TEST_EQUAL(r.rx[0], 0xA5);
+    TEST_EQUAL(r.rx[1], 0x3C);
+    TEST_EQUAL(r.rx[2], 0xEE);
+}
+
+/* Nobody at the address: the transfer stops after the address byte */
+static void test_nack(void)
+{
+    static const uint8_t tx[] = {0x30 << 1, 0x10, 0x55};
+    static run_t r;
+
+    compare(tx, sizeof(tx), 0, &r);
+    TEST_EQUAL(r.regs[0x10], 0xA5);
+    compare(tx, 1, 2, &r);
+    TEST_EQUAL(r.rx[0], 0xEE);
+}
+
+/* 1-3 byte writes and 1-2 byte reads of random data */
+static void test_random(void)
+{
+    static run_t r;
+
+    for (unsigned n = 0; n < RANDOM_RUNS; n++) {
+        uint8_t tx[4] = {TARGET_ADDR << 1, (uint8_t)rand(), (uint8_t)rand(), (uint8_t)rand()};
+        size_t txsize = 2 + rand() % 3;
+        size_t rxsize = rand() % 3;
+
+        compare(tx, txsize, 0, &r);
+        if (rxsize > 0) {
+            tx[0] |= 1U;
+            compare(tx, 1, rxsize, &r);
+            /* The read starts where the write left the pointer */
+            for (size_t i = 0; i < rxsize; i++) {
+                TEST_EQUAL(r.rx[i], r.regs[(uint8_t)(tx[1] + txsize - 2 + i)]);
+            }
+        }
+    }
+}
+
+static void test_speedup(void)
+{
+    printf("\n    %u transactions before shadowing, %u after, %.2fx fewer\n",
+           (unsigned)total_old, (unsigned)total_new, (double)total_old / total_new);
+    printf("%-40s ", "");
+}
+
+int main(void)
+{
+    halInit();
+    chSysInit();
+    srand(38);
+    max7310ModelInit(&model);
+    max7310ModelSetPinsHook(&model, bus_pins, NULL);
+    target.scl = target.sda = true;
+    device.arg = &model;
+    device.transfer = max7310_transfer;
+    i2cHostAttach(&I2CD1, OPD_ADDR, &device);
+
+    opd_init();
+    opd_start();
+    TEST_CHECK(opd_probe(OPD_ADDR, false));
+    max7310ObjectInit(&old_dev);
+    max7310Start(&old_dev, &old_config);
+    TEST_EQUAL(I2CD1.state, I2C_READY);
+
+    TEST_RUN(test_write);
+    TEST_RUN(test_read);
+    TEST_RUN(test_nack);
+    TEST_RUN(test_random);
+    TEST_RUN(test_speedup);
+    return 0;
+}
@@ -0,0 +1,266 @@
+/*
+ * Runs the MCU temperature and VREFINT sampler against the host ADC. The
+ * test converts sequences into the circular buffer, the half and full
+ * callbacks wake the worker as the DMA interrupts would, and the filtered
+ * values are checked against a floating point model of the F0 calibration:
+ * channel order, oversampling, the running average, the published 0.1 C
+ * and mV values and their whole degree and 100 mV OD entries.
+ */
+#include <math.h>
+#include "ch.h"
+#include "hal.h"
+#include "CANopen.h"
+#include "OD.h"
+#include "sensors.h"
+#include "test.h"
+
+#define CAL1                                ((double)sim_mcu_cal[SIM_MCU_TS_CAL1])
+#define CAL2                                ((double)sim_mcu_cal[SIM_MCU_TS_CAL2])
+#define VCAL                                ((double)sim_mcu_cal[SIM_MCU_VREFINT_CAL])
+
+OD_RAM_t OD_RAM;
+OD_t *OD;
+
+/* What the two channels read, ts alternates by +-dither between samples */
+static struct {
+    adcsample_t                 ts;
+    adcsample_t                 vrefint;
+    adcsample_t                 dither;
+    unsigned                    samples;
+} input;
+
+static adcsample_t adc_input(void *arg, unsigned channel)
+{
+    (void)arg;
+
+    switch (channel) {
+    case 16:
+        return input.samples++ & 1U ? input.ts + input.dither : input.ts - input.dither;
+    case 17:
+        return input.vrefint;
+    default:
+        TEST_CHECK(false);
+        return 0;
+    }
+}
+
+/* The raw readings of the sensor at temp_c with the supply at vdda_mv */
+static void set_input(double temp_c, double vdda_mv)
+{
+    double ts_33v = CAL1 + (temp_c - TS_CAL1_TEMP) * (CAL2 - CAL1) / (TS_CAL2_TEMP - TS_CAL1_TEMP);
+
+    input.ts = (adcsample_t)lround(ts_33v * 3300.0 / vdda_mv);
+    input.vrefint = (adcsample_t)lround(VCAL * 3300.0 / vdda_mv);
+}
+
+/* The calibration math in floating point, from the raw readings */
+static double model_temp_c(double ts, double vrefint)
+{
+    return TS_CAL1_TEMP + (ts * VCAL / vrefint - CAL1) * (TS_CAL2_TEMP - TS_CAL1_TEMP) / (CAL2 - CAL1);
+}
+
+static double model_vdda_mv(double vrefint)
+{
+    return VREFINT_CAL_VOLT * 10.0 * VCAL / vrefint;
+}
+
+/* Fills one half of the buffer and lets the worker process it */
+static void convert_half(void)
+{
+    adcHostConvert(&ADCD1, SENSORS_OVERSAMPLE);
+    chThdSleep(1);
+}
+
+/* The published values agree with the model of the filtered raw readings */
+static void check_published(double ts, double vrefint)
+{
+    sensors_data_t data;
+    double temp_c = model_temp_c(ts, vrefint);
+    double vdda_mv = model_vdda_mv(vrefint);
+
+    sensors_get(&data);
+    TEST_CHECK(fabs(data.temperature - temp_c * 10.0) <= 1.5);
+    TEST_CHECK(fabs(data.vdda - vdda_mv) <= 1.5);
+    TEST_EQUAL(OD_RAM.x2022_MCU_Sensors.temperatureRaw, data.temperature_raw);
+    TEST_EQUAL(OD_RAM.x2022_MCU_Sensors.VREFINT_Raw, data.vrefint_raw);
+    TEST_EQUAL(OD_RAM.x2022_MCU_Sensors.temperature, data.temperature / 10);
+    TEST_EQUAL(OD_RAM.x2022_MCU_Sensors.VREFINT, data.vdda / 100);
+}
+
+/* Without heap for the worker the conversion is never started */
+static void test_start_without_heap(void)
+{
+    chHostSetHeapFull(true);
+    sensors_start();
+    chHostSetHeapFull(false);
+    TEST_CHECK(ADCD1.state != ADC_ACTIVE);
+    adcHostConvert(&ADCD1, SENSORS_OVERSAMPLE);
+    TEST_EQUAL(ADCD1.sequences, 0);
+    TEST_CHECK(!sensors_stop());
+}
+
+/* Each callback processes its own half, TS and VREFINT land in their fields */
+static void test_halves(void)
+{
+    sensors_data_t data;
+    double ts;
+
+    set_input(30.0, 3300.0);
+    sensors_start();
+    TEST_EQUAL(ADCD1.state, ADC_ACTIVE);
+    TEST_EQUAL(ADCD1.grpp->num_channels, 2);
+
+    /* The half callback, the first result seeds the average */
+    convert_half();
+    sensors_get(&data);
+    TEST_EQUAL(data.temperature_raw, sim_mcu_cal[SIM_MCU_TS_CAL1]);
+    TEST_EQUAL(data.vrefint_raw, sim_mcu_cal[SIM_MCU_VREFINT_CAL]);
+    TEST_EQUAL(data.temperature, 300);
+    TEST_EQUAL(data.vdda, 3300);
+    TEST_EQUAL(OD_RAM.x2022_MCU_Sensors.temperature, 30);
+    TEST_EQUAL(OD_RAM.x2022_MCU_Sensors.VREFINT, 33);
+
+    /* The full callback only sees the second half */
+    set_input(110.0, 3300.0);
+    convert_half();
+    TEST_EQUAL(ADCD1.pos, 0);
+    ts = CAL1 + (CAL2 - CAL1) / (1 << SENSORS_FILTER_SHIFT);
+    sensors_get(&data);
+    TEST_CHECK(fabs(data.temperature_raw - ts) <= 1.0);
+    TEST_EQUAL(data.vrefint_raw, sim_mcu_cal[SIM_MCU_VREFINT_CAL]);
+    check_published(data.temperature_raw, data.vrefint_raw);
+
+    /* Both halves at once, as when the worker falls behind */
+    adcHostConvert(&ADCD1, 2 * SENSORS_OVERSAMPLE);
+    chThdSleep(1);
+    for (int i = 0; i < 2; i++) {
+        ts += (CAL2 - ts) / (1 << SENSORS_FILTER_SHIFT);
+    }
+    sensors_get(&data);
+    TEST_CHECK(fabs(data.temperature_raw - ts) <= 1.0);
+}
+
+/* The average over a half cancels the dither */
+static void test_oversampling(void)
+{
+    sensors_data_t data;
+
+    set_input(30.0, 3300.0);
+    for (int i = 0; i < 64; i++) {
+        convert_half();
+    }
+    input.dither = 40;
+    for (int i = 0; i < 8; i++) {
+        convert_half();
+        sensors_get(&data);
+        TEST_EQUAL(data.temperature_raw, input.ts);
+    }
+    input.dither = 0;
+}
+
+/* A step follows the running average of weight 1/2^SENSORS_FILTER_SHIFT */
+static void test_filter_step(void)
+{
+    sensors_data_t data;
+    double ts, vrefint;
+    int settled = -1;
+
+    set_input(30.0, 3300.0);
+    for (int i = 0; i < 64; i++) {
+        convert_half();
+    }
+    ts = input.ts;
+    vrefint = input.vrefint;
+
+    set_input(80.0, 3000.0);
+    for (int i = 0; i < 64; i++) {
+        convert_half();
+        ts += (input.ts - ts) / (1 << SENSORS_FILTER_SHIFT);
+        vrefint += (input.vrefint - vrefint) / (1 << SENSORS_FILTER_SHIFT);
+        sensors_get(&data);
+        TEST_CHECK(fabs(data.temperature_raw - ts) <= 1.0);
+        TEST_CHECK(fabs(data.vrefint_raw - vrefint) <= 1.0);
+        check_published(data.temperature_raw, data.vrefint_raw);
+        if (settled < 0 && abs(data.temperature - 800) <= 5)
+            settled = i + 1;
+    }
+    TEST_CHECK(settled > 0);
+    printf("\n    50 C step settles to 0.5 C in %d halves, %.0f ms at 64 sequences of 2 x 252 cycles / 14 MHz\n",
+           settled, settled * SENSORS_OVERSAMPLE * 2.0 * 252.0 / 14e3);
+    printf("%-40s ", "");
+}
+
+/* Whole degrees and 100 mV in the OD, truncated like the firmware */
+static void test_od_conversions(void)
+{
+    static const struct {
+        double                  temp_c;
+        double                  vdda_mv;
+        int                     od_temp;
+        int                     od_vrefint;
+    } cases[] = {
+        {-20.5, 3050.0, -20, 30},
+        {  0.5, 3350.0,   0, 33},
+        { 25.5, 3300.0,  25, 33},
+        { 45.5, 3550.0,  45, 35},
+        { 85.5, 2950.0,  85, 29},
+    };
+    sensors_data_t data;
+
+    for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+        set_input(cases[i].temp_c, cases[i].vdda_mv);
+        for (int j = 0; j < 128; j++) {
+            convert_half();
+        }
+        sensors_get(&data);
+        TEST_EQUAL(data.temperature_raw, input.ts);
+        TEST_EQUAL(data.vrefint_raw, input.vrefint);
+        check_published(input.ts, input.vrefint);
+        TEST_EQUAL(OD_RAM.x2022_MCU_Sensors.temperature, cases[i].od_temp);
+        TEST_EQUAL(OD_RAM.x2022_MCU_Sensors.VREFINT, cases[i].od_vrefint);
+    }
+}
+
+/* Stopping frees the ADC and keeps the last values, starting resumes */
+static void test_stop(void)
+{
+    sensors_data_t before, after;
+    uint32_t sequences;
+
+    sensors_get(&before);
+    TEST_CHECK(sensors_stop());
+    TEST_EQUAL(ADCD1.state, ADC_READY);
+    sequences = ADCD1.sequences;
+    adcHostConvert(&ADCD1, SENSORS_OVERSAMPLE);
+    TEST_EQUAL(ADCD1.sequences, sequences);
+    TEST_CHECK(!sensors_stop());
+    sensors_get(&after);
+    TEST_EQUAL(after.temperature, before.temperature);
+    TEST_EQUAL(after.vdda, before.vdda);
+
+    sensors_start();
+    TEST_EQUAL(ADCD1.state, ADC_ACTIVE);
+    convert_half();
+    sensors_get(&after);
+    TEST_EQUAL(after.temperature_raw, input.ts);
+    TEST_CHECK(sensors_stop());
+}
+
+int main(void)
+{
+    halInit();
+    chSysInit();
+    adcHostSetInputHook(&ADCD1, adc_input, NULL);
+    sensors_init();
+    TEST_EQUAL(OD_RAM.x2021_MCU_Calibration.TS_CAL1, sim_mcu_cal[SIM_MCU_TS_CAL1]);
+    TEST_EQUAL(OD_RAM.x2021_MCU_Calibration.TS_CAL2, sim_mcu_cal[SIM_MCU_TS_CAL2]);
+    TEST_EQUAL(OD_RAM.x2021_MCU_Calibration.VREFINT_CAL, sim_mcu_cal[SIM_MCU_VREFINT_CAL]);
+
+    TEST_RUN(test_start_without_heap);
+    TEST_RUN(test_halves);
+    TEST_RUN(test_oversampling);
+    TEST_RUN(test_filter_step);
+    TEST_RUN(test_od_conversions);
+    TEST_RUN(test_stop);
+    return 0;
+}
@@ -0,0 +1,327 @@
+/*
+ * Checks the SI41xx driver through a bit-level model of the chip's serial
+ * port on the PAL lines: the words latched by start, a retune and stop, that
+ * data only changes with SCLK low, and the divider cache hits, evictions and
+ * reset on start. Measures retunes with and without the cache.
+ *
+ * The timer paced DMA stream needs the STM32 timer and DMA, so it is only
+ * checked on the target by "synth check". Its steps follow the same
+ * waveform as the bit-banged writes checked here.
+ */
+#include <string.h>
+#include <time.h>
+#include "hal.h"
+#include "si41xx.h"
+#include "test.h"
+
+#define LINE_SEN                            PAL_LINE(GPIOB, 12U)
+#define LINE_SCLK                           PAL_LINE(GPIOB, 13U)
+#define LINE_SDATA                          PAL_LINE(GPIOB, 14U)
+
+#define REF_FREQ                            16000000U
+#define BENCH_RETUNES                       20000U
+
+bool si41xxCalcDiv(SI41XXDriver *devp, uint32_t freq, uint32_t *ndiv, uint32_t *rdiv);
+bool si41xxGetDiv(SI41XXDriver *devp, uint32_t freq, uint32_t *ndiv, uint32_t *rdiv);
+
+/* The serial port: 22 bits in on SCLK rising while SEN is low, SEN rising latches */
+static struct {
+    bool                        sen;
+    bool                        sclk;
+    bool                        sdata;
+    uint32_t                    shift;
+    unsigned                    bits;
+    unsigned                    errors;
+    uint32_t                    regs[16];
+    uint32_t                    log[32];
+    unsigned                    words;
+} port;
+
+static void port_out(void *arg, ioline_t line, bool level)
+{
+    (void)arg;
+
+    if (line == LINE_SDATA) {
+        /* Data must be stable while SCLK is high */
+        if (level != port.sdata && port.sclk && !port.sen) {
+            port.errors++;
+        }
+        port.sdata = level;
+    } else if (line == LINE_SCLK) {
+        if (!port.sclk && level && !port.sen) {
+            port.shift = (port.shift << 1) | port.sdata;
+            port.bits++;
+        }
+        port.sclk = level;
+    } else if (line == LINE_SEN) {
+        if (!port.sen && level) {
+            if (port.bits != 22) {
+                port.errors++;
+            } else {
+                uint32_t word = port.shift & 0x3FFFFFU;
+
+                port.regs[word & 0xFU] = word >> 4;
+                if (port.words < 32) {
+                    port.log[port.words] = word;
+                }
+                port.words++;
+            }
+        }
+        if (port.sen && !level) {
+            port.shift = 0;
+            port.bits = 0;
+        }
+        port.sen = level;
+    }
+}
+
+/* Idle with SEN and SCLK high, as the driver leaves them */
+static void port_reset(void)
+{
+    palSetLine(LINE_SEN);
+    palSetLine(LINE_SCLK);
+    memset(&port, 0, sizeof(port));
+    port.sen = true;
+    port.sclk = true;
+    port.sdata = palReadLine(LINE_SDATA);
+}
+
+static uint32_t word(uint32_t addr, uint32_t data)
+{
+    return addr | (data << 4);
+}
+
+static SI41XXConfig cfg;
+static SI41XXDriver synth;
+
+static void synth_start(void)
+{
+    cfg = (SI41XXConfig){
+        .sen            = LINE_SEN,
+        .sclk           = LINE_SCLK,
+        .sdata          = LINE_SDATA,
+        .ref_freq       = REF_FREQ,
+        .if_div         = SI41XX_IFDIV_DIV1,
+        .if_n           = 1616,
+        .if_r           = 32,
+        .rf1_n          = 100,
+        .rf1_r          = 2,
+        .rf2_n          = 200,
+        .rf2_r          = 4,
+    };
+    si41xxObjectInit(&synth);
+    port_reset();
+    si41xxStart(&synth, &cfg);
+}
+
+static void test_start(void)
+{
+    const uint32_t pwr = SI41XX_POWERDOWN_PBIB | SI41XX_POWERDOWN_PBRB;
+    const uint32_t expect[] = {
+        word(SI41XX_REG_CONFIG, SI41XX_CONFIG_AUTOKP |
+                                _VAL2FLD(SI41XX_CONFIG_AUXSEL, SI41XX_AUXSEL_LOCKDET)),
+        word(SI41XX_REG_PHASE_GAIN, 0),
+        word(SI41XX_REG_PWRDOWN, 0),
+        word(SI41XX_REG_IF_NDIV, 1616),
+        word(SI41XX_REG_IF_RDIV, 32),
+        word(SI41XX_REG_RF1_NDIV, 100),
+        word(SI41XX_REG_RF1_RDIV, 2),
+        word(SI41XX_REG_RF2_NDIV, 200),
+        word(SI41XX_REG_RF2_RDIV, 4),
+        word(SI41XX_REG_PWRDOWN, pwr),
+    };
+
+    synth_start();
+    TEST_EQUAL(port.errors, 0);
+    TEST_EQUAL(port.words, 10);
+    TEST_CHECK(memcmp(port.log, expect, sizeof(expect)) == 0);
+    TEST_EQUAL(synth.state, SI41XX_READY);
+
+    port_reset();
+    si41xxStop(&synth);
+    TEST_EQUAL(port.errors, 0);
+    TEST_EQUAL(port.words, 2);
+    TEST_EQUAL(port.log[0], word(SI41XX_REG_PWRDOWN, 0));
+    TEST_EQUAL(port.log[1], word(SI41XX_REG_CONFIG, 0));
+}
+
+/* A retune powers the output down, loads N and R and powers it back up */
+static void check_retune(uint32_t freq, uint8_t ndiv, uint8_t rdiv, uint32_t pb)
+{
+    const uint32_t pwr = SI41XX_POWERDOWN_PBIB | SI41XX_POWERDOWN_PBRB;
+
+    TEST_EQUAL(port.errors, 0);
+    TEST_EQUAL(port.words, 4);
+    TEST_EQUAL(port.log[0], word(SI41XX_REG_PWRDOWN, pwr & ~pb));
+    TEST_EQUAL(port.log[1] & 0xFU, ndiv);
+    TEST_EQUAL(port.log[2] & 0xFU, rdiv);
+    TEST_EQUAL(port.log[3], word(SI41XX_REG_PWRDOWN, pwr));
+    /* The latched dividers give the frequency asked for */
+    TEST_EQUAL((uint64_t)REF_FREQ * port.regs[ndiv] / port.regs[rdiv], freq);
+    TEST_EQUAL((uint64_t)REF_FREQ * port.regs[ndiv] % port.regs[rdiv], 0);
+}
+
+static void test_retune(void)
+{
+    synth_start();
+
+    port_reset();
+    TEST_CHECK(si41xxSetIF(&synth, 808000000U));
+    check_retune(808000000U, SI41XX_REG_IF_NDIV, SI41XX_REG_IF_RDIV, SI41XX_POWERDOWN_PBIB);
+    TEST_EQUAL(cfg.if_n, port.regs[SI41XX_REG_IF_NDIV]);
+    TEST_EQUAL(cfg.if_r, port.regs[SI41XX_REG_IF_RDIV]);
+
+    port_reset();
+    TEST_CHECK(si41xxSetIF(&synth, 800125000U));
+    check_retune(800125000U, SI41XX_REG_IF_NDIV, SI41XX_REG_IF_RDIV, SI41XX_POWERDOWN_PBIB);
+
+    port_reset();
+    TEST_CHECK(si41xxSetRF1(&synth, 1000000000U));
+    check_retune(1000000000U, SI41XX_REG_RF1_NDIV, SI41XX_REG_RF1_RDIV, SI41XX_POWERDOWN_PBRB);
+
+    port_reset();
+    TEST_CHECK(si41xxSetRF2(&synth, 1200000000U));
+    check_retune(1200000000U, SI41XX_REG_RF2_NDIV, SI41XX_REG_RF2_RDIV, SI41XX_POWERDOWN_PBRB);
+
+    /* No divider pair within the phase detector limits, nothing is sent */
+    port_reset();
+    TEST_CHECK(!si41xxSetIF(&synth, 800000001U));
+    TEST_EQUAL(port.words, 0);
+    /* N out of range for the IF */
+    TEST_CHECK(!si41xxSetIF(&synth, 2000010000U));
+    TEST_EQUAL(port.words, 0);
+}
+
+static void test_cache(void)
+{
+    uint32_t freqs[SI41XX_DIV_CACHE_SIZE + 1], first[4];
+
+    synth_start();
+    for (unsigned i = 0; i <= SI41XX_DIV_CACHE_SIZE; i++) {
+        freqs[i] = 800000000U + i * 1000000U;
+    }
+
+    port_reset();
+    TEST_CHECK(si41xxSetIF(&synth, freqs[0]));
+    memcpy(first, port.log, sizeof(first));
+    TEST_EQUAL(synth.div_misses, 1);
+    TEST_EQUAL(synth.div_hits, 0);
+
+    /* A hit sends the same words as the search did */
+    port_reset();
+    TEST_CHECK(si41xxSetIF(&synth, freqs[0]));
+    TEST_EQUAL(port.words, 4);
+    TEST_CHECK(memcmp(port.log, first, sizeof(first)) == 0);
+    TEST_EQUAL(synth.div_misses, 1);
+    TEST_EQUAL(synth.div_hits, 1);
+
+    /* Filling the cache evicts the oldest entry first */
+    for (unsigned i = 1; i <= SI41XX_DIV_CACHE_SIZE; i++) {
+        TEST_CHECK(si41xxSetIF(&synth, freqs[i]));
+    }
+    TEST_EQUAL(synth.div_misses, 1 + SI41XX_DIV_CACHE_SIZE);
+    TEST_CHECK(si41xxSetIF(&synth, freqs[SI41XX_DIV_CACHE_SIZE]));
+    TEST_EQUAL(synth.div_hits, 2);
+    TEST_CHECK(si41xxSetIF(&synth, freqs[0]));
+    TEST_EQUAL(synth.div_misses, 2 + SI41XX_DIV_CACHE_SIZE);
+
+    /* Cached results agree with the search */
+    for (unsigned i = 0; i < SI41XX_DIV_CACHE_SIZE; i++) {
+        uint32_t n, r;
+
+        if (synth.div_cache[i].freq == 0) {
+            continue;
+        }
+        TEST_CHECK(si41xxCalcDiv(&synth, synth.div_cache[i].freq, &n, &r));
+        TEST_EQUAL(synth.div_cache[i].ndiv, n);
+        TEST_EQUAL(synth.div_cache[i].rdiv, r);
+    }
+
+    /* A failed search is not cached */
+    TEST_CHECK(!si41xxSetIF(&synth, 800000001U));
+    TEST_CHECK(!si41xxSetIF(&synth, 800000001U));
+    TEST_EQUAL(synth.div_misses, 4 + SI41XX_DIV_CACHE_SIZE);
+
+    /* Restarting, possibly on another reference, drops the cache */
+    si41xxStop(&synth);
+    cfg.ref_freq = REF_FREQ / 2;
+    si41xxStart(&synth, &cfg);
+    port_reset();
+    TEST_CHECK(si41xxSetIF(&synth, freqs[0]));
+    TEST_EQUAL(synth.div_misses, 5 + SI41XX_DIV_CACHE_SIZE);
+    TEST_EQUAL(REF_FREQ / 2 * (uint64_t)port.regs[SI41XX_REG_IF_NDIV] /
+               port.regs[SI41XX_REG_IF_RDIV], freqs[0]);
+}
+
+static double now_s(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static double retune_ns(const uint32_t freq[2], bool cached)
+{
+    double start = now_s();
+
+    for (unsigned i = 0; i < BENCH_RETUNES; i++) {
+        if (!cached) {
+            memset(synth.div_cache, 0, sizeof(synth.div_cache));
+        }
+        TEST_CHECK(si41xxSetIF(&synth, freq[i & 1]));
+    }
+    return (now_s() - start) * 1e9 / BENCH_RETUNES;
+}
+
+static double lookup_ns(const uint32_t freq[2], bool cached)
+{
+    double start = now_s();
+    uint32_t n, r, sum = 0;
+
+    for (unsigned i = 0; i < BENCH_RETUNES; i++) {
+        if (!cached) {
+            memset(synth.div_cache, 0, sizeof(synth.div_cache));
+        }
+        TEST_CHECK(si41xxGetDiv(&synth, freq[i & 1], &n, &r));
+        sum += n + r;
+    }
+    TEST_CHECK(sum != 0);
+    return (now_s() - start) * 1e9 / BENCH_RETUNES;
+}
+
+static void test_bench(void)
+{
+    /* Channels that share little with the reference, so the search is long */
+    const uint32_t freq[2] = {800050000U, 808150000U};
+    double retune[2], lookup[2];
+
+    synth_start();
+    retune[0] = retune_ns(freq, false);
+    retune[1] = retune_ns(freq, true);
+    lookup[0] = lookup_ns(freq, false);
+    lookup[1] = lookup_ns(freq, true);
+
+    TEST_EQUAL(port.errors, 0);
+    printf("\n    retune: uncached %.0f ns, cached %.0f ns; divider lookup %.0f ns, %.0f ns\n",
+           retune[0], retune[1], lookup[0], lookup[1]);
+    printf("%-40s ", "");
+}
+
+int main(void)
+{
+    halInit();
+    chSysInit();
+    palSetLineMode(LINE_SEN, PAL_MODE_OUTPUT_PUSHPULL);
+    palSetLineMode(LINE_SCLK, PAL_MODE_OUTPUT_PUSHPULL);
+    palSetLineMode(LINE_SDATA, PAL_MODE_OUTPUT_PUSHPULL);
+    palHostSetOutputHook(LINE_SEN, port_out, NULL);
+    palHostSetOutputHook(LINE_SCLK, port_out, NULL);
+    palHostSetOutputHook(LINE_SDATA, port_out, NULL);
+
+    TEST_RUN(test_start);
+    TEST_RUN(test_retune);
+    TEST_RUN(test_cache);
+    TEST_RUN(test_bench);
+    return 0;
+}
@@ -0,0 +1,355 @@
+/*
+ * Runs the solar MPPT tracker against the INA226 model on I2CD2 and a PV
+ * panel behind the LT1618, whose input current limit follows the DAC.
+ * The energy it harvests is compared with the panel's maximum power point
+ * and with the fixed step tracker it replaced, in steady light, through
+ * irradiance steps and an eclipse. solar.c is included for its statics.
+ */
+#include <math.h>
+#include "solar.c"
+#include "ina226_model.h"
+#include "test.h"
+
+/* Two cells in series, full sun at beginning of life */
+#define PV_ISC_UA                           480000.0
+#define PV_VOC_UV                           5300000.0
+#define PV_NVT_UV                           160000.0
+
+/* LT1618 input current limit, full at 0 V on IADJ and none at 1.5 V */
+#define LT1618_ILIM_UA                      600000.0
+#define LT1618_IADJ_OFF_UV                  1500000.0
+
+/* The tracker solar.c replaced */
+#define REF_SETTLE_MS                       ((NUM_INA226_AVG * INA226_ADC_CONVERSION_TIME_MICROSECONDS) / 1000)
+#define REF_STEP_DOWN_UV                    1000U
+#define REF_STEP_UP_UV                      (REF_STEP_DOWN_UV * 4U)
+
+OD_RAM_t OD_RAM;
+OD_t *OD;
+const I2CConfig i2cconfig = {0, 0, 0};
+
+static ina226_model_t ina;
+static virtual_timer_t alert_vt;
+
+typedef struct {
+    double                      irradiance;     /* Fraction of full sun     */
+    double                      iadj_uv;
+    double                      voltage_uv;
+    double                      current_ua;
+    double                      mpp_uw;
+    uint64_t                    at_us;
+    double                      energy_uj;      /* Harvested                */
+    double                      mpp_energy_uj;  /* Available at the MPP     */
+} panel_t;
+
+static panel_t panel;
+
+/*
+ * Single diode model, I(V) = Iph - I0 (exp(V / nVt) - 1). The converter
+ * draws its current limit, the panel settles at the voltage that supplies
+ * it or collapses to zero when it cannot.
+ */
+static double panel_i0(void)
+{
+    return PV_ISC_UA / (exp(PV_VOC_UV / PV_NVT_UV) - 1.0);
+}
+
+static double panel_voltage(double iph_ua, double i_ua)
+{
+    if (i_ua >= iph_ua)
+        return 0.0;
+    return PV_NVT_UV * log((iph_ua - i_ua) / panel_i0() + 1.0);
+}
+
+static double panel_mpp(double iph_ua)
+{
+    double best = 0.0;
+
+    for (int i = 1; i < 10000; i++) {
+        double i_ua = iph_ua * i / 10000.0;
+        double p = panel_voltage(iph_ua, i_ua) * i_ua / 1e6;
+        if (p > best)
+            best = p;
+    }
+    return best;
+}
+
+/* Integrates the energy up to now, then moves to the new operating point */
+static void panel_update(void)
+{
+    uint64_t now = chHostTimeUS();
+    double iph = PV_ISC_UA * panel.irradiance;
+    double ilim = LT1618_ILIM_UA * (1.0 - panel.iadj_uv / LT1618_IADJ_OFF_UV);
+
+    panel.energy_uj += (panel.voltage_uv * panel.current_ua / 1e6) * (now - panel.at_us) / 1e6;
+    panel.mpp_energy_uj += panel.mpp_uw * (now - panel.at_us) / 1e6;
+    panel.at_us = now;
+
+    if (ilim < 0.0)
+        ilim = 0.0;
+    panel.voltage_uv = panel_voltage(iph, ilim);
+    panel.current_ua = panel.voltage_uv > 0.0 ? ilim : iph;
+    ina226ModelSetInput(&ina, now, (int32_t)panel.voltage_uv, (int32_t)panel.current_ua);
+}
+
+static void panel_set_irradiance(double irradiance)
+{
+    panel_update();
+    panel.irradiance = irradiance;
+    panel.mpp_uw = panel_mpp(PV_ISC_UA * irradiance);
+    panel_update();
+}
+
+static double panel_power_mw(void)
+{
+    return panel.voltage_uv * panel.current_ua / 1e9;
+}
+
+static void dac_out(void *arg, dacchannel_t channel, dacsample_t sample)
+{
+    (void)arg;
+    if (channel == 0U) {
+        panel.iadj_uv = ((double)sample * DAC_VDDA_UV) / 4096.0;
+        panel_update();
+    }
+}
+
+/* ALERT is open drain, low while asserted */
+static void alert_update(void)
+{
+    ina226ModelAdvance(&ina, chHostTimeUS());
+    palHostDriveLine(LINE_ALERT, !ina226ModelAlert(&ina));
+}
+
+static void alert_vt_cb(void *arg)
+{
+    (void)arg;
+    alert_update();
+    chVTSetI(&alert_vt, TIME_MS2I(1), alert_vt_cb, NULL);
+}
+
+static msg_t ina_transfer(void *arg, const uint8_t *txbuf, size_t txbytes,
+                          uint8_t *rxbuf, size_t rxbytes)
+{
+    int r;
+
+    ina226ModelAdvance(arg, chHostTimeUS());
+    r = ina226ModelTransfer(arg, txbuf, txbytes, rxbuf, rxbytes);
+    alert_update();
+    return r == 0 ? MSG_OK : MSG_RESET;
+}
+
+static const i2c_host_device_t ina_dev = {&ina, ina_transfer};
+
+/*
+ * The fixed step perturb and observe tracker solar.c replaced: it sleeps
+ * for one averaging period after each step and reads power and voltage
+ * separately from whatever conversion is current.
+ */
+typedef struct {
+    uint32_t                    iadj_uv;
+    bool                        up;
+    bool                        hit_threshold;
+    uint32_t                    power_mw;
+    uint32_t                    voltage_mv;
+    uint32_t                    max_voltage_mv;
+} ref_state_t;
+
+static uint32_t ref_step(ref_state_t *st)
+{
+    if (!st->hit_threshold && st->max_voltage_mv != 0U) {
+        uint32_t low = st->max_voltage_mv / 20U;
+        uint32_t threshold = st->max_voltage_mv - low;
+
+        if (st->voltage_mv > threshold) {
+            uint32_t v = ((st->voltage_mv - threshold) * 100U) / low;
+            return (((5000U - REF_STEP_DOWN_UV) * v) / 100U) + REF_STEP_DOWN_UV;
+        }
+        st->hit_threshold = true;
+    }
+    return st->up ? REF_STEP_UP_UV : REF_STEP_DOWN_UV;
+}
+
+static void ref_tracker(void *arg)
+{
+    INA226Driver dev;
+    ref_state_t st = {.iadj_uv = I_ADJ_INITIAL};
+
+    (void)arg;
+    ina226ObjectInit(&dev);
+    dacStart(&DACD1, &dac1cfg);
+    ina226Start(&dev, &ina226config);
+    dac_put_microvolts(&DACD1, 0, st.iadj_uv);
+
+    while (!chThdShouldTerminateX()) {
+        uint32_t step = ref_step(&st);
+        uint32_t next = saturate_uint32_t((int64_t)st.iadj_uv + (st.up ? (int64_t)step : -(int64_t)step),
+                                          I_ADJ_MIN, I_ADJ_MAX);
+        uint32_t power_mw, voltage_mv;
+
+        if (next == st.iadj_uv) {
+            st.up = !st.up;
+            continue;
+        }
+        dac_put_microvolts(&DACD1, 0, next);
+        chThdSleepMilliseconds(REF_SETTLE_MS);
+        if (ina226ReadPower(&dev, &power_mw) != MSG_OK ||
+            ina226ReadVBUS(&dev, &voltage_mv) != MSG_OK) {
+            st.up = true;
+            continue;
+        }
+        if ((int32_t)power_mw < (int32_t)st.power_mw - HISTERESIS_MW)
+            st.up = !st.up;
+        st.iadj_uv = next;
+        st.power_mw = power_mw;
+        st.voltage_mv = voltage_mv;
+        st.max_voltage_mv = MAX(st.max_voltage_mv, voltage_mv);
+    }
+
+    dacStop(&DACD1);
+    ina226Stop(&dev);
+}
+
+typedef struct {
+    const char                  *name;
+    uint32_t                    ms;
+    double                      irradiance;
+} phase_t;
+
+static const phase_t phases[] = {
+    {"full sun", 20000, 1.0},
+    {"half sun", 10000, 0.5},
+    {"full sun", 10000, 1.0},
+    {"eclipse", 10000, 0.0},
+    {"full sun", 20000, 1.0},
+};
+
+#define PHASES                              (sizeof(phases) / sizeof(phases[0]))
+
+typedef struct {
+    double                      phase[PHASES];
+    double                      total;
+} efficiency_t;
+
+/* Runs a tracker thread through every phase, efficiency is energy over MPP energy */
+static void run(tfunc_t tracker, efficiency_t *eff)
+{
+    thread_t *tp;
+    double e0 = 0.0, m0 = 0.0;
+
+    ina226ModelInit(&ina, RSENSE * 1000U);
+    memset(&panel, 0, sizeof(panel));
+    panel.at_us = chHostTimeUS();
+    panel_set_irradiance(phases[0].irradiance);
+
+    tp = chThdCreateStatic(solar_wa, sizeof(solar_wa), NORMALPRIO, tracker, NULL);
+    for (unsigned i = 0; i < PHASES; i++) {
+        panel_set_irradiance(phases[i].irradiance);
+        e0 = panel.energy_uj;
+        m0 = panel.mpp_energy_uj;
+        chThdSleepMilliseconds(phases[i].ms);
+        panel_update();
+        eff->phase[i] = panel.mpp_energy_uj > m0 ?
+            (panel.energy_uj - e0) / (panel.mpp_energy_uj - m0) : 1.0;
+    }
+    eff->total = panel.energy_uj / panel.mpp_energy_uj;
+    chThdTerminate(tp);
+    chThdWait(tp);
+}
+
+/* A conversion that completes before the tracker waits for it is not missed */
+static void test_alert_already_asserted(void)
+{
+    uint16_t me;
+    uint64_t start;
+
+    ina226ModelInit(&ina, RSENSE * 1000U);
+    ina226Start(&ina226dev, &ina226config);
+    TEST_EQUAL(ina226dev.state, INA226_READY);
+    ina226SetAlert(&ina226dev, INA226_ME_CNVR, 0);
+    palEnableLineEvent(LINE_ALERT, PAL_EVENT_MODE_FALLING_EDGE);
+
+    TEST_EQUAL(ina226ReadRaw(&ina226dev, INA226_AD_ME, &me), MSG_OK);
+    TEST_EQUAL(ina226StartConversion(&ina226dev), MSG_OK);
+    chThdSleepMilliseconds(INA226_CONVERSION_TIMEOUT_MS);
+    TEST_EQUAL(palReadLine(LINE_ALERT), PAL_LOW);
+
+    start = chHostTimeUS();
+    TEST_CHECK(wait_conversion_ready());
+    TEST_CHECK(chHostTimeUS() - start < 1000U);
+    TEST_EQUAL(palReadLine(LINE_ALERT), PAL_HIGH);
+
+    palDisableLineEvent(LINE_ALERT);
+    ina226Stop(&ina226dev);
+}
+
+/* Every reading covers only the time since the last DAC step */
+static void test_reading_after_step(void)
+{
+    uint32_t power_mw, voltage_mv, current_ua;
+
+    ina226ModelInit(&ina, RSENSE * 1000U);
+    memset(&panel, 0, sizeof(panel));
+    panel.at_us = chHostTimeUS();
+    panel_set_irradiance(1.0);
+    dacStart(&DACD1, &dac1cfg);
+    ina226Start(&ina226dev, &ina226config);
+    ina226SetAlert(&ina226dev, INA226_ME_CNVR, 0);
+    palEnableLineEvent(LINE_ALERT, PAL_EVENT_MODE_FALLING_EDGE);
+
+    dac_put_microvolts(&DACD1, 0, 600000);
+    chThdSleepMilliseconds(20);
+    /* Step half way through a conversion */
+    dac_put_microvolts(&DACD1, 0, 500000);
+    TEST_CHECK(read_avg_power_and_voltage(&power_mw, &voltage_mv, &current_ua));
+    TEST_CHECK(fabs(voltage_mv - panel.voltage_uv / 1000.0) <= 2.0);
+    TEST_CHECK(fabs(current_ua - panel.current_ua) <= panel.current_ua * 0.01 + CURR_LSB);
+    TEST_CHECK(fabs(power_mw - panel_power_mw()) <= 2.0);
+
+    palDisableLineEvent(LINE_ALERT);
+    ina226Stop(&ina226dev);
+    dacStop(&DACD1);
+}
+
+static void test_tracking(void)
+{
+    efficiency_t vs, ref;
+
+    run(solar, &vs);
+    /* What the tracker published at the end matches the panel */
+    TEST_EQUAL(OD_RAM.x6002_MPPT.algorithm, MPPT_ALGORITHM_VSPAO);
+    TEST_CHECK(fabs(OD_RAM.x6000_PV_Power.power - panel_power_mw()) < panel_power_mw() * 0.05);
+    run(ref_tracker, &ref);
+
+    printf("\n  %-10s %10s %10s\n", "phase", "tracker", "replaced");
+    for (unsigned i = 0; i < PHASES; i++) {
+        printf("  %-10s %9.1f%% %9.1f%%\n", phases[i].name, vs.phase[i] * 100.0, ref.phase[i] * 100.0);
+    }
+    printf("  %-10s %9.1f%% %9.1f%%\n", "total", vs.total * 100.0, ref.total * 100.0);
+
+    TEST_CHECK(vs.total > ref.total);
+    TEST_CHECK(vs.total > 0.95);
+    /* Back at the MPP within each phase, and recovered after the eclipse */
+    for (unsigned i = 0; i < PHASES; i++) {
+        TEST_CHECK(vs.phase[i] > 0.90);
+    }
+}
+
+int main(void)
+{
+    halInit();
+    chSysInit();
+
+    palSetLineMode(LINE_ALERT, PAL_MODE_INPUT_PULLUP);
+    palHostDriveLine(LINE_ALERT, true);
+    palSetLineMode(LINE_LT1618_EN, PAL_MODE_OUTPUT_PUSHPULL);
+    dacHostSetOutputHook(&DACD1, dac_out, NULL);
+    i2cHostAttach(&I2CD2, INA226_SADDR, &ina_dev);
+    ina226ObjectInit(&ina226dev);
+    chVTSet(&alert_vt, TIME_MS2I(1), alert_vt_cb, NULL);
+
+    TEST_RUN(test_alert_already_asserted);
+    TEST_RUN(test_reading_after_step);
+    TEST_RUN(test_tracking);
+    return 0;
+}